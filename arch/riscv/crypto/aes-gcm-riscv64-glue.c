@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * AES-GCM using the RISC-V vector crypto extensions (Zvkned + Zvkg)
+ *
+ * The AEAD is registered through the crypto SIMD helper, which marks it
+ * CRYPTO_ALG_ASYNC and defers to cryptd when the vector unit is not
+ * usable.  The async flag is what lets kTLS keep a window of records in
+ * flight in its crypto queue instead of waiting on each one.
+ */
+
+#include <linux/err.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <crypto/aes.h>
+#include <crypto/b128ops.h>
+#include <crypto/gcm.h>
+#include <crypto/scatterwalk.h>
+#include <crypto/internal/aead.h>
+#include <crypto/internal/simd.h>
+#include <crypto/internal/skcipher.h>
+#include <asm/hwcap.h>
+#include <asm/switch_to.h>
+
+asmlinkage void gcm_ghash_zvkg(be128 *state, const be128 *key,
+			       const u8 *src, unsigned int blocks);
+asmlinkage void aes_ctr32_crypt_zvkned(const u32 *rk, int rounds, u8 *dst,
+				       const u8 *src, unsigned int blocks,
+				       const u8 iv[GCM_AES_IV_SIZE],
+				       u32 ctr32);
+
+struct riscv64_gcm_ctx {
+	struct crypto_aes_ctx aes;
+	be128 h;
+};
+
+static int riscv64_gcm_setkey(struct crypto_aead *aead, const u8 *key,
+			      unsigned int keylen)
+{
+	struct riscv64_gcm_ctx *ctx = crypto_aead_ctx(aead);
+	static const u8 zeroes[AES_BLOCK_SIZE];
+	int err;
+
+	err = aes_expandkey(&ctx->aes, key, keylen);
+	if (err)
+		return err;
+
+	/* H = E(K, 0^128), kept in GCM wire byte order for vghsh */
+	aes_encrypt(&ctx->aes, (u8 *)&ctx->h, zeroes);
+	return 0;
+}
+
+static int riscv64_gcm_setauthsize(struct crypto_aead *aead,
+				   unsigned int authsize)
+{
+	return crypto_gcm_check_authsize(authsize);
+}
+
+static void riscv64_gcm_auth_mac(struct aead_request *req, be128 *state,
+				 const be128 *h)
+{
+	struct scatter_walk walk;
+	u32 len = req->assoclen;
+	u8 buf[AES_BLOCK_SIZE];
+	unsigned int buffered = 0;
+
+	scatterwalk_start(&walk, req->src);
+
+	do {
+		unsigned int n = scatterwalk_clamp(&walk, len);
+		const u8 *p, *mapped;
+
+		if (!n) {
+			scatterwalk_start(&walk, sg_next(walk.sg));
+			n = scatterwalk_clamp(&walk, len);
+		}
+		mapped = scatterwalk_map(&walk);
+		p = mapped;
+		len -= n;
+		scatterwalk_advance(&walk, n);
+
+		if (buffered) {
+			unsigned int fill = min_t(unsigned int, n,
+						  AES_BLOCK_SIZE - buffered);
+
+			memcpy(buf + buffered, p, fill);
+			buffered += fill;
+			p += fill;
+			n -= fill;
+			if (buffered == AES_BLOCK_SIZE) {
+				kernel_vector_begin();
+				gcm_ghash_zvkg(state, h, buf, 1);
+				kernel_vector_end();
+				buffered = 0;
+			}
+		}
+		if (n >= AES_BLOCK_SIZE) {
+			kernel_vector_begin();
+			gcm_ghash_zvkg(state, h, p, n / AES_BLOCK_SIZE);
+			kernel_vector_end();
+			p += round_down(n, AES_BLOCK_SIZE);
+			n %= AES_BLOCK_SIZE;
+		}
+		if (n) {
+			memcpy(buf + buffered, p, n);
+			buffered += n;
+		}
+
+		scatterwalk_unmap((void *)mapped);
+		scatterwalk_done(&walk, 0, len);
+	} while (len);
+
+	if (buffered) {
+		memset(buf + buffered, 0, AES_BLOCK_SIZE - buffered);
+		kernel_vector_begin();
+		gcm_ghash_zvkg(state, h, buf, 1);
+		kernel_vector_end();
+	}
+}
+
+static int riscv64_gcm_crypt(struct aead_request *req, bool enc)
+{
+	struct crypto_aead *aead = crypto_aead_reqtfm(req);
+	struct riscv64_gcm_ctx *ctx = crypto_aead_ctx(aead);
+	unsigned int authsize = crypto_aead_authsize(aead);
+	int rounds = 6 + ctx->aes.key_length / 4;
+	unsigned int cryptlen = req->cryptlen;
+	u8 tag[AES_BLOCK_SIZE];
+	be128 state = {}, lengths;
+	struct skcipher_walk walk;
+	u32 ctr32 = 2;
+	int err;
+
+	if (!enc)
+		cryptlen -= authsize;
+
+	if (req->assoclen)
+		riscv64_gcm_auth_mac(req, &state, &ctx->h);
+
+	lengths.a = cpu_to_be64((u64)req->assoclen * 8);
+	lengths.b = cpu_to_be64((u64)cryptlen * 8);
+
+	err = enc ? skcipher_walk_aead_encrypt(&walk, req, false)
+		  : skcipher_walk_aead_decrypt(&walk, req, false);
+
+	while (walk.nbytes) {
+		const u8 *src = walk.src.virt.addr;
+		u8 *dst = walk.dst.virt.addr;
+		unsigned int n = walk.nbytes;
+		unsigned int blocks, tail;
+
+		/* only the final chunk may carry a partial block */
+		if (n < walk.total)
+			n = round_down(n, AES_BLOCK_SIZE);
+		blocks = n / AES_BLOCK_SIZE;
+		tail = n % AES_BLOCK_SIZE;
+
+		kernel_vector_begin();
+		if (blocks) {
+			if (!enc)
+				gcm_ghash_zvkg(&state, &ctx->h, src, blocks);
+			aes_ctr32_crypt_zvkned(ctx->aes.key_enc, rounds, dst,
+					       src, blocks, req->iv, ctr32);
+			ctr32 += blocks;
+			if (enc)
+				gcm_ghash_zvkg(&state, &ctx->h, dst, blocks);
+		}
+		if (tail) {
+			u8 buf[AES_BLOCK_SIZE];
+
+			memcpy(buf, src + blocks * AES_BLOCK_SIZE, tail);
+			memset(buf + tail, 0, AES_BLOCK_SIZE - tail);
+			if (!enc)
+				gcm_ghash_zvkg(&state, &ctx->h, buf, 1);
+			aes_ctr32_crypt_zvkned(ctx->aes.key_enc, rounds, buf,
+					       buf, 1, req->iv, ctr32);
+			ctr32++;
+			memcpy(dst + blocks * AES_BLOCK_SIZE, buf, tail);
+			if (enc) {
+				memset(buf + tail, 0, AES_BLOCK_SIZE - tail);
+				gcm_ghash_zvkg(&state, &ctx->h, buf, 1);
+			}
+		}
+		kernel_vector_end();
+
+		err = skcipher_walk_done(&walk, walk.nbytes - n);
+	}
+	if (err)
+		return err;
+
+	/* T = GHASH(lengths) ^ E(K, J0) */
+	kernel_vector_begin();
+	gcm_ghash_zvkg(&state, &ctx->h, (const u8 *)&lengths, 1);
+	aes_ctr32_crypt_zvkned(ctx->aes.key_enc, rounds, tag,
+			       (const u8 *)&state, 1, req->iv, 1);
+	kernel_vector_end();
+
+	if (enc) {
+		scatterwalk_map_and_copy(tag, req->dst,
+					 req->assoclen + cryptlen, authsize,
+					 1);
+	} else {
+		u8 otag[AES_BLOCK_SIZE];
+
+		scatterwalk_map_and_copy(otag, req->src,
+					 req->assoclen + cryptlen, authsize,
+					 0);
+		if (crypto_memneq(tag, otag, authsize)) {
+			memzero_explicit(tag, sizeof(tag));
+			return -EBADMSG;
+		}
+	}
+	return 0;
+}
+
+static int riscv64_gcm_encrypt(struct aead_request *req)
+{
+	return riscv64_gcm_crypt(req, true);
+}
+
+static int riscv64_gcm_decrypt(struct aead_request *req)
+{
+	return riscv64_gcm_crypt(req, false);
+}
+
+static struct aead_alg riscv64_gcm_alg = {
+	.setkey			= riscv64_gcm_setkey,
+	.setauthsize		= riscv64_gcm_setauthsize,
+	.encrypt		= riscv64_gcm_encrypt,
+	.decrypt		= riscv64_gcm_decrypt,
+	.ivsize			= GCM_AES_IV_SIZE,
+	.chunksize		= AES_BLOCK_SIZE,
+	.maxauthsize		= AES_BLOCK_SIZE,
+	.base			= {
+		.cra_name		= "__gcm(aes)",
+		.cra_driver_name	= "__gcm-aes-riscv64-zvk",
+		.cra_priority		= 300,
+		.cra_flags		= CRYPTO_ALG_INTERNAL,
+		.cra_blocksize		= 1,
+		.cra_ctxsize		= sizeof(struct riscv64_gcm_ctx),
+		.cra_module		= THIS_MODULE,
+	},
+};
+
+static struct simd_aead_alg *riscv64_gcm_simd_alg;
+
+static int __init riscv64_gcm_mod_init(void)
+{
+	if (!has_vector() ||
+	    !riscv_isa_extension_available(NULL, ZVKNED) ||
+	    !riscv_isa_extension_available(NULL, ZVKG))
+		return -ENODEV;
+
+	return simd_register_aeads_compat(&riscv64_gcm_alg, 1,
+					  &riscv64_gcm_simd_alg);
+}
+
+static void __exit riscv64_gcm_mod_exit(void)
+{
+	simd_unregister_aeads(&riscv64_gcm_alg, 1, &riscv64_gcm_simd_alg);
+}
+
+module_init(riscv64_gcm_mod_init);
+module_exit(riscv64_gcm_mod_exit);
+
+MODULE_DESCRIPTION("AES-GCM (RISC-V Zvkned/Zvkg accelerated)");
+MODULE_LICENSE("GPL");
+MODULE_ALIAS_CRYPTO("gcm(aes)");
@@ -45,6 +45,7 @@ static bool errata_probe_cmo(unsigned int stage,
 
 	riscv_cbom_block_size = L1_CACHE_BYTES;
 	riscv_noncoherent_supported();
+	riscv_icache_range_supported();
 	return true;
 }
 
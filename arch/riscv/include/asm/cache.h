@@ -13,6 +13,14 @@
 
 #ifdef CONFIG_RISCV_DMA_NONCOHERENT
 #define ARCH_DMA_MINALIGN L1_CACHE_BYTES
+#ifdef CONFIG_DMA_BOUNCE_UNALIGNED_KMALLOC
+/*
+ * Unaligned kmalloc() buffers are bounced for non-coherent DMA, so the
+ * kmalloc caches don't have to be padded out to the worst-case cache
+ * line. See dma_kmalloc_needs_bounce().
+ */
+#define ARCH_KMALLOC_MINALIGN	(8)
+#endif
 #endif
 
 /*
@@ -23,4 +31,18 @@
 #define ARCH_SLAB_MINALIGN	16
 #endif
 
+#ifndef __ASSEMBLY__
+
+#ifdef CONFIG_RISCV_DMA_NONCOHERENT
+extern int dma_cache_alignment;
+#define dma_get_cache_alignment dma_get_cache_alignment
+static inline int dma_get_cache_alignment(void)
+{
+	/* the cache management granule probed at boot, not the worst case */
+	return dma_cache_alignment;
+}
+#endif
+
+#endif	/* __ASSEMBLY__ */
+
 #endif /* _ASM_RISCV_CACHE_H */
@@ -30,10 +30,13 @@ static inline void flush_dcache_page(struct page *page)
 #define ARCH_IMPLEMENTS_FLUSH_DCACHE_PAGE 1
 
 /*
- * RISC-V doesn't have an instruction to flush parts of the instruction cache,
- * so instead we just flush the whole thing.
+ * RISC-V has no standard instruction to flush parts of the instruction
+ * cache, so flush_icache_range() falls back to flushing the whole thing
+ * unless the platform provides a ranged invalidate (see cacheflush.c).
  */
-#define flush_icache_range(start, end) flush_icache_all()
+#define flush_icache_range flush_icache_range
+void flush_icache_range(unsigned long start, unsigned long end);
+void riscv_icache_range_supported(void);
 #define flush_icache_user_page(vma, pg, addr, len) \
 	flush_icache_mm(vma->vm_mm, 0)
 
@@ -52,6 +55,9 @@ void flush_icache_mm(struct mm_struct *mm, bool local);
 extern unsigned int riscv_cbom_block_size;
 void riscv_init_cbom_blocksize(void);
 
+extern unsigned int riscv_cboz_block_size;
+void riscv_init_cboz_blocksize(void);
+
 #ifdef CONFIG_RISCV_DMA_NONCOHERENT
 void riscv_noncoherent_supported(void);
 #else
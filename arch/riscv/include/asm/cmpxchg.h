@@ -8,8 +8,23 @@
 
 #include <linux/bug.h>
 
+#include <asm/alternative-macros.h>
 #include <asm/barrier.h>
+#include <asm/errata_list.h>
 #include <asm/fence.h>
+#include <asm/insn-def.h>
+
+/*
+ * With Zacas a cmpxchg is patched into "mv rd, old; amocas rd, new"
+ * over the LR/SC loop.  The replacement must assemble to exactly the
+ * same size as the loop, and the acquire/release loops are one fence
+ * shorter on !SMP, so pad by the same amount the barrier contributes.
+ */
+#ifdef CONFIG_SMP
+#define RISCV_BARRIER_PAD		"	nop\n"
+#else
+#define RISCV_BARRIER_PAD
+#endif
 
 #define __xchg_relaxed(ptr, new, size)					\
 ({									\
@@ -173,24 +188,36 @@
 	switch (size) {							\
 	case 4:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.w %0, %2\n"				\
 			"	bne  %0, %z3, 1f\n"			\
 			"	sc.w %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_W(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n",					\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" ((long)__old), "rJ" (__new)		\
+			: "rJ" ((long)__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	case 8:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.d %0, %2\n"				\
 			"	bne %0, %z3, 1f\n"			\
 			"	sc.d %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_D(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n",					\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" (__old), "rJ" (__new)			\
+			: "rJ" (__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	default:							\
@@ -217,26 +244,40 @@
 	switch (size) {							\
 	case 4:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.w %0, %2\n"				\
 			"	bne  %0, %z3, 1f\n"			\
 			"	sc.w %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
 			RISCV_ACQUIRE_BARRIER				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_W_AQ(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			RISCV_BARRIER_PAD,				\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" ((long)__old), "rJ" (__new)		\
+			: "rJ" ((long)__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	case 8:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.d %0, %2\n"				\
 			"	bne %0, %z3, 1f\n"			\
 			"	sc.d %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
 			RISCV_ACQUIRE_BARRIER				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_D_AQ(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			RISCV_BARRIER_PAD,				\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" (__old), "rJ" (__new)			\
+			: "rJ" (__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	default:							\
@@ -263,26 +304,40 @@
 	switch (size) {							\
 	case 4:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			RISCV_RELEASE_BARRIER				\
 			"0:	lr.w %0, %2\n"				\
 			"	bne  %0, %z3, 1f\n"			\
 			"	sc.w %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_W_RL(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			RISCV_BARRIER_PAD,				\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" ((long)__old), "rJ" (__new)		\
+			: "rJ" ((long)__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	case 8:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			RISCV_RELEASE_BARRIER				\
 			"0:	lr.d %0, %2\n"				\
 			"	bne %0, %z3, 1f\n"			\
 			"	sc.d %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_D_RL(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			RISCV_BARRIER_PAD,				\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" (__old), "rJ" (__new)			\
+			: "rJ" (__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	default:							\
@@ -309,26 +364,40 @@
 	switch (size) {							\
 	case 4:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.w %0, %2\n"				\
 			"	bne  %0, %z3, 1f\n"			\
 			"	sc.w.rl %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
 			"	fence rw, rw\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_W_AQRL(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			"	nop\n",					\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" ((long)__old), "rJ" (__new)		\
+			: "rJ" ((long)__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	case 8:								\
 		__asm__ __volatile__ (					\
+			ALTERNATIVE(					\
 			"0:	lr.d %0, %2\n"				\
 			"	bne %0, %z3, 1f\n"			\
 			"	sc.d.rl %1, %z4, %2\n"			\
 			"	bnez %1, 0b\n"				\
 			"	fence rw, rw\n"				\
-			"1:\n"						\
+			"1:\n",						\
+			"	mv %0, %z3\n"				\
+			AMOCAS_D_AQRL(%0, %z4, %5) "\n"			\
+			"	nop\n"					\
+			"	nop\n"					\
+			"	nop\n",					\
+			0, CPUFEATURE_ZACAS, CONFIG_RISCV_ISA_ZACAS)	\
 			: "=&r" (__ret), "=&r" (__rc), "+A" (*__ptr)	\
-			: "rJ" (__old), "rJ" (__new)			\
+			: "rJ" (__old), "rJ" (__new), "r" (__ptr)	\
 			: "memory");					\
 		break;							\
 	default:							\
@@ -0,0 +1,23 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2023 SiFive
+ */
+
+#ifndef _ASM_CPUFEATURE_H
+#define _ASM_CPUFEATURE_H
+
+#include <linux/percpu.h>
+
+/*
+ * Per-hart misaligned access handling, worst observed variant first:
+ * unknown until probed, emulated by the kernel trap handler, handled
+ * by hardware but slower than byte copies, or handled at full speed.
+ */
+#define RISCV_MISALIGNED_UNKNOWN	0
+#define RISCV_MISALIGNED_EMULATED	1
+#define RISCV_MISALIGNED_SLOW		2
+#define RISCV_MISALIGNED_FAST		3
+
+DECLARE_PER_CPU(long, misaligned_access_speed);
+
+#endif /* _ASM_CPUFEATURE_H */
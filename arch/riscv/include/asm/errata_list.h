@@ -5,7 +5,7 @@
 #ifndef ASM_ERRATA_LIST_H
 #define ASM_ERRATA_LIST_H
 
-#include <asm/alternative.h>
+#include <asm/alternative-macros.h>
 #include <asm/csr.h>
 #include <asm/vendorid_list.h>
 
@@ -24,7 +24,11 @@
 
 #define	CPUFEATURE_SVPBMT 0
 #define	CPUFEATURE_ZICBOM 1
-#define	CPUFEATURE_NUMBER 2
+#define	CPUFEATURE_VECTOR 2
+#define	CPUFEATURE_ZBB 3
+#define	CPUFEATURE_ZICBOZ 4
+#define	CPUFEATURE_ZACAS 5
+#define	CPUFEATURE_NUMBER 6
 
 #ifdef __ASSEMBLY__
 
@@ -147,24 +151,59 @@ asm volatile(ALTERNATIVE_2(						\
 	    "r"((unsigned long)(_start) + (_size))			\
 	: "a0")
 
+/*
+ * The DMA sync paths walk buffers that are usually much larger than one
+ * cache block, so the main loop is unrolled four times to amortize the
+ * loop branch, with a per-block tail for the remainder.
+ */
 #define ALT_CMO_OP_VPA(_op, _vaddr, _paddr, _size, _cachesize)		\
 asm volatile(ALTERNATIVE_2(						\
-	__nops(6),							\
+	__nops(19),							\
 	"mv a0, %1\n\t"							\
-	"j 2f\n\t"							\
+	"sub t1, %2, %0\n\t"						\
+	"sub t1, t1, %0\n\t"						\
+	"sub t1, t1, %0\n\t"						\
+	"bgeu a0, t1, 2f\n\t"						\
 	"3:\n\t"							\
 	"cbo." __stringify(_op) " (a0)\n\t"				\
 	"add a0, a0, %0\n\t"						\
+	"cbo." __stringify(_op) " (a0)\n\t"				\
+	"add a0, a0, %0\n\t"						\
+	"cbo." __stringify(_op) " (a0)\n\t"				\
+	"add a0, a0, %0\n\t"						\
+	"cbo." __stringify(_op) " (a0)\n\t"				\
+	"add a0, a0, %0\n\t"						\
+	"bltu a0, t1, 3b\n\t"						\
 	"2:\n\t"							\
-	"bltu a0, %2, 3b\n\t"						\
+	"bgeu a0, %2, 1f\n\t"						\
+	"4:\n\t"							\
+	"cbo." __stringify(_op) " (a0)\n\t"				\
+	"add a0, a0, %0\n\t"						\
+	"bltu a0, %2, 4b\n\t"						\
+	"1:\n\t"							\
 	"nop", 0, CPUFEATURE_ZICBOM, CONFIG_RISCV_ISA_ZICBOM,		\
 	"mv a0, %3\n\t"							\
-	"j 2f\n\t"							\
+	"sub t1, %4, %0\n\t"						\
+	"sub t1, t1, %0\n\t"						\
+	"sub t1, t1, %0\n\t"						\
+	"bgeu a0, t1, 2f\n\t"						\
 	"3:\n\t"							\
 	THEAD_##_op##_PA_A0 "\n\t"					\
 	"add a0, a0, %0\n\t"						\
+	THEAD_##_op##_PA_A0 "\n\t"					\
+	"add a0, a0, %0\n\t"						\
+	THEAD_##_op##_PA_A0 "\n\t"					\
+	"add a0, a0, %0\n\t"						\
+	THEAD_##_op##_PA_A0 "\n\t"					\
+	"add a0, a0, %0\n\t"						\
+	"bltu a0, t1, 3b\n\t"						\
 	"2:\n\t"							\
-	"bltu a0, %4, 3b\n\t"						\
+	"bgeu a0, %4, 1f\n\t"						\
+	"4:\n\t"							\
+	THEAD_##_op##_PA_A0 "\n\t"					\
+	"add a0, a0, %0\n\t"						\
+	"bltu a0, %4, 4b\n\t"						\
+	"1:\n\t"							\
 	THEAD_SYNC_S, THEAD_VENDOR_ID,					\
 			ERRATA_THEAD_CMO, CONFIG_ERRATA_THEAD_CMO)	\
 	: : "r"(_cachesize),						\
@@ -172,6 +211,36 @@ asm volatile(ALTERNATIVE_2(						\
 	    "r"((unsigned long)(_vaddr) + (_size)),			\
 	    "r"((unsigned long)(_paddr) & ~((_cachesize) - 1UL)),	\
 	    "r"((unsigned long)(_paddr) + (_size))			\
+	: "a0", "t1")
+
+/*
+ * icache.iva rs1 (invalidate icache by virtual address, broadcast)
+ * | 31 - 25 | 24 - 20 | 19 - 15 | 14 - 12 | 11 - 7 | 6 - 0 |
+ *   0000001    00011      rs1       000      00000  0001011
+ *
+ * sync.is (synchronize instruction fetch, broadcast)
+ * | 31 - 25 | 24 - 20 | 19 - 15 | 14 - 12 | 11 - 7 | 6 - 0 |
+ *   0000000    11011     00000      000      00000  0001011
+ */
+#define THEAD_ICACHE_IVA_A0	".long 0x0235000b"
+#define THEAD_SYNC_IS		".long 0x01b0000b"
+
+#define ALT_ICACHE_INVAL_RANGE(_start, _size, _cachesize)		\
+asm volatile(ALTERNATIVE(						\
+	"fence.i\n\t"							\
+	__nops(5),							\
+	"mv a0, %1\n\t"							\
+	"j 2f\n\t"							\
+	"3:\n\t"							\
+	THEAD_ICACHE_IVA_A0 "\n\t"					\
+	"add a0, a0, %0\n\t"						\
+	"2:\n\t"							\
+	"bltu a0, %2, 3b\n\t"						\
+	THEAD_SYNC_IS, THEAD_VENDOR_ID,					\
+			ERRATA_THEAD_CMO, CONFIG_ERRATA_THEAD_CMO)	\
+	: : "r"(_cachesize),						\
+	    "r"((unsigned long)(_start) & ~((_cachesize) - 1UL)),	\
+	    "r"((unsigned long)(_start) + (_size))			\
 	: "a0")
 
 #define THEAD_C9XX_RV_IRQ_PMU			17
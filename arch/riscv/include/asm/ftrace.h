@@ -47,11 +47,13 @@ struct dyn_arch_ftrace {
  * 4: jalr   t0/ra, ?(t0/ra)
  *
  *<ftrace disable>:
- * 0: nop
+ * 0: auipc  t0/ra, 0x?
  * 4: nop
  *
- * Dynamic ftrace generates probes to call sites, so we must deal with
- * both auipc and jalr at the same time.
+ * The auipc stays resident so that enabling and disabling only has to
+ * toggle the jalr word, which is atomic with respect to concurrent
+ * instruction fetch; the stray auipc only clobbers t0/ra, which is dead
+ * at the call site.
  */
 
 #define MCOUNT_ADDR		((unsigned long)MCOUNT_NAME)
@@ -107,6 +109,22 @@ do {									\
 struct dyn_ftrace;
 int ftrace_init_nop(struct module *mod, struct dyn_ftrace *rec);
 #define ftrace_init_nop ftrace_init_nop
+
+#ifdef CONFIG_DYNAMIC_FTRACE_WITH_DIRECT_CALLS
+struct pt_regs;
+/*
+ * ftrace_regs_caller zeroes pt_regs->t1 on entry and, on the way out,
+ * tail-calls whatever address it finds there instead of returning to
+ * the traced function.  t1 is caller-saved and dead at function entry,
+ * just like the t0 the resident auipc clobbers, so the traced function
+ * never sees the difference.
+ */
+static inline void arch_ftrace_set_direct_caller(struct pt_regs *regs,
+						 unsigned long addr)
+{
+	regs->t1 = addr;
+}
+#endif /* CONFIG_DYNAMIC_FTRACE_WITH_DIRECT_CALLS */
 #endif
 
 #endif /* CONFIG_DYNAMIC_FTRACE */
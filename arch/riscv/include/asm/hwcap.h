@@ -60,20 +60,18 @@ enum riscv_isa_ext_id {
 	RISCV_ISA_EXT_ZIHINTPAUSE,
 	RISCV_ISA_EXT_SSTC,
 	RISCV_ISA_EXT_SVINVAL,
+	RISCV_ISA_EXT_ZBB,
+	RISCV_ISA_EXT_ZICBOZ,
+	RISCV_ISA_EXT_ZACAS,
+	RISCV_ISA_EXT_ZKR,
+	RISCV_ISA_EXT_SVNAPOT,
+	RISCV_ISA_EXT_ZBA,
+	RISCV_ISA_EXT_SSAIA,
+	RISCV_ISA_EXT_ZVKG,
+	RISCV_ISA_EXT_ZVKNED,
 	RISCV_ISA_EXT_ID_MAX = RISCV_ISA_EXT_MAX,
 };
 
-/*
- * This enum represents the logical ID for each RISC-V ISA extension static
- * keys. We can use static key to optimize code path if some ISA extensions
- * are available.
- */
-enum riscv_isa_ext_key {
-	RISCV_ISA_EXT_KEY_FPU,		/* For 'F' and 'D' */
-	RISCV_ISA_EXT_KEY_SVINVAL,
-	RISCV_ISA_EXT_KEY_MAX,
-};
-
 struct riscv_isa_ext_data {
 	/* Name of the extension displayed to userspace via /proc/cpuinfo */
 	char uprop[RISCV_ISA_EXT_NAME_LEN_MAX];
@@ -81,20 +79,28 @@ struct riscv_isa_ext_data {
 	unsigned int isa_ext_id;
 };
 
-extern struct static_key_false riscv_isa_ext_keys[RISCV_ISA_EXT_KEY_MAX];
+/*
+ * One static key per extension, indexed by the logical extension ID and
+ * flipped once when the hwcaps have been filled in at boot.  Hot paths
+ * test them through the helpers below, which compile down to a nop or an
+ * unconditional jump instead of a bitmap lookup.
+ */
+extern struct static_key_false riscv_isa_ext_keys[RISCV_ISA_EXT_MAX];
 
-static __always_inline int riscv_isa_ext2key(int num)
+static __always_inline bool riscv_has_extension_likely(const unsigned long ext)
 {
-	switch (num) {
-	case RISCV_ISA_EXT_f:
-		return RISCV_ISA_EXT_KEY_FPU;
-	case RISCV_ISA_EXT_d:
-		return RISCV_ISA_EXT_KEY_FPU;
-	case RISCV_ISA_EXT_SVINVAL:
-		return RISCV_ISA_EXT_KEY_SVINVAL;
-	default:
-		return -EINVAL;
-	}
+	compiletime_assert(ext < RISCV_ISA_EXT_MAX,
+			   "ext must be < RISCV_ISA_EXT_MAX");
+
+	return static_branch_likely(&riscv_isa_ext_keys[ext]);
+}
+
+static __always_inline bool riscv_has_extension_unlikely(const unsigned long ext)
+{
+	compiletime_assert(ext < RISCV_ISA_EXT_MAX,
+			   "ext must be < RISCV_ISA_EXT_MAX");
+
+	return static_branch_unlikely(&riscv_isa_ext_keys[ext]);
 }
 
 unsigned long riscv_isa_extension_base(const unsigned long *isa_bitmap);
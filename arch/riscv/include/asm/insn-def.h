@@ -12,6 +12,12 @@
 #define INSN_R_RD_SHIFT			 7
 #define INSN_R_OPCODE_SHIFT		 0
 
+#define INSN_I_SIMM12_SHIFT		20
+#define INSN_I_RS1_SHIFT		15
+#define INSN_I_FUNC3_SHIFT		12
+#define INSN_I_RD_SHIFT			 7
+#define INSN_I_OPCODE_SHIFT		 0
+
 #ifdef __ASSEMBLY__
 
 #ifdef CONFIG_AS_HAS_INSN
@@ -20,6 +26,10 @@
 	.insn	r \opcode, \func3, \func7, \rd, \rs1, \rs2
 	.endm
 
+	.macro insn_i, opcode, func3, rd, rs1, simm12
+	.insn	i \opcode, \func3, \rd, \rs1, \simm12
+	.endm
+
 #else
 
 #include <asm/gpr-num.h>
@@ -33,9 +43,18 @@
 		 (.L__gpr_num_\rs2 << INSN_R_RS2_SHIFT))
 	.endm
 
+	.macro insn_i, opcode, func3, rd, rs1, simm12
+	.4byte	((\opcode << INSN_I_OPCODE_SHIFT) |		\
+		 (\func3 << INSN_I_FUNC3_SHIFT) |		\
+		 (.L__gpr_num_\rd << INSN_I_RD_SHIFT) |		\
+		 (.L__gpr_num_\rs1 << INSN_I_RS1_SHIFT) |	\
+		 (\simm12 << INSN_I_SIMM12_SHIFT))
+	.endm
+
 #endif
 
 #define __INSN_R(...)	insn_r __VA_ARGS__
+#define __INSN_I(...)	insn_i __VA_ARGS__
 
 #else /* ! __ASSEMBLY__ */
 
@@ -44,6 +63,9 @@
 #define __INSN_R(opcode, func3, func7, rd, rs1, rs2)	\
 	".insn	r " opcode ", " func3 ", " func7 ", " rd ", " rs1 ", " rs2 "\n"
 
+#define __INSN_I(opcode, func3, rd, rs1, simm12)	\
+	".insn	i " opcode ", " func3 ", " rd ", " rs1 ", " simm12 "\n"
+
 #else
 
 #include <linux/stringify.h>
@@ -63,11 +85,29 @@
 #define UNDEFINE_INSN_R							\
 "	.purgem insn_r\n"
 
+#define DEFINE_INSN_I							\
+	__DEFINE_ASM_GPR_NUMS						\
+"	.macro insn_i, opcode, func3, rd, rs1, simm12\n"		\
+"	.4byte	((\\opcode << " __stringify(INSN_I_OPCODE_SHIFT) ") |"	\
+"		 (\\func3 << " __stringify(INSN_I_FUNC3_SHIFT) ") |"	\
+"		 (.L__gpr_num_\\rd << " __stringify(INSN_I_RD_SHIFT) ") |"    \
+"		 (.L__gpr_num_\\rs1 << " __stringify(INSN_I_RS1_SHIFT) ") |"  \
+"		 (\\simm12 << " __stringify(INSN_I_SIMM12_SHIFT) "))\n"	\
+"	.endm\n"
+
+#define UNDEFINE_INSN_I							\
+"	.purgem insn_i\n"
+
 #define __INSN_R(opcode, func3, func7, rd, rs1, rs2)			\
 	DEFINE_INSN_R							\
 	"insn_r " opcode ", " func3 ", " func7 ", " rd ", " rs1 ", " rs2 "\n" \
 	UNDEFINE_INSN_R
 
+#define __INSN_I(opcode, func3, rd, rs1, simm12)			\
+	DEFINE_INSN_I							\
+	"insn_i " opcode ", " func3 ", " rd ", " rs1 ", " simm12 "\n"	\
+	UNDEFINE_INSN_I
+
 #endif
 
 #endif /* ! __ASSEMBLY__ */
@@ -76,9 +116,14 @@
 	__INSN_R(RV_##opcode, RV_##func3, RV_##func7,		\
 		 RV_##rd, RV_##rs1, RV_##rs2)
 
+#define INSN_I(opcode, func3, rd, rs1, simm12)			\
+	__INSN_I(RV_##opcode, RV_##func3, RV_##rd,		\
+		 RV_##rs1, RV_##simm12)
+
 #define RV_OPCODE(v)		__ASM_STR(v)
 #define RV_FUNC3(v)		__ASM_STR(v)
 #define RV_FUNC7(v)		__ASM_STR(v)
+#define RV_SIMM12(v)		__ASM_STR(v)
 #define RV_RD(v)		__ASM_STR(v)
 #define RV_RS1(v)		__ASM_STR(v)
 #define RV_RS2(v)		__ASM_STR(v)
@@ -87,6 +132,9 @@
 #define RV___RS1(v)		__RV_REG(v)
 #define RV___RS2(v)		__RV_REG(v)
 
+#define RV_OPCODE_MISC_MEM	RV_OPCODE(15)
+#define RV_OPCODE_OP_IMM	RV_OPCODE(19)
+#define RV_OPCODE_AMO		RV_OPCODE(47)
 #define RV_OPCODE_SYSTEM	RV_OPCODE(115)
 
 #define HFENCE_VVMA(vaddr, asid)				\
@@ -134,4 +182,87 @@
 	INSN_R(OPCODE_SYSTEM, FUNC3(0), FUNC7(51),		\
 	       __RD(0), RS1(gaddr), RS2(vmid))
 
+/*
+ * Zacas compare-and-swap.  funct7 is the funct5 of 00101 with the aq/rl
+ * bits appended; rd holds the expected value on entry and the old
+ * memory value on return.
+ */
+#define AMOCAS_W(rd, rs2, rs1)					\
+	INSN_R(OPCODE_AMO, FUNC3(2), FUNC7(20),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_W_RL(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(2), FUNC7(21),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_W_AQ(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(2), FUNC7(22),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_W_AQRL(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(2), FUNC7(23),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_D(rd, rs2, rs1)					\
+	INSN_R(OPCODE_AMO, FUNC3(3), FUNC7(20),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_D_RL(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(3), FUNC7(21),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_D_AQ(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(3), FUNC7(22),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define AMOCAS_D_AQRL(rd, rs2, rs1)				\
+	INSN_R(OPCODE_AMO, FUNC3(3), FUNC7(23),			\
+	       RD(rd), RS1(rs1), RS2(rs2))
+
+#define CBO_INVAL(base)						\
+	INSN_I(OPCODE_MISC_MEM, FUNC3(2), __RD(0),		\
+	       RS1(base), SIMM12(0))
+
+#define CBO_CLEAN(base)						\
+	INSN_I(OPCODE_MISC_MEM, FUNC3(2), __RD(0),		\
+	       RS1(base), SIMM12(1))
+
+#define CBO_FLUSH(base)						\
+	INSN_I(OPCODE_MISC_MEM, FUNC3(2), __RD(0),		\
+	       RS1(base), SIMM12(2))
+
+#define CBO_ZERO(base)						\
+	INSN_I(OPCODE_MISC_MEM, FUNC3(2), __RD(0),		\
+	       RS1(base), SIMM12(4))
+
+/*
+ * Zbb instructions used behind alternatives, encoded by hand so that
+ * the files assemble with toolchains that do not know the extension.
+ */
+#define ZBB_ORC_B(rd, rs)					\
+	INSN_I(OPCODE_OP_IMM, FUNC3(5), RD(rd), RS1(rs),	\
+	       SIMM12(0x287))
+
+#define ZBB_CLZ(rd, rs)						\
+	INSN_I(OPCODE_OP_IMM, FUNC3(1), RD(rd), RS1(rs),	\
+	       SIMM12(0x600))
+
+#define ZBB_CTZ(rd, rs)						\
+	INSN_I(OPCODE_OP_IMM, FUNC3(1), RD(rd), RS1(rs),	\
+	       SIMM12(0x601))
+
+#define ZBB_CPOP(rd, rs)					\
+	INSN_I(OPCODE_OP_IMM, FUNC3(1), RD(rd), RS1(rs),	\
+	       SIMM12(0x602))
+
+#ifdef CONFIG_64BIT
+#define ZBB_REV8(rd, rs)					\
+	INSN_I(OPCODE_OP_IMM, FUNC3(5), RD(rd), RS1(rs),	\
+	       SIMM12(0x6b8))
+#else
+#define ZBB_REV8(rd, rs)					\
+	INSN_I(OPCODE_OP_IMM, FUNC3(5), RD(rd), RS1(rs),	\
+	       SIMM12(0x698))
+#endif
+
 #endif /* __ASM_INSN_DEF_H */
@@ -133,6 +133,30 @@ __io_writes_outs(outs, u64, q, __io_pbr(), __io_paw())
 #define outsq(addr, buffer, count) __outsq(PCI_IOBASE + (addr), buffer, count)
 #endif
 
+#ifdef CONFIG_MMU
+/*
+ * Weakly-ordered I/O mappings.  With Svpbmt (or the T-Head equivalent,
+ * patched in through the same alternative as _PAGE_NOCACHE) the NC memory
+ * type allows stores to prefetchable BARs, descriptor rings and doorbells
+ * to combine instead of serializing on every access.  Without a PBMT the
+ * alternative leaves _PAGE_NOCACHE clear and there is no weaker I/O type,
+ * so fall back to the strongly-ordered default.
+ */
+static inline unsigned long riscv_ioremap_wc_prot(void)
+{
+	if (_PAGE_NOCACHE)
+		return (_PAGE_KERNEL & ~_PAGE_MTMASK) | _PAGE_NOCACHE;
+
+	return _PAGE_IOREMAP;
+}
+
+#define ioremap_wc(addr, size)	\
+	ioremap_prot((addr), (size), riscv_ioremap_wc_prot())
+/* No write-through memory type exists; NC is the closest safe one. */
+#define ioremap_wt(addr, size)	\
+	ioremap_prot((addr), (size), riscv_ioremap_wc_prot())
+#endif
+
 #include <asm-generic/io.h>
 
 #ifdef CONFIG_MMU
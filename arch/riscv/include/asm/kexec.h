@@ -41,8 +41,18 @@ crash_setup_regs(struct pt_regs *newregs,
 struct kimage_arch {
 	void *fdt; /* For CONFIG_KEXEC_FILE */
 	unsigned long fdt_addr;
+	/* Segments already staged at their final physical pages */
+	int preloaded;
 };
 
+/*
+ * Memory reserved at boot ("kexec_pool=" command line parameter) that
+ * kexec_file_load() stages images into, so that machine_kexec() can
+ * skip the reboot-time relocation copy.
+ */
+extern phys_addr_t kexec_pool_base;
+extern phys_addr_t kexec_pool_size;
+
 extern const unsigned char riscv_kexec_relocate[];
 extern const unsigned int riscv_kexec_relocate_size;
 
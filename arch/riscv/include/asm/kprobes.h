@@ -43,5 +43,27 @@ bool kprobe_single_step_handler(struct pt_regs *regs);
 void __kretprobe_trampoline(void);
 void __kprobes *trampoline_probe_handler(struct pt_regs *regs);
 
+#ifdef CONFIG_OPTPROBES
+
+/* slot size, in units of kprobe_opcode_t */
+#define MAX_OPTINSN_SIZE	(optprobe_template_end - optprobe_template_entry)
+
+/* optinsn slots come from a page reserved in the kernel image */
+extern kprobe_opcode_t optinsn_page[];
+extern kprobe_opcode_t optprobe_template_entry[];
+extern kprobe_opcode_t optprobe_template_val[];
+extern kprobe_opcode_t optprobe_template_call[];
+extern kprobe_opcode_t optprobe_template_insn[];
+extern kprobe_opcode_t optprobe_template_return[];
+extern kprobe_opcode_t optprobe_template_data[];
+extern kprobe_opcode_t optprobe_template_end[];
+
+struct arch_optimized_insn {
+	/* detour slot holding the trampoline, or NULL */
+	kprobe_opcode_t *insn;
+};
+
+#endif /* CONFIG_OPTPROBES */
+
 #endif /* CONFIG_KPROBES */
 #endif /* _ASM_RISCV_KPROBES_H */
@@ -15,6 +15,7 @@
 #include <linux/spinlock.h>
 #include <asm/csr.h>
 #include <asm/hwcap.h>
+#include <asm/kvm_aia.h>
 #include <asm/kvm_vcpu_fp.h>
 #include <asm/kvm_vcpu_insn.h>
 #include <asm/kvm_vcpu_timer.h>
@@ -36,6 +37,11 @@
 	KVM_ARCH_REQ_FLAGS(4, KVM_REQUEST_WAIT | KVM_REQUEST_NO_WAKEUP)
 #define KVM_REQ_HFENCE			\
 	KVM_ARCH_REQ_FLAGS(5, KVM_REQUEST_WAIT | KVM_REQUEST_NO_WAKEUP)
+#define KVM_REQ_STEAL_UPDATE		KVM_ARCH_REQ(6)
+
+/* Only MSI routes are supported, the irqchip matrix stays minimal */
+#define KVM_NR_IRQCHIPS			1
+#define KVM_IRQCHIP_NUM_PINS		32
 
 enum kvm_riscv_hfence_type {
 	KVM_RISCV_HFENCE_UNKNOWN = 0,
@@ -91,8 +97,17 @@ struct kvm_arch {
 	pgd_t *pgd;
 	phys_addr_t pgd_phys;
 
+	/*
+	 * Cache used to split huge G-stage leaves under kvm->mmu_lock
+	 * when dirty logging starts
+	 */
+	struct kvm_mmu_memory_cache mmu_split_cache;
+
 	/* Guest Timer */
 	struct kvm_guest_timer timer;
+
+	/* AIA Guest/VM context */
+	struct kvm_aia aia;
 };
 
 struct kvm_sbi_context {
@@ -183,12 +198,24 @@ struct kvm_vcpu_arch {
 	/* CPU CSR context of Guest VCPU */
 	struct kvm_vcpu_csr guest_csr;
 
+	/*
+	 * Lazy guest FP tracking. While the guest FP state is not loaded,
+	 * guest_context.sstatus has SR_FS_OFF and the real FS value is
+	 * stashed here, so guest FP accesses trap to HS-mode and the
+	 * host/guest FP switch only happens when the guest touches FP.
+	 */
+	bool guest_fp_loaded;
+	unsigned long guest_fp_sr_fs;
+
 	/* CPU context upon Guest VCPU reset */
 	struct kvm_cpu_context guest_reset_context;
 
 	/* CPU CSR context upon Guest VCPU reset */
 	struct kvm_vcpu_csr guest_reset_csr;
 
+	/* AIA VCPU context */
+	struct kvm_vcpu_aia aia_context;
+
 	/*
 	 * VCPU interrupts
 	 *
@@ -213,12 +240,21 @@ struct kvm_vcpu_arch {
 	/* MMIO instruction details */
 	struct kvm_mmio_decode mmio_decode;
 
+	/* Unprivileged instruction fetch cache for MMIO emulation */
+	struct kvm_insn_fetch_cache insn_fetch_cache[KVM_INSN_FETCH_CACHE_SLOTS];
+
 	/* CSR instruction details */
 	struct kvm_csr_decode csr_decode;
 
 	/* SBI context */
 	struct kvm_sbi_context sbi_context;
 
+	/* SBI steal-time accounting */
+	struct {
+		gpa_t shmem;
+		u64 last_steal;
+	} sta;
+
 	/* Cache pages needed to program page tables with spinlock held */
 	struct kvm_mmu_memory_cache mmu_page_cache;
 
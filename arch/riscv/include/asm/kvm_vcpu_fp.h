@@ -27,6 +27,8 @@ void kvm_riscv_vcpu_guest_fp_restore(struct kvm_cpu_context *cntx,
 				     const unsigned long *isa);
 void kvm_riscv_vcpu_host_fp_save(struct kvm_cpu_context *cntx);
 void kvm_riscv_vcpu_host_fp_restore(struct kvm_cpu_context *cntx);
+bool kvm_riscv_vcpu_fp_lazy_enable(struct kvm_vcpu *vcpu);
+void kvm_riscv_vcpu_fp_lazy_disable(struct kvm_vcpu *vcpu);
 #else
 static inline void kvm_riscv_vcpu_fp_reset(struct kvm_vcpu *vcpu)
 {
@@ -47,6 +49,13 @@ static inline void kvm_riscv_vcpu_host_fp_restore(
 					struct kvm_cpu_context *cntx)
 {
 }
+static inline bool kvm_riscv_vcpu_fp_lazy_enable(struct kvm_vcpu *vcpu)
+{
+	return false;
+}
+static inline void kvm_riscv_vcpu_fp_lazy_disable(struct kvm_vcpu *vcpu)
+{
+}
 #endif
 
 int kvm_riscv_vcpu_get_reg_fp(struct kvm_vcpu *vcpu,
@@ -23,6 +23,15 @@ struct kvm_csr_decode {
 	int return_handled;
 };
 
+#define KVM_INSN_FETCH_CACHE_SLOTS	8
+
+struct kvm_insn_fetch_cache {
+	unsigned long sepc;
+	unsigned long insn;
+	int insn_len;
+	bool valid;
+};
+
 /* Return values used by function emulating a particular instruction */
 enum kvm_insn_return {
 	KVM_INSN_EXIT_TO_USER_SPACE = 0,
@@ -45,4 +54,6 @@ int kvm_riscv_vcpu_mmio_store(struct kvm_vcpu *vcpu, struct kvm_run *run,
 			      unsigned long htinst);
 int kvm_riscv_vcpu_mmio_return(struct kvm_vcpu *vcpu, struct kvm_run *run);
 
+void kvm_riscv_vcpu_flush_insn_cache(struct kvm_vcpu *vcpu);
+
 #endif
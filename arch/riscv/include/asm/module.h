@@ -4,6 +4,8 @@
 #ifndef _ASM_RISCV_MODULE_H
 #define _ASM_RISCV_MODULE_H
 
+#include <linux/mutex.h>
+
 #include <asm-generic/module.h>
 
 struct module;
@@ -21,6 +23,12 @@ struct mod_arch_specific {
 	struct mod_section got;
 	struct mod_section plt;
 	struct mod_section got_plt;
+	/*
+	 * Relocation sections may be applied concurrently, but all of
+	 * them emit into the shared .got/.plt/.got.plt sections above;
+	 * the scan-then-append in the emit helpers must be atomic.
+	 */
+	struct mutex emit_lock;
 };
 
 struct got_entry {
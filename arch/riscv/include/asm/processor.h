@@ -40,6 +40,10 @@ struct thread_struct {
 	struct __riscv_d_ext_state fstate;
 	unsigned long bad_cause;
 	struct __riscv_v_state vstate;
+	unsigned long vstate_ctrl;
+	/* Accesses emulated by the misaligned trap handler for this task */
+	unsigned long misaligned_loads;
+	unsigned long misaligned_stores;
 };
 
 /* Whitelist the fstate from the task_struct for hardened usercopy */
@@ -81,6 +85,22 @@ int riscv_of_parent_hartid(struct device_node *node, unsigned long *hartid);
 extern void riscv_fill_hwcap(void);
 extern int arch_dup_task_struct(struct task_struct *dst, struct task_struct *src);
 
+#ifdef CONFIG_VECTOR
+bool vstate_first_use_handler(struct pt_regs *regs);
+bool riscv_v_vstate_ctrl_user_allowed(void);
+void riscv_v_vstate_ctrl_init(struct task_struct *tsk);
+long riscv_v_vstate_ctrl_set_current(unsigned long arg);
+long riscv_v_vstate_ctrl_get_current(void);
+/* prctl(PR_RISCV_V_{SET,GET}_CONTROL) entry points used by kernel/sys.c */
+#define RISCV_V_SET_CONTROL(arg)	riscv_v_vstate_ctrl_set_current(arg)
+#define RISCV_V_GET_CONTROL()		riscv_v_vstate_ctrl_get_current()
+#else
+static inline bool vstate_first_use_handler(struct pt_regs *regs)
+{
+	return false;
+}
+#endif
+
 #endif /* __ASSEMBLY__ */
 
 #endif /* _ASM_RISCV_PROCESSOR_H */
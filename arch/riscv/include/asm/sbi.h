@@ -30,6 +30,8 @@ enum sbi_ext_id {
 	SBI_EXT_HSM = 0x48534D,
 	SBI_EXT_SRST = 0x53525354,
 	SBI_EXT_PMU = 0x504D55,
+	SBI_EXT_STA = 0x535441,
+	SBI_EXT_CPPC = 0x43505043,
 
 	/* Experimentals extensions must lie within this range */
 	SBI_EXT_EXPERIMENTAL_START = 0x08000000,
@@ -120,6 +122,8 @@ enum sbi_ext_pmu_fid {
 	SBI_EXT_PMU_COUNTER_START,
 	SBI_EXT_PMU_COUNTER_STOP,
 	SBI_EXT_PMU_COUNTER_FW_READ,
+	SBI_EXT_PMU_COUNTER_FW_READ_HI,
+	SBI_EXT_PMU_SNAPSHOT_SET_SHMEM,
 };
 
 union sbi_pmu_ctr_info {
@@ -232,6 +236,69 @@ enum sbi_pmu_ctr_type {
 
 /* Flags defined for counter stop function */
 #define SBI_PMU_STOP_FLAG_RESET (1 << 0)
+#define SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT (1 << 1)
+
+/*
+ * Data layout of the PMU snapshot shared memory: one page per hart,
+ * written by the firmware on a counter stop taking a snapshot.
+ */
+struct riscv_pmu_snapshot_data {
+	u64 ctr_overflow_mask;
+	u64 ctr_values[64];
+	u64 reserved[447];
+};
+
+#define SBI_PMU_SNAPSHOT_SHMEM_DISABLE	-1
+
+enum sbi_ext_sta_fid {
+	SBI_EXT_STA_STEAL_TIME_SET_SHMEM = 0,
+};
+
+struct sbi_sta_struct {
+	__le32 sequence;
+	__le32 flags;
+	__le64 steal;
+	u8 preempted;
+	u8 pad[47];
+} __packed;
+
+#define SBI_STA_SHMEM_DISABLE		-1
+
+enum sbi_ext_cppc_fid {
+	SBI_EXT_CPPC_PROBE = 0,
+	SBI_EXT_CPPC_READ,
+	SBI_EXT_CPPC_READ_HI,
+	SBI_EXT_CPPC_WRITE,
+};
+
+/*
+ * CPPC registers of the calling hart. IDs below 0x40000000 follow the
+ * ACPI CPPC register numbering, the rest are SBI specific.
+ */
+enum sbi_cppc_reg_id {
+	SBI_CPPC_HIGHEST_PERF		= 0x0,
+	SBI_CPPC_NOMINAL_PERF		= 0x1,
+	SBI_CPPC_LOW_NON_LINEAR_PERF	= 0x2,
+	SBI_CPPC_LOWEST_PERF		= 0x3,
+	SBI_CPPC_GUARANTEED_PERF	= 0x4,
+	SBI_CPPC_DESIRED_PERF		= 0x5,
+	SBI_CPPC_MIN_PERF		= 0x6,
+	SBI_CPPC_MAX_PERF		= 0x7,
+	SBI_CPPC_PERF_REDUC_TOLERANCE	= 0x8,
+	SBI_CPPC_TIME_WINDOW		= 0x9,
+	SBI_CPPC_CTR_WRAP_TIME		= 0xa,
+	SBI_CPPC_REFERENCE_CTR		= 0xb,
+	SBI_CPPC_DELIVERED_CTR		= 0xc,
+	SBI_CPPC_PERF_LIMITED		= 0xd,
+	SBI_CPPC_ENABLE			= 0xe,
+	SBI_CPPC_AUTO_SEL_ENABLE	= 0xf,
+	SBI_CPPC_AUTO_ACT_WINDOW	= 0x10,
+	SBI_CPPC_ENERGY_PERF_PREFERENCE	= 0x11,
+	SBI_CPPC_REFERENCE_PERF		= 0x12,
+	SBI_CPPC_LOWEST_FREQ		= 0x13,
+	SBI_CPPC_NOMINAL_FREQ		= 0x14,
+	SBI_CPPC_TRANSITION_LATENCY	= 0x40000000,
+};
 
 #define SBI_SPEC_VERSION_DEFAULT	0x1
 #define SBI_SPEC_VERSION_MAJOR_SHIFT	24
@@ -16,6 +16,13 @@ int set_memory_rw(unsigned long addr, int numpages);
 int set_memory_x(unsigned long addr, int numpages);
 int set_memory_nx(unsigned long addr, int numpages);
 int set_memory_rw_nx(unsigned long addr, int numpages);
+/*
+ * Defer the TLB shootdown for a run of set_memory_* calls to one ranged
+ * flush at set_memory_batch_end().  Sections may nest; callers must be
+ * able to sleep.
+ */
+void set_memory_batch_begin(void);
+void set_memory_batch_end(void);
 static __always_inline int set_kernel_memory(char *startp, char *endp,
 					     int (*set_memory)(unsigned long start,
 							       int num_pages))
@@ -32,6 +39,8 @@ static inline int set_memory_rw(unsigned long addr, int numpages) { return 0; }
 static inline int set_memory_x(unsigned long addr, int numpages) { return 0; }
 static inline int set_memory_nx(unsigned long addr, int numpages) { return 0; }
 static inline int set_memory_rw_nx(unsigned long addr, int numpages) { return 0; }
+static inline void set_memory_batch_begin(void) { }
+static inline void set_memory_batch_end(void) { }
 static inline int set_kernel_memory(char *startp, char *endp,
 				    int (*set_memory)(unsigned long start,
 						      int num_pages))
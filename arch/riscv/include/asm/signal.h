@@ -6,7 +6,9 @@
 #include <uapi/asm/signal.h>
 #include <uapi/asm/ptrace.h>
 
+#define __ARCH_UAPI_SA_FLAGS	SA_NOEXTCONTEXT
+
 asmlinkage __visible
-void do_work_pending(struct pt_regs *regs, unsigned long thread_info_flags);
+void arch_do_signal_or_restart(struct pt_regs *regs);
 
 #endif
@@ -53,6 +53,9 @@ void riscv_clear_ipi(void);
 /* Check other CPUs stop or not */
 bool smp_crash_stop_failed(void);
 
+/* Park all other harts through firmware for a kexec reboot */
+bool kexec_park_secondary_harts(void);
+
 /* Secondary hart entry */
 asmlinkage void smp_callin(void);
 
@@ -93,6 +96,11 @@ static inline void riscv_clear_ipi(void)
 {
 }
 
+static inline bool kexec_park_secondary_harts(void)
+{
+	return true;
+}
+
 #endif /* CONFIG_SMP */
 
 #if defined(CONFIG_HOTPLUG_CPU) && (CONFIG_SMP)
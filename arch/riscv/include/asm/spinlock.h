@@ -0,0 +1,48 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+
+#ifndef __ASM_RISCV_SPINLOCK_H
+#define __ASM_RISCV_SPINLOCK_H
+
+#ifdef CONFIG_QUEUED_SPINLOCKS
+#define _Q_PENDING_LOOPS	(1 << 9)
+
+/*
+ * The queued spinlock is only safe on cores whose LR/SC implementation
+ * guarantees forward progress for the pending-byte handoff; we cannot
+ * probe that from the ISA string, so it must be requested with
+ * "qspinlock" on the command line and the ticket lock stays the
+ * default.  Both implementations share arch_spinlock_t, see
+ * asm-generic/qspinlock_types.h.
+ */
+#include <linux/jump_label.h>
+
+#define __no_arch_spinlock_redefine
+#include <asm-generic/ticket_spinlock.h>
+#include <asm-generic/qspinlock.h>
+
+DECLARE_STATIC_KEY_FALSE(qspinlock_key);
+
+#define SPINLOCK_BASE_DECLARE(op, type, type_lock)			\
+static __always_inline type arch_spin_##op(type_lock lock)		\
+{									\
+	if (static_branch_unlikely(&qspinlock_key))			\
+		return queued_spin_##op(lock);				\
+	return ticket_spin_##op(lock);					\
+}
+
+SPINLOCK_BASE_DECLARE(lock, void, arch_spinlock_t *)
+SPINLOCK_BASE_DECLARE(unlock, void, arch_spinlock_t *)
+SPINLOCK_BASE_DECLARE(is_locked, int, arch_spinlock_t *)
+SPINLOCK_BASE_DECLARE(is_contended, int, arch_spinlock_t *)
+SPINLOCK_BASE_DECLARE(trylock, bool, arch_spinlock_t *)
+SPINLOCK_BASE_DECLARE(value_unlocked, int, arch_spinlock_t)
+
+#include <asm/qrwlock.h>
+
+#else
+
+#include <asm-generic/spinlock.h>
+
+#endif /* CONFIG_QUEUED_SPINLOCKS */
+
+#endif /* __ASM_RISCV_SPINLOCK_H */
@@ -18,6 +18,21 @@ extern asmlinkage void *__memcpy(void *, const void *, size_t);
 #define __HAVE_ARCH_MEMMOVE
 extern asmlinkage void *memmove(void *, const void *, size_t);
 extern asmlinkage void *__memmove(void *, const void *, size_t);
+#ifdef CONFIG_VECTOR
+/* Patched over the entry points above by the alternatives framework */
+extern asmlinkage void *memcpy_vector(void *, const void *, size_t);
+extern asmlinkage void *memset_vector(void *, int, size_t);
+extern asmlinkage void *memmove_vector(void *, const void *, size_t);
+/* Scalar/vector dispatch thresholds, tuned at boot by copy_tune.c */
+extern unsigned long riscv_vector_memcpy_min;
+extern unsigned long riscv_vector_memset_min;
+#endif
+#define __HAVE_ARCH_STRCMP
+extern asmlinkage int strcmp(const char *cs, const char *ct);
+#define __HAVE_ARCH_STRLEN
+extern asmlinkage __kernel_size_t strlen(const char *);
+#define __HAVE_ARCH_STRNCMP
+extern asmlinkage int strncmp(const char *cs, const char *ct, size_t count);
 /* For those files which don't want to check by kasan. */
 #if defined(CONFIG_KASAN) && !defined(__SANITIZE_ADDRESS__)
 #define memcpy(dst, src, len) __memcpy(dst, src, len)
@@ -59,7 +59,8 @@ static inline void __switch_to_aux(struct task_struct *prev,
 
 static __always_inline bool has_fpu(void)
 {
-	return static_branch_likely(&riscv_isa_ext_keys[RISCV_ISA_EXT_KEY_FPU]);
+	return riscv_has_extension_likely(RISCV_ISA_EXT_f) &&
+		riscv_has_extension_likely(RISCV_ISA_EXT_d);
 }
 
 static inline void kernel_fpu_begin(void)
@@ -88,7 +89,19 @@ extern void __vstate_restore(struct task_struct *restore_from);
 
 static inline void __vstate_clean(struct pt_regs *regs)
 {
-	regs->status |= (regs->status & ~(SR_VS)) | SR_VS_CLEAN;
+	regs->status = (regs->status & ~(SR_VS)) | SR_VS_CLEAN;
+}
+
+static inline void vstate_off(struct task_struct *task,
+		struct pt_regs *regs)
+{
+	regs->status = (regs->status & ~SR_VS) | SR_VS_OFF;
+}
+
+static inline void vstate_on(struct task_struct *task,
+		struct pt_regs *regs)
+{
+	regs->status = (regs->status & ~SR_VS) | SR_VS_INITIAL;
 }
 
 static inline void vstate_save(struct task_struct *task,
@@ -125,6 +138,20 @@ static __always_inline bool has_vector(void)
 {
 	return static_branch_likely(&cpu_hwcap_vector);
 }
+
+static inline void kernel_vector_begin(void)
+{
+	preempt_disable();
+	vstate_save(current, task_pt_regs(current));
+	csr_set(CSR_SSTATUS, SR_VS);
+}
+
+static inline void kernel_vector_end(void)
+{
+	csr_clear(CSR_SSTATUS, SR_VS);
+	vstate_restore(current, task_pt_regs(current));
+	preempt_enable();
+}
 #else
 static __always_inline bool has_vector(void) { return false; }
 #define vstate_save(task, regs) do { } while (0)
@@ -290,15 +290,45 @@ unsigned long __must_check __asm_copy_to_user(void __user *to,
 unsigned long __must_check __asm_copy_from_user(void *to,
 	const void __user *from, unsigned long n);
 
+/*
+ * Streaming copies large enough to amortize the vector state handling
+ * go through the vector unit, see lib/uaccess_vector.c.
+ */
+#define RISCV_UACCESS_VECTOR_MIN	1024
+
+unsigned long __must_check riscv_copy_user_vector(void *to, const void *from,
+						  unsigned long n);
+
+#ifdef CONFIG_VECTOR
+extern struct static_key_false cpu_hwcap_vector;
+
+static __always_inline bool uaccess_vector_usable(unsigned long n)
+{
+	return static_branch_likely(&cpu_hwcap_vector) &&
+	       n >= RISCV_UACCESS_VECTOR_MIN;
+}
+#else
+static __always_inline bool uaccess_vector_usable(unsigned long n)
+{
+	return false;
+}
+#endif
+
 static inline unsigned long
 raw_copy_from_user(void *to, const void __user *from, unsigned long n)
 {
+	if (uaccess_vector_usable(n))
+		return riscv_copy_user_vector(to, (__force const void *)from, n);
+
 	return __asm_copy_from_user(to, from, n);
 }
 
 static inline unsigned long
 raw_copy_to_user(void __user *to, const void *from, unsigned long n)
 {
+	if (uaccess_vector_usable(n))
+		return riscv_copy_user_vector((__force void *)to, from, n);
+
 	return __asm_copy_to_user(to, from, n);
 }
 
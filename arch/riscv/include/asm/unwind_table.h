@@ -0,0 +1,36 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Copyright (C) 2023 Regents of the University of California
+ */
+#ifndef _ASM_RISCV_UNWIND_TABLE_H
+#define _ASM_RISCV_UNWIND_TABLE_H
+
+#include <linux/types.h>
+
+/*
+ * One row of the compact unwind table, valid from @pc up to the @pc of
+ * the next row.  The rows are distilled at boot from the .eh_frame CFI
+ * the compiler emits and are sorted by @pc, so a frame can be unwound
+ * with one binary search and no frame pointer.
+ *
+ * The CFA (the value sp had in the caller) is recovered as base register
+ * plus offset; bit 0 of @cfa_off selects the base.  Register save slots
+ * are relative to the CFA, in units of one register.
+ */
+struct riscv_unwind_entry {
+	u32	pc;		/* offset of the first covered insn from _stext */
+	s16	cfa_off;	/* CFA = base + (cfa_off & ~1UL) */
+	s8	ra_off;		/* saved ra is at CFA + ra_off * SZREG */
+	s8	fp_off;		/* saved s0 is at CFA + fp_off * SZREG */
+};
+
+#define UNWIND_CFA_BASE_FP	1	/* bit 0 of cfa_off: 0 = sp, 1 = s0 */
+
+/* Sentinels for ra_off/fp_off */
+#define UNWIND_REG_UNSAVED	127	/* register is not on the stack */
+#define UNWIND_RA_IN_REG	126	/* ra has not been spilled yet */
+#define UNWIND_ROW_END		125	/* gap row terminating an FDE */
+
+const struct riscv_unwind_entry *riscv_unwind_find(unsigned long pc);
+
+#endif /* _ASM_RISCV_UNWIND_TABLE_H */
@@ -14,7 +14,7 @@
  */
 #ifdef CONFIG_MMU
 
-#define __VVAR_PAGES    2
+#define __VVAR_PAGES    3
 
 #ifndef __ASSEMBLY__
 #include <generated/vdso-offsets.h>
@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-2.0-only WITH Linux-syscall-note */
+#ifndef _UAPI_ASM_RISCV_SIGNAL_H
+#define _UAPI_ASM_RISCV_SIGNAL_H
+
+/*
+ * Do not save or restore FP/vector state in the signal frame for this
+ * handler.  The kernel marks the omitted state in uc_flags (see
+ * <asm/ucontext.h>); the handler must not clobber extended state it did
+ * not save itself.  Intended for high-rate signal users (e.g. runtime
+ * safepoint interrupts) whose handlers touch no FP or vector registers.
+ */
+#define SA_NOEXTCONTEXT	0x02000000
+
+#include <asm-generic/signal.h>
+
+#endif /* _UAPI_ASM_RISCV_SIGNAL_H */
@@ -10,6 +10,16 @@
 
 #include <linux/types.h>
 
+/*
+ * uc_flags bits set by the kernel when the corresponding state was not
+ * written to uc_mcontext, either because the handler was installed with
+ * SA_NOEXTCONTEXT or because the unit was off in the interrupted context.
+ * Omitted state is not restored by rt_sigreturn either; the contents of
+ * the corresponding sigcontext fields are undefined.
+ */
+#define UC_FP_OMITTED		(1UL << 0)
+#define UC_VECTOR_OMITTED	(1UL << 1)
+
 struct ucontext {
 	unsigned long	  uc_flags;
 	struct ucontext	 *uc_link;
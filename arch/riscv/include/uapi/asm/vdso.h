@@ -0,0 +1,26 @@
+/* SPDX-License-Identifier: GPL-2.0-only WITH Linux-syscall-note */
+/*
+ * Copyright (C) 2023 Regents of the University of California
+ */
+#ifndef _UAPI_ASM_RISCV_VDSO_H
+#define _UAPI_ASM_RISCV_VDSO_H
+
+#include <linux/types.h>
+
+/*
+ * Per-cpu data exposed to userspace through the vDSO, one record per
+ * possible cpu.  A record is returned by __vdso_riscv_cpu_data(cpu);
+ * records for cpus that never came online read as zero.
+ */
+struct riscv_vdso_cpu_data {
+	__u32	hartid;		/* hart backing this logical cpu */
+	__u32	node;		/* NUMA node of the cpu */
+	__u32	l1d_size;	/* L1 D-cache size, bytes */
+	__u32	l1d_line_size;	/* L1 D-cache line size, bytes */
+	__u32	llc_size;	/* last-level cache size, bytes */
+	__u32	llc_line_size;	/* last-level cache line size, bytes */
+	__u32	llc_level;	/* cache level of the LLC, 0 if unknown */
+	__u32	__reserved;
+};
+
+#endif /* _UAPI_ASM_RISCV_VDSO_H */
@@ -7,15 +7,24 @@
  */
 
 #include <linux/init.h>
+#include <linux/bitops.h>
 #include <linux/module.h>
 #include <linux/cpu.h>
 #include <linux/uaccess.h>
 #include <asm/alternative.h>
+#include <asm/parse_asm.h>
+#include <asm/patch.h>
 #include <asm/sections.h>
 #include <asm/vendorid_list.h>
 #include <asm/sbi.h>
 #include <asm/csr.h>
 
+#define OPCODE_AUIPC	0x17
+#define MASK_AUIPC	0x7f
+#define MATCH_AUIPC	OPCODE_AUIPC
+#define MASK_BRANCH	0x7f
+#define MATCH_BRANCH	OPCODE_BRANCH
+
 struct cpu_manufacturer_info_t {
 	unsigned long vendor_id;
 	unsigned long arch_id;
@@ -53,6 +62,137 @@ static void __init_or_module riscv_fill_cpu_mfr_info(struct cpu_manufacturer_inf
 	}
 }
 
+static u32 riscv_instruction_at(void *p)
+{
+	u16 *parcel = p;
+
+	return (u32)parcel[0] | (u32)parcel[1] << 16;
+}
+
+static inline s32 riscv_insn_extract_jtype_imm(u32 insn)
+{
+	return sign_extend32(((insn & GENMASK(30, 21)) >> (21 - 1)) |
+			     ((insn & BIT(20)) >> (20 - 11)) |
+			     (insn & GENMASK(19, 12)) |
+			     ((insn & BIT(31)) >> (31 - 20)), 20);
+}
+
+static inline s32 riscv_insn_extract_btype_imm(u32 insn)
+{
+	return sign_extend32(((insn & GENMASK(11, 8)) >> (8 - 1)) |
+			     ((insn & GENMASK(30, 25)) >> (25 - 5)) |
+			     ((insn & BIT(7)) << (11 - 7)) |
+			     ((insn & BIT(31)) >> (31 - 12)), 12);
+}
+
+static void riscv_alternative_fix_auipc_jalr(void *ptr, u32 auipc_insn,
+					     u32 jalr_insn, int patch_offset)
+{
+	u32 call[2] = { auipc_insn, jalr_insn };
+	s32 imm;
+
+	/* get and adjust new target address */
+	imm = (auipc_insn & GENMASK(31, 12)) + ((s32)jalr_insn >> 20);
+	imm -= patch_offset;
+
+	/* pick the original auipc + jalr */
+	call[0] &= ~GENMASK(31, 12);
+	call[1] &= ~GENMASK(31, 20);
+
+	/* drop the old IMMs, all imm bits can be set here */
+	call[0] |= (imm & GENMASK(31, 12)) + ((imm & BIT(11)) << 1);
+	call[1] |= (imm & GENMASK(11, 0)) << 20;
+
+	/* patch the call place again */
+	patch_text_nosync(ptr, call, sizeof(u32) * 2);
+}
+
+static void riscv_alternative_fix_jal(void *ptr, u32 jal_insn, int patch_offset)
+{
+	s32 imm;
+
+	/* get and adjust new target address */
+	imm = riscv_insn_extract_jtype_imm(jal_insn);
+	imm -= patch_offset;
+
+	/* drop the old IMM and install the new one */
+	jal_insn &= ~GENMASK(31, 12);
+	jal_insn |= ((imm & GENMASK(10, 1)) << (21 - 1)) |
+		    ((imm & BIT(11)) << (20 - 11)) |
+		    (imm & GENMASK(19, 12)) |
+		    ((imm & BIT(20)) << (31 - 20));
+
+	/* patch the call place again */
+	patch_text_nosync(ptr, &jal_insn, sizeof(jal_insn));
+}
+
+/*
+ * Alternative replacement instructions are assembled in a different
+ * location than the one they get patched into, so any PC-relative
+ * reference to a symbol outside the alternative block itself is off by
+ * the distance between the two (@patch_offset). Walk the patched range
+ * and adjust such references; jumps and branches that stay within the
+ * block keep their offsets and are left alone.
+ */
+void __init_or_module riscv_alternative_fix_offsets(void *alt_ptr,
+						    unsigned int len,
+						    int patch_offset)
+{
+	int num_insn = len / sizeof(u32);
+	int i;
+
+	for (i = 0; i < num_insn; i++) {
+		u32 insn = riscv_instruction_at(alt_ptr + i * sizeof(u32));
+		s32 imm;
+
+		/*
+		 * May be the start of an auipc + jalr pair
+		 * Needs to check that at least one more instruction
+		 * is in the block.
+		 */
+		if ((insn & MASK_AUIPC) == MATCH_AUIPC && i < num_insn - 1) {
+			u32 insn2 = riscv_instruction_at(alt_ptr +
+							 (i + 1) * sizeof(u32));
+
+			if ((insn2 & MASK_JALR) == MATCH_JALR) {
+				riscv_alternative_fix_auipc_jalr(alt_ptr +
+							i * sizeof(u32),
+							insn, insn2,
+							patch_offset);
+				i++;
+				continue;
+			}
+		}
+
+		if ((insn & MASK_JAL) == MATCH_JAL) {
+			imm = riscv_insn_extract_jtype_imm(insn);
+
+			/* the jump stays inside the patched block */
+			if (imm >= -(s32)(i * sizeof(u32)) &&
+			    imm < (s32)(len - i * sizeof(u32)))
+				continue;
+
+			riscv_alternative_fix_jal(alt_ptr + i * sizeof(u32),
+						  insn, patch_offset);
+			continue;
+		}
+
+		if ((insn & MASK_BRANCH) == MATCH_BRANCH) {
+			imm = riscv_insn_extract_btype_imm(insn);
+
+			/*
+			 * Conditional branches can not reach outside the
+			 * block once moved, their +-4K range is too small
+			 * to absorb the patch offset.
+			 */
+			WARN(imm < -(s32)(i * sizeof(u32)) ||
+			     imm >= (s32)(len - i * sizeof(u32)),
+			     "unfixable branch in alternative at %px",
+			     alt_ptr + i * sizeof(u32));
+		}
+	}
+}
+
 /*
  * This is called very early in the boot process (directly after we run
  * a feature detect on the boot CPU). No need to worry about other CPUs
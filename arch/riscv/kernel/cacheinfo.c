@@ -3,6 +3,7 @@
  * Copyright (C) 2017 SiFive
  */
 
+#include <linux/arch_topology.h>
 #include <linux/cpu.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
@@ -113,6 +114,48 @@ static void fill_cacheinfo(struct cacheinfo **this_leaf,
 	}
 }
 
+/*
+ * Derive the CPU cluster topology from the cache hierarchy when the
+ * devicetree cpu-map does not describe clusters. CPUs whose first
+ * next-level cache node is shared (the per-cluster L2 on SG2042 style
+ * parts) are grouped into one cluster, so that the scheduler and managed
+ * IRQ affinity spreading see the shared-L2 domains.
+ *
+ * Must run after init_cpu_topology() and before the secondary CPUs call
+ * update_siblings_masks(), which builds the cluster sibling masks from
+ * the ids assigned here.
+ */
+void __init riscv_fill_cluster_topology(void)
+{
+	unsigned int cpu;
+
+	/* Nothing to do if the cpu-map already provided clusters. */
+	for_each_possible_cpu(cpu)
+		if (cpu_topology[cpu].cluster_id != -1)
+			return;
+
+	for_each_possible_cpu(cpu) {
+		struct device_node *np, *cache;
+
+		np = of_cpu_device_node_get(cpu);
+		if (!np)
+			continue;
+
+		cache = of_find_next_cache_node(np);
+		of_node_put(np);
+		if (!cache)
+			continue;
+
+		/*
+		 * The phandle is only ever compared for equality, so it
+		 * serves directly as the cluster id.
+		 */
+		if (of_device_is_compatible(cache, "cache"))
+			cpu_topology[cpu].cluster_id = cache->phandle;
+		of_node_put(cache);
+	}
+}
+
 int init_cache_level(unsigned int cpu)
 {
 	struct cpu_cacheinfo *this_cpu_ci = get_cpu_cacheinfo(cpu);
@@ -7,6 +7,7 @@
 #include <linux/init.h>
 #include <linux/seq_file.h>
 #include <linux/of.h>
+#include <asm/cpufeature.h>
 #include <asm/csr.h>
 #include <asm/hwcap.h>
 #include <asm/sbi.h>
@@ -236,6 +237,19 @@ static void print_mmu(struct seq_file *f)
 	seq_printf(f, "mmu\t\t: %s\n", sv_type);
 }
 
+static void print_misaligned(struct seq_file *f, unsigned long cpu_id)
+{
+	static const char * const speed[] = {
+		[RISCV_MISALIGNED_UNKNOWN]	= "unknown",
+		[RISCV_MISALIGNED_EMULATED]	= "emulated",
+		[RISCV_MISALIGNED_SLOW]		= "slow",
+		[RISCV_MISALIGNED_FAST]		= "fast",
+	};
+
+	seq_printf(f, "misaligned\t: %s\n",
+		   speed[per_cpu(misaligned_access_speed, cpu_id)]);
+}
+
 static void *c_start(struct seq_file *m, loff_t *pos)
 {
 	if (*pos == nr_cpu_ids)
@@ -269,6 +283,7 @@ static int c_show(struct seq_file *m, void *v)
 	if (!of_property_read_string(node, "riscv,isa", &isa))
 		print_isa(m, isa);
 	print_mmu(m);
+	print_misaligned(m, cpu_id);
 	if (!of_property_read_string(node, "compatible", &compat)
 	    && strcmp(compat, "riscv"))
 		seq_printf(m, "uarch\t\t: %s\n", compat);
@@ -23,6 +23,9 @@ const struct cpu_operations cpu_ops_sbi;
  */
 static DEFINE_PER_CPU(struct sbi_hart_boot_data, boot_data);
 
+/* Harts already sitting in the head.S holding pen, waiting for a stack */
+static cpumask_t hart_in_pen;
+
 static int sbi_hsm_hart_start(unsigned long hartid, unsigned long saddr,
 			      unsigned long priv)
 {
@@ -72,19 +75,43 @@ static int sbi_cpu_start(unsigned int cpuid, struct task_struct *tidle)
 	/* Make sure tidle is updated */
 	smp_mb();
 	bdata->task_ptr = tidle;
+	/* The stack doubles as the release flag for a hart in the pen */
+	smp_mb();
 	bdata->stack_ptr = task_stack_page(tidle) + THREAD_SIZE;
 	/* Make sure boot data is updated */
 	smp_mb();
+
+	if (cpumask_test_and_clear_cpu(cpuid, &hart_in_pen))
+		return 0;
+
 	hsm_data = __pa(bdata);
 	return sbi_hsm_hart_start(hartid, boot_addr, hsm_data);
 }
 
 static int sbi_cpu_prepare(unsigned int cpuid)
 {
+	struct sbi_hart_boot_data *bdata = &per_cpu(boot_data, cpuid);
+	unsigned long hartid = cpuid_to_hartid_map(cpuid);
+
 	if (!cpu_ops_sbi.cpu_start) {
 		pr_err("cpu start method not defined for CPU [%d]\n", cpuid);
 		return -ENODEV;
 	}
+
+	/*
+	 * Kick the hart into the holding pen right away so that the slow
+	 * firmware part of every secondary bring-up runs in parallel while
+	 * __cpu_up() releases one hart at a time by publishing its boot
+	 * data.  A hart that cannot be started here simply takes the
+	 * ordered path in sbi_cpu_start() later.
+	 */
+	bdata->task_ptr = NULL;
+	bdata->stack_ptr = NULL;
+	smp_mb();
+	if (!sbi_hsm_hart_start(hartid, __pa_symbol(secondary_start_sbi),
+				__pa(bdata)))
+		cpumask_set_cpu(cpuid, &hart_in_pen);
+
 	return 0;
 }
 
@@ -8,13 +8,17 @@
 
 #include <linux/init.h>
 #include <linux/bitmap.h>
+#include <linux/cpu.h>
 #include <linux/ctype.h>
 #include <linux/libfdt.h>
+#include <linux/log2.h>
 #include <linux/memory.h>
 #include <linux/module.h>
 #include <linux/of.h>
+#include <linux/timex.h>
 #include <asm/alternative.h>
 #include <asm/cacheflush.h>
+#include <asm/cpufeature.h>
 #include <asm/errata_list.h>
 #include <asm/hwcap.h>
 #include <asm/patch.h>
@@ -30,7 +34,7 @@ unsigned long elf_hwcap __read_mostly;
 /* Host ISA bitmap */
 static DECLARE_BITMAP(riscv_isa, RISCV_ISA_EXT_MAX) __read_mostly;
 
-DEFINE_STATIC_KEY_ARRAY_FALSE(riscv_isa_ext_keys, RISCV_ISA_EXT_KEY_MAX);
+DEFINE_STATIC_KEY_ARRAY_FALSE(riscv_isa_ext_keys, RISCV_ISA_EXT_MAX);
 EXPORT_SYMBOL(riscv_isa_ext_keys);
 
 #ifdef CONFIG_VECTOR
@@ -220,8 +224,17 @@ void __init riscv_fill_hwcap(void)
 				SET_ISA_EXT_MAP("svpbmt", RISCV_ISA_EXT_SVPBMT);
 				SET_ISA_EXT_MAP("zicbom", RISCV_ISA_EXT_ZICBOM);
 				SET_ISA_EXT_MAP("zihintpause", RISCV_ISA_EXT_ZIHINTPAUSE);
+				SET_ISA_EXT_MAP("ssaia", RISCV_ISA_EXT_SSAIA);
 				SET_ISA_EXT_MAP("sstc", RISCV_ISA_EXT_SSTC);
 				SET_ISA_EXT_MAP("svinval", RISCV_ISA_EXT_SVINVAL);
+				SET_ISA_EXT_MAP("svnapot", RISCV_ISA_EXT_SVNAPOT);
+				SET_ISA_EXT_MAP("zacas", RISCV_ISA_EXT_ZACAS);
+				SET_ISA_EXT_MAP("zba", RISCV_ISA_EXT_ZBA);
+				SET_ISA_EXT_MAP("zbb", RISCV_ISA_EXT_ZBB);
+				SET_ISA_EXT_MAP("zicboz", RISCV_ISA_EXT_ZICBOZ);
+				SET_ISA_EXT_MAP("zkr", RISCV_ISA_EXT_ZKR);
+				SET_ISA_EXT_MAP("zvkg", RISCV_ISA_EXT_ZVKG);
+				SET_ISA_EXT_MAP("zvkned", RISCV_ISA_EXT_ZVKNED);
 			}
 #undef SET_ISA_EXT_MAP
 		}
@@ -277,13 +290,67 @@ void __init riscv_fill_hwcap(void)
 			print_str[j++] = (char)('a' + i);
 	pr_info("riscv: ELF capabilities %s\n", print_str);
 
-	for_each_set_bit(i, riscv_isa, RISCV_ISA_EXT_MAX) {
-		j = riscv_isa_ext2key(i);
-		if (j >= 0)
-			static_branch_enable(&riscv_isa_ext_keys[j]);
-	}
+	for_each_set_bit(i, riscv_isa, RISCV_ISA_EXT_MAX)
+		static_branch_enable(&riscv_isa_ext_keys[i]);
+}
+
+DEFINE_PER_CPU(long, misaligned_access_speed) = RISCV_MISALIGNED_UNKNOWN;
+
+#define MISALIGNED_BUFFER_SIZE	0x100
+#define MISALIGNED_COPY_SIZE	((MISALIGNED_BUFFER_SIZE / 2) - 0x10)
+#define MISALIGNED_ITERATIONS	32
+
+static void __check_unaligned_access(void *unused)
+{
+	long *speed = this_cpu_ptr(&misaligned_access_speed);
+	int cpu = smp_processor_id();
+	u64 start, word_cycles, byte_cycles;
+	u8 buf[MISALIGNED_BUFFER_SIZE];
+	u8 *dst = buf + 1;
+	u8 *src = buf + MISALIGNED_BUFFER_SIZE / 2;
+	int i, j;
+
+	/* Time a misaligned word copy against the byte copy it replaces */
+	start = get_cycles();
+	for (i = 0; i < MISALIGNED_ITERATIONS; i++)
+		for (j = 0; j < MISALIGNED_COPY_SIZE; j += sizeof(ulong))
+			*(ulong *)(dst + j) = *(ulong *)(src + 1 + j);
+	word_cycles = get_cycles() - start;
+
+	start = get_cycles();
+	for (i = 0; i < MISALIGNED_ITERATIONS; i++)
+		for (j = 0; j < MISALIGNED_COPY_SIZE; j++)
+			dst[j] = src[1 + j];
+	byte_cycles = get_cycles() - start;
+
+	/*
+	 * The copies above trap into handle_misaligned_load() when the
+	 * accesses are delegated to the kernel, which latches EMULATED;
+	 * don't let the (terrible) measurement overwrite that.
+	 */
+	if (*speed == RISCV_MISALIGNED_EMULATED)
+		return;
+
+	*speed = word_cycles < byte_cycles ? RISCV_MISALIGNED_FAST :
+					     RISCV_MISALIGNED_SLOW;
+	pr_info("cpu%d: hardware misaligned accesses are %s\n", cpu,
+		*speed == RISCV_MISALIGNED_FAST ? "fast" : "slow");
 }
 
+static int riscv_online_cpu(unsigned int cpu)
+{
+	__check_unaligned_access(NULL);
+	return 0;
+}
+
+static int __init check_unaligned_access_all_cpus(void)
+{
+	cpuhp_setup_state(CPUHP_AP_ONLINE_DYN, "riscv:check_unaligned",
+			  riscv_online_cpu, NULL);
+	return 0;
+}
+arch_initcall(check_unaligned_access_all_cpus);
+
 #ifdef CONFIG_RISCV_ALTERNATIVE
 static bool __init_or_module cpufeature_probe_svpbmt(unsigned int stage)
 {
@@ -311,6 +378,59 @@ static bool __init_or_module cpufeature_probe_zicbom(unsigned int stage)
 	return true;
 }
 
+static bool __init_or_module cpufeature_probe_zicboz(unsigned int stage)
+{
+	if (!IS_ENABLED(CONFIG_RISCV_ISA_ZICBOZ))
+		return false;
+
+	if (stage == RISCV_ALTERNATIVES_EARLY_BOOT)
+		return false;
+
+	if (!riscv_isa_extension_available(NULL, ZICBOZ))
+		return false;
+
+	/* clear_page() walks whole pages in block-size steps */
+	if (!riscv_cboz_block_size ||
+	    !is_power_of_2(riscv_cboz_block_size) ||
+	    riscv_cboz_block_size > PAGE_SIZE)
+		return false;
+
+	return true;
+}
+
+static bool __init_or_module cpufeature_probe_zbb(unsigned int stage)
+{
+	if (!IS_ENABLED(CONFIG_RISCV_ISA_ZBB))
+		return false;
+
+	if (stage == RISCV_ALTERNATIVES_EARLY_BOOT)
+		return false;
+
+	return riscv_isa_extension_available(NULL, ZBB);
+}
+
+static bool __init_or_module cpufeature_probe_zacas(unsigned int stage)
+{
+	if (!IS_ENABLED(CONFIG_RISCV_ISA_ZACAS))
+		return false;
+
+	if (stage == RISCV_ALTERNATIVES_EARLY_BOOT)
+		return false;
+
+	return riscv_isa_extension_available(NULL, ZACAS);
+}
+
+static bool __init_or_module cpufeature_probe_vector(unsigned int stage)
+{
+	if (!IS_ENABLED(CONFIG_VECTOR))
+		return false;
+
+	if (stage == RISCV_ALTERNATIVES_EARLY_BOOT)
+		return false;
+
+	return riscv_isa_extension_available(NULL, v);
+}
+
 /*
  * Probe presence of individual extensions.
  *
@@ -328,6 +448,18 @@ static u32 __init_or_module cpufeature_probe(unsigned int stage)
 	if (cpufeature_probe_zicbom(stage))
 		cpu_req_feature |= BIT(CPUFEATURE_ZICBOM);
 
+	if (cpufeature_probe_zicboz(stage))
+		cpu_req_feature |= BIT(CPUFEATURE_ZICBOZ);
+
+	if (cpufeature_probe_zbb(stage))
+		cpu_req_feature |= BIT(CPUFEATURE_ZBB);
+
+	if (cpufeature_probe_zacas(stage))
+		cpu_req_feature |= BIT(CPUFEATURE_ZACAS);
+
+	if (cpufeature_probe_vector(stage))
+		cpu_req_feature |= BIT(CPUFEATURE_VECTOR);
+
 	return cpu_req_feature;
 }
 
@@ -352,6 +484,8 @@ void __init_or_module riscv_cpufeature_patch_func(struct alt_entry *begin,
 		if (cpu_req_feature & tmp) {
 			mutex_lock(&text_mutex);
 			patch_text_nosync(alt->old_ptr, alt->alt_ptr, alt->alt_len);
+			riscv_alternative_fix_offsets(alt->old_ptr, alt->alt_len,
+						      alt->old_ptr - alt->alt_ptr);
 			mutex_unlock(&text_mutex);
 		}
 	}
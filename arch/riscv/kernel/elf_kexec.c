@@ -108,7 +108,25 @@ static int elf_find_pbase(struct kimage *image, unsigned long kernel_len,
 	kbuf.mem = KEXEC_BUF_MEM_UNKNOWN;
 	kbuf.memsz = ALIGN(kernel_len, PAGE_SIZE);
 	kbuf.top_down = false;
-	ret = arch_kexec_locate_mem_hole(&kbuf);
+
+	/*
+	 * Prefer the boot-time reserved pool for a regular kexec so that
+	 * machine_kexec_prepare() can stage the segments into their final
+	 * pages at load time and skip the reboot-time relocation copy.
+	 */
+	ret = -ENOMEM;
+	if (image->type != KEXEC_TYPE_CRASH && kexec_pool_size) {
+		kbuf.buf_min = kexec_pool_base;
+		kbuf.buf_max = kexec_pool_base + kexec_pool_size - 1;
+		ret = arch_kexec_locate_mem_hole(&kbuf);
+		if (ret) {
+			pr_warn("Image doesn't fit the kexec pool, it won't be preloaded\n");
+			kbuf.buf_min = lowest_paddr;
+			kbuf.buf_max = ULONG_MAX;
+		}
+	}
+	if (ret)
+		ret = arch_kexec_locate_mem_hole(&kbuf);
 	if (!ret) {
 		*old_pbase = lowest_paddr;
 		*new_pbase = kbuf.mem;
@@ -165,6 +183,26 @@ out:
 	return ret;
 }
 
+/*
+ * Add a buffer to the image, preferring the currently set pool bounds.
+ * Preloading needs every buffer inside the pool, but an overflowing pool
+ * must not fail the load: fall back to placing the buffer anywhere, which
+ * makes machine_kexec_prepare() keep the image on the relocation path.
+ */
+static int kexec_add_buffer_pooled(struct kexec_buf *kbuf)
+{
+	int ret;
+
+	ret = kexec_add_buffer(kbuf);
+	if (!ret || kbuf->buf_max == ULONG_MAX)
+		return ret;
+
+	pr_warn("kexec pool is full, the image won't be preloaded\n");
+	kbuf->buf_max = ULONG_MAX;
+	kbuf->mem = KEXEC_BUF_MEM_UNKNOWN;
+	return kexec_add_buffer(kbuf);
+}
+
 static char *setup_kdump_cmdline(struct kimage *image, char *cmdline,
 				 unsigned long cmdline_len)
 {
@@ -228,6 +266,11 @@ static void *elf_kexec_load(struct kimage *image, char *kernel_buf,
 	kbuf.buf_min = new_kernel_pbase + kernel_len;
 	kbuf.buf_max = ULONG_MAX;
 
+	/* Keep the rest of the image in the pool when the kernel made it */
+	if (kexec_pool_size && new_kernel_pbase >= kexec_pool_base &&
+	    new_kernel_pbase < kexec_pool_base + kexec_pool_size)
+		kbuf.buf_max = kexec_pool_base + kexec_pool_size - 1;
+
 	/* Add elfcorehdr */
 	if (image->type == KEXEC_TYPE_CRASH) {
 		ret = prepare_elf_headers(&headers, &headers_sz);
@@ -271,6 +314,12 @@ static void *elf_kexec_load(struct kimage *image, char *kernel_buf,
 	kbuf.top_down = true;
 	kbuf.mem = KEXEC_BUF_MEM_UNKNOWN;
 	ret = kexec_load_purgatory(image, &kbuf);
+	if (ret && kbuf.buf_max != ULONG_MAX) {
+		pr_warn("kexec pool is full, the image won't be preloaded\n");
+		kbuf.buf_max = ULONG_MAX;
+		kbuf.mem = KEXEC_BUF_MEM_UNKNOWN;
+		ret = kexec_load_purgatory(image, &kbuf);
+	}
 	if (ret) {
 		pr_err("Error loading purgatory ret=%d\n", ret);
 		goto out;
@@ -289,7 +338,7 @@ static void *elf_kexec_load(struct kimage *image, char *kernel_buf,
 		kbuf.buf_align = PAGE_SIZE;
 		kbuf.top_down = true;
 		kbuf.mem = KEXEC_BUF_MEM_UNKNOWN;
-		ret = kexec_add_buffer(&kbuf);
+		ret = kexec_add_buffer_pooled(&kbuf);
 		if (ret)
 			goto out;
 		initrd_pbase = kbuf.mem;
@@ -311,7 +360,7 @@ static void *elf_kexec_load(struct kimage *image, char *kernel_buf,
 	kbuf.buf_align = PAGE_SIZE;
 	kbuf.mem = KEXEC_BUF_MEM_UNKNOWN;
 	kbuf.top_down = true;
-	ret = kexec_add_buffer(&kbuf);
+	ret = kexec_add_buffer_pooled(&kbuf);
 	if (ret) {
 		pr_err("Error add DTB kbuf ret=%d\n", ret);
 		goto out_free_fdt;
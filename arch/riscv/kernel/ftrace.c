@@ -15,54 +15,13 @@
 void ftrace_arch_code_modify_prepare(void) __acquires(&text_mutex)
 {
 	mutex_lock(&text_mutex);
-
-	/*
-	 * The code sequences we use for ftrace can't be patched while the
-	 * kernel is running, so we need to use stop_machine() to modify them
-	 * for now.  This doesn't play nice with text_mutex, we use this flag
-	 * to elide the check.
-	 */
-	riscv_patch_in_stop_machine = true;
 }
 
 void ftrace_arch_code_modify_post_process(void) __releases(&text_mutex)
 {
-	riscv_patch_in_stop_machine = false;
 	mutex_unlock(&text_mutex);
 }
 
-static int ftrace_check_current_call(unsigned long hook_pos,
-				     unsigned int *expected)
-{
-	unsigned int replaced[2];
-	unsigned int nops[2] = {NOP4, NOP4};
-
-	/* we expect nops at the hook position */
-	if (!expected)
-		expected = nops;
-
-	/*
-	 * Read the text we want to modify;
-	 * return must be -EFAULT on read error
-	 */
-	if (copy_from_kernel_nofault(replaced, (void *)hook_pos,
-			MCOUNT_INSN_SIZE))
-		return -EFAULT;
-
-	/*
-	 * Make sure it is what we expect it to be;
-	 * return must be -EINVAL on failed comparison
-	 */
-	if (memcmp(expected, replaced, sizeof(replaced))) {
-		pr_err("%p: expected (%08x %08x) but got (%08x %08x)\n",
-		       (void *)hook_pos, expected[0], expected[1], replaced[0],
-		       replaced[1]);
-		return -EINVAL;
-	}
-
-	return 0;
-}
-
 static int __ftrace_modify_call(unsigned long hook_pos, unsigned long target,
 				bool enable, bool ra)
 {
@@ -74,21 +33,50 @@ static int __ftrace_modify_call(unsigned long hook_pos, unsigned long target,
 	else
 		make_call_t0(hook_pos, target, call);
 
-	/* Replace the auipc-jalr pair at once. Return -EPERM on write error. */
-	if (patch_text_nosync
-	    ((void *)hook_pos, enable ? call : nops, MCOUNT_INSN_SIZE))
+	/*
+	 * These hooks live inside the ftrace trampolines and may be executed
+	 * while they are retargeted, so swap the whole auipc-jalr pair under
+	 * stop_machine().  There are only a handful of them per state change,
+	 * unlike the call sites themselves.
+	 */
+	if (patch_text((void *)hook_pos, enable ? call : nops, 2))
 		return -EPERM;
 
 	return 0;
 }
 
-int ftrace_make_call(struct dyn_ftrace *rec, unsigned long addr)
+/*
+ * A concurrently executing hart must always observe a call site as either
+ * fully enabled or fully disabled, but only a single naturally aligned
+ * 32-bit store is atomic with respect to instruction fetch.  We therefore
+ * keep the auipc resident at the call site even while tracing is off and
+ * only ever toggle the jalr word: the stray auipc merely clobbers t0,
+ * which is dead at function entry.  Both words are written together only
+ * by ftrace_init_nop(), before the site can be executed, or under
+ * stop_machine() in the unlikely case that the high part of the target
+ * offset changed.
+ */
+static int ftrace_patch_jalr(unsigned long hook_pos, unsigned long target)
 {
 	unsigned int call[2];
+	unsigned int replaced;
 
-	make_call_t0(rec->ip, addr, call);
+	make_call_t0(hook_pos, target, call);
 
-	if (patch_text_nosync((void *)rec->ip, call, MCOUNT_INSN_SIZE))
+	if (copy_from_kernel_nofault(&replaced, (void *)hook_pos,
+			sizeof(replaced)))
+		return -EFAULT;
+
+	if (replaced != call[0])
+		return patch_text((void *)hook_pos, call, 2);
+
+	return patch_insn_write((void *)(hook_pos + 4), &call[1],
+				sizeof(call[1]));
+}
+
+int ftrace_make_call(struct dyn_ftrace *rec, unsigned long addr)
+{
+	if (ftrace_patch_jalr(rec->ip, addr))
 		return -EPERM;
 
 	return 0;
@@ -97,9 +85,9 @@ int ftrace_make_call(struct dyn_ftrace *rec, unsigned long addr)
 int ftrace_make_nop(struct module *mod, struct dyn_ftrace *rec,
 		    unsigned long addr)
 {
-	unsigned int nops[2] = {NOP4, NOP4};
+	unsigned int nop = NOP4;
 
-	if (patch_text_nosync((void *)rec->ip, nops, MCOUNT_INSN_SIZE))
+	if (patch_insn_write((void *)(rec->ip + 4), &nop, sizeof(nop)))
 		return -EPERM;
 
 	return 0;
@@ -111,13 +99,21 @@ int ftrace_make_nop(struct module *mod, struct dyn_ftrace *rec,
  * text_mutex, which triggers a lockdep failure.  SMP isn't running so we could
  * just directly poke the text, but it's simpler to just take the lock
  * ourselves.
+ *
+ * The compiler filled the site with nops; install the resident auipc over
+ * the first one.  The site can't be live yet, so replacing both words is
+ * fine here, and it is the only place that may do so outside stop_machine.
  */
 int ftrace_init_nop(struct module *mod, struct dyn_ftrace *rec)
 {
+	unsigned int insns[2];
 	int out;
 
+	make_call_t0(rec->ip, ftrace_caller, insns);
+	insns[1] = NOP4;
+
 	mutex_lock(&text_mutex);
-	out = ftrace_make_nop(mod, rec, MCOUNT_ADDR);
+	out = patch_text_nosync((void *)rec->ip, insns, MCOUNT_INSN_SIZE);
 	mutex_unlock(&text_mutex);
 
 	return out;
@@ -134,6 +130,18 @@ int ftrace_update_ftrace_func(ftrace_func_t func)
 
 	return ret;
 }
+
+void arch_ftrace_update_code(int command)
+{
+	ftrace_modify_all_code(command);
+
+	/*
+	 * The call sites were toggled with plain stores above; do a single
+	 * global instruction stream sync at the end of the batch instead of
+	 * broadcasting a fence per site.
+	 */
+	flush_icache_all();
+}
 #endif
 
 #ifdef CONFIG_DYNAMIC_FTRACE_WITH_REGS
@@ -141,16 +149,26 @@ int ftrace_modify_call(struct dyn_ftrace *rec, unsigned long old_addr,
 		       unsigned long addr)
 {
 	unsigned int call[2];
+	unsigned int replaced;
 	unsigned long caller = rec->ip;
-	int ret;
 
 	make_call_t0(caller, old_addr, call);
-	ret = ftrace_check_current_call(caller, call);
 
-	if (ret)
-		return ret;
+	/* The jalr word must still target the old tracer */
+	if (copy_from_kernel_nofault(&replaced, (void *)(caller + 4),
+			sizeof(replaced)))
+		return -EFAULT;
 
-	return __ftrace_modify_call(caller, addr, true, false);
+	if (replaced != call[1]) {
+		pr_err("%p: expected (%08x) but got (%08x)\n",
+		       (void *)caller, call[1], replaced);
+		return -EINVAL;
+	}
+
+	if (ftrace_patch_jalr(caller, addr))
+		return -EPERM;
+
+	return 0;
 }
 #endif
 
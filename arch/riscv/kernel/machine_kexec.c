@@ -42,6 +42,45 @@ kexec_image_info(const struct kimage *image)
 	}
 }
 
+/*
+ * machine_kexec_preload - Stage segments at their final physical pages
+ *
+ * When kexec_file_load() managed to place the whole image inside the
+ * boot-time reserved pool, the destination pages can't be handed out to
+ * anybody else, so the segments may be copied there right now instead
+ * of going through the relocation trampoline at reboot time.  The
+ * indirection list built by the generic code is simply ignored then and
+ * machine_kexec() jumps to the new kernel via riscv_kexec_norelocate.
+ */
+static void
+machine_kexec_preload(struct kimage *image)
+{
+	unsigned long i;
+
+	if (!image->file_mode || image->type == KEXEC_TYPE_CRASH ||
+	    !kexec_pool_size)
+		return;
+
+	for (i = 0; i < image->nr_segments; i++) {
+		if (image->segment[i].mem < kexec_pool_base ||
+		    image->segment[i].mem + image->segment[i].memsz >
+		    kexec_pool_base + kexec_pool_size)
+			return;
+	}
+
+	for (i = 0; i < image->nr_segments; i++) {
+		struct kexec_segment *seg = &image->segment[i];
+		/* The pool is reserved RAM, still in the linear mapping */
+		void *dst = __va(seg->mem);
+
+		memcpy(dst, seg->kbuf, seg->bufsz);
+		memset(dst + seg->bufsz, 0, seg->memsz - seg->bufsz);
+	}
+
+	image->arch.preloaded = 1;
+	pr_info("Image preloaded, reboot will skip the relocation copy\n");
+}
+
 /*
  * machine_kexec_prepare - Initialize kexec
  *
@@ -62,6 +101,8 @@ machine_kexec_prepare(struct kimage *image)
 
 	kexec_image_info(image);
 
+	machine_kexec_preload(image);
+
 	/* Find the Flattened Device Tree and save its physical address */
 	for (i = 0; i < image->nr_segments; i++) {
 		if (image->segment[i].memsz <= sizeof(fdt))
@@ -135,6 +176,15 @@ void machine_shutdown(void)
 	 */
 	local_irq_disable();
 
+	/*
+	 * Taking the secondary harts through the full hotplug state
+	 * machine one at a time dominates the kexec blackout on many-hart
+	 * machines.  The new kernel only needs them in the HSM STOPPED
+	 * state, so park them all in parallel when firmware allows it.
+	 */
+	if (kexec_park_secondary_harts())
+		return;
+
 #if defined(CONFIG_HOTPLUG_CPU)
 	smp_shutdown_nonboot_cpus(smp_processor_id());
 #endif
@@ -219,7 +269,12 @@ machine_kexec(struct kimage *image)
 		"Some CPUs may be stale, kdump will be unreliable.\n");
 #endif
 
-	if (image->type != KEXEC_TYPE_CRASH)
+	/*
+	 * Preloaded segments already sit at their final physical pages,
+	 * crash segments were copied to the crashkernel region at load
+	 * time; neither needs the relocation trampoline.
+	 */
+	if (image->type != KEXEC_TYPE_CRASH && !internal->preloaded)
 		kexec_method = control_code_buffer;
 	else
 		kexec_method = (riscv_kexec_method) &riscv_kexec_norelocate;
@@ -13,20 +13,26 @@
 unsigned long module_emit_got_entry(struct module *mod, unsigned long val)
 {
 	struct mod_section *got_sec = &mod->arch.got;
-	int i = got_sec->num_entries;
-	struct got_entry *got = get_got_entry(val, got_sec);
+	struct got_entry *got;
+	int i;
+
+	mutex_lock(&mod->arch.emit_lock);
 
-	if (got)
-		return (unsigned long)got;
+	got = get_got_entry(val, got_sec);
+	if (!got) {
+		/* There is no duplicate entry, create a new one */
+		i = got_sec->num_entries;
+		got = (struct got_entry *)got_sec->shdr->sh_addr;
+		got[i] = emit_got_entry(val);
 
-	/* There is no duplicate entry, create a new one */
-	got = (struct got_entry *)got_sec->shdr->sh_addr;
-	got[i] = emit_got_entry(val);
+		got_sec->num_entries++;
+		BUG_ON(got_sec->num_entries > got_sec->max_entries);
+		got = &got[i];
+	}
 
-	got_sec->num_entries++;
-	BUG_ON(got_sec->num_entries > got_sec->max_entries);
+	mutex_unlock(&mod->arch.emit_lock);
 
-	return (unsigned long)&got[i];
+	return (unsigned long)got;
 }
 
 unsigned long module_emit_plt_entry(struct module *mod, unsigned long val)
@@ -34,25 +40,31 @@ unsigned long module_emit_plt_entry(struct module *mod, unsigned long val)
 	struct mod_section *got_plt_sec = &mod->arch.got_plt;
 	struct got_entry *got_plt;
 	struct mod_section *plt_sec = &mod->arch.plt;
-	struct plt_entry *plt = get_plt_entry(val, plt_sec, got_plt_sec);
-	int i = plt_sec->num_entries;
-
-	if (plt)
-		return (unsigned long)plt;
+	struct plt_entry *plt;
+	int i;
 
-	/* There is no duplicate entry, create a new one */
-	got_plt = (struct got_entry *)got_plt_sec->shdr->sh_addr;
-	got_plt[i] = emit_got_entry(val);
-	plt = (struct plt_entry *)plt_sec->shdr->sh_addr;
-	plt[i] = emit_plt_entry(val,
-				(unsigned long)&plt[i],
-				(unsigned long)&got_plt[i]);
+	mutex_lock(&mod->arch.emit_lock);
+
+	plt = get_plt_entry(val, plt_sec, got_plt_sec);
+	if (!plt) {
+		/* There is no duplicate entry, create a new one */
+		i = plt_sec->num_entries;
+		got_plt = (struct got_entry *)got_plt_sec->shdr->sh_addr;
+		got_plt[i] = emit_got_entry(val);
+		plt = (struct plt_entry *)plt_sec->shdr->sh_addr;
+		plt[i] = emit_plt_entry(val,
+					(unsigned long)&plt[i],
+					(unsigned long)&got_plt[i]);
+
+		plt_sec->num_entries++;
+		got_plt_sec->num_entries++;
+		BUG_ON(plt_sec->num_entries > plt_sec->max_entries);
+		plt = &plt[i];
+	}
 
-	plt_sec->num_entries++;
-	got_plt_sec->num_entries++;
-	BUG_ON(plt_sec->num_entries > plt_sec->max_entries);
+	mutex_unlock(&mod->arch.emit_lock);
 
-	return (unsigned long)&plt[i];
+	return (unsigned long)plt;
 }
 
 static int is_rela_equal(const Elf_Rela *x, const Elf_Rela *y)
@@ -94,6 +106,8 @@ int module_frob_arch_sections(Elf_Ehdr *ehdr, Elf_Shdr *sechdrs,
 	unsigned int num_gots = 0;
 	int i;
 
+	mutex_init(&mod->arch.emit_lock);
+
 	/*
 	 * Find the empty .got and .plt sections.
 	 */
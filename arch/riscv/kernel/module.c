@@ -445,11 +445,32 @@ int apply_relocate_add(Elf_Shdr *sechdrs, const char *strtab,
 #if defined(CONFIG_MMU) && defined(CONFIG_64BIT)
 void *module_alloc(unsigned long size)
 {
-	return __vmalloc_node_range(size, 1, MODULES_VADDR,
-				    MODULES_END, GFP_KERNEL,
-				    PAGE_KERNEL, VM_FLUSH_RESET_PERMS,
-				    NUMA_NO_NODE,
-				    __builtin_return_address(0));
+	void *p;
+
+	/*
+	 * The module region lies within +-2GB of kernel text, so calls and
+	 * auipc-based references into the kernel resolve to direct
+	 * instruction sequences without going through the PLT/GOT.
+	 */
+	p = __vmalloc_node_range(size, 1, MODULES_VADDR,
+				 MODULES_END, GFP_KERNEL | __GFP_NOWARN,
+				 PAGE_KERNEL, VM_FLUSH_RESET_PERMS,
+				 NUMA_NO_NODE,
+				 __builtin_return_address(0));
+
+	/*
+	 * If the in-range region is exhausted or too fragmented, fall back
+	 * to the whole vmalloc space: out-of-range calls are then routed
+	 * through the module's PLT and GOT.
+	 */
+	if (!p && IS_ENABLED(CONFIG_MODULE_SECTIONS))
+		p = __vmalloc_node_range(size, 1, VMALLOC_START,
+					 VMALLOC_END, GFP_KERNEL,
+					 PAGE_KERNEL, VM_FLUSH_RESET_PERMS,
+					 NUMA_NO_NODE,
+					 __builtin_return_address(0));
+
+	return p;
 }
 #endif
 
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: GPL-2.0+
+/*
+ * Optimized kprobes: replace the probed instruction with a jump into
+ * an out-of-line trampoline instead of taking an ebreak trap plus a
+ * single-step exception on every hit.
+ */
+
+#define pr_fmt(fmt) "optprobes: " fmt
+
+#include <linux/kprobes.h>
+#include <linux/memory.h>
+#include <linux/mutex.h>
+#include <linux/sizes.h>
+#include <asm/bug.h>
+#include <asm/cacheflush.h>
+#include <asm/ftrace.h>
+#include <asm/parse_asm.h>
+#include <asm/patch.h>
+
+#include "decode-insn.h"
+
+#define TMPL_CALL_IDX	(optprobe_template_call - optprobe_template_entry)
+#define TMPL_INSN_IDX	(optprobe_template_insn - optprobe_template_entry)
+#define TMPL_RET_IDX	(optprobe_template_return - optprobe_template_entry)
+#define TMPL_DATA_IDX	(optprobe_template_data - optprobe_template_entry)
+
+/*
+ * The slot page is linked into the kernel image (see opt_trampoline.S)
+ * so that a single jal can reach the slots from the probe point; it is
+ * never handed back to the allocator.
+ */
+static bool insn_page_in_use;
+
+void *alloc_optinsn_page(void)
+{
+	if (insn_page_in_use)
+		return NULL;
+	insn_page_in_use = true;
+	return optinsn_page;
+}
+
+void free_optinsn_page(void *page)
+{
+	WARN_ONCE(page != optinsn_page, "unexpected optinsn page %p\n", page);
+	insn_page_in_use = false;
+}
+
+/* jal only reaches +-1MB around the probed instruction */
+static bool in_jal_range(unsigned long from, unsigned long to)
+{
+	long offset = to - from;
+
+	return offset >= -(long)SZ_1M && offset < (long)SZ_1M;
+}
+
+static u32 to_jal(long offset)
+{
+	/* jal zero, offset */
+	return OPCODE_JAL |
+		(((u32)offset & GENMASK(19, 12)) << (12 - 12)) |
+		(((u32)offset & GENMASK(11, 11)) << (20 - 11)) |
+		(((u32)offset & GENMASK(10,  1)) << (21 -  1)) |
+		(((u32)offset & GENMASK(20, 20)) << (31 - 20));
+}
+
+static void __used optimized_callback(struct optimized_kprobe *op,
+				      struct pt_regs *regs)
+{
+	if (kprobe_disabled(&op->kp))
+		return;
+
+	preempt_disable();
+	if (kprobe_running()) {
+		kprobes_inc_nmissed_count(&op->kp);
+	} else {
+		__this_cpu_write(current_kprobe, &op->kp);
+		regs->epc = (unsigned long)op->kp.addr;
+		get_kprobe_ctlblk()->kprobe_status = KPROBE_HIT_ACTIVE;
+		opt_pre_handler(&op->kp, regs);
+		__this_cpu_write(current_kprobe, NULL);
+	}
+	preempt_enable();
+}
+NOKPROBE_SYMBOL(optimized_callback);
+
+static bool can_optimize(struct kprobe *kp)
+{
+	struct arch_probe_insn api;
+
+	/* only a whole 32-bit instruction can be displaced by the jal */
+	if (GET_INSN_LENGTH(kp->opcode) != 4)
+		return false;
+
+	/*
+	 * The displaced instruction runs out of line in the slot, so
+	 * anything PC-relative or privileged, which the decoder wants
+	 * to simulate or reject, has to stay on the ebreak path.
+	 */
+	return riscv_probe_decode_insn(&kp->opcode, &api) == INSN_GOOD;
+}
+
+int arch_prepared_optinsn(struct arch_optimized_insn *optinsn)
+{
+	return optinsn->insn != NULL;
+}
+
+int arch_check_optimized_kprobe(struct optimized_kprobe *op)
+{
+	/* only the probed instruction itself is displaced */
+	return 0;
+}
+
+int arch_prepare_optimized_kprobe(struct optimized_kprobe *op,
+				  struct kprobe *orig)
+{
+	unsigned long addr = (unsigned long)orig->addr;
+	unsigned long val = (unsigned long)op;
+	kprobe_opcode_t *code;
+	u32 call[2];
+	u32 insn;
+	int ret;
+
+	if (!can_optimize(orig))
+		return -EILSEQ;
+
+	code = get_optinsn_slot();
+	if (!code)
+		return -ENOMEM;
+
+	/*
+	 * Both the jump into the slot and the jump back behind the
+	 * probe point must be within jal range of the slot.
+	 */
+	if (!in_jal_range(addr, (unsigned long)code) ||
+	    !in_jal_range((unsigned long)&code[TMPL_RET_IDX], addr + 4)) {
+		free_optinsn_slot(code, 0);
+		return -ERANGE;
+	}
+
+	make_call_ra(&code[TMPL_CALL_IDX], optimized_callback, call);
+	insn = to_jal(addr + 4 - (unsigned long)&code[TMPL_RET_IDX]);
+
+	/* the slot lives in kernel text, so go through the fixmap */
+	mutex_lock(&text_mutex);
+	ret = patch_text_nosync(code, optprobe_template_entry,
+				MAX_OPTINSN_SIZE * sizeof(kprobe_opcode_t));
+	if (!ret)
+		ret = patch_text_nosync(&code[TMPL_DATA_IDX], &val, sizeof(val));
+	if (!ret)
+		ret = patch_text_nosync(&code[TMPL_CALL_IDX], call, sizeof(call));
+	if (!ret)
+		ret = patch_text_nosync(&code[TMPL_INSN_IDX], &orig->opcode,
+					sizeof(orig->opcode));
+	if (!ret)
+		ret = patch_text_nosync(&code[TMPL_RET_IDX], &insn, sizeof(insn));
+	mutex_unlock(&text_mutex);
+
+	if (ret) {
+		free_optinsn_slot(code, 0);
+		return ret;
+	}
+
+	op->optinsn.insn = code;
+	return 0;
+}
+
+void arch_optimize_kprobes(struct list_head *oplist)
+{
+	struct optimized_kprobe *op, *tmp;
+	u32 insn;
+
+	list_for_each_entry_safe(op, tmp, oplist, list) {
+		WARN_ON(kprobe_disabled(&op->kp));
+
+		insn = to_jal((unsigned long)op->optinsn.insn -
+			      (unsigned long)op->kp.addr);
+		patch_text(op->kp.addr, &insn, 1);
+		list_del_init(&op->list);
+	}
+}
+
+void arch_unoptimize_kprobe(struct optimized_kprobe *op)
+{
+	u32 insn = __BUG_INSN_32;
+
+	/* fall back to the armed ebreak; disarming restores the insn */
+	patch_text(op->kp.addr, &insn, 1);
+}
+
+void arch_unoptimize_kprobes(struct list_head *oplist,
+			     struct list_head *done_list)
+{
+	struct optimized_kprobe *op, *tmp;
+
+	list_for_each_entry_safe(op, tmp, oplist, list) {
+		arch_unoptimize_kprobe(op);
+		list_move(&op->list, done_list);
+	}
+}
+
+void arch_remove_optimized_kprobe(struct optimized_kprobe *op)
+{
+	if (op->optinsn.insn) {
+		free_optinsn_slot(op->optinsn.insn, 1);
+		op->optinsn.insn = NULL;
+	}
+}
+
+int arch_within_optimized_kprobe(struct optimized_kprobe *op,
+				 kprobe_opcode_t *addr)
+{
+	return op->kp.addr == addr;
+}
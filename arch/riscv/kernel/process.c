@@ -15,6 +15,7 @@
 #include <linux/tick.h>
 #include <linux/ptrace.h>
 #include <linux/uaccess.h>
+#include <linux/prctl.h>
 
 #include <asm/unistd.h>
 #include <asm/processor.h>
@@ -34,7 +35,6 @@ EXPORT_SYMBOL(__stack_chk_guard);
 #endif
 
 extern asmlinkage void ret_from_fork(void);
-extern asmlinkage void ret_from_kernel_thread(void);
 
 void arch_cpu_idle(void)
 {
@@ -126,8 +126,14 @@ void start_thread(struct pt_regs *regs, unsigned long pc,
 	}
 
 	if (has_vector()) {
-		regs->status |= SR_VS_INITIAL;
-		vstate_restore(current, regs);
+		riscv_v_vstate_ctrl_init(current);
+		/*
+		 * The vector unit is enabled lazily: SR_VS stays off until
+		 * the first vector instruction traps in do_trap_insn_illegal.
+		 * Clean state is thus never saved or restored for threads
+		 * that do not touch the vector unit.
+		 */
+		vstate_off(current, regs);
 	}
 
 	regs->epc = pc;
@@ -154,11 +160,18 @@ void flush_thread(void)
 	fstate_off(current, task_pt_regs(current));
 	memset(&current->thread.fstate, 0, sizeof(current->thread.fstate));
 #endif
+#ifdef CONFIG_VECTOR
+	/* Reset vector state and disable the unit until its next first use */
+	vstate_off(current, task_pt_regs(current));
+	memset(&current->thread.vstate, 0, sizeof(current->thread.vstate));
+#endif
 }
 
 int arch_dup_task_struct(struct task_struct *dst, struct task_struct *src)
 {
 	fstate_save(src, task_pt_regs(src));
+	if (has_vector())
+		vstate_save(src, task_pt_regs(src));
 	*dst = *src;
 	return 0;
 }
@@ -172,6 +185,10 @@ int copy_thread(struct task_struct *p, const struct kernel_clone_args *args)
 
 	memset(&p->thread.s, 0, sizeof(p->thread.s));
 
+	/* The misaligned access counters start from scratch for a new task */
+	p->thread.misaligned_loads = 0;
+	p->thread.misaligned_stores = 0;
+
 	/* p->thread holds context to be restored by __switch_to() */
 	if (unlikely(args->fn)) {
 		/* Kernel thread */
@@ -180,7 +197,6 @@ int copy_thread(struct task_struct *p, const struct kernel_clone_args *args)
 		/* Supervisor/Machine, irqs on: */
 		childregs->status = SR_PP | SR_PIE;
 
-		p->thread.ra = (unsigned long)ret_from_kernel_thread;
 		p->thread.s[0] = (unsigned long)args->fn;
 		p->thread.s[1] = (unsigned long)args->fn_arg;
 	} else {
@@ -190,11 +206,125 @@ int copy_thread(struct task_struct *p, const struct kernel_clone_args *args)
 		if (clone_flags & CLONE_SETTLS)
 			childregs->tp = tls;
 		childregs->a0 = 0; /* Return value of fork() */
-		p->thread.ra = (unsigned long)ret_from_fork;
+		p->thread.s[0] = 0;
 	}
+	p->thread.ra = (unsigned long)ret_from_fork;
 	p->thread.sp = (unsigned long)childregs; /* kernel sp */
 	return 0;
 }
 
+#ifdef CONFIG_VECTOR
+/*
+ * Per-thread vector state control, exposed to userspace through
+ * prctl(PR_RISCV_V_SET_CONTROL). The low bits select the policy for the
+ * current thread, the next bits the policy latched for the next execve(),
+ * and PR_RISCV_V_VSTATE_CTRL_INHERIT keeps the latched policy across
+ * further execve() calls. A runtime can thereby pre-declare vector-free
+ * threads so that they never take the first-use trap.
+ */
+static unsigned long riscv_v_ctrl_get_cur(struct task_struct *tsk)
+{
+	return tsk->thread.vstate_ctrl & PR_RISCV_V_VSTATE_CTRL_CUR_MASK;
+}
+
+static unsigned long riscv_v_ctrl_get_next(struct task_struct *tsk)
+{
+	return (tsk->thread.vstate_ctrl & PR_RISCV_V_VSTATE_CTRL_NEXT_MASK) >> 2;
+}
+
+static bool riscv_v_ctrl_test_inherit(struct task_struct *tsk)
+{
+	return tsk->thread.vstate_ctrl & PR_RISCV_V_VSTATE_CTRL_INHERIT;
+}
+
+static void riscv_v_ctrl_set(struct task_struct *tsk, int cur, int nxt,
+			     bool inherit)
+{
+	unsigned long ctrl;
+
+	ctrl = cur & PR_RISCV_V_VSTATE_CTRL_CUR_MASK;
+	ctrl |= (nxt << 2) & PR_RISCV_V_VSTATE_CTRL_NEXT_MASK;
+	if (inherit)
+		ctrl |= PR_RISCV_V_VSTATE_CTRL_INHERIT;
+	tsk->thread.vstate_ctrl = ctrl;
+}
+
+bool riscv_v_vstate_ctrl_user_allowed(void)
+{
+	return riscv_v_ctrl_get_cur(current) != PR_RISCV_V_VSTATE_CTRL_OFF;
+}
+
+void riscv_v_vstate_ctrl_init(struct task_struct *tsk)
+{
+	bool inherit;
+	int cur, next;
+
+	if (!has_vector())
+		return;
+
+	next = riscv_v_ctrl_get_next(tsk);
+	if (!next)
+		cur = PR_RISCV_V_VSTATE_CTRL_DEFAULT;
+	else
+		cur = next;
+
+	/* Clear next mask if inherit-bit is not set */
+	inherit = riscv_v_ctrl_test_inherit(tsk);
+	if (!inherit)
+		next = PR_RISCV_V_VSTATE_CTRL_DEFAULT;
+
+	riscv_v_ctrl_set(tsk, cur, next, inherit);
+}
+
+long riscv_v_vstate_ctrl_get_current(void)
+{
+	if (!has_vector())
+		return -EINVAL;
+
+	return current->thread.vstate_ctrl & PR_RISCV_V_VSTATE_CTRL_MASK;
+}
+
+long riscv_v_vstate_ctrl_set_current(unsigned long arg)
+{
+	bool inherit;
+	int cur, next;
+
+	if (!has_vector())
+		return -EINVAL;
+
+	if (arg & ~PR_RISCV_V_VSTATE_CTRL_MASK)
+		return -EINVAL;
+
+	cur = arg & PR_RISCV_V_VSTATE_CTRL_CUR_MASK;
+	switch (cur) {
+	case PR_RISCV_V_VSTATE_CTRL_OFF:
+		/* Do not allow turning off V if it is already in use */
+		if ((task_pt_regs(current)->status & SR_VS) != SR_VS_OFF)
+			return -EPERM;
+		break;
+	case PR_RISCV_V_VSTATE_CTRL_ON:
+	case PR_RISCV_V_VSTATE_CTRL_DEFAULT:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	next = (arg & PR_RISCV_V_VSTATE_CTRL_NEXT_MASK) >> 2;
+	switch (next) {
+	case PR_RISCV_V_VSTATE_CTRL_DEFAULT:
+	case PR_RISCV_V_VSTATE_CTRL_OFF:
+	case PR_RISCV_V_VSTATE_CTRL_ON:
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	inherit = !!(arg & PR_RISCV_V_VSTATE_CTRL_INHERIT);
+	riscv_v_ctrl_set(current, cur, next, inherit);
+
+	return 0;
+}
+#endif /* CONFIG_VECTOR */
+
 EXPORT_SYMBOL_GPL(__fstate_save);
 EXPORT_SYMBOL_GPL(__fstate_restore);
@@ -6,7 +6,10 @@
  */
 
 #include <linux/bits.h>
+#include <linux/cpumask.h>
 #include <linux/init.h>
+#include <linux/irqflags.h>
+#include <linux/percpu.h>
 #include <linux/pm.h>
 #include <linux/reboot.h>
 #include <asm/sbi.h>
@@ -248,6 +251,102 @@ static void __sbi_set_timer_v02(uint64_t stime_value)
 #endif
 }
 
+/*
+ * Cache of the last cpumask-to-hartmask conversion done on this CPU.
+ * The cpuid-to-hartid map is fixed after boot, so a cached conversion
+ * stays valid for as long as the cpumask contents match; no
+ * invalidation is needed.  TLB shootdown paths convert the same
+ * mm_cpumask over and over, so the hit rate is high.
+ *
+ * SBI IPI and rfence calls are legal from hardirq context, so the
+ * cache slot must only ever be read or written with interrupts
+ * disabled; otherwise an interrupt arriving mid-update could observe
+ * or leave behind a torn {cpus, hmask, hbase, valid} tuple and later
+ * sends would target the wrong hart window.
+ */
+struct sbi_hmask_cache {
+	struct cpumask cpus;
+	unsigned long hmask;
+	unsigned long hbase;
+	bool valid;
+};
+
+static DEFINE_PER_CPU(struct sbi_hmask_cache, sbi_hmask_cache);
+
+/*
+ * Try to convert @cpu_mask into a single hmask/hbase window so the
+ * whole request fits in one ecall.  Returns false when the hartids are
+ * spread over more than BITS_PER_LONG and the caller must fall back to
+ * the multi-call walk.
+ */
+static bool sbi_cpumask_to_hartmask(const struct cpumask *cpu_mask,
+				    unsigned long *hmask_out,
+				    unsigned long *hbase_out)
+{
+	unsigned long hartid, cpuid, hmask = 0, hbase = 0, htop = 0;
+	struct sbi_hmask_cache *cache;
+	struct cpumask snapshot;
+	bool single = true;
+	unsigned long flags;
+
+	local_irq_save(flags);
+	cache = this_cpu_ptr(&sbi_hmask_cache);
+	if (cache->valid && cpumask_equal(cpu_mask, &cache->cpus)) {
+		*hmask_out = cache->hmask;
+		*hbase_out = cache->hbase;
+		local_irq_restore(flags);
+		return true;
+	}
+	local_irq_restore(flags);
+
+	/*
+	 * Callers pass live masks (mm_cpumask), so snapshot once and
+	 * derive both the hartmask and the published cpus copy from the
+	 * same mask contents.  A bit set concurrently between the walk
+	 * and the publish would otherwise end up in cpus but not in
+	 * hmask, and every later hit on that entry would silently skip
+	 * the hart's IPI or remote fence.
+	 */
+	cpumask_copy(&snapshot, cpu_mask);
+
+	for_each_cpu(cpuid, &snapshot) {
+		hartid = cpuid_to_hartid_map(cpuid);
+		if (hmask) {
+			if (hartid + BITS_PER_LONG <= htop ||
+			    hbase + BITS_PER_LONG <= hartid) {
+				single = false;
+				break;
+			}
+			if (hartid < hbase) {
+				/* shift the mask to fit lower hartid */
+				hmask <<= hbase - hartid;
+				hbase = hartid;
+			}
+		}
+		if (!hmask) {
+			hbase = hartid;
+			htop = hartid;
+		} else if (hartid > htop) {
+			htop = hartid;
+		}
+		hmask |= BIT(hartid - hbase);
+	}
+
+	if (single && hmask) {
+		local_irq_save(flags);
+		cache = this_cpu_ptr(&sbi_hmask_cache);
+		cpumask_copy(&cache->cpus, &snapshot);
+		cache->hmask = hmask;
+		cache->hbase = hbase;
+		cache->valid = true;
+		local_irq_restore(flags);
+		*hmask_out = hmask;
+		*hbase_out = hbase;
+	}
+
+	return single && hmask;
+}
+
 static int __sbi_send_ipi_v02(const struct cpumask *cpu_mask)
 {
 	unsigned long hartid, cpuid, hmask = 0, hbase = 0, htop = 0;
@@ -257,6 +356,16 @@ static int __sbi_send_ipi_v02(const struct cpumask *cpu_mask)
 	if (!cpu_mask || cpumask_empty(cpu_mask))
 		cpu_mask = cpu_online_mask;
 
+	if (sbi_cpumask_to_hartmask(cpu_mask, &hmask, &hbase)) {
+		ret = sbi_ecall(SBI_EXT_IPI, SBI_EXT_IPI_SEND_IPI,
+				hmask, hbase, 0, 0, 0, 0);
+		if (ret.error)
+			goto ecall_failed;
+		return 0;
+	}
+	hmask = 0;
+	hbase = 0;
+
 	for_each_cpu(cpuid, cpu_mask) {
 		hartid = cpuid_to_hartid_map(cpuid);
 		if (hmask) {
@@ -362,6 +471,12 @@ static int __sbi_rfence_v02(int fid, const struct cpumask *cpu_mask,
 	if (!cpu_mask || cpumask_empty(cpu_mask))
 		cpu_mask = cpu_online_mask;
 
+	if (sbi_cpumask_to_hartmask(cpu_mask, &hmask, &hbase))
+		return __sbi_rfence_v02_call(fid, hmask, hbase,
+					     start, size, arg4, arg5);
+	hmask = 0;
+	hbase = 0;
+
 	for_each_cpu(cpuid, cpu_mask) {
 		hartid = cpuid_to_hartid_map(cpuid);
 		if (hmask) {
@@ -20,6 +20,7 @@
 #include <linux/smp.h>
 #include <linux/efi.h>
 #include <linux/crash_dump.h>
+#include <linux/jump_label.h>
 
 #include <asm/alternative.h>
 #include <asm/cacheflush.h>
@@ -262,6 +263,34 @@ static void __init parse_dtb(void)
 #endif
 }
 
+#ifdef CONFIG_QUEUED_SPINLOCKS
+DEFINE_STATIC_KEY_FALSE(qspinlock_key);
+EXPORT_SYMBOL(qspinlock_key);
+
+static bool enable_qspinlock __initdata;
+static int __init queued_spinlock_setup(char *p)
+{
+	enable_qspinlock = true;
+	return 0;
+}
+early_param("qspinlock", queued_spinlock_setup);
+#endif
+
+static void __init riscv_spinlock_init(void)
+{
+#ifdef CONFIG_QUEUED_SPINLOCKS
+	/*
+	 * The ISA string carries no forward-progress guarantee for LR/SC,
+	 * so the queued spinlock is strictly opt-in; without it we stay
+	 * on the generic ticket lock.
+	 */
+	if (enable_qspinlock) {
+		static_branch_enable(&qspinlock_key);
+		pr_info("Queued spinlock: enabled\n");
+	}
+#endif
+}
+
 void __init setup_arch(char **cmdline_p)
 {
 	parse_dtb();
@@ -294,7 +323,9 @@ void __init setup_arch(char **cmdline_p)
 #endif
 
 	riscv_init_cbom_blocksize();
+	riscv_init_cboz_blocksize();
 	riscv_fill_hwcap();
+	riscv_spinlock_init();
 	apply_boot_alternatives();
 }
 
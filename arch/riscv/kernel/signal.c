@@ -10,7 +10,6 @@
 #include <linux/signal.h>
 #include <linux/uaccess.h>
 #include <linux/syscalls.h>
-#include <linux/resume_user_mode.h>
 #include <linux/linkage.h>
 
 #include <asm/ucontext.h>
@@ -122,16 +121,16 @@ static long save_v_state(struct pt_regs *regs,
 #endif
 
 static long restore_sigcontext(struct pt_regs *regs,
-	struct sigcontext __user *sc)
+	struct sigcontext __user *sc, unsigned long uc_flags)
 {
 	long err;
 	/* sc_regs is structured the same as the start of pt_regs */
 	err = __copy_from_user(regs, &sc->sc_regs, sizeof(sc->sc_regs));
-	/* Restore the floating-point state. */
-	if (has_fpu())
+	/* Restore the floating-point state, unless it was never saved. */
+	if (has_fpu() && !(uc_flags & UC_FP_OMITTED))
 		err |= restore_fp_state(regs, &sc->sc_fpregs);
-	/* Restore the vector state. */
-	if (has_vector())
+	/* Restore the vector state, unless it was never saved. */
+	if (has_vector() && !(uc_flags & UC_VECTOR_OMITTED))
 		err |= restore_v_state(regs, &sc->sc_vregs);
 	return err;
 }
@@ -141,6 +140,7 @@ SYSCALL_DEFINE0(rt_sigreturn)
 	struct pt_regs *regs = current_pt_regs();
 	struct rt_sigframe __user *frame;
 	struct task_struct *task;
+	unsigned long uc_flags;
 	sigset_t set;
 
 	/* Always make any pending restarted system calls return -EINTR */
@@ -156,7 +156,10 @@ SYSCALL_DEFINE0(rt_sigreturn)
 
 	set_current_blocked(&set);
 
-	if (restore_sigcontext(regs, &frame->uc.uc_mcontext))
+	if (__get_user(uc_flags, &frame->uc.uc_flags))
+		goto badframe;
+
+	if (restore_sigcontext(regs, &frame->uc.uc_mcontext, uc_flags))
 		goto badframe;
 
 	if (restore_altstack(&frame->uc.uc_stack))
@@ -179,18 +182,33 @@ badframe:
 }
 
 static long setup_sigcontext(struct rt_sigframe __user *frame,
-	struct pt_regs *regs)
+	struct pt_regs *regs, struct ksignal *ksig, unsigned long *uc_flags)
 {
 	struct sigcontext __user *sc = &frame->uc.uc_mcontext;
+	bool skip_ext = ksig->ka.sa.sa_flags & SA_NOEXTCONTEXT;
 	long err;
 	/* sc_regs is structured the same as the start of pt_regs */
 	err = __copy_to_user(&sc->sc_regs, regs, sizeof(sc->sc_regs));
-	/* Save the floating-point state. */
-	if (has_fpu())
-		err |= save_fp_state(regs, &sc->sc_fpregs);
-	/* Save the vector state. */
-	if (has_vector())
-		err |= save_v_state(regs, &sc->sc_vregs);
+	/*
+	 * Save the floating-point and vector state.  Writing out a unit's
+	 * state is skipped when the handler opted out with SA_NOEXTCONTEXT,
+	 * or when the unit is off in the interrupted context and therefore
+	 * holds no live state.  Either way the omission is recorded in
+	 * uc_flags so rt_sigreturn does not restore from the unwritten
+	 * sigcontext fields.
+	 */
+	if (has_fpu()) {
+		if (skip_ext || (regs->status & SR_FS) == SR_FS_OFF)
+			*uc_flags |= UC_FP_OMITTED;
+		else
+			err |= save_fp_state(regs, &sc->sc_fpregs);
+	}
+	if (has_vector()) {
+		if (skip_ext || (regs->status & SR_VS) == SR_VS_OFF)
+			*uc_flags |= UC_VECTOR_OMITTED;
+		else
+			err |= save_v_state(regs, &sc->sc_vregs);
+	}
 	return err;
 }
 
@@ -221,6 +239,7 @@ static int setup_rt_frame(struct ksignal *ksig, sigset_t *set,
 	struct pt_regs *regs)
 {
 	struct rt_sigframe __user *frame;
+	unsigned long uc_flags = 0;
 	long err = 0;
 	unsigned long __maybe_unused addr;
 
@@ -231,10 +250,10 @@ static int setup_rt_frame(struct ksignal *ksig, sigset_t *set,
 	err |= copy_siginfo_to_user(&frame->info, &ksig->info);
 
 	/* Create the ucontext. */
-	err |= __put_user(0, &frame->uc.uc_flags);
 	err |= __put_user(NULL, &frame->uc.uc_link);
 	err |= __save_altstack(&frame->uc.uc_stack, regs->sp);
-	err |= setup_sigcontext(frame, regs);
+	err |= setup_sigcontext(frame, regs, ksig, &uc_flags);
+	err |= __put_user(uc_flags, &frame->uc.uc_flags);
 	err |= __copy_to_user(&frame->uc.uc_sigmask, set, sizeof(*set));
 	if (err)
 		return -EFAULT;
@@ -321,7 +340,12 @@ static void handle_signal(struct ksignal *ksig, struct pt_regs *regs)
 	signal_setup_done(ret, ksig, 0);
 }
 
-static void do_signal(struct pt_regs *regs)
+/*
+ * Handle any pending signal work, as indicated by _TIF_SIGPENDING and
+ * _TIF_NOTIFY_SIGNAL.  Entered from the generic exit-to-user loop with
+ * interrupts enabled.
+ */
+asmlinkage __visible void arch_do_signal_or_restart(struct pt_regs *regs)
 {
 	struct ksignal ksig;
 
@@ -358,29 +382,3 @@ static void do_signal(struct pt_regs *regs)
 	 */
 	restore_saved_sigmask();
 }
-
-/*
- * Handle any pending work on the resume-to-userspace path, as indicated by
- * _TIF_WORK_MASK. Entered from assembly with IRQs off.
- */
-asmlinkage __visible void do_work_pending(struct pt_regs *regs,
-					  unsigned long thread_info_flags)
-{
-	do {
-		if (thread_info_flags & _TIF_NEED_RESCHED) {
-			schedule();
-		} else {
-			local_irq_enable();
-			if (thread_info_flags & _TIF_UPROBE)
-				uprobe_notify_resume(regs);
-			/* Handle pending signal delivery */
-			if (thread_info_flags & (_TIF_SIGPENDING |
-						 _TIF_NOTIFY_SIGNAL))
-				do_signal(regs);
-			if (thread_info_flags & _TIF_NOTIFY_RESUME)
-				resume_user_mode_work(regs);
-		}
-		local_irq_disable();
-		thread_info_flags = read_thread_flags();
-	} while (thread_info_flags & _TIF_WORK_MASK);
-}
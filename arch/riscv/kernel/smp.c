@@ -30,6 +30,7 @@ enum ipi_message_type {
 	IPI_CALL_FUNC,
 	IPI_CPU_STOP,
 	IPI_CPU_CRASH_STOP,
+	IPI_CPU_PARK,
 	IPI_IRQ_WORK,
 	IPI_TIMER,
 	IPI_MAX
@@ -92,11 +93,39 @@ static inline void ipi_cpu_crash_stop(unsigned int cpu, struct pt_regs *regs)
 	for(;;)
 		wait_for_interrupt();
 }
+/*
+ * Hand this hart back to the firmware for a kexec reboot.  Unlike a
+ * regular hot unplug no hotplug states are unwound; the new kernel
+ * reinitializes everything anyway and only needs the hart in the HSM
+ * STOPPED state to be able to start it again.
+ */
+static void ipi_park(void)
+{
+	unsigned int cpu = smp_processor_id();
+
+	set_cpu_online(cpu, false);
+
+	local_irq_disable();
+
+#ifdef CONFIG_HOTPLUG_CPU
+	if (cpu_has_hotplug(cpu))
+		cpu_ops[cpu]->cpu_stop();
+#endif
+
+	/* The firmware would not take the hart, park it here instead */
+	for(;;)
+		wait_for_interrupt();
+}
 #else
 static inline void ipi_cpu_crash_stop(unsigned int cpu, struct pt_regs *regs)
 {
 	unreachable();
 }
+
+static inline void ipi_park(void)
+{
+	unreachable();
+}
 #endif
 
 static const struct riscv_ipi_ops *ipi_ops __ro_after_init;
@@ -187,6 +216,11 @@ void handle_IPI(struct pt_regs *regs)
 			ipi_cpu_crash_stop(cpu, get_irq_regs());
 		}
 
+		if (ops & (1 << IPI_CPU_PARK)) {
+			stats[IPI_CPU_PARK]++;
+			ipi_park();
+		}
+
 		if (ops & (1 << IPI_IRQ_WORK)) {
 			stats[IPI_IRQ_WORK]++;
 			irq_work_run();
@@ -210,6 +244,7 @@ static const char * const ipi_names[] = {
 	[IPI_CALL_FUNC]		= "Function call interrupts",
 	[IPI_CPU_STOP]		= "CPU stop interrupts",
 	[IPI_CPU_CRASH_STOP]	= "CPU stop (for crash dump) interrupts",
+	[IPI_CPU_PARK]		= "CPU park (for kexec) interrupts",
 	[IPI_IRQ_WORK]		= "IRQ work interrupts",
 	[IPI_TIMER]		= "Timer broadcast interrupts",
 };
@@ -325,6 +360,59 @@ bool smp_crash_stop_failed(void)
 {
 	return (atomic_read(&waiting_for_crash_ipi) > 0);
 }
+
+/*
+ * Park all other online harts for a kexec reboot by handing them back
+ * to the firmware all at once, instead of taking each of them through
+ * the hotplug state machine one at a time.  Returns false without
+ * touching any hart when a hart lacks an HSM-style stop method, so the
+ * caller can fall back to the regular hotplug path.
+ */
+bool kexec_park_secondary_harts(void)
+{
+#ifdef CONFIG_HOTPLUG_CPU
+	unsigned long timeout;
+	cpumask_t mask;
+	int cpu;
+
+	if (num_other_online_cpus() == 0)
+		return true;
+
+	cpumask_copy(&mask, cpu_online_mask);
+	cpumask_clear_cpu(smp_processor_id(), &mask);
+
+	for_each_cpu(cpu, &mask)
+		if (!cpu_has_hotplug(cpu) || !cpu_ops[cpu]->cpu_is_stopped)
+			return false;
+
+	pr_info("SMP: parking secondary harts in parallel\n");
+	send_ipi_mask(&mask, IPI_CPU_PARK);
+
+	/* Wait up to one second for the firmware to report them stopped */
+	timeout = USEC_PER_SEC;
+	while (timeout--) {
+		for_each_cpu(cpu, &mask)
+			if (!cpu_ops[cpu]->cpu_is_stopped(cpu))
+				cpumask_clear_cpu(cpu, &mask);
+
+		if (cpumask_empty(&mask))
+			return true;
+
+		udelay(1);
+	}
+
+	/*
+	 * The park IPIs are out, falling back to hotplug would only hang
+	 * on the harts that did stop.  Carry on like smp_send_stop()
+	 * does; a stale hart spins in wait_for_interrupt() and is no
+	 * worse off than after a failed serial shutdown.
+	 */
+	pr_warn("SMP: failed to park harts %*pbl\n", cpumask_pr_args(&mask));
+	return true;
+#else
+	return num_other_online_cpus() == 0;
+#endif
+}
 #endif
 
 void smp_send_reschedule(int cpu)
@@ -13,6 +13,7 @@
 #include <linux/ftrace.h>
 
 #include <asm/stacktrace.h>
+#include <asm/unwind_table.h>
 
 #ifdef CONFIG_FRAME_POINTER
 
@@ -65,6 +66,84 @@ void notrace walk_stackframe(struct task_struct *task, struct pt_regs *regs,
 	}
 }
 
+#elif defined(CONFIG_RISCV_UNWIND_TABLE)
+
+/*
+ * Unwind using the compact table built from .eh_frame at boot: look up
+ * the row covering pc, recompute the caller's stack pointer (the CFA)
+ * and reload ra and s0 from their save slots.  The walk ends at code
+ * the table does not cover (modules, asm without CFI annotations).
+ */
+void notrace walk_stackframe(struct task_struct *task, struct pt_regs *regs,
+			     bool (*fn)(void *, unsigned long), void *arg)
+{
+	unsigned long fp, sp, pc;
+	bool first = !!regs;
+	int level = 0;
+
+	if (regs) {
+		fp = frame_pointer(regs);
+		sp = user_stack_pointer(regs);
+		pc = instruction_pointer(regs);
+	} else if (task == NULL || task == current) {
+		fp = (unsigned long)__builtin_frame_address(0);
+		sp = current_stack_pointer;
+		pc = (unsigned long)walk_stackframe;
+		level = -1;
+	} else {
+		/* task blocked in __switch_to */
+		fp = task->thread.s[0];
+		sp = task->thread.sp;
+		pc = task->thread.ra;
+	}
+
+	for (;;) {
+		const struct riscv_unwind_entry *entry;
+		unsigned long cfa, high, *ra_slot;
+
+		if (unlikely(!__kernel_text_address(pc) ||
+			     (level++ >= 0 && !fn(arg, pc))))
+			break;
+
+		/*
+		 * A return address points just after its call; step back
+		 * into the calling instruction's row before looking up.
+		 */
+		entry = riscv_unwind_find(first ? pc : pc - 1);
+		if (!entry)
+			break;
+
+		cfa = ((entry->cfa_off & UNWIND_CFA_BASE_FP) ? fp : sp) +
+		      (entry->cfa_off & ~1UL);
+		high = ALIGN(sp, THREAD_SIZE);
+		if (unlikely(cfa < sp || cfa > high || cfa & 0x7))
+			break;
+
+		if (entry->ra_off == UNWIND_RA_IN_REG) {
+			/* Interrupted before ra was spilled */
+			if (!first || !regs)
+				break;
+			pc = regs->ra;
+		} else if (entry->ra_off == UNWIND_REG_UNSAVED) {
+			break;
+		} else {
+			ra_slot = (unsigned long *)cfa + entry->ra_off;
+			if (unlikely((unsigned long)ra_slot < sp))
+				break;
+			pc = ftrace_graph_ret_addr(current, NULL,
+					READ_ONCE_NOCHECK(*ra_slot), ra_slot);
+		}
+
+		if (entry->fp_off != UNWIND_REG_UNSAVED &&
+		    (unsigned long)((unsigned long *)cfa + entry->fp_off) >= sp)
+			fp = READ_ONCE_NOCHECK(*((unsigned long *)cfa +
+						 entry->fp_off));
+
+		sp = cfa;
+		first = false;
+	}
+}
+
 #else /* !CONFIG_FRAME_POINTER */
 
 void notrace walk_stackframe(struct task_struct *task,
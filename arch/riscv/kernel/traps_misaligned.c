@@ -8,9 +8,14 @@
 #include <linux/module.h>
 #include <linux/irq.h>
 #include <linux/stringify.h>
+#include <linux/proc_fs.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/uaccess.h>
 
 #include <asm/processor.h>
 #include <asm/ptrace.h>
+#include <asm/cpufeature.h>
 #include <asm/csr.h>
 
 #define INSN_MATCH_LB			0x3
@@ -151,53 +156,29 @@
 #define PRECISION_S 0
 #define PRECISION_D 1
 
-#define DECLARE_UNPRIVILEGED_LOAD_FUNCTION(type, insn)			\
-static inline type load_##type(const type *addr)			\
-{									\
-	type val;							\
-	asm (#insn " %0, %1"						\
-	: "=&r" (val) : "m" (*addr));					\
-	return val;							\
-}
-
-#define DECLARE_UNPRIVILEGED_STORE_FUNCTION(type, insn)			\
-static inline void store_##type(type *addr, type val)			\
-{									\
-	asm volatile (#insn " %0, %1\n"					\
-	: : "r" (val), "m" (*addr));					\
-}
+#ifdef CONFIG_RISCV_M_MODE
+/*
+ * M-mode has no page tables to worry about; plain loads and stores reach
+ * whatever the faulting access was aiming at.
+ */
+static inline int load_u8(struct pt_regs *regs, const u8 *addr, u8 *r_val)
+{
+	u8 val;
 
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u8, lbu)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u16, lhu)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(s8, lb)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(s16, lh)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(s32, lw)
-DECLARE_UNPRIVILEGED_STORE_FUNCTION(u8, sb)
-DECLARE_UNPRIVILEGED_STORE_FUNCTION(u16, sh)
-DECLARE_UNPRIVILEGED_STORE_FUNCTION(u32, sw)
-#if defined(CONFIG_64BIT)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u32, lwu)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u64, ld)
-DECLARE_UNPRIVILEGED_STORE_FUNCTION(u64, sd)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(ulong, ld)
-#else
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(u32, lw)
-DECLARE_UNPRIVILEGED_LOAD_FUNCTION(ulong, lw)
+	asm ("lbu %0, %1" : "=&r" (val) : "m" (*addr));
+	*r_val = val;
 
-static inline u64 load_u64(const u64 *addr)
-{
-	return load_u32((u32 *)addr)
-		+ ((u64)load_u32((u32 *)addr + 1) << 32);
+	return 0;
 }
 
-static inline void store_u64(u64 *addr, u64 val)
+static inline int store_u8(struct pt_regs *regs, u8 *addr, u8 val)
 {
-	store_u32((u32 *)addr, val);
-	store_u32((u32 *)addr + 1, val >> 32);
+	asm volatile ("sb %0, %1\n" : : "r" (val), "m" (*addr));
+
+	return 0;
 }
-#endif
 
-static inline ulong get_insn(ulong mepc)
+static inline int get_insn(struct pt_regs *regs, ulong mepc, ulong *r_insn)
 {
 	register ulong __mepc asm ("a2") = mepc;
 	ulong val, rvc_mask = 3, tmp;
@@ -226,8 +207,61 @@ static inline ulong get_insn(ulong mepc)
 	: [addr] "r" (__mepc), [rvc_mask] "r" (rvc_mask),
 	  [xlen_minus_16] "i" (XLEN_MINUS_16));
 
-	return val;
+	*r_insn = val;
+
+	return 0;
 }
+#else
+/*
+ * S-mode must go through uaccess for user addresses: SUM is clear on trap
+ * entry and the access may fault in its own right.  Kernel addresses can
+ * be dereferenced directly.
+ */
+static inline int load_u8(struct pt_regs *regs, const u8 *addr, u8 *r_val)
+{
+	if (user_mode(regs))
+		return __get_user(*r_val, (u8 __user *)addr);
+
+	*r_val = *addr;
+	return 0;
+}
+
+static inline int store_u8(struct pt_regs *regs, u8 *addr, u8 val)
+{
+	if (user_mode(regs))
+		return __put_user(val, (u8 __user *)addr);
+
+	*addr = val;
+	return 0;
+}
+
+static inline int get_insn(struct pt_regs *regs, ulong epc, ulong *r_insn)
+{
+	ulong insn = 0;
+
+	if (user_mode(regs)) {
+		u16 __user *insn_addr = (u16 __user *)epc;
+		u16 tmp;
+
+		if (__get_user(insn, insn_addr))
+			return -EFAULT;
+		if (INSN_LEN(insn) == 2) {
+			*r_insn = insn;
+			return 0;
+		}
+		if (__get_user(tmp, insn_addr + 1))
+			return -EFAULT;
+		*r_insn = ((ulong)tmp << 16) | insn;
+		return 0;
+	}
+
+	insn = *(u16 *)epc;
+	if (INSN_LEN(insn) == 4)
+		insn |= (ulong)*((u16 *)epc + 1) << 16;
+	*r_insn = insn;
+	return 0;
+}
+#endif
 
 union reg_data {
 	u8 data_bytes[8];
@@ -235,12 +269,20 @@ union reg_data {
 	u64 data_u64;
 };
 
-int handle_misaligned_load(struct pt_regs *regs)
+/*
+ * Emulating one access costs thousands of cycles in trap overhead alone,
+ * and misaligned accesses rarely come alone (think of a copy loop walking
+ * an odd buffer).  After emulating the faulting instruction, keep going
+ * and consume up to this many immediately following misaligned accesses
+ * in the same trap.
+ */
+#define MISALIGNED_BATCH_MAX		8
+
+static int misaligned_load_one(struct pt_regs *regs, unsigned long insn,
+			       unsigned long addr)
 {
 	union reg_data val;
 	unsigned long epc = regs->epc;
-	unsigned long insn = get_insn(epc);
-	unsigned long addr = csr_read(mtval);
 	int i, fp = 0, shift = 0, len = 0;
 
 	regs->epc = 0;
@@ -305,25 +347,32 @@ int handle_misaligned_load(struct pt_regs *regs)
 		return -1;
 	}
 
+	if (fp) {
+		regs->epc = epc;
+		return -1;
+	}
+
 	val.data_u64 = 0;
-	for (i = 0; i < len; i++)
-		val.data_bytes[i] = load_u8((void *)(addr + i));
+	for (i = 0; i < len; i++) {
+		if (load_u8(regs, (void *)(addr + i), &val.data_bytes[i])) {
+			regs->epc = epc;
+			return -1;
+		}
+	}
 
-	if (fp)
-		return -1;
 	SET_RD(insn, regs, val.data_ulong << shift >> shift);
 
 	regs->epc = epc + INSN_LEN(insn);
+	current->thread.misaligned_loads++;
 
 	return 0;
 }
 
-int handle_misaligned_store(struct pt_regs *regs)
+static int misaligned_store_one(struct pt_regs *regs, unsigned long insn,
+				unsigned long addr)
 {
 	union reg_data val;
 	unsigned long epc = regs->epc;
-	unsigned long insn = get_insn(epc);
-	unsigned long addr = csr_read(mtval);
 	int i, len = 0;
 
 	regs->epc = 0;
@@ -357,10 +406,168 @@ int handle_misaligned_store(struct pt_regs *regs)
 		return -1;
 	}
 
-	for (i = 0; i < len; i++)
-		store_u8((void *)(addr + i), val.data_bytes[i]);
+	for (i = 0; i < len; i++) {
+		if (store_u8(regs, (void *)(addr + i), val.data_bytes[i])) {
+			regs->epc = epc;
+			return -1;
+		}
+	}
 
 	regs->epc = epc + INSN_LEN(insn);
+	current->thread.misaligned_stores++;
+
+	return 0;
+}
+
+/*
+ * Decide whether @insn is a plain scalar load or store whose effective
+ * address is misaligned, computing that address from the current register
+ * file.  Used to extend the emulation of a faulting access to the
+ * instructions that follow it without taking a trap for each one.
+ */
+static bool insn_is_misaligned_access(unsigned long insn, struct pt_regs *regs,
+				      unsigned long *r_addr, bool *r_store)
+{
+	unsigned long addr;
+	bool store = false;
+	int len;
+
+	if ((insn & INSN_MASK_LH) == INSN_MATCH_LH ||
+	    (insn & INSN_MASK_LHU) == INSN_MATCH_LHU) {
+		len = 2;
+		addr = GET_RS1(insn, regs) + IMM_I(insn);
+	} else if ((insn & INSN_MASK_LW) == INSN_MATCH_LW
+#if defined(CONFIG_64BIT)
+		   || (insn & INSN_MASK_LWU) == INSN_MATCH_LWU
+#endif
+		  ) {
+		len = 4;
+		addr = GET_RS1(insn, regs) + IMM_I(insn);
+	} else if ((insn & INSN_MASK_SH) == INSN_MATCH_SH) {
+		len = 2;
+		addr = GET_RS1(insn, regs) + IMM_S(insn);
+		store = true;
+	} else if ((insn & INSN_MASK_SW) == INSN_MATCH_SW) {
+		len = 4;
+		addr = GET_RS1(insn, regs) + IMM_S(insn);
+		store = true;
+#if defined(CONFIG_64BIT)
+	} else if ((insn & INSN_MASK_LD) == INSN_MATCH_LD) {
+		len = 8;
+		addr = GET_RS1(insn, regs) + IMM_I(insn);
+	} else if ((insn & INSN_MASK_SD) == INSN_MATCH_SD) {
+		len = 8;
+		addr = GET_RS1(insn, regs) + IMM_S(insn);
+		store = true;
+	} else if ((insn & INSN_MASK_C_LD) == INSN_MATCH_C_LD) {
+		len = 8;
+		addr = GET_RS1S(insn, regs) + RVC_LD_IMM(insn);
+	} else if ((insn & INSN_MASK_C_LDSP) == INSN_MATCH_C_LDSP &&
+		   ((insn >> SH_RD) & 0x1f)) {
+		len = 8;
+		addr = GET_SP(regs) + RVC_LDSP_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SD) == INSN_MATCH_C_SD) {
+		len = 8;
+		addr = GET_RS1S(insn, regs) + RVC_LD_IMM(insn);
+		store = true;
+	} else if ((insn & INSN_MASK_C_SDSP) == INSN_MATCH_C_SDSP) {
+		len = 8;
+		addr = GET_SP(regs) + RVC_SDSP_IMM(insn);
+		store = true;
+#endif
+	} else if ((insn & INSN_MASK_C_LW) == INSN_MATCH_C_LW) {
+		len = 4;
+		addr = GET_RS1S(insn, regs) + RVC_LW_IMM(insn);
+	} else if ((insn & INSN_MASK_C_LWSP) == INSN_MATCH_C_LWSP &&
+		   ((insn >> SH_RD) & 0x1f)) {
+		len = 4;
+		addr = GET_SP(regs) + RVC_LWSP_IMM(insn);
+	} else if ((insn & INSN_MASK_C_SW) == INSN_MATCH_C_SW) {
+		/* C.SW encodes its immediate exactly like C.LW */
+		len = 4;
+		addr = GET_RS1S(insn, regs) + RVC_LW_IMM(insn);
+		store = true;
+	} else if ((insn & INSN_MASK_C_SWSP) == INSN_MATCH_C_SWSP) {
+		len = 4;
+		addr = GET_SP(regs) + RVC_SWSP_IMM(insn);
+		store = true;
+	} else {
+		return false;
+	}
+
+	if (!(addr & (len - 1)))
+		return false;
+
+	*r_addr = addr;
+	*r_store = store;
+	return true;
+}
+
+static void misaligned_batch(struct pt_regs *regs)
+{
+	unsigned long addr;
+	unsigned long insn;
+	bool store;
+	int n;
+
+	for (n = 1; n < MISALIGNED_BATCH_MAX; n++) {
+		if (get_insn(regs, regs->epc, &insn))
+			break;
+		if (!insn_is_misaligned_access(insn, regs, &addr, &store))
+			break;
+		if (store ? misaligned_store_one(regs, insn, addr)
+			  : misaligned_load_one(regs, insn, addr))
+			break;
+	}
+}
+
+int handle_misaligned_load(struct pt_regs *regs)
+{
+	unsigned long insn;
+
+	*this_cpu_ptr(&misaligned_access_speed) = RISCV_MISALIGNED_EMULATED;
+
+	if (get_insn(regs, regs->epc, &insn))
+		return -1;
+
+	if (misaligned_load_one(regs, insn, regs->badaddr))
+		return -1;
+
+	misaligned_batch(regs);
+
+	return 0;
+}
+
+int handle_misaligned_store(struct pt_regs *regs)
+{
+	unsigned long insn;
+
+	*this_cpu_ptr(&misaligned_access_speed) = RISCV_MISALIGNED_EMULATED;
+
+	if (get_insn(regs, regs->epc, &insn))
+		return -1;
+
+	if (misaligned_store_one(regs, insn, regs->badaddr))
+		return -1;
+
+	misaligned_batch(regs);
 
 	return 0;
 }
+
+#ifdef CONFIG_PROC_PID_ARCH_STATUS
+/*
+ * Every emulated access above costs a full trap round-trip; surface the
+ * per-task totals in /proc/<pid>/status so the offending code can be
+ * found and fixed rather than silently limping along.
+ */
+int proc_pid_arch_status(struct seq_file *m, struct pid_namespace *ns,
+			 struct pid *pid, struct task_struct *task)
+{
+	seq_printf(m, "RiscvMisalignedLoads:\t%lu\n",
+		   task->thread.misaligned_loads);
+	seq_printf(m, "RiscvMisalignedStores:\t%lu\n",
+		   task->thread.misaligned_stores);
+	return 0;
+}
+#endif
@@ -0,0 +1,750 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Boot-time construction of a compact unwind table from .eh_frame.
+ *
+ * When the kernel is built without frame pointers the compiler still
+ * knows how to unwind every function; it just records that knowledge as
+ * DWARF CFI instead of maintaining s0 at run time.  This file walks the
+ * .eh_frame section once during boot, executes the CFI programs, and
+ * flattens the result into an array of riscv_unwind_entry rows sorted
+ * by pc.  Lookups afterwards are a binary search over read-only data,
+ * which is cheap enough for perf sampling and safe in NMI-like context.
+ * The .eh_frame input lives in init data and is freed once the table
+ * has been built.
+ *
+ * Only the rules for the registers the unwinder needs are tracked: the
+ * CFA, the return address (ra) and the frame pointer (s0).  Functions
+ * with CFA rules we cannot represent (expressions, exotic base
+ * registers) simply get no usable rows and the unwinder stops there.
+ *
+ * Copyright (C) 2023 Regents of the University of California
+ */
+
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/sort.h>
+#include <linux/vmalloc.h>
+
+#include <asm/sections.h>
+#include <asm/unwind_table.h>
+
+extern char __eh_frame_start[], __eh_frame_end[];
+
+/* DWARF register numbers for the registers we track */
+#define DW_REG_RA		1
+#define DW_REG_SP		2
+#define DW_REG_FP		8
+
+/* DWARF call frame instructions (high two bits, or full byte when 0) */
+#define DW_CFA_advance_loc	0x40
+#define DW_CFA_offset		0x80
+#define DW_CFA_restore		0xc0
+#define DW_CFA_nop		0x00
+#define DW_CFA_set_loc		0x01
+#define DW_CFA_advance_loc1	0x02
+#define DW_CFA_advance_loc2	0x03
+#define DW_CFA_advance_loc4	0x04
+#define DW_CFA_offset_extended	0x05
+#define DW_CFA_restore_extended	0x06
+#define DW_CFA_undefined	0x07
+#define DW_CFA_same_value	0x08
+#define DW_CFA_register		0x09
+#define DW_CFA_remember_state	0x0a
+#define DW_CFA_restore_state	0x0b
+#define DW_CFA_def_cfa		0x0c
+#define DW_CFA_def_cfa_register	0x0d
+#define DW_CFA_def_cfa_offset	0x0e
+#define DW_CFA_def_cfa_expression 0x0f
+#define DW_CFA_expression	0x10
+#define DW_CFA_offset_extended_sf 0x11
+#define DW_CFA_def_cfa_sf	0x12
+#define DW_CFA_def_cfa_offset_sf 0x13
+#define DW_CFA_val_offset	0x14
+#define DW_CFA_val_offset_sf	0x15
+#define DW_CFA_val_expression	0x16
+#define DW_CFA_GNU_args_size	0x2e
+
+/* Pointer encodings used in .eh_frame */
+#define DW_EH_PE_absptr		0x00
+#define DW_EH_PE_udata4		0x03
+#define DW_EH_PE_udata8		0x04
+#define DW_EH_PE_sdata4		0x0b
+#define DW_EH_PE_sdata8		0x0c
+#define DW_EH_PE_pcrel		0x10
+#define DW_EH_PE_type_mask	0x0f
+#define DW_EH_PE_rel_mask	0x70
+#define DW_EH_PE_indirect	0x80
+#define DW_EH_PE_omit		0xff
+
+/* How a tracked register is recovered */
+enum cfi_rule {
+	RULE_UNSAVED,		/* default: ra in its register, s0 untouched */
+	RULE_OFFSET,		/* saved at CFA + offset */
+	RULE_UNDEF,		/* explicitly unrecoverable */
+};
+
+struct cfi_regs {
+	int		cfa_reg;
+	long		cfa_off;
+	bool		cfa_valid;	/* false for expression/exotic CFAs */
+	enum cfi_rule	ra_rule;
+	long		ra_off;
+	enum cfi_rule	fp_rule;
+	long		fp_off;
+};
+
+#define CFI_STATE_STACK_DEPTH	8
+
+struct cie_info {
+	unsigned long	code_align;
+	long		data_align;
+	u8		ptr_enc;
+	bool		has_aug;	/* 'z': FDEs carry augmentation data */
+	const u8	*insn_start;
+	const u8	*insn_end;
+};
+
+static struct riscv_unwind_entry *unwind_table __ro_after_init;
+static unsigned int unwind_table_len __ro_after_init;
+
+static const u8 *uleb128(const u8 *p, const u8 *end, unsigned long *val)
+{
+	unsigned long result = 0;
+	int shift = 0;
+	u8 byte;
+
+	do {
+		if (p >= end)
+			return NULL;
+		byte = *p++;
+		result |= (unsigned long)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	*val = result;
+	return p;
+}
+
+static const u8 *sleb128(const u8 *p, const u8 *end, long *val)
+{
+	long result = 0;
+	int shift = 0;
+	u8 byte;
+
+	do {
+		if (p >= end)
+			return NULL;
+		byte = *p++;
+		result |= (long)(byte & 0x7f) << shift;
+		shift += 7;
+	} while (byte & 0x80);
+
+	if (shift < BITS_PER_LONG && (byte & 0x40))
+		result |= -1UL << shift;
+
+	*val = result;
+	return p;
+}
+
+/* Read a pointer with the CIE's encoding; only the forms GCC emits. */
+static const u8 *read_encoded(const u8 *p, const u8 *end, u8 enc,
+			      unsigned long *val)
+{
+	unsigned long base = (unsigned long)p;
+	long v;
+
+	if (enc == DW_EH_PE_omit || (enc & DW_EH_PE_indirect))
+		return NULL;
+
+	switch (enc & DW_EH_PE_type_mask) {
+	case DW_EH_PE_absptr:
+		if (p + sizeof(long) > end)
+			return NULL;
+		v = *(const long *)p;
+		p += sizeof(long);
+		break;
+	case DW_EH_PE_udata4:
+		if (p + 4 > end)
+			return NULL;
+		v = *(const u32 *)p;
+		p += 4;
+		break;
+	case DW_EH_PE_sdata4:
+		if (p + 4 > end)
+			return NULL;
+		v = *(const s32 *)p;
+		p += 4;
+		break;
+	case DW_EH_PE_udata8:
+	case DW_EH_PE_sdata8:
+		if (p + 8 > end)
+			return NULL;
+		v = *(const s64 *)p;
+		p += 8;
+		break;
+	default:
+		return NULL;
+	}
+
+	if ((enc & DW_EH_PE_rel_mask) == DW_EH_PE_pcrel)
+		v += base;
+	else if (enc & DW_EH_PE_rel_mask)
+		return NULL;
+
+	*val = v;
+	return p;
+}
+
+static int parse_cie(const u8 *p, const u8 *end, struct cie_info *cie)
+{
+	unsigned long len, tmp;
+	const u8 *aug, *entry_end;
+	u8 version;
+
+	if (p + 4 > end)
+		return -EINVAL;
+	len = *(const u32 *)p;
+	p += 4;
+	if (len == 0 || len == 0xffffffff || p + len > end)
+		return -EINVAL;
+	entry_end = p + len;
+
+	/* CIE id */
+	if (*(const u32 *)p != 0)
+		return -EINVAL;
+	p += 4;
+
+	version = *p++;
+	if (version != 1 && version != 3)
+		return -EINVAL;
+
+	aug = p;
+	while (p < entry_end && *p)
+		p++;
+	if (p >= entry_end)
+		return -EINVAL;
+	p++;
+
+	p = uleb128(p, entry_end, &cie->code_align);
+	if (!p)
+		return -EINVAL;
+	p = sleb128(p, entry_end, &cie->data_align);
+	if (!p)
+		return -EINVAL;
+
+	/* return address register */
+	if (version == 1) {
+		tmp = *p++;
+	} else {
+		p = uleb128(p, entry_end, &tmp);
+		if (!p)
+			return -EINVAL;
+	}
+	if (tmp != DW_REG_RA)
+		return -EINVAL;
+
+	cie->ptr_enc = DW_EH_PE_absptr;
+	cie->has_aug = (*aug == 'z');
+	if (*aug == 'z') {
+		const u8 *aug_end;
+
+		p = uleb128(p, entry_end, &tmp);
+		if (!p || p + tmp > entry_end)
+			return -EINVAL;
+		aug_end = p + tmp;
+
+		for (aug++; *aug; aug++) {
+			switch (*aug) {
+			case 'R':
+				cie->ptr_enc = *p++;
+				break;
+			case 'P':
+				/* personality routine: skip */
+				p = read_encoded(p + 1, aug_end, *p, &tmp);
+				if (!p)
+					return -EINVAL;
+				break;
+			case 'L':
+				p++;	/* LSDA encoding byte */
+				break;
+			case 'S':	/* signal frame, irrelevant here */
+				break;
+			default:
+				return -EINVAL;
+			}
+		}
+		p = aug_end;
+	} else if (*aug) {
+		return -EINVAL;
+	}
+
+	cie->insn_start = p;
+	cie->insn_end = entry_end;
+	return 0;
+}
+
+/* Apply a "register saved at factored offset" rule */
+static void rule_offset(struct cfi_regs *rs, unsigned long reg, long off)
+{
+	if (reg == DW_REG_RA) {
+		rs->ra_rule = RULE_OFFSET;
+		rs->ra_off = off;
+	} else if (reg == DW_REG_FP) {
+		rs->fp_rule = RULE_OFFSET;
+		rs->fp_off = off;
+	}
+}
+
+static void rule_default(struct cfi_regs *rs, unsigned long reg,
+			 const struct cfi_regs *init)
+{
+	if (reg == DW_REG_RA) {
+		rs->ra_rule = init ? init->ra_rule : RULE_UNSAVED;
+		rs->ra_off = init ? init->ra_off : 0;
+	} else if (reg == DW_REG_FP) {
+		rs->fp_rule = init ? init->fp_rule : RULE_UNSAVED;
+		rs->fp_off = init ? init->fp_off : 0;
+	}
+}
+
+static void rule_undef(struct cfi_regs *rs, unsigned long reg)
+{
+	if (reg == DW_REG_RA)
+		rs->ra_rule = RULE_UNDEF;
+	else if (reg == DW_REG_FP)
+		rs->fp_rule = RULE_UNDEF;
+}
+
+/*
+ * Flatten the current CFI state into a table row at @loc.  Rows that
+ * cannot be represented are emitted as dead ends (UNWIND_ROW_END) so
+ * the unwinder stops instead of wandering off.
+ */
+static void emit_row(struct riscv_unwind_entry *row, unsigned long loc,
+		     const struct cfi_regs *rs)
+{
+	long slot;
+
+	row->pc = loc - (unsigned long)_stext;
+	row->cfa_off = 0;
+	row->ra_off = UNWIND_ROW_END;
+	row->fp_off = UNWIND_REG_UNSAVED;
+
+	if (!rs->cfa_valid)
+		return;
+	if (rs->cfa_reg != DW_REG_SP && rs->cfa_reg != DW_REG_FP)
+		return;
+	if (rs->cfa_off < 0 || rs->cfa_off > S16_MAX || (rs->cfa_off & 1))
+		return;
+
+	row->cfa_off = rs->cfa_off;
+	if (rs->cfa_reg == DW_REG_FP)
+		row->cfa_off |= UNWIND_CFA_BASE_FP;
+
+	switch (rs->ra_rule) {
+	case RULE_UNSAVED:
+		row->ra_off = UNWIND_RA_IN_REG;
+		break;
+	case RULE_UNDEF:
+		row->ra_off = UNWIND_REG_UNSAVED;
+		break;
+	case RULE_OFFSET:
+		slot = rs->ra_off / (long)sizeof(long);
+		if (slot * (long)sizeof(long) != rs->ra_off ||
+		    slot < S8_MIN || slot >= UNWIND_ROW_END) {
+			row->cfa_off = 0;
+			row->ra_off = UNWIND_ROW_END;
+			return;
+		}
+		row->ra_off = slot;
+		break;
+	}
+
+	if (rs->fp_rule == RULE_OFFSET) {
+		slot = rs->fp_off / (long)sizeof(long);
+		if (slot * (long)sizeof(long) == rs->fp_off &&
+		    slot >= S8_MIN && slot < UNWIND_ROW_END)
+			row->fp_off = slot;
+	}
+}
+
+struct emit_ctx {
+	struct riscv_unwind_entry	*rows;
+	unsigned int			nr;
+	unsigned int			max;
+};
+
+static void emit(struct emit_ctx *ctx, unsigned long loc,
+		 const struct cfi_regs *rs)
+{
+	struct riscv_unwind_entry row;
+
+	emit_row(&row, loc, rs);
+
+	/* Coalesce ranges whose flattened state is identical */
+	if (ctx->nr && !memcmp(&ctx->rows[ctx->nr - 1].cfa_off, &row.cfa_off,
+			       sizeof(row) - sizeof(row.pc)))
+		return;
+	if (WARN_ON_ONCE(ctx->nr >= ctx->max))
+		return;
+	ctx->rows[ctx->nr++] = row;
+}
+
+/*
+ * Execute one CFI program.  With @ctx == NULL this is the sizing pass
+ * and only counts the rows an FDE can produce.  Returns the number of
+ * potential rows, or a negative error if the program is malformed.
+ */
+static int run_cfi(const u8 *p, const u8 *end, const struct cie_info *cie,
+		   const struct cfi_regs *init, struct cfi_regs *rs,
+		   unsigned long loc, struct emit_ctx *ctx)
+{
+	struct cfi_regs stack[CFI_STATE_STACK_DEPTH];
+	unsigned long val, reg;
+	int depth = 0, rows = 1;
+	long sval;
+	u8 op;
+
+	while (p < end) {
+		op = *p++;
+
+		/* Location advances end the current row's range */
+		if ((op & 0xc0) == DW_CFA_advance_loc || op == DW_CFA_set_loc ||
+		    (op >= DW_CFA_advance_loc1 && op <= DW_CFA_advance_loc4)) {
+			if (ctx)
+				emit(ctx, loc, rs);
+			rows++;
+		}
+
+		switch (op & 0xc0) {
+		case DW_CFA_advance_loc:
+			loc += (op & 0x3f) * cie->code_align;
+			continue;
+		case DW_CFA_offset:
+			p = uleb128(p, end, &val);
+			if (!p)
+				return -EINVAL;
+			rule_offset(rs, op & 0x3f, val * cie->data_align);
+			continue;
+		case DW_CFA_restore:
+			rule_default(rs, op & 0x3f, init);
+			continue;
+		}
+
+		switch (op) {
+		case DW_CFA_nop:
+			break;
+		case DW_CFA_set_loc:
+			p = read_encoded(p, end, cie->ptr_enc, &loc);
+			if (!p)
+				return -EINVAL;
+			break;
+		case DW_CFA_advance_loc1:
+			if (p >= end)
+				return -EINVAL;
+			loc += *p++ * cie->code_align;
+			break;
+		case DW_CFA_advance_loc2:
+			if (p + 2 > end)
+				return -EINVAL;
+			loc += *(const u16 *)p * cie->code_align;
+			p += 2;
+			break;
+		case DW_CFA_advance_loc4:
+			if (p + 4 > end)
+				return -EINVAL;
+			loc += *(const u32 *)p * cie->code_align;
+			p += 4;
+			break;
+		case DW_CFA_offset_extended:
+			p = uleb128(p, end, &reg);
+			p = p ? uleb128(p, end, &val) : NULL;
+			if (!p)
+				return -EINVAL;
+			rule_offset(rs, reg, val * cie->data_align);
+			break;
+		case DW_CFA_offset_extended_sf:
+			p = uleb128(p, end, &reg);
+			p = p ? sleb128(p, end, &sval) : NULL;
+			if (!p)
+				return -EINVAL;
+			rule_offset(rs, reg, sval * cie->data_align);
+			break;
+		case DW_CFA_restore_extended:
+			p = uleb128(p, end, &reg);
+			if (!p)
+				return -EINVAL;
+			rule_default(rs, reg, init);
+			break;
+		case DW_CFA_undefined:
+		case DW_CFA_same_value:
+			p = uleb128(p, end, &reg);
+			if (!p)
+				return -EINVAL;
+			if (op == DW_CFA_undefined)
+				rule_undef(rs, reg);
+			else
+				rule_default(rs, reg, NULL);
+			break;
+		case DW_CFA_register:
+			p = uleb128(p, end, &reg);
+			p = p ? uleb128(p, end, &val) : NULL;
+			if (!p)
+				return -EINVAL;
+			/* tracked register living in another register: give up */
+			rule_undef(rs, reg);
+			break;
+		case DW_CFA_remember_state:
+			if (depth >= CFI_STATE_STACK_DEPTH)
+				return -EINVAL;
+			stack[depth++] = *rs;
+			break;
+		case DW_CFA_restore_state:
+			if (!depth)
+				return -EINVAL;
+			*rs = stack[--depth];
+			break;
+		case DW_CFA_def_cfa:
+			p = uleb128(p, end, &reg);
+			p = p ? uleb128(p, end, &val) : NULL;
+			if (!p)
+				return -EINVAL;
+			rs->cfa_reg = reg;
+			rs->cfa_off = val;
+			rs->cfa_valid = true;
+			break;
+		case DW_CFA_def_cfa_sf:
+			p = uleb128(p, end, &reg);
+			p = p ? sleb128(p, end, &sval) : NULL;
+			if (!p)
+				return -EINVAL;
+			rs->cfa_reg = reg;
+			rs->cfa_off = sval * cie->data_align;
+			rs->cfa_valid = true;
+			break;
+		case DW_CFA_def_cfa_register:
+			p = uleb128(p, end, &reg);
+			if (!p)
+				return -EINVAL;
+			rs->cfa_reg = reg;
+			break;
+		case DW_CFA_def_cfa_offset:
+			p = uleb128(p, end, &val);
+			if (!p)
+				return -EINVAL;
+			rs->cfa_off = val;
+			break;
+		case DW_CFA_def_cfa_offset_sf:
+			p = sleb128(p, end, &sval);
+			if (!p)
+				return -EINVAL;
+			rs->cfa_off = sval * cie->data_align;
+			break;
+		case DW_CFA_def_cfa_expression:
+			p = uleb128(p, end, &val);
+			if (!p || p + val > end)
+				return -EINVAL;
+			p += val;
+			rs->cfa_valid = false;
+			break;
+		case DW_CFA_expression:
+		case DW_CFA_val_expression:
+			p = uleb128(p, end, &reg);
+			p = p ? uleb128(p, end, &val) : NULL;
+			if (!p || p + val > end)
+				return -EINVAL;
+			p += val;
+			rule_undef(rs, reg);
+			break;
+		case DW_CFA_val_offset:
+		case DW_CFA_val_offset_sf:
+			if (op == DW_CFA_val_offset) {
+				p = uleb128(p, end, &reg);
+				p = p ? uleb128(p, end, &val) : NULL;
+			} else {
+				p = uleb128(p, end, &reg);
+				p = p ? sleb128(p, end, &sval) : NULL;
+			}
+			if (!p)
+				return -EINVAL;
+			/* value rules are not representable */
+			rule_undef(rs, reg);
+			break;
+		case DW_CFA_GNU_args_size:
+			p = uleb128(p, end, &val);
+			if (!p)
+				return -EINVAL;
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (ctx)
+		emit(ctx, loc, rs);
+	return rows;
+}
+
+/*
+ * Walk every entry in .eh_frame once.  With @ctx == NULL, return an
+ * upper bound on the number of rows; otherwise fill in the rows.
+ */
+static int walk_eh_frame(struct emit_ctx *ctx)
+{
+	const u8 *p = (const u8 *)__eh_frame_start;
+	const u8 *frame_end = (const u8 *)__eh_frame_end;
+	int total = 0;
+
+	while (p + 4 <= frame_end) {
+		unsigned long len = *(const u32 *)p;
+		const u8 *entry = p + 4;
+		const u8 *entry_end = entry + len;
+		const u8 *cie_p;
+		unsigned long pc_begin, pc_range, aug_len;
+		struct cie_info cie;
+		struct cfi_regs init, rs;
+		u32 cie_off;
+		int rows;
+
+		if (len == 0)
+			break;
+		if (len == 0xffffffff || entry_end > frame_end)
+			return -EINVAL;
+
+		cie_off = *(const u32 *)entry;
+		if (cie_off == 0) {
+			/* CIE: validated when referenced by its FDEs */
+			p = entry_end;
+			continue;
+		}
+
+		cie_p = entry - cie_off;
+		if (cie_p < (const u8 *)__eh_frame_start ||
+		    parse_cie(cie_p, frame_end, &cie))
+			return -EINVAL;
+
+		p = entry + 4;
+		p = read_encoded(p, entry_end, cie.ptr_enc, &pc_begin);
+		if (!p)
+			return -EINVAL;
+		p = read_encoded(p, entry_end,
+				 cie.ptr_enc & DW_EH_PE_type_mask, &pc_range);
+		if (!p)
+			return -EINVAL;
+		if (cie.has_aug) {
+			p = uleb128(p, entry_end, &aug_len);
+			if (!p || p + aug_len > entry_end)
+				return -EINVAL;
+			p += aug_len;
+		}
+
+		/* Initial state: run the CIE's instructions */
+		memset(&rs, 0, sizeof(rs));
+		rs.cfa_reg = DW_REG_SP;
+		rows = run_cfi(cie.insn_start, cie.insn_end, &cie, NULL, &rs,
+			       pc_begin, NULL);
+		if (rows < 0)
+			return rows;
+		init = rs;
+
+		rows = run_cfi(p, entry_end, &cie, &init, &rs, pc_begin, ctx);
+		if (rows < 0)
+			return rows;
+		total += rows + 1;
+
+		if (ctx && !WARN_ON_ONCE(ctx->nr >= ctx->max)) {
+			/* Dead-end row covering the gap after this FDE */
+			struct cfi_regs gap = { .cfa_valid = false };
+
+			emit_row(&ctx->rows[ctx->nr], pc_begin + pc_range,
+				 &gap);
+			ctx->nr++;
+		}
+
+		p = entry_end;
+	}
+
+	return total;
+}
+
+static int cmp_unwind_entry(const void *a, const void *b)
+{
+	const struct riscv_unwind_entry *ea = a, *eb = b;
+
+	if (ea->pc != eb->pc)
+		return ea->pc < eb->pc ? -1 : 1;
+	/*
+	 * A function entry shares its pc with the dead-end row closing
+	 * the preceding FDE.  Sort the dead-end row first so the real
+	 * row wins the last-match binary search in riscv_unwind_find().
+	 */
+	return (eb->ra_off == UNWIND_ROW_END) - (ea->ra_off == UNWIND_ROW_END);
+}
+
+/*
+ * Look up the row covering @pc.  Safe from any context once the table
+ * has been published; returns NULL for addresses we cannot unwind
+ * (modules, asm without CFI, pre-table boot code).
+ */
+const struct riscv_unwind_entry *notrace riscv_unwind_find(unsigned long pc)
+{
+	const struct riscv_unwind_entry *table = READ_ONCE(unwind_table);
+	unsigned long off = pc - (unsigned long)_stext;
+	unsigned int lo = 0, hi = unwind_table_len;
+
+	if (!table || !hi || off >= U32_MAX)
+		return NULL;
+	if (off < table[0].pc)
+		return NULL;
+
+	while (hi - lo > 1) {
+		unsigned int mid = (lo + hi) / 2;
+
+		if (table[mid].pc <= off)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	if (table[lo].ra_off == UNWIND_ROW_END)
+		return NULL;
+	return &table[lo];
+}
+
+static int __init riscv_unwind_init(void)
+{
+	struct emit_ctx ctx;
+	int rows;
+
+	rows = walk_eh_frame(NULL);
+	if (rows < 0) {
+		pr_warn("unwind: malformed .eh_frame, table disabled\n");
+		return 0;
+	}
+	if (!rows)
+		return 0;
+
+	ctx.rows = vmalloc(array_size(rows, sizeof(*ctx.rows)));
+	if (!ctx.rows)
+		return -ENOMEM;
+	ctx.nr = 0;
+	ctx.max = rows;
+
+	rows = walk_eh_frame(&ctx);
+	if (rows < 0) {
+		vfree(ctx.rows);
+		pr_warn("unwind: malformed .eh_frame, table disabled\n");
+		return 0;
+	}
+
+	sort(ctx.rows, ctx.nr, sizeof(*ctx.rows), cmp_unwind_entry, NULL);
+
+	unwind_table_len = ctx.nr;
+	/* Publish only once the rows are fully written and sorted */
+	smp_store_release(&unwind_table, ctx.rows);
+
+	pr_info("unwind: %u table rows (%zu bytes) from .eh_frame\n",
+		ctx.nr, ctx.nr * sizeof(*ctx.rows));
+	return 0;
+}
+arch_initcall(riscv_unwind_init);
@@ -10,9 +10,13 @@
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/binfmts.h>
+#include <linux/cacheinfo.h>
 #include <linux/err.h>
+#include <linux/topology.h>
 #include <asm/page.h>
+#include <asm/smp.h>
 #include <asm/vdso.h>
+#include <uapi/asm/vdso.h>
 #include <linux/time_namespace.h>
 
 #ifdef CONFIG_GENERIC_TIME_VSYSCALL
@@ -30,6 +34,7 @@ extern char compat_vdso_start[], compat_vdso_end[];
 enum vvar_pages {
 	VVAR_DATA_PAGE_OFFSET,
 	VVAR_TIMENS_PAGE_OFFSET,
+	VVAR_CPU_PAGE_OFFSET,
 	VVAR_NR_PAGES,
 };
 
@@ -49,6 +54,16 @@ static union {
 } vdso_data_store __page_aligned_data;
 struct vdso_data *vdso_data = &vdso_data_store.data;
 
+/*
+ * The vDSO per-cpu data page, exposing each cpu's hartid, NUMA node and
+ * cache geometry to userspace.  Read through __vdso_riscv_cpu_data().
+ */
+static union {
+	struct riscv_vdso_cpu_data	data[NR_CPUS];
+	u8				page[PAGE_SIZE];
+} vdso_cpu_data_store __page_aligned_data;
+struct riscv_vdso_cpu_data *vdso_cpu_data = vdso_cpu_data_store.data;
+
 struct __vdso_info {
 	const char *name;
 	const char *vdso_code_start;
@@ -188,6 +203,9 @@ static vm_fault_t vvar_fault(const struct vm_special_mapping *sm,
 		pfn = sym_to_pfn(vdso_data);
 		break;
 #endif /* CONFIG_TIME_NS */
+	case VVAR_CPU_PAGE_OFFSET:
+		pfn = sym_to_pfn(vdso_cpu_data);
+		break;
 	default:
 		return VM_FAULT_SIGBUS;
 	}
@@ -246,6 +264,51 @@ static int __init vdso_init(void)
 }
 arch_initcall(vdso_init);
 
+static void vdso_cpu_data_fill(unsigned int cpu)
+{
+	struct riscv_vdso_cpu_data *cd = &vdso_cpu_data[cpu];
+	struct cpu_cacheinfo *this_cpu_ci = get_cpu_cacheinfo(cpu);
+	struct cacheinfo *leaf;
+	unsigned int i;
+
+	cd->hartid = cpuid_to_hartid_map(cpu);
+	cd->node = cpu_to_node(cpu);
+
+	for (i = 0; i < this_cpu_ci->num_leaves; i++) {
+		leaf = this_cpu_ci->info_list + i;
+
+		if (leaf->level == 1 && leaf->type == CACHE_TYPE_DATA) {
+			cd->l1d_size = leaf->size;
+			cd->l1d_line_size = leaf->coherency_line_size;
+		} else if (leaf->type == CACHE_TYPE_UNIFIED &&
+			   leaf->level > cd->llc_level) {
+			cd->llc_level = leaf->level;
+			cd->llc_size = leaf->size;
+			cd->llc_line_size = leaf->coherency_line_size;
+		}
+	}
+}
+
+/*
+ * Runs after the cacheinfo leaves have been detected for the cpus that
+ * came up during boot.  The geometry of a hart never changes, so records
+ * are not refreshed on hotplug.
+ */
+static int __init vdso_cpu_data_init(void)
+{
+	unsigned int cpu;
+
+	/* __vdso_riscv_cpu_data() indexes the page with a fixed stride */
+	BUILD_BUG_ON(sizeof(struct riscv_vdso_cpu_data) != 32);
+	BUILD_BUG_ON(sizeof(struct riscv_vdso_cpu_data) * NR_CPUS > PAGE_SIZE);
+
+	for_each_online_cpu(cpu)
+		vdso_cpu_data_fill(cpu);
+
+	return 0;
+}
+late_initcall(vdso_cpu_data_init);
+
 static int __setup_additional_pages(struct mm_struct *mm,
 				    struct linux_binprm *bprm,
 				    int uses_interp,
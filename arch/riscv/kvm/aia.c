@@ -0,0 +1,80 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Copyright (C) 2023 Ventana Micro Systems Inc.
+ */
+
+#include <linux/kernel.h>
+#include <linux/kvm_host.h>
+#include <asm/hwcap.h>
+
+/*
+ * Skeleton for AIA support.  With the Ssaia extension present, device
+ * interrupts can eventually be delivered straight into IMSIC guest
+ * interrupt files instead of being injected through HVIP emulation,
+ * which costs a VM-exit per interrupt.  For now this only detects the
+ * extension and reserves the enable/disable hooks; guest interrupt file
+ * allocation, MSI routing and the in-kernel irqchip build on top of it.
+ */
+
+DEFINE_STATIC_KEY_FALSE(kvm_riscv_aia_available);
+
+int kvm_riscv_vcpu_aia_init(struct kvm_vcpu *vcpu)
+{
+	if (!kvm_riscv_aia_available())
+		return 0;
+
+	return 0;
+}
+
+void kvm_riscv_vcpu_aia_deinit(struct kvm_vcpu *vcpu)
+{
+}
+
+void kvm_riscv_vcpu_aia_reset(struct kvm_vcpu *vcpu)
+{
+}
+
+int kvm_riscv_aia_init_vm(struct kvm *kvm)
+{
+	if (!kvm_riscv_aia_available())
+		return 0;
+
+	/*
+	 * We don't have in-kernel irqchip so we ignore in-kernel
+	 * irqchip flags for the VM until the IMSIC/APLIC emulation
+	 * is in place.
+	 */
+
+	return 0;
+}
+
+void kvm_riscv_aia_destroy_vm(struct kvm *kvm)
+{
+}
+
+void kvm_riscv_aia_enable(void)
+{
+	if (!kvm_riscv_aia_available())
+		return;
+}
+
+void kvm_riscv_aia_disable(void)
+{
+	if (!kvm_riscv_aia_available())
+		return;
+}
+
+int kvm_riscv_aia_init(void)
+{
+	if (!riscv_isa_extension_available(NULL, SSAIA))
+		return -ENODEV;
+
+	/* Enable KVM AIA support */
+	static_branch_enable(&kvm_riscv_aia_available);
+
+	return 0;
+}
+
+void kvm_riscv_aia_exit(void)
+{
+}
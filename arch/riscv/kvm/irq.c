@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * In-kernel interrupt routing for irqfd.
+ *
+ * There is no full in-kernel interrupt-controller model on riscv yet
+ * (the AIA support is only a skeleton), so MSI routes use a direct
+ * encoding: the MSI data word selects the target VCPU and the
+ * interrupt is injected as the VS-level external interrupt through
+ * HVIP. This lets vhost deliver an edge-triggered completion interrupt
+ * from the eventfd wakeup with a single atomic op and a kick, without
+ * a workqueue trip or an exit to userspace.
+ */
+
+#include <linux/errno.h>
+#include <linux/kvm_host.h>
+#include <asm/csr.h>
+
+static int kvm_riscv_msi_inject(struct kvm *kvm,
+				struct kvm_kernel_irq_routing_entry *e)
+{
+	struct kvm_vcpu *vcpu;
+
+	vcpu = kvm_get_vcpu_by_id(kvm, e->msi.data);
+	if (!vcpu)
+		return -EINVAL;
+
+	return kvm_riscv_vcpu_set_interrupt(vcpu, IRQ_VS_EXT);
+}
+
+int kvm_set_msi(struct kvm_kernel_irq_routing_entry *e,
+		struct kvm *kvm, int irq_source_id,
+		int level, bool line_status)
+{
+	/* MSIs are edge-triggered, nothing to do on level drop */
+	if (!level)
+		return -1;
+
+	return kvm_riscv_msi_inject(kvm, e);
+}
+
+/*
+ * The injection above is just an atomic bit set plus a kick, so it is
+ * safe from the eventfd wakeup path and the irqfd fast path can use it
+ * directly instead of deferring to the injection worker.
+ */
+int kvm_arch_set_irq_inatomic(struct kvm_kernel_irq_routing_entry *e,
+			      struct kvm *kvm, int irq_source_id,
+			      int level, bool line_status)
+{
+	if (e->type != KVM_IRQ_ROUTING_MSI)
+		return -EWOULDBLOCK;
+
+	return kvm_set_msi(e, kvm, irq_source_id, level, line_status);
+}
+
+int kvm_set_routing_entry(struct kvm *kvm,
+			  struct kvm_kernel_irq_routing_entry *e,
+			  const struct kvm_irq_routing_entry *ue)
+{
+	switch (ue->type) {
+	case KVM_IRQ_ROUTING_MSI:
+		if (ue->flags)
+			return -EINVAL;
+		e->set = kvm_set_msi;
+		e->msi.address_lo = ue->u.msi.address_lo;
+		e->msi.address_hi = ue->u.msi.address_hi;
+		e->msi.data = ue->u.msi.data;
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
@@ -258,14 +258,64 @@ static void gstage_op_pte(struct kvm *kvm, gpa_t addr,
 		if (op == GSTAGE_OP_CLEAR)
 			put_page(virt_to_page(next_ptep));
 	} else {
-		if (op == GSTAGE_OP_CLEAR)
+		if (op == GSTAGE_OP_CLEAR) {
 			set_pte(ptep, __pte(0));
-		else if (op == GSTAGE_OP_WP)
+		} else if (op == GSTAGE_OP_WP) {
+			/* Avoid a remote flush for already-clean leaves */
+			if (!(pte_val(*ptep) & _PAGE_WRITE))
+				return;
 			set_pte(ptep, __pte(pte_val(*ptep) & ~_PAGE_WRITE));
+		}
 		gstage_remote_tlb_flush(kvm, ptep_level, addr);
 	}
 }
 
+/*
+ * Split a huge leaf into write-protected next-level leaves.
+ *
+ * Called from the dirty-logging write-protect paths with kvm->mmu_lock
+ * held, hence the GFP_ATOMIC split cache.  Write-protecting a huge leaf
+ * in place would leave the fault path unable to install the 4K mapping
+ * it wants while logging is active (gstage_set_pte() refuses to replace
+ * a huge leaf with -EEXIST), and taking the whole block write fault
+ * would dirty the full 1G/2M range for a single guest store.  Breaking
+ * the leaf up front keeps migration precopy at 4K granularity.
+ *
+ * The caller re-walks the same address afterwards, so a 1G leaf is
+ * split level by level down to 4K.
+ */
+static int gstage_split_wp_leaf(struct kvm *kvm, gpa_t addr,
+				pte_t *ptep, u32 ptep_level)
+{
+	int i, ret;
+	pte_t old_pte, *next_ptep;
+	unsigned long next_page_size;
+	unsigned long pfn_stride;
+
+	ret = gstage_level_to_page_size(ptep_level - 1, &next_page_size);
+	if (ret)
+		return ret;
+
+	ret = kvm_mmu_topup_memory_cache(&kvm->arch.mmu_split_cache, 1);
+	if (ret)
+		return ret;
+
+	next_ptep = kvm_mmu_memory_cache_alloc(&kvm->arch.mmu_split_cache);
+	if (!next_ptep)
+		return -ENOMEM;
+
+	old_pte = *ptep;
+	pfn_stride = next_page_size >> PAGE_SHIFT;
+	for (i = 0; i < PTRS_PER_PTE; i++)
+		next_ptep[i] = __pte((pte_val(old_pte) & ~_PAGE_WRITE) +
+				     ((unsigned long)i * pfn_stride << _PAGE_PFN_SHIFT));
+
+	*ptep = pfn_pte(PFN_DOWN(__pa(next_ptep)), __pgprot(_PAGE_TABLE));
+	gstage_remote_tlb_flush(kvm, ptep_level, addr);
+
+	return 0;
+}
+
 static void gstage_unmap_range(struct kvm *kvm, gpa_t start,
 			       gpa_t size, bool may_block)
 {
@@ -321,9 +371,23 @@ static void gstage_wp_range(struct kvm *kvm, gpa_t start, gpa_t end)
 		if (!found_leaf)
 			goto next;
 
-		if (!(addr & (page_size - 1)) && ((end - addr) >= page_size))
+		if (!(addr & (page_size - 1)) && ((end - addr) >= page_size)) {
+			/*
+			 * Eagerly split huge leaves so dirty logging and
+			 * the subsequent write faults work at 4K
+			 * granularity.  The split already write-protects
+			 * the new leaves; re-walk the same address so a
+			 * 1G leaf is taken down level by level.  If the
+			 * split fails we fall back to write-protecting
+			 * the whole block.
+			 */
+			if (ptep_level &&
+			    !gstage_split_wp_leaf(kvm, addr, ptep, ptep_level))
+				continue;
+
 			gstage_op_pte(kvm, addr, ptep,
 				      ptep_level, GSTAGE_OP_WP);
+		}
 
 next:
 		addr += page_size;
@@ -587,7 +651,8 @@ bool kvm_age_gfn(struct kvm *kvm, struct kvm_gfn_range *range)
 	if (!kvm->arch.pgd)
 		return false;
 
-	WARN_ON(size != PAGE_SIZE && size != PMD_SIZE && size != PGDIR_SIZE);
+	WARN_ON(size != PAGE_SIZE && size != PMD_SIZE &&
+		size != PUD_SIZE && size != PGDIR_SIZE);
 
 	if (!gstage_get_leaf_entry(kvm, range->start << PAGE_SHIFT,
 				   &ptep, &ptep_level))
@@ -605,7 +670,8 @@ bool kvm_test_age_gfn(struct kvm *kvm, struct kvm_gfn_range *range)
 	if (!kvm->arch.pgd)
 		return false;
 
-	WARN_ON(size != PAGE_SIZE && size != PMD_SIZE && size != PGDIR_SIZE);
+	WARN_ON(size != PAGE_SIZE && size != PMD_SIZE &&
+		size != PUD_SIZE && size != PGDIR_SIZE);
 
 	if (!gstage_get_leaf_entry(kvm, range->start << PAGE_SHIFT,
 				   &ptep, &ptep_level))
@@ -654,7 +720,8 @@ int kvm_riscv_gstage_map(struct kvm_vcpu *vcpu,
 	if (logging || (vma->vm_flags & VM_PFNMAP))
 		vma_pagesize = PAGE_SIZE;
 
-	if (vma_pagesize == PMD_SIZE || vma_pagesize == PGDIR_SIZE)
+	if (vma_pagesize == PMD_SIZE || vma_pagesize == PUD_SIZE ||
+	    vma_pagesize == PGDIR_SIZE)
 		gfn = (gpa & huge_page_mask(hstate_vma(vma))) >> PAGE_SHIFT;
 
 	/*
@@ -669,6 +736,7 @@ int kvm_riscv_gstage_map(struct kvm_vcpu *vcpu,
 	mmap_read_unlock(current->mm);
 
 	if (vma_pagesize != PGDIR_SIZE &&
+	    vma_pagesize != PUD_SIZE &&
 	    vma_pagesize != PMD_SIZE &&
 	    vma_pagesize != PAGE_SIZE) {
 		kvm_err("Invalid VMA page size 0x%lx\n", vma_pagesize);
@@ -732,6 +800,9 @@ int kvm_riscv_gstage_alloc_pgd(struct kvm *kvm)
 	kvm->arch.pgd = page_to_virt(pgd_page);
 	kvm->arch.pgd_phys = page_to_phys(pgd_page);
 
+	kvm->arch.mmu_split_cache.gfp_custom = GFP_ATOMIC | __GFP_ACCOUNT;
+	kvm->arch.mmu_split_cache.gfp_zero = __GFP_ZERO;
+
 	return 0;
 }
 
@@ -748,6 +819,8 @@ void kvm_riscv_gstage_free_pgd(struct kvm *kvm)
 	}
 	spin_unlock(&kvm->mmu_lock);
 
+	kvm_mmu_free_memory_cache(&kvm->arch.mmu_split_cache);
+
 	if (pgd)
 		free_pages((unsigned long)pgd, get_order(gstage_pgd_size));
 }
@@ -15,8 +15,7 @@
 #include <asm/hwcap.h>
 #include <asm/insn-def.h>
 
-#define has_svinval()	\
-	static_branch_unlikely(&riscv_isa_ext_keys[RISCV_ISA_EXT_KEY_SVINVAL])
+#define has_svinval()	riscv_has_extension_unlikely(RISCV_ISA_EXT_SVINVAL)
 
 void kvm_riscv_local_hfence_gvma_vmid_gpa(unsigned long vmid,
 					  gpa_t gpa, gpa_t gpsz,
@@ -181,6 +180,7 @@ void kvm_riscv_local_tlb_sanitize(struct kvm_vcpu *vcpu)
 
 void kvm_riscv_fence_i_process(struct kvm_vcpu *vcpu)
 {
+	kvm_riscv_vcpu_flush_insn_cache(vcpu);
 	local_flush_icache_all();
 }
 
@@ -188,6 +188,8 @@ void kvm_riscv_hfence_gvma_vmid_all_process(struct kvm_vcpu *vcpu)
 {
 	struct kvm_vmid *vmid;
 
+	kvm_riscv_vcpu_flush_insn_cache(vcpu);
+
 	vmid = &vcpu->kvm->arch.vmid;
 	kvm_riscv_local_hfence_gvma_vmid_all(READ_ONCE(vmid->vmid));
 }
@@ -196,6 +198,8 @@ void kvm_riscv_hfence_vvma_all_process(struct kvm_vcpu *vcpu)
 {
 	struct kvm_vmid *vmid;
 
+	kvm_riscv_vcpu_flush_insn_cache(vcpu);
+
 	vmid = &vcpu->kvm->arch.vmid;
 	kvm_riscv_local_hfence_vvma_all(READ_ONCE(vmid->vmid));
 }
@@ -225,6 +229,53 @@ static bool vcpu_hfence_dequeue(struct kvm_vcpu *vcpu,
 	return ret;
 }
 
+/*
+ * Try to extend the most recently enqueued request instead of consuming
+ * another queue slot.  Guest memory updates (e.g. virtio ring setup or
+ * ballooning) unmap large regions one page-table entry at a time, which
+ * used to enqueue one request per PTE and quickly overflow the queue,
+ * degrading a 2M unmap into a full G-stage flush via the fallback
+ * request.  Coalescing adjacent ranges keeps such bursts down to a
+ * single queue entry that is flushed in one pass per VCPU kick.
+ *
+ * Must be called with the VCPU hfence_lock held.
+ */
+static bool vcpu_hfence_merge(struct kvm_vcpu_arch *varch,
+			      const struct kvm_riscv_hfence *data)
+{
+	struct kvm_riscv_hfence *prev;
+	gpa_t begin, end;
+	unsigned long idx;
+
+	/* Only range-based requests carry an address to merge on. */
+	if (data->type != KVM_RISCV_HFENCE_GVMA_VMID_GPA &&
+	    data->type != KVM_RISCV_HFENCE_VVMA_ASID_GVA &&
+	    data->type != KVM_RISCV_HFENCE_VVMA_GVA)
+		return false;
+
+	idx = (varch->hfence_tail + KVM_RISCV_VCPU_MAX_HFENCE - 1) %
+	      KVM_RISCV_VCPU_MAX_HFENCE;
+	prev = &varch->hfence_queue[idx];
+
+	if (prev->type != data->type || prev->asid != data->asid ||
+	    prev->order != data->order)
+		return false;
+
+	/*
+	 * Merge only overlapping or adjacent ranges so a pair of distant
+	 * single-page requests is not widened into a huge invalidation.
+	 */
+	begin = min(prev->addr, data->addr);
+	end = max(prev->addr + prev->size, data->addr + data->size);
+	if (end - begin > prev->size + data->size)
+		return false;
+
+	prev->addr = begin;
+	prev->size = end - begin;
+
+	return true;
+}
+
 static bool vcpu_hfence_enqueue(struct kvm_vcpu *vcpu,
 				const struct kvm_riscv_hfence *data)
 {
@@ -233,6 +284,11 @@ static bool vcpu_hfence_enqueue(struct kvm_vcpu *vcpu,
 
 	spin_lock(&varch->hfence_lock);
 
+	if (vcpu_hfence_merge(varch, data)) {
+		spin_unlock(&varch->hfence_lock);
+		return true;
+	}
+
 	if (!varch->hfence_queue[varch->hfence_tail].type) {
 		memcpy(&varch->hfence_queue[varch->hfence_tail],
 		       data, sizeof(*data));
@@ -254,6 +310,8 @@ void kvm_riscv_hfence_process(struct kvm_vcpu *vcpu)
 	struct kvm_riscv_hfence d = { 0 };
 	struct kvm_vmid *v = &vcpu->kvm->arch.vmid;
 
+	kvm_riscv_vcpu_flush_insn_cache(vcpu);
+
 	while (vcpu_hfence_dequeue(vcpu, &d)) {
 		switch (d.type) {
 		case KVM_RISCV_HFENCE_UNKNOWN:
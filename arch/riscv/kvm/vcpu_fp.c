@@ -10,6 +10,7 @@
 #include <linux/errno.h>
 #include <linux/err.h>
 #include <linux/kvm_host.h>
+#include <linux/preempt.h>
 #include <linux/uaccess.h>
 #include <asm/hwcap.h>
 
@@ -21,9 +22,13 @@ void kvm_riscv_vcpu_fp_reset(struct kvm_vcpu *vcpu)
 	cntx->sstatus &= ~SR_FS;
 	if (riscv_isa_extension_available(vcpu->arch.isa, f) ||
 	    riscv_isa_extension_available(vcpu->arch.isa, d))
-		cntx->sstatus |= SR_FS_INITIAL;
+		vcpu->arch.guest_fp_sr_fs = SR_FS_INITIAL;
 	else
-		cntx->sstatus |= SR_FS_OFF;
+		vcpu->arch.guest_fp_sr_fs = SR_FS_OFF;
+
+	/* Guest FP is lazily loaded on the first guest FP trap */
+	cntx->sstatus |= SR_FS_OFF;
+	vcpu->arch.guest_fp_loaded = false;
 }
 
 static void kvm_riscv_vcpu_fp_clean(struct kvm_cpu_context *cntx)
@@ -72,6 +77,50 @@ void kvm_riscv_vcpu_host_fp_restore(struct kvm_cpu_context *cntx)
 	else if (riscv_isa_extension_available(NULL, f))
 		__kvm_riscv_fp_f_restore(cntx);
 }
+
+/*
+ * The guest runs with SR_FS_OFF in HS-level sstatus until it touches FP,
+ * so the first guest FP access traps to HS-mode as an illegal instruction
+ * and lands here. Swap host FP state for guest FP state and re-enable FS
+ * so the instruction can be retried. Returns false if guest FP is already
+ * loaded (or unavailable), in which case the trap was a real illegal
+ * instruction that must be redirected to the guest.
+ */
+bool kvm_riscv_vcpu_fp_lazy_enable(struct kvm_vcpu *vcpu)
+{
+	struct kvm_cpu_context *cntx = &vcpu->arch.guest_context;
+
+	if (vcpu->arch.guest_fp_loaded)
+		return false;
+	if (vcpu->arch.guest_fp_sr_fs == SR_FS_OFF)
+		return false;
+
+	preempt_disable();
+	kvm_riscv_vcpu_host_fp_save(&vcpu->arch.host_context);
+	cntx->sstatus &= ~SR_FS;
+	cntx->sstatus |= vcpu->arch.guest_fp_sr_fs;
+	kvm_riscv_vcpu_guest_fp_restore(cntx, vcpu->arch.isa);
+	vcpu->arch.guest_fp_loaded = true;
+	preempt_enable();
+
+	return true;
+}
+
+/* Called on vcpu_put with preemption disabled */
+void kvm_riscv_vcpu_fp_lazy_disable(struct kvm_vcpu *vcpu)
+{
+	struct kvm_cpu_context *cntx = &vcpu->arch.guest_context;
+
+	if (!vcpu->arch.guest_fp_loaded)
+		return;
+
+	kvm_riscv_vcpu_guest_fp_save(cntx, vcpu->arch.isa);
+	vcpu->arch.guest_fp_sr_fs = cntx->sstatus & SR_FS;
+	cntx->sstatus &= ~SR_FS;
+	cntx->sstatus |= SR_FS_OFF;
+	kvm_riscv_vcpu_host_fp_restore(&vcpu->arch.host_context);
+	vcpu->arch.guest_fp_loaded = false;
+}
 #endif
 
 int kvm_riscv_vcpu_get_reg_fp(struct kvm_vcpu *vcpu,
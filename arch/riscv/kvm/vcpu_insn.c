@@ -435,6 +435,56 @@ int kvm_riscv_vcpu_virtual_insn(struct kvm_vcpu *vcpu, struct kvm_run *run,
 	}
 }
 
+/*
+ * Unprivileged instruction fetch cache
+ *
+ * On implementations that do not provide the transformed instruction in
+ * htinst, every MMIO trap must re-read the faulting instruction with
+ * kvm_riscv_vcpu_unpriv_read(), which costs two CSR swaps plus a guarded
+ * guest-memory access per exit and can itself trap.  Device driver loops
+ * (virtio-mmio kicks in particular) take this path at the same handful
+ * of guest PCs over and over, so keep a small direct-mapped per-VCPU
+ * cache of fetched instruction words keyed by guest PC.
+ *
+ * The cache is flushed whenever the host observes the guest invalidating
+ * instruction memory or mappings: on remote fence.i and on all queued
+ * HFENCE requests (see tlb.c), as well as on VCPU reset.  All accesses
+ * happen on the VCPU thread, so no locking is needed.
+ */
+static bool insn_fetch_cache_lookup(struct kvm_vcpu *vcpu, unsigned long sepc,
+				    unsigned long *insn, int *insn_len)
+{
+	struct kvm_insn_fetch_cache *ent;
+
+	ent = &vcpu->arch.insn_fetch_cache[(sepc >> 1) %
+					   KVM_INSN_FETCH_CACHE_SLOTS];
+	if (!ent->valid || ent->sepc != sepc)
+		return false;
+
+	*insn = ent->insn;
+	*insn_len = ent->insn_len;
+	return true;
+}
+
+static void insn_fetch_cache_update(struct kvm_vcpu *vcpu, unsigned long sepc,
+				    unsigned long insn, int insn_len)
+{
+	struct kvm_insn_fetch_cache *ent;
+
+	ent = &vcpu->arch.insn_fetch_cache[(sepc >> 1) %
+					   KVM_INSN_FETCH_CACHE_SLOTS];
+	ent->sepc = sepc;
+	ent->insn = insn;
+	ent->insn_len = insn_len;
+	ent->valid = true;
+}
+
+void kvm_riscv_vcpu_flush_insn_cache(struct kvm_vcpu *vcpu)
+{
+	memset(vcpu->arch.insn_fetch_cache, 0,
+	       sizeof(vcpu->arch.insn_fetch_cache));
+}
+
 /**
  * kvm_riscv_vcpu_mmio_load -- Emulate MMIO load instruction
  *
@@ -470,15 +520,19 @@ int kvm_riscv_vcpu_mmio_load(struct kvm_vcpu *vcpu, struct kvm_run *run,
 		 * Bit[0] == 0 implies trapped instruction value is
 		 * zero or special value.
 		 */
-		insn = kvm_riscv_vcpu_unpriv_read(vcpu, true, ct->sepc,
-						  &utrap);
-		if (utrap.scause) {
-			/* Redirect trap if we failed to read instruction */
-			utrap.sepc = ct->sepc;
-			kvm_riscv_vcpu_trap_redirect(vcpu, &utrap);
-			return 1;
+		if (!insn_fetch_cache_lookup(vcpu, ct->sepc,
+					     &insn, &insn_len)) {
+			insn = kvm_riscv_vcpu_unpriv_read(vcpu, true, ct->sepc,
+							  &utrap);
+			if (utrap.scause) {
+				/* Redirect trap if we failed to read instruction */
+				utrap.sepc = ct->sepc;
+				kvm_riscv_vcpu_trap_redirect(vcpu, &utrap);
+				return 1;
+			}
+			insn_len = INSN_LEN(insn);
+			insn_fetch_cache_update(vcpu, ct->sepc, insn, insn_len);
 		}
-		insn_len = INSN_LEN(insn);
 	}
 
 	/* Decode length of MMIO and shift */
@@ -596,15 +650,19 @@ int kvm_riscv_vcpu_mmio_store(struct kvm_vcpu *vcpu, struct kvm_run *run,
 		 * Bit[0] == 0 implies trapped instruction value is
 		 * zero or special value.
 		 */
-		insn = kvm_riscv_vcpu_unpriv_read(vcpu, true, ct->sepc,
-						  &utrap);
-		if (utrap.scause) {
-			/* Redirect trap if we failed to read instruction */
-			utrap.sepc = ct->sepc;
-			kvm_riscv_vcpu_trap_redirect(vcpu, &utrap);
-			return 1;
+		if (!insn_fetch_cache_lookup(vcpu, ct->sepc,
+					     &insn, &insn_len)) {
+			insn = kvm_riscv_vcpu_unpriv_read(vcpu, true, ct->sepc,
+							  &utrap);
+			if (utrap.scause) {
+				/* Redirect trap if we failed to read instruction */
+				utrap.sepc = ct->sepc;
+				kvm_riscv_vcpu_trap_redirect(vcpu, &utrap);
+				return 1;
+			}
+			insn_len = INSN_LEN(insn);
+			insn_fetch_cache_update(vcpu, ct->sepc, insn, insn_len);
 		}
-		insn_len = INSN_LEN(insn);
 	}
 
 	data = GET_RS2(insn, &vcpu->arch.guest_context);
@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Boot-time tuning of the mem* dispatch thresholds.
+ *
+ * The block size above which the vector mem* kernels beat the scalar
+ * ones varies widely between parts: unaligned-access cost, vector
+ * startup latency and the sweet-spot copy block size are all different
+ * on e.g. a JH7110 and an SG2042, and a threshold hard-coded for one of
+ * them loses on the other.  Instead of guessing, time both candidate
+ * kernels over a few block sizes once on the boot CPU and set the
+ * dispatch thresholds consumed by mem_vector.c to the measured
+ * crossover.  The chosen values are reported in dmesg and exported
+ * through debugfs for debugging.
+ */
+
+#include <linux/debugfs.h>
+#include <linux/init.h>
+#include <linux/interrupt.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/string.h>
+#include <linux/timex.h>
+
+#include <asm/switch_to.h>
+
+#define COPY_TUNE_ITERS		32
+#define COPY_TUNE_BUF_SIZE	SZ_8K
+
+static const unsigned long copy_tune_sizes[] = { 64, 128, 256, 512, 1024, 2048 };
+
+extern asmlinkage void *__memcpy_generic(void *, const void *, size_t);
+extern asmlinkage void *__memset_generic(void *, int, size_t);
+asmlinkage void *__memcpy_vector(void *, const void *, size_t);
+asmlinkage void *__memset_vector(void *, int, size_t);
+
+/*
+ * Minimum of COPY_TUNE_ITERS runs: the minimum discards interrupt and
+ * cache-miss noise, which is what we want when comparing the kernels
+ * themselves.  The vector timings deliberately include the vstate
+ * save/restore bookkeeping since every real call pays for it too.
+ */
+static u64 __init copy_tune_time_memcpy(void *dst, const void *src,
+					unsigned long size, bool vector)
+{
+	u64 t0, dt, best = U64_MAX;
+	int i;
+
+	for (i = 0; i < COPY_TUNE_ITERS; i++) {
+		t0 = get_cycles();
+		if (vector) {
+			kernel_vector_begin();
+			__memcpy_vector(dst, src, size);
+			kernel_vector_end();
+		} else {
+			__memcpy_generic(dst, src, size);
+		}
+		dt = get_cycles() - t0;
+		best = min(best, dt);
+	}
+
+	return best;
+}
+
+static u64 __init copy_tune_time_memset(void *dst, unsigned long size,
+					bool vector)
+{
+	u64 t0, dt, best = U64_MAX;
+	int i;
+
+	for (i = 0; i < COPY_TUNE_ITERS; i++) {
+		t0 = get_cycles();
+		if (vector) {
+			kernel_vector_begin();
+			__memset_vector(dst, 0, size);
+			kernel_vector_end();
+		} else {
+			__memset_generic(dst, 0, size);
+		}
+		dt = get_cycles() - t0;
+		best = min(best, dt);
+	}
+
+	return best;
+}
+
+/* Smallest probed size at which the vector kernel wins, or ULONG_MAX. */
+static unsigned long __init copy_tune_crossover(void *dst, const void *src,
+						bool is_set)
+{
+	u64 scalar, vector;
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(copy_tune_sizes); i++) {
+		unsigned long size = copy_tune_sizes[i];
+
+		if (is_set) {
+			scalar = copy_tune_time_memset(dst, size, false);
+			vector = copy_tune_time_memset(dst, size, true);
+		} else {
+			scalar = copy_tune_time_memcpy(dst, src, size, false);
+			vector = copy_tune_time_memcpy(dst, src, size, true);
+		}
+
+		if (vector < scalar)
+			return size;
+	}
+
+	return ULONG_MAX;
+}
+
+static struct dentry *copy_tune_debugfs;
+
+static int __init riscv_copy_tune(void)
+{
+	void *src, *dst;
+
+	if (!has_vector())
+		return 0;
+
+	src = kmalloc(COPY_TUNE_BUF_SIZE, GFP_KERNEL);
+	dst = kmalloc(COPY_TUNE_BUF_SIZE, GFP_KERNEL);
+	if (!src || !dst)
+		goto out;
+
+	/* Warm the buffers so both candidates see hot caches. */
+	memset(src, 0x5a, COPY_TUNE_BUF_SIZE);
+	memset(dst, 0xa5, COPY_TUNE_BUF_SIZE);
+
+	riscv_vector_memcpy_min = copy_tune_crossover(dst, src, false);
+	riscv_vector_memset_min = copy_tune_crossover(dst, src, true);
+
+	pr_info("copy-tune: vector crossover: memcpy %lu, memset %lu\n",
+		riscv_vector_memcpy_min, riscv_vector_memset_min);
+
+	copy_tune_debugfs = debugfs_create_dir("riscv-copy-tune", NULL);
+	debugfs_create_ulong("vector_memcpy_min", 0444, copy_tune_debugfs,
+			     &riscv_vector_memcpy_min);
+	debugfs_create_ulong("vector_memset_min", 0444, copy_tune_debugfs,
+			     &riscv_vector_memset_min);
+
+out:
+	kfree(src);
+	kfree(dst);
+	return 0;
+}
+arch_initcall(riscv_copy_tune);
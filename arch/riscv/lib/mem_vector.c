@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Vector accelerated mem* frontends.  The scalar entry points in
+ * memcpy.S/memset.S/memmove.S get their first instruction patched to a
+ * jump here by the alternatives framework once the boot CPU reports the
+ * V extension, see cpufeature_probe_vector().
+ */
+
+#include <linux/preempt.h>
+#include <linux/string.h>
+#include <asm/switch_to.h>
+
+/*
+ * Below this size the vsetvli strip mining plus the vstate bookkeeping
+ * in kernel_vector_begin()/kernel_vector_end() costs more than the
+ * wider datapath saves.  This is only the build-time default: the real
+ * crossover differs per part, so copy_tune.c measures it at boot and
+ * overwrites the thresholds below.
+ */
+#define VECTOR_MEMOP_MIN	256
+
+unsigned long riscv_vector_memcpy_min __read_mostly = VECTOR_MEMOP_MIN;
+unsigned long riscv_vector_memset_min __read_mostly = VECTOR_MEMOP_MIN;
+
+extern asmlinkage void *__memcpy_generic(void *, const void *, size_t);
+extern asmlinkage void *__memset_generic(void *, int, size_t);
+extern asmlinkage void *__memmove_generic(void *, const void *, size_t);
+
+asmlinkage void *__memcpy_vector(void *, const void *, size_t);
+asmlinkage void *__memset_vector(void *, int, size_t);
+asmlinkage void *__memmove_vector(void *, const void *, size_t);
+
+static __always_inline bool vector_memop_usable(size_t n, unsigned long min)
+{
+	/*
+	 * Interrupt context may have preempted another kernel vector
+	 * region whose live register contents must not be clobbered, so
+	 * only task level work may take the vector path.
+	 */
+	return n >= min && !in_interrupt();
+}
+
+asmlinkage void *memcpy_vector(void *dest, const void *src, size_t n)
+{
+	if (!vector_memop_usable(n, riscv_vector_memcpy_min))
+		return __memcpy_generic(dest, src, n);
+
+	kernel_vector_begin();
+	__memcpy_vector(dest, src, n);
+	kernel_vector_end();
+
+	return dest;
+}
+
+asmlinkage void *memset_vector(void *dest, int c, size_t n)
+{
+	if (!vector_memop_usable(n, riscv_vector_memset_min))
+		return __memset_generic(dest, c, n);
+
+	kernel_vector_begin();
+	__memset_vector(dest, c, n);
+	kernel_vector_end();
+
+	return dest;
+}
+
+asmlinkage void *memmove_vector(void *dest, const void *src, size_t n)
+{
+	if (!vector_memop_usable(n, riscv_vector_memcpy_min))
+		return __memmove_generic(dest, src, n);
+
+	kernel_vector_begin();
+	__memmove_vector(dest, src, n);
+	kernel_vector_end();
+
+	return dest;
+}
@@ -0,0 +1,34 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Vector user copy frontend.  raw_copy_{to,from}_user() divert here for
+ * copies of at least RISCV_UACCESS_VECTOR_MIN bytes once the V
+ * extension has been detected, see uaccess_vector_usable().
+ */
+
+#include <linux/preempt.h>
+#include <linux/uaccess.h>
+#include <asm/switch_to.h>
+
+unsigned long __asm_copy_user_vector(void *to, const void *from,
+				     unsigned long n);
+
+unsigned long riscv_copy_user_vector(void *to, const void *from,
+				     unsigned long n)
+{
+	unsigned long rem;
+
+	/*
+	 * Interrupt context may have preempted another kernel vector
+	 * region, keep it on the scalar path.  Both copy directions
+	 * share one scalar body, either entry point will do.
+	 */
+	if (in_interrupt())
+		return __asm_copy_to_user((__force void __user *)to, from, n);
+
+	kernel_vector_begin();
+	rem = __asm_copy_user_vector(to, from, n);
+	kernel_vector_end();
+
+	return rem;
+}
+EXPORT_SYMBOL(riscv_copy_user_vector);
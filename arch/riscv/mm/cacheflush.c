@@ -5,6 +5,7 @@
 
 #include <linux/of.h>
 #include <asm/cacheflush.h>
+#include <asm/errata_list.h>
 
 #ifdef CONFIG_SMP
 
@@ -78,6 +79,37 @@ void flush_icache_mm(struct mm_struct *mm, bool local)
 
 #endif /* CONFIG_SMP */
 
+/*
+ * fence.i only works on the whole local icache and remote harts can only
+ * be reached through the SBI broadcast.  The T-Head C9xx cores however
+ * broadcast their ranged icache.iva maintenance to every hart in the
+ * coherence domain, so once the CMO alternatives have been patched in we
+ * can service small ranges without interrupting every hart.  Beyond
+ * RISCV_ICACHE_RANGE_MAX the per-line loop stops being cheaper than a
+ * full invalidation, so fall back to the global flush.
+ */
+static bool icache_range_bcast;
+
+void riscv_icache_range_supported(void)
+{
+	icache_range_bcast = true;
+}
+
+#define RISCV_ICACHE_RANGE_MAX	(16UL * PAGE_SIZE)
+
+void flush_icache_range(unsigned long start, unsigned long end)
+{
+	unsigned long size = end - start;
+
+	if (!icache_range_bcast || size > RISCV_ICACHE_RANGE_MAX) {
+		flush_icache_all();
+		return;
+	}
+
+	ALT_ICACHE_INVAL_RANGE(start, size, riscv_cbom_block_size);
+}
+EXPORT_SYMBOL(flush_icache_range);
+
 #ifdef CONFIG_MMU
 void flush_icache_pte(pte_t pte)
 {
@@ -133,3 +165,40 @@ void riscv_init_cbom_blocksize(void)
 	if (probed_block_size)
 		riscv_cbom_block_size = probed_block_size;
 }
+
+unsigned int riscv_cboz_block_size;
+EXPORT_SYMBOL_GPL(riscv_cboz_block_size);
+
+void riscv_init_cboz_blocksize(void)
+{
+	struct device_node *node;
+	unsigned long cboz_hartid;
+	u32 val, probed_block_size;
+	int ret;
+
+	probed_block_size = 0;
+	for_each_of_cpu_node(node) {
+		unsigned long hartid;
+
+		ret = riscv_of_processor_hartid(node, &hartid);
+		if (ret)
+			continue;
+
+		/* set block-size for cboz extension if available */
+		ret = of_property_read_u32(node, "riscv,cboz-block-size", &val);
+		if (ret)
+			continue;
+
+		if (!probed_block_size) {
+			probed_block_size = val;
+			cboz_hartid = hartid;
+		} else {
+			if (probed_block_size != val)
+				pr_warn("cboz-block-size mismatched between harts %lu and %lu\n",
+					cboz_hartid, hartid);
+		}
+	}
+
+	if (probed_block_size)
+		riscv_cboz_block_size = probed_block_size;
+}
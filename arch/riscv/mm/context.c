@@ -93,13 +93,19 @@ static void __flush_context(void)
 
 		__set_bit(cntx & asid_mask, context_asid_map);
 		per_cpu(reserved_context, i) = cntx;
+
+		/*
+		 * Harts that never scheduled a user context (both the
+		 * active and the reserved CONTEXT are still zero) cannot
+		 * hold stale user translations, so don't make them flush
+		 * on their next context-switch.
+		 */
+		if (cntx)
+			cpumask_set_cpu(i, &context_tlb_flush_pending);
 	}
 
 	/* Mark ASID #0 as used because it is used at boot-time */
 	__set_bit(0, context_asid_map);
-
-	/* Queue a TLB invalidation for each CPU on next context-switch */
-	cpumask_setall(&context_tlb_flush_pending);
 }
 
 static unsigned long __new_context(struct mm_struct *mm)
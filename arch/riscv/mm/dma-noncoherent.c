@@ -12,6 +12,13 @@
 
 static bool noncoherent_supported;
 
+/*
+ * The worst-case granule is assumed until the real one has been probed.
+ * Consumed through dma_get_cache_alignment(), see asm/cache.h.
+ */
+int dma_cache_alignment __ro_after_init = ARCH_DMA_MINALIGN;
+EXPORT_SYMBOL_GPL(dma_cache_alignment);
+
 void arch_sync_dma_for_device(phys_addr_t paddr, size_t size,
 			      enum dma_data_direction dir)
 {
@@ -77,5 +84,7 @@ void riscv_noncoherent_supported(void)
 {
 	WARN(!riscv_cbom_block_size,
 	     "Non-coherent DMA support enabled without a block size\n");
+	if (riscv_cbom_block_size)
+		dma_cache_alignment = riscv_cbom_block_size;
 	noncoherent_supported = true;
 }
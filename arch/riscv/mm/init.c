@@ -22,6 +22,7 @@
 #include <linux/hugetlb.h>
 
 #include <asm/fixmap.h>
+#include <asm/kexec.h>
 #include <asm/tlbflush.h>
 #include <asm/sections.h>
 #include <asm/soc.h>
@@ -795,13 +796,64 @@ void __init create_pgd_mapping(pgd_t *pgdp,
 	create_pgd_next_mapping(nextp, va, pa, sz, prot);
 }
 
-static uintptr_t __init best_map_size(phys_addr_t base, phys_addr_t size)
+static uintptr_t __init best_map_size(phys_addr_t pa, uintptr_t va,
+				      phys_addr_t size)
 {
-	/* Upgrade to PMD_SIZE mappings whenever possible */
-	if ((base & (PMD_SIZE - 1)) || (size & (PMD_SIZE - 1)))
-		return PAGE_SIZE;
+	if (pgtable_l5_enabled &&
+	    !(pa & (P4D_SIZE - 1)) && !(va & (P4D_SIZE - 1)) && size >= P4D_SIZE)
+		return P4D_SIZE;
 
-	return PMD_SIZE;
+	if (pgtable_l4_enabled &&
+	    !(pa & (PUD_SIZE - 1)) && !(va & (PUD_SIZE - 1)) && size >= PUD_SIZE)
+		return PUD_SIZE;
+
+	if (IS_ENABLED(CONFIG_64BIT) &&
+	    !(pa & (PMD_SIZE - 1)) && !(va & (PMD_SIZE - 1)) && size >= PMD_SIZE)
+		return PMD_SIZE;
+
+	return PAGE_SIZE;
+}
+
+/*
+ * Optional accounting of the linear mapping: pass "linear_map_report" on
+ * the command line to get a one-off summary of how much of the linear map
+ * ended up at each mapping size.  Useful to spot memory banks whose
+ * base or size alignment demotes them from gigapages to 2M/4K mappings.
+ */
+static bool linear_map_report_enabled __initdata;
+
+static int __init set_linear_map_report(char *str)
+{
+	linear_map_report_enabled = true;
+	return 0;
+}
+early_param("linear_map_report", set_linear_map_report);
+
+static unsigned long linear_map_pages[4] __initdata;
+
+static void __init linear_map_count(uintptr_t map_size)
+{
+	if (!linear_map_report_enabled)
+		return;
+
+	if (map_size == P4D_SIZE)
+		linear_map_pages[3]++;
+	else if (map_size == PUD_SIZE)
+		linear_map_pages[2]++;
+	else if (map_size == PMD_SIZE)
+		linear_map_pages[1]++;
+	else
+		linear_map_pages[0]++;
+}
+
+static void __init linear_map_report(void)
+{
+	if (!linear_map_report_enabled)
+		return;
+
+	pr_info("linear mapping: %lu P4D + %lu PUD + %lu PMD + %lu PTE mappings\n",
+		linear_map_pages[3], linear_map_pages[2],
+		linear_map_pages[1], linear_map_pages[0]);
 }
 
 #ifdef CONFIG_XIP_KERNEL
@@ -839,10 +891,12 @@ static __init pgprot_t pgprot_from_va(uintptr_t va)
 
 void mark_rodata_ro(void)
 {
+	set_memory_batch_begin();
 	set_kernel_memory(__start_rodata, _data, set_memory_ro);
 	if (IS_ENABLED(CONFIG_64BIT))
 		set_kernel_memory(lm_alias(__start_rodata), lm_alias(_data),
 				  set_memory_ro);
+	set_memory_batch_end();
 
 	debug_checkwx();
 }
@@ -1259,14 +1313,16 @@ static void __init setup_vm_final(void)
 		if (end >= __pa(PAGE_OFFSET) + memory_limit)
 			end = __pa(PAGE_OFFSET) + memory_limit;
 
-		map_size = best_map_size(start, end - start);
 		for (pa = start; pa < end; pa += map_size) {
 			va = (uintptr_t)__va(pa);
+			map_size = best_map_size(pa, va, end - pa);
 
 			create_pgd_mapping(swapper_pg_dir, va, pa, map_size,
 					   pgprot_from_va(va));
+			linear_map_count(map_size);
 		}
 	}
+	linear_map_report();
 
 	/* Map the kernel */
 	if (IS_ENABLED(CONFIG_64BIT))
@@ -1368,6 +1424,58 @@ static void __init reserve_crashkernel(void)
 	crashk_res.end = crash_base + crash_size - 1;
 }
 
+/* Pool backing preloaded kexec images, see arch/riscv/kernel/machine_kexec.c */
+phys_addr_t kexec_pool_base;
+phys_addr_t kexec_pool_size;
+
+static unsigned long long kexec_pool_requested;
+
+static int __init early_kexec_pool(char *p)
+{
+	kexec_pool_requested = memparse(p, NULL);
+	return 0;
+}
+early_param("kexec_pool", early_kexec_pool);
+
+/*
+ * reserve_kexec_pool() - reserves memory for preloaded kexec images
+ *
+ * This function reserves the memory area given in the "kexec_pool=" kernel
+ * command line parameter. kexec_file_load() places images for a regular
+ * (non-crash) kexec in this pool and stages their segments into the final
+ * physical pages at load time, so that no copying is left for reboot time.
+ */
+static void __init reserve_kexec_pool(void)
+{
+	unsigned long long size;
+	phys_addr_t base;
+
+	if (!IS_ENABLED(CONFIG_KEXEC_FILE) || !kexec_pool_requested)
+		return;
+
+	/* No live updates out of a crash kernel, don't waste its memory */
+	if (is_kdump_kernel())
+		return;
+
+	size = PAGE_ALIGN(kexec_pool_requested);
+
+	/* The kernel segment needs the boot protocol alignment, see above */
+	base = memblock_phys_alloc_range(size, PMD_SIZE,
+					 memblock_start_of_DRAM(),
+					 memblock_end_of_DRAM());
+	if (!base) {
+		pr_warn("kexec_pool: couldn't allocate %lldKB\n", size >> 10);
+		return;
+	}
+
+	pr_info("kexec_pool: reserved 0x%016llx - 0x%016llx (%lld MB)\n",
+		(unsigned long long)base, (unsigned long long)(base + size),
+		size >> 20);
+
+	kexec_pool_base = base;
+	kexec_pool_size = size;
+}
+
 #ifdef CONFIG_HIGHMEM
 static void __init pkmap_init(void)
 {
@@ -1394,6 +1502,7 @@ void __init misc_mem_init(void)
 	pkmap_init();
 #endif
 	reserve_crashkernel();
+	reserve_kexec_pool();
 	memblock_dump_all();
 }
 
@@ -3,8 +3,10 @@
  * Copyright (C) 2019 SiFive
  */
 
+#include <linux/mutex.h>
 #include <linux/pagewalk.h>
 #include <linux/pgtable.h>
+#include <linux/sched.h>
 #include <asm/tlbflush.h>
 #include <asm/bitops.h>
 #include <asm/set_memory.h>
@@ -104,6 +106,57 @@ static const struct mm_walk_ops pageattr_ops = {
 	.pte_hole = pageattr_pte_hole,
 };
 
+/*
+ * Batching of attribute changes.  Module loading, the BPF JIT and ftrace
+ * patching all issue runs of set_memory_* calls over adjacent ranges, and
+ * each call used to pay for a full ranged shootdown.  Inside a
+ * begin/end section the PTE updates are applied immediately but the
+ * shootdown is deferred and issued once over the union of the touched
+ * range, so a whole run costs a single fence.
+ *
+ * The section is serialized against other batchers by the mutex;
+ * set_memory_* calls from other tasks are unaffected and keep their
+ * immediate flush.  Note that inside a section the new protections are
+ * only guaranteed to be observed by all harts after
+ * set_memory_batch_end() returns.
+ */
+static struct {
+	struct mutex lock;
+	struct task_struct *owner;
+	int depth;
+	unsigned long start;
+	unsigned long end;
+} pageattr_batch = {
+	.lock = __MUTEX_INITIALIZER(pageattr_batch.lock),
+};
+
+void set_memory_batch_begin(void)
+{
+	if (pageattr_batch.owner != current) {
+		mutex_lock(&pageattr_batch.lock);
+		pageattr_batch.owner = current;
+		pageattr_batch.start = ULONG_MAX;
+		pageattr_batch.end = 0;
+	}
+	pageattr_batch.depth++;
+}
+
+void set_memory_batch_end(void)
+{
+	if (WARN_ON(pageattr_batch.owner != current))
+		return;
+
+	if (--pageattr_batch.depth)
+		return;
+
+	if (pageattr_batch.start < pageattr_batch.end)
+		flush_tlb_kernel_range(pageattr_batch.start,
+				       pageattr_batch.end);
+
+	pageattr_batch.owner = NULL;
+	mutex_unlock(&pageattr_batch.lock);
+}
+
 static int __set_memory(unsigned long addr, int numpages, pgprot_t set_mask,
 			pgprot_t clear_mask)
 {
@@ -123,7 +176,12 @@ static int __set_memory(unsigned long addr, int numpages, pgprot_t set_mask,
 				     &masks);
 	mmap_write_unlock(&init_mm);
 
-	flush_tlb_kernel_range(start, end);
+	if (pageattr_batch.owner == current) {
+		pageattr_batch.start = min(pageattr_batch.start, start);
+		pageattr_batch.end = max(pageattr_batch.end, end);
+	} else {
+		flush_tlb_kernel_range(start, end);
+	}
 
 	return ret;
 }
@@ -4,8 +4,12 @@
 #include <linux/smp.h>
 #include <linux/sched.h>
 #include <asm/sbi.h>
+#include <asm/hwcap.h>
+#include <asm/insn-def.h>
 #include <asm/mmu_context.h>
 
+#define has_svinval()	riscv_has_extension_unlikely(RISCV_ISA_EXT_SVINVAL)
+
 static inline void local_flush_tlb_all_asid(unsigned long asid)
 {
 	__asm__ __volatile__ ("sfence.vma x0, %0"
@@ -23,11 +27,96 @@ static inline void local_flush_tlb_page_asid(unsigned long addr,
 			: "memory");
 }
 
+/*
+ * With Svinval the per-page invalidations are unordered and a batch of
+ * them shares a single pair of ordering fences, instead of every
+ * sfence.vma draining the pipeline on its own.
+ */
+static inline void local_sinval_vma(unsigned long addr)
+{
+	asm volatile(SINVAL_VMA(%0, zero) : : "r" (addr) : "memory");
+}
+
+static inline void local_sinval_vma_asid(unsigned long addr,
+		unsigned long asid)
+{
+	asm volatile(SINVAL_VMA(%0, %1) : : "r" (addr), "r" (asid) : "memory");
+}
+
 void flush_tlb_all(void)
 {
 	sbi_remote_sfence_vma(NULL, 0, -1);
 }
 
+/*
+ * Flushing a range below this many pages loops sfence.vma per entry,
+ * above it we give up and invalidate the whole ASID.  Tunable with
+ * "tlb_flush_all_threshold=" since the sweet spot depends on how
+ * expensive TLB refills are on the implementation.
+ */
+static unsigned long tlb_flush_all_threshold __read_mostly = 64;
+
+static int __init early_tlb_flush_all_threshold(char *buf)
+{
+	return kstrtoul(buf, 0, &tlb_flush_all_threshold);
+}
+early_param("tlb_flush_all_threshold", early_tlb_flush_all_threshold);
+
+static void local_flush_tlb_range_asid(unsigned long start, unsigned long size,
+				       unsigned long stride, unsigned long asid)
+{
+	/* Careful, size == -1 means the full address space */
+	if (size == (unsigned long)-1 ||
+	    DIV_ROUND_UP(size, stride) > tlb_flush_all_threshold) {
+		local_flush_tlb_all_asid(asid);
+		return;
+	}
+
+	if (has_svinval()) {
+		asm volatile(SFENCE_W_INVAL() ::: "memory");
+		while (size) {
+			local_sinval_vma_asid(start, asid);
+			start += stride;
+			size -= min(size, stride);
+		}
+		asm volatile(SFENCE_INVAL_IR() ::: "memory");
+		return;
+	}
+
+	while (size) {
+		local_flush_tlb_page_asid(start, asid);
+		start += stride;
+		size -= min(size, stride);
+	}
+}
+
+static void local_flush_tlb_range(unsigned long start, unsigned long size,
+				  unsigned long stride)
+{
+	if (size == (unsigned long)-1 ||
+	    DIV_ROUND_UP(size, stride) > tlb_flush_all_threshold) {
+		local_flush_tlb_all();
+		return;
+	}
+
+	if (has_svinval()) {
+		asm volatile(SFENCE_W_INVAL() ::: "memory");
+		while (size) {
+			local_sinval_vma(start);
+			start += stride;
+			size -= min(size, stride);
+		}
+		asm volatile(SFENCE_INVAL_IR() ::: "memory");
+		return;
+	}
+
+	while (size) {
+		local_flush_tlb_page(start);
+		start += stride;
+		size -= min(size, stride);
+	}
+}
+
 static void __sbi_tlb_flush_range(struct mm_struct *mm, unsigned long start,
 				  unsigned long size, unsigned long stride)
 {
@@ -44,21 +133,15 @@ static void __sbi_tlb_flush_range(struct mm_struct *mm, unsigned long start,
 	if (static_branch_unlikely(&use_asid_allocator)) {
 		unsigned long asid = atomic_long_read(&mm->context.id) & asid_mask;
 
-		if (broadcast) {
+		if (broadcast)
 			sbi_remote_sfence_vma_asid(cmask, start, size, asid);
-		} else if (size <= stride) {
-			local_flush_tlb_page_asid(start, asid);
-		} else {
-			local_flush_tlb_all_asid(asid);
-		}
+		else
+			local_flush_tlb_range_asid(start, size, stride, asid);
 	} else {
-		if (broadcast) {
+		if (broadcast)
 			sbi_remote_sfence_vma(cmask, start, size);
-		} else if (size <= stride) {
-			local_flush_tlb_page(start);
-		} else {
-			local_flush_tlb_all();
-		}
+		else
+			local_flush_tlb_range(start, size, stride);
 	}
 
 	put_cpu();
@@ -86,3 +169,32 @@ void flush_pmd_tlb_range(struct vm_area_struct *vma, unsigned long start,
 	__sbi_tlb_flush_range(vma->vm_mm, start, end - start, PMD_SIZE);
 }
 #endif
+
+#ifdef CONFIG_ARCH_WANT_BATCHED_UNMAP_TLB_FLUSH
+void arch_tlbbatch_add_mm(struct arch_tlbflush_unmap_batch *batch,
+			  struct mm_struct *mm)
+{
+	cpumask_or(&batch->cpumask, &batch->cpumask, mm_cpumask(mm));
+
+	/*
+	 * Publish the cleared PTEs before the batch is flushed on the
+	 * CPUs collected above, see the comment in mm_types_task.h.
+	 */
+	smp_mb();
+}
+
+void arch_tlbbatch_flush(struct arch_tlbflush_unmap_batch *batch)
+{
+	if (cpumask_empty(&batch->cpumask))
+		return;
+
+	/*
+	 * Reclaim batches PTEs from many mms onto one cpumask, so there
+	 * is no single ASID to flush; take the full flush on the
+	 * affected harts in exchange for the fenced IPI per page we
+	 * saved during the unmap walk.
+	 */
+	sbi_remote_sfence_vma(&batch->cpumask, 0, -1);
+	cpumask_clear(&batch->cpumask);
+}
+#endif /* CONFIG_ARCH_WANT_BATCHED_UNMAP_TLB_FLUSH */
@@ -12,12 +12,25 @@
 #include <linux/bpf.h>
 #include <linux/filter.h>
 #include <asm/cacheflush.h>
+#include <asm/hwcap.h>
 
 static inline bool rvc_enabled(void)
 {
 	return IS_ENABLED(CONFIG_RISCV_ISA_C);
 }
 
+static inline bool rvzba_enabled(void)
+{
+	return IS_ENABLED(CONFIG_RISCV_ISA_ZBA) &&
+	       riscv_has_extension_likely(RISCV_ISA_EXT_ZBA);
+}
+
+static inline bool rvzbb_enabled(void)
+{
+	return IS_ENABLED(CONFIG_RISCV_ISA_ZBB) &&
+	       riscv_has_extension_likely(RISCV_ISA_EXT_ZBB);
+}
+
 enum {
 	RV_REG_ZERO =	0,	/* The constant value 0 */
 	RV_REG_RA =	1,	/* Return address */
@@ -573,6 +586,40 @@ static inline u32 rv_fence(u8 pred, u8 succ)
 	return rv_i_insn(imm11_0, 0, 0, 0, 0xf);
 }
 
+static inline u32 rv_nop(void)
+{
+	return rv_i_insn(0, 0, 0, 0, 0x13);
+}
+
+/* Zba instructions. */
+
+static inline u32 rvzba_sh1add(u8 rd, u8 rs1, u8 rs2)
+{
+	return rv_r_insn(0x10, rs2, rs1, 2, rd, 0x33);
+}
+
+static inline u32 rvzba_sh2add(u8 rd, u8 rs1, u8 rs2)
+{
+	return rv_r_insn(0x10, rs2, rs1, 4, rd, 0x33);
+}
+
+static inline u32 rvzba_sh3add(u8 rd, u8 rs1, u8 rs2)
+{
+	return rv_r_insn(0x10, rs2, rs1, 6, rd, 0x33);
+}
+
+/* Zbb instructions. */
+
+static inline u32 rvzbb_sextb(u8 rd, u8 rs)
+{
+	return rv_i_insn(0x604, rs, 1, rd, 0x13);
+}
+
+static inline u32 rvzbb_sexth(u8 rd, u8 rs)
+{
+	return rv_i_insn(0x605, rs, 1, rd, 0x13);
+}
+
 /* RVC instrutions. */
 
 static inline u16 rvc_addi4spn(u8 rd, u32 imm10)
@@ -821,6 +868,26 @@ static inline u32 rv_sc_d(u8 rd, u8 rs2, u8 rs1, u8 aq, u8 rl)
 	return rv_amo_insn(0x3, aq, rl, rs2, rs1, 3, rd, 0x2f);
 }
 
+/* RV64-only Zba instructions. */
+
+static inline u32 rvzba_zextw(u8 rd, u8 rs)
+{
+	/* add.uw rd, rs, ZERO */
+	return rv_r_insn(0x04, RV_REG_ZERO, rs, 0, rd, 0x3b);
+}
+
+/* RV64-only Zbb instructions. */
+
+static inline u32 rvzbb_zexth(u8 rd, u8 rs)
+{
+	return rv_r_insn(0x04, 0, rs, 4, rd, 0x3b);
+}
+
+static inline u32 rvzbb_rev8(u8 rd, u8 rs)
+{
+	return rv_i_insn(0x6b8, rs, 5, rd, 0x13);
+}
+
 /* RV64-only RVC instructions. */
 
 static inline u16 rvc_ld(u8 rd, u32 imm8, u8 rs1)
@@ -17,6 +17,19 @@
 #include <linux/dma-mapping.h>
 #include <linux/async_tx.h>
 
+/*
+ * Offloading a copy is only a win once it is large enough to amortize
+ * descriptor setup, the completion interrupt and the cache implications
+ * of the engine writing memory behind the CPU's back.  Copies shorter
+ * than this stay on the CPU even when a memcpy channel is available;
+ * 0 offloads unconditionally.  The default keeps page-sized copies
+ * (raid5 stripe cache) on the engine.
+ */
+static unsigned int dma_min_len = 4096;
+module_param(dma_min_len, uint, 0644);
+MODULE_PARM_DESC(dma_min_len,
+		 "minimum copy length (bytes) worth offloading to a DMA engine");
+
 /**
  * async_memcpy - attempt to copy memory with a dma engine.
  * @dest: destination page
@@ -33,12 +46,17 @@ async_memcpy(struct page *dest, struct page *src, unsigned int dest_offset,
 	     unsigned int src_offset, size_t len,
 	     struct async_submit_ctl *submit)
 {
-	struct dma_chan *chan = async_tx_find_channel(submit, DMA_MEMCPY,
-						      &dest, 1, &src, 1, len);
-	struct dma_device *device = chan ? chan->device : NULL;
+	struct dma_chan *chan = NULL;
+	struct dma_device *device = NULL;
 	struct dma_async_tx_descriptor *tx = NULL;
 	struct dmaengine_unmap_data *unmap = NULL;
 
+	if (len >= READ_ONCE(dma_min_len))
+		chan = async_tx_find_channel(submit, DMA_MEMCPY,
+					     &dest, 1, &src, 1, len);
+	if (chan)
+		device = chan->device;
+
 	if (device)
 		unmap = dmaengine_get_unmap_data(device->dev, 2, GFP_NOWAIT);
 
@@ -9,6 +9,8 @@
 #include <linux/sched.h>
 #include <linux/fs.h>
 #include <linux/init.h>
+#include <linux/debugfs.h>
+#include <linux/random.h>
 #include "null_blk.h"
 
 #undef pr_fmt
@@ -193,6 +195,22 @@ static unsigned long g_completion_nsec = 10000;
 module_param_named(completion_nsec, g_completion_nsec, ulong, 0444);
 MODULE_PARM_DESC(completion_nsec, "Time in ns to complete a request in hardware. Default: 10,000ns");
 
+static int g_completion_dist = NULL_DIST_FIXED;
+module_param_named(completion_dist, g_completion_dist, int, 0444);
+MODULE_PARM_DESC(completion_dist, "Completion latency distribution with irqmode=2. 0-fixed, 1-lognormal, 2-bimodal");
+
+static unsigned long g_completion_slow_nsec = 100000;
+module_param_named(completion_slow_nsec, g_completion_slow_nsec, ulong, 0444);
+MODULE_PARM_DESC(completion_slow_nsec, "Slow-mode completion time in ns for the bimodal distribution. Default: 100,000ns");
+
+static int g_completion_slow_pct = 1;
+module_param_named(completion_slow_pct, g_completion_slow_pct, int, 0444);
+MODULE_PARM_DESC(completion_slow_pct, "Percentage of bimodal completions taking completion_slow_nsec. Default: 1");
+
+static int g_completion_sigma = 4;
+module_param_named(completion_sigma, g_completion_sigma, int, 0444);
+MODULE_PARM_DESC(completion_sigma, "Lognormal spread in eighths of an octave per standard unit. Default: 4");
+
 static int g_hw_queue_depth = 64;
 module_param_named(hw_queue_depth, g_hw_queue_depth, int, 0444);
 MODULE_PARM_DESC(hw_queue_depth, "Queue depth for each hardware queue. Default: 64");
@@ -403,6 +421,10 @@ static int nullb_apply_poll_queues(struct nullb_device *dev,
 
 NULLB_DEVICE_ATTR(size, ulong, NULL);
 NULLB_DEVICE_ATTR(completion_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(completion_dist, uint, NULL);
+NULLB_DEVICE_ATTR(completion_slow_nsec, ulong, NULL);
+NULLB_DEVICE_ATTR(completion_slow_pct, uint, NULL);
+NULLB_DEVICE_ATTR(completion_sigma, uint, NULL);
 NULLB_DEVICE_ATTR(submit_queues, uint, nullb_apply_submit_queues);
 NULLB_DEVICE_ATTR(poll_queues, uint, nullb_apply_poll_queues);
 NULLB_DEVICE_ATTR(home_node, uint, NULL);
@@ -526,6 +548,10 @@ CONFIGFS_ATTR(nullb_device_, badblocks);
 static struct configfs_attribute *nullb_device_attrs[] = {
 	&nullb_device_attr_size,
 	&nullb_device_attr_completion_nsec,
+	&nullb_device_attr_completion_dist,
+	&nullb_device_attr_completion_slow_nsec,
+	&nullb_device_attr_completion_slow_pct,
+	&nullb_device_attr_completion_sigma,
 	&nullb_device_attr_submit_queues,
 	&nullb_device_attr_poll_queues,
 	&nullb_device_attr_home_node,
@@ -609,7 +635,9 @@ static ssize_t memb_group_features_show(struct config_item *item, char *page)
 {
 	return snprintf(page, PAGE_SIZE,
 			"badblocks,blocking,blocksize,cache_size,"
-			"completion_nsec,discard,home_node,hw_queue_depth,"
+			"completion_dist,completion_nsec,completion_sigma,"
+			"completion_slow_nsec,completion_slow_pct,"
+			"discard,home_node,hw_queue_depth,"
 			"irqmode,max_sectors,mbps,memory_backed,no_sched,"
 			"poll_queues,power,queue_mode,shared_tag_bitmap,size,"
 			"submit_queues,use_per_node_hctx,virt_boundary,zoned,"
@@ -665,6 +693,10 @@ static struct nullb_device *null_alloc_dev(void)
 
 	dev->size = g_gb * 1024;
 	dev->completion_nsec = g_completion_nsec;
+	dev->completion_dist = g_completion_dist;
+	dev->completion_slow_nsec = g_completion_slow_nsec;
+	dev->completion_slow_pct = g_completion_slow_pct;
+	dev->completion_sigma = g_completion_sigma;
 	dev->submit_queues = g_submit_queues;
 	dev->prev_submit_queues = g_submit_queues;
 	dev->poll_queues = g_poll_queues;
@@ -742,6 +774,7 @@ static struct nullb_cmd *__alloc_cmd(struct nullb_queue *nq)
 		cmd->tag = tag;
 		cmd->error = BLK_STS_OK;
 		cmd->nq = nq;
+		cmd->start_time = ktime_get_ns();
 		if (nq->dev->irqmode == NULL_IRQ_TIMER) {
 			hrtimer_init(&cmd->timer, CLOCK_MONOTONIC,
 				     HRTIMER_MODE_REL);
@@ -774,10 +807,21 @@ static struct nullb_cmd *alloc_cmd(struct nullb_queue *nq, struct bio *bio)
 	} while (1);
 }
 
+static void null_account_cmd(struct nullb_cmd *cmd)
+{
+	struct nullb_queue *nq = cmd->nq;
+	u64 delta = ktime_get_ns() - cmd->start_time;
+
+	nq->lat_hist[min_t(int, ilog2(delta | 1), NULL_LAT_BUCKETS - 1)]++;
+	nq->nr_completed++;
+}
+
 static void end_cmd(struct nullb_cmd *cmd)
 {
 	int queue_mode = cmd->nq->dev->queue_mode;
 
+	null_account_cmd(cmd);
+
 	switch (queue_mode)  {
 	case NULL_Q_MQ:
 		blk_mq_end_request(cmd->rq, cmd->error);
@@ -798,9 +842,47 @@ static enum hrtimer_restart null_cmd_timer_expired(struct hrtimer *timer)
 	return HRTIMER_NORESTART;
 }
 
+/*
+ * Draw a completion time from the configured distribution. The
+ * lognormal mode approximates the normal variate in the log domain
+ * with a centred binomial (popcount of a random word, sigma ~2.83) and
+ * scales completion_nsec by 2^(z * completion_sigma / 8), so sigma is
+ * expressed in eighths of an octave; the defaults give a spread close
+ * to what NVMe read latencies show. Bimodal mode models a slow tail
+ * (cache miss, media retry) hit completion_slow_pct percent of the
+ * time.
+ */
+static u64 null_cmd_nsec(struct nullb_device *dev)
+{
+	static const u16 pow2_frac[8] = {
+		256, 279, 304, 331, 362, 394, 430, 469
+	};
+	u64 nsec = dev->completion_nsec;
+	s32 e;
+
+	switch (dev->completion_dist) {
+	case NULL_DIST_LOGNORMAL:
+		e = ((s32)hweight32(get_random_u32()) - 16) *
+			(s32)dev->completion_sigma;
+		nsec = nsec * pow2_frac[e & 7] >> 8;
+		e >>= 3;
+		if (e >= 0)
+			nsec <<= min_t(s32, e, 16);
+		else
+			nsec >>= min_t(s32, -e, 16);
+		return max_t(u64, nsec, 1);
+	case NULL_DIST_BIMODAL:
+		if (get_random_u32_below(100) < dev->completion_slow_pct)
+			return dev->completion_slow_nsec;
+		return nsec;
+	default:
+		return nsec;
+	}
+}
+
 static void null_cmd_end_timer(struct nullb_cmd *cmd)
 {
-	ktime_t kt = cmd->nq->dev->completion_nsec;
+	ktime_t kt = null_cmd_nsec(cmd->nq->dev);
 
 	hrtimer_start(&cmd->timer, kt, HRTIMER_MODE_REL);
 }
@@ -1605,6 +1687,8 @@ static int null_poll(struct blk_mq_hw_ctx *hctx, struct io_comp_batch *iob)
 		if (!blk_mq_add_to_batch(req, iob, (__force int) cmd->error,
 					blk_mq_end_request_batch))
 			end_cmd(cmd);
+		else
+			null_account_cmd(cmd);
 		nr++;
 	}
 
@@ -1662,6 +1746,7 @@ static blk_status_t null_queue_rq(struct blk_mq_hw_ctx *hctx,
 	cmd->rq = bd->rq;
 	cmd->error = BLK_STS_OK;
 	cmd->nq = nq;
+	cmd->start_time = ktime_get_ns();
 	cmd->fake_timeout = should_timeout_request(bd->rq) ||
 		blk_should_fake_timeout(bd->rq->q);
 
@@ -1755,6 +1840,71 @@ static const struct blk_mq_ops null_mq_ops = {
 	.exit_hctx	= null_exit_hctx,
 };
 
+static struct dentry *null_debugfs_root;
+
+/*
+ * Per-queue completion latency histogram in power-of-two nanosecond
+ * buckets, plus the total number of completions per queue so IOPS can
+ * be derived by sampling the file. Writing anything to the file
+ * clears the counters, which makes interval measurements easy.
+ */
+static int null_lat_hist_show(struct seq_file *m, void *data)
+{
+	struct nullb *nullb = m->private;
+	unsigned int i, b;
+
+	for (i = 0; i < nullb->nr_queues; i++) {
+		struct nullb_queue *nq = &nullb->queues[i];
+
+		seq_printf(m, "queue %u: completed %llu\n",
+			   i, nq->nr_completed);
+		for (b = 0; b < NULL_LAT_BUCKETS; b++) {
+			if (!nq->lat_hist[b])
+				continue;
+			seq_printf(m, "  >=%10lluns: %llu\n",
+				   1ULL << b, nq->lat_hist[b]);
+		}
+	}
+	return 0;
+}
+
+static int null_lat_hist_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, null_lat_hist_show, inode->i_private);
+}
+
+static ssize_t null_lat_hist_write(struct file *file, const char __user *buf,
+				   size_t count, loff_t *ppos)
+{
+	struct nullb *nullb = file_inode(file)->i_private;
+	unsigned int i;
+
+	for (i = 0; i < nullb->nr_queues; i++) {
+		struct nullb_queue *nq = &nullb->queues[i];
+
+		memset(nq->lat_hist, 0, sizeof(nq->lat_hist));
+		nq->nr_completed = 0;
+	}
+	return count;
+}
+
+static const struct file_operations null_lat_hist_fops = {
+	.owner		= THIS_MODULE,
+	.open		= null_lat_hist_open,
+	.read		= seq_read,
+	.write		= null_lat_hist_write,
+	.llseek		= seq_lseek,
+	.release	= single_release,
+};
+
+static void null_debugfs_add_dev(struct nullb *nullb)
+{
+	nullb->debugfs_dir = debugfs_create_dir(nullb->disk_name,
+						null_debugfs_root);
+	debugfs_create_file("latency_hist", 0644, nullb->debugfs_dir,
+			    nullb, &null_lat_hist_fops);
+}
+
 static void null_del_dev(struct nullb *nullb)
 {
 	struct nullb_device *dev;
@@ -1762,6 +1912,8 @@ static void null_del_dev(struct nullb *nullb)
 	if (!nullb)
 		return;
 
+	debugfs_remove_recursive(nullb->debugfs_dir);
+
 	dev = nullb->dev;
 
 	ida_simple_remove(&nullb_indexes, nullb->index);
@@ -2134,6 +2286,8 @@ static int null_add_dev(struct nullb_device *dev)
 	if (rv)
 		goto out_ida_free;
 
+	null_debugfs_add_dev(nullb);
+
 	mutex_lock(&lock);
 	list_add_tail(&nullb->list, &nullb_list);
 	mutex_unlock(&lock);
@@ -2258,6 +2412,8 @@ static int __init null_init(void)
 		goto err_conf;
 	}
 
+	null_debugfs_root = debugfs_create_dir("null_blk", NULL);
+
 	for (i = 0; i < nr_devices; i++) {
 		ret = null_create_dev();
 		if (ret)
@@ -2272,6 +2428,7 @@ err_dev:
 		nullb = list_entry(nullb_list.next, struct nullb, list);
 		null_destroy_dev(nullb);
 	}
+	debugfs_remove_recursive(null_debugfs_root);
 	unregister_blkdev(null_major, "nullb");
 err_conf:
 	configfs_unregister_subsystem(&nullb_subsys);
@@ -2287,6 +2444,7 @@ static void __exit null_exit(void)
 
 	configfs_unregister_subsystem(&nullb_subsys);
 
+	debugfs_remove_recursive(null_debugfs_root);
 	unregister_blkdev(null_major, "nullb");
 
 	mutex_lock(&lock);
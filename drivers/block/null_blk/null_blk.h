@@ -25,8 +25,12 @@ struct nullb_cmd {
 	bool fake_timeout;
 	struct nullb_queue *nq;
 	struct hrtimer timer;
+	u64 start_time;
 };
 
+/* power-of-two nanosecond buckets for the debugfs latency histogram */
+#define NULL_LAT_BUCKETS	32
+
 struct nullb_queue {
 	unsigned long *tag_map;
 	wait_queue_head_t wait;
@@ -38,6 +42,14 @@ struct nullb_queue {
 	spinlock_t poll_lock;
 
 	struct nullb_cmd *cmds;
+
+	/*
+	 * Completion accounting for the debugfs latency histogram.
+	 * Updated locklessly from the completion context, so totals are
+	 * approximate when completions for one queue run concurrently.
+	 */
+	u64 lat_hist[NULL_LAT_BUCKETS];
+	u64 nr_completed;
 };
 
 struct nullb_zone {
@@ -67,6 +79,13 @@ enum {
 	NULL_Q_MQ	= 2,
 };
 
+/* Completion latency distributions, used with irqmode=2 (timer) */
+enum {
+	NULL_DIST_FIXED		= 0,
+	NULL_DIST_LOGNORMAL	= 1,
+	NULL_DIST_BIMODAL	= 2,
+};
+
 struct nullb_device {
 	struct nullb *nullb;
 	struct config_item item;
@@ -88,6 +107,10 @@ struct nullb_device {
 
 	unsigned long size; /* device size in MB */
 	unsigned long completion_nsec; /* time in ns to complete a request */
+	unsigned long completion_slow_nsec; /* slow-mode time for bimodal completion */
+	unsigned int completion_dist; /* completion latency distribution */
+	unsigned int completion_slow_pct; /* percentage of slow bimodal completions */
+	unsigned int completion_sigma; /* lognormal spread, eighths of an octave */
 	unsigned long cache_size; /* disk cache size in MB */
 	unsigned long zone_size; /* zone size in MB if device is zoned */
 	unsigned long zone_capacity; /* zone capacity in MB if device is zoned */
@@ -134,6 +157,7 @@ struct nullb {
 	struct nullb_queue *queues;
 	unsigned int nr_queues;
 	char disk_name[DISK_NAME_LEN];
+	struct dentry *debugfs_dir;
 };
 
 blk_status_t null_handle_discard(struct nullb_device *dev, sector_t sector,
@@ -11,6 +11,8 @@
 #include <linux/sched.h>
 #include <linux/cpu.h>
 #include <linux/crypto.h>
+#include <linux/scatterlist.h>
+#include <crypto/acompress.h>
 
 #include "zcomp.h"
 
@@ -35,29 +37,49 @@ static const char * const backends[] = {
 
 static void zcomp_strm_free(struct zcomp_strm *zstrm)
 {
+	if (zstrm->req)
+		acomp_request_free(zstrm->req);
 	if (!IS_ERR_OR_NULL(zstrm->tfm))
-		crypto_free_comp(zstrm->tfm);
+		crypto_free_acomp(zstrm->tfm);
 	free_pages((unsigned long)zstrm->buffer, 1);
+	zstrm->req = NULL;
 	zstrm->tfm = NULL;
 	zstrm->buffer = NULL;
 }
 
 /*
- * Initialize zcomp_strm structure with ->tfm initialized by backend, and
- * ->buffer. Return a negative value on error.
+ * Initialize zcomp_strm structure with ->tfm and ->req initialized by
+ * backend, and ->buffer. Return a negative value on error.
  */
 static int zcomp_strm_init(struct zcomp_strm *zstrm, struct zcomp *comp)
 {
-	zstrm->tfm = crypto_alloc_comp(comp->name, 0, 0);
+	/*
+	 * Go through the acomp interface so that drivers for hardware
+	 * (de)compression offload engines can be used; software algorithms
+	 * are served by the crypto layer's synchronous scomp wrapper.
+	 * Truly asynchronous implementations must be excluded: requests
+	 * are issued under the per-CPU stream local_lock with atomic
+	 * kmaps live in the callers, so waiting for -EINPROGRESS
+	 * completion would sleep in atomic context.
+	 */
+	zstrm->tfm = crypto_alloc_acomp(comp->name, 0, CRYPTO_ALG_ASYNC);
+	if (!IS_ERR_OR_NULL(zstrm->tfm))
+		zstrm->req = acomp_request_alloc(zstrm->tfm);
 	/*
 	 * allocate 2 pages. 1 for compressed data, plus 1 extra for the
 	 * case when compressed size is larger than the original one
 	 */
 	zstrm->buffer = (void *)__get_free_pages(GFP_KERNEL | __GFP_ZERO, 1);
-	if (IS_ERR_OR_NULL(zstrm->tfm) || !zstrm->buffer) {
+	if (IS_ERR_OR_NULL(zstrm->tfm) || !zstrm->req || !zstrm->buffer) {
 		zcomp_strm_free(zstrm);
 		return -ENOMEM;
 	}
+
+	crypto_init_wait(&zstrm->wait);
+	acomp_request_set_callback(zstrm->req,
+				   CRYPTO_TFM_REQ_MAY_BACKLOG |
+				   CRYPTO_TFM_REQ_MAY_SLEEP,
+				   crypto_req_done, &zstrm->wait);
 	return 0;
 }
 
@@ -70,7 +92,7 @@ bool zcomp_available_algorithm(const char *comp)
 	 * This also means that we permit zcomp initialisation
 	 * with any compressing algorithm known to crypto api.
 	 */
-	return crypto_has_comp(comp, 0, 0) == 1;
+	return crypto_has_acomp(comp, 0, CRYPTO_ALG_ASYNC);
 }
 
 /* show available compressors */
@@ -95,7 +117,7 @@ ssize_t zcomp_available_show(const char *comp, char *buf)
 	 * Out-of-tree module known to crypto api or a missing
 	 * entry in `backends'.
 	 */
-	if (!known_algorithm && crypto_has_comp(comp, 0, 0) == 1)
+	if (!known_algorithm && crypto_has_acomp(comp, 0, CRYPTO_ALG_ASYNC))
 		sz += scnprintf(buf + sz, PAGE_SIZE - sz - 2,
 				"[%s] ", comp);
 
@@ -131,21 +153,32 @@ int zcomp_compress(struct zcomp_strm *zstrm,
 	 * the dst buffer, zram_drv will take care of the fact that
 	 * compressed buffer is too big.
 	 */
-	*dst_len = PAGE_SIZE * 2;
+	struct scatterlist sg_src, sg_dst;
+	int ret;
 
-	return crypto_comp_compress(zstrm->tfm,
-			src, PAGE_SIZE,
-			zstrm->buffer, dst_len);
+	sg_init_one(&sg_src, src, PAGE_SIZE);
+	sg_init_one(&sg_dst, zstrm->buffer, PAGE_SIZE * 2);
+	acomp_request_set_params(zstrm->req, &sg_src, &sg_dst,
+				 PAGE_SIZE, PAGE_SIZE * 2);
+
+	ret = crypto_wait_req(crypto_acomp_compress(zstrm->req), &zstrm->wait);
+	*dst_len = zstrm->req->dlen;
+
+	return ret;
 }
 
 int zcomp_decompress(struct zcomp_strm *zstrm,
 		const void *src, unsigned int src_len, void *dst)
 {
-	unsigned int dst_len = PAGE_SIZE;
+	struct scatterlist sg_src, sg_dst;
+
+	sg_init_one(&sg_src, (void *)src, src_len);
+	sg_init_one(&sg_dst, dst, PAGE_SIZE);
+	acomp_request_set_params(zstrm->req, &sg_src, &sg_dst,
+				 src_len, PAGE_SIZE);
 
-	return crypto_comp_decompress(zstrm->tfm,
-			src, src_len,
-			dst, &dst_len);
+	return crypto_wait_req(crypto_acomp_decompress(zstrm->req),
+			       &zstrm->wait);
 }
 
 int zcomp_cpu_up_prepare(unsigned int cpu, struct hlist_node *node)
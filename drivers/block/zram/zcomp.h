@@ -6,13 +6,17 @@
 #ifndef _ZCOMP_H_
 #define _ZCOMP_H_
 #include <linux/local_lock.h>
+#include <linux/crypto.h>
+#include <crypto/acompress.h>
 
 struct zcomp_strm {
-	/* The members ->buffer and ->tfm are protected by ->lock. */
+	/* The members ->buffer and ->req are protected by ->lock. */
 	local_lock_t lock;
 	/* compression/decompression buffer */
 	void *buffer;
-	struct crypto_comp *tfm;
+	struct crypto_acomp *tfm;
+	struct acomp_req *req;
+	struct crypto_wait wait;
 };
 
 /* dynamic per-device compression frontend */
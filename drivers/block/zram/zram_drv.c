@@ -33,6 +33,8 @@
 #include <linux/debugfs.h>
 #include <linux/cpuhotplug.h>
 #include <linux/part_stat.h>
+#include <linux/rbtree.h>
+#include <linux/xxhash.h>
 
 #include "zram_drv.h"
 
@@ -143,6 +145,250 @@ static inline bool zram_allocated(struct zram *zram, u32 index)
 			zram_test_flag(zram, index, ZRAM_WB);
 }
 
+#ifdef CONFIG_ZRAM_DEDUP
+/*
+ * Objects whose compressed bytes hash to the same xxh64 value are
+ * indexed once and shared between slots. ->csum_node keys the entry by
+ * checksum for lookups on the write path, ->handle_node keys it by the
+ * (unique) zsmalloc handle so the free path never has to re-hash the
+ * stored data. An entry holds one reference per slot that carries
+ * ZRAM_DEDUPED; the object is returned to zsmalloc when the last such
+ * slot is freed.
+ */
+struct zram_dedup_entry {
+	struct rb_node csum_node;
+	struct rb_node handle_node;
+	u64 checksum;
+	unsigned long handle;
+	unsigned int len;
+	unsigned int refcount;
+};
+
+static void zram_dedup_put(struct zram *zram, unsigned long handle);
+
+static struct zram_dedup_entry *zram_dedup_find_csum(struct zram *zram,
+						     u64 checksum)
+{
+	struct rb_node *node = zram->dedup_csum_tree.rb_node;
+
+	while (node) {
+		struct zram_dedup_entry *entry;
+
+		entry = rb_entry(node, struct zram_dedup_entry, csum_node);
+		if (checksum < entry->checksum)
+			node = node->rb_left;
+		else if (checksum > entry->checksum)
+			node = node->rb_right;
+		else
+			return entry;
+	}
+	return NULL;
+}
+
+static struct zram_dedup_entry *zram_dedup_find_handle(struct zram *zram,
+						       unsigned long handle)
+{
+	struct rb_node *node = zram->dedup_handle_tree.rb_node;
+
+	while (node) {
+		struct zram_dedup_entry *entry;
+
+		entry = rb_entry(node, struct zram_dedup_entry, handle_node);
+		if (handle < entry->handle)
+			node = node->rb_left;
+		else if (handle > entry->handle)
+			node = node->rb_right;
+		else
+			return entry;
+	}
+	return NULL;
+}
+
+/*
+ * Look up a stored object matching @buf/@len. On a hit the entry gains
+ * a reference and its handle is returned; the caller stores it and sets
+ * ZRAM_DEDUPED on the slot. Returns 0 on a miss, with *checksum filled
+ * in for a later zram_dedup_insert() of the newly allocated object.
+ */
+static unsigned long zram_dedup_match(struct zram *zram, const void *buf,
+				      unsigned int len, u64 *checksum)
+{
+	struct zram_dedup_entry *entry;
+	unsigned long handle = 0;
+	void *obj;
+
+	*checksum = xxh64(buf, len, 0);
+
+	spin_lock(&zram->dedup_lock);
+	entry = zram_dedup_find_csum(zram, *checksum);
+	if (entry && entry->len == len) {
+		obj = zs_map_object(zram->mem_pool, entry->handle, ZS_MM_RO);
+		if (!memcmp(obj, buf, len)) {
+			entry->refcount++;
+			handle = entry->handle;
+			atomic64_inc(&zram->stats.dedup_hits);
+		}
+		zs_unmap_object(zram->mem_pool, entry->handle);
+	}
+	spin_unlock(&zram->dedup_lock);
+
+	return handle;
+}
+
+/*
+ * Index a freshly stored object. Returns true when the slot now shares
+ * the object through the index (and must carry ZRAM_DEDUPED); false
+ * when the checksum is already taken or no memory was available, in
+ * which case the slot owns its object exclusively as before.
+ */
+static bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+			      unsigned int len, u64 checksum)
+{
+	struct zram_dedup_entry *entry, *cur;
+	struct rb_node **link, *parent = NULL;
+
+	entry = kmalloc(sizeof(*entry), GFP_NOIO | __GFP_NOWARN);
+	if (!entry)
+		return false;
+
+	entry->checksum = checksum;
+	entry->handle = handle;
+	entry->len = len;
+	entry->refcount = 1;
+
+	spin_lock(&zram->dedup_lock);
+	link = &zram->dedup_csum_tree.rb_node;
+	while (*link) {
+		parent = *link;
+		cur = rb_entry(parent, struct zram_dedup_entry, csum_node);
+		if (checksum < cur->checksum) {
+			link = &parent->rb_left;
+		} else if (checksum > cur->checksum) {
+			link = &parent->rb_right;
+		} else {
+			/* raced with an identical store; keep the first */
+			spin_unlock(&zram->dedup_lock);
+			kfree(entry);
+			return false;
+		}
+	}
+	rb_link_node(&entry->csum_node, parent, link);
+	rb_insert_color(&entry->csum_node, &zram->dedup_csum_tree);
+
+	parent = NULL;
+	link = &zram->dedup_handle_tree.rb_node;
+	while (*link) {
+		parent = *link;
+		cur = rb_entry(parent, struct zram_dedup_entry, handle_node);
+		if (handle < cur->handle)
+			link = &parent->rb_left;
+		else
+			link = &parent->rb_right;
+	}
+	rb_link_node(&entry->handle_node, parent, link);
+	rb_insert_color(&entry->handle_node, &zram->dedup_handle_tree);
+	spin_unlock(&zram->dedup_lock);
+
+	return true;
+}
+
+/*
+ * Called from zram_free_page() for a ZRAM_DEDUPED slot: clear the flag
+ * and drop the slot's reference. Returns true when it took care of the
+ * object (it is freed with the last reference); false means the caller
+ * owns the object and must zs_free() it itself.
+ */
+static bool zram_dedup_free(struct zram *zram, u32 index, unsigned long handle)
+{
+	if (!zram_test_flag(zram, index, ZRAM_DEDUPED))
+		return false;
+	zram_clear_flag(zram, index, ZRAM_DEDUPED);
+	zram_dedup_put(zram, handle);
+	return true;
+}
+
+/* Drop one slot's reference; frees the object when it was the last. */
+static void zram_dedup_put(struct zram *zram, unsigned long handle)
+{
+	struct zram_dedup_entry *entry;
+
+	spin_lock(&zram->dedup_lock);
+	entry = zram_dedup_find_handle(zram, handle);
+	if (WARN_ON_ONCE(!entry)) {
+		spin_unlock(&zram->dedup_lock);
+		zs_free(zram->mem_pool, handle);
+		return;
+	}
+	if (--entry->refcount) {
+		spin_unlock(&zram->dedup_lock);
+		return;
+	}
+	rb_erase(&entry->csum_node, &zram->dedup_csum_tree);
+	rb_erase(&entry->handle_node, &zram->dedup_handle_tree);
+	spin_unlock(&zram->dedup_lock);
+
+	kfree(entry);
+	zs_free(zram->mem_pool, handle);
+}
+
+static void zram_dedup_init(struct zram *zram)
+{
+	zram->dedup_csum_tree = RB_ROOT;
+	zram->dedup_handle_tree = RB_ROOT;
+	spin_lock_init(&zram->dedup_lock);
+}
+#else
+static unsigned long zram_dedup_match(struct zram *zram, const void *buf,
+				      unsigned int len, u64 *checksum)
+{
+	return 0;
+}
+
+static bool zram_dedup_insert(struct zram *zram, unsigned long handle,
+			      unsigned int len, u64 checksum)
+{
+	return false;
+}
+
+static bool zram_dedup_free(struct zram *zram, u32 index, unsigned long handle)
+{
+	return false;
+}
+
+static void zram_dedup_init(struct zram *zram)
+{
+}
+#endif
+
+/*
+ * Sampled Shannon-entropy estimate in integer arithmetic: looking at
+ * every 8th byte costs 512 loads per page, and floor-log2 bucket counts
+ * give entropy * ZRAM_ENTROPY_SAMPLES without any divisions. Pages
+ * estimated above 7 bits per byte are effectively random (encrypted or
+ * already compressed) and go straight to the incompressible path,
+ * saving the wasted compressor pass.
+ */
+#define ZRAM_ENTROPY_SAMPLES	(PAGE_SIZE / 8)
+#define ZRAM_ENTROPY_THRESHOLD	(ZRAM_ENTROPY_SAMPLES * 7)
+
+static bool zram_page_incompressible(const void *mem)
+{
+	const u8 *data = mem;
+	u16 counts[256] = { };
+	unsigned int ent = 0;
+	unsigned int i;
+
+	for (i = 0; i < PAGE_SIZE; i += 8)
+		counts[data[i]]++;
+
+	for (i = 0; i < 256; i++)
+		if (counts[i])
+			ent += counts[i] * ilog2(counts[i]);
+	ent = ZRAM_ENTROPY_SAMPLES * ilog2(ZRAM_ENTROPY_SAMPLES) - ent;
+
+	return ent > ZRAM_ENTROPY_THRESHOLD;
+}
+
 #if PAGE_SIZE != 4096
 static inline bool is_partial_io(struct bio_vec *bvec)
 {
@@ -633,6 +879,160 @@ static int read_from_bdev_async(struct zram *zram, struct bio_vec *bvec,
 #define HUGE_WRITEBACK (1<<0)
 #define IDLE_WRITEBACK (1<<1)
 
+/* pages staged per writeback batch before the bios are submitted */
+#define ZRAM_WB_BATCH_PAGES 32
+
+struct zram_wb_batch;
+
+struct zram_wb_entry {
+	struct zram_wb_batch *batch;
+	unsigned long index;
+	unsigned long blk_idx;
+	struct page *page;
+	struct bio bio;
+	struct bio_vec bio_vec;
+	int err;
+};
+
+struct zram_wb_batch {
+	struct zram_wb_entry entries[ZRAM_WB_BATCH_PAGES];
+	unsigned int nr;
+	atomic_t pending;
+	struct completion done;
+};
+
+static void zram_writeback_endio(struct bio *bio)
+{
+	struct zram_wb_entry *entry = container_of(bio, struct zram_wb_entry,
+						   bio);
+	struct zram_wb_batch *batch = entry->batch;
+
+	entry->err = blk_status_to_errno(bio->bi_status);
+	if (atomic_dec_and_test(&batch->pending))
+		complete(&batch->done);
+}
+
+static void zram_writeback_free_batch(struct zram_wb_batch *batch)
+{
+	unsigned int i;
+
+	if (!batch)
+		return;
+
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES; i++)
+		if (batch->entries[i].page)
+			__free_page(batch->entries[i].page);
+	kvfree(batch);
+}
+
+static struct zram_wb_batch *zram_writeback_alloc_batch(void)
+{
+	struct zram_wb_batch *batch;
+	unsigned int i;
+
+	batch = kvzalloc(sizeof(*batch), GFP_KERNEL);
+	if (!batch)
+		return NULL;
+
+	for (i = 0; i < ZRAM_WB_BATCH_PAGES; i++) {
+		batch->entries[i].page = alloc_page(GFP_KERNEL);
+		if (!batch->entries[i].page)
+			goto free_batch;
+		batch->entries[i].batch = batch;
+	}
+	init_completion(&batch->done);
+	return batch;
+
+free_batch:
+	zram_writeback_free_batch(batch);
+	return NULL;
+}
+
+static int zram_writeback_complete(struct zram *zram,
+				   struct zram_wb_entry *entry)
+{
+	unsigned long blk_idx = entry->blk_idx;
+	unsigned long index = entry->index;
+
+	if (entry->err) {
+		zram_slot_lock(zram, index);
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_clear_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+		free_block_bdev(zram, blk_idx);
+		return entry->err;
+	}
+
+	atomic64_inc(&zram->stats.bd_writes);
+	/*
+	 * We released zram_slot_lock so need to check if the slot was
+	 * changed. If there is freeing for the slot, we can catch it
+	 * easily by zram_allocated.
+	 * A subtle case is the slot is freed/reallocated/marked as
+	 * ZRAM_IDLE again. To close the race, idle_store doesn't
+	 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
+	 * Thus, we could close the race by checking ZRAM_IDLE bit.
+	 */
+	zram_slot_lock(zram, index);
+	if (!zram_allocated(zram, index) ||
+	    !zram_test_flag(zram, index, ZRAM_IDLE)) {
+		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+		zram_clear_flag(zram, index, ZRAM_IDLE);
+		zram_slot_unlock(zram, index);
+		free_block_bdev(zram, blk_idx);
+		return 0;
+	}
+
+	zram_free_page(zram, index);
+	zram_clear_flag(zram, index, ZRAM_UNDER_WB);
+	zram_set_flag(zram, index, ZRAM_WB);
+	zram_set_element(zram, index, blk_idx);
+	atomic64_inc(&zram->stats.pages_stored);
+	zram_slot_unlock(zram, index);
+
+	spin_lock(&zram->wb_limit_lock);
+	if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
+		zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
+	spin_unlock(&zram->wb_limit_lock);
+
+	return 0;
+}
+
+/*
+ * Submit every staged page in one plugged burst, then finish the slots
+ * in staging order. Returns the last IO error, or 0 when all pages hit
+ * the backing device.
+ */
+static int zram_writeback_flush_batch(struct zram *zram,
+				      struct zram_wb_batch *batch)
+{
+	struct blk_plug plug;
+	int ret = 0, err;
+	unsigned int i;
+
+	if (!batch->nr)
+		return 0;
+
+	reinit_completion(&batch->done);
+	atomic_set(&batch->pending, batch->nr);
+
+	blk_start_plug(&plug);
+	for (i = 0; i < batch->nr; i++)
+		submit_bio(&batch->entries[i].bio);
+	blk_finish_plug(&plug);
+
+	wait_for_completion_io(&batch->done);
+
+	for (i = 0; i < batch->nr; i++) {
+		err = zram_writeback_complete(zram, &batch->entries[i]);
+		if (err)
+			ret = err;
+	}
+	batch->nr = 0;
+
+	return ret;
+}
+
 
 static ssize_t writeback_store(struct device *dev,
 		struct device_attribute *attr, const char *buf, size_t len)
@@ -640,9 +1040,8 @@ static ssize_t writeback_store(struct device *dev,
 	struct zram *zram = dev_to_zram(dev);
 	unsigned long nr_pages = zram->disksize >> PAGE_SHIFT;
 	unsigned long index = 0;
-	struct bio bio;
-	struct bio_vec bio_vec;
-	struct page *page;
+	struct zram_wb_batch *batch;
+	struct zram_wb_entry *entry;
 	ssize_t ret = len;
 	int mode, err;
 	unsigned long blk_idx = 0;
@@ -676,8 +1075,8 @@ static ssize_t writeback_store(struct device *dev,
 		goto release_init_lock;
 	}
 
-	page = alloc_page(GFP_KERNEL);
-	if (!page) {
+	batch = zram_writeback_alloc_batch();
+	if (!batch) {
 		ret = -ENOMEM;
 		goto release_init_lock;
 	}
@@ -685,7 +1084,8 @@ static ssize_t writeback_store(struct device *dev,
 	for (; nr_pages != 0; index++, nr_pages--) {
 		struct bio_vec bvec;
 
-		bvec.bv_page = page;
+		entry = &batch->entries[batch->nr];
+		bvec.bv_page = entry->page;
 		bvec.bv_len = PAGE_SIZE;
 		bvec.bv_offset = 0;
 
@@ -736,65 +1136,45 @@ static ssize_t writeback_store(struct device *dev,
 			continue;
 		}
 
-		bio_init(&bio, zram->bdev, &bio_vec, 1,
+		entry->index = index;
+		entry->blk_idx = blk_idx;
+		entry->err = 0;
+		bio_init(&entry->bio, zram->bdev, &entry->bio_vec, 1,
 			 REQ_OP_WRITE | REQ_SYNC);
-		bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+		entry->bio.bi_iter.bi_sector = blk_idx * (PAGE_SIZE >> 9);
+		entry->bio.bi_end_io = zram_writeback_endio;
 
-		bio_add_page(&bio, bvec.bv_page, bvec.bv_len,
+		bio_add_page(&entry->bio, bvec.bv_page, bvec.bv_len,
 				bvec.bv_offset);
+		blk_idx = 0;
+		batch->nr++;
+
 		/*
-		 * XXX: A single page IO would be inefficient for write
-		 * but it would be not bad as starter.
+		 * Stage pages until the batch is full so the backing
+		 * device sees a plugged burst instead of synchronous
+		 * single-page writes.
 		 */
-		err = submit_bio_wait(&bio);
-		if (err) {
-			zram_slot_lock(zram, index);
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			zram_slot_unlock(zram, index);
+		if (batch->nr == ZRAM_WB_BATCH_PAGES) {
 			/*
 			 * Return last IO error unless every IO were
 			 * not suceeded.
 			 */
-			ret = err;
-			continue;
+			err = zram_writeback_flush_batch(zram, batch);
+			if (err)
+				ret = err;
 		}
-
-		atomic64_inc(&zram->stats.bd_writes);
-		/*
-		 * We released zram_slot_lock so need to check if the slot was
-		 * changed. If there is freeing for the slot, we can catch it
-		 * easily by zram_allocated.
-		 * A subtle case is the slot is freed/reallocated/marked as
-		 * ZRAM_IDLE again. To close the race, idle_store doesn't
-		 * mark ZRAM_IDLE once it found the slot was ZRAM_UNDER_WB.
-		 * Thus, we could close the race by checking ZRAM_IDLE bit.
-		 */
-		zram_slot_lock(zram, index);
-		if (!zram_allocated(zram, index) ||
-			  !zram_test_flag(zram, index, ZRAM_IDLE)) {
-			zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-			zram_clear_flag(zram, index, ZRAM_IDLE);
-			goto next;
-		}
-
-		zram_free_page(zram, index);
-		zram_clear_flag(zram, index, ZRAM_UNDER_WB);
-		zram_set_flag(zram, index, ZRAM_WB);
-		zram_set_element(zram, index, blk_idx);
-		blk_idx = 0;
-		atomic64_inc(&zram->stats.pages_stored);
-		spin_lock(&zram->wb_limit_lock);
-		if (zram->wb_limit_enable && zram->bd_wb_limit > 0)
-			zram->bd_wb_limit -=  1UL << (PAGE_SHIFT - 12);
-		spin_unlock(&zram->wb_limit_lock);
+		continue;
 next:
 		zram_slot_unlock(zram, index);
 	}
 
+	err = zram_writeback_flush_batch(zram, batch);
+	if (err)
+		ret = err;
+
 	if (blk_idx)
 		free_block_bdev(zram, blk_idx);
-	__free_page(page);
+	zram_writeback_free_batch(batch);
 release_init_lock:
 	up_read(&zram->init_lock);
 
@@ -1135,16 +1515,23 @@ static ssize_t bd_stat_show(struct device *dev,
 static ssize_t debug_stat_show(struct device *dev,
 		struct device_attribute *attr, char *buf)
 {
-	int version = 1;
+	int version = 2;
 	struct zram *zram = dev_to_zram(dev);
+	u64 dedup_hits = 0;
 	ssize_t ret;
 
+#ifdef CONFIG_ZRAM_DEDUP
+	dedup_hits = atomic64_read(&zram->stats.dedup_hits);
+#endif
+
 	down_read(&zram->init_lock);
 	ret = scnprintf(buf, PAGE_SIZE,
-			"version: %d\n%8llu %8llu\n",
+			"version: %d\n%8llu %8llu %8llu %8llu\n",
 			version,
 			(u64)atomic64_read(&zram->stats.writestall),
-			(u64)atomic64_read(&zram->stats.miss_free));
+			(u64)atomic64_read(&zram->stats.miss_free),
+			(u64)atomic64_read(&zram->stats.bypass_pages),
+			dedup_hits);
 	up_read(&zram->init_lock);
 
 	return ret;
@@ -1230,7 +1617,8 @@ static void zram_free_page(struct zram *zram, size_t index)
 	if (!handle)
 		return;
 
-	zs_free(zram->mem_pool, handle);
+	if (!zram_dedup_free(zram, index, handle))
+		zs_free(zram->mem_pool, handle);
 
 	atomic64_sub(zram_get_obj_size(zram, index),
 			&zram->stats.compr_data_size);
@@ -1351,6 +1739,9 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 	struct page *page = bvec->bv_page;
 	unsigned long element = 0;
 	enum zram_pageflags flags = 0;
+	bool deduped = false;
+	u64 checksum = 0;
+	bool bypass;
 
 	mem = kmap_atomic(page);
 	if (page_same_filled(mem, &element)) {
@@ -1360,23 +1751,49 @@ static int __zram_bvec_write(struct zram *zram, struct bio_vec *bvec,
 		atomic64_inc(&zram->stats.same_pages);
 		goto out;
 	}
+	bypass = zram_page_incompressible(mem);
 	kunmap_atomic(mem);
 
+	if (bypass)
+		atomic64_inc(&zram->stats.bypass_pages);
+
 compress_again:
 	zstrm = zcomp_stream_get(zram->comp);
-	src = kmap_atomic(page);
-	ret = zcomp_compress(zstrm, src, &comp_len);
-	kunmap_atomic(src);
+	if (bypass) {
+		/* effectively random content; store it raw right away */
+		comp_len = PAGE_SIZE;
+	} else {
+		src = kmap_atomic(page);
+		ret = zcomp_compress(zstrm, src, &comp_len);
+		kunmap_atomic(src);
 
-	if (unlikely(ret)) {
-		zcomp_stream_put(zram->comp);
-		pr_err("Compression failed! err=%d\n", ret);
-		zs_free(zram->mem_pool, handle);
-		return ret;
+		if (unlikely(ret)) {
+			zcomp_stream_put(zram->comp);
+			pr_err("Compression failed! err=%d\n", ret);
+			zs_free(zram->mem_pool, handle);
+			return ret;
+		}
+
+		if (comp_len >= huge_class_size)
+			comp_len = PAGE_SIZE;
 	}
 
-	if (comp_len >= huge_class_size)
-		comp_len = PAGE_SIZE;
+	if (comp_len != PAGE_SIZE) {
+		unsigned long dup;
+
+		dup = zram_dedup_match(zram, zstrm->buffer, comp_len,
+				       &checksum);
+		if (dup) {
+			zcomp_stream_put(zram->comp);
+			/* drop a handle pre-allocated by the slow path */
+			if (!IS_ERR((void *)handle))
+				zs_free(zram->mem_pool, handle);
+			handle = dup;
+			deduped = true;
+			atomic64_add(comp_len, &zram->stats.compr_data_size);
+			goto out;
+		}
+	}
 	/*
 	 * handle allocation has 2 paths:
 	 * a) fast path is executed with preemption disabled (for
@@ -1438,6 +1855,9 @@ compress_again:
 	zcomp_stream_put(zram->comp);
 	zs_unmap_object(zram->mem_pool, handle);
 	atomic64_add(comp_len, &zram->stats.compr_data_size);
+
+	if (comp_len != PAGE_SIZE)
+		deduped = zram_dedup_insert(zram, handle, comp_len, checksum);
 out:
 	/*
 	 * Free memory associated with this sector
@@ -1459,6 +1879,10 @@ out:
 		zram_set_handle(zram, index, handle);
 		zram_set_obj_size(zram, index, comp_len);
 	}
+#ifdef CONFIG_ZRAM_DEDUP
+	if (deduped)
+		zram_set_flag(zram, index, ZRAM_DEDUPED);
+#endif
 	zram_slot_unlock(zram, index);
 
 	/* Update stats */
@@ -1907,6 +2331,7 @@ static int zram_add(void)
 	device_id = ret;
 
 	init_rwsem(&zram->init_lock);
+	zram_dedup_init(zram);
 #ifdef CONFIG_ZRAM_WRITEBACK
 	spin_lock_init(&zram->wb_limit_lock);
 #endif
@@ -49,6 +49,9 @@ enum zram_pageflags {
 	ZRAM_UNDER_WB,	/* page is under writeback */
 	ZRAM_HUGE,	/* Incompressible page */
 	ZRAM_IDLE,	/* not accessed page since last idle marking */
+#ifdef CONFIG_ZRAM_DEDUP
+	ZRAM_DEDUPED,	/* page shares its object through the dedup index */
+#endif
 
 	__NR_ZRAM_PAGEFLAGS,
 };
@@ -82,6 +85,10 @@ struct zram_stats {
 	atomic_long_t max_used_pages;	/* no. of maximum pages stored */
 	atomic64_t writestall;		/* no. of write slow paths */
 	atomic64_t miss_free;		/* no. of missed free */
+	atomic64_t bypass_pages;	/* no. of skipped compression attempts */
+#ifdef CONFIG_ZRAM_DEDUP
+	atomic64_t dedup_hits;		/* no. of writes served from the index */
+#endif
 #ifdef	CONFIG_ZRAM_WRITEBACK
 	atomic64_t bd_count;		/* no. of pages in backing device */
 	atomic64_t bd_reads;		/* no. of reads from backing device */
@@ -108,6 +115,12 @@ struct zram {
 	 */
 	u64 disksize;	/* bytes */
 	char compressor[CRYPTO_MAX_ALG_NAME];
+#ifdef CONFIG_ZRAM_DEDUP
+	/* both trees index the same entries; ->dedup_lock covers them */
+	struct rb_root dedup_csum_tree;
+	struct rb_root dedup_handle_tree;
+	spinlock_t dedup_lock;
+#endif
 	/*
 	 * zram is claimed so open request will be failed
 	 */
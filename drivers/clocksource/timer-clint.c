@@ -45,8 +45,13 @@ static void clint_send_ipi(const struct cpumask *target)
 {
 	unsigned int cpu;
 
+	/*
+	 * One fence ordering prior stores against all the IPI writes,
+	 * instead of the fence writel() would issue per target hart.
+	 */
+	mb();
 	for_each_cpu(cpu, target)
-		writel(1, clint_ipi_base + cpuid_to_hartid_map(cpu));
+		writel_relaxed(1, clint_ipi_base + cpuid_to_hartid_map(cpu));
 }
 
 static void clint_clear_ipi(void)
@@ -98,22 +103,53 @@ static struct clocksource clint_clocksource = {
 	.read		= clint_rdtime,
 };
 
+/* Deadline currently programmed into this hart's mtimecmp */
+static DEFINE_PER_CPU(u64, clint_next_event);
+
 static int clint_clock_next_event(unsigned long delta,
 				   struct clock_event_device *ce)
 {
 	void __iomem *r = clint_timer_cmp +
 			  cpuid_to_hartid_map(smp_processor_id());
+	u64 deadline;
+
+	/*
+	 * get_cycles64() is rdtime when the kernel runs in S-mode, which
+	 * avoids an MMIO round trip per reprogram; in M-mode it reads the
+	 * same mtime word this driver registers as clocksource.
+	 */
+	deadline = get_cycles64() + delta;
 
 	csr_set(CSR_IE, IE_TIE);
-	writeq_relaxed(clint_get_cycles64() + delta, r);
+	this_cpu_write(clint_next_event, deadline);
+	writeq_relaxed(deadline, r);
+	return 0;
+}
+
+static int clint_clock_shutdown(struct clock_event_device *ce)
+{
+	void __iomem *r = clint_timer_cmp +
+			  cpuid_to_hartid_map(smp_processor_id());
+
+	csr_clear(CSR_IE, IE_TIE);
+	/*
+	 * Park mtimecmp so a stale deadline cannot wake the hart out of
+	 * idle; skip the write when it is already parked.
+	 */
+	if (this_cpu_read(clint_next_event) != U64_MAX) {
+		this_cpu_write(clint_next_event, U64_MAX);
+		writeq_relaxed(U64_MAX, r);
+	}
 	return 0;
 }
 
 static DEFINE_PER_CPU(struct clock_event_device, clint_clock_event) = {
-	.name		= "clint_clockevent",
-	.features	= CLOCK_EVT_FEAT_ONESHOT,
-	.rating		= 100,
-	.set_next_event	= clint_clock_next_event,
+	.name			= "clint_clockevent",
+	.features		= CLOCK_EVT_FEAT_ONESHOT,
+	.rating			= 100,
+	.set_next_event		= clint_clock_next_event,
+	.set_state_shutdown	= clint_clock_shutdown,
+	.set_state_oneshot_stopped = clint_clock_shutdown,
 };
 
 static int clint_timer_starting_cpu(unsigned int cpu)
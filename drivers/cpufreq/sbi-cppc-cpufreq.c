@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * CPU frequency scaling through the SBI CPPC extension.
+ *
+ * The SBI CPPC registers belong to the calling hart and a desired
+ * performance write is a single ecall with no locks taken, so unlike
+ * the clk/regulator path of cpufreq-dt this backend can offer
+ * fast_switch() to schedutil and retune frequency from the scheduler
+ * tick itself.
+ *
+ * Performance values are translated to frequencies by linear
+ * interpolation between the lowest and nominal operating points when
+ * the firmware implements the frequency registers, and are taken as
+ * kHz directly otherwise.
+ */
+
+#define pr_fmt(fmt)	KBUILD_MODNAME ": " fmt
+
+#include <linux/cpu.h>
+#include <linux/cpufreq.h>
+#include <linux/init.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/percpu.h>
+#include <linux/smp.h>
+
+#include <asm/sbi.h>
+
+struct sbi_cppc_cpudata {
+	u32 highest_perf;
+	u32 nominal_perf;
+	u32 lowest_perf;
+	u32 lowest_freq_khz;
+	u32 nominal_freq_khz;
+	u32 desired_perf;
+	/* Firmware has no frequency registers, perf values are kHz. */
+	bool perf_is_khz;
+	u32 transition_latency_ns;
+};
+
+static DEFINE_PER_CPU(struct sbi_cppc_cpudata, sbi_cppc_cpudata);
+
+static int sbi_cppc_read(u32 reg, u64 *val)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_CPPC, SBI_EXT_CPPC_READ, reg, 0, 0, 0, 0, 0);
+	if (ret.error)
+		return sbi_err_map_linux_errno(ret.error);
+	*val = ret.value;
+
+	if (IS_ENABLED(CONFIG_32BIT)) {
+		ret = sbi_ecall(SBI_EXT_CPPC, SBI_EXT_CPPC_READ_HI, reg,
+				0, 0, 0, 0, 0);
+		if (ret.error)
+			return sbi_err_map_linux_errno(ret.error);
+		*val |= (u64)ret.value << 32;
+	}
+
+	return 0;
+}
+
+static int sbi_cppc_write(u32 reg, u64 val)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_CPPC, SBI_EXT_CPPC_WRITE, reg, val,
+			0, 0, 0, 0);
+
+	return ret.error ? sbi_err_map_linux_errno(ret.error) : 0;
+}
+
+static bool sbi_cppc_reg_implemented(u32 reg)
+{
+	struct sbiret ret;
+
+	ret = sbi_ecall(SBI_EXT_CPPC, SBI_EXT_CPPC_PROBE, reg, 0, 0, 0, 0, 0);
+
+	return !ret.error && ret.value;
+}
+
+static unsigned int sbi_cppc_perf_to_khz(struct sbi_cppc_cpudata *data,
+					 u32 perf)
+{
+	u64 offset;
+
+	if (data->perf_is_khz)
+		return perf;
+
+	offset = (u64)(perf - data->lowest_perf) *
+		 (data->nominal_freq_khz - data->lowest_freq_khz);
+	do_div(offset, data->nominal_perf - data->lowest_perf);
+
+	return data->lowest_freq_khz + offset;
+}
+
+static u32 sbi_cppc_khz_to_perf(struct sbi_cppc_cpudata *data,
+				unsigned int khz)
+{
+	u64 offset;
+
+	if (data->perf_is_khz)
+		return khz;
+
+	if (khz <= data->lowest_freq_khz)
+		return data->lowest_perf;
+
+	offset = (u64)(khz - data->lowest_freq_khz) *
+		 (data->nominal_perf - data->lowest_perf);
+	do_div(offset, data->nominal_freq_khz - data->lowest_freq_khz);
+
+	return min_t(u64, data->lowest_perf + offset, data->highest_perf);
+}
+
+/* Runs on the hart whose registers are being read. */
+static void sbi_cppc_init_cpudata(void *ret_ptr)
+{
+	struct sbi_cppc_cpudata *data = this_cpu_ptr(&sbi_cppc_cpudata);
+	u64 lowest_mhz, nominal_mhz, val;
+	int ret;
+
+	ret = sbi_cppc_read(SBI_CPPC_HIGHEST_PERF, &val);
+	if (ret)
+		goto out;
+	data->highest_perf = val;
+
+	ret = sbi_cppc_read(SBI_CPPC_NOMINAL_PERF, &val);
+	if (ret)
+		goto out;
+	data->nominal_perf = val;
+
+	ret = sbi_cppc_read(SBI_CPPC_LOWEST_PERF, &val);
+	if (ret)
+		goto out;
+	data->lowest_perf = val;
+
+	if (data->lowest_perf >= data->highest_perf) {
+		ret = -ENODEV;
+		goto out;
+	}
+
+	/* The ACPI frequency registers are in MHz. */
+	if (!sbi_cppc_read(SBI_CPPC_LOWEST_FREQ, &lowest_mhz) &&
+	    !sbi_cppc_read(SBI_CPPC_NOMINAL_FREQ, &nominal_mhz) &&
+	    lowest_mhz && nominal_mhz > lowest_mhz &&
+	    data->nominal_perf > data->lowest_perf) {
+		data->lowest_freq_khz = lowest_mhz * 1000;
+		data->nominal_freq_khz = nominal_mhz * 1000;
+	} else {
+		data->perf_is_khz = true;
+	}
+
+	if (sbi_cppc_read(SBI_CPPC_TRANSITION_LATENCY, &val) || !val)
+		val = CPUFREQ_ETERNAL;
+	data->transition_latency_ns = val;
+
+	/* Optional; some firmwares have CPPC always enabled. */
+	if (sbi_cppc_reg_implemented(SBI_CPPC_ENABLE))
+		sbi_cppc_write(SBI_CPPC_ENABLE, 1);
+
+	ret = sbi_cppc_read(SBI_CPPC_DESIRED_PERF, &val);
+	if (ret)
+		goto out;
+	data->desired_perf = val ? : data->nominal_perf;
+
+out:
+	*(int *)ret_ptr = ret;
+}
+
+static int sbi_cppc_cpufreq_init(struct cpufreq_policy *policy)
+{
+	struct sbi_cppc_cpudata *data;
+	int cpu = policy->cpu;
+	int ret, err = 0;
+
+	ret = smp_call_function_single(cpu, sbi_cppc_init_cpudata, &err, 1);
+	if (ret)
+		return ret;
+	if (err)
+		return err;
+
+	data = per_cpu_ptr(&sbi_cppc_cpudata, cpu);
+	policy->driver_data = data;
+
+	policy->min = sbi_cppc_perf_to_khz(data, data->lowest_perf);
+	policy->max = sbi_cppc_perf_to_khz(data, data->highest_perf);
+	policy->cpuinfo.min_freq = policy->min;
+	policy->cpuinfo.max_freq = policy->max;
+	policy->cpuinfo.transition_latency = data->transition_latency_ns;
+	policy->cur = sbi_cppc_perf_to_khz(data, data->desired_perf);
+
+	/* A desired performance write is one ecall, atomic context is fine. */
+	policy->fast_switch_possible = true;
+
+	return 0;
+}
+
+static int sbi_cppc_cpufreq_verify(struct cpufreq_policy_data *policy)
+{
+	cpufreq_verify_within_cpu_limits(policy);
+	return 0;
+}
+
+/* Runs on a hart of the policy; the register belongs to the caller. */
+static void sbi_cppc_set_perf(void *info)
+{
+	struct sbi_cppc_cpudata *data = this_cpu_ptr(&sbi_cppc_cpudata);
+	u32 perf = *(u32 *)info;
+
+	if (!sbi_cppc_write(SBI_CPPC_DESIRED_PERF, perf))
+		data->desired_perf = perf;
+}
+
+static int sbi_cppc_cpufreq_target(struct cpufreq_policy *policy,
+				   unsigned int target_freq,
+				   unsigned int relation)
+{
+	struct sbi_cppc_cpudata *data = policy->driver_data;
+	struct cpufreq_freqs freqs;
+	u32 perf;
+
+	perf = sbi_cppc_khz_to_perf(data, target_freq);
+	freqs.old = sbi_cppc_perf_to_khz(data, data->desired_perf);
+	freqs.new = sbi_cppc_perf_to_khz(data, perf);
+
+	cpufreq_freq_transition_begin(policy, &freqs);
+	smp_call_function_any(policy->cpus, sbi_cppc_set_perf, &perf, 1);
+	cpufreq_freq_transition_end(policy, &freqs, false);
+
+	return 0;
+}
+
+static unsigned int sbi_cppc_cpufreq_fast_switch(struct cpufreq_policy *policy,
+						 unsigned int target_freq)
+{
+	struct sbi_cppc_cpudata *data = policy->driver_data;
+	u32 perf;
+
+	perf = sbi_cppc_khz_to_perf(data, target_freq);
+	if (sbi_cppc_write(SBI_CPPC_DESIRED_PERF, perf))
+		return 0;
+
+	data->desired_perf = perf;
+
+	return sbi_cppc_perf_to_khz(data, perf);
+}
+
+static unsigned int sbi_cppc_cpufreq_get(unsigned int cpu)
+{
+	struct sbi_cppc_cpudata *data = per_cpu_ptr(&sbi_cppc_cpudata, cpu);
+
+	return sbi_cppc_perf_to_khz(data, data->desired_perf);
+}
+
+static struct cpufreq_driver sbi_cppc_cpufreq_driver = {
+	.flags		= CPUFREQ_NEED_INITIAL_FREQ_CHECK,
+	.verify		= sbi_cppc_cpufreq_verify,
+	.target		= sbi_cppc_cpufreq_target,
+	.fast_switch	= sbi_cppc_cpufreq_fast_switch,
+	.get		= sbi_cppc_cpufreq_get,
+	.init		= sbi_cppc_cpufreq_init,
+	.name		= "sbi-cppc",
+};
+
+static int __init sbi_cppc_cpufreq_driver_init(void)
+{
+	if (!sbi_probe_extension(SBI_EXT_CPPC)) {
+		pr_debug("CPPC extension not available\n");
+		return -ENODEV;
+	}
+
+	if (!sbi_cppc_reg_implemented(SBI_CPPC_DESIRED_PERF) ||
+	    !sbi_cppc_reg_implemented(SBI_CPPC_HIGHEST_PERF)) {
+		pr_info("firmware lacks mandatory CPPC registers\n");
+		return -ENODEV;
+	}
+
+	return cpufreq_register_driver(&sbi_cppc_cpufreq_driver);
+}
+module_init(sbi_cppc_cpufreq_driver_init);
+
+static void __exit sbi_cppc_cpufreq_driver_exit(void)
+{
+	cpufreq_unregister_driver(&sbi_cppc_cpufreq_driver);
+}
+module_exit(sbi_cppc_cpufreq_driver_exit);
+
+MODULE_DESCRIPTION("SBI CPPC cpufreq driver");
+MODULE_LICENSE("GPL");
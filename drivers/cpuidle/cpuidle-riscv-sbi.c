@@ -13,6 +13,7 @@
 #include <linux/cpu_pm.h>
 #include <linux/cpu_cooling.h>
 #include <linux/kernel.h>
+#include <linux/ktime.h>
 #include <linux/module.h>
 #include <linux/of.h>
 #include <linux/of_device.h>
@@ -28,6 +29,15 @@
 #include "dt_idle_states.h"
 #include "dt_idle_genpd.h"
 
+/*
+ * When the architecture supports cpu_relax() polling, state 0 is the
+ * generic polling loop and the architectural WFI plus the DT-declared
+ * SBI states shift up by one. Polling never pays the interrupt entry
+ * path, which makes it the cheapest option for the sub-WFI wait times
+ * seen between back-to-back request arrivals.
+ */
+#define SBI_POLL_OFFSET	(IS_ENABLED(CONFIG_ARCH_HAS_CPU_RELAX) ? 1 : 0)
+
 struct sbi_cpuidle_data {
 	u32 *states;
 	struct device *dev;
@@ -87,23 +97,79 @@ static int sbi_suspend_finisher(unsigned long suspend_type,
 
 static int sbi_suspend(u32 state)
 {
+	/*
+	 * Only non-retention states need the full register/CSR context
+	 * save and restore of cpu_suspend(); retention states preserve
+	 * all hart state across the SBI call, so enter them directly to
+	 * keep their exit latency low.
+	 */
 	if (state & SBI_HSM_SUSP_NON_RET_BIT)
 		return cpu_suspend(state, sbi_suspend_finisher);
 	else
 		return sbi_suspend_finisher(state, 0, 0);
 }
 
+/*
+ * The DT exit latencies and residencies for the SBI states are nominal
+ * numbers from the platform description; the real cost of the HSM
+ * ecall round trip depends on the firmware build. Track the shortest
+ * residency observed per state: when wakeups arrive back to back, some
+ * of them interrupt the suspend almost immediately, so the floor over a
+ * window of entries approximates the bare entry/exit overhead. If that
+ * floor sits above the DT target residency, raise the threshold so the
+ * governor stops picking a state that cannot pay for itself.
+ */
+#define SBI_RESIDENCY_SAMPLES	128
+
+struct sbi_residency_feedback {
+	unsigned int count[CPUIDLE_STATE_MAX];
+	u64 min_ns[CPUIDLE_STATE_MAX];
+};
+
+static DEFINE_PER_CPU(struct sbi_residency_feedback, sbi_residency_feedback);
+
+static void sbi_cpuidle_note_residency(struct cpuidle_driver *drv, int idx,
+				       u64 res)
+{
+	struct sbi_residency_feedback *fb =
+			this_cpu_ptr(&sbi_residency_feedback);
+	struct cpuidle_state *s = &drv->states[idx];
+
+	if (!fb->count[idx] || res < fb->min_ns[idx])
+		fb->min_ns[idx] = res;
+
+	if (++fb->count[idx] < SBI_RESIDENCY_SAMPLES)
+		return;
+
+	/* The driver instance is per CPU, so this only affects this hart. */
+	if (fb->min_ns[idx] > s->target_residency_ns)
+		s->target_residency_ns = fb->min_ns[idx];
+	fb->count[idx] = 0;
+}
+
 static int sbi_cpuidle_enter_state(struct cpuidle_device *dev,
 				   struct cpuidle_driver *drv, int idx)
 {
 	u32 *states = __this_cpu_read(sbi_cpuidle_data.states);
 	u32 state = states[idx];
+	u64 start;
+	int ret;
+
+	/* The WFI state has no suspend parameter, idle architecturally. */
+	if (idx == SBI_POLL_OFFSET) {
+		cpu_do_idle();
+		return idx;
+	}
 
+	start = ktime_get_ns();
 	if (state & SBI_HSM_SUSP_NON_RET_BIT)
-		return CPU_PM_CPU_IDLE_ENTER_PARAM(sbi_suspend, idx, state);
+		ret = CPU_PM_CPU_IDLE_ENTER_PARAM(sbi_suspend, idx, state);
 	else
-		return CPU_PM_CPU_IDLE_ENTER_RETENTION_PARAM(sbi_suspend,
-							     idx, state);
+		ret = CPU_PM_CPU_IDLE_ENTER_RETENTION_PARAM(sbi_suspend,
+							    idx, state);
+	sbi_cpuidle_note_residency(drv, idx, ktime_get_ns() - start);
+
+	return ret;
 }
 
 static int __sbi_enter_domain_idle_state(struct cpuidle_device *dev,
@@ -113,6 +179,7 @@ static int __sbi_enter_domain_idle_state(struct cpuidle_device *dev,
 	struct sbi_cpuidle_data *data = this_cpu_ptr(&sbi_cpuidle_data);
 	u32 *states = data->states;
 	struct device *pd_dev = data->dev;
+	u64 start;
 	u32 state;
 	int ret;
 
@@ -133,7 +200,10 @@ static int __sbi_enter_domain_idle_state(struct cpuidle_device *dev,
 	else
 		state = states[idx];
 
+	start = ktime_get_ns();
 	ret = sbi_suspend(state) ? -1 : idx;
+	if (!s2idle)
+		sbi_cpuidle_note_residency(drv, idx, ktime_get_ns() - start);
 
 	ct_irq_enter_irqson();
 	if (s2idle)
@@ -281,8 +351,9 @@ static int sbi_cpuidle_dt_init_states(struct device *dev,
 	}
 
 	/* Parse SBI specific details from state DT nodes */
-	for (i = 1; i < state_count; i++) {
-		state_node = of_get_cpu_state_node(cpu_node, i - 1);
+	for (i = SBI_POLL_OFFSET + 1; i < state_count; i++) {
+		state_node = of_get_cpu_state_node(cpu_node,
+						   i - SBI_POLL_OFFSET - 1);
 		if (!state_node)
 			break;
 
@@ -325,6 +396,7 @@ static int sbi_cpuidle_init_cpu(struct device *dev, int cpu)
 {
 	struct cpuidle_driver *drv;
 	unsigned int state_count = 0;
+	unsigned int wfi_idx = SBI_POLL_OFFSET;
 	int ret = 0;
 
 	drv = devm_kzalloc(dev, sizeof(*drv), GFP_KERNEL);
@@ -335,13 +407,16 @@ static int sbi_cpuidle_init_cpu(struct device *dev, int cpu)
 	drv->owner = THIS_MODULE;
 	drv->cpumask = (struct cpumask *)cpumask_of(cpu);
 
-	/* RISC-V architectural WFI to be represented as state index 0. */
-	drv->states[0].enter = sbi_cpuidle_enter_state;
-	drv->states[0].exit_latency = 1;
-	drv->states[0].target_residency = 1;
-	drv->states[0].power_usage = UINT_MAX;
-	strcpy(drv->states[0].name, "WFI");
-	strcpy(drv->states[0].desc, "RISC-V WFI");
+	/* A no-op unless the architecture supports cpu_relax() polling. */
+	cpuidle_poll_state_init(drv);
+
+	/* RISC-V architectural WFI follows the optional polling state. */
+	drv->states[wfi_idx].enter = sbi_cpuidle_enter_state;
+	drv->states[wfi_idx].exit_latency = 1;
+	drv->states[wfi_idx].target_residency = 1;
+	drv->states[wfi_idx].power_usage = UINT_MAX;
+	strcpy(drv->states[wfi_idx].name, "WFI");
+	strcpy(drv->states[wfi_idx].desc, "RISC-V WFI");
 
 	/*
 	 * If no DT idle states are detected (ret == 0) let the driver
@@ -350,13 +425,13 @@ static int sbi_cpuidle_init_cpu(struct device *dev, int cpu)
 	 * default archictectural back-end already executes wfi
 	 * on idle entry.
 	 */
-	ret = dt_init_idle_driver(drv, sbi_cpuidle_state_match, 1);
+	ret = dt_init_idle_driver(drv, sbi_cpuidle_state_match, wfi_idx + 1);
 	if (ret <= 0) {
 		pr_debug("HART%ld: failed to parse DT idle states\n",
 			 cpuid_to_hartid_map(cpu));
 		return ret ? : -ENODEV;
 	}
-	state_count = ret + 1; /* Include WFI state as well */
+	state_count = ret + wfi_idx + 1; /* Polling and WFI states as well */
 
 	/* Initialize idle states from DT. */
 	ret = sbi_cpuidle_dt_init_states(dev, drv, cpu, state_count);
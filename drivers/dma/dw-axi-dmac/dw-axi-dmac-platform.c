@@ -429,7 +429,7 @@ static void axi_chan_block_xfer_start(struct axi_dma_chan *chan,
 
 static void axi_chan_start_first_queued(struct axi_dma_chan *chan)
 {
-	struct axi_dma_desc *desc;
+	struct axi_dma_desc *desc, *prev = NULL;
 	struct virt_dma_desc *vd;
 
 	vd = vchan_next_desc(&chan->vc);
@@ -437,19 +437,70 @@ static void axi_chan_start_first_queued(struct axi_dma_chan *chan)
 		return;
 
 	desc = vd_to_axi_desc(vd);
+
+	/*
+	 * Link every descriptor issued so far into one hardware chain, so
+	 * the whole batch completes on a single end-of-chain interrupt
+	 * instead of one per transfer. Cyclic descriptors are
+	 * self-contained rings and are never chained.
+	 */
+	if (!chan->cyclic) {
+		list_for_each_entry(vd, &chan->vc.desc_issued, node) {
+			struct axi_dma_desc *cur = vd_to_axi_desc(vd);
+
+			axi_desc_set_valid(cur);
+			if (prev)
+				axi_chan_chain_desc(prev, cur);
+			prev = cur;
+		}
+		chan->tail_desc = prev;
+	}
+
 	dev_vdbg(chan2dev(chan), "%s: started %u\n", axi_chan_name(chan),
-		vd->tx.cookie);
+		desc->vd.tx.cookie);
 	axi_chan_block_xfer_start(chan, desc);
 }
 
+/*
+ * Append freshly issued descriptors to the chain the controller is
+ * already walking. Called in chan locked context.
+ */
+static void axi_chan_append_queued(struct axi_dma_chan *chan)
+{
+	struct axi_dma_desc *prev = chan->tail_desc;
+	struct virt_dma_desc *vd = &prev->vd;
+
+	list_for_each_entry_continue(vd, &chan->vc.desc_issued, node) {
+		struct axi_dma_desc *desc = vd_to_axi_desc(vd);
+
+		axi_desc_set_valid(desc);
+		axi_chan_chain_desc(prev, desc);
+		prev = desc;
+	}
+	chan->tail_desc = prev;
+}
+
 static void dma_chan_issue_pending(struct dma_chan *dchan)
 {
 	struct axi_dma_chan *chan = dchan_to_axi_dma_chan(dchan);
 	unsigned long flags;
 
 	spin_lock_irqsave(&chan->vc.lock, flags);
-	if (vchan_issue_pending(&chan->vc))
-		axi_chan_start_first_queued(chan);
+	if (vchan_issue_pending(&chan->vc)) {
+		/*
+		 * Fast path: the channel is already walking a chain, so
+		 * splice the new descriptors onto its tail instead of
+		 * waiting for the end-of-chain interrupt. Should the
+		 * controller retire its old last LLI before observing the
+		 * new link, the completion handler finds the unconsumed
+		 * remainder and restarts from it.
+		 */
+		if (!chan->cyclic && chan->tail_desc &&
+		    axi_chan_is_hw_enable(chan))
+			axi_chan_append_queued(chan);
+		else
+			axi_chan_start_first_queued(chan);
+	}
 	spin_unlock_irqrestore(&chan->vc.lock, flags);
 }
 
@@ -558,6 +609,56 @@ static void set_desc_last(struct axi_dma_hw_desc *desc)
 	desc->lli->ctl_hi = cpu_to_le32(val);
 }
 
+static struct axi_dma_hw_desc *axi_desc_last_hw(struct axi_dma_desc *desc)
+{
+	return &desc->hw_desc[desc->nr_hw_descs - 1];
+}
+
+/*
+ * With LLI write-back the controller clears CH_CTL_H_LLI_VALID in memory
+ * as it retires each block, so a descriptor whose final LLI still has the
+ * bit set was not reached before the channel went idle.
+ */
+static bool axi_desc_is_consumed(struct axi_dma_desc *desc)
+{
+	return !(le32_to_cpu(axi_desc_last_hw(desc)->lli->ctl_hi) &
+		 CH_CTL_H_LLI_VALID);
+}
+
+/* Re-arm every LLI of a descriptor that is about to be (re)submitted */
+static void axi_desc_set_valid(struct axi_dma_desc *desc)
+{
+	struct axi_dma_hw_desc *hw_desc;
+	u32 val, i;
+
+	for (i = 0; i < desc->nr_hw_descs; i++) {
+		hw_desc = &desc->hw_desc[i];
+		val = le32_to_cpu(hw_desc->lli->ctl_hi);
+		val |= CH_CTL_H_LLI_VALID;
+		hw_desc->lli->ctl_hi = cpu_to_le32(val);
+	}
+}
+
+/*
+ * Splice @next onto the end of @prev so the controller walks straight
+ * from one descriptor into the other without raising an interrupt in
+ * between. Called in chan locked context.
+ */
+static void axi_chan_chain_desc(struct axi_dma_desc *prev,
+				struct axi_dma_desc *next)
+{
+	struct axi_dma_hw_desc *hw_desc = axi_desc_last_hw(prev);
+	u32 val;
+	u8 lms = 0; /* Select AXI0 master for LLI fetching */
+
+	write_desc_llp(hw_desc, next->hw_desc[0].llp | lms);
+	/* The link must be visible before the LAST bit is cleared */
+	dma_wmb();
+	val = le32_to_cpu(hw_desc->lli->ctl_hi);
+	val &= ~CH_CTL_H_LLI_LAST;
+	hw_desc->lli->ctl_hi = cpu_to_le32(val);
+}
+
 static void write_desc_sar(struct axi_dma_hw_desc *desc, dma_addr_t adr)
 {
 	desc->lli->sar = cpu_to_le64(adr);
@@ -764,6 +865,7 @@ dw_axi_dma_chan_prep_cyclic(struct dma_chan *dchan, dma_addr_t dma_addr,
 		src_addr += segment_len;
 	}
 
+	desc->nr_hw_descs = total_segments;
 	llp = desc->hw_desc[0].llp;
 
 	/* Managed transfer list */
@@ -845,6 +947,7 @@ dw_axi_dma_chan_prep_slave_sg(struct dma_chan *dchan, struct scatterlist *sgl,
 
 	/* Set end-of-link to the last link descriptor of list */
 	set_desc_last(&desc->hw_desc[num_sgs - 1]);
+	desc->nr_hw_descs = num_sgs;
 
 	/* Managed transfer list */
 	do {
@@ -952,6 +1055,7 @@ dma_chan_prep_dma_memcpy(struct dma_chan *dchan, dma_addr_t dst_adr,
 
 	/* Set end-of-link to the last link descriptor of list */
 	set_desc_last(&desc->hw_desc[num - 1]);
+	desc->nr_hw_descs = num;
 	/* Managed transfer list */
 	do {
 		hw_desc = &desc->hw_desc[--num];
@@ -1033,6 +1137,7 @@ static noinline void axi_chan_handle_err(struct axi_dma_chan *chan, u32 status)
 	vchan_cookie_complete(vd);
 
 	/* Try to restart the controller */
+	chan->tail_desc = NULL;
 	axi_chan_start_first_queued(chan);
 
 out:
@@ -1084,12 +1189,27 @@ static void axi_chan_block_xfer_complete(struct axi_dma_chan *chan)
 			axi_chan_enable(chan);
 		}
 	} else {
-		/* Remove the completed descriptor from issued list before completing */
-		list_del(&vd->node);
-		vchan_cookie_complete(vd);
+		/*
+		 * Complete, in order, every chained descriptor the
+		 * controller consumed. A descriptor appended via
+		 * issue_pending() that lost the race against channel
+		 * shutdown has its final LLI untouched; restart the chain
+		 * from there.
+		 */
+		do {
+			desc = vd_to_axi_desc(vd);
+			if (!axi_desc_is_consumed(desc))
+				break;
+			list_del(&vd->node);
+			vchan_cookie_complete(vd);
+			vd = vchan_next_desc(&chan->vc);
+		} while (vd);
+
+		chan->tail_desc = NULL;
 
 		/* Submit queued descriptors after processing the completed ones */
-		axi_chan_start_first_queued(chan);
+		if (vd)
+			axi_chan_start_first_queued(chan);
 	}
 
 out:
@@ -1155,6 +1275,7 @@ static int dma_chan_terminate_all(struct dma_chan *dchan)
 	vchan_get_all_descriptors(&chan->vc, &head);
 
 	chan->cyclic = false;
+	chan->tail_desc = NULL;
 	spin_unlock_irqrestore(&chan->vc.lock, flags);
 
 	vchan_dma_desc_free_list(&chan->vc, &head);
@@ -51,6 +51,8 @@ struct axi_dma_chan {
 	bool				cyclic;
 	/* these other elements are all protected by vc.lock */
 	bool				is_paused;
+	/* last descriptor of the hardware chain currently in flight */
+	struct axi_dma_desc		*tail_desc;
 };
 
 struct dw_axi_dma {
@@ -100,6 +102,7 @@ struct axi_dma_desc {
 
 	struct virt_dma_desc		vd;
 	struct axi_dma_chan		*chan;
+	u32				nr_hw_descs;
 	u32				completed_blocks;
 	u32				length;
 	u32				period_len;
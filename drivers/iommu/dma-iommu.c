@@ -59,6 +59,8 @@ struct iommu_dma_cookie {
 			struct timer_list	fq_timer;
 			/* 1 when timer is active, 0 when not */
 			atomic_t		fq_timer_on;
+			/* Shortens the flush interval after allocation failures */
+			atomic_t		fq_pressure;
 		};
 		/* Trivial linear page allocator for IOMMU_DMA_MSI_COOKIE */
 		dma_addr_t		msi_iova;
@@ -89,6 +91,12 @@ early_param("iommu.forcedac", iommu_dma_forcedac_setup);
 /* Timeout (in ms) after which entries are flushed from the queue */
 #define IOVA_FQ_TIMEOUT	10
 
+/* Timeout (in ms) while recent allocation failures indicate IOVA pressure */
+#define IOVA_FQ_TIMEOUT_MIN	1
+
+/* Number of timer flushes over which allocation-failure pressure decays */
+#define IOVA_FQ_PRESSURE_DECAY	8
+
 /* Flush queue entry for deferred flushing */
 struct iova_fq_entry {
 	unsigned long iova_pfn;
@@ -152,12 +160,11 @@ static void fq_flush_iotlb(struct iommu_dma_cookie *cookie)
 	atomic64_inc(&cookie->fq_flush_finish_cnt);
 }
 
-static void fq_flush_timeout(struct timer_list *t)
+/* Flush the IOTLB and return all queued IOVAs on every CPU */
+static void fq_flush_all(struct iommu_dma_cookie *cookie)
 {
-	struct iommu_dma_cookie *cookie = from_timer(cookie, t, fq_timer);
 	int cpu;
 
-	atomic_set(&cookie->fq_timer_on, 0);
 	fq_flush_iotlb(cookie);
 
 	for_each_possible_cpu(cpu) {
@@ -171,6 +178,15 @@ static void fq_flush_timeout(struct timer_list *t)
 	}
 }
 
+static void fq_flush_timeout(struct timer_list *t)
+{
+	struct iommu_dma_cookie *cookie = from_timer(cookie, t, fq_timer);
+
+	atomic_set(&cookie->fq_timer_on, 0);
+	atomic_dec_if_positive(&cookie->fq_pressure);
+	fq_flush_all(cookie);
+}
+
 static void queue_iova(struct iommu_dma_cookie *cookie,
 		unsigned long pfn, unsigned long pages,
 		struct list_head *freelist)
@@ -216,7 +232,9 @@ static void queue_iova(struct iommu_dma_cookie *cookie,
 	if (!atomic_read(&cookie->fq_timer_on) &&
 	    !atomic_xchg(&cookie->fq_timer_on, 1))
 		mod_timer(&cookie->fq_timer,
-			  jiffies + msecs_to_jiffies(IOVA_FQ_TIMEOUT));
+			  jiffies + msecs_to_jiffies(
+				atomic_read(&cookie->fq_pressure) ?
+				IOVA_FQ_TIMEOUT_MIN : IOVA_FQ_TIMEOUT));
 }
 
 static void iommu_dma_free_fq(struct iommu_dma_cookie *cookie)
@@ -273,6 +291,7 @@ int iommu_dma_init_fq(struct iommu_domain *domain)
 
 	timer_setup(&cookie->fq_timer, fq_flush_timeout, 0);
 	atomic_set(&cookie->fq_timer_on, 0);
+	atomic_set(&cookie->fq_pressure, 0);
 	/*
 	 * Prevent incomplete fq state being observable. Pairs with path from
 	 * __iommu_dma_unmap() through iommu_dma_free_iova() to queue_iova()
@@ -648,6 +667,25 @@ static dma_addr_t iommu_dma_alloc_iova(struct iommu_domain *domain,
 		iova = alloc_iova_fast(iovad, iova_len,
 				       DMA_BIT_MASK(32) >> shift, false);
 
+	if (!iova)
+		iova = alloc_iova_fast(iovad, iova_len, dma_limit >> shift,
+				       false);
+
+	/*
+	 * Allocation failed while the flush queues may still hold dead
+	 * IOVAs: drain them right now instead of waiting out the timer,
+	 * and keep draining eagerly while the pressure lasts.  Only when
+	 * that is not enough pay for nuking the rcaches.
+	 */
+	if (!iova && cookie->fq_domain) {
+		/* Pairs with the smp_wmb() in iommu_dma_init_fq() */
+		smp_mb();
+		atomic_set(&cookie->fq_pressure, IOVA_FQ_PRESSURE_DECAY);
+		fq_flush_all(cookie);
+		iova = alloc_iova_fast(iovad, iova_len, dma_limit >> shift,
+				       false);
+	}
+
 	if (!iova)
 		iova = alloc_iova_fast(iovad, iova_len, dma_limit >> shift,
 				       true);
@@ -0,0 +1,347 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * RISC-V page table allocator for the RISC-V IOMMU.
+ *
+ * Implements the Sv39 and Sv48 first-stage formats from the RISC-V
+ * privileged architecture, which the ratified RISC-V IOMMU spec reuses
+ * unchanged for its first-stage translation. PTEs share the CPU layout:
+ * a 44-bit PPN at bit 10 and the V/R/W/X/U/G/A/D flag bits below it.
+ */
+
+#define pr_fmt(fmt)	"riscv-io-pgtable: " fmt
+
+#include <linux/atomic.h>
+#include <linux/bitops.h>
+#include <linux/io-pgtable.h>
+#include <linux/kernel.h>
+#include <linux/sizes.h>
+#include <linux/slab.h>
+#include <linux/types.h>
+
+#include <asm/barrier.h>
+
+#define RISCV_IOPTE_V		BIT_ULL(0)
+#define RISCV_IOPTE_R		BIT_ULL(1)
+#define RISCV_IOPTE_W		BIT_ULL(2)
+#define RISCV_IOPTE_X		BIT_ULL(3)
+#define RISCV_IOPTE_U		BIT_ULL(4)
+#define RISCV_IOPTE_G		BIT_ULL(5)
+#define RISCV_IOPTE_A		BIT_ULL(6)
+#define RISCV_IOPTE_D		BIT_ULL(7)
+
+#define RISCV_IOPTE_PERMS	(RISCV_IOPTE_R | RISCV_IOPTE_W | RISCV_IOPTE_X)
+
+#define RISCV_IOPTE_PPN_SHIFT	10
+
+/* 512 8-byte entries per table at every level */
+#define RISCV_PTRS_PER_PTE	512
+#define RISCV_PGLEVEL_BITS	9
+
+#define RISCV_SV39_LEVELS	3
+#define RISCV_SV48_LEVELS	4
+
+struct riscv_io_pgtable {
+	struct io_pgtable	iop;
+	int			levels;
+	u64			*pgd;
+};
+
+#define io_pgtable_to_data(x)						\
+	container_of((x), struct riscv_io_pgtable, iop)
+
+#define io_pgtable_ops_to_data(x)					\
+	io_pgtable_to_data(io_pgtable_ops_to_pgtable(x))
+
+/* Shift for the VPN field indexing tables at @lvl, root being level 0 */
+static unsigned int riscv_iopte_shift(struct riscv_io_pgtable *data, int lvl)
+{
+	return PAGE_SHIFT + RISCV_PGLEVEL_BITS * (data->levels - 1 - lvl);
+}
+
+static u64 *riscv_iopte_offset(u64 *table, unsigned long iova,
+			       unsigned int shift)
+{
+	return table + ((iova >> shift) & (RISCV_PTRS_PER_PTE - 1));
+}
+
+static u64 riscv_iopte_from_paddr(phys_addr_t paddr)
+{
+	return (u64)(paddr >> PAGE_SHIFT) << RISCV_IOPTE_PPN_SHIFT;
+}
+
+static phys_addr_t riscv_iopte_to_paddr(u64 pte)
+{
+	return (phys_addr_t)(pte >> RISCV_IOPTE_PPN_SHIFT) << PAGE_SHIFT;
+}
+
+static bool riscv_iopte_is_leaf(u64 pte)
+{
+	return (pte & RISCV_IOPTE_V) && (pte & RISCV_IOPTE_PERMS);
+}
+
+/*
+ * The IOMMU performs untranslated requests with U-mode permissions, so
+ * leaves must carry the U bit. A and D are preset because we never rely
+ * on hardware updating them, and implementations without Svadu raise a
+ * fault on access to a leaf with A (or D, for writes) clear.
+ */
+static u64 riscv_iopte_prot(int prot)
+{
+	u64 pte = RISCV_IOPTE_V | RISCV_IOPTE_U | RISCV_IOPTE_A;
+
+	if (prot & IOMMU_READ)
+		pte |= RISCV_IOPTE_R;
+	if (prot & IOMMU_WRITE)
+		pte |= RISCV_IOPTE_R | RISCV_IOPTE_W | RISCV_IOPTE_D;
+
+	return pte;
+}
+
+/*
+ * Walk to the slot for @iova at the level implied by @pgsize, optionally
+ * installing intermediate tables on the way down. Concurrent installs of
+ * the same table are resolved with cmpxchg, the loser frees its page.
+ */
+static u64 *riscv_iopte_walk(struct riscv_io_pgtable *data, unsigned long iova,
+			     size_t pgsize, gfp_t gfp)
+{
+	u64 *table = data->pgd;
+	int lvl;
+
+	for (lvl = 0; lvl < data->levels; lvl++) {
+		unsigned int shift = riscv_iopte_shift(data, lvl);
+		u64 *ptep = riscv_iopte_offset(table, iova, shift);
+		u64 pte, old;
+
+		if (BIT_ULL(shift) == pgsize)
+			return ptep;
+
+		pte = READ_ONCE(*ptep);
+		if (!(pte & RISCV_IOPTE_V)) {
+			u64 *new_table;
+
+			if (!gfp)
+				return NULL;
+
+			new_table = (u64 *)get_zeroed_page(gfp);
+			if (!new_table)
+				return NULL;
+
+			pte = riscv_iopte_from_paddr(__pa(new_table)) |
+			      RISCV_IOPTE_V;
+			old = cmpxchg64_relaxed(ptep, 0, pte);
+			if (old) {
+				free_page((unsigned long)new_table);
+				pte = old;
+			}
+		}
+
+		/* A block mapping already covers this range */
+		if (riscv_iopte_is_leaf(pte))
+			return NULL;
+
+		table = __va(riscv_iopte_to_paddr(pte));
+	}
+
+	return NULL;
+}
+
+static int riscv_io_pgtable_map_pages(struct io_pgtable_ops *ops,
+				      unsigned long iova, phys_addr_t paddr,
+				      size_t pgsize, size_t pgcount,
+				      int iommu_prot, gfp_t gfp,
+				      size_t *mapped)
+{
+	struct riscv_io_pgtable *data = io_pgtable_ops_to_data(ops);
+	struct io_pgtable_cfg *cfg = &data->iop.cfg;
+	u64 prot = riscv_iopte_prot(iommu_prot);
+	size_t i;
+
+	if (WARN_ON(!(pgsize & cfg->pgsize_bitmap)))
+		return -EINVAL;
+
+	if (WARN_ON(iova >> cfg->ias || (paddr + pgsize * pgcount) >>
+		    cfg->oas))
+		return -ERANGE;
+
+	if (!(iommu_prot & (IOMMU_READ | IOMMU_WRITE)))
+		return -EINVAL;
+
+	for (i = 0; i < pgcount; i++) {
+		u64 *ptep = riscv_iopte_walk(data, iova, pgsize, gfp);
+
+		if (!ptep)
+			return -ENOMEM;
+
+		if (WARN_ON(READ_ONCE(*ptep) & RISCV_IOPTE_V))
+			return -EEXIST;
+
+		WRITE_ONCE(*ptep, riscv_iopte_from_paddr(paddr) | prot);
+
+		iova += pgsize;
+		paddr += pgsize;
+		if (mapped)
+			*mapped += pgsize;
+	}
+
+	/* Make the new PTEs visible before any TLB fill walks them */
+	wmb();
+
+	return 0;
+}
+
+static int riscv_io_pgtable_map(struct io_pgtable_ops *ops, unsigned long iova,
+				phys_addr_t paddr, size_t size, int iommu_prot,
+				gfp_t gfp)
+{
+	return riscv_io_pgtable_map_pages(ops, iova, paddr, size, 1,
+					  iommu_prot, gfp, NULL);
+}
+
+static size_t riscv_io_pgtable_unmap_pages(struct io_pgtable_ops *ops,
+					   unsigned long iova, size_t pgsize,
+					   size_t pgcount,
+					   struct iommu_iotlb_gather *gather)
+{
+	struct riscv_io_pgtable *data = io_pgtable_ops_to_data(ops);
+	size_t unmapped = 0;
+
+	while (pgcount--) {
+		u64 *ptep = riscv_iopte_walk(data, iova, pgsize, 0);
+
+		if (!ptep || !(READ_ONCE(*ptep) & RISCV_IOPTE_V))
+			break;
+
+		WRITE_ONCE(*ptep, 0);
+
+		if (!iommu_iotlb_gather_queued(gather))
+			io_pgtable_tlb_add_page(&data->iop, gather, iova,
+						pgsize);
+
+		iova += pgsize;
+		unmapped += pgsize;
+	}
+
+	return unmapped;
+}
+
+static size_t riscv_io_pgtable_unmap(struct io_pgtable_ops *ops,
+				     unsigned long iova, size_t size,
+				     struct iommu_iotlb_gather *gather)
+{
+	return riscv_io_pgtable_unmap_pages(ops, iova, size, 1, gather);
+}
+
+static phys_addr_t riscv_io_pgtable_iova_to_phys(struct io_pgtable_ops *ops,
+						 unsigned long iova)
+{
+	struct riscv_io_pgtable *data = io_pgtable_ops_to_data(ops);
+	u64 *table = data->pgd;
+	int lvl;
+
+	for (lvl = 0; lvl < data->levels; lvl++) {
+		unsigned int shift = riscv_iopte_shift(data, lvl);
+		u64 pte = READ_ONCE(*riscv_iopte_offset(table, iova, shift));
+
+		if (!(pte & RISCV_IOPTE_V))
+			return 0;
+
+		if (riscv_iopte_is_leaf(pte))
+			return riscv_iopte_to_paddr(pte) |
+			       (iova & (BIT_ULL(shift) - 1));
+
+		table = __va(riscv_iopte_to_paddr(pte));
+	}
+
+	return 0;
+}
+
+static void riscv_io_pgtable_free_table(u64 *table, int lvl, int levels)
+{
+	int i;
+
+	if (lvl < levels - 1) {
+		for (i = 0; i < RISCV_PTRS_PER_PTE; i++) {
+			u64 pte = table[i];
+
+			if ((pte & RISCV_IOPTE_V) && !riscv_iopte_is_leaf(pte))
+				riscv_io_pgtable_free_table(
+					__va(riscv_iopte_to_paddr(pte)),
+					lvl + 1, levels);
+		}
+	}
+
+	free_page((unsigned long)table);
+}
+
+static struct io_pgtable *riscv_alloc_pgtable(struct io_pgtable_cfg *cfg,
+					      void *cookie, int levels)
+{
+	unsigned int max_ias = PAGE_SHIFT + levels * RISCV_PGLEVEL_BITS;
+	struct riscv_io_pgtable *data;
+
+	if (cfg->quirks)
+		return NULL;
+
+	if (!cfg->ias || cfg->ias > max_ias || cfg->oas > 56)
+		return NULL;
+
+	/* 4K pages plus the block sizes each upper level can map */
+	cfg->pgsize_bitmap &= SZ_4K | SZ_2M | SZ_1G;
+	if (!cfg->pgsize_bitmap)
+		return NULL;
+
+	data = kzalloc(sizeof(*data), GFP_KERNEL);
+	if (!data)
+		return NULL;
+
+	data->levels = levels;
+	data->pgd = (u64 *)get_zeroed_page(GFP_KERNEL);
+	if (!data->pgd) {
+		kfree(data);
+		return NULL;
+	}
+
+	data->iop.ops = (struct io_pgtable_ops) {
+		.map		= riscv_io_pgtable_map,
+		.map_pages	= riscv_io_pgtable_map_pages,
+		.unmap		= riscv_io_pgtable_unmap,
+		.unmap_pages	= riscv_io_pgtable_unmap_pages,
+		.iova_to_phys	= riscv_io_pgtable_iova_to_phys,
+	};
+
+	cfg->ias = max_ias;
+	cfg->riscv_cfg.pgd = __pa(data->pgd);
+
+	return &data->iop;
+}
+
+static struct io_pgtable *riscv_sv39_alloc_pgtable(struct io_pgtable_cfg *cfg,
+						   void *cookie)
+{
+	return riscv_alloc_pgtable(cfg, cookie, RISCV_SV39_LEVELS);
+}
+
+static struct io_pgtable *riscv_sv48_alloc_pgtable(struct io_pgtable_cfg *cfg,
+						   void *cookie)
+{
+	return riscv_alloc_pgtable(cfg, cookie, RISCV_SV48_LEVELS);
+}
+
+static void riscv_free_pgtable(struct io_pgtable *iop)
+{
+	struct riscv_io_pgtable *data = io_pgtable_to_data(iop);
+
+	riscv_io_pgtable_free_table(data->pgd, 0, data->levels);
+	kfree(data);
+}
+
+struct io_pgtable_init_fns io_pgtable_riscv_sv39_init_fns = {
+	.alloc	= riscv_sv39_alloc_pgtable,
+	.free	= riscv_free_pgtable,
+};
+
+struct io_pgtable_init_fns io_pgtable_riscv_sv48_init_fns = {
+	.alloc	= riscv_sv48_alloc_pgtable,
+	.free	= riscv_free_pgtable,
+};
@@ -25,6 +25,10 @@ io_pgtable_init_table[IO_PGTABLE_NUM_FMTS] = {
 	[APPLE_DART] = &io_pgtable_apple_dart_init_fns,
 	[APPLE_DART2] = &io_pgtable_apple_dart_init_fns,
 #endif
+#ifdef CONFIG_IOMMU_IO_PGTABLE_RISCV
+	[RISCV_SV39] = &io_pgtable_riscv_sv39_init_fns,
+	[RISCV_SV48] = &io_pgtable_riscv_sv48_init_fns,
+#endif
 #ifdef CONFIG_IOMMU_IO_PGTABLE_ARMV7S
 	[ARM_V7S] = &io_pgtable_arm_v7s_init_fns,
 #endif
@@ -11,6 +11,11 @@
 #include <linux/smp.h>
 #include <linux/bitops.h>
 #include <linux/cpu.h>
+#ifdef CONFIG_IOMMU_DEBUGFS
+#include <linux/debugfs.h>
+#include <linux/iommu.h>
+#include <linux/seq_file.h>
+#endif
 
 /* The anchor node sits above the top of the usable address space */
 #define IOVA_ANCHOR	~0UL
@@ -240,6 +245,56 @@ static struct kmem_cache *iova_cache;
 static unsigned int iova_cache_users;
 static DEFINE_MUTEX(iova_cache_mutex);
 
+#ifdef CONFIG_IOMMU_DEBUGFS
+static struct dentry *iova_rcache_debugfs;
+
+static int iova_rcache_stats_show(struct seq_file *s, void *unused)
+{
+	unsigned int cpu;
+	int i;
+
+	seq_puts(s, "order      hits    misses   refills    spills overflows\n");
+	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; i++) {
+		u64 hits = 0, misses = 0, refills = 0;
+		u64 spills = 0, overflows = 0;
+
+		for_each_possible_cpu(cpu) {
+			struct iova_rcache_stats *st =
+				&per_cpu(rcache_stats, cpu);
+
+			hits += st->hits[i];
+			misses += st->misses[i];
+			refills += st->refills[i];
+			spills += st->spills[i];
+			overflows += st->overflows[i];
+		}
+
+		seq_printf(s, "%5d %9llu %9llu %9llu %9llu %9llu\n",
+			   i, hits, misses, refills, spills, overflows);
+	}
+
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(iova_rcache_stats);
+
+static void iova_rcache_debugfs_init(void)
+{
+	iommu_debugfs_setup();
+	iova_rcache_debugfs = debugfs_create_file("iova-rcache", 0444,
+						  iommu_debugfs_dir, NULL,
+						  &iova_rcache_stats_fops);
+}
+
+static void iova_rcache_debugfs_exit(void)
+{
+	debugfs_remove(iova_rcache_debugfs);
+	iova_rcache_debugfs = NULL;
+}
+#else
+static inline void iova_rcache_debugfs_init(void) {}
+static inline void iova_rcache_debugfs_exit(void) {}
+#endif /* CONFIG_IOMMU_DEBUGFS */
+
 static struct iova *alloc_iova_mem(void)
 {
 	return kmem_cache_zalloc(iova_cache, GFP_ATOMIC | __GFP_NOWARN);
@@ -274,6 +329,8 @@ int iova_cache_get(void)
 			pr_err("Couldn't create iova cache\n");
 			return -ENOMEM;
 		}
+
+		iova_rcache_debugfs_init();
 	}
 
 	iova_cache_users++;
@@ -292,6 +349,7 @@ void iova_cache_put(void)
 	}
 	iova_cache_users--;
 	if (!iova_cache_users) {
+		iova_rcache_debugfs_exit();
 		cpuhp_remove_multi_state(CPUHP_IOMMU_IOVA_DEAD);
 		kmem_cache_destroy(iova_cache);
 	}
@@ -465,6 +523,15 @@ retry:
 
 		/* Try replenishing IOVAs by flushing rcache. */
 		flush_rcache = false;
+		/*
+		 * The caches evidently can't hold the circulating working
+		 * set; let the depots grow so that the next steady state
+		 * keeps more magazines out of the rbtree.
+		 */
+		WRITE_ONCE(iovad->rcache_depot_max,
+			   min_t(unsigned long,
+				 2 * READ_ONCE(iovad->rcache_depot_max),
+				 IOVA_DEPOT_MAX_MAGS));
 		for_each_online_cpu(cpu)
 			free_cpu_cached_iovas(cpu, iovad);
 		free_global_cached_iovas(iovad);
@@ -625,7 +692,20 @@ EXPORT_SYMBOL_GPL(reserve_iova);
  * will be wasted.
  */
 #define IOVA_MAG_SIZE 127
-#define MAX_GLOBAL_MAGS 32	/* magazines per bin */
+
+/* Default and hard cap on the number of depot magazines per bin */
+#define IOVA_DEPOT_DEFAULT_MAGS 32
+#define IOVA_DEPOT_MAX_MAGS 128
+
+/*
+ * Initial per-domain cap on depot magazines per bin.  Runtime-writable;
+ * domains additionally grow their own cap up to IOVA_DEPOT_MAX_MAGS
+ * when allocations keep missing the caches.
+ */
+static unsigned long iova_rcache_depot_max = IOVA_DEPOT_DEFAULT_MAGS;
+module_param(iova_rcache_depot_max, ulong, 0644);
+MODULE_PARM_DESC(iova_rcache_depot_max,
+		 "Depot magazines cached per IOVA size class (max 128)");
 
 struct iova_magazine {
 	unsigned long size;
@@ -641,10 +721,21 @@ struct iova_cpu_rcache {
 struct iova_rcache {
 	spinlock_t lock;
 	unsigned long depot_size;
-	struct iova_magazine *depot[MAX_GLOBAL_MAGS];
+	struct iova_magazine *depot[IOVA_DEPOT_MAX_MAGS];
 	struct iova_cpu_rcache __percpu *cpu_rcaches;
 };
 
+/* Per-size-class cache statistics, summed over all domains */
+struct iova_rcache_stats {
+	u64 hits[IOVA_RANGE_CACHE_MAX_SIZE];	  /* served from a magazine */
+	u64 misses[IOVA_RANGE_CACHE_MAX_SIZE];	  /* fell through to the rbtree */
+	u64 refills[IOVA_RANGE_CACHE_MAX_SIZE];	  /* magazines depot -> cpu */
+	u64 spills[IOVA_RANGE_CACHE_MAX_SIZE];	  /* magazines cpu -> depot */
+	u64 overflows[IOVA_RANGE_CACHE_MAX_SIZE]; /* magazines freed, depot full */
+};
+
+static DEFINE_PER_CPU(struct iova_rcache_stats, rcache_stats);
+
 static struct iova_magazine *iova_magazine_alloc(gfp_t flags)
 {
 	return kzalloc(sizeof(struct iova_magazine), flags);
@@ -722,6 +813,10 @@ int iova_domain_init_rcaches(struct iova_domain *iovad)
 	if (!iovad->rcaches)
 		return -ENOMEM;
 
+	iovad->rcache_depot_max = clamp_t(unsigned long,
+					  READ_ONCE(iova_rcache_depot_max),
+					  1, IOVA_DEPOT_MAX_MAGS);
+
 	for (i = 0; i < IOVA_RANGE_CACHE_MAX_SIZE; ++i) {
 		struct iova_cpu_rcache *cpu_rcache;
 		struct iova_rcache *rcache;
@@ -787,12 +882,17 @@ static bool __iova_rcache_insert(struct iova_domain *iovad,
 		struct iova_magazine *new_mag = iova_magazine_alloc(GFP_ATOMIC);
 
 		if (new_mag) {
+			unsigned int bin = rcache - iovad->rcaches;
+
 			spin_lock(&rcache->lock);
-			if (rcache->depot_size < MAX_GLOBAL_MAGS) {
+			if (rcache->depot_size <
+			    READ_ONCE(iovad->rcache_depot_max)) {
 				rcache->depot[rcache->depot_size++] =
 						cpu_rcache->loaded;
+				this_cpu_inc(rcache_stats.spills[bin]);
 			} else {
 				mag_to_free = cpu_rcache->loaded;
+				this_cpu_inc(rcache_stats.overflows[bin]);
 			}
 			spin_unlock(&rcache->lock);
 
@@ -831,7 +931,8 @@ static bool iova_rcache_insert(struct iova_domain *iovad, unsigned long pfn,
  * it from the 'rcache'.
  */
 static unsigned long __iova_rcache_get(struct iova_rcache *rcache,
-				       unsigned long limit_pfn)
+				       unsigned long limit_pfn,
+				       unsigned int bin)
 {
 	struct iova_cpu_rcache *cpu_rcache;
 	unsigned long iova_pfn = 0;
@@ -852,6 +953,7 @@ static unsigned long __iova_rcache_get(struct iova_rcache *rcache,
 			iova_magazine_free(cpu_rcache->loaded);
 			cpu_rcache->loaded = rcache->depot[--rcache->depot_size];
 			has_pfn = true;
+			this_cpu_inc(rcache_stats.refills[bin]);
 		}
 		spin_unlock(&rcache->lock);
 	}
@@ -874,11 +976,19 @@ static unsigned long iova_rcache_get(struct iova_domain *iovad,
 				     unsigned long limit_pfn)
 {
 	unsigned int log_size = order_base_2(size);
+	unsigned long iova_pfn;
 
 	if (log_size >= IOVA_RANGE_CACHE_MAX_SIZE)
 		return 0;
 
-	return __iova_rcache_get(&iovad->rcaches[log_size], limit_pfn - size);
+	iova_pfn = __iova_rcache_get(&iovad->rcaches[log_size],
+				     limit_pfn - size, log_size);
+	if (iova_pfn)
+		this_cpu_inc(rcache_stats.hits[log_size]);
+	else
+		this_cpu_inc(rcache_stats.misses[log_size]);
+
+	return iova_pfn;
 }
 
 /*
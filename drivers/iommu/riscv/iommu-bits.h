@@ -0,0 +1,185 @@
+/* SPDX-License-Identifier: GPL-2.0-only */
+/*
+ * Register layout, queue formats and command encodings for the ratified
+ * RISC-V IOMMU Architecture Specification, version 1.0.
+ *
+ * Only the parts the driver actually uses are defined here.
+ */
+#ifndef _RISCV_IOMMU_BITS_H_
+#define _RISCV_IOMMU_BITS_H_
+
+#include <linux/bitfield.h>
+#include <linux/bits.h>
+#include <linux/types.h>
+
+/*
+ * Memory-mapped register offsets
+ */
+#define RISCV_IOMMU_REG_CAPS		0x0000
+#define RISCV_IOMMU_REG_FCTL		0x0008
+#define RISCV_IOMMU_REG_DDTP		0x0010
+#define RISCV_IOMMU_REG_CQB		0x0018
+#define RISCV_IOMMU_REG_CQH		0x0020
+#define RISCV_IOMMU_REG_CQT		0x0024
+#define RISCV_IOMMU_REG_FQB		0x0028
+#define RISCV_IOMMU_REG_FQH		0x0030
+#define RISCV_IOMMU_REG_FQT		0x0034
+#define RISCV_IOMMU_REG_CQCSR		0x0048
+#define RISCV_IOMMU_REG_FQCSR		0x004c
+#define RISCV_IOMMU_REG_IPSR		0x0054
+#define RISCV_IOMMU_REG_ICVEC		0x02f8
+
+/* Capabilities register */
+#define RISCV_IOMMU_CAPS_VERSION	GENMASK_ULL(7, 0)
+#define RISCV_IOMMU_CAPS_SV39		BIT_ULL(9)
+#define RISCV_IOMMU_CAPS_SV48		BIT_ULL(10)
+#define RISCV_IOMMU_CAPS_SV57		BIT_ULL(11)
+#define RISCV_IOMMU_CAPS_MSI_FLAT	BIT_ULL(22)
+#define RISCV_IOMMU_CAPS_MSI_MRIF	BIT_ULL(23)
+#define RISCV_IOMMU_CAPS_ATS		BIT_ULL(25)
+#define RISCV_IOMMU_CAPS_IGS		GENMASK_ULL(29, 28)
+#define RISCV_IOMMU_CAPS_PAS		GENMASK_ULL(37, 32)
+#define RISCV_IOMMU_CAPS_PD8		BIT_ULL(38)
+#define RISCV_IOMMU_CAPS_PD17		BIT_ULL(39)
+#define RISCV_IOMMU_CAPS_PD20		BIT_ULL(40)
+
+#define RISCV_IOMMU_CAPS_VERSION_1_0	0x10
+
+/* Interrupt generation support (caps.IGS) */
+#define RISCV_IOMMU_IGS_MSI		0
+#define RISCV_IOMMU_IGS_WSI		1
+#define RISCV_IOMMU_IGS_BOTH		2
+
+/* Features control register */
+#define RISCV_IOMMU_FCTL_BE		BIT(0)
+#define RISCV_IOMMU_FCTL_WSI		BIT(1)
+
+/* Device directory table pointer */
+#define RISCV_IOMMU_DDTP_MODE		GENMASK_ULL(3, 0)
+#define RISCV_IOMMU_DDTP_BUSY		BIT_ULL(4)
+#define RISCV_IOMMU_DDTP_PPN		GENMASK_ULL(53, 10)
+
+#define RISCV_IOMMU_DDTP_MODE_OFF	0
+#define RISCV_IOMMU_DDTP_MODE_BARE	1
+#define RISCV_IOMMU_DDTP_MODE_1LVL	2
+#define RISCV_IOMMU_DDTP_MODE_2LVL	3
+#define RISCV_IOMMU_DDTP_MODE_3LVL	4
+
+/* Queue base registers (CQB/FQB share the layout) */
+#define RISCV_IOMMU_QB_LOG2SZ		GENMASK_ULL(4, 0)
+#define RISCV_IOMMU_QB_PPN		GENMASK_ULL(53, 10)
+
+/* Command-queue CSR */
+#define RISCV_IOMMU_CQCSR_CQEN		BIT(0)
+#define RISCV_IOMMU_CQCSR_CIE		BIT(1)
+#define RISCV_IOMMU_CQCSR_CQMF		BIT(8)
+#define RISCV_IOMMU_CQCSR_CMD_TO	BIT(9)
+#define RISCV_IOMMU_CQCSR_CMD_ILL	BIT(10)
+#define RISCV_IOMMU_CQCSR_FENCE_W_IP	BIT(11)
+#define RISCV_IOMMU_CQCSR_CQON		BIT(16)
+#define RISCV_IOMMU_CQCSR_BUSY		BIT(17)
+
+/* Fault-queue CSR */
+#define RISCV_IOMMU_FQCSR_FQEN		BIT(0)
+#define RISCV_IOMMU_FQCSR_FIE		BIT(1)
+#define RISCV_IOMMU_FQCSR_FQMF		BIT(8)
+#define RISCV_IOMMU_FQCSR_FQOF		BIT(9)
+#define RISCV_IOMMU_FQCSR_FQON		BIT(16)
+#define RISCV_IOMMU_FQCSR_BUSY		BIT(17)
+
+/* Interrupt pending status (write 1 to clear) */
+#define RISCV_IOMMU_IPSR_CIP		BIT(0)
+#define RISCV_IOMMU_IPSR_FIP		BIT(1)
+
+/*
+ * Device directory table
+ *
+ * Non-leaf entries are a single u64: V plus the PPN of the next level.
+ * Leaf entries are device contexts, 32 bytes in the base format and 64
+ * bytes in the extended format (present when caps.MSI_FLAT is set).
+ */
+#define RISCV_IOMMU_DDTE_V		BIT_ULL(0)
+#define RISCV_IOMMU_DDTE_PPN		GENMASK_ULL(53, 10)
+
+/* Device context, indices into the u64 array forming the entry */
+#define RISCV_IOMMU_DC_TC		0
+#define RISCV_IOMMU_DC_IOHGATP		1
+#define RISCV_IOMMU_DC_TA		2
+#define RISCV_IOMMU_DC_FSC		3
+
+#define RISCV_IOMMU_DC_TC_V		BIT_ULL(0)
+#define RISCV_IOMMU_DC_TC_EN_ATS	BIT_ULL(1)
+#define RISCV_IOMMU_DC_TC_EN_PRI	BIT_ULL(2)
+#define RISCV_IOMMU_DC_TC_DTF		BIT_ULL(4)
+#define RISCV_IOMMU_DC_TC_PDTV		BIT_ULL(5)
+#define RISCV_IOMMU_DC_TC_DPE		BIT_ULL(9)
+
+#define RISCV_IOMMU_DC_TA_PSCID		GENMASK_ULL(31, 12)
+
+/* First-stage context (same encoding as satp) */
+#define RISCV_IOMMU_DC_FSC_PPN		GENMASK_ULL(43, 0)
+#define RISCV_IOMMU_DC_FSC_MODE		GENMASK_ULL(63, 60)
+
+#define RISCV_IOMMU_DC_FSC_MODE_BARE	0
+#define RISCV_IOMMU_DC_FSC_MODE_SV39	8
+#define RISCV_IOMMU_DC_FSC_MODE_SV48	9
+
+/* First-stage context when tc.PDTV is set: a process directory table */
+#define RISCV_IOMMU_DC_FSC_MODE_PD8	1
+#define RISCV_IOMMU_DC_FSC_MODE_PD17	2
+#define RISCV_IOMMU_DC_FSC_MODE_PD20	3
+
+/*
+ * Commands, 16 bytes each
+ */
+#define RISCV_IOMMU_CMD_OPCODE		GENMASK_ULL(6, 0)
+#define RISCV_IOMMU_CMD_FUNC		GENMASK_ULL(9, 7)
+
+#define RISCV_IOMMU_CMD_IOTINVAL_OPCODE	1
+#define RISCV_IOMMU_CMD_IOTINVAL_VMA	0
+#define RISCV_IOMMU_CMD_IOTINVAL_GVMA	1
+#define RISCV_IOMMU_CMD_IOTINVAL_AV	BIT_ULL(10)
+#define RISCV_IOMMU_CMD_IOTINVAL_PSCID	GENMASK_ULL(31, 12)
+#define RISCV_IOMMU_CMD_IOTINVAL_PSCV	BIT_ULL(32)
+#define RISCV_IOMMU_CMD_IOTINVAL_GV	BIT_ULL(33)
+#define RISCV_IOMMU_CMD_IOTINVAL_GSCID	GENMASK_ULL(59, 44)
+/* dword1[61:10] holds address bits [63:12] */
+#define RISCV_IOMMU_CMD_IOTINVAL_ADDR(a) ((((u64)(a)) >> 12) << 10)
+
+#define RISCV_IOMMU_CMD_IOFENCE_OPCODE	2
+#define RISCV_IOMMU_CMD_IOFENCE_C	0
+#define RISCV_IOMMU_CMD_IOFENCE_PR	BIT_ULL(10)
+#define RISCV_IOMMU_CMD_IOFENCE_PW	BIT_ULL(11)
+#define RISCV_IOMMU_CMD_IOFENCE_AV	BIT_ULL(12)
+#define RISCV_IOMMU_CMD_IOFENCE_WSI	BIT_ULL(13)
+#define RISCV_IOMMU_CMD_IOFENCE_DATA	GENMASK_ULL(63, 32)
+
+#define RISCV_IOMMU_CMD_IODIR_OPCODE	3
+#define RISCV_IOMMU_CMD_IODIR_INVAL_DDT	0
+#define RISCV_IOMMU_CMD_IODIR_INVAL_PDT	1
+#define RISCV_IOMMU_CMD_IODIR_PID	GENMASK_ULL(31, 12)
+#define RISCV_IOMMU_CMD_IODIR_DV	BIT_ULL(33)
+#define RISCV_IOMMU_CMD_IODIR_DID	GENMASK_ULL(63, 40)
+
+struct riscv_iommu_command {
+	u64 dword0;
+	u64 dword1;
+};
+
+/*
+ * Fault queue record, 32 bytes
+ */
+#define RISCV_IOMMU_FQ_CAUSE		GENMASK_ULL(11, 0)
+#define RISCV_IOMMU_FQ_PID		GENMASK_ULL(31, 12)
+#define RISCV_IOMMU_FQ_PV		BIT_ULL(32)
+#define RISCV_IOMMU_FQ_TTYP		GENMASK_ULL(39, 34)
+#define RISCV_IOMMU_FQ_DID		GENMASK_ULL(63, 40)
+
+struct riscv_iommu_fq_record {
+	u64 hdr;
+	u64 _reserved;
+	u64 iotval;
+	u64 iotval2;
+};
+
+#endif /* _RISCV_IOMMU_BITS_H_ */
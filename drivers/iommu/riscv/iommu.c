@@ -0,0 +1,826 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * Driver for the ratified RISC-V IOMMU Architecture Specification,
+ * version 1.0.
+ *
+ * Translation contexts live in an in-memory device directory table
+ * indexed by device ID. Paging domains use the shared io-pgtable
+ * Sv39/Sv48 allocators; invalidations are batched through the command
+ * queue and only fenced from iotlb_sync(), so a large unmap posts many
+ * IOTINVAL.VMA commands but waits for a single IOFENCE.C.
+ */
+
+#define pr_fmt(fmt)	"riscv-iommu: " fmt
+
+#include <linux/bitfield.h>
+#include <linux/delay.h>
+#include <linux/dma-mapping.h>
+#include <linux/interrupt.h>
+#include <linux/io.h>
+#include <linux/io-64-nonatomic-lo-hi.h>
+#include <linux/io-pgtable.h>
+#include <linux/iommu.h>
+#include <linux/iopoll.h>
+#include <linux/kernel.h>
+#include <linux/module.h>
+#include <linux/of.h>
+#include <linux/of_platform.h>
+#include <linux/pci.h>
+#include <linux/platform_device.h>
+#include <linux/slab.h>
+
+#include "iommu-bits.h"
+
+MODULE_DESCRIPTION("IOMMU driver for the RISC-V IOMMU architecture");
+MODULE_LICENSE("GPL v2");
+
+/* One page per queue: 256 x 16-byte commands, 128 x 32-byte faults */
+#define RISCV_IOMMU_CMDQ_LOG2SZ		8
+#define RISCV_IOMMU_FLTQ_LOG2SZ		7
+
+#define RISCV_IOMMU_CMDQ_ENTRIES	BIT(RISCV_IOMMU_CMDQ_LOG2SZ)
+#define RISCV_IOMMU_FLTQ_ENTRIES	BIT(RISCV_IOMMU_FLTQ_LOG2SZ)
+
+/* Poll granularity and limit for register BUSY bits and IOFENCE waits */
+#define RISCV_IOMMU_POLL_DELAY_US	10
+#define RISCV_IOMMU_POLL_TIMEOUT_US	(100 * USEC_PER_MSEC)
+
+/*
+ * Past this many pages, invalidating the whole PSCID is cheaper than
+ * posting one IOTINVAL.VMA per page.
+ */
+#define RISCV_IOMMU_INVAL_PAGES_MAX	64
+
+/* PSCIDs are 20 bits; 0 is left unused so an unset field is never valid */
+#define RISCV_IOMMU_PSCID_MAX		GENMASK(19, 0)
+
+struct riscv_iommu_device {
+	struct iommu_device iommu;
+	struct device *dev;
+	void __iomem *reg;
+	u64 caps;
+	int irq;
+
+	/* Device directory: three levels, leaves hold device contexts */
+	u64 *ddt_root;
+	bool dc_extended;
+	/* Serialises on-demand directory level allocation */
+	struct mutex ddt_lock;
+
+	/* Command queue, producer side under cmdq_lock */
+	struct riscv_iommu_command *cmdq;
+	dma_addr_t cmdq_phys;
+	unsigned int cmdq_tail;
+	spinlock_t cmdq_lock;
+
+	/* IOFENCE completion slot and the last sequence number posted */
+	u32 *fence;
+	dma_addr_t fence_phys;
+	u32 fence_seq;
+
+	/* Fault queue, consumed from the interrupt handler */
+	struct riscv_iommu_fq_record *fltq;
+	dma_addr_t fltq_phys;
+	unsigned int fltq_head;
+
+	struct ida pscids;
+};
+
+struct riscv_iommu_domain {
+	struct iommu_domain domain;
+
+	/* Set on first attach, when the backing hardware is known */
+	struct riscv_iommu_device *iommu;
+	struct io_pgtable_cfg pgtbl_cfg;
+	struct io_pgtable_ops *pgtbl_ops;
+	int pscid;
+
+	/* Serialises domain finalisation against concurrent attach */
+	struct mutex init_lock;
+};
+
+static struct iommu_ops riscv_iommu_ops;
+
+static struct riscv_iommu_domain *to_riscv_domain(struct iommu_domain *dom)
+{
+	return container_of(dom, struct riscv_iommu_domain, domain);
+}
+
+/*
+ * Command queue
+ *
+ * Commands are posted under cmdq_lock by advancing the tail register;
+ * the IOMMU consumes them in order and advances the head. Callers batch
+ * invalidations by posting without a fence and fencing once from
+ * riscv_iommu_cmd_sync().
+ */
+
+static void riscv_iommu_cmd_post(struct riscv_iommu_device *iommu,
+				 const struct riscv_iommu_command *cmd)
+{
+	unsigned int next = (iommu->cmdq_tail + 1) %
+			    RISCV_IOMMU_CMDQ_ENTRIES;
+	u32 head;
+
+	/* Wait for a free slot; the queue drains in hardware time */
+	if (next == readl_relaxed(iommu->reg + RISCV_IOMMU_REG_CQH)) {
+		if (readl_poll_timeout_atomic(iommu->reg + RISCV_IOMMU_REG_CQH,
+					      head, head != next,
+					      RISCV_IOMMU_POLL_DELAY_US,
+					      RISCV_IOMMU_POLL_TIMEOUT_US)) {
+			dev_err_ratelimited(iommu->dev,
+					    "command queue stalled\n");
+			return;
+		}
+	}
+
+	iommu->cmdq[iommu->cmdq_tail] = *cmd;
+	/* Commands must be visible in memory before the tail moves */
+	dma_wmb();
+	iommu->cmdq_tail = next;
+	writel_relaxed(next, iommu->reg + RISCV_IOMMU_REG_CQT);
+}
+
+static void riscv_iommu_cmd_send(struct riscv_iommu_device *iommu,
+				 const struct riscv_iommu_command *cmd)
+{
+	unsigned long flags;
+
+	spin_lock_irqsave(&iommu->cmdq_lock, flags);
+	riscv_iommu_cmd_post(iommu, cmd);
+	spin_unlock_irqrestore(&iommu->cmdq_lock, flags);
+}
+
+/* Post an IOFENCE.C and wait until its completion write lands */
+static void riscv_iommu_cmd_sync(struct riscv_iommu_device *iommu)
+{
+	struct riscv_iommu_command cmd;
+	unsigned long flags;
+	u32 seq, val;
+
+	spin_lock_irqsave(&iommu->cmdq_lock, flags);
+	seq = ++iommu->fence_seq;
+	cmd.dword0 = FIELD_PREP(RISCV_IOMMU_CMD_OPCODE,
+				RISCV_IOMMU_CMD_IOFENCE_OPCODE) |
+		     FIELD_PREP(RISCV_IOMMU_CMD_FUNC,
+				RISCV_IOMMU_CMD_IOFENCE_C) |
+		     RISCV_IOMMU_CMD_IOFENCE_AV |
+		     FIELD_PREP(RISCV_IOMMU_CMD_IOFENCE_DATA, seq);
+	cmd.dword1 = iommu->fence_phys;
+	riscv_iommu_cmd_post(iommu, &cmd);
+	spin_unlock_irqrestore(&iommu->cmdq_lock, flags);
+
+	/*
+	 * Sequence numbers are compared as a signed delta so the wait
+	 * also completes if a later fence overtakes ours.
+	 */
+	if (readl_poll_timeout_atomic(iommu->fence, val,
+				      (s32)(val - seq) >= 0,
+				      RISCV_IOMMU_POLL_DELAY_US,
+				      RISCV_IOMMU_POLL_TIMEOUT_US))
+		dev_err_ratelimited(iommu->dev, "IOFENCE timeout\n");
+}
+
+static void riscv_iommu_cmd_inval_vma(struct riscv_iommu_device *iommu,
+				      int pscid, u64 addr, bool addr_valid)
+{
+	struct riscv_iommu_command cmd;
+
+	cmd.dword0 = FIELD_PREP(RISCV_IOMMU_CMD_OPCODE,
+				RISCV_IOMMU_CMD_IOTINVAL_OPCODE) |
+		     FIELD_PREP(RISCV_IOMMU_CMD_FUNC,
+				RISCV_IOMMU_CMD_IOTINVAL_VMA) |
+		     RISCV_IOMMU_CMD_IOTINVAL_PSCV |
+		     FIELD_PREP(RISCV_IOMMU_CMD_IOTINVAL_PSCID, pscid);
+	cmd.dword1 = 0;
+	if (addr_valid) {
+		cmd.dword0 |= RISCV_IOMMU_CMD_IOTINVAL_AV;
+		cmd.dword1 = RISCV_IOMMU_CMD_IOTINVAL_ADDR(addr);
+	}
+	riscv_iommu_cmd_send(iommu, &cmd);
+}
+
+static void riscv_iommu_cmd_inval_ddt(struct riscv_iommu_device *iommu,
+				      u32 devid)
+{
+	struct riscv_iommu_command cmd;
+
+	cmd.dword0 = FIELD_PREP(RISCV_IOMMU_CMD_OPCODE,
+				RISCV_IOMMU_CMD_IODIR_OPCODE) |
+		     FIELD_PREP(RISCV_IOMMU_CMD_FUNC,
+				RISCV_IOMMU_CMD_IODIR_INVAL_DDT) |
+		     RISCV_IOMMU_CMD_IODIR_DV |
+		     FIELD_PREP(RISCV_IOMMU_CMD_IODIR_DID, devid);
+	cmd.dword1 = 0;
+	riscv_iommu_cmd_send(iommu, &cmd);
+}
+
+/*
+ * Device directory table
+ *
+ * Always run in 3LVL mode so the full 24-bit device ID space is
+ * addressable; intermediate levels and leaf pages are allocated on
+ * demand at attach time. The device ID is split into directory indices
+ * as the spec prescribes for the base (7/9/8 bits) and extended
+ * (6/9/9 bits) formats.
+ */
+
+static unsigned int riscv_iommu_ddt_index(struct riscv_iommu_device *iommu,
+					  u32 devid, int lvl)
+{
+	unsigned int low_bits = iommu->dc_extended ? 6 : 7;
+
+	switch (lvl) {
+	case 0:
+		return (devid >> (low_bits + 9)) & 0xff;
+	case 1:
+		return (devid >> low_bits) & 0x1ff;
+	default:
+		return devid & ((1U << low_bits) - 1);
+	}
+}
+
+/* Return the device context for @devid, allocating directory levels */
+static u64 *riscv_iommu_get_dc(struct riscv_iommu_device *iommu, u32 devid)
+{
+	unsigned int dc_words = iommu->dc_extended ? 8 : 4;
+	u64 *table = iommu->ddt_root;
+	int lvl;
+
+	mutex_lock(&iommu->ddt_lock);
+	for (lvl = 0; lvl < 2; lvl++) {
+		u64 *ptep = table + riscv_iommu_ddt_index(iommu, devid, lvl);
+		u64 pte = *ptep;
+
+		if (!(pte & RISCV_IOMMU_DDTE_V)) {
+			u64 *new_table = (u64 *)get_zeroed_page(GFP_KERNEL);
+
+			if (!new_table) {
+				mutex_unlock(&iommu->ddt_lock);
+				return NULL;
+			}
+			pte = FIELD_PREP(RISCV_IOMMU_DDTE_PPN,
+					 __pa(new_table) >> PAGE_SHIFT) |
+			      RISCV_IOMMU_DDTE_V;
+			/* Publish the level before linking it in */
+			dma_wmb();
+			WRITE_ONCE(*ptep, pte);
+		}
+
+		table = __va(FIELD_GET(RISCV_IOMMU_DDTE_PPN, pte) <<
+			     PAGE_SHIFT);
+	}
+	mutex_unlock(&iommu->ddt_lock);
+
+	return table + riscv_iommu_ddt_index(iommu, devid, 2) * dc_words;
+}
+
+static void riscv_iommu_write_dc(struct riscv_iommu_device *iommu, u32 devid,
+				 u64 fsc, u64 ta)
+{
+	u64 *dc = riscv_iommu_get_dc(iommu, devid);
+
+	if (WARN_ON(!dc))
+		return;
+
+	/*
+	 * Take the context invalid across the update so the IOMMU never
+	 * observes a half-written tuple, then validate with tc last.
+	 */
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_TC], 0);
+	dma_wmb();
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_IOHGATP], 0);
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_TA], ta);
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_FSC], fsc);
+	dma_wmb();
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_TC], RISCV_IOMMU_DC_TC_V);
+	dma_wmb();
+
+	riscv_iommu_cmd_inval_ddt(iommu, devid);
+}
+
+static void riscv_iommu_clear_dc(struct riscv_iommu_device *iommu, u32 devid)
+{
+	u64 *dc = riscv_iommu_get_dc(iommu, devid);
+
+	if (WARN_ON(!dc))
+		return;
+
+	WRITE_ONCE(dc[RISCV_IOMMU_DC_TC], 0);
+	dma_wmb();
+
+	riscv_iommu_cmd_inval_ddt(iommu, devid);
+}
+
+/*
+ * Fault queue
+ */
+
+static irqreturn_t riscv_iommu_irq(int irq, void *opaque)
+{
+	struct riscv_iommu_device *iommu = opaque;
+	u32 ipsr = readl_relaxed(iommu->reg + RISCV_IOMMU_REG_IPSR);
+	u32 fqcsr, tail;
+
+	if (!(ipsr & (RISCV_IOMMU_IPSR_FIP | RISCV_IOMMU_IPSR_CIP)))
+		return IRQ_NONE;
+
+	if (ipsr & RISCV_IOMMU_IPSR_FIP) {
+		tail = readl_relaxed(iommu->reg + RISCV_IOMMU_REG_FQT);
+		while (iommu->fltq_head != tail) {
+			struct riscv_iommu_fq_record *rec =
+				&iommu->fltq[iommu->fltq_head];
+
+			dev_warn_ratelimited(iommu->dev,
+					     "fault: cause %lld devid %lld iova %#llx\n",
+					     FIELD_GET(RISCV_IOMMU_FQ_CAUSE,
+						       rec->hdr),
+					     FIELD_GET(RISCV_IOMMU_FQ_DID,
+						       rec->hdr),
+					     rec->iotval);
+
+			iommu->fltq_head = (iommu->fltq_head + 1) %
+					   RISCV_IOMMU_FLTQ_ENTRIES;
+		}
+		writel_relaxed(iommu->fltq_head,
+			       iommu->reg + RISCV_IOMMU_REG_FQH);
+
+		/* Acknowledge memory faults or overflow on the queue itself */
+		fqcsr = readl_relaxed(iommu->reg + RISCV_IOMMU_REG_FQCSR);
+		if (fqcsr & (RISCV_IOMMU_FQCSR_FQMF | RISCV_IOMMU_FQCSR_FQOF))
+			writel_relaxed(fqcsr,
+				       iommu->reg + RISCV_IOMMU_REG_FQCSR);
+	}
+
+	writel_relaxed(ipsr, iommu->reg + RISCV_IOMMU_REG_IPSR);
+
+	return IRQ_HANDLED;
+}
+
+/*
+ * IOMMU API
+ */
+
+static struct iommu_domain *riscv_iommu_domain_alloc(unsigned int type)
+{
+	struct riscv_iommu_domain *domain;
+
+	if (type != IOMMU_DOMAIN_DMA && type != IOMMU_DOMAIN_DMA_FQ &&
+	    type != IOMMU_DOMAIN_UNMANAGED && type != IOMMU_DOMAIN_IDENTITY)
+		return NULL;
+
+	domain = kzalloc(sizeof(*domain), GFP_KERNEL);
+	if (!domain)
+		return NULL;
+
+	mutex_init(&domain->init_lock);
+
+	return &domain->domain;
+}
+
+static void riscv_iommu_domain_free(struct iommu_domain *dom)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+
+	if (domain->pgtbl_ops)
+		free_io_pgtable_ops(domain->pgtbl_ops);
+	if (domain->pscid)
+		ida_free(&domain->iommu->pscids, domain->pscid);
+	kfree(domain);
+}
+
+/* Bind a paging domain to the hardware instance it is first attached to */
+static int riscv_iommu_domain_finalize(struct riscv_iommu_domain *domain,
+				       struct riscv_iommu_device *iommu)
+{
+	enum io_pgtable_fmt fmt;
+	int ret = 0;
+
+	mutex_lock(&domain->init_lock);
+	if (domain->iommu) {
+		/* A domain spans at most one IOMMU instance */
+		if (domain->iommu != iommu)
+			ret = -EINVAL;
+		goto out_unlock;
+	}
+
+	if (domain->domain.type == IOMMU_DOMAIN_IDENTITY) {
+		domain->iommu = iommu;
+		goto out_unlock;
+	}
+
+	/* Sv39 keeps the walk one level shorter where it suffices */
+	if (iommu->caps & RISCV_IOMMU_CAPS_SV39) {
+		fmt = RISCV_SV39;
+	} else if (iommu->caps & RISCV_IOMMU_CAPS_SV48) {
+		fmt = RISCV_SV48;
+	} else {
+		ret = -ENODEV;
+		goto out_unlock;
+	}
+
+	domain->pscid = ida_alloc_range(&iommu->pscids, 1,
+					RISCV_IOMMU_PSCID_MAX, GFP_KERNEL);
+	if (domain->pscid < 0) {
+		ret = domain->pscid;
+		domain->pscid = 0;
+		goto out_unlock;
+	}
+
+	domain->pgtbl_cfg = (struct io_pgtable_cfg) {
+		.pgsize_bitmap	= SZ_4K | SZ_2M | SZ_1G,
+		.ias		= fmt == RISCV_SV39 ? 39 : 48,
+		.oas		= FIELD_GET(RISCV_IOMMU_CAPS_PAS, iommu->caps),
+		.coherent_walk	= true,
+		.iommu_dev	= iommu->dev,
+	};
+
+	domain->pgtbl_ops = alloc_io_pgtable_ops(fmt, &domain->pgtbl_cfg,
+						 domain);
+	if (!domain->pgtbl_ops) {
+		ida_free(&iommu->pscids, domain->pscid);
+		domain->pscid = 0;
+		ret = -ENOMEM;
+		goto out_unlock;
+	}
+
+	domain->domain.pgsize_bitmap = domain->pgtbl_cfg.pgsize_bitmap;
+	domain->domain.geometry.aperture_start = 0;
+	domain->domain.geometry.aperture_end =
+		BIT_ULL(domain->pgtbl_cfg.ias - 1) - 1;
+	domain->domain.geometry.force_aperture = true;
+	domain->iommu = iommu;
+
+out_unlock:
+	mutex_unlock(&domain->init_lock);
+	return ret;
+}
+
+static int riscv_iommu_attach_dev(struct iommu_domain *dom, struct device *dev)
+{
+	struct riscv_iommu_device *iommu = dev_iommu_priv_get(dev);
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+	struct iommu_fwspec *fwspec = dev_iommu_fwspec_get(dev);
+	u64 fsc, ta;
+	int ret, i;
+
+	ret = riscv_iommu_domain_finalize(domain, iommu);
+	if (ret)
+		return ret;
+
+	if (dom->type == IOMMU_DOMAIN_IDENTITY) {
+		fsc = FIELD_PREP(RISCV_IOMMU_DC_FSC_MODE,
+				 RISCV_IOMMU_DC_FSC_MODE_BARE);
+		ta = 0;
+	} else {
+		u64 mode = domain->pgtbl_cfg.ias == 39 ?
+			   RISCV_IOMMU_DC_FSC_MODE_SV39 :
+			   RISCV_IOMMU_DC_FSC_MODE_SV48;
+
+		fsc = FIELD_PREP(RISCV_IOMMU_DC_FSC_MODE, mode) |
+		      FIELD_PREP(RISCV_IOMMU_DC_FSC_PPN,
+				 domain->pgtbl_cfg.riscv_cfg.pgd >>
+				 PAGE_SHIFT);
+		ta = FIELD_PREP(RISCV_IOMMU_DC_TA_PSCID, domain->pscid);
+	}
+
+	for (i = 0; i < fwspec->num_ids; i++)
+		riscv_iommu_write_dc(iommu, fwspec->ids[i], fsc, ta);
+
+	riscv_iommu_cmd_sync(iommu);
+
+	return 0;
+}
+
+static void riscv_iommu_detach_dev(struct iommu_domain *dom,
+				   struct device *dev)
+{
+	struct riscv_iommu_device *iommu = dev_iommu_priv_get(dev);
+	struct iommu_fwspec *fwspec = dev_iommu_fwspec_get(dev);
+	int i;
+
+	for (i = 0; i < fwspec->num_ids; i++)
+		riscv_iommu_clear_dc(iommu, fwspec->ids[i]);
+
+	riscv_iommu_cmd_sync(iommu);
+}
+
+static int riscv_iommu_map_pages(struct iommu_domain *dom, unsigned long iova,
+				 phys_addr_t paddr, size_t pgsize,
+				 size_t pgcount, int prot, gfp_t gfp,
+				 size_t *mapped)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+
+	if (!domain->pgtbl_ops)
+		return -ENODEV;
+
+	return domain->pgtbl_ops->map_pages(domain->pgtbl_ops, iova, paddr,
+					    pgsize, pgcount, prot, gfp,
+					    mapped);
+}
+
+static size_t riscv_iommu_unmap_pages(struct iommu_domain *dom,
+				      unsigned long iova, size_t pgsize,
+				      size_t pgcount,
+				      struct iommu_iotlb_gather *gather)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+
+	if (!domain->pgtbl_ops)
+		return 0;
+
+	return domain->pgtbl_ops->unmap_pages(domain->pgtbl_ops, iova, pgsize,
+					      pgcount, gather);
+}
+
+static void riscv_iommu_flush_iotlb_all(struct iommu_domain *dom)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+
+	if (!domain->iommu || !domain->pscid)
+		return;
+
+	riscv_iommu_cmd_inval_vma(domain->iommu, domain->pscid, 0, false);
+	riscv_iommu_cmd_sync(domain->iommu);
+}
+
+static void riscv_iommu_iotlb_sync(struct iommu_domain *dom,
+				   struct iommu_iotlb_gather *gather)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+	struct riscv_iommu_device *iommu = domain->iommu;
+	size_t pgsize = gather->pgsize;
+	unsigned long iova;
+
+	if (!iommu || !pgsize)
+		return;
+
+	/*
+	 * Post one command per page for small ranges; past the threshold
+	 * a single all-addresses invalidation of the PSCID is cheaper
+	 * than flooding the queue.
+	 */
+	if ((gather->end - gather->start + 1) / pgsize >
+	    RISCV_IOMMU_INVAL_PAGES_MAX) {
+		riscv_iommu_cmd_inval_vma(iommu, domain->pscid, 0, false);
+	} else {
+		for (iova = gather->start; iova < gather->end; iova += pgsize)
+			riscv_iommu_cmd_inval_vma(iommu, domain->pscid, iova,
+						  true);
+	}
+
+	riscv_iommu_cmd_sync(iommu);
+}
+
+static phys_addr_t riscv_iommu_iova_to_phys(struct iommu_domain *dom,
+					    dma_addr_t iova)
+{
+	struct riscv_iommu_domain *domain = to_riscv_domain(dom);
+
+	if (!domain->pgtbl_ops)
+		return 0;
+
+	return domain->pgtbl_ops->iova_to_phys(domain->pgtbl_ops, iova);
+}
+
+static struct iommu_device *riscv_iommu_probe_device(struct device *dev)
+{
+	struct riscv_iommu_device *iommu = dev_iommu_priv_get(dev);
+
+	if (!iommu)
+		return ERR_PTR(-ENODEV);
+
+	return &iommu->iommu;
+}
+
+static void riscv_iommu_probe_finalize(struct device *dev)
+{
+	/* First-come first-served translation domains cover all of DMA */
+	iommu_setup_dma_ops(dev, 0, U64_MAX);
+}
+
+static void riscv_iommu_release_device(struct device *dev)
+{
+}
+
+static struct iommu_group *riscv_iommu_device_group(struct device *dev)
+{
+	if (dev_is_pci(dev))
+		return pci_device_group(dev);
+	return generic_device_group(dev);
+}
+
+static int riscv_iommu_of_xlate(struct device *dev,
+				struct of_phandle_args *args)
+{
+	struct platform_device *iommu_pdev;
+
+	if (args->args_count != 1)
+		return -EINVAL;
+
+	iommu_pdev = of_find_device_by_node(args->np);
+	if (!iommu_pdev || !platform_get_drvdata(iommu_pdev))
+		return -EPROBE_DEFER;
+
+	dev_iommu_priv_set(dev, platform_get_drvdata(iommu_pdev));
+
+	return iommu_fwspec_add_ids(dev, args->args, 1);
+}
+
+static struct iommu_ops riscv_iommu_ops = {
+	.domain_alloc = riscv_iommu_domain_alloc,
+	.probe_device = riscv_iommu_probe_device,
+	.probe_finalize = riscv_iommu_probe_finalize,
+	.release_device = riscv_iommu_release_device,
+	.device_group = riscv_iommu_device_group,
+	.of_xlate = riscv_iommu_of_xlate,
+	.pgsize_bitmap = SZ_4K | SZ_2M | SZ_1G,
+	.owner = THIS_MODULE,
+	.default_domain_ops = &(const struct iommu_domain_ops) {
+		.attach_dev	= riscv_iommu_attach_dev,
+		.detach_dev	= riscv_iommu_detach_dev,
+		.map_pages	= riscv_iommu_map_pages,
+		.unmap_pages	= riscv_iommu_unmap_pages,
+		.flush_iotlb_all = riscv_iommu_flush_iotlb_all,
+		.iotlb_sync	= riscv_iommu_iotlb_sync,
+		.iova_to_phys	= riscv_iommu_iova_to_phys,
+		.free		= riscv_iommu_domain_free,
+	}
+};
+
+/*
+ * Hardware bring-up
+ */
+
+static int riscv_iommu_queue_enable(struct riscv_iommu_device *iommu,
+				    unsigned int qb, unsigned int csr,
+				    dma_addr_t phys, unsigned int log2sz,
+				    u32 enable, u32 on, u32 busy)
+{
+	u32 val;
+
+	writeq_relaxed(FIELD_PREP(RISCV_IOMMU_QB_LOG2SZ, log2sz - 1) |
+		       FIELD_PREP(RISCV_IOMMU_QB_PPN, phys >> PAGE_SHIFT),
+		       iommu->reg + qb);
+	writel_relaxed(enable, iommu->reg + csr);
+
+	return readl_poll_timeout(iommu->reg + csr, val,
+				  (val & on) && !(val & busy),
+				  RISCV_IOMMU_POLL_DELAY_US,
+				  RISCV_IOMMU_POLL_TIMEOUT_US);
+}
+
+static int riscv_iommu_enable(struct riscv_iommu_device *iommu)
+{
+	u64 ddtp;
+	int ret;
+
+	/* Route all interrupt causes to vector 0 */
+	writeq_relaxed(0, iommu->reg + RISCV_IOMMU_REG_ICVEC);
+
+	ret = riscv_iommu_queue_enable(iommu, RISCV_IOMMU_REG_CQB,
+				       RISCV_IOMMU_REG_CQCSR,
+				       iommu->cmdq_phys,
+				       RISCV_IOMMU_CMDQ_LOG2SZ,
+				       RISCV_IOMMU_CQCSR_CQEN,
+				       RISCV_IOMMU_CQCSR_CQON,
+				       RISCV_IOMMU_CQCSR_BUSY);
+	if (ret)
+		return ret;
+
+	ret = riscv_iommu_queue_enable(iommu, RISCV_IOMMU_REG_FQB,
+				       RISCV_IOMMU_REG_FQCSR,
+				       iommu->fltq_phys,
+				       RISCV_IOMMU_FLTQ_LOG2SZ,
+				       RISCV_IOMMU_FQCSR_FQEN |
+				       RISCV_IOMMU_FQCSR_FIE,
+				       RISCV_IOMMU_FQCSR_FQON,
+				       RISCV_IOMMU_FQCSR_BUSY);
+	if (ret)
+		return ret;
+
+	writeq_relaxed(FIELD_PREP(RISCV_IOMMU_DDTP_MODE,
+				  RISCV_IOMMU_DDTP_MODE_3LVL) |
+		       FIELD_PREP(RISCV_IOMMU_DDTP_PPN,
+				  __pa(iommu->ddt_root) >> PAGE_SHIFT),
+		       iommu->reg + RISCV_IOMMU_REG_DDTP);
+
+	return readq_poll_timeout(iommu->reg + RISCV_IOMMU_REG_DDTP, ddtp,
+				  !(ddtp & RISCV_IOMMU_DDTP_BUSY),
+				  RISCV_IOMMU_POLL_DELAY_US,
+				  RISCV_IOMMU_POLL_TIMEOUT_US);
+}
+
+static int riscv_iommu_probe(struct platform_device *pdev)
+{
+	struct device *dev = &pdev->dev;
+	struct riscv_iommu_device *iommu;
+	u32 igs, fctl;
+	int ret;
+
+	iommu = devm_kzalloc(dev, sizeof(*iommu), GFP_KERNEL);
+	if (!iommu)
+		return -ENOMEM;
+
+	iommu->dev = dev;
+	mutex_init(&iommu->ddt_lock);
+	spin_lock_init(&iommu->cmdq_lock);
+	ida_init(&iommu->pscids);
+
+	iommu->reg = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(iommu->reg))
+		return PTR_ERR(iommu->reg);
+
+	iommu->caps = readq_relaxed(iommu->reg + RISCV_IOMMU_REG_CAPS);
+	if (FIELD_GET(RISCV_IOMMU_CAPS_VERSION, iommu->caps) !=
+	    RISCV_IOMMU_CAPS_VERSION_1_0) {
+		dev_err(dev, "unsupported architecture version %#llx\n",
+			FIELD_GET(RISCV_IOMMU_CAPS_VERSION, iommu->caps));
+		return -ENODEV;
+	}
+
+	if (!(iommu->caps & (RISCV_IOMMU_CAPS_SV39 |
+			     RISCV_IOMMU_CAPS_SV48))) {
+		dev_err(dev, "no supported first-stage translation mode\n");
+		return -ENODEV;
+	}
+
+	iommu->dc_extended = !!(iommu->caps & RISCV_IOMMU_CAPS_MSI_FLAT);
+
+	/* Wire-signalled interrupts, when the implementation offers them */
+	igs = FIELD_GET(RISCV_IOMMU_CAPS_IGS, iommu->caps);
+	iommu->irq = platform_get_irq_optional(pdev, 0);
+	if (iommu->irq > 0 && igs != RISCV_IOMMU_IGS_MSI) {
+		fctl = readl_relaxed(iommu->reg + RISCV_IOMMU_REG_FCTL);
+		writel_relaxed(fctl | RISCV_IOMMU_FCTL_WSI,
+			       iommu->reg + RISCV_IOMMU_REG_FCTL);
+	} else {
+		iommu->irq = 0;
+	}
+
+	iommu->cmdq = dmam_alloc_coherent(dev, PAGE_SIZE, &iommu->cmdq_phys,
+					  GFP_KERNEL);
+	iommu->fltq = dmam_alloc_coherent(dev, PAGE_SIZE, &iommu->fltq_phys,
+					  GFP_KERNEL);
+	iommu->fence = dmam_alloc_coherent(dev, sizeof(*iommu->fence),
+					   &iommu->fence_phys, GFP_KERNEL);
+	if (!iommu->cmdq || !iommu->fltq || !iommu->fence)
+		return -ENOMEM;
+
+	iommu->ddt_root = (u64 *)get_zeroed_page(GFP_KERNEL);
+	if (!iommu->ddt_root)
+		return -ENOMEM;
+
+	ret = riscv_iommu_enable(iommu);
+	if (ret) {
+		dev_err(dev, "failed to bring up translation: %d\n", ret);
+		goto err_free_ddt;
+	}
+
+	if (iommu->irq) {
+		ret = devm_request_irq(dev, iommu->irq,
+				       riscv_iommu_irq, 0,
+				       dev_name(dev), iommu);
+		if (ret)
+			goto err_free_ddt;
+	}
+
+	platform_set_drvdata(pdev, iommu);
+
+	ret = iommu_device_sysfs_add(&iommu->iommu, dev, NULL, "%s",
+				     dev_name(dev));
+	if (ret)
+		goto err_free_ddt;
+
+	ret = iommu_device_register(&iommu->iommu, &riscv_iommu_ops, dev);
+	if (ret)
+		goto err_sysfs_remove;
+
+	dev_info(dev, "RISC-V IOMMU, %s first stage, %s device contexts\n",
+		 iommu->caps & RISCV_IOMMU_CAPS_SV39 ? "Sv39" : "Sv48",
+		 iommu->dc_extended ? "extended" : "base");
+
+	return 0;
+
+err_sysfs_remove:
+	iommu_device_sysfs_remove(&iommu->iommu);
+err_free_ddt:
+	free_page((unsigned long)iommu->ddt_root);
+	return ret;
+}
+
+static const struct of_device_id riscv_iommu_of_match[] = {
+	{ .compatible = "riscv,iommu" },
+	{}
+};
+
+static struct platform_driver riscv_iommu_driver = {
+	.driver	= {
+		.name			= "riscv-iommu",
+		.of_match_table		= riscv_iommu_of_match,
+		.suppress_bind_attrs	= true,
+	},
+	.probe	= riscv_iommu_probe,
+};
+builtin_platform_driver(riscv_iommu_driver);
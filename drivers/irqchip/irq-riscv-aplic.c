@@ -0,0 +1,308 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Driver for the RISC-V Advanced Platform-Level Interrupt Controller
+ * (APLIC) in MSI delivery mode.
+ *
+ * In MSI mode the APLIC does not latch and claim interrupts itself: each
+ * wired source is converted into an MSI write to one hart's IMSIC
+ * interrupt file. Every source therefore allocates an identity from the
+ * IMSIC base domain underneath it, delivery is per hart with no shared
+ * claim registers, and an affinity change reprograms the source's target
+ * register instead of rerouting inside a shared controller.
+ *
+ * Direct delivery mode (APLIC used like a PLIC, without an IMSIC) is not
+ * supported; machines without an IMSIC keep using the PLIC driver.
+ */
+
+#define pr_fmt(fmt) "riscv-aplic: " fmt
+#include <linux/bitfield.h>
+#include <linux/io.h>
+#include <linux/irq.h>
+#include <linux/irqchip.h>
+#include <linux/irqchip/riscv-imsic.h>
+#include <linux/irqdomain.h>
+#include <linux/module.h>
+#include <linux/msi.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/of_irq.h>
+#include <linux/platform_device.h>
+
+#define APLIC_DOMAINCFG			0x0000
+#define  APLIC_DOMAINCFG_IE		BIT(8)
+#define  APLIC_DOMAINCFG_DM		BIT(2)
+
+#define APLIC_SOURCECFG_BASE		0x0004
+#define  APLIC_SOURCECFG_SM_INACTIVE	0x0
+#define  APLIC_SOURCECFG_SM_DETACHED	0x1
+#define  APLIC_SOURCECFG_SM_EDGE_RISE	0x4
+#define  APLIC_SOURCECFG_SM_EDGE_FALL	0x5
+#define  APLIC_SOURCECFG_SM_LEVEL_HIGH	0x6
+#define  APLIC_SOURCECFG_SM_LEVEL_LOW	0x7
+
+#define APLIC_CLRIP_BASE		0x1d00
+#define APLIC_SETIPNUM_LE		0x2000
+#define APLIC_SETIENUM			0x1edc
+#define APLIC_CLRIENUM			0x1fdc
+
+#define APLIC_TARGET_BASE		0x3004
+#define  APLIC_TARGET_HART_IDX		GENMASK(31, 18)
+#define  APLIC_TARGET_GUEST_IDX		GENMASK(17, 12)
+#define  APLIC_TARGET_EIID		GENMASK(10, 0)
+
+#define APLIC_IRQBITS_PER_REG		32
+
+struct aplic_priv {
+	struct device		*dev;
+	void __iomem		*regs;
+	u32			nr_irqs;
+	struct irq_domain	*irqdomain;
+};
+
+static void __iomem *aplic_sourcecfg(struct aplic_priv *priv,
+				     irq_hw_number_t hwirq)
+{
+	return priv->regs + APLIC_SOURCECFG_BASE + (hwirq - 1) * sizeof(u32);
+}
+
+static void __iomem *aplic_target(struct aplic_priv *priv,
+				  irq_hw_number_t hwirq)
+{
+	return priv->regs + APLIC_TARGET_BASE + (hwirq - 1) * sizeof(u32);
+}
+
+/*
+ * Reprogram the source's target register from the parent IMSIC vector:
+ * hart index from the interrupt-file address, interrupt identity from
+ * the MSI data word.
+ */
+static void aplic_msi_write_target(struct irq_data *d)
+{
+	struct aplic_priv *priv = irq_data_get_irq_chip_data(d);
+	struct msi_msg msg;
+	phys_addr_t pa;
+	u32 val;
+
+	irq_chip_compose_msi_msg(irq_data_get_irq_parent_data(d), &msg);
+	pa = ((phys_addr_t)msg.address_hi << 32) | msg.address_lo;
+
+	val = FIELD_PREP(APLIC_TARGET_HART_IDX, imsic_pa_to_hartindex(pa)) |
+	      FIELD_PREP(APLIC_TARGET_EIID, msg.data);
+	writel(val, aplic_target(priv, d->hwirq));
+}
+
+static void aplic_msi_irq_mask(struct irq_data *d)
+{
+	struct aplic_priv *priv = irq_data_get_irq_chip_data(d);
+
+	writel(d->hwirq, priv->regs + APLIC_CLRIENUM);
+	irq_chip_mask_parent(d);
+}
+
+static void aplic_msi_irq_unmask(struct irq_data *d)
+{
+	struct aplic_priv *priv = irq_data_get_irq_chip_data(d);
+
+	irq_chip_unmask_parent(d);
+	writel(d->hwirq, priv->regs + APLIC_SETIENUM);
+}
+
+/*
+ * In MSI mode the APLIC forwards a level-triggered source once, when it
+ * asserts. If the line is still asserted at EOI time the gateway must be
+ * repinged so another MSI is sent, otherwise the interrupt is lost.
+ */
+static void aplic_msi_irq_eoi(struct irq_data *d)
+{
+	struct aplic_priv *priv = irq_data_get_irq_chip_data(d);
+	u32 reg_off, reg_mask;
+
+	reg_off = APLIC_CLRIP_BASE +
+		  (d->hwirq / APLIC_IRQBITS_PER_REG) * sizeof(u32);
+	reg_mask = BIT(d->hwirq % APLIC_IRQBITS_PER_REG);
+
+	switch (irqd_get_trigger_type(d)) {
+	case IRQ_TYPE_LEVEL_LOW:
+		if (!(readl(priv->regs + reg_off) & reg_mask))
+			writel(d->hwirq, priv->regs + APLIC_SETIPNUM_LE);
+		break;
+	case IRQ_TYPE_LEVEL_HIGH:
+		if (readl(priv->regs + reg_off) & reg_mask)
+			writel(d->hwirq, priv->regs + APLIC_SETIPNUM_LE);
+		break;
+	}
+}
+
+static int aplic_msi_irq_set_type(struct irq_data *d, unsigned int type)
+{
+	struct aplic_priv *priv = irq_data_get_irq_chip_data(d);
+	u32 sm;
+
+	switch (type) {
+	case IRQ_TYPE_NONE:
+		sm = APLIC_SOURCECFG_SM_DETACHED;
+		break;
+	case IRQ_TYPE_EDGE_RISING:
+		sm = APLIC_SOURCECFG_SM_EDGE_RISE;
+		break;
+	case IRQ_TYPE_EDGE_FALLING:
+		sm = APLIC_SOURCECFG_SM_EDGE_FALL;
+		break;
+	case IRQ_TYPE_LEVEL_HIGH:
+		sm = APLIC_SOURCECFG_SM_LEVEL_HIGH;
+		break;
+	case IRQ_TYPE_LEVEL_LOW:
+		sm = APLIC_SOURCECFG_SM_LEVEL_LOW;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	writel(sm, aplic_sourcecfg(priv, d->hwirq));
+	return 0;
+}
+
+static int aplic_msi_irq_set_affinity(struct irq_data *d,
+				      const struct cpumask *mask_val,
+				      bool force)
+{
+	int ret;
+
+	ret = irq_chip_set_affinity_parent(d, mask_val, force);
+	if (ret >= 0)
+		aplic_msi_write_target(d);
+
+	return ret;
+}
+
+static struct irq_chip aplic_msi_chip = {
+	.name			= "RISC-V APLIC-MSI",
+	.irq_mask		= aplic_msi_irq_mask,
+	.irq_unmask		= aplic_msi_irq_unmask,
+	.irq_eoi		= aplic_msi_irq_eoi,
+	.irq_set_type		= aplic_msi_irq_set_type,
+	.irq_set_affinity	= aplic_msi_irq_set_affinity,
+};
+
+static int aplic_irq_domain_translate(struct irq_domain *d,
+				      struct irq_fwspec *fwspec,
+				      unsigned long *hwirq,
+				      unsigned int *type)
+{
+	struct aplic_priv *priv = d->host_data;
+
+	if (fwspec->param_count != 2)
+		return -EINVAL;
+	if (!fwspec->param[0] || fwspec->param[0] > priv->nr_irqs)
+		return -EINVAL;
+
+	*hwirq = fwspec->param[0];
+	*type = fwspec->param[1] & IRQ_TYPE_SENSE_MASK;
+	return 0;
+}
+
+static int aplic_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
+				  unsigned int nr_irqs, void *arg)
+{
+	struct aplic_priv *priv = domain->host_data;
+	struct irq_fwspec *fwspec = arg;
+	irq_hw_number_t hwirq;
+	unsigned int type;
+	int i, ret;
+
+	ret = aplic_irq_domain_translate(domain, fwspec, &hwirq, &type);
+	if (ret)
+		return ret;
+
+	ret = irq_domain_alloc_irqs_parent(domain, virq, nr_irqs, NULL);
+	if (ret)
+		return ret;
+
+	for (i = 0; i < nr_irqs; i++)
+		irq_domain_set_info(domain, virq + i, hwirq + i,
+				    &aplic_msi_chip, priv,
+				    handle_fasteoi_irq, NULL, NULL);
+
+	return 0;
+}
+
+static int aplic_irq_domain_activate(struct irq_domain *domain,
+				     struct irq_data *d, bool reserve)
+{
+	aplic_msi_write_target(d);
+	return 0;
+}
+
+static const struct irq_domain_ops aplic_irq_domain_ops = {
+	.translate	= aplic_irq_domain_translate,
+	.alloc		= aplic_irq_domain_alloc,
+	.free		= irq_domain_free_irqs_parent,
+	.activate	= aplic_irq_domain_activate,
+};
+
+static int aplic_probe(struct platform_device *pdev)
+{
+	struct device_node *node = pdev->dev.of_node;
+	struct irq_domain *parent_domain;
+	struct aplic_priv *priv;
+	u32 val;
+	int i;
+
+	parent_domain = imsic_get_base_domain();
+	if (!parent_domain)
+		return -EPROBE_DEFER;
+
+	priv = devm_kzalloc(&pdev->dev, sizeof(*priv), GFP_KERNEL);
+	if (!priv)
+		return -ENOMEM;
+	priv->dev = &pdev->dev;
+
+	priv->regs = devm_platform_ioremap_resource(pdev, 0);
+	if (IS_ERR(priv->regs))
+		return PTR_ERR(priv->regs);
+
+	if (of_property_read_u32(node, "riscv,num-sources", &priv->nr_irqs) ||
+	    !priv->nr_irqs) {
+		dev_err(&pdev->dev, "invalid riscv,num-sources\n");
+		return -EINVAL;
+	}
+
+	/* All sources inactive until a driver claims them */
+	for (i = 1; i <= priv->nr_irqs; i++)
+		writel(APLIC_SOURCECFG_SM_INACTIVE, aplic_sourcecfg(priv, i));
+
+	writel(APLIC_DOMAINCFG_IE | APLIC_DOMAINCFG_DM,
+	       priv->regs + APLIC_DOMAINCFG);
+	val = readl(priv->regs + APLIC_DOMAINCFG);
+	if (!(val & APLIC_DOMAINCFG_DM)) {
+		dev_err(&pdev->dev, "MSI delivery mode not supported\n");
+		return -ENODEV;
+	}
+
+	priv->irqdomain = irq_domain_create_hierarchy(parent_domain, 0,
+						      priv->nr_irqs + 1,
+						      of_node_to_fwnode(node),
+						      &aplic_irq_domain_ops,
+						      priv);
+	if (!priv->irqdomain)
+		return -ENOMEM;
+
+	dev_info(&pdev->dev, "%d wired interrupts forwarded as MSIs\n",
+		 priv->nr_irqs);
+	return 0;
+}
+
+static const struct of_device_id aplic_match[] = {
+	{ .compatible = "riscv,aplic" },
+	{}
+};
+
+static struct platform_driver aplic_driver = {
+	.driver = {
+		.name			= "riscv-aplic",
+		.of_match_table		= aplic_match,
+		.suppress_bind_attrs	= true,
+	},
+	.probe = aplic_probe,
+};
+builtin_platform_driver(aplic_driver);
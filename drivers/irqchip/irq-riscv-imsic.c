@@ -0,0 +1,544 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * Driver for the RISC-V Incoming MSI Controller (IMSIC)
+ *
+ * Every hart owns a supervisor interrupt file: a page of MMIO into which
+ * a 32-bit store raises interrupt identity <data> on that hart, and a set
+ * of indirectly accessed CSRs to enable/claim identities. Interrupt
+ * identity 1 is reserved for IPIs, delivered as plain MMIO stores instead
+ * of SBI ecalls; the remaining identities back a linear irq domain with
+ * PCI and platform MSI domains stacked on top, so devices get per-hart
+ * MSI delivery and affinity changes are a file-address rewrite instead of
+ * a route-register rewrite in a shared controller.
+ *
+ * The enable bits of an interrupt file can only be written from its own
+ * hart, so each CPU keeps a bitmap of the identities routed to it and
+ * remote updates are applied through irq_work on the target CPU.
+ */
+
+#define pr_fmt(fmt) "riscv-imsic: " fmt
+#include <linux/bitmap.h>
+#include <linux/cpu.h>
+#include <linux/io.h>
+#include <linux/irq.h>
+#include <linux/irq_work.h>
+#include <linux/irqchip.h>
+#include <linux/irqchip/chained_irq.h>
+#include <linux/irqchip/riscv-imsic.h>
+#include <linux/irqdomain.h>
+#include <linux/msi.h>
+#include <linux/mutex.h>
+#include <linux/of.h>
+#include <linux/of_address.h>
+#include <linux/of_irq.h>
+#include <linux/slab.h>
+#include <linux/smp.h>
+#include <linux/spinlock.h>
+#include <asm/smp.h>
+
+/* Per-hart interrupt-file register layout */
+#define IMSIC_MMIO_PAGE_SHIFT		12
+#define IMSIC_MMIO_PAGE_SZ		BIT(IMSIC_MMIO_PAGE_SHIFT)
+#define IMSIC_MMIO_SETIPNUM_LE		0x00
+
+/* Identity used for IPIs; identity 0 means "no interrupt" */
+#define IMSIC_IPI_ID			1
+
+struct imsic_vector {
+	unsigned int		cpu;
+	u32			id;
+};
+
+static struct {
+	struct irq_domain	*base_domain;
+	phys_addr_t		base_pa;
+	unsigned long		stride;
+	u32			num_ids;
+	struct imsic_vector	*vectors;	/* [num_ids + 1] */
+	unsigned long		*ids_bitmap;	/* identity allocation */
+	struct mutex		ids_lock;	/* protects ids_bitmap */
+	raw_spinlock_t		enable_lock;	/* per-cpu enable bitmaps */
+} imsic;
+
+static int imsic_parent_irq __ro_after_init;
+static void __iomem *imsic_ipi_target[NR_CPUS] __ro_after_init;
+static u32 imsic_file_index[NR_CPUS] __ro_after_init;
+static DEFINE_PER_CPU(unsigned long *, imsic_enable_bitmap);
+static DEFINE_PER_CPU(struct irq_work, imsic_sync_work);
+static DEFINE_PER_CPU(unsigned long *, imsic_move_bitmap);
+static DEFINE_PER_CPU(struct irq_work, imsic_move_work);
+
+static void imsic_ipi_inject(const struct cpumask *mask)
+{
+	unsigned int cpu;
+
+	/*
+	 * Order stores done before the IPI against the setipnum write;
+	 * the MSI store itself is not ordered by a fence on the sender.
+	 */
+	mb();
+
+	for_each_cpu(cpu, mask)
+		writel(IMSIC_IPI_ID, imsic_ipi_target[cpu]);
+}
+
+static const struct riscv_ipi_ops imsic_ipi_ops = {
+	.ipi_inject	= imsic_ipi_inject,
+};
+
+/*
+ * Rewrite this hart's identity enable registers from its bitmap.
+ * On XLEN == 64 the even-numbered eie registers each cover one
+ * 64-bit word of the bitmap. Caller holds imsic.enable_lock.
+ */
+static void imsic_local_apply(void)
+{
+	unsigned long *en = *this_cpu_ptr(&imsic_enable_bitmap);
+	int i;
+
+	for (i = 0; i < BITS_TO_LONGS(imsic.num_ids + 1); i++) {
+		csr_write(CSR_SISELECT, IMSIC_EIE0 + 2 * i);
+		csr_write(CSR_SIREG, en[i]);
+	}
+}
+
+static void imsic_sync_work_func(struct irq_work *work)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&imsic.enable_lock, flags);
+	imsic_local_apply();
+	raw_spin_unlock_irqrestore(&imsic.enable_lock, flags);
+}
+
+/*
+ * Re-inject identities that were moved away from this hart while an MSI
+ * for them was already pending in its interrupt file.  Runs on the hart
+ * owning the old file, since the pending array, like the enables, is
+ * only readable through the local siselect window.  Caller holds
+ * imsic.enable_lock.
+ *
+ * The stale pending bit is deliberately left behind: clearing it would
+ * take a read-modify-write of the whole eip word, racing with MSIs
+ * landing in neighbouring bits, and a pending-but-disabled bit is
+ * harmless - at worst it replays one spurious interrupt if the identity
+ * ever moves back here.
+ */
+static void imsic_local_forward(void)
+{
+	unsigned long *mv = *this_cpu_ptr(&imsic_move_bitmap);
+	unsigned long pending;
+	unsigned int id;
+
+	for_each_set_bit(id, mv, imsic.num_ids + 1) {
+		csr_write(CSR_SISELECT,
+			  IMSIC_EIP0 + 2 * (id / BITS_PER_LONG));
+		pending = csr_read(CSR_SIREG);
+		if (pending & BIT(id % BITS_PER_LONG))
+			writel(id, imsic_ipi_target[READ_ONCE(imsic.vectors[id].cpu)]);
+		clear_bit(id, mv);
+	}
+}
+
+static void imsic_move_work_func(struct irq_work *work)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&imsic.enable_lock, flags);
+	imsic_local_forward();
+	raw_spin_unlock_irqrestore(&imsic.enable_lock, flags);
+}
+
+/*
+ * Ask @old_cpu to check its interrupt file for a pending @id and
+ * re-inject it at the identity's new home.  A message-signaled edge
+ * does not re-assert at the new target the way a wired level interrupt
+ * does, so an MSI that already landed in the old file when the identity
+ * moved would otherwise sit there pending and disabled forever - one
+ * lost completion interrupt is enough to hang a device queue.
+ */
+static void imsic_id_forward_pending(unsigned int old_cpu, u32 id)
+{
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&imsic.enable_lock, flags);
+	set_bit(id, per_cpu(imsic_move_bitmap, old_cpu));
+	if (old_cpu == smp_processor_id())
+		imsic_local_forward();
+	else
+		irq_work_queue_on(&per_cpu(imsic_move_work, old_cpu), old_cpu);
+	raw_spin_unlock_irqrestore(&imsic.enable_lock, flags);
+}
+
+static void imsic_id_set_enable(unsigned int cpu, u32 id, bool enable)
+{
+	unsigned long *en = per_cpu(imsic_enable_bitmap, cpu);
+	unsigned long flags;
+
+	raw_spin_lock_irqsave(&imsic.enable_lock, flags);
+	if (enable)
+		set_bit(id, en);
+	else
+		clear_bit(id, en);
+	if (cpu == smp_processor_id())
+		imsic_local_apply();
+	else
+		irq_work_queue_on(&per_cpu(imsic_sync_work, cpu), cpu);
+	raw_spin_unlock_irqrestore(&imsic.enable_lock, flags);
+}
+
+static void imsic_irq_mask(struct irq_data *d)
+{
+	struct imsic_vector *vec = irq_data_get_irq_chip_data(d);
+
+	imsic_id_set_enable(vec->cpu, vec->id, false);
+}
+
+static void imsic_irq_unmask(struct irq_data *d)
+{
+	struct imsic_vector *vec = irq_data_get_irq_chip_data(d);
+
+	imsic_id_set_enable(vec->cpu, vec->id, true);
+}
+
+static void imsic_irq_compose_msi_msg(struct irq_data *d, struct msi_msg *msg)
+{
+	struct imsic_vector *vec = irq_data_get_irq_chip_data(d);
+	phys_addr_t pa = imsic.base_pa +
+			 (phys_addr_t)imsic_file_index[vec->cpu] * imsic.stride;
+
+	msg->address_hi = upper_32_bits(pa);
+	msg->address_lo = lower_32_bits(pa);
+	msg->data = vec->id;
+}
+
+static int imsic_irq_set_affinity(struct irq_data *d,
+				  const struct cpumask *mask_val, bool force)
+{
+	struct imsic_vector *vec = irq_data_get_irq_chip_data(d);
+	unsigned int cpu;
+
+	if (force)
+		cpu = cpumask_first(mask_val);
+	else
+		cpu = cpumask_any_and(mask_val, cpu_online_mask);
+
+	if (cpu >= nr_cpu_ids || !imsic_ipi_target[cpu])
+		return -EINVAL;
+
+	if (cpu != vec->cpu) {
+		unsigned int old = vec->cpu;
+
+		vec->cpu = cpu;
+		/*
+		 * Enable on the new hart before disabling on the old one,
+		 * then have the old hart forward anything that already
+		 * landed in its file to the new one.  The MSI core
+		 * rewrites the message (the file address) right after
+		 * this returns; an MSI raised into the old file in that
+		 * last window is picked up by the forwarding check, which
+		 * runs on the old hart strictly afterwards.
+		 */
+		if (!irqd_irq_masked(d)) {
+			imsic_id_set_enable(cpu, vec->id, true);
+			imsic_id_set_enable(old, vec->id, false);
+		}
+		imsic_id_forward_pending(old, vec->id);
+	}
+
+	irq_data_update_effective_affinity(d, cpumask_of(cpu));
+	return IRQ_SET_MASK_OK;
+}
+
+static struct irq_chip imsic_irq_chip = {
+	.name			= "RISC-V IMSIC",
+	.irq_mask		= imsic_irq_mask,
+	.irq_unmask		= imsic_irq_unmask,
+	.irq_set_affinity	= imsic_irq_set_affinity,
+	.irq_compose_msi_msg	= imsic_irq_compose_msi_msg,
+};
+
+static int imsic_irq_domain_alloc(struct irq_domain *domain, unsigned int virq,
+				  unsigned int nr_irqs, void *arg)
+{
+	int i, id;
+
+	mutex_lock(&imsic.ids_lock);
+	id = bitmap_find_free_region(imsic.ids_bitmap, imsic.num_ids + 1,
+				     get_count_order(nr_irqs));
+	mutex_unlock(&imsic.ids_lock);
+	if (id < 0)
+		return id;
+
+	for (i = 0; i < nr_irqs; i++) {
+		struct imsic_vector *vec = &imsic.vectors[id + i];
+
+		vec->id = id + i;
+		vec->cpu = cpumask_first(cpu_online_mask);
+		irq_domain_set_info(domain, virq + i, vec->id, &imsic_irq_chip,
+				    vec, handle_simple_irq, NULL, NULL);
+	}
+
+	return 0;
+}
+
+static void imsic_irq_domain_free(struct irq_domain *domain, unsigned int virq,
+				  unsigned int nr_irqs)
+{
+	struct irq_data *d = irq_domain_get_irq_data(domain, virq);
+
+	mutex_lock(&imsic.ids_lock);
+	bitmap_release_region(imsic.ids_bitmap, d->hwirq,
+			      get_count_order(nr_irqs));
+	mutex_unlock(&imsic.ids_lock);
+}
+
+static const struct irq_domain_ops imsic_irq_domain_ops = {
+	.alloc	= imsic_irq_domain_alloc,
+	.free	= imsic_irq_domain_free,
+};
+
+#ifdef CONFIG_PCI_MSI
+static void imsic_pci_msi_mask_irq(struct irq_data *d)
+{
+	pci_msi_mask_irq(d);
+	irq_chip_mask_parent(d);
+}
+
+static void imsic_pci_msi_unmask_irq(struct irq_data *d)
+{
+	pci_msi_unmask_irq(d);
+	irq_chip_unmask_parent(d);
+}
+
+static struct irq_chip imsic_pci_msi_chip = {
+	.name		= "IMSIC-PCI-MSI",
+	.irq_mask	= imsic_pci_msi_mask_irq,
+	.irq_unmask	= imsic_pci_msi_unmask_irq,
+};
+
+static struct msi_domain_info imsic_pci_msi_domain_info = {
+	.flags	= (MSI_FLAG_USE_DEF_DOM_OPS | MSI_FLAG_USE_DEF_CHIP_OPS |
+		   MSI_FLAG_PCI_MSIX | MSI_FLAG_MULTI_PCI_MSI),
+	.chip	= &imsic_pci_msi_chip,
+};
+#endif
+
+static struct irq_chip imsic_plat_msi_chip = {
+	.name		= "IMSIC-PLAT-MSI",
+	.irq_mask	= irq_chip_mask_parent,
+	.irq_unmask	= irq_chip_unmask_parent,
+};
+
+static struct msi_domain_info imsic_plat_msi_domain_info = {
+	.flags	= (MSI_FLAG_USE_DEF_DOM_OPS | MSI_FLAG_USE_DEF_CHIP_OPS),
+	.chip	= &imsic_plat_msi_chip,
+};
+
+static void imsic_handle_irq(struct irq_desc *desc)
+{
+	struct irq_chip *chip = irq_desc_get_chip(desc);
+	unsigned long topei;
+
+	chained_irq_enter(chip, desc);
+
+	/* Reading stopei claims and clears the highest pending identity */
+	while ((topei = csr_swap(CSR_STOPEI, 0))) {
+		topei >>= TOPEI_ID_SHIFT;
+
+		if (likely(topei == IMSIC_IPI_ID)) {
+			handle_IPI(get_irq_regs());
+		} else {
+			int err = generic_handle_domain_irq(imsic.base_domain,
+							    topei);
+
+			if (unlikely(err))
+				pr_warn_ratelimited("unexpected interrupt id %ld\n",
+						    topei);
+		}
+	}
+
+	chained_irq_exit(chip, desc);
+}
+
+static int imsic_starting_cpu(unsigned int cpu)
+{
+	unsigned long flags;
+
+	/* Apply the enable bitmap, deliver all enabled identities */
+	raw_spin_lock_irqsave(&imsic.enable_lock, flags);
+	imsic_local_apply();
+	raw_spin_unlock_irqrestore(&imsic.enable_lock, flags);
+
+	csr_write(CSR_SISELECT, IMSIC_EITHRESHOLD);
+	csr_write(CSR_SIREG, 0);
+	csr_write(CSR_SISELECT, IMSIC_EIDELIVERY);
+	csr_write(CSR_SIREG, 1);
+
+	enable_percpu_irq(imsic_parent_irq,
+			  irq_get_trigger_type(imsic_parent_irq));
+	return 0;
+}
+
+static int imsic_dying_cpu(unsigned int cpu)
+{
+	disable_percpu_irq(imsic_parent_irq);
+
+	csr_write(CSR_SISELECT, IMSIC_EIDELIVERY);
+	csr_write(CSR_SIREG, 0);
+	return 0;
+}
+
+struct irq_domain *imsic_get_base_domain(void)
+{
+	return imsic.base_domain;
+}
+
+u32 imsic_pa_to_hartindex(phys_addr_t pa)
+{
+	return (pa - imsic.base_pa) / imsic.stride;
+}
+
+static int __init imsic_init(struct device_node *node,
+			     struct device_node *parent)
+{
+	void __iomem *base;
+	struct of_phandle_args intc;
+	struct irq_domain *plat_domain;
+	struct resource res;
+	unsigned long hartid;
+	u32 guest_bits = 0, num_ids;
+	int i, rc, cpu, nr_parent_irqs;
+
+	if (of_property_read_u32(node, "riscv,num-ids", &num_ids) ||
+	    num_ids <= IMSIC_IPI_ID) {
+		pr_err("%pOF: invalid riscv,num-ids\n", node);
+		return -EINVAL;
+	}
+
+	of_property_read_u32(node, "riscv,guest-index-bits", &guest_bits);
+
+	if (of_address_to_resource(node, 0, &res)) {
+		pr_err("%pOF: unable to find register resource\n", node);
+		return -ENXIO;
+	}
+
+	base = of_iomap(node, 0);
+	if (!base) {
+		pr_err("%pOF: unable to map interrupt files\n", node);
+		return -ENXIO;
+	}
+
+	imsic.base_pa = res.start;
+	imsic.stride = IMSIC_MMIO_PAGE_SZ << guest_bits;
+	imsic.num_ids = num_ids;
+	mutex_init(&imsic.ids_lock);
+	raw_spin_lock_init(&imsic.enable_lock);
+
+	imsic.vectors = kcalloc(num_ids + 1, sizeof(*imsic.vectors),
+				GFP_KERNEL);
+	imsic.ids_bitmap = bitmap_zalloc(num_ids + 1, GFP_KERNEL);
+	if (!imsic.vectors || !imsic.ids_bitmap)
+		goto out_free;
+
+	/* Identity 0 does not exist, identity 1 carries IPIs */
+	bitmap_set(imsic.ids_bitmap, 0, IMSIC_IPI_ID + 1);
+
+	nr_parent_irqs = of_irq_count(node);
+
+	/*
+	 * The i-th supervisor interrupt file belongs to the hart whose
+	 * intc is the i-th entry of interrupts-extended.
+	 */
+	for (i = 0; i < nr_parent_irqs; i++) {
+		if (of_irq_parse_one(node, i, &intc))
+			continue;
+		if (intc.args[0] != RV_IRQ_EXT)
+			continue;
+
+		rc = riscv_of_parent_hartid(intc.np, &hartid);
+		if (rc < 0) {
+			pr_warn("%pOF: hart id not found for parent %d\n",
+				node, i);
+			continue;
+		}
+
+		cpu = riscv_hartid_to_cpuid(hartid);
+		if (cpu < 0)
+			continue;
+
+		imsic_ipi_target[cpu] = base + i * imsic.stride +
+					IMSIC_MMIO_SETIPNUM_LE;
+		imsic_file_index[cpu] = i;
+
+		per_cpu(imsic_enable_bitmap, cpu) =
+			bitmap_zalloc(num_ids + 1, GFP_KERNEL);
+		if (!per_cpu(imsic_enable_bitmap, cpu))
+			goto out_free;
+		set_bit(IMSIC_IPI_ID, per_cpu(imsic_enable_bitmap, cpu));
+		init_irq_work(&per_cpu(imsic_sync_work, cpu),
+			      imsic_sync_work_func);
+
+		per_cpu(imsic_move_bitmap, cpu) =
+			bitmap_zalloc(num_ids + 1, GFP_KERNEL);
+		if (!per_cpu(imsic_move_bitmap, cpu))
+			goto out_free;
+		init_irq_work(&per_cpu(imsic_move_work, cpu),
+			      imsic_move_work_func);
+
+		if (!imsic_parent_irq)
+			imsic_parent_irq = irq_of_parse_and_map(node, i);
+	}
+
+	if (!imsic_parent_irq) {
+		pr_err("%pOF: unable to map parent irq\n", node);
+		goto out_free;
+	}
+
+	imsic.base_domain = irq_domain_create_linear(of_node_to_fwnode(node),
+						     num_ids + 1,
+						     &imsic_irq_domain_ops,
+						     NULL);
+	if (!imsic.base_domain) {
+		pr_err("%pOF: failed to create base domain\n", node);
+		goto out_free;
+	}
+	irq_domain_update_bus_token(imsic.base_domain, DOMAIN_BUS_NEXUS);
+
+#ifdef CONFIG_PCI_MSI
+	if (!pci_msi_create_irq_domain(of_node_to_fwnode(node),
+				       &imsic_pci_msi_domain_info,
+				       imsic.base_domain))
+		pr_warn("%pOF: failed to create PCI MSI domain\n", node);
+#endif
+	plat_domain = platform_msi_create_irq_domain(of_node_to_fwnode(node),
+						     &imsic_plat_msi_domain_info,
+						     imsic.base_domain);
+	if (!plat_domain)
+		pr_warn("%pOF: failed to create platform MSI domain\n", node);
+
+	irq_set_chained_handler(imsic_parent_irq, imsic_handle_irq);
+
+	cpuhp_setup_state(CPUHP_AP_IRQ_RISCV_IMSIC_STARTING,
+			  "irqchip/riscv/imsic:starting",
+			  imsic_starting_cpu, imsic_dying_cpu);
+
+	riscv_set_ipi_ops(&imsic_ipi_ops);
+
+	pr_info("%d interrupt identities, IPIs on identity %d\n",
+		num_ids, IMSIC_IPI_ID);
+
+	return 0;
+
+out_free:
+	for_each_possible_cpu(cpu) {
+		bitmap_free(per_cpu(imsic_enable_bitmap, cpu));
+		bitmap_free(per_cpu(imsic_move_bitmap, cpu));
+	}
+	bitmap_free(imsic.ids_bitmap);
+	kfree(imsic.vectors);
+	iounmap(base);
+	return -ENOMEM;
+}
+
+IRQCHIP_DECLARE(riscv_imsic, "riscv,imsics", imsic_init);
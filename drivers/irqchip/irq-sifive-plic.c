@@ -5,6 +5,7 @@
  */
 #define pr_fmt(fmt) "plic: " fmt
 #include <linux/cpu.h>
+#include <linux/debugfs.h>
 #include <linux/interrupt.h>
 #include <linux/io.h>
 #include <linux/irq.h>
@@ -16,7 +17,9 @@
 #include <linux/of_address.h>
 #include <linux/of_irq.h>
 #include <linux/platform_device.h>
+#include <linux/seq_file.h>
 #include <linux/spinlock.h>
+#include <linux/workqueue.h>
 #include <asm/smp.h>
 
 /*
@@ -60,6 +63,13 @@
 #define	PLIC_DISABLE_THRESHOLD		0x7
 #define	PLIC_ENABLE_THRESHOLD		0
 
+/*
+ * Maximum number of interrupts claimed in one trap. Past this the context
+ * is parked behind the threshold register and the remainder is drained
+ * from process context, so an interrupt flood cannot livelock the hart.
+ */
+#define PLIC_CLAIM_BUDGET		64
+
 #define PLIC_QUIRK_EDGE_INTERRUPT	0
 
 struct plic_priv {
@@ -79,12 +89,17 @@ struct plic_handler {
 	raw_spinlock_t		enable_lock;
 	void __iomem		*enable_base;
 	struct plic_priv	*priv;
+	struct work_struct	overflow_work;
+	/* statistics, written only by this hart */
+	unsigned long		claims;
+	unsigned long		overflows;
 };
 static int plic_parent_irq __ro_after_init;
 static bool plic_cpuhp_setup_done __ro_after_init;
 static DEFINE_PER_CPU(struct plic_handler, plic_handlers);
 
 static int plic_irq_set_type(struct irq_data *d, unsigned int type);
+static void plic_set_threshold(struct plic_handler *handler, u32 threshold);
 
 static void __plic_toggle(void __iomem *enable_base, int hwirq, int enable)
 {
@@ -285,6 +300,32 @@ static const struct irq_domain_ops plic_irqdomain_ops = {
 	.free		= irq_domain_free_irqs_top,
 };
 
+/*
+ * Drain interrupts left behind when a trap overran its claim budget. New
+ * external interrupts for this context are gated by the threshold register
+ * until the backlog is gone, so the hart stays available for softirqs and
+ * scheduling in between handlers.
+ */
+static void plic_overflow_work_func(struct work_struct *work)
+{
+	struct plic_handler *handler = container_of(work, struct plic_handler,
+						    overflow_work);
+	void __iomem *claim = handler->hart_base + CONTEXT_CLAIM;
+	irq_hw_number_t hwirq;
+
+	while ((hwirq = readl(claim))) {
+		int err = generic_handle_domain_irq_safe(handler->priv->irqdomain,
+							 hwirq);
+		if (unlikely(err))
+			pr_warn_ratelimited("can't find mapping for hwirq %lu\n",
+					hwirq);
+		handler->claims++;
+		cond_resched();
+	}
+
+	plic_set_threshold(handler, PLIC_ENABLE_THRESHOLD);
+}
+
 /*
  * Handling an interrupt is a two-step process: first you claim the interrupt
  * by reading the claim register, then you complete the interrupt by writing
@@ -296,6 +337,7 @@ static void plic_handle_irq(struct irq_desc *desc)
 	struct plic_handler *handler = this_cpu_ptr(&plic_handlers);
 	struct irq_chip *chip = irq_desc_get_chip(desc);
 	void __iomem *claim = handler->hart_base + CONTEXT_CLAIM;
+	int budget = PLIC_CLAIM_BUDGET;
 	irq_hw_number_t hwirq;
 
 	WARN_ON_ONCE(!handler->present);
@@ -308,6 +350,14 @@ static void plic_handle_irq(struct irq_desc *desc)
 		if (unlikely(err))
 			pr_warn_ratelimited("can't find mapping for hwirq %lu\n",
 					hwirq);
+		handler->claims++;
+		if (!--budget) {
+			handler->overflows++;
+			plic_set_threshold(handler, PLIC_DISABLE_THRESHOLD);
+			schedule_work_on(smp_processor_id(),
+					 &handler->overflow_work);
+			break;
+		}
 	}
 
 	chained_irq_exit(chip, desc);
@@ -441,6 +491,7 @@ static int __init __plic_init(struct device_node *node,
 		handler->present = true;
 		handler->hart_base = priv->regs + CONTEXT_BASE +
 			i * CONTEXT_SIZE;
+		INIT_WORK(&handler->overflow_work, plic_overflow_work_func);
 		raw_spin_lock_init(&handler->enable_lock);
 		handler->enable_base = priv->regs + CONTEXT_ENABLE_BASE +
 			i * CONTEXT_ENABLE_SIZE;
@@ -477,6 +528,38 @@ out_free_priv:
 	return error;
 }
 
+static int plic_stats_show(struct seq_file *m, void *v)
+{
+	int cpu;
+
+	seq_puts(m, "cpu        claims     overflows\n");
+	for_each_possible_cpu(cpu) {
+		struct plic_handler *handler = per_cpu_ptr(&plic_handlers, cpu);
+
+		if (!handler->present)
+			continue;
+		seq_printf(m, "%3d %13lu %13lu\n", cpu,
+			   handler->claims, handler->overflows);
+	}
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(plic_stats);
+
+static int __init plic_debugfs_init(void)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		if (per_cpu_ptr(&plic_handlers, cpu)->present) {
+			debugfs_create_file("plic_stats", 0444, NULL, NULL,
+					    &plic_stats_fops);
+			break;
+		}
+	}
+	return 0;
+}
+device_initcall(plic_debugfs_init);
+
 static int __init plic_init(struct device_node *node,
 			    struct device_node *parent)
 {
@@ -501,57 +501,68 @@ static void dw_mci_dmac_complete_dma(void *arg)
 
 static int dw_mci_idmac_init(struct dw_mci *host)
 {
-	int i;
+	int i, ring;
 
-	if (host->dma_64bit_address == 1) {
-		struct idmac_desc_64addr *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc_64addr);
-
-		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu; i < host->ring_size - 1;
-								i++, p++) {
-			p->des6 = (host->sg_dma +
+	/*
+	 * Two descriptor rings alternate between transfers so that the
+	 * descriptors for the next request can be built from pre_req()
+	 * while the IDMAC is still walking the other ring.  Each ring
+	 * wraps onto itself; DBADDR is repointed when a transfer starts.
+	 */
+	for (ring = 0; ring < 2; ring++) {
+		if (host->dma_64bit_address == 1) {
+			struct idmac_desc_64addr *p;
+			/* Number of descriptors in the ring buffer */
+			host->ring_size = DESC_RING_BUF_SZ /
+					sizeof(struct idmac_desc_64addr);
+
+			/* Forward link the descriptor list */
+			for (i = 0, p = host->sg_cpu[ring];
+			     i < host->ring_size - 1; i++, p++) {
+				p->des6 = (host->sg_dma[ring] +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) & 0xffffffff;
 
-			p->des7 = (u64)(host->sg_dma +
+				p->des7 = (u64)(host->sg_dma[ring] +
 					(sizeof(struct idmac_desc_64addr) *
 							(i + 1))) >> 32;
-			/* Initialize reserved and buffer size fields to "0" */
-			p->des0 = 0;
-			p->des1 = 0;
-			p->des2 = 0;
-			p->des3 = 0;
-		}
+				/* Initialize reserved and buffer size fields to "0" */
+				p->des0 = 0;
+				p->des1 = 0;
+				p->des2 = 0;
+				p->des3 = 0;
+			}
 
-		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des6 = host->sg_dma & 0xffffffff;
-		p->des7 = (u64)host->sg_dma >> 32;
-		p->des0 = IDMAC_DES0_ER;
+			/* Set the last descriptor as the end-of-ring descriptor */
+			p->des6 = host->sg_dma[ring] & 0xffffffff;
+			p->des7 = (u64)host->sg_dma[ring] >> 32;
+			p->des0 = IDMAC_DES0_ER;
 
-	} else {
-		struct idmac_desc *p;
-		/* Number of descriptors in the ring buffer */
-		host->ring_size =
-			DESC_RING_BUF_SZ / sizeof(struct idmac_desc);
-
-		/* Forward link the descriptor list */
-		for (i = 0, p = host->sg_cpu;
-		     i < host->ring_size - 1;
-		     i++, p++) {
-			p->des3 = cpu_to_le32(host->sg_dma +
+		} else {
+			struct idmac_desc *p;
+			/* Number of descriptors in the ring buffer */
+			host->ring_size = DESC_RING_BUF_SZ /
+					sizeof(struct idmac_desc);
+
+			/* Forward link the descriptor list */
+			for (i = 0, p = host->sg_cpu[ring];
+			     i < host->ring_size - 1;
+			     i++, p++) {
+				p->des3 = cpu_to_le32(host->sg_dma[ring] +
 					(sizeof(struct idmac_desc) * (i + 1)));
-			p->des0 = 0;
-			p->des1 = 0;
-		}
+				p->des0 = 0;
+				p->des1 = 0;
+			}
 
-		/* Set the last descriptor as the end-of-ring descriptor */
-		p->des3 = cpu_to_le32(host->sg_dma);
-		p->des0 = cpu_to_le32(IDMAC_DES0_ER);
+			/* Set the last descriptor as the end-of-ring descriptor */
+			p->des3 = cpu_to_le32(host->sg_dma[ring]);
+			p->des0 = cpu_to_le32(IDMAC_DES0_ER);
+		}
 	}
 
+	host->ring_next = 0;
+	host->prep_data = NULL;
+
 	dw_mci_idmac_reset(host);
 
 	if (host->dma_64bit_address == 1) {
@@ -561,8 +572,8 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
 
 		/* Set the descriptor base address */
-		mci_writel(host, DBADDRL, host->sg_dma & 0xffffffff);
-		mci_writel(host, DBADDRU, (u64)host->sg_dma >> 32);
+		mci_writel(host, DBADDRL, host->sg_dma[0] & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)host->sg_dma[0] >> 32);
 
 	} else {
 		/* Mask out interrupts - get Tx & Rx complete only */
@@ -571,22 +582,37 @@ static int dw_mci_idmac_init(struct dw_mci *host)
 				SDMMC_IDMAC_INT_RI | SDMMC_IDMAC_INT_TI);
 
 		/* Set the descriptor base address */
-		mci_writel(host, DBADDR, host->sg_dma);
+		mci_writel(host, DBADDR, host->sg_dma[0]);
 	}
 
 	return 0;
 }
 
+/*
+ * Claim the descriptor ring for the next transfer.  Called with
+ * host->lock held; claims alternate, so a ring prepared early from
+ * dw_mci_pre_req() can never collide with the ring the IDMAC is
+ * actively walking.
+ */
+static unsigned int dw_mci_idmac_claim_ring(struct dw_mci *host)
+{
+	unsigned int ring = host->ring_next;
+
+	host->ring_next = ring ^ 1;
+	return ring;
+}
+
 static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int ring)
 {
 	unsigned int desc_len;
 	struct idmac_desc_64addr *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = host->sg_cpu[ring];
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -641,24 +667,22 @@ static inline int dw_mci_prepare_desc64(struct dw_mci *host,
 
 	return 0;
 err_own_bit:
-	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
 	return -EINVAL;
 }
 
 
 static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 					 struct mmc_data *data,
-					 unsigned int sg_len)
+					 unsigned int sg_len,
+					 unsigned int ring)
 {
 	unsigned int desc_len;
 	struct idmac_desc *desc_first, *desc_last, *desc;
 	u32 val;
 	int i;
 
-	desc_first = desc_last = desc = host->sg_cpu;
+	desc_first = desc_last = desc = host->sg_cpu[ring];
 
 	for (i = 0; i < sg_len; i++) {
 		unsigned int length = sg_dma_len(&data->sg[i]);
@@ -715,25 +739,47 @@ static inline int dw_mci_prepare_desc32(struct dw_mci *host,
 
 	return 0;
 err_own_bit:
-	/* restore the descriptor chain as it's polluted */
 	dev_dbg(host->dev, "descriptor is still owned by IDMAC.\n");
-	memset(host->sg_cpu, 0, DESC_RING_BUF_SZ);
-	dw_mci_idmac_init(host);
 	return -EINVAL;
 }
 
 static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 {
+	unsigned int ring;
 	u32 temp;
-	int ret;
+	int ret = 0;
 
-	if (host->dma_64bit_address == 1)
-		ret = dw_mci_prepare_desc64(host, host->data, sg_len);
-	else
-		ret = dw_mci_prepare_desc32(host, host->data, sg_len);
+	/*
+	 * Use the descriptors prebuilt from dw_mci_pre_req() when they
+	 * were built for this very transfer, otherwise claim the next
+	 * ring and build them now.  COOKIE_PRE_MAPPED guarantees the
+	 * prebuild is fresh: pre_req() republishes or clears the
+	 * prepared slot every time it runs for a data transfer.
+	 */
+	if (host->prep_data == host->data &&
+	    host->data->host_cookie == COOKIE_PRE_MAPPED) {
+		ring = host->prep_ring;
+	} else {
+		ring = dw_mci_idmac_claim_ring(host);
+		if (host->dma_64bit_address == 1)
+			ret = dw_mci_prepare_desc64(host, host->data, sg_len,
+						    ring);
+		else
+			ret = dw_mci_prepare_desc32(host, host->data, sg_len,
+						    ring);
+	}
+	/*
+	 * Invalidate any unconsumed prebuild as well: a later claim
+	 * could rotate onto its ring and overwrite the descriptors.
+	 */
+	host->prep_data = NULL;
 
-	if (ret)
+	if (ret) {
+		/* restore the descriptor chain as it's polluted */
+		memset(host->sg_cpu[ring], 0, DESC_RING_BUF_SZ);
+		dw_mci_idmac_init(host);
 		goto out;
+	}
 
 	/* drain writebuffer */
 	wmb();
@@ -742,6 +788,14 @@ static int dw_mci_idmac_start_dma(struct dw_mci *host, unsigned int sg_len)
 	dw_mci_ctrl_reset(host, SDMMC_CTRL_DMA_RESET);
 	dw_mci_idmac_reset(host);
 
+	/* Point the IDMAC at the ring this transfer uses */
+	if (host->dma_64bit_address == 1) {
+		mci_writel(host, DBADDRL, host->sg_dma[ring] & 0xffffffff);
+		mci_writel(host, DBADDRU, (u64)host->sg_dma[ring] >> 32);
+	} else {
+		mci_writel(host, DBADDR, host->sg_dma[ring]);
+	}
+
 	/* Select IDMAC interface */
 	temp = mci_readl(host, CTRL);
 	temp |= SDMMC_CTRL_USE_IDMAC;
@@ -912,11 +966,53 @@ static int dw_mci_pre_dma_transfer(struct dw_mci *host,
 	return sg_len;
 }
 
+/*
+ * Build the IDMAC descriptors for @data ahead of time, while the
+ * previous transfer may still be running.  Descriptors land in a ring
+ * the IDMAC is guaranteed not to be walking (claims alternate), and
+ * the prepared slot is published under host->lock so that
+ * dw_mci_idmac_start_dma() can pick it up or ignore it atomically.
+ * Failure here is harmless - the start path simply builds the
+ * descriptors synchronously as before.
+ */
+static void dw_mci_prep_desc(struct dw_mci *host, struct mmc_data *data,
+			     unsigned int sg_len)
+{
+	unsigned int ring;
+	int ret;
+
+	if (host->use_dma != TRANS_MODE_IDMAC)
+		return;
+
+	spin_lock_bh(&host->lock);
+	/* Drop a stale prebuild for a previous use of this data */
+	if (host->prep_data == data)
+		host->prep_data = NULL;
+	ring = dw_mci_idmac_claim_ring(host);
+	spin_unlock_bh(&host->lock);
+
+	if (host->dma_64bit_address == 1)
+		ret = dw_mci_prepare_desc64(host, data, sg_len, ring);
+	else
+		ret = dw_mci_prepare_desc32(host, data, sg_len, ring);
+	if (ret)
+		return;
+
+	/* drain writebuffer before the descriptors are published */
+	wmb();
+
+	spin_lock_bh(&host->lock);
+	host->prep_data = data;
+	host->prep_ring = ring;
+	spin_unlock_bh(&host->lock);
+}
+
 static void dw_mci_pre_req(struct mmc_host *mmc,
 			   struct mmc_request *mrq)
 {
 	struct dw_mci_slot *slot = mmc_priv(mmc);
 	struct mmc_data *data = mrq->data;
+	int sg_len;
 
 	if (!slot->host->use_dma || !data)
 		return;
@@ -924,9 +1020,14 @@ static void dw_mci_pre_req(struct mmc_host *mmc,
 	/* This data might be unmapped at this time */
 	data->host_cookie = COOKIE_UNMAPPED;
 
-	if (dw_mci_pre_dma_transfer(slot->host, mrq->data,
-				COOKIE_PRE_MAPPED) < 0)
+	sg_len = dw_mci_pre_dma_transfer(slot->host, mrq->data,
+					 COOKIE_PRE_MAPPED);
+	if (sg_len < 0) {
 		data->host_cookie = COOKIE_UNMAPPED;
+		return;
+	}
+
+	dw_mci_prep_desc(slot->host, data, sg_len);
 }
 
 static void dw_mci_post_req(struct mmc_host *mmc,
@@ -1103,8 +1204,8 @@ static int dw_mci_submit_data_dma(struct dw_mci *host, struct mmc_data *data)
 	if (host->use_dma == TRANS_MODE_IDMAC)
 		dev_vdbg(host->dev,
 			 "sd sg_cpu: %#lx sg_dma: %#lx sg_len: %d\n",
-			 (unsigned long)host->sg_cpu,
-			 (unsigned long)host->sg_dma,
+			 (unsigned long)host->sg_cpu[0],
+			 (unsigned long)host->sg_dma[0],
 			 sg_len);
 
 	/*
@@ -3047,16 +3148,19 @@ static void dw_mci_init_dma(struct dw_mci *host)
 				 "IDMAC supports 32-bit address mode.\n");
 		}
 
-		/* Alloc memory for sg translation */
-		host->sg_cpu = dmam_alloc_coherent(host->dev,
-						   DESC_RING_BUF_SZ,
-						   &host->sg_dma, GFP_KERNEL);
-		if (!host->sg_cpu) {
+		/* Alloc memory for sg translation; two rings, see
+		 * dw_mci_idmac_init() */
+		host->sg_cpu[0] = dmam_alloc_coherent(host->dev,
+						   2 * DESC_RING_BUF_SZ,
+						   &host->sg_dma[0], GFP_KERNEL);
+		if (!host->sg_cpu[0]) {
 			dev_err(host->dev,
 				"%s: could not alloc DMA memory\n",
 				__func__);
 			goto no_dma;
 		}
+		host->sg_cpu[1] = host->sg_cpu[0] + DESC_RING_BUF_SZ;
+		host->sg_dma[1] = host->sg_dma[0] + DESC_RING_BUF_SZ;
 
 		host->dma_ops = &dw_mci_idmac_ops;
 		dev_info(host->dev, "Using internal DMA controller.\n");
@@ -75,11 +75,15 @@ struct dw_mci_dma_slave {
  *	denotes PIO mode.
  * @using_dma: Whether DMA is in use for the current transfer.
  * @dma_64bit_address: Whether DMA supports 64-bit address mode or not.
- * @sg_dma: Bus address of DMA buffer.
- * @sg_cpu: Virtual address of DMA buffer.
+ * @sg_dma: Bus addresses of the two IDMAC descriptor rings.
+ * @sg_cpu: Virtual addresses of the two IDMAC descriptor rings.
  * @dma_ops: Pointer to platform-specific DMA callbacks.
  * @cmd_status: Snapshot of SR taken upon completion of the current
  * @ring_size: Buffer size for idma descriptors.
+ * @ring_next: Descriptor ring to claim for the next transfer.
+ * @prep_data: Data whose idma descriptors were prebuilt from pre_req(),
+ *	or NULL. Protected by @lock, as are @ring_next and @prep_ring.
+ * @prep_ring: Descriptor ring holding the prebuilt descriptors.
  *	command. Only valid when EVENT_CMD_COMPLETE is pending.
  * @dms: structure of slave-dma private data.
  * @phy_regs: physical address of controller's register map
@@ -179,11 +183,14 @@ struct dw_mci {
 	int			using_dma;
 	int			dma_64bit_address;
 
-	dma_addr_t		sg_dma;
-	void			*sg_cpu;
+	dma_addr_t		sg_dma[2];
+	void			*sg_cpu[2];
 	const struct dw_mci_dma_ops	*dma_ops;
 	/* For idmac */
 	unsigned int		ring_size;
+	unsigned int		ring_next;
+	struct mmc_data		*prep_data;
+	unsigned int		prep_ring;
 
 	/* For edmac */
 	struct dw_mci_dma_slave *dms;
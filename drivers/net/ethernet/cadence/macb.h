@@ -1224,7 +1224,8 @@ struct macb_queue {
 	unsigned int		rx_tail;
 	unsigned int		rx_prepared_head;
 	struct macb_dma_desc	*rx_ring;
-	struct sk_buff		**rx_skbuff;
+	struct page_pool	*rx_page_pool;
+	struct page		**rx_page;
 	void			*rx_buffers;
 	struct napi_struct	napi_rx;
 	struct queue_stats stats;
@@ -1255,6 +1256,7 @@ struct macb {
 	void	(*macb_reg_writel)(struct macb *bp, int offset, u32 value);
 
 	size_t			rx_buffer_size;
+	unsigned int		rx_frag_size;
 
 	unsigned int		rx_ring_size;
 	unsigned int		tx_ring_size;
@@ -39,6 +39,7 @@
 #include <linux/ptp_classify.h>
 #include <linux/reset.h>
 #include <linux/firmware/xlnx-zynqmp.h>
+#include <net/page_pool.h>
 #include "macb.h"
 
 /* This structure is only used for MACB on SiFive FU540 devices */
@@ -1126,6 +1127,8 @@ static void macb_tx_error_task(struct work_struct *work)
 	/* Make TX ring reflect state of hardware */
 	queue->tx_head = 0;
 	queue->tx_tail = 0;
+	netdev_tx_reset_queue(netdev_get_tx_queue(bp->dev,
+						  queue - bp->queues));
 
 	/* Housework before enabling TX IRQ */
 	macb_writel(bp, TSR, macb_readl(bp, TSR));
@@ -1175,6 +1178,7 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 	u16 queue_index = queue - bp->queues;
 	unsigned int tail;
 	unsigned int head;
+	unsigned int bytes = 0;
 	int packets = 0;
 
 	spin_lock(&queue->tx_ptr_lock);
@@ -1220,6 +1224,7 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 				queue->stats.tx_packets++;
 				bp->dev->stats.tx_bytes += skb->len;
 				queue->stats.tx_bytes += skb->len;
+				bytes += skb->len;
 				packets++;
 			}
 
@@ -1236,6 +1241,8 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 	}
 
 	queue->tx_tail = tail;
+	netdev_tx_completed_queue(netdev_get_tx_queue(bp->dev, queue_index),
+				  packets, bytes);
 	if (__netif_subqueue_stopped(bp->dev, queue_index) &&
 	    CIRC_CNT(queue->tx_head, queue->tx_tail,
 		     bp->tx_ring_size) <= MACB_TX_WAKEUP_THRESH(bp))
@@ -1248,7 +1255,7 @@ static int macb_tx_complete(struct macb_queue *queue, int budget)
 static void gem_rx_refill(struct macb_queue *queue)
 {
 	unsigned int		entry;
-	struct sk_buff		*skb;
+	struct page		*page;
 	dma_addr_t		paddr;
 	struct macb *bp = queue->bp;
 	struct macb_dma_desc *desc;
@@ -1262,25 +1269,21 @@ static void gem_rx_refill(struct macb_queue *queue)
 
 		desc = macb_rx_desc(queue, entry);
 
-		if (!queue->rx_skbuff[entry]) {
-			/* allocate sk_buff for this free entry in ring */
-			skb = netdev_alloc_skb(bp->dev, bp->rx_buffer_size);
-			if (unlikely(!skb)) {
+		if (!queue->rx_page[entry]) {
+			/* take a page for this free entry in ring, mapped
+			 * and synced for the device by the pool
+			 */
+			page = page_pool_dev_alloc_pages(queue->rx_page_pool);
+			if (unlikely(!page)) {
 				netdev_err(bp->dev,
-					   "Unable to allocate sk_buff\n");
+					   "Unable to allocate RX page\n");
 				break;
 			}
 
 			/* now fill corresponding descriptor entry */
-			paddr = dma_map_single(&bp->pdev->dev, skb->data,
-					       bp->rx_buffer_size,
-					       DMA_FROM_DEVICE);
-			if (dma_mapping_error(&bp->pdev->dev, paddr)) {
-				dev_kfree_skb(skb);
-				break;
-			}
+			paddr = page_pool_get_dma_addr(page) + NET_SKB_PAD;
 
-			queue->rx_skbuff[entry] = skb;
+			queue->rx_page[entry] = page;
 
 			if (entry == bp->rx_ring_size - 1)
 				paddr |= MACB_BIT(RX_WRAP);
@@ -1290,9 +1293,6 @@ static void gem_rx_refill(struct macb_queue *queue)
 			 */
 			dma_wmb();
 			macb_set_addr(bp, desc, paddr);
-
-			/* properly align Ethernet header */
-			skb_reserve(skb, NET_IP_ALIGN);
 		} else {
 			desc->ctrl = 0;
 			dma_wmb();
@@ -1336,6 +1336,7 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 	unsigned int		len;
 	unsigned int		entry;
 	struct sk_buff		*skb;
+	struct page		*page;
 	struct macb_dma_desc	*desc;
 	int			count = 0;
 
@@ -1371,8 +1372,8 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			queue->stats.rx_dropped++;
 			break;
 		}
-		skb = queue->rx_skbuff[entry];
-		if (unlikely(!skb)) {
+		page = queue->rx_page[entry];
+		if (unlikely(!page)) {
 			netdev_err(bp->dev,
 				   "inconsistent Rx descriptor chain\n");
 			bp->dev->stats.rx_dropped++;
@@ -1380,14 +1381,27 @@ static int gem_rx(struct macb_queue *queue, struct napi_struct *napi,
 			break;
 		}
 		/* now everything is ready for receiving packet */
-		queue->rx_skbuff[entry] = NULL;
+		queue->rx_page[entry] = NULL;
 		len = ctrl & bp->rx_frm_len_mask;
 
 		netdev_vdbg(bp->dev, "gem_rx %u (len %u)\n", entry, len);
 
+		dma_sync_single_for_cpu(&bp->pdev->dev, addr,
+					len + NET_IP_ALIGN, DMA_FROM_DEVICE);
+
+		/* build the skb around the page buffer; the frame starts
+		 * NET_IP_ALIGN bytes into it (NCFGR.RBOF)
+		 */
+		skb = build_skb(page_address(page), bp->rx_frag_size);
+		if (unlikely(!skb)) {
+			page_pool_recycle_direct(queue->rx_page_pool, page);
+			bp->dev->stats.rx_dropped++;
+			queue->stats.rx_dropped++;
+			continue;
+		}
+		skb_mark_for_recycle(skb);
+		skb_reserve(skb, NET_SKB_PAD + NET_IP_ALIGN);
 		skb_put(skb, len);
-		dma_unmap_single(&bp->pdev->dev, addr,
-				 bp->rx_buffer_size, DMA_FROM_DEVICE);
 
 		skb->protocol = eth_type_trans(skb, bp->dev);
 		skb_checksum_none_assert(skb);
@@ -2248,6 +2262,14 @@ add_fcs:
 	return 0;
 }
 
+/* Ring the TX doorbell; harmless if the transmitter is already running */
+static void macb_tx_kick(struct macb *bp)
+{
+	spin_lock_irq(&bp->lock);
+	macb_writel(bp, NCR, macb_readl(bp, NCR) | MACB_BIT(TSTART));
+	spin_unlock_irq(&bp->lock);
+}
+
 static netdev_tx_t macb_start_xmit(struct sk_buff *skb, struct net_device *dev)
 {
 	u16 queue_index = skb_get_queue_mapping(skb);
@@ -2318,26 +2340,40 @@ static netdev_tx_t macb_start_xmit(struct sk_buff *skb, struct net_device *dev)
 		netdev_dbg(bp->dev, "tx_head = %u, tx_tail = %u\n",
 			   queue->tx_head, queue->tx_tail);
 		ret = NETDEV_TX_BUSY;
+		/* Kick the hardware in case descriptors queued by a
+		 * previous xmit_more round are still waiting for their
+		 * doorbell; the ring cannot drain otherwise.
+		 */
+		macb_tx_kick(bp);
 		goto unlock;
 	}
 
 	/* Map socket buffer for DMA transfer */
 	if (!macb_tx_map(bp, queue, skb, hdrlen)) {
 		dev_kfree_skb_any(skb);
+		if (queue->tx_head != queue->tx_tail)
+			macb_tx_kick(bp);
 		goto unlock;
 	}
 
+	netdev_tx_sent_queue(netdev_get_tx_queue(dev, queue_index), skb->len);
+
 	/* Make newly initialized descriptor visible to hardware */
 	wmb();
 	skb_tx_timestamp(skb);
 
-	spin_lock_irq(&bp->lock);
-	macb_writel(bp, NCR, macb_readl(bp, NCR) | MACB_BIT(TSTART));
-	spin_unlock_irq(&bp->lock);
-
 	if (CIRC_SPACE(queue->tx_head, queue->tx_tail, bp->tx_ring_size) < 1)
 		netif_stop_subqueue(dev, queue_index);
 
+	/* Defer the doorbell when the stack has more frames for us: one
+	 * TSTART write then starts the whole batch. The queue having been
+	 * stopped (by us above or by BQL) breaks that promise, so flush
+	 * unconditionally in that case.
+	 */
+	if (!netdev_xmit_more() ||
+	    netif_xmit_stopped(netdev_get_tx_queue(dev, queue_index)))
+		macb_tx_kick(bp);
+
 unlock:
 	spin_unlock_bh(&queue->tx_ptr_lock);
 
@@ -2366,34 +2402,32 @@ static void macb_init_rx_buffer_size(struct macb *bp, size_t size)
 
 static void gem_free_rx_buffers(struct macb *bp)
 {
-	struct sk_buff		*skb;
-	struct macb_dma_desc	*desc;
 	struct macb_queue *queue;
-	dma_addr_t		addr;
+	struct page		*page;
 	unsigned int q;
 	int i;
 
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		if (!queue->rx_skbuff)
-			continue;
-
-		for (i = 0; i < bp->rx_ring_size; i++) {
-			skb = queue->rx_skbuff[i];
+		if (queue->rx_page) {
+			for (i = 0; i < bp->rx_ring_size; i++) {
+				page = queue->rx_page[i];
 
-			if (!skb)
-				continue;
+				if (!page)
+					continue;
 
-			desc = macb_rx_desc(queue, i);
-			addr = macb_get_addr(bp, desc);
+				page_pool_put_full_page(queue->rx_page_pool,
+							page, false);
+				queue->rx_page[i] = NULL;
+			}
 
-			dma_unmap_single(&bp->pdev->dev, addr, bp->rx_buffer_size,
-					DMA_FROM_DEVICE);
-			dev_kfree_skb_any(skb);
-			skb = NULL;
+			kfree(queue->rx_page);
+			queue->rx_page = NULL;
 		}
 
-		kfree(queue->rx_skbuff);
-		queue->rx_skbuff = NULL;
+		if (queue->rx_page_pool) {
+			page_pool_destroy(queue->rx_page_pool);
+			queue->rx_page_pool = NULL;
+		}
 	}
 }
 
@@ -2437,19 +2471,44 @@ static void macb_free_consistent(struct macb *bp)
 
 static int gem_alloc_rx_buffers(struct macb *bp)
 {
+	struct page_pool_params pp_params = { 0 };
 	struct macb_queue *queue;
+	unsigned int len;
 	unsigned int q;
 	int size;
 
+	/* One RX buffer per (possibly compound) page: headroom for the
+	 * stack, the buffer itself and room for the shared info needed
+	 * to build an skb around it without copying.
+	 */
+	len = NET_SKB_PAD + bp->rx_buffer_size +
+	      SKB_DATA_ALIGN(sizeof(struct skb_shared_info));
+	pp_params.order = get_order(len);
+	bp->rx_frag_size = PAGE_SIZE << pp_params.order;
+
+	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
+	pp_params.pool_size = bp->rx_ring_size;
+	pp_params.nid = dev_to_node(&bp->pdev->dev);
+	pp_params.dev = &bp->pdev->dev;
+	pp_params.dma_dir = DMA_FROM_DEVICE;
+	pp_params.offset = NET_SKB_PAD;
+	pp_params.max_len = bp->rx_buffer_size + NET_IP_ALIGN;
+
 	for (q = 0, queue = bp->queues; q < bp->num_queues; ++q, ++queue) {
-		size = bp->rx_ring_size * sizeof(struct sk_buff *);
-		queue->rx_skbuff = kzalloc(size, GFP_KERNEL);
-		if (!queue->rx_skbuff)
+		queue->rx_page_pool = page_pool_create(&pp_params);
+		if (IS_ERR(queue->rx_page_pool)) {
+			queue->rx_page_pool = NULL;
+			return -ENOMEM;
+		}
+
+		size = bp->rx_ring_size * sizeof(struct page *);
+		queue->rx_page = kzalloc(size, GFP_KERNEL);
+		if (!queue->rx_page)
 			return -ENOMEM;
 		else
 			netdev_dbg(bp->dev,
-				   "Allocated %d RX struct sk_buff entries at %p\n",
-				   bp->rx_ring_size, queue->rx_skbuff);
+				   "Allocated %d RX page entries at %p\n",
+				   bp->rx_ring_size, queue->rx_page);
 	}
 	return 0;
 }
@@ -2529,6 +2588,7 @@ static void gem_init_rings(struct macb *bp)
 		desc->ctrl |= MACB_BIT(TX_WRAP);
 		queue->tx_head = 0;
 		queue->tx_tail = 0;
+		netdev_tx_reset_queue(netdev_get_tx_queue(bp->dev, q));
 
 		queue->rx_tail = 0;
 		queue->rx_prepared_head = 0;
@@ -2552,6 +2612,7 @@ static void macb_init_rings(struct macb *bp)
 	}
 	bp->queues[0].tx_head = 0;
 	bp->queues[0].tx_tail = 0;
+	netdev_tx_reset_queue(netdev_get_tx_queue(bp->dev, 0));
 	desc->ctrl |= MACB_BIT(TX_WRAP);
 }
 
@@ -134,6 +134,7 @@ static void stmmac_reset_rx_queue(struct stmmac_priv *priv, u32 queue);
 static void stmmac_reset_tx_queue(struct stmmac_priv *priv, u32 queue);
 static void stmmac_reset_queues_param(struct stmmac_priv *priv);
 static void stmmac_tx_timer_arm(struct stmmac_priv *priv, u32 queue);
+static void stmmac_rx_dim_work(struct work_struct *work);
 static void stmmac_flush_tx_descriptors(struct stmmac_priv *priv, int queue);
 static void stmmac_set_dma_operation_mode(struct stmmac_priv *priv, u32 txmode,
 					  u32 rxmode, u32 chan);
@@ -1905,6 +1906,8 @@ static void __free_dma_rx_desc_resources(struct stmmac_priv *priv,
 {
 	struct stmmac_rx_queue *rx_q = &dma_conf->rx_queue[queue];
 
+	cancel_work_sync(&rx_q->dim.work);
+
 	/* Release the DMA RX socket buffers */
 	if (rx_q->xsk_pool)
 		dma_free_rx_xskbufs(priv, dma_conf, queue);
@@ -2015,6 +2018,9 @@ static int __alloc_dma_rx_desc_resources(struct stmmac_priv *priv,
 	rx_q->queue_index = queue;
 	rx_q->priv_data = priv;
 
+	INIT_WORK(&rx_q->dim.work, stmmac_rx_dim_work);
+	rx_q->dim.mode = DIM_CQ_PERIOD_MODE_START_FROM_EQE;
+
 	pp_params.flags = PP_FLAG_DMA_MAP | PP_FLAG_DMA_SYNC_DEV;
 	pp_params.pool_size = dma_conf->dma_rx_size;
 	num_pages = DIV_ROUND_UP(dma_conf->dma_buf_sz, PAGE_SIZE);
@@ -3493,6 +3499,16 @@ static void stmmac_free_irq(struct net_device *dev,
 	}
 }
 
+/* Pick the CPU serving a given MSI vector. Prefer CPUs close to the
+ * device (same NUMA node / cluster) before wrapping to remote ones, so
+ * that per-queue interrupt handlers and NAPI keep their working set in
+ * a local cache hierarchy instead of striping over all online CPUs.
+ */
+static unsigned int stmmac_msi_vec_cpu(struct stmmac_priv *priv, int vec)
+{
+	return cpumask_local_spread(vec, dev_to_node(priv->device));
+}
+
 static int stmmac_request_irq_multi_msi(struct net_device *dev)
 {
 	struct stmmac_priv *priv = netdev_priv(dev);
@@ -3610,7 +3626,7 @@ static int stmmac_request_irq_multi_msi(struct net_device *dev)
 			goto irq_error;
 		}
 		cpumask_clear(&cpu_mask);
-		cpumask_set_cpu(i % num_online_cpus(), &cpu_mask);
+		cpumask_set_cpu(stmmac_msi_vec_cpu(priv, i), &cpu_mask);
 		irq_set_affinity_hint(priv->rx_irq[i], &cpu_mask);
 	}
 
@@ -3635,7 +3651,7 @@ static int stmmac_request_irq_multi_msi(struct net_device *dev)
 			goto irq_error;
 		}
 		cpumask_clear(&cpu_mask);
-		cpumask_set_cpu(i % num_online_cpus(), &cpu_mask);
+		cpumask_set_cpu(stmmac_msi_vec_cpu(priv, i), &cpu_mask);
 		irq_set_affinity_hint(priv->tx_irq[i], &cpu_mask);
 	}
 
@@ -4942,6 +4958,8 @@ static void stmmac_dispatch_skb_zc(struct stmmac_priv *priv, u32 queue,
 
 	priv->dev->stats.rx_packets++;
 	priv->dev->stats.rx_bytes += len;
+	priv->dma_conf.rx_queue[queue].dim_packets++;
+	priv->dma_conf.rx_queue[queue].dim_bytes += len;
 }
 
 static bool stmmac_rx_refill_zc(struct stmmac_priv *priv, u32 queue, u32 budget)
@@ -5430,6 +5448,8 @@ drain_data:
 
 		priv->dev->stats.rx_packets++;
 		priv->dev->stats.rx_bytes += len;
+		rx_q->dim_packets++;
+		rx_q->dim_bytes += len;
 		count++;
 	}
 
@@ -5450,6 +5470,43 @@ drain_data:
 	return count;
 }
 
+/* Reprogram the RX watchdog timer of a queue with the moderation value
+ * picked by the DIM algorithm. Runs from the per-queue dim work.
+ */
+static void stmmac_rx_dim_work(struct work_struct *work)
+{
+	struct dim *dim = container_of(work, struct dim, work);
+	struct stmmac_rx_queue *rx_q =
+		container_of(dim, struct stmmac_rx_queue, dim);
+	struct stmmac_priv *priv = rx_q->priv_data;
+	struct dim_cq_moder moder;
+	u32 riwt;
+
+	moder = net_dim_get_rx_moderation(dim->mode, dim->profile_ix);
+
+	riwt = stmmac_usec2riwt(moder.usec, priv);
+	riwt = clamp_t(u32, riwt, MIN_DMA_RIWT, MAX_DMA_RIWT);
+
+	priv->rx_riwt[rx_q->queue_index] = riwt;
+	stmmac_rx_watchdog(priv, priv->ioaddr, riwt, rx_q->queue_index);
+
+	dim->state = DIM_START_MEASURE;
+}
+
+/* Feed the per-queue traffic counters to DIM at the end of a NAPI poll */
+static void stmmac_rx_dim_sample(struct stmmac_priv *priv,
+				 struct stmmac_rx_queue *rx_q)
+{
+	struct dim_sample sample;
+
+	if (!priv->rx_dim_enabled)
+		return;
+
+	dim_update_sample(rx_q->dim_events++, rx_q->dim_packets,
+			  rx_q->dim_bytes, &sample);
+	net_dim(&rx_q->dim, sample);
+}
+
 static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 {
 	struct stmmac_channel *ch =
@@ -5464,6 +5521,8 @@ static int stmmac_napi_poll_rx(struct napi_struct *napi, int budget)
 	if (work_done < budget && napi_complete_done(napi, work_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_sample(priv, &priv->dma_conf.rx_queue[chan]);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		stmmac_enable_dma_irq(priv, priv->ioaddr, chan, 1, 0);
 		spin_unlock_irqrestore(&ch->lock, flags);
@@ -5523,6 +5582,8 @@ static int stmmac_napi_poll_rxtx(struct napi_struct *napi, int budget)
 	if (napi_complete_done(napi, rxtx_done)) {
 		unsigned long flags;
 
+		stmmac_rx_dim_sample(priv, &priv->dma_conf.rx_queue[chan]);
+
 		spin_lock_irqsave(&ch->lock, flags);
 		/* Both RX and TX work done are compelte,
 		 * so enable both RX & TX IRQs.
@@ -6892,6 +6953,7 @@ static int stmmac_hw_init(struct stmmac_priv *priv)
 	if (((priv->synopsys_id >= DWMAC_CORE_3_50) ||
 	    (priv->plat->has_xgmac)) && (!priv->plat->riwt_off)) {
 		priv->use_riwt = 1;
+		priv->rx_dim_enabled = true;
 		dev_info(priv->device,
 			 "Enable RX Mitigation via HW Watchdog Timer\n");
 	}
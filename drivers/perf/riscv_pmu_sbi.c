@@ -18,7 +18,9 @@
 #include <linux/of_irq.h>
 #include <linux/of.h>
 #include <linux/cpu_pm.h>
+#include <linux/gfp.h>
 #include <linux/sched/clock.h>
+#include <linux/sysctl.h>
 
 #include <asm/errata_list.h>
 #include <asm/sbi.h>
@@ -48,7 +50,16 @@ static const struct attribute_group *riscv_pmu_attr_groups[] = {
  * per_cpu in case of harts with different pmu counters
  */
 static union sbi_pmu_ctr_info *pmu_ctr_list;
+static bool sbi_pmu_snapshot_available;
 static bool riscv_pmu_use_irq;
+
+/*
+ * This tree has always delegated the cycle/time/instret CSRs to U-mode,
+ * so SYSCTL_LEGACY is the default to keep existing rdcycle users alive.
+ * SYSCTL_USER_ACCESS restricts delegation to counters backing an mmap'd
+ * perf event of the current task, SYSCTL_NO_USER_ACCESS to TIME only.
+ */
+static int sysctl_perf_user_access __read_mostly = SYSCTL_LEGACY;
 static unsigned int riscv_pmu_irq_num;
 static unsigned int riscv_pmu_irq;
 
@@ -256,6 +267,43 @@ static int pmu_sbi_ctr_get_width(int idx)
 	return pmu_ctr_list[idx].width;
 }
 
+/* Hardware counter index of the event, i.e. its CSR offset from CSR_CYCLE. */
+static uint8_t pmu_sbi_csr_index(struct perf_event *event)
+{
+	return pmu_ctr_list[event->hw.idx].csr - CSR_CYCLE;
+}
+
+static void pmu_sbi_set_scounteren(void *arg)
+{
+	struct perf_event *event = (struct perf_event *)arg;
+
+	if (event->hw.idx != -1)
+		csr_write(CSR_SCOUNTEREN,
+			  csr_read(CSR_SCOUNTEREN) | BIT(pmu_sbi_csr_index(event)));
+}
+
+static void pmu_sbi_reset_scounteren(void *arg)
+{
+	struct perf_event *event = (struct perf_event *)arg;
+
+	if (event->hw.idx != -1)
+		csr_write(CSR_SCOUNTEREN,
+			  csr_read(CSR_SCOUNTEREN) & ~BIT(pmu_sbi_csr_index(event)));
+}
+
+/* Apply the always-delegated base set after a perf_user_access change. */
+static void pmu_sbi_sysctl_scounteren(void *arg)
+{
+	unsigned long en = csr_read(CSR_SCOUNTEREN);
+
+	if (sysctl_perf_user_access == SYSCTL_LEGACY)
+		en |= 0x5;
+	else
+		en &= ~0x5UL;
+
+	csr_write(CSR_SCOUNTEREN, en);
+}
+
 static bool pmu_sbi_ctr_is_fw(int cidx)
 {
 	union sbi_pmu_ctr_info *info;
@@ -275,6 +323,7 @@ static int pmu_sbi_ctr_get_idx(struct perf_event *event)
 	struct sbiret ret;
 	int idx;
 	uint64_t cbase = 0;
+	unsigned long ctr_mask = rvpmu->cmask;
 	unsigned long cflags = 0;
 
 	if (event->attr.exclude_kernel)
@@ -282,14 +331,30 @@ static int pmu_sbi_ctr_get_idx(struct perf_event *event)
 	if (event->attr.exclude_user)
 		cflags |= SBI_PMU_CFG_FLAG_SET_UINH;
 
+	/*
+	 * In legacy mode, a user-read event must land on the fixed
+	 * counter its rdcycle/rdinstret protocol expects; in user access
+	 * mode any counter can be delegated, so keep the normal matching
+	 * to retain sampling/filtering support.
+	 */
+	if (hwc->flags & PERF_EVENT_FLAG_LEGACY) {
+		if (event->attr.config == PERF_COUNT_HW_CPU_CYCLES) {
+			cflags |= SBI_PMU_CFG_FLAG_SKIP_MATCH;
+			ctr_mask = 1;
+		} else if (event->attr.config == PERF_COUNT_HW_INSTRUCTIONS) {
+			cflags |= SBI_PMU_CFG_FLAG_SKIP_MATCH;
+			ctr_mask = BIT(CSR_INSTRET - CSR_CYCLE);
+		}
+	}
+
 	/* retrieve the available counter index */
 #if defined(CONFIG_32BIT)
 	ret = sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_CFG_MATCH, cbase,
-			rvpmu->cmask, cflags, hwc->event_base, hwc->config,
+			ctr_mask, cflags, hwc->event_base, hwc->config,
 			hwc->config >> 32);
 #else
 	ret = sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_CFG_MATCH, cbase,
-			rvpmu->cmask, cflags, hwc->event_base, hwc->config, 0);
+			ctr_mask, cflags, hwc->event_base, hwc->config, 0);
 #endif
 	if (ret.error) {
 		pr_debug("Not able to find a counter for event %lx config %llx\n",
@@ -442,6 +507,10 @@ static void pmu_sbi_ctr_start(struct perf_event *event, u64 ival)
 	if (ret.error && (ret.error != SBI_ERR_ALREADY_STARTED))
 		pr_err("Starting counter idx %d failed with error %d\n",
 			hwc->idx, sbi_err_map_linux_errno(ret.error));
+
+	if ((hwc->flags & PERF_EVENT_FLAG_USER_ACCESS) &&
+	    (hwc->flags & PERF_EVENT_FLAG_USER_READ_CNT))
+		pmu_sbi_set_scounteren((void *)event);
 }
 
 static void pmu_sbi_ctr_stop(struct perf_event *event, unsigned long flag)
@@ -449,6 +518,10 @@ static void pmu_sbi_ctr_stop(struct perf_event *event, unsigned long flag)
 	struct sbiret ret;
 	struct hw_perf_event *hwc = &event->hw;
 
+	if ((hwc->flags & PERF_EVENT_FLAG_USER_ACCESS) &&
+	    (hwc->flags & PERF_EVENT_FLAG_USER_READ_CNT))
+		pmu_sbi_reset_scounteren((void *)event);
+
 	ret = sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_STOP, hwc->idx, 1, flag, 0, 0, 0);
 	if (ret.error && (ret.error != SBI_ERR_ALREADY_STOPPED) &&
 		flag != SBI_PMU_STOP_FLAG_RESET)
@@ -498,6 +571,67 @@ static int pmu_sbi_get_ctrinfo(int nctr, unsigned long *mask)
 	return 0;
 }
 
+static void pmu_sbi_snapshot_free(struct riscv_pmu *pmu)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct cpu_hw_events *cpu_hw_evt = per_cpu_ptr(pmu->hw_events, cpu);
+
+		if (!cpu_hw_evt->snapshot_addr)
+			continue;
+
+		free_page((unsigned long)cpu_hw_evt->snapshot_addr);
+		cpu_hw_evt->snapshot_addr = NULL;
+		cpu_hw_evt->snapshot_addr_phys = 0;
+	}
+}
+
+static int pmu_sbi_snapshot_alloc(struct riscv_pmu *pmu)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct cpu_hw_events *cpu_hw_evt = per_cpu_ptr(pmu->hw_events, cpu);
+
+		cpu_hw_evt->snapshot_addr =
+				(void *)get_zeroed_page(GFP_KERNEL);
+		if (!cpu_hw_evt->snapshot_addr) {
+			pmu_sbi_snapshot_free(pmu);
+			return -ENOMEM;
+		}
+		cpu_hw_evt->snapshot_addr_phys = __pa(cpu_hw_evt->snapshot_addr);
+	}
+
+	return 0;
+}
+
+/* Register the calling hart's snapshot page with the firmware. */
+static int pmu_sbi_snapshot_setup(struct riscv_pmu *pmu, int cpu)
+{
+	struct cpu_hw_events *cpu_hw_evt = per_cpu_ptr(pmu->hw_events, cpu);
+	phys_addr_t pa = cpu_hw_evt->snapshot_addr_phys;
+	struct sbiret ret;
+
+	if (!cpu_hw_evt->snapshot_addr)
+		return -EINVAL;
+
+	ret = sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_SNAPSHOT_SET_SHMEM, pa,
+			IS_ENABLED(CONFIG_32BIT) ? (u64)pa >> 32 : 0,
+			0, 0, 0, 0);
+	if (ret.error)
+		return sbi_err_map_linux_errno(ret.error);
+
+	return 0;
+}
+
+static void pmu_sbi_snapshot_disable(void)
+{
+	sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_SNAPSHOT_SET_SHMEM,
+		  SBI_PMU_SNAPSHOT_SHMEM_DISABLE,
+		  SBI_PMU_SNAPSHOT_SHMEM_DISABLE, 0, 0, 0, 0);
+}
+
 static inline void pmu_sbi_stop_all(struct riscv_pmu *pmu)
 {
 	/*
@@ -511,10 +645,12 @@ static inline void pmu_sbi_stop_all(struct riscv_pmu *pmu)
 static inline void pmu_sbi_stop_hw_ctrs(struct riscv_pmu *pmu)
 {
 	struct cpu_hw_events *cpu_hw_evt = this_cpu_ptr(pmu->hw_events);
+	unsigned long flag = sbi_pmu_snapshot_available ?
+			     SBI_PMU_STOP_FLAG_TAKE_SNAPSHOT : 0;
 
 	/* No need to check the error here as we can't do anything about the error */
 	sbi_ecall(SBI_EXT_PMU, SBI_EXT_PMU_COUNTER_STOP, 0,
-		  cpu_hw_evt->used_hw_ctrs[0], 0, 0, 0, 0);
+		  cpu_hw_evt->used_hw_ctrs[0], flag, 0, 0, 0);
 }
 
 /*
@@ -564,6 +700,60 @@ static inline void pmu_sbi_start_overflow_mask(struct riscv_pmu *pmu,
 	}
 }
 
+static void pmu_sbi_event_init(struct perf_event *event)
+{
+	/*
+	 * The permissions are latched at event creation so that a sysctl
+	 * change cannot revoke access from an already mmap'd event.
+	 */
+	if (sysctl_perf_user_access == SYSCTL_NO_USER_ACCESS)
+		event->hw.flags |= PERF_EVENT_FLAG_NO_USER_ACCESS;
+	else if (sysctl_perf_user_access == SYSCTL_USER_ACCESS)
+		event->hw.flags |= PERF_EVENT_FLAG_USER_ACCESS;
+	else
+		event->hw.flags |= PERF_EVENT_FLAG_LEGACY;
+}
+
+static void pmu_sbi_event_mapped(struct perf_event *event, struct mm_struct *mm)
+{
+	if (event->hw.flags & PERF_EVENT_FLAG_NO_USER_ACCESS)
+		return;
+
+	/*
+	 * Legacy mode only delegates the fixed cycle and instret
+	 * counters, which are enabled for everybody anyway; the events
+	 * just advertise cap_user_rdpmc for them.
+	 */
+	if (event->hw.flags & PERF_EVENT_FLAG_LEGACY &&
+	    event->attr.config != PERF_COUNT_HW_CPU_CYCLES &&
+	    event->attr.config != PERF_COUNT_HW_INSTRUCTIONS)
+		return;
+
+	event->hw.flags |= PERF_EVENT_FLAG_USER_READ_CNT;
+
+	/*
+	 * The counter delegation must be in place before the user page
+	 * advertises it. Enable it on every CPU running this mm; the
+	 * ctr_start/ctr_stop paths keep it current from then on as the
+	 * perf core schedules the event in and out with its task.
+	 */
+	if (event->hw.flags & PERF_EVENT_FLAG_USER_ACCESS)
+		on_each_cpu_mask(mm_cpumask(mm), pmu_sbi_set_scounteren,
+				 (void *)event, 1);
+}
+
+static void pmu_sbi_event_unmapped(struct perf_event *event, struct mm_struct *mm)
+{
+	if (event->hw.flags & PERF_EVENT_FLAG_NO_USER_ACCESS)
+		return;
+
+	event->hw.flags &= ~PERF_EVENT_FLAG_USER_READ_CNT;
+
+	if (event->hw.flags & PERF_EVENT_FLAG_USER_ACCESS)
+		on_each_cpu_mask(mm_cpumask(mm), pmu_sbi_reset_scounteren,
+				 (void *)event, 1);
+}
+
 static irqreturn_t pmu_sbi_ovf_handler(int irq, void *dev)
 {
 	struct perf_sample_data data;
@@ -592,8 +782,16 @@ static irqreturn_t pmu_sbi_ovf_handler(int irq, void *dev)
 	pmu = to_riscv_pmu(event->pmu);
 	pmu_sbi_stop_hw_ctrs(pmu);
 
-	/* Overflow status register should only be read after counter are stopped */
-	ALT_SBI_PMU_OVERFLOW(overflow);
+	/*
+	 * Overflow status should only be read after the counters are
+	 * stopped. With the snapshot shared memory the stop ecall above
+	 * already deposited it, so read the page instead of trapping to
+	 * the firmware (or the M-mode CSR) again.
+	 */
+	if (sbi_pmu_snapshot_available)
+		overflow = cpu_hw_evt->snapshot_addr->ctr_overflow_mask;
+	else
+		ALT_SBI_PMU_OVERFLOW(overflow);
 
 	/*
 	 * Overflow interrupt pending bit should only be cleared after stopping
@@ -619,11 +817,20 @@ static irqreturn_t pmu_sbi_ovf_handler(int irq, void *dev)
 		if (!info || info->type != SBI_PMU_CTR_TYPE_HW)
 			continue;
 
-		/* compute hardware counter index */
-		hidx = info->csr - CSR_CYCLE;
-		/* check if the corresponding bit is set in sscountovf */
-		if (!(overflow & (1 << hidx)))
-			continue;
+		/*
+		 * The snapshot reports overflow per logical counter index,
+		 * sscountovf per hardware counter index.
+		 */
+		if (sbi_pmu_snapshot_available) {
+			if (!(overflow & BIT(lidx)))
+				continue;
+		} else {
+			/* compute hardware counter index */
+			hidx = info->csr - CSR_CYCLE;
+			/* check if the corresponding bit is set in sscountovf */
+			if (!(overflow & (1 << hidx)))
+				continue;
+		}
 
 		/*
 		 * Keep a track of overflowed counters so that they can be started
@@ -658,14 +865,22 @@ static int pmu_sbi_starting_cpu(unsigned int cpu, struct hlist_node *node)
 	struct cpu_hw_events *cpu_hw_evt = this_cpu_ptr(pmu->hw_events);
 
 	/*
-	 * Enable the access for CYCLE, TIME, and INSTRET CSRs from userspace,
-	 * as is necessary to maintain uABI compatibility.
+	 * In legacy mode keep CYCLE, TIME, and INSTRET delegated to
+	 * userspace, as is necessary to maintain uABI compatibility.
+	 * Otherwise only TIME is; counter CSRs are delegated individually
+	 * when an event owning them is mmap'd by its task.
 	 */
-	csr_write(CSR_SCOUNTEREN, 0x7);
+	if (sysctl_perf_user_access == SYSCTL_LEGACY)
+		csr_write(CSR_SCOUNTEREN, 0x7);
+	else
+		csr_write(CSR_SCOUNTEREN, 0x2);
 
 	/* Stop all the counters so that they can be enabled from perf */
 	pmu_sbi_stop_all(pmu);
 
+	if (sbi_pmu_snapshot_available && pmu_sbi_snapshot_setup(pmu, cpu))
+		pr_warn("Failed to setup PMU snapshot for CPU %d\n", cpu);
+
 	if (riscv_pmu_use_irq) {
 		cpu_hw_evt->irq = riscv_pmu_irq;
 		csr_clear(CSR_IP, BIT(riscv_pmu_irq_num));
@@ -683,6 +898,9 @@ static int pmu_sbi_dying_cpu(unsigned int cpu, struct hlist_node *node)
 		csr_clear(CSR_IE, BIT(riscv_pmu_irq_num));
 	}
 
+	if (sbi_pmu_snapshot_available)
+		pmu_sbi_snapshot_disable();
+
 	/* Disable all counters access for user mode now */
 	csr_write(CSR_SCOUNTEREN, 0x0);
 
@@ -805,6 +1023,37 @@ static inline int riscv_pm_pmu_register(struct riscv_pmu *pmu) { return 0; }
 static inline void riscv_pm_pmu_unregister(struct riscv_pmu *pmu) { }
 #endif
 
+static int riscv_pmu_proc_user_access_handler(struct ctl_table *table,
+					      int write, void *buffer,
+					      size_t *lenp, loff_t *ppos)
+{
+	int prev = sysctl_perf_user_access;
+	int ret = proc_dointvec_minmax(table, write, buffer, lenp, ppos);
+
+	/*
+	 * A mode change only adjusts the always-delegated base set
+	 * (cycle/instret in legacy mode); permissions of existing events
+	 * were latched at creation and are left alone.
+	 */
+	if (!ret && write && prev != sysctl_perf_user_access)
+		on_each_cpu(pmu_sbi_sysctl_scounteren, NULL, 1);
+
+	return ret;
+}
+
+static struct ctl_table sbi_pmu_sysctl_table[] = {
+	{
+		.procname       = "perf_user_access",
+		.data		= &sysctl_perf_user_access,
+		.maxlen		= sizeof(unsigned int),
+		.mode           = 0644,
+		.proc_handler	= riscv_pmu_proc_user_access_handler,
+		.extra1		= SYSCTL_ZERO,
+		.extra2		= SYSCTL_TWO,
+	},
+	{ }
+};
+
 static void riscv_pmu_destroy(struct riscv_pmu *pmu)
 {
 	riscv_pm_pmu_unregister(pmu);
@@ -849,6 +1098,28 @@ static int pmu_sbi_device_probe(struct platform_device *pdev)
 	pmu->ctr_get_width = pmu_sbi_ctr_get_width;
 	pmu->ctr_clear_idx = pmu_sbi_ctr_clear_idx;
 	pmu->ctr_read = pmu_sbi_ctr_read;
+	pmu->event_init = pmu_sbi_event_init;
+	pmu->event_mapped = pmu_sbi_event_mapped;
+	pmu->event_unmapped = pmu_sbi_event_unmapped;
+	pmu->csr_index = pmu_sbi_csr_index;
+
+	/*
+	 * The snapshot shared memory is an SBI v2.0 feature. Probe it by
+	 * registering the boot hart's page before the hotplug callbacks
+	 * set up the other harts; older firmwares simply reject the call.
+	 */
+	if (sbi_spec_version >= sbi_mk_version(2, 0) &&
+	    !pmu_sbi_snapshot_alloc(pmu)) {
+		int cpu = get_cpu();
+
+		if (pmu_sbi_snapshot_setup(pmu, cpu)) {
+			pmu_sbi_snapshot_free(pmu);
+		} else {
+			pr_info("SBI PMU snapshot shared memory is available\n");
+			sbi_pmu_snapshot_available = true;
+		}
+		put_cpu();
+	}
 
 	ret = cpuhp_state_add_instance(CPUHP_AP_PERF_RISCV_STARTING, &pmu->node);
 	if (ret)
@@ -862,6 +1133,8 @@ static int pmu_sbi_device_probe(struct platform_device *pdev)
 	if (ret)
 		goto out_unregister;
 
+	register_sysctl("kernel", sbi_pmu_sysctl_table);
+
 	return 0;
 
 out_unregister:
@@ -10,10 +10,12 @@
 
 #include <linux/debugfs.h>
 #include <linux/interrupt.h>
+#include <linux/io-64-nonatomic-lo-hi.h>
 #include <linux/of_irq.h>
 #include <linux/of_address.h>
 #include <linux/device.h>
 #include <linux/bitfield.h>
+#include <linux/perf_event.h>
 #include <asm/cacheinfo.h>
 #include <soc/sifive/sifive_ccache.h>
 
@@ -44,6 +46,18 @@
 
 #define SIFIVE_CCACHE_MAX_ECCINTR 4
 
+/*
+ * Performance monitor block: one 64-bit event selector, client filter
+ * and free-running counter per implemented counter. The number of
+ * counters is a design-time parameter with no discovery register, so it
+ * comes from the "sifive,perfmon-counters" devicetree property.
+ */
+#define SIFIVE_CCACHE_PM_EVENTSELECT(n)		(0x2000 + 8 * (n))
+#define SIFIVE_CCACHE_PM_CLIENTFILTER(n)	(0x2800 + 8 * (n))
+#define SIFIVE_CCACHE_PM_EVENTCOUNTER(n)	(0x3000 + 8 * (n))
+
+#define SIFIVE_CCACHE_PM_MAX_COUNTERS 64
+
 static void __iomem *ccache_base;
 static int g_irq[SIFIVE_CCACHE_MAX_ECCINTR];
 static struct riscv_cacheinfo_ops ccache_cache_ops;
@@ -103,6 +117,186 @@ static void ccache_config_read(void)
 	pr_info("Index of the largest way enabled: %u\n", cfg);
 }
 
+/*
+ * Uncore PMU on top of the performance monitor block, so perf stat can
+ * attribute cache hits, misses and evictions to the composable cache.
+ * Event selector values (an event set index in the low byte plus a mask
+ * of events from that set above it) and client filter masks follow the
+ * SoC's cache controller manual and are passed through as raw config.
+ * The counters are 64 bit, free running and raise no overflow interrupt.
+ */
+struct ccache_pmu {
+	struct pmu pmu;
+	struct perf_event *events[SIFIVE_CCACHE_PM_MAX_COUNTERS];
+	DECLARE_BITMAP(used_mask, SIFIVE_CCACHE_PM_MAX_COUNTERS);
+	unsigned int n_counters;
+	cpumask_t cpumask;
+};
+
+static struct ccache_pmu ccache_pmu;
+
+#define to_ccache_pmu(p) (container_of(p, struct ccache_pmu, pmu))
+
+PMU_FORMAT_ATTR(event, "config:0-63");
+PMU_FORMAT_ATTR(clientfilter, "config1:0-63");
+
+static struct attribute *ccache_pmu_format_attrs[] = {
+	&format_attr_event.attr,
+	&format_attr_clientfilter.attr,
+	NULL,
+};
+
+static const struct attribute_group ccache_pmu_format_group = {
+	.name = "format",
+	.attrs = ccache_pmu_format_attrs,
+};
+
+static ssize_t ccache_pmu_cpumask_show(struct device *dev,
+				       struct device_attribute *attr,
+				       char *buf)
+{
+	return cpumap_print_to_pagebuf(true, buf, &ccache_pmu.cpumask);
+}
+
+static DEVICE_ATTR(cpumask, 0444, ccache_pmu_cpumask_show, NULL);
+
+static struct attribute *ccache_pmu_cpumask_attrs[] = {
+	&dev_attr_cpumask.attr,
+	NULL,
+};
+
+static const struct attribute_group ccache_pmu_cpumask_group = {
+	.attrs = ccache_pmu_cpumask_attrs,
+};
+
+static const struct attribute_group *ccache_pmu_attr_groups[] = {
+	&ccache_pmu_format_group,
+	&ccache_pmu_cpumask_group,
+	NULL,
+};
+
+static void ccache_pmu_event_update(struct perf_event *event)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	u64 prev, now;
+
+	do {
+		prev = local64_read(&hwc->prev_count);
+		now = readq(ccache_base +
+			    SIFIVE_CCACHE_PM_EVENTCOUNTER(hwc->idx));
+	} while (local64_cmpxchg(&hwc->prev_count, prev, now) != prev);
+
+	local64_add(now - prev, &event->count);
+}
+
+static void ccache_pmu_event_start(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	hwc->state = 0;
+	local64_set(&hwc->prev_count,
+		    readq(ccache_base +
+			  SIFIVE_CCACHE_PM_EVENTCOUNTER(hwc->idx)));
+	writeq(event->attr.config,
+	       ccache_base + SIFIVE_CCACHE_PM_EVENTSELECT(hwc->idx));
+}
+
+static void ccache_pmu_event_stop(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	writeq(0, ccache_base + SIFIVE_CCACHE_PM_EVENTSELECT(hwc->idx));
+	if (flags & PERF_EF_UPDATE)
+		ccache_pmu_event_update(event);
+	hwc->state |= PERF_HES_STOPPED | PERF_HES_UPTODATE;
+}
+
+static int ccache_pmu_event_add(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+	int idx;
+
+	idx = find_first_zero_bit(ccache_pmu.used_mask,
+				  ccache_pmu.n_counters);
+	if (idx >= ccache_pmu.n_counters)
+		return -EAGAIN;
+
+	set_bit(idx, ccache_pmu.used_mask);
+	ccache_pmu.events[idx] = event;
+	hwc->idx = idx;
+	hwc->state = PERF_HES_STOPPED | PERF_HES_UPTODATE;
+
+	writeq(event->attr.config1,
+	       ccache_base + SIFIVE_CCACHE_PM_CLIENTFILTER(idx));
+
+	if (flags & PERF_EF_START)
+		ccache_pmu_event_start(event, flags);
+
+	perf_event_update_userpage(event);
+
+	return 0;
+}
+
+static void ccache_pmu_event_del(struct perf_event *event, int flags)
+{
+	struct hw_perf_event *hwc = &event->hw;
+
+	ccache_pmu_event_stop(event, PERF_EF_UPDATE);
+	ccache_pmu.events[hwc->idx] = NULL;
+	clear_bit(hwc->idx, ccache_pmu.used_mask);
+	perf_event_update_userpage(event);
+}
+
+static int ccache_pmu_event_init(struct perf_event *event)
+{
+	if (event->attr.type != event->pmu->type)
+		return -ENOENT;
+
+	/* The counters cannot interrupt, so sampling is not possible */
+	if (is_sampling_event(event) || event->attach_state & PERF_ATTACH_TASK)
+		return -EOPNOTSUPP;
+
+	/* A shared uncore resource: counted on one designated CPU only */
+	if (event->cpu < 0)
+		return -EINVAL;
+	event->cpu = cpumask_first(&ccache_pmu.cpumask);
+
+	return 0;
+}
+
+static void ccache_pmu_init(struct device_node *np)
+{
+	u32 n_counters;
+	int rc;
+
+	if (of_property_read_u32(np, "sifive,perfmon-counters", &n_counters) ||
+	    !n_counters)
+		return;
+
+	ccache_pmu.n_counters = min_t(u32, n_counters,
+				      SIFIVE_CCACHE_PM_MAX_COUNTERS);
+	cpumask_set_cpu(raw_smp_processor_id(), &ccache_pmu.cpumask);
+	ccache_pmu.pmu = (struct pmu) {
+		.task_ctx_nr	= perf_invalid_context,
+		.attr_groups	= ccache_pmu_attr_groups,
+		.capabilities	= PERF_PMU_CAP_NO_EXCLUDE |
+				  PERF_PMU_CAP_NO_INTERRUPT,
+		.event_init	= ccache_pmu_event_init,
+		.add		= ccache_pmu_event_add,
+		.del		= ccache_pmu_event_del,
+		.start		= ccache_pmu_event_start,
+		.stop		= ccache_pmu_event_stop,
+		.read		= ccache_pmu_event_update,
+	};
+
+	rc = perf_pmu_register(&ccache_pmu.pmu, "sifive_ccache", -1);
+	if (rc)
+		pr_err("Could not register PMU: %d\n", rc);
+	else
+		pr_info("Registered PMU with %u event counters\n",
+			ccache_pmu.n_counters);
+}
+
 static const struct of_device_id sifive_ccache_ids[] = {
 	{ .compatible = "sifive,fu540-c000-ccache" },
 	{ .compatible = "sifive,fu740-c000-ccache" },
@@ -247,6 +441,7 @@ static int __init sifive_ccache_init(void)
 			goto err_free_irq;
 		}
 	}
+	ccache_pmu_init(np);
 	of_node_put(np);
 
 	ccache_config_read();
@@ -8,6 +8,8 @@
 // sifive@sifive.com
 
 #include <linux/clk.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 #include <linux/module.h>
 #include <linux/interrupt.h>
 #include <linux/of.h>
@@ -22,6 +24,13 @@
 #define SIFIVE_SPI_DEFAULT_DEPTH         8
 #define SIFIVE_SPI_DEFAULT_MAX_BITS      8
 
+/*
+ * Transfers shorter than this finish in FIFO-sized chunks quickly
+ * enough that programming the DMA controller is a net loss; they stay
+ * on the polled/interrupt PIO path.
+ */
+#define SIFIVE_SPI_DMA_MIN_LEN           64
+
 /* register offsets */
 #define SIFIVE_SPI_REG_SCKDIV            0x00 /* Serial clock divisor */
 #define SIFIVE_SPI_REG_SCKMODE           0x04 /* Serial clock mode */
@@ -90,10 +99,15 @@
 
 struct sifive_spi {
 	void __iomem      *regs;        /* virt. address of control registers */
+	phys_addr_t       phys;         /* bus address of control registers */
 	struct clk        *clk;         /* bus clock */
 	unsigned int      fifo_depth;   /* fifo depth in words */
 	u32               cs_inactive;  /* level of the CS pins when inactive */
 	struct completion done;         /* wake-up from interrupt */
+	struct dma_chan   *dma_tx;      /* optional TX DMA channel */
+	struct dma_chan   *dma_rx;      /* optional RX DMA channel */
+	struct completion tx_done;      /* TX DMA completion */
+	struct completion rx_done;      /* RX DMA completion */
 };
 
 static void sifive_spi_write(struct sifive_spi *spi, int offset, u32 value)
@@ -251,6 +265,128 @@ static void sifive_spi_rx(struct sifive_spi *spi, u8 *rx_ptr)
 	*rx_ptr = data & SIFIVE_SPI_RXDATA_DATA_MASK;
 }
 
+static bool sifive_spi_can_dma(struct spi_master *master,
+			       struct spi_device *device,
+			       struct spi_transfer *t)
+{
+	struct sifive_spi *spi = spi_master_get_devdata(master);
+
+	return spi->dma_tx && t->len >= SIFIVE_SPI_DMA_MIN_LEN &&
+	       (!t->rx_buf || spi->dma_rx);
+}
+
+static void sifive_spi_dma_done(void *data)
+{
+	complete(data);
+}
+
+/*
+ * Stream the transfer through the DMA controller, paced by the FIFO
+ * watermark request lines: TX requests are raised while a full burst
+ * still fits into the FIFO, RX requests once a full burst has
+ * arrived.  The scatterlist is handed to the DMA controller in one
+ * descriptor chain, so chunks are fetched back to back without the
+ * CPU refilling the FIFO in between.
+ */
+static int sifive_spi_transfer_dma(struct sifive_spi *spi,
+				   struct spi_transfer *t)
+{
+	struct dma_async_tx_descriptor *tx_desc, *rx_desc = NULL;
+	unsigned int burst = spi->fifo_depth / 2;
+	struct dma_slave_config cfg;
+	unsigned long timeout;
+	int ret;
+
+	/* Transfer time at wire speed plus a generous scheduling margin */
+	timeout = msecs_to_jiffies(1000UL * t->len * 8 / t->speed_hz + 100);
+
+	if (t->rx_buf) {
+		memset(&cfg, 0, sizeof(cfg));
+		cfg.direction = DMA_DEV_TO_MEM;
+		cfg.src_addr = spi->phys + SIFIVE_SPI_REG_RXDATA;
+		cfg.src_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE;
+		cfg.src_maxburst = burst;
+		ret = dmaengine_slave_config(spi->dma_rx, &cfg);
+		if (ret)
+			return ret;
+
+		sifive_spi_write(spi, SIFIVE_SPI_REG_RXMARK, burst - 1);
+
+		rx_desc = dmaengine_prep_slave_sg(spi->dma_rx,
+						  t->rx_sg.sgl, t->rx_sg.nents,
+						  DMA_DEV_TO_MEM,
+						  DMA_PREP_INTERRUPT |
+						  DMA_CTRL_ACK);
+		if (!rx_desc)
+			return -ENOMEM;
+
+		reinit_completion(&spi->rx_done);
+		rx_desc->callback = sifive_spi_dma_done;
+		rx_desc->callback_param = &spi->rx_done;
+	}
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.direction = DMA_MEM_TO_DEV;
+	cfg.dst_addr = spi->phys + SIFIVE_SPI_REG_TXDATA;
+	cfg.dst_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE;
+	cfg.dst_maxburst = burst;
+	ret = dmaengine_slave_config(spi->dma_tx, &cfg);
+	if (ret)
+		return ret;
+
+	sifive_spi_write(spi, SIFIVE_SPI_REG_TXMARK,
+			 spi->fifo_depth - burst + 1);
+
+	tx_desc = dmaengine_prep_slave_sg(spi->dma_tx,
+					  t->tx_sg.sgl, t->tx_sg.nents,
+					  DMA_MEM_TO_DEV,
+					  DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!tx_desc)
+		return -ENOMEM;
+
+	reinit_completion(&spi->tx_done);
+	tx_desc->callback = sifive_spi_dma_done;
+	tx_desc->callback_param = &spi->tx_done;
+
+	/* The RX side must be listening before the first TX burst */
+	if (rx_desc) {
+		ret = dma_submit_error(dmaengine_submit(rx_desc));
+		if (ret)
+			return ret;
+		dma_async_issue_pending(spi->dma_rx);
+	}
+
+	ret = dma_submit_error(dmaengine_submit(tx_desc));
+	if (ret)
+		goto err_terminate;
+
+	dma_async_issue_pending(spi->dma_tx);
+
+	ret = -ETIMEDOUT;
+	if (!wait_for_completion_timeout(&spi->tx_done, timeout))
+		goto err_terminate;
+
+	if (rx_desc) {
+		if (!wait_for_completion_timeout(&spi->rx_done, timeout))
+			goto err_terminate;
+	} else {
+		/*
+		 * TX DMA completion only means the last byte reached
+		 * the FIFO; wait until it has been shifted out.
+		 */
+		sifive_spi_write(spi, SIFIVE_SPI_REG_TXMARK, 1);
+		sifive_spi_wait(spi, SIFIVE_SPI_IP_TXWM, 1);
+	}
+
+	return 0;
+
+err_terminate:
+	dmaengine_terminate_sync(spi->dma_tx);
+	if (rx_desc)
+		dmaengine_terminate_sync(spi->dma_rx);
+	return ret;
+}
+
 static int
 sifive_spi_transfer_one(struct spi_master *master, struct spi_device *device,
 			struct spi_transfer *t)
@@ -261,6 +397,10 @@ sifive_spi_transfer_one(struct spi_master *master, struct spi_device *device,
 	u8 *rx_ptr = t->rx_buf;
 	unsigned int remaining_words = t->len;
 
+	if (master->cur_msg_mapped &&
+	    sifive_spi_can_dma(master, device, t))
+		return sifive_spi_transfer_dma(spi, t);
+
 	while (remaining_words) {
 		unsigned int n_words = min(remaining_words, spi->fifo_depth);
 		unsigned int i;
@@ -295,6 +435,7 @@ static int sifive_spi_probe(struct platform_device *pdev)
 	int ret, irq, num_cs;
 	u32 cs_bits, max_bits_per_word;
 	struct spi_master *master;
+	struct resource *res;
 
 	master = spi_alloc_master(&pdev->dev, sizeof(struct sifive_spi));
 	if (!master) {
@@ -304,13 +445,16 @@ static int sifive_spi_probe(struct platform_device *pdev)
 
 	spi = spi_master_get_devdata(master);
 	init_completion(&spi->done);
+	init_completion(&spi->tx_done);
+	init_completion(&spi->rx_done);
 	platform_set_drvdata(pdev, master);
 
-	spi->regs = devm_platform_ioremap_resource(pdev, 0);
+	spi->regs = devm_platform_get_and_ioremap_resource(pdev, 0, &res);
 	if (IS_ERR(spi->regs)) {
 		ret = PTR_ERR(spi->regs);
 		goto put_master;
 	}
+	spi->phys = res->start;
 
 	spi->clk = devm_clk_get(&pdev->dev, NULL);
 	if (IS_ERR(spi->clk)) {
@@ -396,17 +540,43 @@ static int sifive_spi_probe(struct platform_device *pdev)
 		goto disable_clk;
 	}
 
-	dev_info(&pdev->dev, "mapped; irq=%d, cs=%d\n",
-		 irq, master->num_chipselect);
+	/* Optional DMA channels; fall back to PIO without them */
+	spi->dma_tx = dma_request_chan(&pdev->dev, "tx");
+	if (IS_ERR(spi->dma_tx)) {
+		ret = PTR_ERR(spi->dma_tx);
+		spi->dma_tx = NULL;
+		if (ret == -EPROBE_DEFER)
+			goto disable_clk;
+	} else {
+		spi->dma_rx = dma_request_chan(&pdev->dev, "rx");
+		if (IS_ERR(spi->dma_rx)) {
+			ret = PTR_ERR(spi->dma_rx);
+			spi->dma_rx = NULL;
+			if (ret == -EPROBE_DEFER)
+				goto release_dma;
+		}
+		master->can_dma = sifive_spi_can_dma;
+		master->dma_tx = spi->dma_tx;
+		master->dma_rx = spi->dma_rx;
+	}
+
+	dev_info(&pdev->dev, "mapped; irq=%d, cs=%d, dma=%s\n",
+		 irq, master->num_chipselect,
+		 spi->dma_tx ? (spi->dma_rx ? "tx/rx" : "tx") : "none");
 
 	ret = devm_spi_register_master(&pdev->dev, master);
 	if (ret < 0) {
 		dev_err(&pdev->dev, "spi_register_master failed\n");
-		goto disable_clk;
+		goto release_dma;
 	}
 
 	return 0;
 
+release_dma:
+	if (spi->dma_rx)
+		dma_release_channel(spi->dma_rx);
+	if (spi->dma_tx)
+		dma_release_channel(spi->dma_tx);
 disable_clk:
 	clk_disable_unprepare(spi->clk);
 put_master:
@@ -422,6 +592,10 @@ static int sifive_spi_remove(struct platform_device *pdev)
 
 	/* Disable all the interrupts just in case */
 	sifive_spi_write(spi, SIFIVE_SPI_REG_IE, 0);
+	if (spi->dma_rx)
+		dma_release_channel(spi->dma_rx);
+	if (spi->dma_tx)
+		dma_release_channel(spi->dma_tx);
 	clk_disable_unprepare(spi->clk);
 
 	return 0;
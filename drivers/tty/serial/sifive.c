@@ -31,6 +31,8 @@
 #include <linux/clk.h>
 #include <linux/console.h>
 #include <linux/delay.h>
+#include <linux/dmaengine.h>
+#include <linux/dma-mapping.h>
 #include <linux/init.h>
 #include <linux/io.h>
 #include <linux/irq.h>
@@ -125,6 +127,19 @@
 /* SIFIVE_RX_FIFO_DEPTH: depth of the TX FIFO (in bytes) */
 #define SIFIVE_RX_FIFO_DEPTH			8
 
+/* SIFIVE_SERIAL_RX_RING_SZ: size of the RX DMA ring buffer (in bytes) */
+#define SIFIVE_SERIAL_RX_RING_SZ		4096
+
+/* SIFIVE_SERIAL_RX_POLL_MS: interval between RX DMA ring flushes */
+#define SIFIVE_SERIAL_RX_POLL_MS		2
+
+/*
+ * SIFIVE_SERIAL_TX_DMA_MIN: shortest transmit queue worth programming a
+ *                           DMA descriptor for; shorter writes fit into
+ *                           the TX FIFO in one watermark interrupt anyway
+ */
+#define SIFIVE_SERIAL_TX_DMA_MIN		16
+
 #if (SIFIVE_TX_FIFO_DEPTH != SIFIVE_RX_FIFO_DEPTH)
 #error Driver does not support configurations with different TX, RX FIFO sizes
 #endif
@@ -141,6 +156,18 @@
  * @baud_rate: UART serial line rate (e.g., 115200 baud)
  * @clk: reference to this device's clock
  * @clk_notifier: clock rate change notifier for upstream clock changes
+ * @rx_chan: optional DMA channel filling the RX ring buffer
+ * @tx_chan: optional DMA channel draining the transmit queue
+ * @rx_cookie: dmaengine cookie of the cyclic RX transfer
+ * @tx_cookie: dmaengine cookie of the in-flight TX transfer
+ * @rx_ring: RX DMA ring buffer, or NULL when RX DMA is not in use
+ * @rx_ring_dma: bus address of @rx_ring
+ * @rx_ring_tail: offset into @rx_ring up to which data was pushed to the tty
+ * @rx_dma_running: true while the cyclic RX transfer and flush timer run
+ * @rx_timer: timer flushing @rx_ring into the tty layer
+ * @tx_dma_addr: bus address of the mapped transmit queue chunk
+ * @tx_dma_bytes: length of the in-flight TX transfer (in bytes)
+ * @tx_dma_busy: true while a TX transfer is in flight
  *
  * Configuration data specific to this SiFive UART.
  */
@@ -151,6 +178,18 @@ struct sifive_serial_port {
 	unsigned long		baud_rate;
 	struct clk		*clk;
 	struct notifier_block	clk_notifier;
+	struct dma_chan		*rx_chan;
+	struct dma_chan		*tx_chan;
+	dma_cookie_t		rx_cookie;
+	dma_cookie_t		tx_cookie;
+	unsigned char		*rx_ring;
+	dma_addr_t		rx_ring_dma;
+	unsigned int		rx_ring_tail;
+	bool			rx_dma_running;
+	struct timer_list	rx_timer;
+	dma_addr_t		tx_dma_addr;
+	unsigned int		tx_dma_bytes;
+	bool			tx_dma_busy;
 };
 
 /*
@@ -169,6 +208,7 @@ struct sifive_serial_port {
  * Forward declarations
  */
 static void sifive_serial_stop_tx(struct uart_port *port);
+static void __ssp_tx_dma_complete(void *arg);
 
 /*
  * Internal functions
@@ -439,6 +479,277 @@ static void __ssp_receive_chars(struct sifive_serial_port *ssp)
 	tty_flip_buffer_push(&ssp->port.state->port);
 }
 
+/**
+ * __ssp_rx_dma_flush() - push received DMA ring data into the tty layer
+ * @ssp: pointer to a struct sifive_serial_port
+ *
+ * Determine how far the cyclic RX transfer has advanced through the ring
+ * buffer and hand everything between the last flush point and the current
+ * write position to the tty layer.
+ *
+ * Context: Any context.  Expects @ssp->port.lock to be held by caller.
+ */
+static void __ssp_rx_dma_flush(struct sifive_serial_port *ssp)
+{
+	struct tty_port *tport = &ssp->port.state->port;
+	struct dma_tx_state state;
+	unsigned int head, tail, count;
+
+	if (!ssp->rx_dma_running)
+		return;
+
+	dmaengine_tx_status(ssp->rx_chan, ssp->rx_cookie, &state);
+	head = (SIFIVE_SERIAL_RX_RING_SZ - state.residue) &
+	       (SIFIVE_SERIAL_RX_RING_SZ - 1);
+	tail = ssp->rx_ring_tail;
+	if (head == tail)
+		return;
+
+	dma_sync_single_for_cpu(ssp->rx_chan->device->dev, ssp->rx_ring_dma,
+				SIFIVE_SERIAL_RX_RING_SZ, DMA_FROM_DEVICE);
+
+	if (head > tail) {
+		count = tty_insert_flip_string(tport, ssp->rx_ring + tail,
+					       head - tail);
+	} else {
+		count = tty_insert_flip_string(tport, ssp->rx_ring + tail,
+					       SIFIVE_SERIAL_RX_RING_SZ - tail);
+		count += tty_insert_flip_string(tport, ssp->rx_ring, head);
+	}
+	ssp->port.icount.rx += count;
+	ssp->rx_ring_tail = head;
+
+	dma_sync_single_for_device(ssp->rx_chan->device->dev,
+				   ssp->rx_ring_dma,
+				   SIFIVE_SERIAL_RX_RING_SZ, DMA_FROM_DEVICE);
+
+	tty_flip_buffer_push(tport);
+}
+
+static void sifive_serial_rx_dma_timer(struct timer_list *t)
+{
+	struct sifive_serial_port *ssp = from_timer(ssp, t, rx_timer);
+	unsigned long flags;
+
+	spin_lock_irqsave(&ssp->port.lock, flags);
+	__ssp_rx_dma_flush(ssp);
+	if (ssp->rx_dma_running)
+		mod_timer(&ssp->rx_timer, jiffies +
+			  msecs_to_jiffies(SIFIVE_SERIAL_RX_POLL_MS));
+	spin_unlock_irqrestore(&ssp->port.lock, flags);
+}
+
+/**
+ * __ssp_start_rx_dma() - start cyclic DMA reception into the ring buffer
+ * @ssp: pointer to a struct sifive_serial_port
+ *
+ * Set up a cyclic DMA transfer from the RX FIFO into the ring buffer,
+ * paced by the RX watermark request line, and arm the flush timer.  While
+ * the transfer runs, per-character RX watermark interrupts stay disabled.
+ *
+ * Return: 0 upon success, or a negative errno to fall back to IRQ-driven
+ * reception.
+ */
+static int __ssp_start_rx_dma(struct sifive_serial_port *ssp)
+{
+	struct dma_slave_config cfg = {
+		.direction = DMA_DEV_TO_MEM,
+		.src_addr = ssp->port.mapbase + SIFIVE_SERIAL_RXDATA_OFFS,
+		.src_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE,
+		.src_maxburst = 1,
+	};
+	struct dma_async_tx_descriptor *desc;
+	int ret;
+
+	ret = dmaengine_slave_config(ssp->rx_chan, &cfg);
+	if (ret)
+		return ret;
+
+	ssp->rx_ring = kzalloc(SIFIVE_SERIAL_RX_RING_SZ, GFP_KERNEL);
+	if (!ssp->rx_ring)
+		return -ENOMEM;
+
+	ssp->rx_ring_dma = dma_map_single(ssp->rx_chan->device->dev,
+					  ssp->rx_ring,
+					  SIFIVE_SERIAL_RX_RING_SZ,
+					  DMA_FROM_DEVICE);
+	if (dma_mapping_error(ssp->rx_chan->device->dev, ssp->rx_ring_dma)) {
+		ret = -ENOMEM;
+		goto free_ring;
+	}
+
+	desc = dmaengine_prep_dma_cyclic(ssp->rx_chan, ssp->rx_ring_dma,
+					 SIFIVE_SERIAL_RX_RING_SZ,
+					 SIFIVE_SERIAL_RX_RING_SZ / 2,
+					 DMA_DEV_TO_MEM, 0);
+	if (!desc) {
+		ret = -ENOMEM;
+		goto unmap_ring;
+	}
+
+	ssp->rx_ring_tail = 0;
+	ssp->rx_cookie = dmaengine_submit(desc);
+	dma_async_issue_pending(ssp->rx_chan);
+
+	ssp->rx_dma_running = true;
+	timer_setup(&ssp->rx_timer, sifive_serial_rx_dma_timer, 0);
+	mod_timer(&ssp->rx_timer, jiffies +
+		  msecs_to_jiffies(SIFIVE_SERIAL_RX_POLL_MS));
+
+	return 0;
+
+unmap_ring:
+	dma_unmap_single(ssp->rx_chan->device->dev, ssp->rx_ring_dma,
+			 SIFIVE_SERIAL_RX_RING_SZ, DMA_FROM_DEVICE);
+free_ring:
+	kfree(ssp->rx_ring);
+	ssp->rx_ring = NULL;
+	return ret;
+}
+
+/**
+ * __ssp_stop_rx_dma() - stop DMA reception and free the ring buffer
+ * @ssp: pointer to a struct sifive_serial_port
+ *
+ * Context: Process context.  Expects @ssp->port.lock to NOT be held by
+ * the caller, since the flush timer takes it.
+ */
+static void __ssp_stop_rx_dma(struct sifive_serial_port *ssp)
+{
+	if (!ssp->rx_ring)
+		return;
+
+	ssp->rx_dma_running = false;
+	del_timer_sync(&ssp->rx_timer);
+	dmaengine_terminate_sync(ssp->rx_chan);
+	dma_unmap_single(ssp->rx_chan->device->dev, ssp->rx_ring_dma,
+			 SIFIVE_SERIAL_RX_RING_SZ, DMA_FROM_DEVICE);
+	kfree(ssp->rx_ring);
+	ssp->rx_ring = NULL;
+}
+
+/**
+ * __ssp_start_tx_dma() - hand a transmit queue chunk to the DMA engine
+ * @ssp: pointer to a struct sifive_serial_port
+ *
+ * Map the contiguous part of the transmit queue and program a slave
+ * transfer towards the TX FIFO, paced by the TX watermark request line.
+ *
+ * Context: Any context.  Expects @ssp->port.lock to be held by caller.
+ *
+ * Return: 0 if a transfer is (already) in flight, or a negative errno to
+ * fall back to IRQ-driven transmission.
+ */
+static int __ssp_start_tx_dma(struct sifive_serial_port *ssp)
+{
+	struct circ_buf *xmit = &ssp->port.state->xmit;
+	struct dma_slave_config cfg = {
+		.direction = DMA_MEM_TO_DEV,
+		.dst_addr = ssp->port.mapbase + SIFIVE_SERIAL_TXDATA_OFFS,
+		.dst_addr_width = DMA_SLAVE_BUSWIDTH_1_BYTE,
+		.dst_maxburst = 1,
+	};
+	struct dma_async_tx_descriptor *desc;
+	unsigned int count;
+
+	if (ssp->tx_dma_busy)
+		return 0;
+
+	if (ssp->port.x_char)
+		return -EBUSY;
+
+	count = CIRC_CNT_TO_END(xmit->head, xmit->tail, UART_XMIT_SIZE);
+	if (count < SIFIVE_SERIAL_TX_DMA_MIN)
+		return -EAGAIN;
+
+	if (dmaengine_slave_config(ssp->tx_chan, &cfg))
+		return -EIO;
+
+	ssp->tx_dma_addr = dma_map_single(ssp->tx_chan->device->dev,
+					  xmit->buf + xmit->tail, count,
+					  DMA_TO_DEVICE);
+	if (dma_mapping_error(ssp->tx_chan->device->dev, ssp->tx_dma_addr))
+		return -EIO;
+
+	desc = dmaengine_prep_slave_single(ssp->tx_chan, ssp->tx_dma_addr,
+					   count, DMA_MEM_TO_DEV,
+					   DMA_PREP_INTERRUPT | DMA_CTRL_ACK);
+	if (!desc) {
+		dma_unmap_single(ssp->tx_chan->device->dev, ssp->tx_dma_addr,
+				 count, DMA_TO_DEVICE);
+		return -EIO;
+	}
+
+	desc->callback = __ssp_tx_dma_complete;
+	desc->callback_param = ssp;
+
+	ssp->tx_dma_bytes = count;
+	ssp->tx_dma_busy = true;
+	ssp->tx_cookie = dmaengine_submit(desc);
+	dma_async_issue_pending(ssp->tx_chan);
+
+	return 0;
+}
+
+/**
+ * __ssp_stop_tx_dma() - cancel an in-flight TX DMA transfer
+ * @ssp: pointer to a struct sifive_serial_port
+ *
+ * Terminate the current TX transfer, credit the bytes the DMA engine
+ * already pushed into the FIFO, and unmap the transmit queue chunk.
+ *
+ * Context: Any context.  Expects @ssp->port.lock to be held by caller.
+ */
+static void __ssp_stop_tx_dma(struct sifive_serial_port *ssp)
+{
+	struct circ_buf *xmit = &ssp->port.state->xmit;
+	struct dma_tx_state state;
+	unsigned int sent;
+
+	if (!ssp->tx_dma_busy)
+		return;
+
+	dmaengine_tx_status(ssp->tx_chan, ssp->tx_cookie, &state);
+	dmaengine_terminate_async(ssp->tx_chan);
+	sent = ssp->tx_dma_bytes - state.residue;
+	dma_unmap_single(ssp->tx_chan->device->dev, ssp->tx_dma_addr,
+			 ssp->tx_dma_bytes, DMA_TO_DEVICE);
+	xmit->tail = (xmit->tail + sent) & (UART_XMIT_SIZE - 1);
+	ssp->port.icount.tx += sent;
+	ssp->tx_dma_busy = false;
+}
+
+static void __ssp_tx_dma_complete(void *arg)
+{
+	struct sifive_serial_port *ssp = arg;
+	struct circ_buf *xmit = &ssp->port.state->xmit;
+	unsigned long flags;
+
+	spin_lock_irqsave(&ssp->port.lock, flags);
+
+	/* Raced with __ssp_stop_tx_dma(), which did the accounting */
+	if (!ssp->tx_dma_busy) {
+		spin_unlock_irqrestore(&ssp->port.lock, flags);
+		return;
+	}
+
+	dma_unmap_single(ssp->tx_chan->device->dev, ssp->tx_dma_addr,
+			 ssp->tx_dma_bytes, DMA_TO_DEVICE);
+	xmit->tail = (xmit->tail + ssp->tx_dma_bytes) & (UART_XMIT_SIZE - 1);
+	ssp->port.icount.tx += ssp->tx_dma_bytes;
+	ssp->tx_dma_busy = false;
+
+	if (uart_circ_chars_pending(xmit) < WAKEUP_CHARS)
+		uart_write_wakeup(&ssp->port);
+
+	if (!uart_circ_empty(xmit) && !uart_tx_stopped(&ssp->port)) {
+		if (__ssp_start_tx_dma(ssp))
+			__ssp_enable_txwm(ssp);
+	}
+
+	spin_unlock_irqrestore(&ssp->port.lock, flags);
+}
+
 /**
  * __ssp_update_div() - calculate the divisor setting by the line rate
  * @ssp: pointer to a struct sifive_serial_port
@@ -520,6 +831,7 @@ static void sifive_serial_stop_tx(struct uart_port *port)
 {
 	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
 
+	__ssp_stop_tx_dma(ssp);
 	__ssp_disable_txwm(ssp);
 }
 
@@ -527,6 +839,19 @@ static void sifive_serial_stop_rx(struct uart_port *port)
 {
 	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
 
+	if (ssp->rx_dma_running) {
+		/*
+		 * Push out what already arrived and park the transfer;
+		 * ring teardown happens in the shutdown path, which may
+		 * sleep.
+		 */
+		__ssp_rx_dma_flush(ssp);
+		ssp->rx_dma_running = false;
+		dmaengine_terminate_async(ssp->rx_chan);
+		del_timer(&ssp->rx_timer);
+		return;
+	}
+
 	__ssp_disable_rxwm(ssp);
 }
 
@@ -534,6 +859,9 @@ static void sifive_serial_start_tx(struct uart_port *port)
 {
 	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
 
+	if (ssp->tx_chan && !__ssp_start_tx_dma(ssp))
+		return;
+
 	__ssp_enable_txwm(ssp);
 }
 
@@ -584,6 +912,9 @@ static int sifive_serial_startup(struct uart_port *port)
 {
 	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
 
+	if (ssp->rx_chan && !__ssp_start_rx_dma(ssp))
+		return 0;
+
 	__ssp_enable_rxwm(ssp);
 
 	return 0;
@@ -592,9 +923,18 @@ static int sifive_serial_startup(struct uart_port *port)
 static void sifive_serial_shutdown(struct uart_port *port)
 {
 	struct sifive_serial_port *ssp = port_to_sifive_serial_port(port);
+	unsigned long flags;
 
 	__ssp_disable_rxwm(ssp);
 	__ssp_disable_txwm(ssp);
+
+	if (ssp->tx_chan) {
+		spin_lock_irqsave(&ssp->port.lock, flags);
+		__ssp_stop_tx_dma(ssp);
+		spin_unlock_irqrestore(&ssp->port.lock, flags);
+		dmaengine_terminate_sync(ssp->tx_chan);
+	}
+	__ssp_stop_rx_dma(ssp);
 }
 
 /**
@@ -1005,11 +1345,27 @@ static int sifive_serial_probe(struct platform_device *pdev)
 		     SIFIVE_SERIAL_RXCTRL_RXEN_MASK,
 		     SIFIVE_SERIAL_RXCTRL_OFFS, ssp);
 
+	/* Optional DMA channels; the IRQ paths remain as fallback */
+	ssp->rx_chan = dma_request_chan(&pdev->dev, "rx");
+	if (IS_ERR(ssp->rx_chan)) {
+		r = PTR_ERR(ssp->rx_chan);
+		ssp->rx_chan = NULL;
+		if (r == -EPROBE_DEFER)
+			goto probe_out2;
+	}
+	ssp->tx_chan = dma_request_chan(&pdev->dev, "tx");
+	if (IS_ERR(ssp->tx_chan)) {
+		r = PTR_ERR(ssp->tx_chan);
+		ssp->tx_chan = NULL;
+		if (r == -EPROBE_DEFER)
+			goto probe_out_dma;
+	}
+
 	r = request_irq(ssp->port.irq, sifive_serial_irq, ssp->port.irqflags,
 			dev_name(&pdev->dev), ssp);
 	if (r) {
 		dev_err(&pdev->dev, "could not attach interrupt: %d\n", r);
-		goto probe_out2;
+		goto probe_out_dma;
 	}
 
 	__ssp_add_console_port(ssp);
@@ -1025,6 +1381,11 @@ static int sifive_serial_probe(struct platform_device *pdev)
 probe_out3:
 	__ssp_remove_console_port(ssp);
 	free_irq(ssp->port.irq, ssp);
+probe_out_dma:
+	if (ssp->tx_chan)
+		dma_release_channel(ssp->tx_chan);
+	if (ssp->rx_chan)
+		dma_release_channel(ssp->rx_chan);
 probe_out2:
 	clk_notifier_unregister(ssp->clk, &ssp->clk_notifier);
 probe_out1:
@@ -1038,6 +1399,10 @@ static int sifive_serial_remove(struct platform_device *dev)
 	__ssp_remove_console_port(ssp);
 	uart_remove_one_port(&sifive_serial_uart_driver, &ssp->port);
 	free_irq(ssp->port.irq, ssp);
+	if (ssp->tx_chan)
+		dma_release_channel(ssp->tx_chan);
+	if (ssp->rx_chan)
+		dma_release_channel(ssp->rx_chan);
 	clk_notifier_unregister(ssp->clk, &ssp->clk_notifier);
 
 	return 0;
@@ -126,6 +126,8 @@ struct vhost_net_virtqueue {
 	struct vhost_net_buf rxq;
 	/* Batched XDP buffs */
 	struct xdp_buff *xdp;
+	/* Used entries were published without signalling the guest yet */
+	bool notify_pending;
 };
 
 struct vhost_net {
@@ -446,16 +448,37 @@ static int vhost_net_enable_vq(struct vhost_net *n,
 	return vhost_poll_start(poll, sock->file);
 }
 
-static void vhost_net_signal_used(struct vhost_net_virtqueue *nvq)
+/* Publish batched heads to the used ring without notifying the guest;
+ * the guest can consume them right away while we keep filling.
+ */
+static void vhost_net_publish_used(struct vhost_net_virtqueue *nvq)
 {
 	struct vhost_virtqueue *vq = &nvq->vq;
-	struct vhost_dev *dev = vq->dev;
 
 	if (!nvq->done_idx)
 		return;
 
-	vhost_add_used_and_signal_n(dev, vq, vq->heads, nvq->done_idx);
+	vhost_add_used_n(vq, vq->heads, nvq->done_idx);
 	nvq->done_idx = 0;
+	nvq->notify_pending = true;
+}
+
+/* Publish any remaining heads and run the notification check once for
+ * the whole poll burst. With EVENT_IDX the check is driven by the used
+ * event the guest publishes as it consumes, so the notification rate
+ * adapts to how far the guest is lagging behind.
+ */
+static void vhost_net_signal_used(struct vhost_net_virtqueue *nvq)
+{
+	struct vhost_virtqueue *vq = &nvq->vq;
+	struct vhost_dev *dev = vq->dev;
+
+	vhost_net_publish_used(nvq);
+
+	if (nvq->notify_pending) {
+		vhost_signal(dev, vq);
+		nvq->notify_pending = false;
+	}
 }
 
 static void vhost_tx_batch(struct vhost_net *net,
@@ -491,7 +514,7 @@ static void vhost_tx_batch(struct vhost_net *net,
 	}
 
 signal_used:
-	vhost_net_signal_used(nvq);
+	vhost_net_publish_used(nvq);
 	nvq->batched_xdp = 0;
 }
 
@@ -545,7 +568,7 @@ static void vhost_net_busy_poll(struct vhost_net *net,
 	endtime = busy_clock() + busyloop_timeout;
 
 	while (vhost_can_busy_poll(endtime)) {
-		if (vhost_has_work(&net->dev)) {
+		if (vhost_vq_has_work(rvq) || vhost_vq_has_work(tvq)) {
 			*busyloop_intr = true;
 			break;
 		}
@@ -853,6 +876,7 @@ done:
 	} while (likely(!vhost_exceeds_weight(vq, ++sent_pkts, total_len)));
 
 	vhost_tx_batch(net, nvq, sock, &msg);
+	vhost_net_signal_used(nvq);
 }
 
 static void handle_tx_zerocopy(struct vhost_net *net, struct socket *sock)
@@ -1241,7 +1265,7 @@ static void handle_rx(struct vhost_net *net)
 		}
 		nvq->done_idx += headcount;
 		if (nvq->done_idx > VHOST_NET_BATCH)
-			vhost_net_signal_used(nvq);
+			vhost_net_publish_used(nvq);
 		if (unlikely(vq_log))
 			vhost_log_write(vq, vq_log, log, vhost_len,
 					vq->iov, in);
@@ -76,6 +76,21 @@
  * Currently hardcoded to the page size. */
 #define VIRTIO_MMIO_VRING_ALIGN		PAGE_SIZE
 
+/*
+ * Multi-interrupt extension: when VIRTIO_F_MMIO_MULTI_IRQ is negotiated
+ * the device delivers each queue's used-buffer notification on the
+ * platform interrupt line whose index is programmed into
+ * VIRTIO_MMIO_QUEUE_IRQ_VECTOR while the queue is selected.  Line 0
+ * keeps the legacy shared semantics and carries configuration changes.
+ * These definitions belong in the uapi headers; carry them here until
+ * that change lands.
+ */
+#ifndef VIRTIO_F_MMIO_MULTI_IRQ
+#define VIRTIO_F_MMIO_MULTI_IRQ		41
+#define VIRTIO_MMIO_QUEUE_IRQ_VECTOR	0x0c4
+#define VIRTIO_MMIO_IRQ_VECTOR_NONE	0xffffffff
+#endif
+
 
 
 #define to_virtio_mmio_device(_plat_dev) \
@@ -99,6 +114,9 @@ struct virtio_mmio_vq_info {
 
 	/* the list node for the virtqueues list */
 	struct list_head node;
+
+	/* dedicated interrupt line, or -1 when the shared line is used */
+	int irq;
 };
 
 
@@ -127,6 +145,16 @@ static int vm_finalize_features(struct virtio_device *vdev)
 	/* Give virtio_ring a chance to accept features. */
 	vring_transport_features(vdev);
 
+	/*
+	 * vring_transport_features() only knows ratified bits; re-accept
+	 * the multi-interrupt bit when the device offers it and the
+	 * platform actually wired up extra lines.
+	 */
+	if (vm_dev->version == 2 &&
+	    (vm_get_features(vdev) & BIT_ULL(VIRTIO_F_MMIO_MULTI_IRQ)) &&
+	    platform_irq_count(vm_dev->pdev) > 1)
+		__virtio_set_bit(vdev, VIRTIO_F_MMIO_MULTI_IRQ);
+
 	/* Make sure there are no mixed devices */
 	if (vm_dev->version == 2 &&
 			!__virtio_test_bit(vdev, VIRTIO_F_VERSION_1)) {
@@ -313,6 +341,15 @@ static irqreturn_t vm_interrupt(int irq, void *opaque)
 	return ret;
 }
 
+/* Notify a single virtqueue on its dedicated interrupt line. */
+static irqreturn_t vm_vring_interrupt(int irq, void *opaque)
+{
+	struct virtio_mmio_vq_info *info = opaque;
+
+	/* Dedicated lines do not use the INTERRUPT_STATUS register. */
+	return vring_interrupt(irq, info->vq);
+}
+
 
 
 static void vm_del_vq(struct virtqueue *vq)
@@ -322,6 +359,9 @@ static void vm_del_vq(struct virtqueue *vq)
 	unsigned long flags;
 	unsigned int index = vq->index;
 
+	if (info->irq >= 0)
+		free_irq(info->irq, info);
+
 	spin_lock_irqsave(&vm_dev->lock, flags);
 	list_del(&info->node);
 	spin_unlock_irqrestore(&vm_dev->lock, flags);
@@ -354,13 +394,22 @@ static void vm_del_vqs(struct virtio_device *vdev)
 static void vm_synchronize_cbs(struct virtio_device *vdev)
 {
 	struct virtio_mmio_device *vm_dev = to_virtio_mmio_device(vdev);
+	struct virtqueue *vq;
+
+	list_for_each_entry(vq, &vdev->vqs, list) {
+		struct virtio_mmio_vq_info *info = vq->priv;
+
+		if (info->irq >= 0)
+			synchronize_irq(info->irq);
+	}
 
 	synchronize_irq(platform_get_irq(vm_dev->pdev, 0));
 }
 
 static struct virtqueue *vm_setup_vq(struct virtio_device *vdev, unsigned int index,
 				  void (*callback)(struct virtqueue *vq),
-				  const char *name, bool ctx)
+				  const char *name, bool ctx,
+				  unsigned int vector)
 {
 	struct virtio_mmio_device *vm_dev = to_virtio_mmio_device(vdev);
 	struct virtio_mmio_vq_info *info;
@@ -388,6 +437,7 @@ static struct virtqueue *vm_setup_vq(struct virtio_device *vdev, unsigned int in
 		err = -ENOMEM;
 		goto error_kmalloc;
 	}
+	info->irq = -1;
 
 	num = readl(vm_dev->base + VIRTIO_MMIO_QUEUE_NUM_MAX);
 	if (num == 0) {
@@ -405,6 +455,10 @@ static struct virtqueue *vm_setup_vq(struct virtio_device *vdev, unsigned int in
 
 	vq->num_max = num;
 
+	/* Tell the device where this queue's notifications should land */
+	if (__virtio_test_bit(vdev, VIRTIO_F_MMIO_MULTI_IRQ))
+		writel(vector, vm_dev->base + VIRTIO_MMIO_QUEUE_IRQ_VECTOR);
+
 	/* Activate the queue */
 	writel(virtqueue_get_vring_size(vq), vm_dev->base + VIRTIO_MMIO_QUEUE_NUM);
 	if (vm_dev->version == 1) {
@@ -480,10 +534,19 @@ static int vm_find_vqs(struct virtio_device *vdev, unsigned int nvqs,
 	struct virtio_mmio_device *vm_dev = to_virtio_mmio_device(vdev);
 	int irq = platform_get_irq(vm_dev->pdev, 0);
 	int i, err, queue_idx = 0;
+	bool per_vq_irq;
 
 	if (irq < 0)
 		return irq;
 
+	/*
+	 * Use dedicated lines when the device understands them and the
+	 * platform provides one per queue on top of the shared line;
+	 * otherwise everything is multiplexed onto line 0 as before.
+	 */
+	per_vq_irq = __virtio_test_bit(vdev, VIRTIO_F_MMIO_MULTI_IRQ) &&
+		     platform_irq_count(vm_dev->pdev) > (int)nvqs;
+
 	err = request_irq(irq, vm_interrupt, IRQF_SHARED,
 			dev_name(&vdev->dev), vm_dev);
 	if (err)
@@ -493,17 +556,38 @@ static int vm_find_vqs(struct virtio_device *vdev, unsigned int nvqs,
 		enable_irq_wake(irq);
 
 	for (i = 0; i < nvqs; ++i) {
+		unsigned int vector = VIRTIO_MMIO_IRQ_VECTOR_NONE;
+
 		if (!names[i]) {
 			vqs[i] = NULL;
 			continue;
 		}
 
+		if (per_vq_irq)
+			vector = queue_idx + 1;
+
 		vqs[i] = vm_setup_vq(vdev, queue_idx++, callbacks[i], names[i],
-				     ctx ? ctx[i] : false);
+				     ctx ? ctx[i] : false, vector);
 		if (IS_ERR(vqs[i])) {
 			vm_del_vqs(vdev);
 			return PTR_ERR(vqs[i]);
 		}
+
+		if (vector != VIRTIO_MMIO_IRQ_VECTOR_NONE) {
+			struct virtio_mmio_vq_info *info = vqs[i]->priv;
+			int virq = platform_get_irq(vm_dev->pdev, vector);
+
+			if (virq < 0)
+				err = virq;
+			else
+				err = request_irq(virq, vm_vring_interrupt, 0,
+						  vqs[i]->name, info);
+			if (err) {
+				vm_del_vqs(vdev);
+				return err;
+			}
+			info->irq = virq;
+		}
 	}
 
 	return 0;
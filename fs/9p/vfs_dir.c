@@ -25,6 +25,9 @@
 #include "v9fs_vfs.h"
 #include "fid.h"
 
+/* Wire messages buffered per readdir refill */
+#define P9_RDIR_BATCH	4
+
 /**
  * struct p9_rdir - readdir accounting
  * @head: start offset of current dirread buffer
@@ -72,10 +75,39 @@ static struct p9_rdir *v9fs_alloc_rdir_buf(struct file *filp, int buflen)
 	struct p9_fid *fid = filp->private_data;
 
 	if (!fid->rdir)
-		fid->rdir = kzalloc(sizeof(struct p9_rdir) + buflen, GFP_KERNEL);
+		fid->rdir = kvzalloc(sizeof(struct p9_rdir) + buflen,
+				     GFP_KERNEL);
 	return fid->rdir;
 }
 
+/**
+ * v9fs_rdir_last_off - find the offset to resume from after a dirent chunk
+ * @fid: fid of the directory being read
+ * @buf: buffer holding one RREADDIR payload
+ * @len: length of the payload
+ * @offp: on success, d_off of the last entry in @buf
+ *
+ * TREADDIR offsets are opaque cookies taken from a previously returned
+ * entry, so batching consecutive requests requires walking each reply to
+ * its tail entry before the next request can be issued.
+ */
+static int v9fs_rdir_last_off(struct p9_fid *fid, uint8_t *buf, int len,
+			      u64 *offp)
+{
+	struct p9_dirent dirent;
+	int err;
+
+	while (len > 0) {
+		err = p9dirent_read(fid->clnt, buf, len, &dirent);
+		if (err < 0)
+			return err;
+		*offp = dirent.d_off;
+		buf += err;
+		len -= err;
+	}
+	return 0;
+}
+
 /**
  * v9fs_dir_readdir - iterate through a directory
  * @file: opened file structure
@@ -96,7 +128,11 @@ static int v9fs_dir_readdir(struct file *file, struct dir_context *ctx)
 	p9_debug(P9_DEBUG_VFS, "name %pD\n", file);
 	fid = file->private_data;
 
-	buflen = fid->clnt->msize - P9_IOHDRSZ;
+	/* p9_client_read() loops issuing msize-limited requests until the
+	 * buffer is full, so sizing it for several messages streams a
+	 * batch of replies into the dcache per refill.
+	 */
+	buflen = (fid->clnt->msize - P9_IOHDRSZ) * P9_RDIR_BATCH;
 
 	rdir = v9fs_alloc_rdir_buf(file, buflen);
 	if (!rdir)
@@ -150,14 +186,15 @@ static int v9fs_dir_readdir_dotl(struct file *file, struct dir_context *ctx)
 {
 	int err = 0;
 	struct p9_fid *fid;
-	int buflen;
+	int chunk, buflen;
 	struct p9_rdir *rdir;
 	struct p9_dirent curdirent;
 
 	p9_debug(P9_DEBUG_VFS, "name %pD\n", file);
 	fid = file->private_data;
 
-	buflen = fid->clnt->msize - P9_READDIRHDRSZ;
+	chunk = fid->clnt->msize - P9_READDIRHDRSZ;
+	buflen = chunk * P9_RDIR_BATCH;
 
 	rdir = v9fs_alloc_rdir_buf(file, buflen);
 	if (!rdir)
@@ -165,13 +202,31 @@ static int v9fs_dir_readdir_dotl(struct file *file, struct dir_context *ctx)
 
 	while (1) {
 		if (rdir->tail == rdir->head) {
-			err = p9_client_readdir(fid, rdir->buf, buflen,
-						ctx->pos);
-			if (err <= 0)
-				return err;
-
-			rdir->head = 0;
-			rdir->tail = err;
+			u64 off = ctx->pos;
+
+			rdir->head = rdir->tail = 0;
+			/* Stream up to P9_RDIR_BATCH messages into the
+			 * buffer per refill, chaining each request off the
+			 * tail entry of the previous reply.
+			 */
+			while (rdir->tail + chunk <= buflen) {
+				err = p9_client_readdir(fid,
+							rdir->buf + rdir->tail,
+							chunk, off);
+				if (err < 0)
+					return err;
+				if (err == 0)
+					break;
+
+				rdir->tail += err;
+				err = v9fs_rdir_last_off(fid,
+						rdir->buf + rdir->tail - err,
+						err, &off);
+				if (err < 0)
+					return -EIO;
+			}
+			if (rdir->tail == 0)
+				return 0;
 		}
 
 		while (rdir->head < rdir->tail) {
@@ -87,6 +87,8 @@ struct connection {
 	struct list_head writequeue;  /* List of outgoing writequeue_entries */
 	spinlock_t writequeue_lock;
 	atomic_t writequeue_cnt;
+	int cork; /* hold off send work for batching, under writequeue_lock */
+	bool delayed_send; /* send work held back while corked */
 	int retries;
 #define MAX_CONNECT_RETRIES 3
 	struct hlist_node list;
@@ -257,6 +259,8 @@ static int dlm_con_init(struct connection *con, int nodeid)
 	INIT_LIST_HEAD(&con->writequeue);
 	spin_lock_init(&con->writequeue_lock);
 	atomic_set(&con->writequeue_cnt, 0);
+	con->cork = 0;
+	con->delayed_send = false;
 	INIT_WORK(&con->swork, process_send_sockets);
 	INIT_WORK(&con->rwork, process_recv_sockets);
 	init_waitqueue_head(&con->shutdown_wait);
@@ -1348,6 +1352,11 @@ static void _dlm_lowcomms_commit_msg(struct dlm_msg *msg)
 		goto out;
 
 	e->len = DLM_WQ_LENGTH_BYTES(e);
+
+	if (con->cork) {
+		con->delayed_send = true;
+		goto out;
+	}
 	spin_unlock(&con->writequeue_lock);
 
 	queue_work(send_workqueue, &con->swork);
@@ -1376,6 +1385,53 @@ void dlm_lowcomms_put_msg(struct dlm_msg *msg)
 	kref_put(&msg->ref, dlm_msg_release);
 }
 
+static void con_cork(struct connection *con)
+{
+	spin_lock(&con->writequeue_lock);
+	con->cork++;
+	spin_unlock(&con->writequeue_lock);
+}
+
+static void con_uncork(struct connection *con)
+{
+	bool kick = false;
+
+	spin_lock(&con->writequeue_lock);
+	/* connections created while corked start out at zero */
+	if (con->cork > 0 && !--con->cork && con->delayed_send) {
+		con->delayed_send = false;
+		kick = true;
+	}
+	spin_unlock(&con->writequeue_lock);
+
+	if (kick)
+		queue_work(send_workqueue, &con->swork);
+}
+
+/* Hold off kicking the send workers until dlm_lowcomms_uncork(), so that
+ * a burst of messages committed in between is packed into as few wire
+ * messages per node as possible instead of being sent one by one.  The
+ * messages are still appended to the writequeues as usual; only the
+ * send work is delayed.  Corks nest and must be balanced by uncorks.
+ */
+void dlm_lowcomms_cork(void)
+{
+	int idx;
+
+	idx = srcu_read_lock(&connections_srcu);
+	foreach_conn(con_cork);
+	srcu_read_unlock(&connections_srcu, idx);
+}
+
+void dlm_lowcomms_uncork(void)
+{
+	int idx;
+
+	idx = srcu_read_lock(&connections_srcu);
+	foreach_conn(con_uncork);
+	srcu_read_unlock(&connections_srcu, idx);
+}
+
 /* does not held connections_srcu, usage workqueue only */
 int dlm_lowcomms_resend_msg(struct dlm_msg *msg)
 {
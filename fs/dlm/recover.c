@@ -526,16 +526,18 @@ int dlm_recover_masters(struct dlm_ls *ls)
 	unsigned int total = 0;
 	unsigned int count = 0;
 	int nodir = dlm_no_directory(ls);
-	int error;
+	int error = 0;
 
 	log_rinfo(ls, "dlm_recover_masters");
 
+	/* pack the burst of lookup messages into few wire messages */
+	dlm_lowcomms_cork();
+
 	down_read(&ls->ls_root_sem);
 	list_for_each_entry(r, &ls->ls_root_list, res_root_list) {
 		if (dlm_recovery_stopped(ls)) {
-			up_read(&ls->ls_root_sem);
 			error = -EINTR;
-			goto out;
+			break;
 		}
 
 		lock_rsb(r);
@@ -547,17 +549,19 @@ int dlm_recover_masters(struct dlm_ls *ls)
 		cond_resched();
 		total++;
 
-		if (error) {
-			up_read(&ls->ls_root_sem);
-			goto out;
-		}
+		if (error)
+			break;
 	}
 	up_read(&ls->ls_root_sem);
 
-	log_rinfo(ls, "dlm_recover_masters %u of %u", count, total);
+	dlm_lowcomms_uncork();
+
+	if (!error) {
+		log_rinfo(ls, "dlm_recover_masters %u of %u", count, total);
+
+		error = dlm_wait_function(ls, &recover_idr_empty);
+	}
 
-	error = dlm_wait_function(ls, &recover_idr_empty);
- out:
 	if (error)
 		recover_idr_clear(ls);
 	return error;
@@ -659,7 +663,10 @@ static int recover_locks(struct dlm_rsb *r)
 int dlm_recover_locks(struct dlm_ls *ls)
 {
 	struct dlm_rsb *r;
-	int error, count = 0;
+	int error = 0, count = 0;
+
+	/* pack the burst of lock messages into few wire messages */
+	dlm_lowcomms_cork();
 
 	down_read(&ls->ls_root_sem);
 	list_for_each_entry(r, &ls->ls_root_list, res_root_list) {
@@ -673,24 +680,25 @@ int dlm_recover_locks(struct dlm_ls *ls)
 
 		if (dlm_recovery_stopped(ls)) {
 			error = -EINTR;
-			up_read(&ls->ls_root_sem);
-			goto out;
+			break;
 		}
 
 		error = recover_locks(r);
-		if (error) {
-			up_read(&ls->ls_root_sem);
-			goto out;
-		}
+		if (error)
+			break;
 
 		count += r->res_recover_locks_count;
 	}
 	up_read(&ls->ls_root_sem);
 
-	log_rinfo(ls, "dlm_recover_locks %d out", count);
+	dlm_lowcomms_uncork();
+
+	if (!error) {
+		log_rinfo(ls, "dlm_recover_locks %d out", count);
+
+		error = dlm_wait_function(ls, &recover_list_empty);
+	}
 
-	error = dlm_wait_function(ls, &recover_list_empty);
- out:
 	if (error)
 		recover_list_clear(ls);
 	return error;
@@ -6,6 +6,9 @@
 #include <linux/fscache.h>
 #include "internal.h"
 
+/* mount-time readahead window over the index metadata (in pages) */
+#define EROFS_FSCACHE_META_RA_PAGES	(SZ_256K / PAGE_SIZE)
+
 static DEFINE_MUTEX(erofs_domain_list_lock);
 static DEFINE_MUTEX(erofs_domain_cookies_lock);
 static LIST_HEAD(erofs_domain_list);
@@ -244,6 +247,39 @@ out:
 	return ret;
 }
 
+static void erofs_fscache_meta_readahead(struct readahead_control *rac)
+{
+	struct super_block *sb = rac->mapping->host->i_sb;
+	struct netfs_io_request *rreq;
+	struct erofs_map_dev mdev = {
+		.m_deviceid = 0,
+		.m_pa = readahead_pos(rac),
+	};
+	struct folio *folio;
+
+	if (!readahead_count(rac))
+		return;
+
+	/* the meta address space maps the primary blob linearly */
+	if (erofs_map_dev(sb, &mdev))
+		goto err;
+
+	rreq = erofs_fscache_alloc_request(rac->mapping, readahead_pos(rac),
+					   readahead_length(rac));
+	if (IS_ERR(rreq))
+		goto err;
+
+	/* the request takes over unlocking of the folios in the range */
+	while (readahead_folio(rac))
+		;
+	erofs_fscache_read_folios_async(mdev.m_fscache->cookie, rreq,
+					mdev.m_pa);
+	return;
+err:
+	while ((folio = readahead_folio(rac)))
+		folio_unlock(folio);
+}
+
 /*
  * Read into page cache in the range described by (@pos, @len).
  *
@@ -380,6 +416,7 @@ static void erofs_fscache_readahead(struct readahead_control *rac)
 
 static const struct address_space_operations erofs_fscache_meta_aops = {
 	.read_folio = erofs_fscache_meta_read_folio,
+	.readahead = erofs_fscache_meta_readahead,
 };
 
 const struct address_space_operations erofs_fscache_access_aops = {
@@ -684,6 +721,21 @@ int erofs_fscache_register_fs(struct super_block *sb)
 		return PTR_ERR(fscache);
 
 	sbi->s_fscache = fscache;
+
+	/*
+	 * The superblock, inode table and index metadata all sit at the
+	 * front of the primary blob.  Pull that window into the (domain
+	 * wide) meta page cache in one request now, so that the flurry
+	 * of single-folio reads issued while walking the image on first
+	 * access hits the page cache instead of the backend.
+	 */
+	if (fscache->inode) {
+		struct file_ra_state ra = {};
+		DEFINE_READAHEAD(ractl, NULL, &ra,
+				 fscache->inode->i_mapping, 0);
+
+		page_cache_ra_unbounded(&ractl, EROFS_FSCACHE_META_RA_PAGES, 0);
+	}
 	return 0;
 }
 
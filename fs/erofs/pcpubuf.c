@@ -61,17 +61,22 @@ int erofs_pcpubuf_growsize(unsigned int nrpages)
 
 	for_each_possible_cpu(cpu) {
 		struct erofs_pcpubuf *pcb = &per_cpu(erofs_pcb, cpu);
+		int nid = cpu_to_node(cpu);
 		struct page **pages, **oldpages;
 		void *ptr, *old_ptr;
 
-		pages = kmalloc_array(nrpages, sizeof(*pages), GFP_KERNEL);
+		pages = kmalloc_array_node(nrpages, sizeof(*pages),
+					   GFP_KERNEL, nid);
 		if (!pages) {
 			ret = -ENOMEM;
 			break;
 		}
 
+		/* keep each CPU's scratch pages on its own node: the buffer
+		 * is only ever written by decompression running on that CPU
+		 */
 		for (i = 0; i < nrpages; ++i) {
-			pages[i] = erofs_allocpage(&pagepool, GFP_KERNEL);
+			pages[i] = alloc_pages_node(nid, GFP_KERNEL, 0);
 			if (!pages[i]) {
 				ret = -ENOMEM;
 				oldpages = pages;
@@ -35,6 +35,28 @@ static int exfat_mirror_bh(struct super_block *sb, sector_t sec,
 	return err;
 }
 
+#define EXFAT_FAT_RA_SIZE	(16*1024)
+static void exfat_fat_readahead(struct super_block *sb, sector_t sec)
+{
+	struct exfat_sb_info *sbi = EXFAT_SB(sb);
+	struct buffer_head *bh;
+	unsigned int ra_count = EXFAT_FAT_RA_SIZE >> sb->s_blocksize_bits;
+	sector_t fat_end = sbi->FAT1_start_sector + sbi->num_FAT_sectors;
+	unsigned int i;
+
+	bh = sb_find_get_block(sb, sec);
+	if (!bh || !buffer_uptodate(bh)) {
+		/*
+		 * Chain walks read the FAT a few bytes at a time; pull in
+		 * the following FAT sectors as well so that a sequential
+		 * walk only waits for the device once per window.
+		 */
+		for (i = 0; i < ra_count && sec + i < fat_end; i++)
+			sb_breadahead(sb, sec + i);
+	}
+	brelse(bh);
+}
+
 static int __exfat_ent_get(struct super_block *sb, unsigned int loc,
 		unsigned int *content)
 {
@@ -45,6 +67,8 @@ static int __exfat_ent_get(struct super_block *sb, unsigned int loc,
 	sec = FAT_ENT_OFFSET_SECTOR(sb, loc);
 	off = FAT_ENT_OFFSET_BYTE_IN_SECTOR(sb, loc);
 
+	exfat_fat_readahead(sb, sec);
+
 	bh = sb_bread(sb, sec);
 	if (!bh)
 		return -EIO;
@@ -748,6 +748,7 @@ extern int ext2_getattr (struct user_namespace *, const struct path *,
 extern void ext2_set_inode_flags(struct inode *inode);
 extern int ext2_fiemap(struct inode *inode, struct fiemap_extent_info *fieinfo,
 		       u64 start, u64 len);
+extern void ext2_write_failed(struct address_space *mapping, loff_t to);
 
 /* ioctl.c */
 extern int ext2_fileattr_get(struct dentry *dentry, struct fileattr *fa);
@@ -20,6 +20,7 @@
 #include <linux/pipe_fs_i.h>
 #include <linux/swap.h>
 #include <linux/splice.h>
+#include <linux/io_uring.h>
 #include <linux/sched.h>
 
 MODULE_ALIAS_MISCDEV(FUSE_MINOR);
@@ -1198,7 +1199,7 @@ __releases(fiq->lock)
  * fuse_request_end().  Otherwise add it to the processing list, and set
  * the 'sent' flag.
  */
-static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
+static ssize_t fuse_dev_do_read(struct fuse_dev *fud, bool nonblock,
 				struct fuse_copy_state *cs, size_t nbytes)
 {
 	ssize_t err;
@@ -1235,7 +1236,7 @@ static ssize_t fuse_dev_do_read(struct fuse_dev *fud, struct file *file,
 			break;
 		spin_unlock(&fiq->lock);
 
-		if (file->f_flags & O_NONBLOCK)
+		if (nonblock)
 			return -EAGAIN;
 		err = wait_event_interruptible_exclusive(fiq->waitq,
 				!fiq->connected || request_pending(fiq));
@@ -1361,7 +1362,8 @@ static ssize_t fuse_dev_read(struct kiocb *iocb, struct iov_iter *to)
 
 	fuse_copy_init(&cs, 1, to);
 
-	return fuse_dev_do_read(fud, file, &cs, iov_iter_count(to));
+	return fuse_dev_do_read(fud, file->f_flags & O_NONBLOCK, &cs,
+				 iov_iter_count(to));
 }
 
 static ssize_t fuse_dev_splice_read(struct file *in, loff_t *ppos,
@@ -1385,7 +1387,7 @@ static ssize_t fuse_dev_splice_read(struct file *in, loff_t *ppos,
 	fuse_copy_init(&cs, 1, NULL);
 	cs.pipebufs = bufs;
 	cs.pipe = pipe;
-	ret = fuse_dev_do_read(fud, in, &cs, len);
+	ret = fuse_dev_do_read(fud, in->f_flags & O_NONBLOCK, &cs, len);
 	if (ret < 0)
 		goto out;
 
@@ -2248,6 +2250,71 @@ static int fuse_device_clone(struct fuse_conn *fc, struct file *new)
 	return 0;
 }
 
+/* The 16 byte SQE command payload of a /dev/fuse uring command; the layout
+ * and the command codes below mirror the uapi values, which this tree does
+ * not carry.  A READ command completes with one request copied into the
+ * given buffer, a WRITE command feeds one reply (or notification) back,
+ * both with exactly read(2)/write(2) semantics.  Queueing a batch of READ
+ * commands lets the daemon harvest requests from the completion ring
+ * without issuing a syscall per operation.
+ */
+struct fuse_uring_cmd_req {
+	__u64 buf;
+	__u32 len;
+	__u32 flags;
+};
+
+#ifndef FUSE_DEV_IOC_URING_READ
+#define FUSE_DEV_IOC_URING_READ \
+	_IOW(FUSE_DEV_IOC_MAGIC, 1, struct fuse_uring_cmd_req)
+#define FUSE_DEV_IOC_URING_WRITE \
+	_IOR(FUSE_DEV_IOC_MAGIC, 2, struct fuse_uring_cmd_req)
+#endif
+
+static int fuse_dev_uring_cmd(struct io_uring_cmd *ioucmd,
+			      unsigned int issue_flags)
+{
+	const struct fuse_uring_cmd_req *ucmd = ioucmd->cmd;
+	struct fuse_dev *fud = fuse_get_dev(ioucmd->file);
+	struct fuse_copy_state cs;
+	struct iov_iter iter;
+	struct iovec iov;
+	ssize_t ret;
+
+	if (!fud)
+		return -EPERM;
+	if (ucmd->flags)
+		return -EINVAL;
+
+	switch (ioucmd->cmd_op) {
+	case FUSE_DEV_IOC_URING_READ:
+		ret = import_single_range(READ, u64_to_user_ptr(ucmd->buf),
+					  ucmd->len, &iov, &iter);
+		if (ret)
+			return ret;
+
+		fuse_copy_init(&cs, 1, &iter);
+		/* on -EAGAIN the core reissues from a worker that may block */
+		ret = fuse_dev_do_read(fud, issue_flags & IO_URING_F_NONBLOCK,
+				       &cs, ucmd->len);
+		break;
+	case FUSE_DEV_IOC_URING_WRITE:
+		ret = import_single_range(WRITE, u64_to_user_ptr(ucmd->buf),
+					  ucmd->len, &iov, &iter);
+		if (ret)
+			return ret;
+
+		fuse_copy_init(&cs, 0, &iter);
+		ret = fuse_dev_do_write(fud, &cs, ucmd->len);
+		break;
+	default:
+		ret = -ENOTTY;
+		break;
+	}
+
+	return ret;
+}
+
 static long fuse_dev_ioctl(struct file *file, unsigned int cmd,
 			   unsigned long arg)
 {
@@ -2300,6 +2367,7 @@ const struct file_operations fuse_dev_operations = {
 	.fasync		= fuse_dev_fasync,
 	.unlocked_ioctl = fuse_dev_ioctl,
 	.compat_ioctl   = compat_ptr_ioctl,
+	.uring_cmd	= fuse_dev_uring_cmd,
 };
 EXPORT_SYMBOL_GPL(fuse_dev_operations);
 
@@ -387,6 +387,34 @@ static loff_t iomap_readahead_iter(const struct iomap_iter *iter,
 	return done;
 }
 
+/*
+ * Expand the readahead window to the end of the extent we just mapped, so
+ * that a physically contiguous range is submitted as one batch instead of
+ * being chopped at the window boundary the VM handed us.  The expansion is
+ * bounded by one extra ra_pages window and by i_size; readahead_expand()
+ * only adds folios it can allocate and that are not already cached, so the
+ * achieved growth may be smaller than requested.  Returns the number of
+ * bytes actually added to the window.
+ */
+static size_t iomap_readahead_expand(struct readahead_control *rac,
+		const struct iomap_iter *iter)
+{
+	loff_t old_end = readahead_pos(rac) + readahead_length(rac);
+	loff_t new_end = iter->iomap.offset + iter->iomap.length;
+
+	if (!rac->ra)
+		return 0;
+	new_end = min(new_end,
+		      old_end + ((loff_t)rac->ra->ra_pages << PAGE_SHIFT));
+	new_end = min(new_end, i_size_read(iter->inode));
+	if (new_end <= old_end)
+		return 0;
+
+	readahead_expand(rac, readahead_pos(rac),
+			 new_end - readahead_pos(rac));
+	return readahead_pos(rac) + readahead_length(rac) - old_end;
+}
+
 /**
  * iomap_readahead - Attempt to read pages from a file.
  * @rac: Describes the pages to be read.
@@ -415,8 +443,11 @@ void iomap_readahead(struct readahead_control *rac, const struct iomap_ops *ops)
 
 	trace_iomap_readahead(rac->mapping->host, readahead_count(rac));
 
-	while (iomap_iter(&iter, ops) > 0)
+	while (iomap_iter(&iter, ops) > 0) {
+		if (iter.iomap.type == IOMAP_MAPPED)
+			iter.len += iomap_readahead_expand(rac, &iter);
 		iter.processed = iomap_readahead_iter(&iter, &ctx);
+	}
 
 	if (ctx.bio)
 		submit_bio(ctx.bio);
@@ -1420,8 +1420,15 @@ static journal_t *journal_init_common(struct block_device *bdev,
 	if (percpu_counter_init(&journal->j_checkpoint_jh_count, 0, GFP_KERNEL))
 		goto err_cleanup;
 
+	journal->j_credit_cache = alloc_percpu(struct jbd2_credit_cache);
+	if (!journal->j_credit_cache) {
+		percpu_counter_destroy(&journal->j_checkpoint_jh_count);
+		goto err_cleanup;
+	}
+
 	if (register_shrinker(&journal->j_shrinker, "jbd2-journal:(%u:%u)",
 			      MAJOR(bdev->bd_dev), MINOR(bdev->bd_dev))) {
+		free_percpu(journal->j_credit_cache);
 		percpu_counter_destroy(&journal->j_checkpoint_jh_count);
 		goto err_cleanup;
 	}
@@ -1539,6 +1546,22 @@ static void journal_fail_superblock(journal_t *journal)
  * subsequent use.
  */
 
+/*
+ * Size the per-CPU credit cache batch so that all CPUs together cannot
+ * inflate the running transaction's credit accounting by more than a quarter
+ * of the maximum transaction size (each cache holds at most two batches).
+ * Caching is disabled on journals small enough that the batch would be too
+ * small to be worth the bookkeeping.
+ */
+static void jbd2_journal_set_credit_batch(journal_t *journal)
+{
+	int batch = journal->j_max_transaction_buffers /
+		    (8 * (int)num_possible_cpus());
+
+	batch = min(batch, 64);
+	journal->j_credit_batch = batch >= 8 ? batch : 0;
+}
+
 static int journal_reset(journal_t *journal)
 {
 	journal_superblock_t *sb = journal->j_superblock;
@@ -1565,6 +1588,7 @@ static int journal_reset(journal_t *journal)
 	journal->j_commit_request = journal->j_commit_sequence;
 
 	journal->j_max_transaction_buffers = jbd2_journal_get_max_txn_bufs(journal);
+	jbd2_journal_set_credit_batch(journal);
 
 	/*
 	 * Now that journal recovery is done, turn fast commits off here. This
@@ -2192,6 +2216,7 @@ int jbd2_journal_destroy(journal_t *journal)
 		percpu_counter_destroy(&journal->j_checkpoint_jh_count);
 		unregister_shrinker(&journal->j_shrinker);
 	}
+	free_percpu(journal->j_credit_cache);
 	if (journal->j_proc_entry)
 		jbd2_stats_proc_exit(journal);
 	iput(journal->j_inode);
@@ -2299,6 +2324,7 @@ jbd2_journal_initialize_fast_commit(journal_t *journal)
 	journal->j_free = journal->j_last - journal->j_first;
 	journal->j_max_transaction_buffers =
 		jbd2_journal_get_max_txn_bufs(journal);
+	jbd2_journal_set_credit_batch(journal);
 
 	return 0;
 }
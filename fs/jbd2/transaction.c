@@ -213,6 +213,69 @@ static void sub_reserved_credits(journal_t *journal, int blocks)
 	wake_up(&journal->j_wait_reserved);
 }
 
+/*
+ * Refill this CPU's credit cache from the running transaction.  Called with
+ * j_state_lock held for reading, right after the caller's own credits have
+ * been accepted, so the transaction is known to be T_RUNNING and the log
+ * space checks for a full-sized transaction have just passed.  The batch is
+ * added to t_outstanding_credits up front; consuming cached credits later is
+ * then pure per-CPU arithmetic.  Credits still cached from an earlier
+ * transaction are dropped: they stay counted against that transaction, which
+ * at worst makes it look slightly fuller than it really was.
+ */
+static void jbd2_credit_cache_refill(journal_t *journal, transaction_t *t)
+{
+	struct jbd2_credit_cache *cc;
+	int batch = journal->j_credit_batch;
+
+	if (!batch)
+		return;
+	cc = this_cpu_ptr(journal->j_credit_cache);
+	if (cc->tid == t->t_tid && cc->credits >= batch)
+		return;
+
+	if (atomic_add_return(batch, &t->t_outstanding_credits) >
+	    journal->j_max_transaction_buffers) {
+		atomic_sub(batch, &t->t_outstanding_credits);
+		return;
+	}
+	if (cc->tid == t->t_tid) {
+		cc->credits += batch;
+	} else {
+		cc->tid = t->t_tid;
+		cc->credits = batch;
+	}
+}
+
+/*
+ * Return a handle's unused credits.  If this CPU's cache is tracking the
+ * handle's transaction and isn't overfull, park them there for the next
+ * handle started on this CPU; otherwise hand them back to the shared
+ * counter.  No locks are held here, but the transaction is still pinned by
+ * t_updates and its tid never changes; if it is already committing, the
+ * parked credits can never be consumed and are dropped on the next refill.
+ */
+static void jbd2_credit_cache_put(journal_t *journal, transaction_t *t,
+				  int credits)
+{
+	struct jbd2_credit_cache *cc;
+	int batch = journal->j_credit_batch;
+	bool cached = false;
+
+	if (!credits)
+		return;
+	if (batch) {
+		cc = get_cpu_ptr(journal->j_credit_cache);
+		if (cc->tid == t->t_tid && cc->credits + credits <= 2 * batch) {
+			cc->credits += credits;
+			cached = true;
+		}
+		put_cpu_ptr(journal->j_credit_cache);
+	}
+	if (!cached)
+		atomic_sub(credits, &t->t_outstanding_credits);
+}
+
 /*
  * Wait until we can add credits for handle to the running transaction.  Called
  * with j_state_lock held for reading. Returns 0 if handle joined the running
@@ -243,6 +306,23 @@ __must_hold(&journal->j_state_lock)
 		return 1;
 	}
 
+	/*
+	 * Try the per-CPU credit cache first.  We hold j_state_lock for
+	 * reading and the transaction is T_RUNNING, so it cannot be locked
+	 * down under us.  Cached credits for this tid are already included
+	 * in t_outstanding_credits and went through the checks below when
+	 * the batch was drawn, so consuming them needs no shared state.
+	 */
+	if (!rsv_blocks && journal->j_credit_batch) {
+		struct jbd2_credit_cache *cc =
+			this_cpu_ptr(journal->j_credit_cache);
+
+		if (cc->tid == t->t_tid && cc->credits >= total) {
+			cc->credits -= total;
+			return 0;
+		}
+	}
+
 	/*
 	 * If there is not enough space left in the log to write all
 	 * potential buffers requested by this operation, we need to
@@ -302,8 +382,10 @@ __must_hold(&journal->j_state_lock)
 	}
 
 	/* No reservation? We are done... */
-	if (!rsv_blocks)
+	if (!rsv_blocks) {
+		jbd2_credit_cache_refill(journal, t);
 		return 0;
+	}
 
 	needed = atomic_add_return(rsv_blocks, &journal->j_reserved_credits);
 	/* We allow at most half of a transaction to be reserved */
@@ -742,8 +824,7 @@ static void stop_this_handle(handle_t *handle)
 			DIV_ROUND_UP(t_revokes - revokes, rr_per_blk);
 		handle->h_total_credits -= revoke_descriptors;
 	}
-	atomic_sub(handle->h_total_credits,
-		   &transaction->t_outstanding_credits);
+	jbd2_credit_cache_put(journal, transaction, handle->h_total_credits);
 	if (handle->h_rsv_handle)
 		__jbd2_journal_unreserve_handle(handle->h_rsv_handle,
 						transaction);
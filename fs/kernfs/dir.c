@@ -1799,6 +1799,19 @@ static struct kernfs_node *kernfs_dir_next_pos(const void *ns,
 	return pos;
 }
 
+/* directory entry copied out under kernfs_rwsem and emitted without it */
+struct kernfs_dirent {
+	ino_t		ino;
+	unsigned int	hash;
+	unsigned short	namelen;
+	unsigned char	type;
+	char		name[];		/* NUL-terminated */
+};
+
+#define KERNFS_DIRENT_SIZE(namelen) \
+	ALIGN(offsetof(struct kernfs_dirent, name) + (namelen) + 1, \
+	      __alignof__(struct kernfs_dirent))
+
 static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
 {
 	struct dentry *dentry = file->f_path.dentry;
@@ -1806,16 +1819,108 @@ static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
 	struct kernfs_node *pos = file->private_data;
 	struct kernfs_root *root;
 	const void *ns = NULL;
+	char *buf;
 
 	if (!dir_emit_dots(file, ctx))
 		return 0;
 
+	buf = (void *)__get_free_page(GFP_KERNEL);
+
 	root = kernfs_root(parent);
 	down_read(&root->kernfs_rwsem);
 
 	if (kernfs_ns_enabled(parent))
 		ns = kernfs_info(dentry->d_sb)->ns;
 
+	if (!buf)
+		goto per_entry;
+
+	/*
+	 * Copy a pageful of entries out under the rwsem, then emit them with
+	 * the lock dropped, so that a large readdir takes and releases the
+	 * lock once per batch instead of once per entry and never shows the
+	 * names to userspace while a rename may be freeing them.
+	 */
+	pos = kernfs_dir_pos(ns, parent, ctx->pos, pos);
+	while (pos) {
+		unsigned int used = 0, off;
+		unsigned int next_hash = 0;
+
+		while (pos) {
+			struct kernfs_dirent *de = (void *)(buf + used);
+			size_t len = strlen(pos->name);
+			size_t size = KERNFS_DIRENT_SIZE(len);
+
+			if (size > PAGE_SIZE - used)
+				break;
+			de->ino		= kernfs_ino(pos);
+			de->hash	= pos->hash;
+			de->namelen	= len;
+			de->type	= dt_type(pos);
+			memcpy(de->name, pos->name, len + 1);
+			used += size;
+
+			do {
+				struct rb_node *node = rb_next(&pos->rb);
+
+				pos = node ? rb_to_kn(node) : NULL;
+			} while (pos && (!kernfs_active(pos) || pos->ns != ns));
+		}
+
+		if (!used) {
+			/* name too long to batch - emit this one directly */
+			const char *name = pos->name;
+			unsigned int type = dt_type(pos);
+			int len = strlen(name);
+			ino_t ino = kernfs_ino(pos);
+
+			ctx->pos = pos->hash;
+			file->private_data = pos;
+			kernfs_get(pos);
+
+			up_read(&root->kernfs_rwsem);
+			if (!dir_emit(ctx, name, len, ino, type)) {
+				free_page((unsigned long)buf);
+				return 0;
+			}
+			down_read(&root->kernfs_rwsem);
+			pos = kernfs_dir_next_pos(ns, parent, ctx->pos, pos);
+			continue;
+		}
+
+		/* pin the resume point before dropping the lock */
+		if (pos) {
+			kernfs_get(pos);
+			next_hash = pos->hash;
+		}
+		file->private_data = pos;
+		up_read(&root->kernfs_rwsem);
+
+		for (off = 0; off < used;) {
+			struct kernfs_dirent *de = (void *)(buf + off);
+
+			ctx->pos = de->hash;
+			if (!dir_emit(ctx, de->name, de->namelen, de->ino,
+				      de->type)) {
+				/* resume by hash search next time */
+				if (pos)
+					kernfs_put(pos);
+				file->private_data = NULL;
+				free_page((unsigned long)buf);
+				return 0;
+			}
+			off += KERNFS_DIRENT_SIZE(de->namelen);
+		}
+
+		down_read(&root->kernfs_rwsem);
+		if (pos) {
+			ctx->pos = next_hash;
+			pos = kernfs_dir_pos(ns, parent, ctx->pos, pos);
+		}
+	}
+	goto out;
+
+per_entry:
 	for (pos = kernfs_dir_pos(ns, parent, ctx->pos, pos);
 	     pos;
 	     pos = kernfs_dir_next_pos(ns, parent, ctx->pos, pos)) {
@@ -1833,9 +1938,11 @@ static int kernfs_fop_readdir(struct file *file, struct dir_context *ctx)
 			return 0;
 		down_read(&root->kernfs_rwsem);
 	}
+out:
 	up_read(&root->kernfs_rwsem);
 	file->private_data = NULL;
 	ctx->pos = INT_MAX;
+	free_page((unsigned long)buf);
 	return 0;
 }
 
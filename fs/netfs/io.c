@@ -12,6 +12,7 @@
 #include <linux/pagemap.h>
 #include <linux/slab.h>
 #include <linux/uio.h>
+#include <linux/blkdev.h>
 #include <linux/sched/mm.h>
 #include <linux/task_io_accounting_ops.h>
 #include "internal.h"
@@ -171,6 +172,7 @@ static void netfs_rreq_do_write_to_cache(struct netfs_io_request *rreq)
 	struct netfs_cache_resources *cres = &rreq->cache_resources;
 	struct netfs_io_subrequest *subreq, *next, *p;
 	struct iov_iter iter;
+	struct blk_plug plug;
 	int ret;
 
 	trace_netfs_rreq(rreq, netfs_rreq_trace_copy);
@@ -188,6 +190,7 @@ static void netfs_rreq_do_write_to_cache(struct netfs_io_request *rreq)
 		}
 	}
 
+	blk_start_plug(&plug);
 	list_for_each_entry(subreq, &rreq->subrequests, rreq_link) {
 		/* Amalgamate adjacent writes */
 		while (!list_is_last(&subreq->rreq_link, &rreq->subrequests)) {
@@ -218,6 +221,7 @@ static void netfs_rreq_do_write_to_cache(struct netfs_io_request *rreq)
 		cres->ops->write(cres, subreq->start, &iter,
 				 netfs_rreq_copy_terminated, subreq);
 	}
+	blk_finish_plug(&plug);
 
 	/* If we decrement nr_copy_ops to 0, the usage ref belongs to us. */
 	if (atomic_dec_and_test(&rreq->nr_copy_ops))
@@ -538,10 +542,61 @@ out:
 }
 
 /*
- * Slice off a piece of a read request and submit an I/O request for it.
+ * Issue the I/O operation for a previously prepared subrequest.
+ */
+static void netfs_rreq_issue_slice(struct netfs_io_request *rreq,
+				   struct netfs_io_subrequest *subreq)
+{
+	atomic_inc(&rreq->nr_outstanding);
+
+	trace_netfs_sreq(subreq, netfs_sreq_trace_submit);
+	switch (subreq->source) {
+	case NETFS_FILL_WITH_ZEROES:
+		netfs_fill_with_zeroes(rreq, subreq);
+		break;
+	case NETFS_DOWNLOAD_FROM_SERVER:
+		netfs_read_from_server(rreq, subreq);
+		break;
+	case NETFS_READ_FROM_CACHE:
+		netfs_read_from_cache(rreq, subreq, NETFS_READ_HOLE_IGNORE);
+		break;
+	default:
+		BUG();
+	}
+}
+
+/*
+ * See if a freshly prepared slice can be folded into the last one still
+ * awaiting submission.  Only cache reads and zero-fills are merged: one read
+ * from the backing file can span any number of cache granules, whereas
+ * server slices were clamped to the netfs's I/O limits and must stay within
+ * them.
+ */
+static bool netfs_rreq_merge_slice(struct netfs_io_subrequest *pending,
+				   struct netfs_io_subrequest *subreq)
+{
+	if (!pending ||
+	    pending->source != subreq->source ||
+	    pending->flags != subreq->flags ||
+	    pending->start + pending->len != subreq->start)
+		return false;
+	if (subreq->source != NETFS_READ_FROM_CACHE &&
+	    subreq->source != NETFS_FILL_WITH_ZEROES)
+		return false;
+
+	pending->len += subreq->len;
+	return true;
+}
+
+/*
+ * Slice off a piece of a read request and prepare an I/O request for it.  The
+ * prepared slice is held back in *@_pending until the next slice shows it
+ * cannot be extended any further, so that adjacent same-source pieces go out
+ * as a single operation.
  */
 static bool netfs_rreq_submit_slice(struct netfs_io_request *rreq,
-				    unsigned int *_debug_index)
+				    unsigned int *_debug_index,
+				    struct netfs_io_subrequest **_pending)
 {
 	struct netfs_io_subrequest *subreq;
 	enum netfs_io_source source;
@@ -569,25 +624,17 @@ static bool netfs_rreq_submit_slice(struct netfs_io_request *rreq,
 	if (source == NETFS_INVALID_READ)
 		goto subreq_failed;
 
-	atomic_inc(&rreq->nr_outstanding);
-
 	rreq->submitted += subreq->len;
 
-	trace_netfs_sreq(subreq, netfs_sreq_trace_submit);
-	switch (source) {
-	case NETFS_FILL_WITH_ZEROES:
-		netfs_fill_with_zeroes(rreq, subreq);
-		break;
-	case NETFS_DOWNLOAD_FROM_SERVER:
-		netfs_read_from_server(rreq, subreq);
-		break;
-	case NETFS_READ_FROM_CACHE:
-		netfs_read_from_cache(rreq, subreq, NETFS_READ_HOLE_IGNORE);
-		break;
-	default:
-		BUG();
+	if (netfs_rreq_merge_slice(*_pending, subreq)) {
+		list_del_init(&subreq->rreq_link);
+		netfs_put_subrequest(subreq, false, netfs_sreq_trace_put_merged);
+		return true;
 	}
 
+	if (*_pending)
+		netfs_rreq_issue_slice(rreq, *_pending);
+	*_pending = subreq;
 	return true;
 
 subreq_failed:
@@ -603,6 +650,8 @@ subreq_failed:
  */
 int netfs_begin_read(struct netfs_io_request *rreq, bool sync)
 {
+	struct netfs_io_subrequest *pending = NULL;
+	struct blk_plug plug;
 	unsigned int debug_index = 0;
 	int ret;
 
@@ -621,15 +670,21 @@ int netfs_begin_read(struct netfs_io_request *rreq, bool sync)
 		netfs_get_request(rreq, netfs_rreq_trace_get_hold);
 
 	/* Chop the read into slices according to what the cache and the netfs
-	 * want and submit each one.
+	 * want and submit each one.  Plug the block layer so that reads
+	 * against the cache file are released to the device as one batch.
 	 */
 	atomic_set(&rreq->nr_outstanding, 1);
+	blk_start_plug(&plug);
 	do {
-		if (!netfs_rreq_submit_slice(rreq, &debug_index))
+		if (!netfs_rreq_submit_slice(rreq, &debug_index, &pending))
 			break;
 
 	} while (rreq->submitted < rreq->len);
 
+	if (pending)
+		netfs_rreq_issue_slice(rreq, pending);
+	blk_finish_plug(&plug);
+
 	if (sync) {
 		/* Keep nr_outstanding incremented so that the ref always belongs to
 		 * us, and the service code isn't punted off to a random thread pool to
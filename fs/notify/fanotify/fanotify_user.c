@@ -206,47 +206,88 @@ static void fanotify_unhash_event(struct fsnotify_group *group,
 	hlist_del_init(&event->merge_list);
 }
 
+/* Limit batched dequeues to bound the notification_lock hold time */
+#define FANOTIFY_MAX_READ_BATCH 16
+
 /*
- * Get an fanotify notification event if one exists and is small
- * enough to fit in "count". Return an error pointer if the count
- * is not large enough. When permission event is dequeued, its state is
- * updated accordingly.
+ * Dequeue as many events as fit in "count" bytes, up to a fixed batch
+ * limit, under a single acquisition of the notification_lock.  Dequeued
+ * events are moved to "events" in queue order.  When permission events
+ * are dequeued, their state is updated accordingly.  Returns -EINVAL if
+ * the first queued event alone does not fit in "count".
  */
-static struct fanotify_event *get_one_event(struct fsnotify_group *group,
-					    size_t count)
+static int get_many_events(struct fsnotify_group *group, size_t count,
+			   struct list_head *events)
 {
 	size_t event_size;
-	struct fanotify_event *event = NULL;
+	struct fanotify_event *event;
 	struct fsnotify_event *fsn_event;
 	unsigned int info_mode = FAN_GROUP_FLAG(group, FANOTIFY_INFO_MODES);
+	int batched = 0;
+	int ret = 0;
 
 	pr_debug("%s: group=%p count=%zd\n", __func__, group, count);
 
 	spin_lock(&group->notification_lock);
-	fsn_event = fsnotify_peek_first_event(group);
-	if (!fsn_event)
-		goto out;
+	while (batched < FANOTIFY_MAX_READ_BATCH) {
+		fsn_event = fsnotify_peek_first_event(group);
+		if (!fsn_event)
+			break;
 
-	event = FANOTIFY_E(fsn_event);
-	event_size = fanotify_event_len(info_mode, event);
+		event = FANOTIFY_E(fsn_event);
+		event_size = fanotify_event_len(info_mode, event);
 
-	if (event_size > count) {
-		event = ERR_PTR(-EINVAL);
-		goto out;
+		if (event_size > count) {
+			if (!batched && list_empty(events))
+				ret = -EINVAL;
+			break;
+		}
+
+		/*
+		 * Held the notification_lock the whole time, so this is
+		 * the same event we peeked above.
+		 */
+		fsnotify_remove_first_event(group);
+		if (fanotify_is_perm_event(event->mask))
+			FANOTIFY_PERM(event)->state = FAN_EVENT_REPORTED;
+		if (fanotify_is_hashed_event(event->mask))
+			fanotify_unhash_event(group, event);
+
+		list_add_tail(&fsn_event->list, events);
+		count -= event_size;
+		batched++;
 	}
+	spin_unlock(&group->notification_lock);
+	return ret;
+}
 
-	/*
-	 * Held the notification_lock the whole time, so this is the
-	 * same event we peeked above.
-	 */
-	fsnotify_remove_first_event(group);
-	if (fanotify_is_perm_event(event->mask))
-		FANOTIFY_PERM(event)->state = FAN_EVENT_REPORTED;
-	if (fanotify_is_hashed_event(event->mask))
-		fanotify_unhash_event(group, event);
-out:
+/*
+ * Put events that were dequeued but could not be delivered back at the
+ * head of the notification queue, in their original order, so nothing
+ * is lost when copying out a batch fails part way through.
+ */
+static void requeue_events(struct fsnotify_group *group,
+			   struct list_head *events)
+{
+	struct fanotify_event *event;
+	struct fsnotify_event *fsn_event, *tmp;
+
+	if (list_empty(events))
+		return;
+
+	spin_lock(&group->notification_lock);
+	list_for_each_entry_safe_reverse(fsn_event, tmp, events, list) {
+		event = FANOTIFY_E(fsn_event);
+		list_move(&fsn_event->list, &group->notification_list);
+		group->q_len++;
+		if (fanotify_is_perm_event(event->mask))
+			FANOTIFY_PERM(event)->state = FAN_EVENT_INIT;
+		if (fanotify_is_hashed_event(event->mask))
+			hlist_add_head(&event->merge_list,
+				       &group->fanotify_data.merge_hash[
+					fanotify_event_hash_bucket(group, event)]);
+	}
 	spin_unlock(&group->notification_lock);
-	return event;
 }
 
 static int create_fd(struct fsnotify_group *group, const struct path *path,
@@ -745,8 +786,10 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 {
 	struct fsnotify_group *group;
 	struct fanotify_event *event;
+	struct fsnotify_event *fsn_event;
 	char __user *start;
 	int ret;
+	LIST_HEAD(events);
 	DEFINE_WAIT_FUNC(wait, woken_wake_function);
 
 	start = buf;
@@ -761,13 +804,11 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 		 * in case there are lots of available events.
 		 */
 		cond_resched();
-		event = get_one_event(group, count);
-		if (IS_ERR(event)) {
-			ret = PTR_ERR(event);
+		ret = get_many_events(group, count, &events);
+		if (ret < 0)
 			break;
-		}
 
-		if (!event) {
+		if (list_empty(&events)) {
 			ret = -EAGAIN;
 			if (file->f_flags & O_NONBLOCK)
 				break;
@@ -783,43 +824,56 @@ static ssize_t fanotify_read(struct file *file, char __user *buf,
 			continue;
 		}
 
-		ret = copy_event_to_user(group, event, buf, count);
-		if (unlikely(ret == -EOPENSTALE)) {
+		while (!list_empty(&events)) {
+			fsn_event = list_first_entry(&events,
+						     struct fsnotify_event, list);
+			event = FANOTIFY_E(fsn_event);
+			list_del_init(&fsn_event->list);
+
+			ret = copy_event_to_user(group, event, buf, count);
+			if (unlikely(ret == -EOPENSTALE)) {
+				/*
+				 * We cannot report events with stale fd so drop
+				 * it. Setting ret to 0 will continue the event
+				 * loop and do the right thing if there are no
+				 * more events to read (i.e. return bytes read,
+				 * -EAGAIN or wait).
+				 */
+				ret = 0;
+			}
+
 			/*
-			 * We cannot report events with stale fd so drop it.
-			 * Setting ret to 0 will continue the event loop and
-			 * do the right thing if there are no more events to
-			 * read (i.e. return bytes read, -EAGAIN or wait).
+			 * Permission events get queued to wait for response.
+			 * Other events can be destroyed now.
 			 */
-			ret = 0;
-		}
-
-		/*
-		 * Permission events get queued to wait for response.  Other
-		 * events can be destroyed now.
-		 */
-		if (!fanotify_is_perm_event(event->mask)) {
-			fsnotify_destroy_event(group, &event->fse);
-		} else {
-			if (ret <= 0) {
-				spin_lock(&group->notification_lock);
-				finish_permission_event(group,
-					FANOTIFY_PERM(event), FAN_DENY);
-				wake_up(&group->fanotify_data.access_waitq);
+			if (!fanotify_is_perm_event(event->mask)) {
+				fsnotify_destroy_event(group, &event->fse);
 			} else {
-				spin_lock(&group->notification_lock);
-				list_add_tail(&event->fse.list,
-					&group->fanotify_data.access_list);
-				spin_unlock(&group->notification_lock);
+				if (ret <= 0) {
+					spin_lock(&group->notification_lock);
+					finish_permission_event(group,
+						FANOTIFY_PERM(event), FAN_DENY);
+					wake_up(&group->fanotify_data.access_waitq);
+				} else {
+					spin_lock(&group->notification_lock);
+					list_add_tail(&event->fse.list,
+						&group->fanotify_data.access_list);
+					spin_unlock(&group->notification_lock);
+				}
 			}
+			if (ret < 0)
+				break;
+			buf += ret;
+			count -= ret;
 		}
 		if (ret < 0)
 			break;
-		buf += ret;
-		count -= ret;
 	}
 	remove_wait_queue(&group->notification_waitq, &wait);
 
+	/* Put back any events we dequeued but did not deliver */
+	requeue_events(group, &events);
+
 	if (start != buf && ret != -EFAULT)
 		ret = buf - start;
 	return ret;
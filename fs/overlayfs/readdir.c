@@ -225,31 +225,42 @@ void ovl_cache_free(struct list_head *list)
 	INIT_LIST_HEAD(list);
 }
 
-void ovl_dir_cache_free(struct inode *inode)
+static void ovl_cache_unref(struct ovl_dir_cache *cache)
 {
-	struct ovl_dir_cache *cache = ovl_dir_cache(inode);
-
-	if (cache) {
+	WARN_ON(cache->refcount <= 0);
+	cache->refcount--;
+	if (!cache->refcount) {
 		ovl_cache_free(&cache->entries);
 		kfree(cache);
 	}
 }
 
-static void ovl_cache_put(struct ovl_dir_file *od, struct dentry *dentry)
+void ovl_dir_cache_free(struct inode *inode)
 {
-	struct ovl_dir_cache *cache = od->cache;
-
-	WARN_ON(cache->refcount <= 0);
-	cache->refcount--;
-	if (!cache->refcount) {
-		if (ovl_dir_cache(d_inode(dentry)) == cache)
-			ovl_set_dir_cache(d_inode(dentry), NULL);
+	struct ovl_dir_cache *cache = ovl_dir_cache(inode);
 
-		ovl_cache_free(&cache->entries);
-		kfree(cache);
+	if (cache) {
+		ovl_set_dir_cache(inode, NULL);
+		/* The impure cache is not refcounted - free it outright */
+		if (!cache->refcount) {
+			ovl_cache_free(&cache->entries);
+			kfree(cache);
+		} else {
+			ovl_cache_unref(cache);
+		}
 	}
 }
 
+static void ovl_cache_put(struct ovl_dir_file *od)
+{
+	/*
+	 * The inode holds its own reference on the merge cache, so the
+	 * cache survives the last fd dropping it and can only go away
+	 * once version invalidation or inode eviction has detached it.
+	 */
+	ovl_cache_unref(od->cache);
+}
+
 static bool ovl_fill_merge(struct dir_context *ctx, const char *name,
 			  int namelen, loff_t offset, u64 ino,
 			  unsigned int d_type)
@@ -327,7 +338,7 @@ static void ovl_dir_reset(struct file *file)
 	bool is_real;
 
 	if (cache && ovl_dentry_version_get(dentry) != cache->version) {
-		ovl_cache_put(od, dentry);
+		ovl_cache_put(od);
 		od->cache = NULL;
 		od->cursor = NULL;
 	}
@@ -401,13 +412,18 @@ static struct ovl_dir_cache *ovl_cache_get(struct dentry *dentry)
 		cache->refcount++;
 		return cache;
 	}
-	ovl_set_dir_cache(d_inode(dentry), NULL);
+	if (cache) {
+		/* Stale - detach and drop the inode's reference */
+		ovl_set_dir_cache(d_inode(dentry), NULL);
+		ovl_cache_unref(cache);
+	}
 
 	cache = kzalloc(sizeof(struct ovl_dir_cache), GFP_KERNEL);
 	if (!cache)
 		return ERR_PTR(-ENOMEM);
 
-	cache->refcount = 1;
+	/* One reference for our caller and one for the inode */
+	cache->refcount = 2;
 	INIT_LIST_HEAD(&cache->entries);
 	cache->root = RB_ROOT;
 
@@ -605,7 +621,6 @@ static struct ovl_dir_cache *ovl_cache_get_impure(const struct path *path)
 
 	/* Impure cache is not refcounted, free it here */
 	ovl_dir_cache_free(d_inode(dentry));
-	ovl_set_dir_cache(d_inode(dentry), NULL);
 
 	cache = kzalloc(sizeof(struct ovl_dir_cache), GFP_KERNEL);
 	if (!cache)
@@ -913,7 +928,7 @@ static int ovl_dir_release(struct inode *inode, struct file *file)
 
 	if (od->cache) {
 		inode_lock(inode);
-		ovl_cache_put(od, file->f_path.dentry);
+		ovl_cache_put(od);
 		inode_unlock(inode);
 	}
 	fput(od->realfile);
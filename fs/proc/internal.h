@@ -285,11 +285,14 @@ extern void proc_self_init(void);
  * task_[no]mmu.c
  */
 struct mem_size_stats;
+struct smaps_rollup_cache;
+
 struct proc_maps_private {
 	struct inode *inode;
 	struct task_struct *task;
 	struct mm_struct *mm;
 	struct vma_iterator iter;
+	struct smaps_rollup_cache *rollup_cache;
 #ifdef CONFIG_NUMA
 	struct mempolicy *task_mempolicy;
 #endif
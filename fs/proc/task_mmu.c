@@ -414,6 +414,71 @@ struct mem_size_stats {
 	u64 swap_pss;
 };
 
+/*
+ * Cached result of a previous smaps_rollup walk on the same file
+ * description.  Serving from the cache is allowed only while the mm's cheap
+ * counters are unchanged and the walk is younger than the staleness bound:
+ * the counters catch any fault, unmap or m(un)lock in this mm without a
+ * page-table walk, while the time bound caps the drift of sharing-dependent
+ * values (Pss, Referenced) that other processes can change without touching
+ * this mm at all.
+ */
+struct smaps_rollup_cache {
+	struct mem_size_stats mss;
+	unsigned long gathered;		/* jiffies of the cached walk */
+	unsigned long rss;
+	unsigned long swapents;
+	unsigned long total_vm;
+	unsigned long locked_vm;
+#ifdef CONFIG_HUGETLB_PAGE
+	long hugetlb_usage;
+#endif
+	int map_count;
+	unsigned long vma_start;
+	unsigned long last_vma_end;
+	bool valid;
+};
+
+#define SMAPS_ROLLUP_CACHE_TIMEOUT	HZ
+
+static bool smaps_rollup_cache_usable(struct smaps_rollup_cache *cache,
+				      struct mm_struct *mm)
+{
+	if (!cache || !cache->valid ||
+	    time_after(jiffies, cache->gathered + SMAPS_ROLLUP_CACHE_TIMEOUT))
+		return false;
+#ifdef CONFIG_HUGETLB_PAGE
+	if (cache->hugetlb_usage != atomic_long_read(&mm->hugetlb_usage))
+		return false;
+#endif
+	return cache->rss == get_mm_rss(mm) &&
+	       cache->swapents == get_mm_counter(mm, MM_SWAPENTS) &&
+	       cache->total_vm == mm->total_vm &&
+	       cache->locked_vm == mm->locked_vm &&
+	       cache->map_count == mm->map_count;
+}
+
+static void smaps_rollup_cache_fill(struct smaps_rollup_cache *cache,
+				    struct mm_struct *mm,
+				    const struct mem_size_stats *mss,
+				    unsigned long vma_start,
+				    unsigned long last_vma_end)
+{
+	cache->mss = *mss;
+	cache->gathered = jiffies;
+	cache->rss = get_mm_rss(mm);
+	cache->swapents = get_mm_counter(mm, MM_SWAPENTS);
+	cache->total_vm = mm->total_vm;
+	cache->locked_vm = mm->locked_vm;
+#ifdef CONFIG_HUGETLB_PAGE
+	cache->hugetlb_usage = atomic_long_read(&mm->hugetlb_usage);
+#endif
+	cache->map_count = mm->map_count;
+	cache->vma_start = vma_start;
+	cache->last_vma_end = last_vma_end;
+	cache->valid = true;
+}
+
 static void smaps_page_accumulate(struct mem_size_stats *mss,
 		struct page *page, unsigned long size, unsigned long pss,
 		bool dirty, bool locked, bool private)
@@ -900,6 +965,14 @@ static int show_smaps_rollup(struct seq_file *m, void *v)
 		goto out_put_mm;
 
 	hold_task_mempolicy(priv);
+
+	if (smaps_rollup_cache_usable(priv->rollup_cache, mm)) {
+		mss = priv->rollup_cache->mss;
+		vma_start = priv->rollup_cache->vma_start;
+		last_vma_end = priv->rollup_cache->last_vma_end;
+		goto empty_set;
+	}
+
 	vma = mas_find(&mas, ULONG_MAX);
 
 	if (unlikely(!vma))
@@ -975,6 +1048,11 @@ static int show_smaps_rollup(struct seq_file *m, void *v)
 		/* Case 2 above */
 	} while ((vma = mas_find(&mas, ULONG_MAX)) != NULL);
 
+	/* Completed a full walk - refresh the cache for the next read */
+	if (priv->rollup_cache)
+		smaps_rollup_cache_fill(priv->rollup_cache, mm, &mss,
+					vma_start, last_vma_end);
+
 empty_set:
 	show_vma_header_prefix(m, vma_start, last_vma_end, 0, 0, 0, 0);
 	seq_pad(m, ' ');
@@ -1029,6 +1107,10 @@ static int smaps_rollup_open(struct inode *inode, struct file *file)
 		goto out_free;
 	}
 
+	/* Optional; pollers re-reading the same fd walk only on changes */
+	priv->rollup_cache = kzalloc(sizeof(*priv->rollup_cache),
+				     GFP_KERNEL_ACCOUNT);
+
 	return 0;
 
 out_free:
@@ -1044,6 +1126,7 @@ static int smaps_rollup_release(struct inode *inode, struct file *file)
 	if (priv->mm)
 		mmdrop(priv->mm);
 
+	kfree(priv->rollup_cache);
 	kfree(priv);
 	return single_release(inode, file);
 }
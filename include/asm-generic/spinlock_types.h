@@ -4,14 +4,16 @@
 #define __ASM_GENERIC_SPINLOCK_TYPES_H
 
 #include <linux/types.h>
-typedef atomic_t arch_spinlock_t;
+#include <asm-generic/qspinlock_types.h>
 
 /*
- * qrwlock_types depends on arch_spinlock_t, so we must typedef that before the
+ * The ticket lock and the queued spinlock share arch_spinlock_t (see
+ * asm-generic/qspinlock_types.h) so that an architecture can select the
+ * implementation at boot time.
+ *
+ * qrwlock_types depends on arch_spinlock_t, so we must define that before the
  * include.
  */
 #include <asm/qrwlock_types.h>
 
-#define __ARCH_SPIN_LOCK_UNLOCKED	ATOMIC_INIT(0)
-
 #endif /* __ASM_GENERIC_SPINLOCK_TYPES_H */
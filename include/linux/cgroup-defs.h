@@ -477,6 +477,13 @@ struct cgroup {
 	struct cgroup_rstat_cpu __percpu *rstat_cpu;
 	struct list_head rstat_css_list;
 
+	/*
+	 * Number of cgroup/cpu pairs in the subtree with pending rstat
+	 * deltas, used by cgroup_rstat_flush_nowait() to skip flushes
+	 * which wouldn't gather enough data to matter.
+	 */
+	atomic_t rstat_pending;
+
 	/* cgroup basic resource statistics */
 	struct cgroup_base_stat last_bstat;
 	struct cgroup_base_stat bstat;
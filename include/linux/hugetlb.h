@@ -52,13 +52,20 @@ enum {
 };
 
 struct hugepage_subpool {
-	spinlock_t lock;
-	long count;
+	/* Read-mostly configuration, set up at mount time. */
+	struct hstate *hstate;
 	long max_hpages;	/* Maximum huge pages or -1 if no maximum. */
+	long min_hpages;	/* Minimum huge pages or -1 if no minimum. */
+
+	/*
+	 * Counters below are written on every reservation and fault; keep
+	 * them on their own cache line so concurrent faulters do not drag
+	 * the configuration fields around with the lock.
+	 */
+	spinlock_t lock ____cacheline_aligned_in_smp;
+	long count;
 	long used_hpages;	/* Used count against maximum, includes */
 				/* both allocated and reserved pages. */
-	struct hstate *hstate;
-	long min_hpages;	/* Minimum huge pages or -1 if no minimum. */
 	long rsv_hpages;	/* Pages reserved against global pool to */
 				/* satisfy minimum size. */
 };
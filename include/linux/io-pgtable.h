@@ -19,6 +19,8 @@ enum io_pgtable_fmt {
 	AMD_IOMMU_V2,
 	APPLE_DART,
 	APPLE_DART2,
+	RISCV_SV39,
+	RISCV_SV48,
 	IO_PGTABLE_NUM_FMTS,
 };
 
@@ -144,6 +146,10 @@ struct io_pgtable_cfg {
 			u64 ttbr[4];
 			u32 n_ttbrs;
 		} apple_dart_cfg;
+
+		struct {
+			u64	pgd;
+		} riscv_cfg;
 	};
 };
 
@@ -264,5 +270,7 @@ extern struct io_pgtable_init_fns io_pgtable_arm_mali_lpae_init_fns;
 extern struct io_pgtable_init_fns io_pgtable_amd_iommu_v1_init_fns;
 extern struct io_pgtable_init_fns io_pgtable_amd_iommu_v2_init_fns;
 extern struct io_pgtable_init_fns io_pgtable_apple_dart_init_fns;
+extern struct io_pgtable_init_fns io_pgtable_riscv_sv39_init_fns;
+extern struct io_pgtable_init_fns io_pgtable_riscv_sv48_init_fns;
 
 #endif /* __IO_PGTABLE_H */
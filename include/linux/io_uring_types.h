@@ -242,6 +242,11 @@ struct io_ring_ctx {
 
 		struct io_submit_state	submit_state;
 
+		/* open coalesced sendzc notification, see io_coalesced_notif_get() */
+		struct io_kiocb		*zc_notif;
+		int			zc_notif_fd;
+		bool			zc_notif_fixed;
+
 		struct io_buffer_list	*io_bl;
 		struct xarray		io_bl_xa;
 		struct list_head	io_buffers_cache;
@@ -317,6 +322,9 @@ struct io_ring_ctx {
 	struct io_restriction		restrictions;
 	struct task_struct		*submitter_task;
 
+	/* serializes ring fd mmap against IORING_REGISTER_RESIZE_RINGS */
+	struct mutex			resize_lock;
+
 	/* slow path rsrc auxilary data, used by update/register */
 	struct io_rsrc_node		*rsrc_backup_node;
 	struct io_mapped_ubuf		*dummy_ubuf;
@@ -353,6 +361,8 @@ struct io_ring_ctx {
 
 	struct list_head		defer_list;
 	unsigned			sq_thread_idle;
+	/* SQEs submitted on behalf of this ring by the SQPOLL thread */
+	u64				sq_submitted;
 	/* protected by ->completion_lock */
 	unsigned			evfd_last_cq_tail;
 };
@@ -37,6 +37,7 @@ struct iova_domain {
 	struct iova	anchor;		/* rbtree lookup anchor */
 
 	struct iova_rcache	*rcaches;
+	unsigned long	rcache_depot_max; /* Cap on depot magazines per rcache */
 	struct hlist_node	cpuhp_dead;
 };
 
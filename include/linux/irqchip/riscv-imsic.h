@@ -0,0 +1,29 @@
+/* SPDX-License-Identifier: GPL-2.0 */
+/*
+ * Interface between the RISC-V IMSIC driver and the APLIC driver, which
+ * needs the IMSIC base irq domain to stack its wired-to-MSI domain on,
+ * and the interrupt-file geometry to turn an MSI target address back
+ * into a hart index for its target registers.
+ */
+#ifndef _LINUX_IRQCHIP_RISCV_IMSIC_H
+#define _LINUX_IRQCHIP_RISCV_IMSIC_H
+
+#include <linux/types.h>
+
+struct irq_domain;
+
+#ifdef CONFIG_RISCV_IMSIC
+struct irq_domain *imsic_get_base_domain(void);
+u32 imsic_pa_to_hartindex(phys_addr_t pa);
+#else
+static inline struct irq_domain *imsic_get_base_domain(void)
+{
+	return NULL;
+}
+static inline u32 imsic_pa_to_hartindex(phys_addr_t pa)
+{
+	return 0;
+}
+#endif
+
+#endif /* _LINUX_IRQCHIP_RISCV_IMSIC_H */
@@ -722,6 +722,18 @@ struct transaction_s
 	struct list_head	t_private_list;
 };
 
+/*
+ * Per-CPU cache of credits drawn in batches from the running transaction.
+ * The cached credits are already included in t_outstanding_credits of the
+ * transaction identified by @tid, so handing them to a handle is pure
+ * per-CPU arithmetic; credits left over from an earlier transaction are
+ * simply dropped and remain counted against it.
+ */
+struct jbd2_credit_cache {
+	tid_t		tid;		/* transaction the credits came from */
+	int		credits;	/* credits available on this CPU */
+};
+
 struct transaction_run_stats_s {
 	unsigned long		rs_wait;
 	unsigned long		rs_request_delay;
@@ -1029,6 +1041,25 @@ struct journal_s
 	 */
 	atomic_t		j_reserved_credits;
 
+	/**
+	 * @j_credit_cache:
+	 *
+	 * Per-CPU caches of credits pre-reserved from the running
+	 * transaction, so that handle start and stop in the common case do
+	 * not touch the shared t_outstanding_credits counter.
+	 */
+	struct jbd2_credit_cache __percpu *j_credit_cache;
+
+	/**
+	 * @j_credit_batch:
+	 *
+	 * Number of credits a CPU grabs at a time for its credit cache,
+	 * sized so that all caches together cannot inflate the running
+	 * transaction's accounting by more than a fraction of
+	 * j_max_transaction_buffers.  Zero disables the caches.
+	 */
+	int			j_credit_batch;
+
 	/**
 	 * @j_list_lock: Protects the buffer lists and internal buffer state.
 	 */
@@ -15,10 +15,16 @@
 #ifdef CONFIG_KFENCE
 
 #include <linux/atomic.h>
+#include <linux/percpu.h>
 #include <linux/static_key.h>
 
 extern unsigned long kfence_sample_interval;
 
+#if !defined(CONFIG_KFENCE_STATIC_KEYS) && CONFIG_KFENCE_SAMPLE_INTERVAL != 0
+extern unsigned int kfence_check_stride;
+DECLARE_PER_CPU(int, kfence_skip_counter);
+#endif
+
 /*
  * We allocate an even number of pages, as it simplifies calculations to map
  * address to metadata indices; effectively, the very first page serves as an
@@ -122,6 +128,18 @@ static __always_inline void *kfence_alloc(struct kmem_cache *s, size_t size, gfp
 #else
 	if (!static_branch_likely(&kfence_allocation_key))
 		return NULL;
+	/*
+	 * Without static keys every allocation would read the shared
+	 * allocation gate, keeping its cacheline bouncing between all
+	 * allocating CPUs whenever the gate is toggled.  Skip most
+	 * allocations using a cheap per-CPU countdown, and look at the gate
+	 * only on every kfence_check_stride-th allocation of this CPU.  The
+	 * countdown is only statistical; races with CPU migration just make
+	 * a CPU check the gate a little earlier or later.
+	 */
+	if (likely(raw_cpu_dec_return(kfence_skip_counter) > 0))
+		return NULL;
+	raw_cpu_write(kfence_skip_counter, kfence_check_stride);
 #endif
 	if (likely(atomic_read(&kfence_allocation_gate)))
 		return NULL;
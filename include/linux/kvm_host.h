@@ -332,6 +332,8 @@ struct kvm_vcpu {
 	int sigset_active;
 	sigset_t sigset;
 	unsigned int halt_poll_ns;
+	u16 halt_poll_history;
+	u8 halt_poll_hist_len;
 	bool valid_wakeup;
 
 #ifdef CONFIG_HAS_IOMEM
@@ -1864,6 +1866,8 @@ struct _kvm_stats_desc {
 			HALT_POLL_HIST_COUNT),				       \
 	STATS_DESC_LOGHIST_TIME_NSEC(VCPU_GENERIC, halt_wait_hist,	       \
 			HALT_POLL_HIST_COUNT),				       \
+	STATS_DESC_ICOUNTER(VCPU_GENERIC, halt_poll_window_hits),	       \
+	STATS_DESC_ICOUNTER(VCPU_GENERIC, halt_poll_cur_ns),		       \
 	STATS_DESC_IBOOLEAN(VCPU_GENERIC, blocking)
 
 extern struct dentry *kvm_debugfs_dir;
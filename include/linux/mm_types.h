@@ -508,6 +508,7 @@ struct vm_area_struct {
 	struct vm_userfaultfd_ctx vm_userfaultfd_ctx;
 } __randomize_layout;
 
+struct futex_private_hash;
 struct kioctx_table;
 struct mm_struct {
 	struct {
@@ -625,6 +626,13 @@ struct mm_struct {
 
 		unsigned long flags; /* Must use atomic bitops to access */
 
+#ifdef CONFIG_FUTEX
+		/*
+		 * Optional process private futex hash, set up via
+		 * prctl(PR_FUTEX_HASH) and freed on the last mmput().
+		 */
+		struct futex_private_hash *futex_phash;
+#endif
 #ifdef CONFIG_AIO
 		spinlock_t			ioctx_lock;
 		struct kioctx_table __rcu	*ioctx_table;
@@ -58,6 +58,8 @@ struct rw_semaphore {
 #endif
 	raw_spinlock_t wait_lock;
 	struct list_head wait_list;
+	/* reader-biased mode, see rwsem_set_reader_biased() */
+	unsigned int rbias;
 #ifdef CONFIG_DEBUG_RWSEMS
 	void *magic;
 #endif
@@ -72,6 +74,21 @@ static inline int rwsem_is_locked(struct rw_semaphore *sem)
 	return atomic_long_read(&sem->count) != 0;
 }
 
+/*
+ * Favour readers over queued writers on this rwsem: arriving readers keep
+ * stealing the lock past a queued writer until the writer has waited out
+ * the handoff timeout, after which they queue behind it and let the
+ * reader count drain so the writer gets woken. The writer wait is thus
+ * bounded by the handoff timeout plus the drain of the readers already
+ * holding the lock. Only meant for read-mostly semaphores such as
+ * mmap_lock where reader latency matters more than writer latency; must
+ * be called before the rwsem is used.
+ */
+static inline void rwsem_set_reader_biased(struct rw_semaphore *sem)
+{
+	sem->rbias = 1;
+}
+
 #define RWSEM_UNLOCKED_VALUE		0L
 #define __RWSEM_COUNT_INIT(name)	.count = ATOMIC_LONG_INIT(RWSEM_UNLOCKED_VALUE)
 
@@ -162,6 +179,9 @@ static __always_inline int rwsem_is_contended(struct rw_semaphore *sem)
 	return rw_base_is_contended(&sem->rwbase);
 }
 
+/* The rtmutex based implementation is already reader biased */
+static inline void rwsem_set_reader_biased(struct rw_semaphore *sem) { }
+
 #endif /* CONFIG_PREEMPT_RT */
 
 /*
@@ -87,6 +87,12 @@ dma_addr_t swiotlb_map(struct device *dev, phys_addr_t phys,
  * @for_alloc:  %true if the pool is used for memory allocation
  * @nareas:  The area number in the pool.
  * @area_nslabs: The slot number in the area.
+ * @pools:	Extra pool segments grown at runtime, RCU list.
+ * @node:	Node in the parent pool's @pools list.
+ * @pools_lock:	Serializes additions to @pools.
+ * @extra_nslabs: Total number of slots in the grown segments.
+ * @has_pools:	%true once @pools is non-empty.
+ * @can_grow:	%true if extra segments may be grown on demand.
  */
 struct io_tlb_mem {
 	phys_addr_t start;
@@ -102,14 +108,29 @@ struct io_tlb_mem {
 	unsigned int area_nslabs;
 	struct io_tlb_area *areas;
 	struct io_tlb_slot *slots;
+	struct list_head pools;
+	struct list_head node;
+	spinlock_t pools_lock;
+	unsigned long extra_nslabs;
+	bool has_pools;
+	bool can_grow;
 };
 extern struct io_tlb_mem io_tlb_default_mem;
 
+struct io_tlb_mem *swiotlb_find_pool(struct device *dev, phys_addr_t paddr);
+
 static inline bool is_swiotlb_buffer(struct device *dev, phys_addr_t paddr)
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 
-	return mem && paddr >= mem->start && paddr < mem->end;
+	if (!mem)
+		return false;
+	if (paddr >= mem->start && paddr < mem->end)
+		return true;
+	/* pool segments grown at runtime sit outside the main range */
+	if (READ_ONCE(mem->has_pools))
+		return swiotlb_find_pool(dev, paddr) != NULL;
+	return false;
 }
 
 static inline bool is_swiotlb_force_bounce(struct device *dev)
@@ -114,6 +114,20 @@ static inline size_t virtio_vsock_skb_len(struct sk_buff *skb)
 #define VIRTIO_VSOCK_MAX_BUF_SIZE		0xFFFFFFFFUL
 #define VIRTIO_VSOCK_MAX_PKT_BUF_SIZE		(1024 * 64)
 
+/* Feature bit: the device may send packets up to
+ * VIRTIO_VSOCK_MAX_PKT_BUF_SIZE, so the driver posts rx buffers of that
+ * size instead of VIRTIO_VSOCK_DEFAULT_RX_BUF_SIZE.  Mirrors the uapi
+ * value.
+ */
+#ifndef VIRTIO_VSOCK_F_BIG_PACKETS
+#define VIRTIO_VSOCK_F_BIG_PACKETS	6
+#endif
+
+/* Bound on rx buffer memory parked in the virtqueue, so big-packet
+ * buffers do not multiply the default footprint by their size ratio.
+ */
+#define VIRTIO_VSOCK_MAX_RX_BUF_BYTES		(1024 * 1024 * 4)
+
 enum {
 	VSOCK_VQ_RX     = 0, /* for host to guest data */
 	VSOCK_VQ_TX     = 1, /* for guest to host data */
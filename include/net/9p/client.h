@@ -84,16 +84,35 @@ struct p9_req_t {
 	struct list_head req_list;
 };
 
+/* Upper bound on per-CPU request tag pools carved out of the tag space */
+#define P9_TAG_POOLS_MAX 16
+
+/**
+ * struct p9_tag_pool - slice of a client's request tag space
+ * @lock: protects @reqs
+ * @reqs: active requests whose tags fall in this slice
+ *
+ * The 16-bit tag space is statically partitioned so that concurrent
+ * requests issued from different CPUs allocate and retire tags without
+ * contending on a single client-wide lock.
+ */
+struct p9_tag_pool {
+	spinlock_t lock;
+	struct idr reqs;
+};
+
 /**
  * struct p9_client - per client instance state
- * @lock: protect @fids and @reqs
+ * @lock: protect @fids
  * @msize: maximum data size negotiated by protocol
  * @proto_version: 9P protocol version to use
  * @trans_mod: module API instantiated with this client
  * @status: connection state
  * @trans: tranport instance state and API
  * @fids: All active FID handles
- * @reqs: All active requests.
+ * @pools: Per-CPU slices of the request tag space.
+ * @n_pools: Number of active entries in @pools (power of two).
+ * @pool_shift: Bits of tag space covered by each pool.
  * @name: node name used as client id
  *
  * The client structure is used to keep track of various per-client
@@ -121,7 +140,9 @@ struct p9_client {
 	} trans_opts;
 
 	struct idr fids;
-	struct idr reqs;
+	struct p9_tag_pool pools[P9_TAG_POOLS_MAX];
+	unsigned int n_pools;
+	unsigned int pool_shift;
 
 	char name[__NEW_UTS_LEN + 1];
 };
@@ -15,6 +15,8 @@
 #include <linux/mm.h>
 #include <linux/namei.h>
 #include <linux/init_syscalls.h>
+#include <linux/kthread.h>
+#include <linux/completion.h>
 #include <linux/task_work.h>
 #include <linux/umh.h>
 
@@ -486,6 +488,158 @@ static unsigned long my_inptr __initdata; /* index of next byte to be processed
 
 #include <linux/decompress/generic.h>
 
+static bool __initdata initramfs_pipeline = true;
+static int __init initramfs_pipeline_setup(char *str)
+{
+	strtobool(str, &initramfs_pipeline);
+	return 1;
+}
+__setup("initramfs_pipeline=", initramfs_pipeline_setup);
+
+/*
+ * Pipelined unpacking: the decompressor runs in a kthread on another CPU
+ * and hands its output to this context, which runs the cpio state machine
+ * and creates the files (with the boot task's credentials, as before).
+ * The stream formats give no way to find the end of a compressed stream
+ * without inflating it, so a single stream cannot be split across CPUs;
+ * overlapping inflate with the VFS work is what is possible without a new
+ * image format. Concatenated archives are pipelined one stream at a time.
+ */
+#define PIPELINE_MAX_BYTES	(1 << 20)
+
+struct pipeline_chunk {
+	struct list_head	list;
+	unsigned long		len;
+	char			data[];
+};
+
+static struct {
+	struct list_head	chunks;
+	spinlock_t		lock;
+	wait_queue_head_t	produce_wq;
+	wait_queue_head_t	consume_wq;
+	struct completion	done;
+	unsigned long		bytes;	/* decompressed data in flight */
+	bool			eof;
+	int			res;
+} pipeline __initdata;
+
+static long __init pipeline_flush(void *bufv, unsigned long len)
+{
+	struct pipeline_chunk *chunk;
+
+	if (READ_ONCE(message))
+		return -1;
+
+	chunk = kmalloc(struct_size(chunk, data, len), GFP_KERNEL);
+	if (!chunk) {
+		error("out of memory while buffering archive");
+		return -1;
+	}
+	chunk->len = len;
+	memcpy(chunk->data, bufv, len);
+
+	/* Cap the amount of decompressed data sitting in the queue. */
+	wait_event(pipeline.produce_wq,
+		   READ_ONCE(pipeline.bytes) < PIPELINE_MAX_BYTES ||
+		   READ_ONCE(message));
+	if (READ_ONCE(message)) {
+		kfree(chunk);
+		return -1;
+	}
+
+	spin_lock(&pipeline.lock);
+	list_add_tail(&chunk->list, &pipeline.chunks);
+	pipeline.bytes += len;
+	spin_unlock(&pipeline.lock);
+	wake_up(&pipeline.consume_wq);
+
+	return len;
+}
+
+struct pipeline_args {
+	char *buf;
+	unsigned long len;
+	decompress_fn decompress;
+};
+
+static int __init pipeline_threadfn(void *data)
+{
+	struct pipeline_args *args = data;
+
+	pipeline.res = args->decompress(args->buf, args->len, NULL,
+					pipeline_flush, NULL, &my_inptr,
+					error);
+	smp_store_release(&pipeline.eof, true);
+	wake_up(&pipeline.consume_wq);
+	complete(&pipeline.done);
+	return 0;
+}
+
+static int __init pipeline_unpack(char *buf, unsigned long len,
+				  decompress_fn decompress)
+{
+	struct pipeline_args args = {
+		.buf = buf,
+		.len = len,
+		.decompress = decompress,
+	};
+	struct pipeline_chunk *chunk, *tmp;
+	struct task_struct *task;
+
+	INIT_LIST_HEAD(&pipeline.chunks);
+	spin_lock_init(&pipeline.lock);
+	init_waitqueue_head(&pipeline.produce_wq);
+	init_waitqueue_head(&pipeline.consume_wq);
+	init_completion(&pipeline.done);
+	pipeline.bytes = 0;
+	pipeline.eof = false;
+	pipeline.res = 0;
+
+	task = kthread_run(pipeline_threadfn, &args, "initramfs");
+	if (IS_ERR(task))
+		return decompress(buf, len, NULL, flush_buffer, NULL,
+				  &my_inptr, error);
+
+	for (;;) {
+		wait_event(pipeline.consume_wq,
+			   !list_empty(&pipeline.chunks) ||
+			   smp_load_acquire(&pipeline.eof) || message);
+		if (message)
+			break;
+
+		spin_lock(&pipeline.lock);
+		chunk = list_first_entry_or_null(&pipeline.chunks,
+						 struct pipeline_chunk, list);
+		if (chunk) {
+			list_del(&chunk->list);
+			pipeline.bytes -= chunk->len;
+		}
+		spin_unlock(&pipeline.lock);
+
+		if (!chunk) {
+			if (smp_load_acquire(&pipeline.eof))
+				break;
+			continue;
+		}
+
+		wake_up(&pipeline.produce_wq);
+		flush_buffer(chunk->data, chunk->len);
+		kfree(chunk);
+	}
+
+	/* Let the decompressor observe any error and run to completion. */
+	wake_up(&pipeline.produce_wq);
+	wait_for_completion(&pipeline.done);
+
+	list_for_each_entry_safe(chunk, tmp, &pipeline.chunks, list) {
+		list_del(&chunk->list);
+		kfree(chunk);
+	}
+
+	return pipeline.res;
+}
+
 static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 {
 	long written;
@@ -522,8 +676,13 @@ static char * __init unpack_to_rootfs(char *buf, unsigned long len)
 		decompress = decompress_method(buf, len, &compress_name);
 		pr_debug("Detected %s compressed data\n", compress_name);
 		if (decompress) {
-			int res = decompress(buf, len, NULL, flush_buffer, NULL,
-				   &my_inptr, error);
+			int res;
+
+			if (initramfs_pipeline && num_online_cpus() > 1)
+				res = pipeline_unpack(buf, len, decompress);
+			else
+				res = decompress(buf, len, NULL, flush_buffer,
+						 NULL, &my_inptr, error);
 			if (res)
 				error("decompressor failed");
 		} else if (compress_name) {
@@ -16,6 +16,8 @@
 #include <linux/extable.h>
 #include <linux/module.h>
 #include <linux/proc_fs.h>
+#include <linux/debugfs.h>
+#include <linux/seq_file.h>
 #include <linux/binfmts.h>
 #include <linux/kernel.h>
 #include <linux/syscalls.h>
@@ -1283,17 +1285,96 @@ static inline void do_trace_initcall_finish(initcall_t fn, int ret)
 }
 #endif /* !TRACEPOINTS_ENABLED */
 
+#ifdef CONFIG_DEBUG_FS
+/*
+ * Duration and result of every initcall run during boot, retrievable
+ * after the fact from <debugfs>/initcall_timings. Unlike initcall_debug
+ * this needs no console bandwidth and no boot parameter; recording stops
+ * once the system leaves SYSTEM_BOOTING, so module loads after early
+ * userspace settle are not mixed in.
+ */
+struct initcall_timing {
+	initcall_t	fn;
+	u64		duration;	/* nsecs */
+	int		ret;
+};
+
+static struct initcall_timing *initcall_timings;
+static int initcall_timings_count;
+static int initcall_timings_max;
+static DEFINE_MUTEX(initcall_timings_lock);
+
+static void initcall_timing_record(initcall_t fn, u64 duration, int ret)
+{
+	struct initcall_timing *t;
+
+	if (system_state != SYSTEM_BOOTING)
+		return;
+
+	/* Module initcalls during boot come in concurrently. */
+	mutex_lock(&initcall_timings_lock);
+	if (initcall_timings_count >= initcall_timings_max) {
+		int max = initcall_timings_max ? 2 * initcall_timings_max : 512;
+		struct initcall_timing *new;
+
+		new = krealloc_array(initcall_timings, max, sizeof(*new),
+				     GFP_KERNEL);
+		if (!new)
+			goto out;
+		initcall_timings = new;
+		initcall_timings_max = max;
+	}
+	t = &initcall_timings[initcall_timings_count++];
+	t->fn = fn;
+	t->duration = duration;
+	t->ret = ret;
+out:
+	mutex_unlock(&initcall_timings_lock);
+}
+
+static int initcall_timings_show(struct seq_file *m, void *v)
+{
+	int i;
+
+	mutex_lock(&initcall_timings_lock);
+	for (i = 0; i < initcall_timings_count; i++) {
+		struct initcall_timing *t = &initcall_timings[i];
+
+		seq_printf(m, "%8llu %5d %pS\n",
+			   div_u64(t->duration, NSEC_PER_USEC), t->ret, t->fn);
+	}
+	mutex_unlock(&initcall_timings_lock);
+	return 0;
+}
+DEFINE_SHOW_ATTRIBUTE(initcall_timings);
+
+static int __init initcall_timings_init(void)
+{
+	debugfs_create_file("initcall_timings", 0444, NULL, NULL,
+			    &initcall_timings_fops);
+	return 0;
+}
+late_initcall(initcall_timings_init);
+#else
+static inline void initcall_timing_record(initcall_t fn, u64 duration, int ret)
+{
+}
+#endif /* CONFIG_DEBUG_FS */
+
 int __init_or_module do_one_initcall(initcall_t fn)
 {
 	int count = preempt_count();
 	char msgbuf[64];
+	u64 start;
 	int ret;
 
 	if (initcall_blacklisted(fn))
 		return -EPERM;
 
 	do_trace_initcall_start(fn);
+	start = ktime_get_ns();
 	ret = fn();
+	initcall_timing_record(fn, ktime_get_ns() - start, ret);
 	do_trace_initcall_finish(fn, ret);
 
 	msgbuf[0] = 0;
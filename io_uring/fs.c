@@ -3,6 +3,7 @@
 #include <linux/errno.h>
 #include <linux/fs.h>
 #include <linux/file.h>
+#include <linux/dirent.h>
 #include <linux/mm.h>
 #include <linux/slab.h>
 #include <linux/namei.h>
@@ -13,6 +14,7 @@
 #include "../fs/internal.h"
 
 #include "io_uring.h"
+#include "kbuf.h"
 #include "fs.h"
 
 struct io_rename {
@@ -47,6 +49,12 @@ struct io_link {
 	int				flags;
 };
 
+struct io_getdents {
+	struct file			*file;
+	struct linux_dirent64 __user	*dirent;
+	unsigned int			count;
+};
+
 int io_renameat_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 {
 	struct io_rename *ren = io_kiocb_to_cmd(req, struct io_rename);
@@ -291,3 +299,50 @@ void io_link_cleanup(struct io_kiocb *req)
 	putname(sl->oldpath);
 	putname(sl->newpath);
 }
+
+int io_getdents_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
+{
+	struct io_getdents *gd = io_kiocb_to_cmd(req, struct io_getdents);
+
+	if (sqe->off || sqe->rw_flags || sqe->splice_fd_in)
+		return -EINVAL;
+
+	gd->dirent = u64_to_user_ptr(READ_ONCE(sqe->addr));
+	gd->count = READ_ONCE(sqe->len);
+	return 0;
+}
+
+int io_getdents(struct io_kiocb *req, unsigned int issue_flags)
+{
+	struct io_getdents *gd = io_kiocb_to_cmd(req, struct io_getdents);
+	struct linux_dirent64 __user *dirent = gd->dirent;
+	unsigned int count = gd->count;
+	int ret;
+
+	if (issue_flags & IO_URING_F_NONBLOCK)
+		return -EAGAIN;
+
+	if (io_do_buffer_select(req)) {
+		size_t len = count;
+		void __user *buf;
+
+		buf = io_buffer_select(req, &len, issue_flags);
+		if (!buf)
+			return -ENOBUFS;
+		dirent = buf;
+		count = len;
+	}
+
+	/* serialize against other ->f_pos users, like fdget_pos() would */
+	mutex_lock(&req->file->f_pos_lock);
+	ret = vfs_getdents(req->file, dirent, count);
+	mutex_unlock(&req->file->f_pos_lock);
+
+	if (ret < 0) {
+		if (ret == -ERESTARTSYS)
+			ret = -EINTR;
+		req_set_fail(req);
+	}
+	io_req_set_res(req, ret, io_put_kbuf(req, ret, issue_flags));
+	return IOU_OK;
+}
@@ -620,6 +620,57 @@ static void io_worker_handle_work(struct io_worker *worker)
 	} while (1);
 }
 
+/*
+ * Called when a worker has run out of local work. Try to pull one
+ * non-hashed work item of the same account type off another node's
+ * queue, so a flooded node can spill over onto idle workers elsewhere
+ * instead of backing up behind its own pool limits. Hashed work stays
+ * put to preserve the per-node hash chains. The stolen item is added
+ * to the local queue for the caller to pick up, which also makes it
+ * discoverable again for cancelation.
+ */
+static bool io_wqe_steal_work(struct io_worker *worker)
+{
+	struct io_wqe_acct *acct = io_wqe_get_acct(worker);
+	struct io_wqe *wqe = worker->wqe;
+	struct io_wq *wq = wqe->wq;
+	struct io_wq_work *work = NULL;
+	struct io_wq_work_node *node, *prev;
+	struct io_wqe_acct *victim;
+	int i;
+
+	if (nr_node_ids == 1)
+		return false;
+
+	for_each_node(i) {
+		if (wq->wqes[i] == wqe)
+			continue;
+
+		victim = &wq->wqes[i]->acct[acct->index];
+		raw_spin_lock(&victim->lock);
+		wq_list_for_each(node, prev, &victim->work_list) {
+			work = container_of(node, struct io_wq_work, list);
+			if (io_wq_is_hashed(work)) {
+				work = NULL;
+				continue;
+			}
+			wq_list_del(&victim->work_list, node, prev);
+			break;
+		}
+		raw_spin_unlock(&victim->lock);
+		if (work)
+			break;
+	}
+	if (!work)
+		return false;
+
+	raw_spin_lock(&acct->lock);
+	wq_list_add_tail(&work->list, &acct->work_list);
+	clear_bit(IO_ACCT_STALLED_BIT, &acct->flags);
+	raw_spin_unlock(&acct->lock);
+	return true;
+}
+
 static int io_wqe_worker(void *data)
 {
 	struct io_worker *worker = data;
@@ -641,6 +692,10 @@ static int io_wqe_worker(void *data)
 		while (io_acct_run_queue(acct))
 			io_worker_handle_work(worker);
 
+		/* Only steal once the local queue is drained */
+		if (io_wqe_steal_work(worker))
+			continue;
+
 		raw_spin_lock(&wqe->lock);
 		/* timed out, exit unless we're the last worker */
 		if (last_timeout && acct->nr_workers > 1) {
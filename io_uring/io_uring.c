@@ -314,6 +314,7 @@ static __cold struct io_ring_ctx *io_ring_ctx_alloc(struct io_uring_params *p)
 	init_completion(&ctx->ref_comp);
 	xa_init_flags(&ctx->personalities, XA_FLAGS_ALLOC1);
 	mutex_init(&ctx->uring_lock);
+	mutex_init(&ctx->resize_lock);
 	init_waitqueue_head(&ctx->cq_wait);
 	spin_lock_init(&ctx->completion_lock);
 	spin_lock_init(&ctx->timeout_lock);
@@ -873,7 +874,7 @@ void io_req_complete_failed(struct io_kiocb *req, s32 res)
 	lockdep_assert_held(&req->ctx->uring_lock);
 
 	req_set_fail(req);
-	io_req_set_res(req, res, io_put_kbuf(req, IO_URING_F_UNLOCKED));
+	io_req_set_res(req, res, io_put_kbuf(req, res, IO_URING_F_UNLOCKED));
 	if (def->fail)
 		def->fail(req);
 	io_req_complete_post(req);
@@ -1472,7 +1473,7 @@ void io_req_task_complete(struct io_kiocb *req, bool *locked)
 	if (req->flags & (REQ_F_BUFFER_SELECTED|REQ_F_BUFFER_RING)) {
 		unsigned issue_flags = *locked ? 0 : IO_URING_F_UNLOCKED;
 
-		req->cqe.flags |= io_put_kbuf(req, issue_flags);
+		req->cqe.flags |= io_put_kbuf(req, req->cqe.res, issue_flags);
 	}
 
 	if (*locked)
@@ -2186,6 +2187,9 @@ static void io_submit_state_end(struct io_ring_ctx *ctx)
 
 	if (unlikely(state->link.head))
 		io_queue_sqe_fallback(state->link.head);
+	/* don't let a coalesced sendzc notification outlive the batch */
+	if (unlikely(ctx->zc_notif))
+		io_notif_flush_coalesced(ctx);
 	/* flush only after queuing links as they can generate completions */
 	io_submit_flush_completions(ctx);
 	if (state->plug_started)
@@ -3072,6 +3076,13 @@ void __io_uring_cancel(bool cancel_all)
 	io_uring_cancel_generic(cancel_all, NULL);
 }
 
+static inline struct mutex *ctx_mmap_resize_lock(struct file *file)
+{
+	struct io_ring_ctx *ctx = file->private_data;
+
+	return &ctx->resize_lock;
+}
+
 static void *io_uring_validate_mmap_request(struct file *file,
 					    loff_t pgoff, size_t sz)
 {
@@ -3103,16 +3114,35 @@ static void *io_uring_validate_mmap_request(struct file *file,
 
 static __cold int io_uring_mmap(struct file *file, struct vm_area_struct *vma)
 {
+	struct io_ring_ctx *ctx = file->private_data;
 	size_t sz = vma->vm_end - vma->vm_start;
-	unsigned long pfn;
+	unsigned int npages, i;
+	struct page *page;
 	void *ptr;
+	int ret = 0;
 
+	mutex_lock(&ctx->resize_lock);
 	ptr = io_uring_validate_mmap_request(file, vma->vm_pgoff, sz);
-	if (IS_ERR(ptr))
+	if (IS_ERR(ptr)) {
+		mutex_unlock(&ctx->resize_lock);
 		return PTR_ERR(ptr);
+	}
 
-	pfn = virt_to_phys(ptr) >> PAGE_SHIFT;
-	return remap_pfn_range(vma, vma->vm_start, pfn, sz, vma->vm_page_prot);
+	/*
+	 * Map the pages with references held rather than as a raw PFN range,
+	 * so that ring memory dropped by a later ring resize stays alive
+	 * until any stale user mapping of it is actually torn down.
+	 */
+	page = virt_to_page(ptr);
+	npages = sz >> PAGE_SHIFT;
+	for (i = 0; i < npages; i++) {
+		ret = vm_insert_page(vma, vma->vm_start + i * PAGE_SIZE,
+				     nth_page(page, i));
+		if (ret)
+			break;
+	}
+	mutex_unlock(&ctx->resize_lock);
+	return ret;
 }
 
 static unsigned long io_uring_mmu_get_unmapped_area(struct file *filp,
@@ -3129,7 +3159,9 @@ static unsigned long io_uring_mmu_get_unmapped_area(struct file *filp,
 	if (addr)
 		return -EINVAL;
 
+	mutex_lock(&ctx_mmap_resize_lock(filp));
 	ptr = io_uring_validate_mmap_request(filp, pgoff, len);
+	mutex_unlock(&ctx_mmap_resize_lock(filp));
 	if (IS_ERR(ptr))
 		return -ENOMEM;
 
@@ -3176,7 +3208,9 @@ static unsigned long io_uring_nommu_get_unmapped_area(struct file *file,
 {
 	void *ptr;
 
+	mutex_lock(&ctx_mmap_resize_lock(file));
 	ptr = io_uring_validate_mmap_request(file, pgoff, len);
+	mutex_unlock(&ctx_mmap_resize_lock(file));
 	if (IS_ERR(ptr))
 		return PTR_ERR(ptr);
 
@@ -3676,7 +3710,8 @@ static long io_uring_setup(u32 entries, struct io_uring_params __user *params)
 			IORING_SETUP_R_DISABLED | IORING_SETUP_SUBMIT_ALL |
 			IORING_SETUP_COOP_TASKRUN | IORING_SETUP_TASKRUN_FLAG |
 			IORING_SETUP_SQE128 | IORING_SETUP_CQE32 |
-			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN))
+			IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN |
+			IORING_SETUP_INLINE_READS))
 		return -EINVAL;
 
 	return io_uring_create(entries, &p, params);
@@ -3967,6 +4002,188 @@ err:
 	return ret;
 }
 
+/*
+ * Resize the CQ and SQ rings in place, carrying over any queued SQEs and
+ * pending CQEs. On success the old ring memory is dropped and userspace
+ * must re-mmap() the rings at their new size before touching them again;
+ * the kernel side is fully functional with the new sizes right away.
+ *
+ * Limited to DEFER_TASKRUN rings: those confine submission, CQE posting
+ * and CQ waiting to the submitter task, so with ->uring_lock and the
+ * completion lock held there is nobody left who could observe the rings
+ * mid-swap.
+ */
+static __cold int io_register_resize_rings(struct io_ring_ctx *ctx,
+					   void __user *arg)
+{
+	struct io_rings *n_rings, *o_rings;
+	struct io_uring_sqe *n_sqes, *o_sqes;
+	size_t size, sq_array_offset;
+	struct io_uring_params p;
+	unsigned i, tail, old_head;
+	u32 *n_sq_array;
+	int ret;
+
+	if (!(ctx->flags & IORING_SETUP_DEFER_TASKRUN))
+		return -EINVAL;
+	if (copy_from_user(&p, arg, sizeof(p)))
+		return -EFAULT;
+	if (p.flags & ~(IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP))
+		return -EINVAL;
+	if (p.resv[0] || p.resv[1] || p.resv[2])
+		return -EINVAL;
+
+	/* same sizing rules as io_uring_setup() */
+	if (!p.sq_entries)
+		return -EINVAL;
+	if (p.sq_entries > IORING_MAX_ENTRIES) {
+		if (!(p.flags & IORING_SETUP_CLAMP))
+			return -EINVAL;
+		p.sq_entries = IORING_MAX_ENTRIES;
+	}
+	p.sq_entries = roundup_pow_of_two(p.sq_entries);
+	if (p.flags & IORING_SETUP_CQSIZE) {
+		if (!p.cq_entries)
+			return -EINVAL;
+		if (p.cq_entries > IORING_MAX_CQ_ENTRIES) {
+			if (!(p.flags & IORING_SETUP_CLAMP))
+				return -EINVAL;
+			p.cq_entries = IORING_MAX_CQ_ENTRIES;
+		}
+		p.cq_entries = roundup_pow_of_two(p.cq_entries);
+		if (p.cq_entries < p.sq_entries)
+			return -EINVAL;
+	} else {
+		p.cq_entries = 2 * p.sq_entries;
+	}
+
+	size = rings_size(ctx, p.sq_entries, p.cq_entries, &sq_array_offset);
+	if (size == SIZE_MAX)
+		return -EOVERFLOW;
+	n_rings = io_mem_alloc(size);
+	if (!n_rings)
+		return -ENOMEM;
+
+	if (ctx->flags & IORING_SETUP_SQE128)
+		size = array_size(2 * sizeof(struct io_uring_sqe), p.sq_entries);
+	else
+		size = array_size(sizeof(struct io_uring_sqe), p.sq_entries);
+	if (size == SIZE_MAX) {
+		io_mem_free(n_rings);
+		return -EOVERFLOW;
+	}
+	n_sqes = io_mem_alloc(size);
+	if (!n_sqes) {
+		io_mem_free(n_rings);
+		return -ENOMEM;
+	}
+
+	n_sq_array = (u32 *)((char *)n_rings + sq_array_offset);
+	n_rings->sq_ring_mask = p.sq_entries - 1;
+	n_rings->cq_ring_mask = p.cq_entries - 1;
+	n_rings->sq_ring_entries = p.sq_entries;
+	n_rings->cq_ring_entries = p.cq_entries;
+
+	p.sq_off.head = offsetof(struct io_rings, sq.head);
+	p.sq_off.tail = offsetof(struct io_rings, sq.tail);
+	p.sq_off.ring_mask = offsetof(struct io_rings, sq_ring_mask);
+	p.sq_off.ring_entries = offsetof(struct io_rings, sq_ring_entries);
+	p.sq_off.flags = offsetof(struct io_rings, sq_flags);
+	p.sq_off.dropped = offsetof(struct io_rings, sq_dropped);
+	p.sq_off.array = sq_array_offset;
+
+	p.cq_off.head = offsetof(struct io_rings, cq.head);
+	p.cq_off.tail = offsetof(struct io_rings, cq.tail);
+	p.cq_off.ring_mask = offsetof(struct io_rings, cq_ring_mask);
+	p.cq_off.ring_entries = offsetof(struct io_rings, cq_ring_entries);
+	p.cq_off.overflow = offsetof(struct io_rings, cq_overflow);
+	p.cq_off.cqes = offsetof(struct io_rings, cqes);
+	p.cq_off.flags = offsetof(struct io_rings, cq_flags);
+
+	if (copy_to_user(arg, &p, sizeof(p))) {
+		io_mem_free(n_rings);
+		io_mem_free(n_sqes);
+		return -EFAULT;
+	}
+
+	/*
+	 * Exclude new mmap()s of the ring fd, then stop CQE posting and
+	 * swap. ->uring_lock is already held, which keeps submission and
+	 * deferred task_work out.
+	 */
+	mutex_lock(&ctx->resize_lock);
+	spin_lock(&ctx->completion_lock);
+
+	o_rings = ctx->rings;
+	o_sqes = ctx->sq_sqes;
+
+	/*
+	 * Carry over whatever is queued. If either destination ring can't
+	 * hold what is pending in the old one, fail the resize.
+	 */
+	ret = -EOVERFLOW;
+	tail = o_rings->sq.tail;
+	old_head = o_rings->sq.head;
+	if (tail - old_head > p.sq_entries)
+		goto out_unlock;
+	for (i = old_head; i < tail; i++) {
+		unsigned dst = i & (p.sq_entries - 1);
+		unsigned src = READ_ONCE(ctx->sq_array[i & (ctx->sq_entries - 1)]);
+
+		if (unlikely(src >= ctx->sq_entries))
+			src = 0;
+		if (ctx->flags & IORING_SETUP_SQE128)
+			memcpy(&n_sqes[2 * dst], &o_sqes[2 * src],
+			       2 * sizeof(*n_sqes));
+		else
+			n_sqes[dst] = o_sqes[src];
+		/* the indirection is resolved above, publish identity */
+		n_sq_array[dst] = dst;
+	}
+	n_rings->sq.head = old_head;
+	n_rings->sq.tail = tail;
+
+	tail = o_rings->cq.tail;
+	old_head = o_rings->cq.head;
+	if (tail - old_head > p.cq_entries)
+		goto out_unlock;
+	for (i = old_head; i < tail; i++) {
+		unsigned dst = i & (p.cq_entries - 1);
+		unsigned src = i & (ctx->cq_entries - 1);
+
+		if (ctx->flags & IORING_SETUP_CQE32)
+			memcpy(&n_rings->cqes[2 * dst], &o_rings->cqes[2 * src],
+			       2 * sizeof(struct io_uring_cqe));
+		else
+			n_rings->cqes[dst] = o_rings->cqes[src];
+	}
+	n_rings->cq.head = old_head;
+	n_rings->cq.tail = tail;
+	n_rings->sq_dropped = o_rings->sq_dropped;
+	n_rings->sq_flags = o_rings->sq_flags;
+	n_rings->cq_flags = o_rings->cq_flags;
+	n_rings->cq_overflow = o_rings->cq_overflow;
+
+	ctx->rings = n_rings;
+	ctx->sq_sqes = n_sqes;
+	ctx->sq_array = n_sq_array;
+	ctx->sq_entries = p.sq_entries;
+	ctx->cq_entries = p.cq_entries;
+	/* invalidate the cached CQE range, it points into the old ring */
+	ctx->cqe_cached = ctx->cqe_sentinel = NULL;
+
+	/* free the old rings below instead */
+	n_rings = o_rings;
+	n_sqes = o_sqes;
+	ret = 0;
+out_unlock:
+	spin_unlock(&ctx->completion_lock);
+	mutex_unlock(&ctx->resize_lock);
+	io_mem_free(n_rings);
+	io_mem_free(n_sqes);
+	return ret;
+}
+
 static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			       void __user *arg, unsigned nr_args)
 	__releases(ctx->uring_lock)
@@ -4125,6 +4342,12 @@ static int __io_uring_register(struct io_ring_ctx *ctx, unsigned opcode,
 			break;
 		ret = io_register_file_alloc_range(ctx, arg);
 		break;
+	case IORING_REGISTER_RESIZE_RINGS:
+		ret = -EINVAL;
+		if (!arg || nr_args != 1)
+			break;
+		ret = io_register_resize_rings(ctx, arg);
+		break;
 	default:
 		ret = -EINVAL;
 		break;
@@ -77,7 +77,44 @@ void io_kbuf_recycle_legacy(struct io_kiocb *req, unsigned issue_flags)
 	return;
 }
 
-unsigned int __io_put_kbuf(struct io_kiocb *req, unsigned issue_flags)
+static struct io_uring_buf *io_ring_head_to_buf(struct io_buffer_list *bl,
+						__u16 head)
+{
+	struct io_uring_buf *buf;
+	int off, index;
+
+	head &= bl->mask;
+	if (head < IO_BUFFER_LIST_BUF_PER_PAGE)
+		return &bl->buf_ring->bufs[head];
+
+	off = head & (IO_BUFFER_LIST_BUF_PER_PAGE - 1);
+	index = head / IO_BUFFER_LIST_BUF_PER_PAGE;
+	buf = page_address(bl->buf_pages[index]);
+	return buf + off;
+}
+
+/*
+ * Retire or partially consume the entry at the ring head. Returns true if
+ * the entry was fully consumed and the head advanced, false if an
+ * incrementally consumed entry still has bytes left, in which case the
+ * caller must flag the CQE with IORING_CQE_F_BUF_MORE.
+ */
+bool io_kbuf_ring_commit(struct io_buffer_list *bl, int len)
+{
+	if ((bl->flags & IOBL_INC) && len > 0) {
+		struct io_uring_buf *buf = io_ring_head_to_buf(bl, bl->head);
+
+		if (len < buf->len) {
+			buf->addr += len;
+			buf->len -= len;
+			return false;
+		}
+	}
+	bl->head++;
+	return true;
+}
+
+unsigned int __io_put_kbuf(struct io_kiocb *req, int len, unsigned issue_flags)
 {
 	unsigned int cflags;
 
@@ -95,17 +132,17 @@ unsigned int __io_put_kbuf(struct io_kiocb *req, unsigned issue_flags)
 	 */
 	if (req->flags & REQ_F_BUFFER_RING) {
 		/* no buffers to recycle for this case */
-		cflags = __io_put_kbuf_list(req, NULL);
+		cflags = __io_put_kbuf_list(req, len, NULL);
 	} else if (issue_flags & IO_URING_F_UNLOCKED) {
 		struct io_ring_ctx *ctx = req->ctx;
 
 		spin_lock(&ctx->completion_lock);
-		cflags = __io_put_kbuf_list(req, &ctx->io_buffers_comp);
+		cflags = __io_put_kbuf_list(req, len, &ctx->io_buffers_comp);
 		spin_unlock(&ctx->completion_lock);
 	} else {
 		lockdep_assert_held(&req->ctx->uring_lock);
 
-		cflags = __io_put_kbuf_list(req, &req->ctx->io_buffers_cache);
+		cflags = __io_put_kbuf_list(req, len, &req->ctx->io_buffers_cache);
 	}
 	return cflags;
 }
@@ -139,15 +176,7 @@ static void __user *io_ring_buffer_select(struct io_kiocb *req, size_t *len,
 	if (unlikely(smp_load_acquire(&br->tail) == head))
 		return NULL;
 
-	head &= bl->mask;
-	if (head < IO_BUFFER_LIST_BUF_PER_PAGE) {
-		buf = &br->bufs[head];
-	} else {
-		int off = head & (IO_BUFFER_LIST_BUF_PER_PAGE - 1);
-		int index = head / IO_BUFFER_LIST_BUF_PER_PAGE;
-		buf = page_address(bl->buf_pages[index]);
-		buf += off;
-	}
+	buf = io_ring_head_to_buf(bl, head);
 	if (*len == 0 || *len > buf->len)
 		*len = buf->len;
 	req->flags |= REQ_F_BUFFER_RING;
@@ -163,7 +192,8 @@ static void __user *io_ring_buffer_select(struct io_kiocb *req, size_t *len,
 		 * io-wq context and there may be further retries in async hybrid
 		 * mode. For the locked case, the caller must call commit when
 		 * the transfer completes (or if we get -EAGAIN and must poll of
-		 * retry).
+		 * retry). Incremental rings degrade to whole-buffer consumption
+		 * here since the transferred length isn't known up front.
 		 */
 		req->buf_list = NULL;
 		bl->head++;
@@ -482,7 +512,9 @@ int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	if (copy_from_user(&reg, arg, sizeof(reg)))
 		return -EFAULT;
 
-	if (reg.pad || reg.resv[0] || reg.resv[1] || reg.resv[2])
+	if (reg.flags & ~IOU_PBUF_RING_INC)
+		return -EINVAL;
+	if (reg.resv[0] || reg.resv[1] || reg.resv[2])
 		return -EINVAL;
 	if (!reg.ring_addr)
 		return -EFAULT;
@@ -526,6 +558,8 @@ int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 	bl->nr_entries = reg.ring_entries;
 	bl->buf_ring = br;
 	bl->mask = reg.ring_entries - 1;
+	if (reg.flags & IOU_PBUF_RING_INC)
+		bl->flags |= IOBL_INC;
 	io_buffer_add_list(ctx, bl, reg.bgid);
 	return 0;
 }
@@ -537,7 +571,7 @@ int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg)
 
 	if (copy_from_user(&reg, arg, sizeof(reg)))
 		return -EFAULT;
-	if (reg.pad || reg.resv[0] || reg.resv[1] || reg.resv[2])
+	if (reg.flags || reg.resv[0] || reg.resv[1] || reg.resv[2])
 		return -EINVAL;
 
 	bl = io_buffer_get_list(ctx, reg.bgid);
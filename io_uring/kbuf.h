@@ -23,8 +23,17 @@ struct io_buffer_list {
 	__u16 nr_entries;
 	__u16 head;
 	__u16 mask;
+	__u16 flags;
 };
 
+/*
+ * Ring entries are consumed incrementally: a short transfer advances
+ * addr/len of the head entry instead of retiring it, and the CQE is
+ * flagged with IORING_CQE_F_BUF_MORE so the application knows the
+ * buffer is still owned by the kernel side.
+ */
+#define IOBL_INC	1
+
 struct io_buffer {
 	struct list_head list;
 	__u64 addr;
@@ -46,7 +55,9 @@ int io_provide_buffers(struct io_kiocb *req, unsigned int issue_flags);
 int io_register_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg);
 int io_unregister_pbuf_ring(struct io_ring_ctx *ctx, void __user *arg);
 
-unsigned int __io_put_kbuf(struct io_kiocb *req, unsigned issue_flags);
+unsigned int __io_put_kbuf(struct io_kiocb *req, int len, unsigned issue_flags);
+
+bool io_kbuf_ring_commit(struct io_buffer_list *bl, int len);
 
 void io_kbuf_recycle_legacy(struct io_kiocb *req, unsigned issue_flags);
 
@@ -92,7 +103,7 @@ static inline void io_kbuf_recycle(struct io_kiocb *req, unsigned issue_flags)
 		io_kbuf_recycle_ring(req);
 }
 
-static inline unsigned int __io_put_kbuf_list(struct io_kiocb *req,
+static inline unsigned int __io_put_kbuf_list(struct io_kiocb *req, int len,
 					      struct list_head *list)
 {
 	unsigned int ret = IORING_CQE_F_BUFFER | (req->buf_index << IORING_CQE_BUFFER_SHIFT);
@@ -100,7 +111,8 @@ static inline unsigned int __io_put_kbuf_list(struct io_kiocb *req,
 	if (req->flags & REQ_F_BUFFER_RING) {
 		if (req->buf_list) {
 			req->buf_index = req->buf_list->bgid;
-			req->buf_list->head++;
+			if (!io_kbuf_ring_commit(req->buf_list, len))
+				ret |= IORING_CQE_F_BUF_MORE;
 		}
 		req->flags &= ~REQ_F_BUFFER_RING;
 	} else {
@@ -118,15 +130,16 @@ static inline unsigned int io_put_kbuf_comp(struct io_kiocb *req)
 
 	if (!(req->flags & (REQ_F_BUFFER_SELECTED|REQ_F_BUFFER_RING)))
 		return 0;
-	return __io_put_kbuf_list(req, &req->ctx->io_buffers_comp);
+	/* failed or abandoned request, retire any selected buffer entirely */
+	return __io_put_kbuf_list(req, -1, &req->ctx->io_buffers_comp);
 }
 
-static inline unsigned int io_put_kbuf(struct io_kiocb *req,
+static inline unsigned int io_put_kbuf(struct io_kiocb *req, int len,
 				       unsigned issue_flags)
 {
 
 	if (!(req->flags & (REQ_F_BUFFER_SELECTED|REQ_F_BUFFER_RING)))
 		return 0;
-	return __io_put_kbuf(req, issue_flags);
+	return __io_put_kbuf(req, len, issue_flags);
 }
 #endif
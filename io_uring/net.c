@@ -829,7 +829,7 @@ retry_multishot:
 	else
 		io_kbuf_recycle(req, issue_flags);
 
-	cflags = io_put_kbuf(req, issue_flags);
+	cflags = io_put_kbuf(req, ret, issue_flags);
 	if (kmsg->msg.msg_inq)
 		cflags |= IORING_CQE_F_SOCK_NONEMPTY;
 
@@ -929,7 +929,7 @@ out_free:
 	else
 		io_kbuf_recycle(req, issue_flags);
 
-	cflags = io_put_kbuf(req, issue_flags);
+	cflags = io_put_kbuf(req, ret, issue_flags);
 	if (msg.msg_inq)
 		cflags |= IORING_CQE_F_SOCK_NONEMPTY;
 
@@ -971,9 +971,17 @@ int io_send_zc_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 	zc->flags = READ_ONCE(sqe->ioprio);
 	if (zc->flags & ~(IORING_RECVSEND_POLL_FIRST |
 			  IORING_RECVSEND_FIXED_BUF |
-			  IORING_SEND_ZC_REPORT_USAGE))
+			  IORING_SEND_ZC_REPORT_USAGE |
+			  IORING_SEND_ZC_COALESCE))
 		return -EINVAL;
-	notif = zc->notif = io_alloc_notif(ctx);
+	if (zc->flags & IORING_SEND_ZC_COALESCE) {
+		notif = zc->notif = io_coalesced_notif_get(req);
+	} else {
+		/* an uncoalesced send closes any open chain on this ring */
+		if (unlikely(ctx->zc_notif))
+			io_notif_flush_coalesced(ctx);
+		notif = zc->notif = io_alloc_notif(ctx);
+	}
 	if (!notif)
 		return -ENOMEM;
 	notif->cqe.user_data = req->cqe.user_data;
@@ -82,3 +82,46 @@ void io_notif_flush(struct io_kiocb *notif)
 		io_req_task_work_add(notif);
 	}
 }
+
+/*
+ * Consecutive zero-copy sends to the same socket may share a single
+ * notification instead of posting one CQE each. Every send that joins
+ * takes its own reference and bumps the notification's user_data to its
+ * own, while the submission side holds the chain reference until the
+ * batch ends or a different socket is targeted. The one CQE that
+ * eventually posts thus carries the user_data of the last joined send
+ * and signals that the buffers of all sends up to it are released.
+ */
+struct io_kiocb *io_coalesced_notif_get(struct io_kiocb *req)
+	__must_hold(&req->ctx->uring_lock)
+{
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_kiocb *notif = ctx->zc_notif;
+	bool fixed = req->flags & REQ_F_FIXED_FILE;
+
+	if (notif && ctx->zc_notif_fd == req->cqe.fd &&
+	    ctx->zc_notif_fixed == fixed) {
+		refcount_inc(&io_notif_to_data(notif)->uarg.refcnt);
+		return notif;
+	}
+
+	/* different socket, close the open chain and start a fresh one */
+	if (notif)
+		io_notif_flush_coalesced(ctx);
+	notif = io_alloc_notif(ctx);
+	if (!notif)
+		return NULL;
+	/* the chain keeps the base reference, the request gets its own */
+	refcount_inc(&io_notif_to_data(notif)->uarg.refcnt);
+	ctx->zc_notif = notif;
+	ctx->zc_notif_fd = req->cqe.fd;
+	ctx->zc_notif_fixed = fixed;
+	return notif;
+}
+
+void io_notif_flush_coalesced(struct io_ring_ctx *ctx)
+	__must_hold(&ctx->uring_lock)
+{
+	io_notif_flush(ctx->zc_notif);
+	ctx->zc_notif = NULL;
+}
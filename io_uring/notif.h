@@ -20,6 +20,8 @@ struct io_notif_data {
 
 void io_notif_flush(struct io_kiocb *notif);
 struct io_kiocb *io_alloc_notif(struct io_ring_ctx *ctx);
+struct io_kiocb *io_coalesced_notif_get(struct io_kiocb *req);
+void io_notif_flush_coalesced(struct io_ring_ctx *ctx);
 
 static inline struct io_notif_data *io_notif_to_data(struct io_kiocb *notif)
 {
@@ -531,6 +531,13 @@ const struct io_op_def io_op_defs[] = {
 		.prep			= io_eopnotsupp_prep,
 #endif
 	},
+	[IORING_OP_GETDENTS] = {
+		.needs_file		= 1,
+		.buffer_select		= 1,
+		.name			= "GETDENTS",
+		.prep			= io_getdents_prep,
+		.issue			= io_getdents,
+	},
 };
 
 const char *io_uring_get_opcode(u8 opcode)
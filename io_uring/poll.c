@@ -226,6 +226,40 @@ enum {
 	IOU_POLL_REISSUE = 3,
 };
 
+/*
+ * Multishot poll posts a CQE for every readiness edge, so a hot socket
+ * can flood the CQ with thousands of identical entries between reaps.
+ * If the CQE from our previous edge is still sitting unreaped in the
+ * ring with the same mask, another one carries no information - the
+ * application hasn't looked yet and will see current readiness when it
+ * does. Readiness is level-triggered through vfs_poll(), so suppressed
+ * edges aren't lost, the next edge after the ring is reaped posts again.
+ * Masks are compared so that e.g. newly surfacing EPOLLOUT on top of a
+ * pending EPOLLIN entry still gets its own CQE.
+ */
+static bool io_poll_cqe_pending_same(struct io_kiocb *req, __poll_t mask)
+{
+	struct io_poll *poll = io_kiocb_to_cmd(req, struct io_poll);
+	struct io_ring_ctx *ctx = req->ctx;
+	struct io_uring_cqe *cqe;
+	unsigned int off;
+
+	if ((s32)(READ_ONCE(ctx->rings->cq.head) - poll->last_cq_tail) >= 0)
+		return false;
+
+	off = (poll->last_cq_tail - 1) & (ctx->cq_entries - 1);
+	if (ctx->flags & IORING_SETUP_CQE32)
+		off <<= 1;
+	cqe = &ctx->rings->cqes[off];
+	/*
+	 * The ring is mapped writable, so treat the readback as untrusted;
+	 * a mismatch (including a CQE that went to the overflow list and
+	 * left someone else's entry in this slot) just disables coalescing.
+	 */
+	return READ_ONCE(cqe->user_data) == req->cqe.user_data &&
+	       READ_ONCE(cqe->res) == (s32)mask;
+}
+
 /*
  * All poll tw should go through this. Checks for poll events, manages
  * references, does rewait, etc.
@@ -298,10 +332,17 @@ static int io_poll_check_events(struct io_kiocb *req, bool *locked)
 			__poll_t mask = mangle_poll(req->cqe.res &
 						    req->apoll_events);
 
-			if (!io_post_aux_cqe(ctx, req->cqe.user_data,
+			if (io_poll_cqe_pending_same(req, mask)) {
+				/* duplicate of an unreaped CQE, just rearm */
+			} else if (!io_post_aux_cqe(ctx, req->cqe.user_data,
 					     mask, IORING_CQE_F_MORE, false)) {
 				io_req_set_res(req, mask, 0);
 				return IOU_POLL_REMOVE_POLL_USE_RES;
+			} else {
+				struct io_poll *poll = io_kiocb_to_cmd(req,
+							struct io_poll);
+
+				poll->last_cq_tail = READ_ONCE(ctx->rings->cq.tail);
 			}
 		} else {
 			int ret = io_poll_issue(req, locked);
@@ -960,6 +1001,8 @@ int io_poll_add_prep(struct io_kiocb *req, const struct io_uring_sqe *sqe)
 		return -EINVAL;
 
 	poll->events = io_poll_parse_events(sqe, flags);
+	/* no CQE posted yet, so nothing can be coalesced against */
+	poll->last_cq_tail = READ_ONCE(req->ctx->rings->cq.head);
 	return 0;
 }
 
@@ -12,7 +12,12 @@ struct io_poll {
 	struct file			*file;
 	struct wait_queue_head		*head;
 	__poll_t			events;
-	int				retries;
+	union {
+		/* async armed poll: double poll retry budget */
+		int			retries;
+		/* multishot POLL_ADD: CQ tail right after the last CQE */
+		u32			last_cq_tail;
+	};
 	struct wait_queue_entry		wait;
 };
 
@@ -336,7 +336,7 @@ static int kiocb_done(struct io_kiocb *req, ssize_t ret,
 			 */
 			io_req_io_end(req);
 			io_req_set_res(req, final_ret,
-				       io_put_kbuf(req, issue_flags));
+				       io_put_kbuf(req, ret, issue_flags));
 			return IOU_OK;
 		}
 	} else {
@@ -743,8 +743,20 @@ int io_read(struct io_kiocb *req, unsigned int issue_flags)
 	if (force_nonblock) {
 		/* If the file doesn't support async, just async punt */
 		if (unlikely(!io_file_supports_nowait(req))) {
-			ret = io_setup_async_rw(req, iovec, s, true);
-			return ret ?: -EAGAIN;
+			/*
+			 * Rings setup with IORING_SETUP_INLINE_READS try a
+			 * nonblocking read first so page-cache-hot data
+			 * completes inline instead of taking two context
+			 * switches through io-wq. Regular files only - the
+			 * generic filemap path honors IOCB_NOWAIT even when
+			 * the filesystem doesn't advertise FMODE_NOWAIT, and
+			 * a miss falls back to the usual punt below.
+			 */
+			if (!(req->ctx->flags & IORING_SETUP_INLINE_READS) ||
+			    !(req->flags & REQ_F_ISREG)) {
+				ret = io_setup_async_rw(req, iovec, s, true);
+				return ret ?: -EAGAIN;
+			}
 		}
 		kiocb->ki_flags |= IOCB_NOWAIT;
 	} else {
@@ -1058,7 +1070,7 @@ int io_do_iopoll(struct io_ring_ctx *ctx, bool force_nonspin)
 		if (unlikely(req->flags & REQ_F_CQE_SKIP))
 			continue;
 
-		req->cqe.flags = io_put_kbuf(req, 0);
+		req->cqe.flags = io_put_kbuf(req, req->cqe.res, 0);
 		if (unlikely(!__io_fill_cqe_req(ctx, req))) {
 			spin_lock(&ctx->completion_lock);
 			io_req_cqe_overflow(req);
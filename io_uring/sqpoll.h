@@ -16,6 +16,10 @@ struct io_sq_data {
 	pid_t			task_pid;
 	pid_t			task_tgid;
 
+	/* poller utilization, microseconds, published via fdinfo */
+	u64			work_time;
+	ktime_t			started;
+
 	unsigned long		state;
 	struct completion	exited;
 };
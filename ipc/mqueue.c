@@ -1162,12 +1162,19 @@ static int do_mq_timedsend(mqd_t mqdes, const char __user *u_msg_ptr,
 				goto out_unlock;
 			__do_notify(info);
 		}
-		inode->i_atime = inode->i_mtime = inode->i_ctime =
-				current_time(inode);
 	}
 out_unlock:
 	spin_unlock(&info->lock);
 	wake_up_q(&wake_q);
+	/*
+	 * The inode times only ever move forward to "now", so updating
+	 * them after dropping the lock keeps current_time() out of the
+	 * critical section and any race with a concurrent update is
+	 * benign.
+	 */
+	if (ret == 0)
+		inode->i_atime = inode->i_mtime = inode->i_ctime =
+				current_time(inode);
 out_free:
 	if (ret)
 		free_msg(msg_ptr);
@@ -1257,13 +1264,14 @@ static int do_mq_timedreceive(mqd_t mqdes, char __user *u_msg_ptr,
 
 		msg_ptr = msg_get(info);
 
-		inode->i_atime = inode->i_mtime = inode->i_ctime =
-				current_time(inode);
-
 		/* There is now free space in queue. */
 		pipelined_receive(&wake_q, info);
 		spin_unlock(&info->lock);
 		wake_up_q(&wake_q);
+
+		/* As on the send side, no need to hold the lock for this. */
+		inode->i_atime = inode->i_mtime = inode->i_ctime =
+				current_time(inode);
 		ret = 0;
 	}
 	if (ret == 0) {
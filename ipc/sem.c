@@ -902,6 +902,13 @@ static int do_smart_wakeup_zero(struct sem_array *sma, struct sembuf *sops,
 		for (i = 0; i < nsops; i++) {
 			int num = sops[i].sem_num;
 
+			/*
+			 * An increase can never leave the semaphore at
+			 * zero, don't even look at its value.
+			 */
+			if (sops[i].sem_op > 0)
+				continue;
+
 			if (sma->sems[num].semval == 0) {
 				got_zero = 1;
 				semop_completed |= wake_const_ops(sma, num, wake_q);
@@ -1089,6 +1089,103 @@ done:
 	return ndoms;
 }
 
+/*
+ * Private copy of the partition most recently handed to the scheduler,
+ * used to elide rebuilds that would not change any sched domain.  The
+ * scheduler keeps its own copy (doms_cur in kernel/sched/topology.c),
+ * but takes ownership of whatever partition_sched_domains_locked() is
+ * passed, so it cannot be consulted from here without reaching into
+ * scheduler internals.  Protected by cpuset_mutex.
+ */
+static cpumask_var_t *cpuset_doms_cur;
+static struct sched_domain_attr *cpuset_dattr_cur;
+static int cpuset_ndoms_cur;
+static bool cpuset_doms_stale = true;
+
+/*
+ * The cached partition no longer reflects what the scheduler has, e.g.
+ * because the scheduler rebuilt domains on its own across a CPU hotplug
+ * or suspend/resume cycle.  The next rebuild must not be elided.
+ */
+static void invalidate_sched_domains_cache(void)
+{
+	cpuset_doms_stale = true;
+}
+
+static bool sched_domain_attrs_equal(struct sched_domain_attr *a, int ia,
+				     struct sched_domain_attr *b, int ib)
+{
+	struct sched_domain_attr tmp = SD_ATTR_INIT;
+
+	/* A missing attribute array means default attributes throughout */
+	return !memcmp(a ? a + ia : &tmp, b ? b + ib : &tmp, sizeof(tmp));
+}
+
+/*
+ * Does the new partition <ndoms, doms, dattr> describe the same sched
+ * domains as the cached one?  Domains within a partition are mutually
+ * non-overlapping, so with equal counts every match below consumes a
+ * distinct cached domain and the order generate_sched_domains() emitted
+ * them in does not matter.
+ */
+static bool sched_domains_unchanged(int ndoms, cpumask_var_t doms[],
+				    struct sched_domain_attr *dattr)
+{
+	int i, j;
+
+	if (ndoms != cpuset_ndoms_cur)
+		return false;
+
+	for (i = 0; i < ndoms; i++) {
+		for (j = 0; j < ndoms; j++) {
+			if (cpumask_equal(doms[i], cpuset_doms_cur[j]) &&
+			    sched_domain_attrs_equal(dattr, i,
+						     cpuset_dattr_cur, j))
+				break;
+		}
+		if (j == ndoms)
+			return false;
+	}
+	return true;
+}
+
+/*
+ * Remember <ndoms, doms, dattr> for the next sched_domains_unchanged()
+ * comparison.  Must be called before the arrays are handed to the
+ * scheduler, which frees them when it is done.  If the copy cannot be
+ * allocated, just leave the cache stale; the only cost is that the next
+ * rebuild is not elided.
+ */
+static void cache_sched_domains(int ndoms, cpumask_var_t doms[],
+				struct sched_domain_attr *dattr)
+{
+	int i;
+
+	free_sched_domains(cpuset_doms_cur, cpuset_ndoms_cur);
+	kfree(cpuset_dattr_cur);
+	cpuset_dattr_cur = NULL;
+
+	cpuset_doms_cur = alloc_sched_domains(ndoms);
+	cpuset_ndoms_cur = cpuset_doms_cur ? ndoms : 0;
+	if (!cpuset_doms_cur) {
+		cpuset_doms_stale = true;
+		return;
+	}
+
+	for (i = 0; i < ndoms; i++)
+		cpumask_copy(cpuset_doms_cur[i], doms[i]);
+
+	if (dattr) {
+		cpuset_dattr_cur = kmemdup(dattr, ndoms * sizeof(*dattr),
+					   GFP_KERNEL);
+		if (!cpuset_dattr_cur) {
+			cpuset_doms_stale = true;
+			return;
+		}
+	}
+	cpuset_doms_stale = false;
+}
+
 static void dl_update_tasks_root_domain(struct cpuset *cs)
 {
 	struct css_task_iter it;
@@ -1210,6 +1307,33 @@ static void rebuild_sched_domains_locked(void)
 	/* Generate domain masks and attrs */
 	ndoms = generate_sched_domains(&doms, &attr);
 
+	/*
+	 * Cpusets are reconfigured far more often than the effective
+	 * partition actually changes.  The scheduler already limits the
+	 * rebuild to domains that differ from the ones it has, but it
+	 * still walks every root domain's deadline accounting under
+	 * sched_domains_mutex even when nothing differs.  If the freshly
+	 * generated partition matches the cached one, drop it here and
+	 * leave the scheduler alone.
+	 *
+	 * Identical masks must still be rebuilt when the topology
+	 * changed underneath them.  arch_update_cpu_topology() is a
+	 * non-consuming peek at the pending-update flag in the generic
+	 * arch_topology implementation; partition_sched_domains_locked()
+	 * reads the same flag to force its own full rebuild.
+	 */
+	if (doms && !cpuset_doms_stale && !arch_update_cpu_topology() &&
+	    sched_domains_unchanged(ndoms, doms, attr)) {
+		free_sched_domains(doms, ndoms);
+		kfree(attr);
+		return;
+	}
+
+	if (doms)
+		cache_sched_domains(ndoms, doms, attr);
+	else
+		cpuset_doms_stale = true;
+
 	/* Have scheduler rebuild the domains */
 	partition_and_rebuild_sched_domains(ndoms, doms, attr);
 }
@@ -1217,12 +1341,27 @@ static void rebuild_sched_domains_locked(void)
 static void rebuild_sched_domains_locked(void)
 {
 }
+
+static void invalidate_sched_domains_cache(void)
+{
+}
 #endif /* CONFIG_SMP */
 
 void rebuild_sched_domains(void)
 {
 	cpus_read_lock();
 	mutex_lock(&cpuset_mutex);
+	/*
+	 * Outside callers - update_topology_flags_workfn(),
+	 * rebuild_sched_domains_energy(), the hotplug work function -
+	 * enter here precisely because the world changed underneath
+	 * unchanged cpumasks (topology flags, a pending energy model
+	 * update), so the elision in rebuild_sched_domains_locked()
+	 * must not apply to them.  Cpuset-internal reconfiguration,
+	 * where mask equality does imply an unchanged partition, calls
+	 * the locked variant directly and keeps the elision.
+	 */
+	invalidate_sched_domains_cache();
 	rebuild_sched_domains_locked();
 	mutex_unlock(&cpuset_mutex);
 	cpus_read_unlock();
@@ -3578,6 +3717,7 @@ static bool force_rebuild;
 
 void cpuset_force_rebuild(void)
 {
+	invalidate_sched_domains_cache();
 	force_rebuild = true;
 }
 
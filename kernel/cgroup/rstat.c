@@ -49,6 +49,7 @@ void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
 		struct cgroup_rstat_cpu *rstatc = cgroup_rstat_cpu(cgrp, cpu);
 		struct cgroup *parent = cgroup_parent(cgrp);
 		struct cgroup_rstat_cpu *prstatc;
+		struct cgroup *pos;
 
 		/*
 		 * Both additions and removals are bottom-up.  If a cgroup
@@ -60,6 +61,7 @@ void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
 		/* Root has no parent to link it to, but mark it busy */
 		if (!parent) {
 			rstatc->updated_next = cgrp;
+			atomic_inc(&cgrp->rstat_pending);
 			break;
 		}
 
@@ -67,6 +69,10 @@ void cgroup_rstat_updated(struct cgroup *cgrp, int cpu)
 		rstatc->updated_next = prstatc->updated_children;
 		prstatc->updated_children = cgrp;
 
+		/* newly pending cgroup/cpu pair, count it in every subtree */
+		for (pos = cgrp; pos; pos = cgroup_parent(pos))
+			atomic_inc(&pos->rstat_pending);
+
 		cgrp = parent;
 	}
 
@@ -142,6 +148,11 @@ static struct cgroup *cgroup_rstat_cpu_pop_updated(struct cgroup *pos,
 	}
 
 	rstatc->updated_next = NULL;
+
+	/* no longer pending, drop it from every subtree it was counted in */
+	for (parent = pos; parent; parent = cgroup_parent(parent))
+		atomic_dec(&parent->rstat_pending);
+
 	return pos;
 }
 
@@ -240,6 +251,31 @@ void cgroup_rstat_flush(struct cgroup *cgrp)
 	spin_unlock_irq(&cgroup_rstat_lock);
 }
 
+/**
+ * cgroup_rstat_flush_nowait - best-effort flush of @cgrp's subtree
+ * @cgrp: target cgroup
+ * @threshold: number of pending cgroup/cpu pairs worth a flush
+ *
+ * Opportunistic counterpart of cgroup_rstat_flush() for readers which can
+ * tolerate slightly stale aggregates.  The flush is skipped when no more
+ * than @threshold cgroup/cpu pairs in the subtree carry pending deltas,
+ * and rather than queueing on cgroup_rstat_lock behind another flusher,
+ * the caller is sent away with whatever that flusher aggregated.
+ *
+ * Returns %true if the subtree was flushed.
+ */
+bool cgroup_rstat_flush_nowait(struct cgroup *cgrp, unsigned int threshold)
+{
+	if (atomic_read(&cgrp->rstat_pending) <= threshold)
+		return false;
+
+	if (!spin_trylock_irq(&cgroup_rstat_lock))
+		return false;
+	cgroup_rstat_flush_locked(cgrp, false);
+	spin_unlock_irq(&cgroup_rstat_lock);
+	return true;
+}
+
 /**
  * cgroup_rstat_flush_irqsafe - irqsafe version of cgroup_rstat_flush()
  * @cgrp: target cgroup
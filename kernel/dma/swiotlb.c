@@ -35,8 +35,10 @@
 #include <linux/memblock.h>
 #include <linux/mm.h>
 #include <linux/pfn.h>
+#include <linux/rculist.h>
 #include <linux/scatterlist.h>
 #include <linux/set_memory.h>
+#include <linux/slab.h>
 #include <linux/spinlock.h>
 #include <linux/string.h>
 #include <linux/swiotlb.h>
@@ -45,7 +47,6 @@
 #include <linux/of.h>
 #include <linux/of_fdt.h>
 #include <linux/of_reserved_mem.h>
-#include <linux/slab.h>
 #endif
 
 #define CREATE_TRACE_POINTS
@@ -62,6 +63,9 @@
 
 #define INVALID_PHYS_ADDR (~(phys_addr_t)0)
 
+/* minimum size of an extra pool segment grown at runtime, see swiotlb_grow() */
+#define IO_TLB_GROW_SIZE (4UL << 20)
+
 struct io_tlb_slot {
 	phys_addr_t orig_addr;
 	size_t alloc_size;
@@ -297,6 +301,8 @@ static void swiotlb_init_io_tlb_mem(struct io_tlb_mem *mem, phys_addr_t start,
 	mem->late_alloc = late_alloc;
 	mem->nareas = nareas;
 	mem->area_nslabs = nslabs / mem->nareas;
+	INIT_LIST_HEAD(&mem->pools);
+	spin_lock_init(&mem->pools_lock);
 
 	mem->force_bounce = swiotlb_force_bounce || (flags & SWIOTLB_FORCE);
 
@@ -409,6 +415,8 @@ void __init swiotlb_init_remap(bool addressing_limit, unsigned int flags,
 
 	swiotlb_init_io_tlb_mem(mem, __pa(tlb), nslabs, flags, false,
 				default_nareas);
+	/* the default pool may be grown on demand, see swiotlb_grow() */
+	mem->can_grow = true;
 
 	if (flags & SWIOTLB_VERBOSE)
 		swiotlb_print_info();
@@ -491,6 +499,7 @@ retry:
 			     (nslabs << IO_TLB_SHIFT) >> PAGE_SHIFT);
 	swiotlb_init_io_tlb_mem(mem, virt_to_phys(vstart), nslabs, 0, true,
 				nareas);
+	mem->can_grow = true;
 
 	swiotlb_print_info();
 	return 0;
@@ -545,13 +554,42 @@ static unsigned int swiotlb_align_offset(struct device *dev, u64 addr)
 	return addr & dma_get_min_align_mask(dev) & (IO_TLB_SIZE - 1);
 }
 
+/**
+ * swiotlb_find_pool - find the IO TLB pool containing a physical address
+ * @dev:	Device which has mapped the buffer.
+ * @paddr:	Physical address within the bounce buffer.
+ *
+ * Return the pool owning @paddr, i.e. either the device's main pool or one
+ * of the segments grown from it at runtime, or %NULL if @paddr does not
+ * belong to any of them.
+ */
+struct io_tlb_mem *swiotlb_find_pool(struct device *dev, phys_addr_t paddr)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *pool;
+
+	if (paddr >= mem->start && paddr < mem->end)
+		return mem;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node) {
+		if (paddr >= pool->start && paddr < pool->end)
+			goto out;
+	}
+	pool = NULL;
+out:
+	rcu_read_unlock();
+	return pool;
+}
+EXPORT_SYMBOL_GPL(swiotlb_find_pool);
+
 /*
  * Bounce: copy the swiotlb buffer from or back to the original dma location
  */
 static void swiotlb_bounce(struct device *dev, phys_addr_t tlb_addr, size_t size,
 			   enum dma_data_direction dir)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *mem = swiotlb_find_pool(dev, tlb_addr);
 	int index = (tlb_addr - mem->start) >> IO_TLB_SHIFT;
 	phys_addr_t orig_addr = mem->slots[index].orig_addr;
 	size_t alloc_size = mem->slots[index].alloc_size;
@@ -644,11 +682,10 @@ static unsigned int wrap_area_index(struct io_tlb_mem *mem, unsigned int index)
  * Find a suitable number of IO TLB entries size that will fit this request and
  * allocate a buffer from that IO TLB pool.
  */
-static int swiotlb_do_find_slots(struct device *dev, int area_index,
-		phys_addr_t orig_addr, size_t alloc_size,
+static int swiotlb_do_find_slots(struct io_tlb_mem *mem, struct device *dev,
+		int area_index, phys_addr_t orig_addr, size_t alloc_size,
 		unsigned int alloc_align_mask)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 	struct io_tlb_area *area = mem->areas + area_index;
 	unsigned long boundary_mask = dma_get_seg_boundary(dev);
 	dma_addr_t tbl_dma_addr =
@@ -734,23 +771,117 @@ found:
 	return slot_index;
 }
 
+/*
+ * Grow the bounce capacity of @dev's pool by one segment allocated from the
+ * page allocator. Called when all pools are exhausted. The new segment is
+ * published with RCU so that concurrent lookups only ever see it fully
+ * initialized, and it stays around for the lifetime of the parent pool.
+ */
+static struct io_tlb_mem *swiotlb_grow(struct device *dev, size_t alloc_size)
+{
+	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	unsigned long nslabs = max(IO_TLB_GROW_SIZE >> IO_TLB_SHIFT,
+				   (unsigned long)nr_slots(alloc_size));
+	u64 phys_limit = min_not_zero(dma_get_mask(dev), dev->bus_dma_limit);
+	gfp_t gfp = GFP_NOWAIT | __GFP_NOWARN;
+	struct io_tlb_mem *pool;
+	struct page *tlb = NULL;
+	unsigned int order;
+	unsigned long flags;
+
+	if (!mem->can_grow)
+		return NULL;
+
+	/* growing cannot honour remapping or memory encryption */
+	if (cc_platform_has(CC_ATTR_MEM_ENCRYPT) || swiotlb_unencrypted_base)
+		return NULL;
+
+	order = get_order(nslabs << IO_TLB_SHIFT);
+	nslabs = SLABS_PER_PAGE << order;
+
+	/* the zone modifier is a preference, the result is checked below */
+	if (phys_limit <= DMA_BIT_MASK(zone_dma_bits))
+		gfp |= __GFP_DMA;
+	else if (phys_limit <= DMA_BIT_MASK(32))
+		gfp |= __GFP_DMA32;
+
+	pool = kzalloc(sizeof(*pool), gfp);
+	if (!pool)
+		return NULL;
+
+	pool->slots = kcalloc(nslabs, sizeof(*pool->slots), gfp);
+	pool->areas = kcalloc(1, sizeof(*pool->areas), gfp);
+	tlb = alloc_pages(gfp, order);
+	if (!pool->slots || !pool->areas || !tlb)
+		goto free;
+
+	if (page_to_phys(tlb) + (nslabs << IO_TLB_SHIFT) - 1 > phys_limit)
+		goto free;
+
+	swiotlb_init_io_tlb_mem(pool, page_to_phys(tlb), nslabs, 0, true, 1);
+
+	spin_lock_irqsave(&mem->pools_lock, flags);
+	list_add_rcu(&pool->node, &mem->pools);
+	mem->extra_nslabs += nslabs;
+	WRITE_ONCE(mem->has_pools, true);
+	spin_unlock_irqrestore(&mem->pools_lock, flags);
+
+	dev_info(dev, "grew swiotlb pool by %lu slabs (%lu extra total)\n",
+		 nslabs, mem->extra_nslabs);
+	return pool;
+
+free:
+	if (tlb)
+		__free_pages(tlb, order);
+	kfree(pool->areas);
+	kfree(pool->slots);
+	kfree(pool);
+	return NULL;
+}
+
 static int swiotlb_find_slots(struct device *dev, phys_addr_t orig_addr,
-		size_t alloc_size, unsigned int alloc_align_mask)
+		size_t alloc_size, unsigned int alloc_align_mask,
+		struct io_tlb_mem **retpool)
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *pool;
 	int start = raw_smp_processor_id() & (mem->nareas - 1);
 	int i = start, index;
 
 	do {
-		index = swiotlb_do_find_slots(dev, i, orig_addr, alloc_size,
-					      alloc_align_mask);
-		if (index >= 0)
+		index = swiotlb_do_find_slots(mem, dev, i, orig_addr,
+					      alloc_size, alloc_align_mask);
+		if (index >= 0) {
+			*retpool = mem;
 			return index;
+		}
 		if (++i >= mem->nareas)
 			i = 0;
 	} while (i != start);
 
-	return -1;
+	/* the main pool is exhausted, search the grown segments */
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node) {
+		index = swiotlb_do_find_slots(pool, dev, 0, orig_addr,
+					      alloc_size, alloc_align_mask);
+		if (index >= 0) {
+			rcu_read_unlock();
+			*retpool = pool;
+			return index;
+		}
+	}
+	rcu_read_unlock();
+
+	/* everything is full, try growing by another segment */
+	pool = swiotlb_grow(dev, alloc_size);
+	if (!pool)
+		return -1;
+
+	index = swiotlb_do_find_slots(pool, dev, 0, orig_addr, alloc_size,
+				      alloc_align_mask);
+	if (index >= 0)
+		*retpool = pool;
+	return index;
 }
 
 static unsigned long mem_used(struct io_tlb_mem *mem)
@@ -770,6 +901,7 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 {
 	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
 	unsigned int offset = swiotlb_align_offset(dev, orig_addr);
+	struct io_tlb_mem *pool;
 	unsigned int i;
 	int index;
 	phys_addr_t tlb_addr;
@@ -790,7 +922,8 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 	}
 
 	index = swiotlb_find_slots(dev, orig_addr,
-				   alloc_size + offset, alloc_align_mask);
+				   alloc_size + offset, alloc_align_mask,
+				   &pool);
 	if (index == -1) {
 		if (!(attrs & DMA_ATTR_NO_WARN))
 			dev_warn_ratelimited(dev,
@@ -805,8 +938,8 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 	 * needed.
 	 */
 	for (i = 0; i < nr_slots(alloc_size + offset); i++)
-		mem->slots[index + i].orig_addr = slot_addr(orig_addr, i);
-	tlb_addr = slot_addr(mem->start, index) + offset;
+		pool->slots[index + i].orig_addr = slot_addr(orig_addr, i);
+	tlb_addr = slot_addr(pool->start, index) + offset;
 	/*
 	 * When dir == DMA_FROM_DEVICE we could omit the copy from the orig
 	 * to the tlb buffer, if we knew for sure the device will
@@ -820,7 +953,7 @@ phys_addr_t swiotlb_tbl_map_single(struct device *dev, phys_addr_t orig_addr,
 
 static void swiotlb_release_slots(struct device *dev, phys_addr_t tlb_addr)
 {
-	struct io_tlb_mem *mem = dev->dma_io_tlb_mem;
+	struct io_tlb_mem *mem = swiotlb_find_pool(dev, tlb_addr);
 	unsigned long flags;
 	unsigned int offset = swiotlb_align_offset(dev, tlb_addr);
 	int index = (tlb_addr - offset - mem->start) >> IO_TLB_SHIFT;
@@ -966,6 +1099,22 @@ static int io_tlb_used_get(void *data, u64 *val)
 }
 DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_used, io_tlb_used_get, NULL, "%llu\n");
 
+static int io_tlb_extra_used_get(void *data, u64 *val)
+{
+	struct io_tlb_mem *mem = data, *pool;
+	unsigned long used = 0;
+
+	rcu_read_lock();
+	list_for_each_entry_rcu(pool, &mem->pools, node)
+		used += mem_used(pool);
+	rcu_read_unlock();
+
+	*val = used;
+	return 0;
+}
+DEFINE_DEBUGFS_ATTRIBUTE(fops_io_tlb_extra_used, io_tlb_extra_used_get, NULL,
+			 "%llu\n");
+
 static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 					 const char *dirname)
 {
@@ -976,6 +1125,10 @@ static void swiotlb_create_debugfs_files(struct io_tlb_mem *mem,
 	debugfs_create_ulong("io_tlb_nslabs", 0400, mem->debugfs, &mem->nslabs);
 	debugfs_create_file("io_tlb_used", 0400, mem->debugfs, mem,
 			&fops_io_tlb_used);
+	debugfs_create_ulong("io_tlb_extra_nslabs", 0400, mem->debugfs,
+			&mem->extra_nslabs);
+	debugfs_create_file("io_tlb_extra_used", 0400, mem->debugfs, mem,
+			&fops_io_tlb_extra_used);
 }
 
 static int __init __maybe_unused swiotlb_create_default_debugfs(void)
@@ -999,7 +1152,7 @@ struct page *swiotlb_alloc(struct device *dev, size_t size)
 	if (!mem)
 		return NULL;
 
-	index = swiotlb_find_slots(dev, 0, size, 0);
+	index = swiotlb_find_slots(dev, 0, size, 0, &mem);
 	if (index == -1)
 		return NULL;
 
@@ -191,7 +191,17 @@ __perf_output_begin(struct perf_output_handle *handle,
 
 	perf_output_get_handle(handle);
 
-	do {
+	if (rb->overwrite && !backward) {
+		/*
+		 * In overwrite mode there is no space check against the
+		 * consumer, so the head can be advanced with a single
+		 * local_add_return() instead of the cmpxchg retry loop
+		 * below. This is the common case for continuous profiling
+		 * with high sampling rates.
+		 */
+		head = local_add_return(size, &rb->head);
+		offset = head - size;
+	} else do {
 		tail = READ_ONCE(rb->user_page->data_tail);
 		offset = head = local_read(&rb->head);
 		if (!rb->overwrite) {
@@ -225,8 +235,9 @@ __perf_output_begin(struct perf_output_handle *handle,
 	}
 
 	/*
-	 * We rely on the implied barrier() by local_cmpxchg() to ensure
-	 * none of the data stores below can be lifted up by the compiler.
+	 * We rely on the implied barrier() by local_cmpxchg() (or
+	 * local_add_return() on the overwrite path) to ensure none of the
+	 * data stores below can be lifted up by the compiler.
 	 */
 
 	if (unlikely(head - local_read(&rb->wakeup) > rb->watermark))
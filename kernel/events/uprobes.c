@@ -1700,11 +1700,18 @@ unsigned long uprobe_get_trap_addr(struct pt_regs *regs)
 	return instruction_pointer(regs);
 }
 
+/*
+ * A return_instance is allocated and freed on every call to and return
+ * from a uretprobed function, so give it its own cache instead of going
+ * through the kmalloc size classes.
+ */
+static struct kmem_cache *return_instance_cache __ro_after_init;
+
 static struct return_instance *free_ret_instance(struct return_instance *ri)
 {
 	struct return_instance *next = ri->next;
 	put_uprobe(ri->uprobe);
-	kfree(ri);
+	kmem_cache_free(return_instance_cache, ri);
 	return next;
 }
 
@@ -1759,7 +1766,7 @@ static int dup_utask(struct task_struct *t, struct uprobe_task *o_utask)
 
 	p = &n_utask->return_instances;
 	for (o = o_utask->return_instances; o; o = o->next) {
-		n = kmalloc(sizeof(struct return_instance), GFP_KERNEL);
+		n = kmem_cache_alloc(return_instance_cache, GFP_KERNEL);
 		if (!n)
 			return -ENOMEM;
 
@@ -1877,7 +1884,7 @@ static void prepare_uretprobe(struct uprobe *uprobe, struct pt_regs *regs)
 		return;
 	}
 
-	ri = kmalloc(sizeof(struct return_instance), GFP_KERNEL);
+	ri = kmem_cache_alloc(return_instance_cache, GFP_KERNEL);
 	if (!ri)
 		return;
 
@@ -1919,7 +1926,7 @@ static void prepare_uretprobe(struct uprobe *uprobe, struct pt_regs *regs)
 
 	return;
  fail:
-	kfree(ri);
+	kmem_cache_free(return_instance_cache, ri);
 }
 
 /* Prepare to single-step probed instruction out of line. */
@@ -2355,5 +2362,7 @@ void __init uprobes_init(void)
 	for (i = 0; i < UPROBES_HASH_SZ; i++)
 		mutex_init(&uprobes_mmap_mutex[i]);
 
+	return_instance_cache = KMEM_CACHE(return_instance, SLAB_PANIC);
+
 	BUG_ON(register_die_notifier(&uprobe_exception_nb));
 }
@@ -36,6 +36,8 @@
 #include <linux/pagemap.h>
 #include <linux/memblock.h>
 #include <linux/fault-inject.h>
+#include <linux/prctl.h>
+#include <linux/sched/signal.h>
 #include <linux/slab.h>
 
 #include "futex.h"
@@ -106,20 +108,110 @@ late_initcall(fail_futex_debugfs);
 #endif /* CONFIG_FAIL_FUTEX */
 
 /**
- * futex_hash - Return the hash bucket in the global hash
+ * futex_hash - Return the hash bucket for a futex key
  * @key:	Pointer to the futex key for which the hash is calculated
  *
  * We hash on the keys returned from get_futex_key (see below) and return the
- * corresponding hash bucket in the global hash.
+ * corresponding hash bucket. Private keys of a process which installed its
+ * own hash via prctl(PR_FUTEX_HASH) resolve to that process private bucket
+ * array, everything else goes to the global hash.
  */
 struct futex_hash_bucket *futex_hash(union futex_key *key)
 {
 	u32 hash = jhash2((u32 *)key, offsetof(typeof(*key), both.offset) / 4,
 			  key->both.offset);
 
+	if (!(key->both.offset & (FUT_OFF_INODE | FUT_OFF_MMSHARED))) {
+		struct futex_private_hash *fph;
+
+		/* Pairs with smp_store_release() in futex_hash_allocate() */
+		fph = smp_load_acquire(&key->private.mm->futex_phash);
+		if (fph)
+			return &fph->queues[hash & fph->hash_mask];
+	}
 	return &futex_queues[hash & (futex_hashsize - 1)];
 }
 
+/*
+ * Upper limit for a process private hash, same order as the default global
+ * hash size. Mostly there to bound the allocation, a process with enough
+ * threads to saturate this is better off with the global hash anyway.
+ */
+#define FUTEX_PRIVATE_HASH_MAX	(256 * 1024)
+
+static int futex_hash_allocate(unsigned int slots)
+{
+	struct mm_struct *mm = current->mm;
+	struct futex_private_hash *fph;
+	unsigned int i;
+
+	if (slots > FUTEX_PRIVATE_HASH_MAX)
+		return -EINVAL;
+
+	/*
+	 * Default to four buckets per thread so that the common case of
+	 * one waiter per futex rarely shares a bucket.
+	 */
+	if (!slots)
+		slots = 4 * get_nr_threads(current);
+	slots = roundup_pow_of_two(slots);
+
+	/*
+	 * The hash is immutable once published and other threads walk the
+	 * global hash without any means to redirect them, so only a single
+	 * threaded process may install one. Waiters queued on the global
+	 * hash before the switch would otherwise never be woken, as the
+	 * waker side would hash into the private buckets.
+	 */
+	if (atomic_read(&mm->mm_users) != 1 || get_nr_threads(current) != 1)
+		return -EBUSY;
+	if (mm->futex_phash)
+		return -EBUSY;
+
+	fph = kvzalloc(struct_size(fph, queues, slots), GFP_KERNEL_ACCOUNT);
+	if (!fph)
+		return -ENOMEM;
+
+	fph->hash_mask = slots - 1;
+	for (i = 0; i < slots; i++) {
+		atomic_set(&fph->queues[i].waiters, 0);
+		plist_head_init(&fph->queues[i].chain);
+		spin_lock_init(&fph->queues[i].lock);
+	}
+	/* Pairs with smp_load_acquire() in futex_hash() */
+	smp_store_release(&mm->futex_phash, fph);
+	return 0;
+}
+
+static int futex_hash_get_slots(void)
+{
+	struct futex_private_hash *fph;
+
+	fph = smp_load_acquire(&current->mm->futex_phash);
+	if (fph)
+		return fph->hash_mask + 1;
+	return 0;
+}
+
+int futex_hash_prctl(unsigned long arg2, unsigned long arg3)
+{
+	switch (arg2) {
+	case PR_FUTEX_HASH_SET_SLOTS:
+		return futex_hash_allocate(arg3);
+	case PR_FUTEX_HASH_GET_SLOTS:
+		if (arg3)
+			return -EINVAL;
+		return futex_hash_get_slots();
+	default:
+		return -EINVAL;
+	}
+}
+
+void futex_hash_free(struct mm_struct *mm)
+{
+	kvfree(mm->futex_phash);
+}
+
 
 /**
  * futex_setup_timer - set up the sleeping hrtimer.
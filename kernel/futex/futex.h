@@ -48,6 +48,15 @@ struct futex_hash_bucket {
 	struct plist_head chain;
 } ____cacheline_aligned_in_smp;
 
+/*
+ * Process private hash bucket array, installed via prctl(PR_FUTEX_HASH).
+ * Immutable once published in mm->futex_phash, freed with the mm.
+ */
+struct futex_private_hash {
+	unsigned int		hash_mask;
+	struct futex_hash_bucket queues[];
+};
+
 /*
  * Priority Inheritance state:
  */
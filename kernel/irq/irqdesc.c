@@ -283,6 +283,74 @@ static struct kobj_type irq_kobj_type = {
 	.default_groups = irq_groups,
 };
 
+/*
+ * Record layout of the /sys/kernel/irq/snapshot binary file. One record
+ * per allocated interrupt, native endianness. @delta is the increment
+ * since the previous read of the file, computed kernel side, so the file
+ * is meant for a single monitoring consumer. Readers should fetch the
+ * whole file with one large read; short reads splitting a record can
+ * observe the fields of that record from two different samples.
+ */
+struct irq_snapshot {
+	u32 irq;
+	u32 reserved;
+	u64 total;
+	u64 delta;
+};
+
+static unsigned int kstat_irqs(unsigned int irq);
+
+static ssize_t snapshot_read(struct file *file, struct kobject *kobj,
+			     struct bin_attribute *bin_attr, char *buf,
+			     loff_t off, size_t count)
+{
+	struct irq_desc *desc;
+	loff_t pos = 0;
+	size_t ret = 0;
+	int irq;
+
+	/*
+	 * The descriptors are protected by rcu, see kstat_irqs_usr().
+	 * Neither sparse_irq_lock nor any descriptor lock is taken, so
+	 * scraping the counters does not perturb the interrupt path.
+	 */
+	rcu_read_lock();
+	for_each_irq_desc(irq, desc) {
+		struct irq_snapshot rec;
+		unsigned int total;
+		size_t skip, len;
+
+		if (!desc->kstat_irqs)
+			continue;
+
+		if (pos + sizeof(rec) <= off) {
+			pos += sizeof(rec);
+			continue;
+		}
+		if (ret >= count)
+			break;
+
+		total = kstat_irqs(irq);
+		rec.irq = irq;
+		rec.reserved = 0;
+		rec.total = total;
+		rec.delta = total - data_race(desc->snap_count);
+
+		skip = off > pos ? off - pos : 0;
+		if (!skip)
+			WRITE_ONCE(desc->snap_count, total);
+
+		len = min(sizeof(rec) - skip, count - ret);
+		memcpy(buf + ret, (char *)&rec + skip, len);
+		ret += len;
+		pos += sizeof(rec);
+	}
+	rcu_read_unlock();
+
+	return ret;
+}
+static BIN_ATTR_RO(snapshot, 0);
+
 static void irq_sysfs_add(int irq, struct irq_desc *desc)
 {
 	if (irq_kobj_base) {
@@ -324,6 +392,9 @@ static int __init irq_sysfs_init(void)
 		return -ENOMEM;
 	}
 
+	if (sysfs_create_bin_file(irq_kobj_base, &bin_attr_snapshot))
+		pr_warn("Failed to create the irq snapshot file\n");
+
 	/* Add the already allocated interrupts */
 	for_each_irq_desc(irq, desc)
 		irq_sysfs_add(irq, desc);
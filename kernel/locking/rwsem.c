@@ -326,6 +326,7 @@ void __init_rwsem(struct rw_semaphore *sem, const char *name,
 	atomic_long_set(&sem->count, RWSEM_UNLOCKED_VALUE);
 	raw_spin_lock_init(&sem->wait_lock);
 	INIT_LIST_HEAD(&sem->wait_list);
+	sem->rbias = 0;
 	atomic_long_set(&sem->owner, 0L);
 #ifdef CONFIG_RWSEM_SPIN_ON_OWNER
 	osq_lock_init(&sem->osq);
@@ -997,6 +998,29 @@ static inline void rwsem_cond_wake_waiter(struct rw_semaphore *sem, long count,
 	rwsem_mark_wake(sem, wake_type, wake_q);
 }
 
+/*
+ * With the wait queue non-empty on a reader-biased rwsem, readers may
+ * keep stealing only while the head waiter is within its handoff
+ * timeout.  A sleeping writer at the head only evaluates its timeout in
+ * rwsem_try_write_lock(), which it reaches when woken - and it is only
+ * woken once the reader count drains to zero, which continuous stealing
+ * would prevent from ever happening.  So the steal path has to police
+ * the timeout on the writer's behalf.  The head waiter lives on the
+ * waiting task's stack; it may only be examined under wait_lock.
+ */
+static bool rwsem_rbias_steal_expired(struct rw_semaphore *sem)
+{
+	bool expired = false;
+
+	raw_spin_lock_irq(&sem->wait_lock);
+	if (!list_empty(&sem->wait_list) &&
+	    time_after(jiffies, rwsem_first_waiter(sem)->timeout))
+		expired = true;
+	raw_spin_unlock_irq(&sem->wait_lock);
+
+	return expired;
+}
+
 /*
  * Wait for the read lock to be granted
  */
@@ -1011,9 +1035,16 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	/*
 	 * To prevent a constant stream of readers from starving a sleeping
 	 * waiter, don't attempt optimistic lock stealing if the lock is
-	 * currently owned by readers.
+	 * currently owned by readers. Reader-biased rwsems keep stealing
+	 * past queued waiters, but only until the head waiter's handoff
+	 * timeout expires: from then on arriving readers queue behind it,
+	 * the reader count drains, and the wakeup on the last read unlock
+	 * hands the lock over, bounding the writer wait as advertised.
 	 */
-	if ((atomic_long_read(&sem->owner) & RWSEM_READER_OWNED) &&
+	if (READ_ONCE(sem->rbias)) {
+		if ((count & RWSEM_FLAG_WAITERS) && rwsem_rbias_steal_expired(sem))
+			goto queue;
+	} else if ((atomic_long_read(&sem->owner) & RWSEM_READER_OWNED) &&
 	    (rcnt > 1) && !(count & RWSEM_WRITER_LOCKED))
 		goto queue;
 
@@ -1023,6 +1054,7 @@ rwsem_down_read_slowpath(struct rw_semaphore *sem, long count, unsigned int stat
 	if (!(count & (RWSEM_WRITER_LOCKED | RWSEM_FLAG_HANDOFF))) {
 		rwsem_set_reader_owned(sem);
 		lockevent_inc(rwsem_rlock_steal);
+		lockevent_cond_inc(rwsem_rbias_steal, READ_ONCE(sem->rbias));
 
 		/*
 		 * Wake up other readers in the wait queue if it is
@@ -1118,8 +1150,10 @@ rwsem_down_write_slowpath(struct rw_semaphore *sem, int state)
 	DEFINE_WAKE_Q(wake_q);
 
 	/* do optimistic spinning and steal lock if possible */
+	trace_contention_begin(sem, LCB_F_WRITE | LCB_F_SPIN);
 	if (rwsem_can_spin_on_owner(sem) && rwsem_optimistic_spin(sem)) {
 		/* rwsem_optimistic_spin() implies ACQUIRE on success */
+		trace_contention_end(sem, 0);
 		return sem;
 	}
 
@@ -54,6 +54,7 @@
 #include <linux/dynamic_debug.h>
 #include <linux/audit.h>
 #include <linux/cfi.h>
+#include <linux/workqueue.h>
 #include <uapi/linux/module.h>
 #include "internal.h"
 
@@ -1354,35 +1355,136 @@ static int simplify_symbols(struct module *mod, const struct load_info *info)
 	return ret;
 }
 
+static bool reloc_section_applicable(const struct load_info *info,
+				     unsigned int relsec)
+{
+	unsigned int infosec = info->sechdrs[relsec].sh_info;
+
+	/* Not a valid relocation section? */
+	if (infosec >= info->hdr->e_shnum)
+		return false;
+
+	/* Don't bother with non-allocated sections */
+	if (!(info->sechdrs[infosec].sh_flags & SHF_ALLOC))
+		return false;
+
+	return true;
+}
+
+static int apply_relocations_in_section(struct module *mod,
+					const struct load_info *info,
+					unsigned int relsec)
+{
+	if (info->sechdrs[relsec].sh_flags & SHF_RELA_LIVEPATCH)
+		return klp_apply_section_relocs(mod, info->sechdrs,
+						info->secstrings,
+						info->strtab,
+						info->index.sym, relsec,
+						NULL);
+	else if (info->sechdrs[relsec].sh_type == SHT_REL)
+		return apply_relocate(info->sechdrs, info->strtab,
+				      info->index.sym, relsec, mod);
+	else if (info->sechdrs[relsec].sh_type == SHT_RELA)
+		return apply_relocate_add(info->sechdrs, info->strtab,
+					  info->index.sym, relsec, mod);
+	return 0;
+}
+
+struct reloc_sec_work {
+	struct work_struct work;
+	struct module *mod;
+	const struct load_info *info;
+	unsigned int relsec;
+	int err;
+};
+
+static void reloc_sec_workfn(struct work_struct *work)
+{
+	struct reloc_sec_work *rw = container_of(work, struct reloc_sec_work,
+						 work);
+
+	rw->err = apply_relocations_in_section(rw->mod, rw->info, rw->relsec);
+}
+
+/*
+ * Threshold, in relocation entries, above which the relocation sections of
+ * a module are applied in parallel on the unbound workqueue. Applying a
+ * handful of relocations is cheaper than the workqueue round trip.
+ */
+#define RELOC_PARALLEL_MIN_ENTRIES	4096
+
+static int apply_relocations_parallel(struct module *mod,
+				      const struct load_info *info)
+{
+	struct reloc_sec_work *works;
+	unsigned int i, nr = 0;
+	int err = 0;
+
+	works = kcalloc(info->hdr->e_shnum, sizeof(*works), GFP_KERNEL);
+	if (!works)
+		return -ENOMEM;
+
+	for (i = 1; i < info->hdr->e_shnum; i++) {
+		if (!reloc_section_applicable(info, i))
+			continue;
+
+		/* Livepatch relocations take klp locks, keep them here. */
+		if (info->sechdrs[i].sh_flags & SHF_RELA_LIVEPATCH) {
+			err = apply_relocations_in_section(mod, info, i);
+			if (err < 0)
+				break;
+			continue;
+		}
+
+		works[nr].mod = mod;
+		works[nr].info = info;
+		works[nr].relsec = i;
+		INIT_WORK(&works[nr].work, reloc_sec_workfn);
+		queue_work(system_unbound_wq, &works[nr].work);
+		nr++;
+	}
+
+	for (i = 0; i < nr; i++) {
+		flush_work(&works[i].work);
+		if (works[i].err < 0 && !err)
+			err = works[i].err;
+	}
+
+	kfree(works);
+	return err;
+}
+
 static int apply_relocations(struct module *mod, const struct load_info *info)
 {
+	unsigned long nr_entries = 0;
 	unsigned int i;
 	int err = 0;
 
-	/* Now do relocations. */
 	for (i = 1; i < info->hdr->e_shnum; i++) {
-		unsigned int infosec = info->sechdrs[i].sh_info;
-
-		/* Not a valid relocation section? */
-		if (infosec >= info->hdr->e_shnum)
+		if (!reloc_section_applicable(info, i))
 			continue;
+		if (info->sechdrs[i].sh_type == SHT_REL)
+			nr_entries += info->sechdrs[i].sh_size / sizeof(Elf_Rel);
+		else if (info->sechdrs[i].sh_type == SHT_RELA)
+			nr_entries += info->sechdrs[i].sh_size / sizeof(Elf_Rela);
+	}
 
-		/* Don't bother with non-allocated sections */
-		if (!(info->sechdrs[infosec].sh_flags & SHF_ALLOC))
+	/*
+	 * Every relocation section patches its own target section, so big
+	 * modules can apply them concurrently on the other CPUs.  Shared
+	 * per-module state that relocations emit into regardless of their
+	 * target section - the riscv .plt/.got sections, for instance -
+	 * must be serialized inside the arch's apply_relocate_add().
+	 */
+	if (nr_entries >= RELOC_PARALLEL_MIN_ENTRIES && num_online_cpus() > 1)
+		return apply_relocations_parallel(mod, info);
+
+	/* Now do relocations. */
+	for (i = 1; i < info->hdr->e_shnum; i++) {
+		if (!reloc_section_applicable(info, i))
 			continue;
 
-		if (info->sechdrs[i].sh_flags & SHF_RELA_LIVEPATCH)
-			err = klp_apply_section_relocs(mod, info->sechdrs,
-						       info->secstrings,
-						       info->strtab,
-						       info->index.sym, i,
-						       NULL);
-		else if (info->sechdrs[i].sh_type == SHT_REL)
-			err = apply_relocate(info->sechdrs, info->strtab,
-					     info->index.sym, i, mod);
-		else if (info->sechdrs[i].sh_type == SHT_RELA)
-			err = apply_relocate_add(info->sechdrs, info->strtab,
-						 info->index.sym, i, mod);
+		err = apply_relocations_in_section(mod, info, i);
 		if (err < 0)
 			break;
 	}
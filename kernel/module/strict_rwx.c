@@ -46,18 +46,27 @@ static void frob_rodata(const struct module_layout *layout,
 		   (layout->ro_size - layout->text_size) >> PAGE_SHIFT);
 }
 
-static void frob_ro_after_init(const struct module_layout *layout,
+/* Text and read-only data are adjacent, frob them with a single call. */
+static void frob_text_and_rodata(const struct module_layout *layout,
 			int (*set_memory)(unsigned long start, int num_pages))
 {
-	set_memory((unsigned long)layout->base + layout->ro_size,
-		   (layout->ro_after_init_size - layout->ro_size) >> PAGE_SHIFT);
+	set_memory((unsigned long)layout->base,
+		   PAGE_ALIGN(layout->ro_size) >> PAGE_SHIFT);
+}
+
+/* Everything past the text is data of some kind, see layout_sections(). */
+static void frob_all_data(const struct module_layout *layout,
+			int (*set_memory)(unsigned long start, int num_pages))
+{
+	set_memory((unsigned long)layout->base + layout->text_size,
+		   (layout->size - layout->text_size) >> PAGE_SHIFT);
 }
 
-static void frob_writable_data(const struct module_layout *layout,
+static void frob_ro_after_init(const struct module_layout *layout,
 			int (*set_memory)(unsigned long start, int num_pages))
 {
-	set_memory((unsigned long)layout->base + layout->ro_after_init_size,
-		   (layout->size - layout->ro_after_init_size) >> PAGE_SHIFT);
+	set_memory((unsigned long)layout->base + layout->ro_size,
+		   (layout->ro_after_init_size - layout->ro_size) >> PAGE_SHIFT);
 }
 
 static bool layout_check_misalignment(const struct module_layout *layout)
@@ -103,8 +112,13 @@ void module_enable_ro(const struct module *mod, bool after_init)
 	frob_text(&mod->core_layout, set_memory_ro);
 
 	frob_rodata(&mod->data_layout, set_memory_ro);
-	frob_text(&mod->init_layout, set_memory_ro);
-	frob_rodata(&mod->init_layout, set_memory_ro);
+	/*
+	 * Init text and rodata are adjacent (init_layout has
+	 * ro_after_init_size == ro_size), so one call covers both and the
+	 * page table update plus TLB flush is paid once instead of per
+	 * section.
+	 */
+	frob_text_and_rodata(&mod->init_layout, set_memory_ro);
 
 	if (after_init)
 		frob_ro_after_init(&mod->data_layout, set_memory_ro);
@@ -115,11 +129,13 @@ void module_enable_nx(const struct module *mod)
 	if (!IS_ENABLED(CONFIG_STRICT_MODULE_RWX))
 		return;
 
-	frob_rodata(&mod->data_layout, set_memory_nx);
-	frob_ro_after_init(&mod->data_layout, set_memory_nx);
-	frob_writable_data(&mod->data_layout, set_memory_nx);
-	frob_rodata(&mod->init_layout, set_memory_nx);
-	frob_writable_data(&mod->init_layout, set_memory_nx);
+	/*
+	 * The rodata, ro-after-init and writable regions of each layout are
+	 * contiguous, so batch the transition into one call per layout
+	 * rather than one TLB flush per section.
+	 */
+	frob_all_data(&mod->data_layout, set_memory_nx);
+	frob_all_data(&mod->init_layout, set_memory_nx);
 }
 
 int module_enforce_rwx_sections(Elf_Ehdr *hdr, Elf_Shdr *sechdrs,
@@ -12,6 +12,7 @@
 #define pr_fmt(fmt) "PM: hibernation: " fmt
 
 #include <linux/export.h>
+#include <linux/moduleparam.h>
 #include <linux/suspend.h>
 #include <linux/reboot.h>
 #include <linux/string.h>
@@ -38,6 +39,13 @@
 
 static int nocompress;
 static int noresume;
+/*
+ * Compression algorithm for the hibernation image ("lzo" or "zstd") and the
+ * zstd compression level, selectable via hibernate.compressor= and
+ * hibernate.compress_level=.  Consumed by kernel/power/swap.c.
+ */
+char hibernate_compressor[8] = "lzo";
+int hibernate_compress_level = 3;	/* ZSTD_CLEVEL_DEFAULT */
 static int nohibernate;
 static int resume_wait;
 static unsigned int resume_delay;
@@ -1365,3 +1373,11 @@ __setup("hibernate=", hibernate_setup);
 __setup("resumewait", resumewait_setup);
 __setup("resumedelay=", resumedelay_setup);
 __setup("nohibernate", nohibernate_setup);
+
+module_param_string(compressor, hibernate_compressor,
+		    sizeof(hibernate_compressor), 0644);
+MODULE_PARM_DESC(compressor,
+		 "Compression algorithm for the hibernation image (lzo or zstd)");
+module_param_named(compress_level, hibernate_compress_level, int, 0644);
+MODULE_PARM_DESC(compress_level,
+		 "Zstd compression level for the hibernation image (1..19)");
@@ -172,8 +172,11 @@ extern int swsusp_swap_in_use(void);
 #define SF_NOCOMPRESS_MODE	2
 #define SF_CRC32_MODE	        4
 #define SF_HW_SIG		8
+#define SF_COMPRESSION_ALG_ZSTD	16
 
 /* kernel/power/hibernate.c */
+extern char hibernate_compressor[];
+extern int hibernate_compress_level;
 extern int swsusp_check(void);
 extern void swsusp_free(void);
 extern int swsusp_read(unsigned int *flags_p);
@@ -24,6 +24,7 @@
 #include <linux/pm.h>
 #include <linux/slab.h>
 #include <linux/lzo.h>
+#include <linux/zstd.h>
 #include <linux/vmalloc.h>
 #include <linux/cpumask.h>
 #include <linux/atomic.h>
@@ -532,6 +533,30 @@ static int swap_writer_finish(struct swap_map_handle *handle,
 #define LZO_MIN_RD_PAGES	1024
 #define LZO_MAX_RD_PAGES	8192
 
+/*
+ * Compression algorithms the image data may be compressed with.  The worst
+ * case buffer sizes above are based on the LZO bound, which for our block
+ * size also covers zstd_compress_bound(LZO_UNC_SIZE), so the same buffers
+ * and length checks work for both algorithms.
+ */
+enum hib_comp_algo {
+	HIB_COMP_ALGO_LZO,
+	HIB_COMP_ALGO_ZSTD,
+};
+
+static enum hib_comp_algo hib_select_comp_algo(void)
+{
+	if (!strcmp(hibernate_compressor, "zstd")) {
+		if (IS_ENABLED(CONFIG_HIBERNATION_ZSTD))
+			return HIB_COMP_ALGO_ZSTD;
+		pr_warn("zstd compression not built in, using lzo\n");
+	} else if (strcmp(hibernate_compressor, "lzo")) {
+		pr_warn("Unknown image compressor \"%s\", using lzo\n",
+			hibernate_compressor);
+	}
+	return HIB_COMP_ALGO_LZO;
+}
+
 
 /**
  *	save_image - save the suspend image data
@@ -624,10 +649,11 @@ static int crc32_threadfn(void *data)
 	return 0;
 }
 /**
- * Structure used for LZO data compression.
+ * Structure used for data compression.
  */
 struct cmp_data {
 	struct task_struct *thr;                  /* thread */
+	enum hib_comp_algo alg;                   /* compression algorithm */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
@@ -637,13 +663,16 @@ struct cmp_data {
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
-	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* compression workspace */
+	unsigned char wrk[LZO1X_1_MEM_COMPRESS];  /* LZO compression workspace */
+	zstd_parameters params;                   /* zstd parameters */
+	zstd_cctx *cctx;                          /* zstd compression context */
+	void *cctx_wksp;                          /* zstd context workspace */
 };
 
 /**
  * Compression function that runs in its own thread.
  */
-static int lzo_compress_threadfn(void *data)
+static int compress_threadfn(void *data)
 {
 	struct cmp_data *d = data;
 
@@ -659,9 +688,25 @@ static int lzo_compress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->ret = lzo1x_1_compress(d->unc, d->unc_len,
-		                          d->cmp + LZO_HEADER, &d->cmp_len,
-		                          d->wrk);
+		if (d->alg == HIB_COMP_ALGO_ZSTD) {
+			size_t cmp_len;
+
+			cmp_len = zstd_compress_cctx(d->cctx,
+			                             d->cmp + LZO_HEADER,
+			                             LZO_CMP_SIZE - LZO_HEADER,
+			                             d->unc, d->unc_len,
+			                             &d->params);
+			if (zstd_is_error(cmp_len)) {
+				d->ret = -EIO;
+			} else {
+				d->cmp_len = cmp_len;
+				d->ret = 0;
+			}
+		} else {
+			d->ret = lzo1x_1_compress(d->unc, d->unc_len,
+			                          d->cmp + LZO_HEADER,
+			                          &d->cmp_len, d->wrk);
+		}
 		atomic_set_release(&d->stop, 1);
 		wake_up(&d->done);
 	}
@@ -669,14 +714,16 @@ static int lzo_compress_threadfn(void *data)
 }
 
 /**
- * save_image_lzo - Save the suspend image data compressed with LZO.
+ * save_compressed_image - Save the suspend image data after compression.
  * @handle: Swap map handle to use for saving the image.
  * @snapshot: Image to read data from.
  * @nr_to_write: Number of pages to save.
+ * @alg: Compression algorithm to use.
  */
-static int save_image_lzo(struct swap_map_handle *handle,
-                          struct snapshot_handle *snapshot,
-                          unsigned int nr_to_write)
+static int save_compressed_image(struct swap_map_handle *handle,
+                                 struct snapshot_handle *snapshot,
+                                 unsigned int nr_to_write,
+                                 enum hib_comp_algo alg)
 {
 	unsigned int m;
 	int ret = 0;
@@ -728,7 +775,28 @@ static int save_image_lzo(struct swap_map_handle *handle,
 		init_waitqueue_head(&data[thr].go);
 		init_waitqueue_head(&data[thr].done);
 
-		data[thr].thr = kthread_run(lzo_compress_threadfn,
+		data[thr].alg = alg;
+		if (alg == HIB_COMP_ALGO_ZSTD) {
+			size_t wksp_size;
+
+			data[thr].params =
+				zstd_get_params(hibernate_compress_level,
+						LZO_UNC_SIZE);
+			wksp_size = zstd_cctx_workspace_bound(
+						&data[thr].params.cParams);
+			data[thr].cctx_wksp = vmalloc(wksp_size);
+			if (data[thr].cctx_wksp)
+				data[thr].cctx =
+					zstd_init_cctx(data[thr].cctx_wksp,
+						       wksp_size);
+			if (!data[thr].cctx) {
+				pr_err("Failed to initialize zstd context\n");
+				ret = -ENOMEM;
+				goto out_clean;
+			}
+		}
+
+		data[thr].thr = kthread_run(compress_threadfn,
 		                            &data[thr],
 		                            "image_compress/%u", thr);
 		if (IS_ERR(data[thr].thr)) {
@@ -766,7 +834,8 @@ static int save_image_lzo(struct swap_map_handle *handle,
 	 */
 	handle->reqd_free_pages = reqd_free_pages();
 
-	pr_info("Using %u thread(s) for compression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s compression\n", nr_threads,
+		alg == HIB_COMP_ALGO_ZSTD ? "zstd" : "lzo");
 	pr_info("Compressing and saving image data (%u pages)...\n",
 		nr_to_write);
 	m = nr_to_write / 10;
@@ -816,14 +885,14 @@ static int save_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				pr_err("LZO compression failed\n");
+				pr_err("Image compression failed\n");
 				goto out_finish;
 			}
 
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(data[thr].unc_len))) {
-				pr_err("Invalid LZO compressed length\n");
+				pr_err("Invalid compressed length\n");
 				ret = -1;
 				goto out_finish;
 			}
@@ -869,9 +938,11 @@ out_clean:
 		kfree(crc);
 	}
 	if (data) {
-		for (thr = 0; thr < nr_threads; thr++)
+		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
 				kthread_stop(data[thr].thr);
+			vfree(data[thr].cctx_wksp);
+		}
 		vfree(data);
 	}
 	if (page) free_page((unsigned long)page);
@@ -915,6 +986,14 @@ int swsusp_write(unsigned int flags)
 	unsigned long pages;
 	int error;
 
+	/*
+	 * Record the compression algorithm in the image header so that
+	 * resume picks the right one without any configuration.
+	 */
+	if (!(flags & SF_NOCOMPRESS_MODE) &&
+	    hib_select_comp_algo() == HIB_COMP_ALGO_ZSTD)
+		flags |= SF_COMPRESSION_ALG_ZSTD;
+
 	pages = snapshot_get_image_size();
 	error = get_swap_writer(&handle);
 	if (error) {
@@ -941,7 +1020,10 @@ int swsusp_write(unsigned int flags)
 	if (!error) {
 		error = (flags & SF_NOCOMPRESS_MODE) ?
 			save_image(&handle, &snapshot, pages - 1) :
-			save_image_lzo(&handle, &snapshot, pages - 1);
+			save_compressed_image(&handle, &snapshot, pages - 1,
+					      (flags & SF_COMPRESSION_ALG_ZSTD) ?
+					      HIB_COMP_ALGO_ZSTD :
+					      HIB_COMP_ALGO_LZO);
 	}
 out_finish:
 	error = swap_writer_finish(&handle, flags, error);
@@ -1108,10 +1190,11 @@ static int load_image(struct swap_map_handle *handle,
 }
 
 /**
- * Structure used for LZO data decompression.
+ * Structure used for data decompression.
  */
 struct dec_data {
 	struct task_struct *thr;                  /* thread */
+	enum hib_comp_algo alg;                   /* compression algorithm */
 	atomic_t ready;                           /* ready to start flag */
 	atomic_t stop;                            /* ready to stop flag */
 	int ret;                                  /* return code */
@@ -1121,12 +1204,14 @@ struct dec_data {
 	size_t cmp_len;                           /* compressed length */
 	unsigned char unc[LZO_UNC_SIZE];          /* uncompressed buffer */
 	unsigned char cmp[LZO_CMP_SIZE];          /* compressed buffer */
+	zstd_dctx *dctx;                          /* zstd decompression context */
+	void *dctx_wksp;                          /* zstd context workspace */
 };
 
 /**
  * Decompression function that runs in its own thread.
  */
-static int lzo_decompress_threadfn(void *data)
+static int decompress_threadfn(void *data)
 {
 	struct dec_data *d = data;
 
@@ -1142,9 +1227,26 @@ static int lzo_decompress_threadfn(void *data)
 		}
 		atomic_set(&d->ready, 0);
 
-		d->unc_len = LZO_UNC_SIZE;
-		d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER, d->cmp_len,
-		                               d->unc, &d->unc_len);
+		if (d->alg == HIB_COMP_ALGO_ZSTD) {
+			size_t unc_len;
+
+			unc_len = zstd_decompress_dctx(d->dctx,
+			                               d->unc, LZO_UNC_SIZE,
+			                               d->cmp + LZO_HEADER,
+			                               d->cmp_len);
+			if (zstd_is_error(unc_len)) {
+				d->unc_len = 0;
+				d->ret = -EIO;
+			} else {
+				d->unc_len = unc_len;
+				d->ret = 0;
+			}
+		} else {
+			d->unc_len = LZO_UNC_SIZE;
+			d->ret = lzo1x_decompress_safe(d->cmp + LZO_HEADER,
+			                               d->cmp_len, d->unc,
+			                               &d->unc_len);
+		}
 		if (clean_pages_on_decompress)
 			flush_icache_range((unsigned long)d->unc,
 					   (unsigned long)d->unc + d->unc_len);
@@ -1156,14 +1258,16 @@ static int lzo_decompress_threadfn(void *data)
 }
 
 /**
- * load_image_lzo - Load compressed image data and decompress them with LZO.
+ * load_compressed_image - Load compressed image data and decompress it.
  * @handle: Swap map handle to use for loading data.
  * @snapshot: Image to copy uncompressed data into.
  * @nr_to_read: Number of pages to load.
+ * @alg: Compression algorithm the image was saved with.
  */
-static int load_image_lzo(struct swap_map_handle *handle,
-                          struct snapshot_handle *snapshot,
-                          unsigned int nr_to_read)
+static int load_compressed_image(struct swap_map_handle *handle,
+                                 struct snapshot_handle *snapshot,
+                                 unsigned int nr_to_read,
+                                 enum hib_comp_algo alg)
 {
 	unsigned int m;
 	int ret = 0;
@@ -1220,7 +1324,23 @@ static int load_image_lzo(struct swap_map_handle *handle,
 		init_waitqueue_head(&data[thr].go);
 		init_waitqueue_head(&data[thr].done);
 
-		data[thr].thr = kthread_run(lzo_decompress_threadfn,
+		data[thr].alg = alg;
+		if (alg == HIB_COMP_ALGO_ZSTD) {
+			size_t wksp_size = zstd_dctx_workspace_bound();
+
+			data[thr].dctx_wksp = vmalloc(wksp_size);
+			if (data[thr].dctx_wksp)
+				data[thr].dctx =
+					zstd_init_dctx(data[thr].dctx_wksp,
+						       wksp_size);
+			if (!data[thr].dctx) {
+				pr_err("Failed to initialize zstd context\n");
+				ret = -ENOMEM;
+				goto out_clean;
+			}
+		}
+
+		data[thr].thr = kthread_run(decompress_threadfn,
 		                            &data[thr],
 		                            "image_decompress/%u", thr);
 		if (IS_ERR(data[thr].thr)) {
@@ -1282,7 +1402,8 @@ static int load_image_lzo(struct swap_map_handle *handle,
 	}
 	want = ring_size = i;
 
-	pr_info("Using %u thread(s) for decompression\n", nr_threads);
+	pr_info("Using %u thread(s) for %s decompression\n", nr_threads,
+		alg == HIB_COMP_ALGO_ZSTD ? "zstd" : "lzo");
 	pr_info("Loading and decompressing image data (%u pages)...\n",
 		nr_to_read);
 	m = nr_to_read / 10;
@@ -1344,7 +1465,7 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			if (unlikely(!data[thr].cmp_len ||
 			             data[thr].cmp_len >
 			             lzo1x_worst_compress(LZO_UNC_SIZE))) {
-				pr_err("Invalid LZO compressed length\n");
+				pr_err("Invalid compressed length\n");
 				ret = -1;
 				goto out_finish;
 			}
@@ -1395,14 +1516,14 @@ static int load_image_lzo(struct swap_map_handle *handle,
 			ret = data[thr].ret;
 
 			if (ret < 0) {
-				pr_err("LZO decompression failed\n");
+				pr_err("Image decompression failed\n");
 				goto out_finish;
 			}
 
 			if (unlikely(!data[thr].unc_len ||
 			             data[thr].unc_len > LZO_UNC_SIZE ||
 			             data[thr].unc_len & (PAGE_SIZE - 1))) {
-				pr_err("Invalid LZO uncompressed length\n");
+				pr_err("Invalid uncompressed length\n");
 				ret = -1;
 				goto out_finish;
 			}
@@ -1463,9 +1584,11 @@ out_clean:
 		kfree(crc);
 	}
 	if (data) {
-		for (thr = 0; thr < nr_threads; thr++)
+		for (thr = 0; thr < nr_threads; thr++) {
 			if (data[thr].thr)
 				kthread_stop(data[thr].thr);
+			vfree(data[thr].dctx_wksp);
+		}
 		vfree(data);
 	}
 	vfree(page);
@@ -1497,9 +1620,19 @@ int swsusp_read(unsigned int *flags_p)
 	if (!error)
 		error = swap_read_page(&handle, header, NULL);
 	if (!error) {
-		error = (*flags_p & SF_NOCOMPRESS_MODE) ?
-			load_image(&handle, &snapshot, header->pages - 1) :
-			load_image_lzo(&handle, &snapshot, header->pages - 1);
+		if (*flags_p & SF_NOCOMPRESS_MODE) {
+			error = load_image(&handle, &snapshot,
+					   header->pages - 1);
+		} else if ((*flags_p & SF_COMPRESSION_ALG_ZSTD) &&
+			   !IS_ENABLED(CONFIG_HIBERNATION_ZSTD)) {
+			pr_err("Image compressed with zstd, but zstd support is not built in\n");
+			error = -EINVAL;
+		} else {
+			error = load_compressed_image(&handle, &snapshot,
+					header->pages - 1,
+					(*flags_p & SF_COMPRESSION_ALG_ZSTD) ?
+					HIB_COMP_ALGO_ZSTD : HIB_COMP_ALGO_LZO);
+		}
 	}
 	swap_reader_finish(&handle);
 end:
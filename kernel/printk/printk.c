@@ -2224,6 +2224,71 @@ out:
 	return ret;
 }
 
+/*
+ * Console flushing can be offloaded to a kthread so that printk() callers
+ * never wait for slow consoles to drain. The lockless ringbuffer already
+ * decouples message storage from printing, so the thread only needs to
+ * take over the console_lock()/console_unlock() flush cycle. Printing
+ * stays synchronous until the thread is up and whenever direct output is
+ * required (panic, oops, shutdown).
+ */
+static struct task_struct *printk_flusher_thread;
+static DECLARE_WAIT_QUEUE_HEAD(printk_flusher_wait);
+static atomic_t printk_flusher_work = ATOMIC_INIT(0);
+
+static bool threaded_flush = true;
+module_param(threaded_flush, bool, 0644);
+MODULE_PARM_DESC(threaded_flush, "offload console flushing to a kthread");
+
+static void defer_console_flush(void);
+
+static bool printk_flush_offload(void)
+{
+	if (!READ_ONCE(threaded_flush))
+		return false;
+	if (!READ_ONCE(printk_flusher_thread))
+		return false;
+	/* Print directly once a panic or shutdown is under way. */
+	if (panic_in_progress() || oops_in_progress)
+		return false;
+	if (system_state > SYSTEM_RUNNING)
+		return false;
+	return true;
+}
+
+static int printk_flusher_threadfn(void *unused)
+{
+	while (1) {
+		wait_event_interruptible(printk_flusher_wait,
+				atomic_read_acquire(&printk_flusher_work));
+		atomic_set(&printk_flusher_work, 0);
+
+		/*
+		 * console_unlock() prints all records stored since the
+		 * matching console_lock(), so records added while we were
+		 * flushing are picked up before sleeping again.
+		 */
+		console_lock();
+		console_unlock();
+	}
+	return 0;
+}
+
+static void printk_start_flusher(void)
+{
+	struct task_struct *thr;
+
+	if (!threaded_flush)
+		return;
+
+	thr = kthread_run(printk_flusher_threadfn, NULL, "printk");
+	if (IS_ERR(thr)) {
+		pr_err("Failed to start console flushing thread\n");
+		return;
+	}
+	WRITE_ONCE(printk_flusher_thread, thr);
+}
+
 asmlinkage int vprintk_emit(int facility, int level,
 			    const struct dev_printk_info *dev_info,
 			    const char *fmt, va_list args)
@@ -2249,7 +2314,7 @@ asmlinkage int vprintk_emit(int facility, int level,
 	printed_len = vprintk_store(facility, level, dev_info, fmt, args);
 
 	/* If called from the scheduler, we can not call up(). */
-	if (!in_sched) {
+	if (!in_sched && !printk_flush_offload()) {
 		/*
 		 * The caller may be holding system-critical or
 		 * timing-sensitive locks. Disable preemption during
@@ -2271,6 +2336,8 @@ asmlinkage int vprintk_emit(int facility, int level,
 
 	if (in_sched)
 		defer_console_output();
+	else if (printk_flush_offload())
+		defer_console_flush();
 	else
 		wake_up_klogd();
 
@@ -2334,6 +2401,7 @@ static void call_console_driver(struct console *con, const char *text, size_t le
 static bool suppress_message_printing(int level) { return false; }
 static bool pr_flush(int timeout_ms, bool reset_on_progress) { return true; }
 static bool __pr_flush(struct console *con, int timeout_ms, bool reset_on_progress) { return true; }
+static void printk_start_flusher(void) { }
 
 #endif /* CONFIG_PRINTK */
 
@@ -3358,6 +3426,7 @@ static int __init printk_late_init(void)
 					console_cpu_notify, NULL);
 	WARN_ON(ret < 0);
 	printk_sysctl_init();
+	printk_start_flusher();
 	return 0;
 }
 late_initcall(printk_late_init);
@@ -3449,6 +3518,7 @@ static bool pr_flush(int timeout_ms, bool reset_on_progress)
  */
 #define PRINTK_PENDING_WAKEUP	0x01
 #define PRINTK_PENDING_OUTPUT	0x02
+#define PRINTK_PENDING_FLUSH	0x04
 
 static DEFINE_PER_CPU(int, printk_pending);
 
@@ -3462,6 +3532,11 @@ static void wake_up_klogd_work_func(struct irq_work *irq_work)
 			console_unlock();
 	}
 
+	if (pending & PRINTK_PENDING_FLUSH) {
+		atomic_set_release(&printk_flusher_work, 1);
+		wake_up(&printk_flusher_wait);
+	}
+
 	if (pending & PRINTK_PENDING_WAKEUP)
 		wake_up_interruptible(&log_wait);
 }
@@ -3487,7 +3562,7 @@ static void __wake_up_klogd(int val)
 	 * This pairs with devkmsg_read:A and syslog_print:A.
 	 */
 	if (wq_has_sleeper(&log_wait) || /* LMM(__wake_up_klogd:A) */
-	    (val & PRINTK_PENDING_OUTPUT)) {
+	    (val & (PRINTK_PENDING_OUTPUT | PRINTK_PENDING_FLUSH))) {
 		this_cpu_or(printk_pending, val);
 		irq_work_queue(this_cpu_ptr(&wake_up_klogd_work));
 	}
@@ -3530,6 +3605,18 @@ void defer_console_output(void)
 	__wake_up_klogd(PRINTK_PENDING_WAKEUP | PRINTK_PENDING_OUTPUT);
 }
 
+/*
+ * defer_console_flush - Hand the pending records over to the console
+ * flushing thread
+ *
+ * The wakeup goes through the klogd irq_work so that it is safe from any
+ * context, including with scheduler or timekeeping locks held.
+ */
+static void defer_console_flush(void)
+{
+	__wake_up_klogd(PRINTK_PENDING_WAKEUP | PRINTK_PENDING_FLUSH);
+}
+
 void printk_trigger_flush(void)
 {
 	defer_console_output();
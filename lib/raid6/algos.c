@@ -75,6 +75,9 @@ const struct raid6_calls * const raid6_algos[] = {
 	&raid6_neonx2,
 	&raid6_neonx1,
 #endif
+#if defined(CONFIG_RISCV) && defined(CONFIG_VECTOR)
+	&raid6_rvvx1,
+#endif
 #if defined(__ia64__)
 	&raid6_intx32,
 	&raid6_intx16,
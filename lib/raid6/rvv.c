@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: GPL-2.0-only
+/*
+ * lib/raid6/rvv.c - RAID6 syndrome calculation using the riscv vector
+ * extension
+ *
+ * The actual inner loops live in rvv1.S; these wrappers only fence the
+ * vector register usage, mirroring lib/raid6/neon.c.
+ */
+
+#include <linux/raid/pq.h>
+
+#include <asm/switch_to.h>
+
+void raid6_rvv1_gen_syndrome_real(int disks, unsigned long bytes, void **ptrs);
+void raid6_rvv1_xor_syndrome_real(int disks, int start, int stop,
+				  unsigned long bytes, void **ptrs);
+
+static void raid6_rvv1_gen_syndrome(int disks, size_t bytes, void **ptrs)
+{
+	kernel_vector_begin();
+	raid6_rvv1_gen_syndrome_real(disks, (unsigned long)bytes, ptrs);
+	kernel_vector_end();
+}
+
+static void raid6_rvv1_xor_syndrome(int disks, int start, int stop,
+				    size_t bytes, void **ptrs)
+{
+	kernel_vector_begin();
+	raid6_rvv1_xor_syndrome_real(disks, start, stop,
+				     (unsigned long)bytes, ptrs);
+	kernel_vector_end();
+}
+
+static int raid6_have_rvv(void)
+{
+	return has_vector();
+}
+
+const struct raid6_calls raid6_rvvx1 = {
+	raid6_rvv1_gen_syndrome,
+	raid6_rvv1_xor_syndrome,
+	raid6_have_rvv,
+	"rvvx1",
+	0
+};
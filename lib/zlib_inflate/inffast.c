@@ -4,6 +4,10 @@
  */
 
 #include <linux/zutil.h>
+#include <asm/unaligned.h>
+#ifdef CONFIG_RISCV
+#include <asm/cpufeature.h>
+#endif
 #include "inftrees.h"
 #include "inflate.h"
 #include "inffast.h"
@@ -27,6 +31,25 @@ get_unaligned16(const unsigned short *p)
 	return mm.us;
 }
 
+/*
+ * Whether inflate_fast() may use unaligned 8-byte loads and stores for
+ * bit buffer refills and match copies.  They need a 64-bit bit buffer
+ * and only pay off when the CPU handles misaligned accesses in
+ * hardware: on riscv that is a per-platform property probed at boot
+ * (trapping accesses would be *emulated* a byte at a time), elsewhere
+ * CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS settles it at build time.
+ */
+static inline int inflate_wide_ok(void)
+{
+	if (sizeof(unsigned long) < 8)
+		return 0;
+#ifdef CONFIG_RISCV
+	return this_cpu_read(misaligned_access_speed) == RISCV_MISALIGNED_FAST;
+#else
+	return IS_ENABLED(CONFIG_HAVE_EFFICIENT_UNALIGNED_ACCESS);
+#endif
+}
+
 /*
    Decode literal, length, and distance codes and write out the resulting
    literal and match bytes until either not enough input or output is
@@ -91,6 +114,7 @@ void inflate_fast(z_streamp strm, unsigned start)
     unsigned len;               /* match length, unused bytes */
     unsigned dist;              /* match distance */
     unsigned char *from;        /* where to copy match from */
+    const int wide = inflate_wide_ok(); /* unaligned 8-byte accesses OK */
 
     /* copy state to local variables */
     state = (struct inflate_state *)strm->state;
@@ -117,10 +141,27 @@ void inflate_fast(z_streamp strm, unsigned start)
        input data or output space */
     do {
         if (bits < 15) {
-            hold += (unsigned long)(*in++) << bits;
-            bits += 8;
-            hold += (unsigned long)(*in++) << bits;
-            bits += 8;
+            if (wide && likely(in <= last - 3)) {
+                /* One unaligned 8-byte load tops the buffer up to at
+                   least 56 bits, enough for a whole length/distance
+                   pair (48 bits, see above), so none of the byte-wise
+                   refills below run this iteration.  The load needs
+                   in + 8 <= last + 5, i.e. in <= last - 3.  The load
+                   brings in up to 8 bits more than get accounted in
+                   bits; mask them off, since in still points at those
+                   bytes and the += refills rely on everything above
+                   the accounted bits of hold being zero. */
+                hold |= get_unaligned_le64(in) << bits;
+                in += 7 - (bits >> 3);
+                bits |= 56;
+                hold &= (1UL << bits) - 1;
+            }
+            else {
+                hold += (unsigned long)(*in++) << bits;
+                bits += 8;
+                hold += (unsigned long)(*in++) << bits;
+                bits += 8;
+            }
         }
         this = lcode[hold & lmask];
       dolen:
@@ -242,6 +283,23 @@ void inflate_fast(z_streamp strm, unsigned start)
 
                     from = out - dist;          /* copy direct from output */
 		    /* minimum length is three */
+		    if (wide && dist >= 8) {
+			/* Source trails the destination by at least a
+			   full word, so 8-byte copies never read a byte
+			   this loop has not written yet. */
+			while (len >= 8) {
+			    put_unaligned(get_unaligned((const u64 *)from),
+					  (u64 *)out);
+			    from += 8;
+			    out += 8;
+			    len -= 8;
+			}
+			while (len) {
+			    *out++ = *from++;
+			    len--;
+			}
+			continue;
+		    }
 		    /* Align out addr */
 		    if (!((long)(out - 1) & 1)) {
 			*out++ = *from++;
@@ -311,7 +369,7 @@ void inflate_fast(z_streamp strm, unsigned start)
     len = bits >> 3;
     in -= len;
     bits -= len << 3;
-    hold &= (1U << bits) - 1;
+    hold &= (1UL << bits) - 1;
 
     /* update state and return */
     strm->next_in = in;
@@ -287,6 +287,8 @@ struct damos *damon_new_scheme(struct damos_access_pattern *pattern,
 		return NULL;
 	scheme->pattern = *pattern;
 	scheme->action = action;
+	/* Callers of migration actions should explicitly set the target */
+	scheme->target_nid = NUMA_NO_NODE;
 	scheme->stat = (struct damos_stat){};
 	INIT_LIST_HEAD(&scheme->list);
 
@@ -954,7 +956,25 @@ static void damon_split_region_at(struct damon_target *t,
 	damon_insert_region(new, r, damon_next_region(r), t);
 }
 
-/* Split every region in the given target into 'nr_subs' regions */
+/*
+ * Check if a region deserves finer monitoring granularity
+ *
+ * A region showed accesses in the last aggregation interval, or one whose
+ * access pattern just changed (age reset by the merge logic), might be hiding
+ * internal access skew behind its single nr_accesses value, so splitting it
+ * could improve the monitoring quality.  A region that stayed idle for
+ * multiple aggregation intervals is already well represented by one region;
+ * once it is accessed again, its age will be reset and it becomes a split
+ * candidate from the next aggregation interval.
+ */
+static bool damon_region_worth_split(struct damon_region *r)
+{
+	return r->last_nr_accesses || !r->age;
+}
+
+/*
+ * Split every split-worthy region in the given target into 'nr_subs' regions
+ */
 static void damon_split_regions_of(struct damon_target *t, int nr_subs)
 {
 	struct damon_region *r, *next;
@@ -962,6 +982,9 @@ static void damon_split_regions_of(struct damon_target *t, int nr_subs)
 	int i;
 
 	damon_for_each_region_safe(r, next, t) {
+		if (!damon_region_worth_split(r))
+			continue;
+
 		sz_region = damon_sz_region(r);
 
 		for (i = 0; i < nr_subs - 1 &&
@@ -983,33 +1006,39 @@ static void damon_split_regions_of(struct damon_target *t, int nr_subs)
 }
 
 /*
- * Split every target region into randomly-sized small regions
+ * Split split-worthy target regions into randomly-sized small regions
  *
- * This function splits every target region into random-sized small regions if
- * current total number of the regions is equal or smaller than half of the
- * user-specified maximum number of regions.  This is for maximizing the
- * monitoring accuracy under the dynamically changeable access patterns.  If a
- * split was unnecessarily made, later 'kdamond_merge_regions()' will revert
- * it.
+ * This function splits target regions that are showing accesses or unstable
+ * access patterns into random-sized small regions, if the user-specified
+ * maximum number of regions can accommodate the worst-case outcome of the
+ * split.  Spending the region-count budget only on such regions maximizes the
+ * monitoring accuracy for the actively accessed part of the memory while
+ * long-idle areas keep being monitored at low cost.  If a split was
+ * unnecessarily made, later 'kdamond_merge_regions()' will revert it.
  */
 static void kdamond_split_regions(struct damon_ctx *ctx)
 {
 	struct damon_target *t;
-	unsigned int nr_regions = 0;
+	struct damon_region *r;
+	unsigned int nr_regions = 0, nr_splittable = 0;
 	static unsigned int last_nr_regions;
 	int nr_subregions = 2;
 
-	damon_for_each_target(t, ctx)
+	damon_for_each_target(t, ctx) {
 		nr_regions += damon_nr_regions(t);
-
-	if (nr_regions > ctx->attrs.max_nr_regions / 2)
-		return;
+		damon_for_each_region(r, t)
+			nr_splittable += damon_region_worth_split(r);
+	}
 
 	/* Maybe the middle of the region has different access frequency */
 	if (last_nr_regions == nr_regions &&
 			nr_regions < ctx->attrs.max_nr_regions / 3)
 		nr_subregions = 3;
 
+	if (nr_regions + nr_splittable * (nr_subregions - 1) >
+			ctx->attrs.max_nr_regions)
+		return;
+
 	damon_for_each_target(t, ctx)
 		damon_split_regions_of(t, nr_subregions);
 
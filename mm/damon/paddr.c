@@ -7,6 +7,7 @@
 
 #define pr_fmt(fmt) "damon-pa: " fmt
 
+#include <linux/migrate.h>
 #include <linux/mmu_notifier.h>
 #include <linux/page_idle.h>
 #include <linux/pagemap.h>
@@ -260,6 +261,57 @@ static unsigned long damon_pa_deactivate_pages(struct damon_region *r)
 	return damon_pa_mark_accessed_or_deactivate(r, false);
 }
 
+static unsigned long damon_pa_migrate(struct damon_region *r,
+		struct damos *scheme)
+{
+	unsigned long addr, applied = 0;
+	unsigned int nr_succeeded = 0;
+	LIST_HEAD(migrate_list);
+	struct migration_target_control mtc = {
+		.nid = scheme->target_nid,
+		/*
+		 * Allocate from the target node without reclaiming or
+		 * splashing warnings.  Failed migrations just leave the pages
+		 * where they are.
+		 */
+		.gfp_mask = (GFP_HIGHUSER_MOVABLE & ~__GFP_RECLAIM) |
+			__GFP_NOWARN | __GFP_NOMEMALLOC | GFP_NOWAIT,
+	};
+
+	if (mtc.nid == NUMA_NO_NODE || !node_online(mtc.nid))
+		return 0;
+
+	for (addr = r->ar.start; addr < r->ar.end; addr += PAGE_SIZE) {
+		struct page *page = damon_get_page(PHYS_PFN(addr));
+
+		if (!page)
+			continue;
+
+		if (page_to_nid(page) == mtc.nid) {
+			put_page(page);
+			continue;
+		}
+
+		if (isolate_lru_page(page)) {
+			put_page(page);
+			continue;
+		}
+		if (PageUnevictable(page))
+			putback_lru_page(page);
+		else
+			list_add(&page->lru, &migrate_list);
+		put_page(page);
+	}
+
+	if (migrate_pages(&migrate_list, alloc_migration_target, NULL,
+				(unsigned long)&mtc, MIGRATE_ASYNC,
+				MR_NUMA_MISPLACED, &nr_succeeded))
+		putback_movable_pages(&migrate_list);
+	applied = nr_succeeded;
+	cond_resched();
+	return applied * PAGE_SIZE;
+}
+
 static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		struct damon_target *t, struct damon_region *r,
 		struct damos *scheme)
@@ -271,6 +323,8 @@ static unsigned long damon_pa_apply_scheme(struct damon_ctx *ctx,
 		return damon_pa_mark_accessed(r);
 	case DAMOS_LRU_DEPRIO:
 		return damon_pa_deactivate_pages(r);
+	case DAMOS_MIGRATE_HOT:
+		return damon_pa_migrate(r, scheme);
 	case DAMOS_STAT:
 		break;
 	default:
@@ -291,6 +345,8 @@ static int damon_pa_scheme_score(struct damon_ctx *context,
 		return damon_hot_score(context, r, scheme);
 	case DAMOS_LRU_DEPRIO:
 		return damon_cold_score(context, r, scheme);
+	case DAMOS_MIGRATE_HOT:
+		return damon_hot_score(context, r, scheme);
 	default:
 		break;
 	}
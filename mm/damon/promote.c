@@ -0,0 +1,329 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * DAMON-based Hot-pages Promotion
+ *
+ * Let frequently accessed (hot) pages of the monitored memory region be
+ * migrated to a user-specified NUMA node, so that hot working sets end up on
+ * the fast node without manual migration.
+ */
+
+#define pr_fmt(fmt) "damon-promote: " fmt
+
+#include <linux/damon.h>
+#include <linux/ioport.h>
+#include <linux/module.h>
+#include <linux/numa.h>
+#include <linux/workqueue.h>
+
+#include "modules-common.h"
+
+#ifdef MODULE_PARAM_PREFIX
+#undef MODULE_PARAM_PREFIX
+#endif
+#define MODULE_PARAM_PREFIX "damon_promote."
+
+/*
+ * Enable or disable DAMON_PROMOTE.
+ *
+ * You can enable DAMON_PROMOTE by setting the value of this parameter as
+ * ``Y``.  Setting it as ``N`` disables DAMON_PROMOTE.  Note that
+ * DAMON_PROMOTE does nothing while ``target_node`` is not a valid online
+ * node.
+ */
+static bool enabled __read_mostly;
+
+/*
+ * Make DAMON_PROMOTE reads the input parameters again, except ``enabled``.
+ *
+ * Input parameters that updated while DAMON_PROMOTE is running are not
+ * applied by default.  Once this parameter is set as ``Y``, DAMON_PROMOTE
+ * reads values of parametrs except ``enabled`` again.  Once the re-reading is
+ * done, this parameter is set as ``N``.  If invalid parameters are found
+ * while the re-reading, DAMON_PROMOTE will be disabled.
+ */
+static bool commit_inputs __read_mostly;
+module_param(commit_inputs, bool, 0600);
+
+/*
+ * NUMA node that the hot pages should be migrated to.
+ *
+ * Pages of hot regions that reside on other nodes are migrated to this node.
+ * There is no default; DAMON_PROMOTE does nothing until this is set to a
+ * valid online node, normally the node backed by the fastest memory.
+ */
+static int target_node __read_mostly = NUMA_NO_NODE;
+module_param(target_node, int, 0600);
+
+/*
+ * Access frequency threshold for hot memory regions identification in permil.
+ *
+ * If a memory region is accessed in frequency of this or higher,
+ * DAMON_PROMOTE identifies the region as hot, and migrates it to
+ * ``target_node``.  50% by default.
+ */
+static unsigned long hot_thres_access_freq = 500;
+module_param(hot_thres_access_freq, ulong, 0600);
+
+/*
+ * Minimum age of the hot regions to be promoted, in aggregation intervals.
+ *
+ * Migrating a region on its first hot sighting risks bouncing pages that are
+ * only briefly hot.  Regions should stay hot at least this long before they
+ * are migrated.  2 by default.
+ */
+static unsigned long hot_min_age __read_mostly = 2;
+module_param(hot_min_age, ulong, 0600);
+
+static struct damos_quota damon_promote_quota = {
+	/* use up to 10 ms time, and migrate up to 128 MiB per 1 sec */
+	.ms = 10,
+	.sz = 128 * 1024 * 1024,
+	.reset_interval = 1000,
+	/* Within the quota, migrate hotter regions first. */
+	.weight_sz = 0,
+	.weight_nr_accesses = 1,
+	.weight_age = 0,
+};
+DEFINE_DAMON_MODULES_DAMOS_QUOTAS(damon_promote_quota);
+
+/*
+ * Promotion is about locality, not memory pressure, so the scheme is always
+ * active rather than watermarks-activated.
+ */
+static struct damos_watermarks damon_promote_wmarks = {
+	.metric = DAMOS_WMARK_NONE,
+};
+
+static struct damon_attrs damon_promote_mon_attrs = {
+	.sample_interval = 5000,	/* 5 ms */
+	.aggr_interval = 100000,	/* 100 ms */
+	.ops_update_interval = 0,
+	.min_nr_regions = 10,
+	.max_nr_regions = 1000,
+};
+DEFINE_DAMON_MODULES_MON_ATTRS_PARAMS(damon_promote_mon_attrs);
+
+/*
+ * Start of the target memory region in physical address.
+ *
+ * The start physical address of memory region that DAMON_PROMOTE will do work
+ * against.  By default, biggest System RAM is used as the region.
+ */
+static unsigned long monitor_region_start __read_mostly;
+module_param(monitor_region_start, ulong, 0600);
+
+/*
+ * End of the target memory region in physical address.
+ *
+ * The end physical address of memory region that DAMON_PROMOTE will do work
+ * against.  By default, biggest System RAM is used as the region.
+ */
+static unsigned long monitor_region_end __read_mostly;
+module_param(monitor_region_end, ulong, 0600);
+
+/*
+ * PID of the DAMON thread
+ *
+ * If DAMON_PROMOTE is enabled, this becomes the PID of the worker thread.
+ * Else, -1.
+ */
+static int kdamond_pid __read_mostly = -1;
+module_param(kdamond_pid, int, 0400);
+
+static struct damos_stat damon_promote_stat;
+DEFINE_DAMON_MODULES_DAMOS_STATS_PARAMS(damon_promote_stat,
+		promote_tried_regions, promoted_regions, quota_exceeds);
+
+static struct damon_ctx *ctx;
+static struct damon_target *target;
+
+/* Create a DAMON-based operation scheme for hot memory regions */
+static struct damos *damon_promote_new_scheme(void)
+{
+	unsigned int hot_thres =
+		damon_max_nr_accesses(&damon_promote_mon_attrs) *
+		hot_thres_access_freq / 1000;
+	struct damos_access_pattern pattern = {
+		/* Find regions having PAGE_SIZE or larger size */
+		.min_sz_region = PAGE_SIZE,
+		.max_sz_region = ULONG_MAX,
+		/* accessed in the hot frequency or higher, */
+		.min_nr_accesses = hot_thres,
+		.max_nr_accesses = UINT_MAX,
+		/* and staying hot for a while */
+		.min_age_region = hot_min_age,
+		.max_age_region = UINT_MAX,
+	};
+	struct damos *scheme;
+
+	scheme = damon_new_scheme(
+			/* find the pattern, and */
+			&pattern,
+			/* migrate the regions to the target node, */
+			DAMOS_MIGRATE_HOT,
+			/* under the quota. */
+			&damon_promote_quota,
+			/* with no watermarks-based deactivation. */
+			&damon_promote_wmarks);
+	if (scheme)
+		scheme->target_nid = target_node;
+	return scheme;
+}
+
+static void damon_promote_copy_quota_status(struct damos_quota *dst,
+		struct damos_quota *src)
+{
+	dst->total_charged_sz = src->total_charged_sz;
+	dst->total_charged_ns = src->total_charged_ns;
+	dst->charged_sz = src->charged_sz;
+	dst->charged_from = src->charged_from;
+	dst->charge_target_from = src->charge_target_from;
+	dst->charge_addr_from = src->charge_addr_from;
+}
+
+static int damon_promote_apply_parameters(void)
+{
+	struct damos *scheme, *old_scheme;
+	int err = 0;
+
+	err = damon_set_attrs(ctx, &damon_promote_mon_attrs);
+	if (err)
+		return err;
+
+	/* Will be freed by next 'damon_set_schemes()' below */
+	scheme = damon_promote_new_scheme();
+	if (!scheme)
+		return -ENOMEM;
+	damon_for_each_scheme(old_scheme, ctx) {
+		damon_promote_copy_quota_status(&scheme->quota,
+				&old_scheme->quota);
+		break;
+	}
+	damon_set_schemes(ctx, &scheme, 1);
+
+	return damon_set_region_biggest_system_ram_default(target,
+					&monitor_region_start,
+					&monitor_region_end);
+}
+
+static int damon_promote_turn(bool on)
+{
+	int err;
+
+	if (!on) {
+		err = damon_stop(&ctx, 1);
+		if (!err)
+			kdamond_pid = -1;
+		return err;
+	}
+
+	err = damon_promote_apply_parameters();
+	if (err)
+		return err;
+
+	err = damon_start(&ctx, 1, true);
+	if (err)
+		return err;
+	kdamond_pid = ctx->kdamond->pid;
+	return 0;
+}
+
+static struct delayed_work damon_promote_timer;
+static void damon_promote_timer_fn(struct work_struct *work)
+{
+	static bool last_enabled;
+	bool now_enabled;
+
+	now_enabled = enabled;
+	if (last_enabled != now_enabled) {
+		if (!damon_promote_turn(now_enabled))
+			last_enabled = now_enabled;
+		else
+			enabled = last_enabled;
+	}
+}
+static DECLARE_DELAYED_WORK(damon_promote_timer, damon_promote_timer_fn);
+
+static bool damon_promote_initialized;
+
+static int damon_promote_enabled_store(const char *val,
+		const struct kernel_param *kp)
+{
+	int rc = param_set_bool(val, kp);
+
+	if (rc < 0)
+		return rc;
+
+	if (!damon_promote_initialized)
+		return rc;
+
+	schedule_delayed_work(&damon_promote_timer, 0);
+
+	return 0;
+}
+
+static const struct kernel_param_ops enabled_param_ops = {
+	.set = damon_promote_enabled_store,
+	.get = param_get_bool,
+};
+
+module_param_cb(enabled, &enabled_param_ops, &enabled, 0600);
+MODULE_PARM_DESC(enabled,
+	"Enable or disable DAMON_PROMOTE (default: disabled)");
+
+static int damon_promote_handle_commit_inputs(void)
+{
+	int err;
+
+	if (!commit_inputs)
+		return 0;
+
+	err = damon_promote_apply_parameters();
+	commit_inputs = false;
+	return err;
+}
+
+static int damon_promote_after_aggregation(struct damon_ctx *c)
+{
+	struct damos *s;
+
+	/* update the stats parameter */
+	damon_for_each_scheme(s, c)
+		damon_promote_stat = s->stat;
+
+	return damon_promote_handle_commit_inputs();
+}
+
+static int damon_promote_after_wmarks_check(struct damon_ctx *c)
+{
+	return damon_promote_handle_commit_inputs();
+}
+
+static int __init damon_promote_init(void)
+{
+	ctx = damon_new_ctx();
+	if (!ctx)
+		return -ENOMEM;
+
+	if (damon_select_ops(ctx, DAMON_OPS_PADDR)) {
+		damon_destroy_ctx(ctx);
+		return -EINVAL;
+	}
+
+	ctx->callback.after_wmarks_check = damon_promote_after_wmarks_check;
+	ctx->callback.after_aggregation = damon_promote_after_aggregation;
+
+	target = damon_new_target();
+	if (!target) {
+		damon_destroy_ctx(ctx);
+		return -ENOMEM;
+	}
+	damon_add_target(ctx, target);
+
+	schedule_delayed_work(&damon_promote_timer, 0);
+
+	damon_promote_initialized = true;
+	return 0;
+}
+
+module_init(damon_promote_init);
@@ -10,7 +10,9 @@
 #include <linux/damon.h>
 #include <linux/ioport.h>
 #include <linux/module.h>
+#include <linux/psi.h>
 #include <linux/sched.h>
+#include <linux/vmstat.h>
 #include <linux/workqueue.h>
 
 #include "modules-common.h"
@@ -64,6 +66,57 @@ static struct damos_quota damon_reclaim_quota = {
 };
 DEFINE_DAMON_MODULES_DAMOS_QUOTAS(damon_reclaim_quota);
 
+/*
+ * Automatically modulate the size quota from observed memory pressure.
+ *
+ * If this parameter is set as ``Y``, DAMON_RECLAIM periodically compares the
+ * system's PSI memory ``some`` stall time and workingset refault rate against
+ * the target band below, and adjusts the effective size quota between 1 MiB
+ * and ``quota_sz``: halving it while the pressure is above the band, and
+ * growing it by a quarter while the pressure is below the band.  This way the
+ * reclamation converges on the most aggressive quota the workload can bear
+ * without hand tuning.  Requires a non-zero ``quota_sz``.
+ */
+static bool quota_autotune __read_mostly;
+module_param(quota_autotune, bool, 0600);
+
+/*
+ * Upper bound of the acceptable memory pressure, in permil of wall time.
+ *
+ * If the system-level PSI memory ``some`` stall time exceeds this portion of
+ * the wall time, the effective size quota is reduced.  1 percent by default.
+ */
+static unsigned long quota_autotune_psi_high __read_mostly = 10;
+module_param(quota_autotune_psi_high, ulong, 0600);
+
+/*
+ * Lower bound of the target memory pressure band, in permil of wall time.
+ *
+ * While the PSI memory ``some`` stall time stays below this portion of the
+ * wall time, the effective size quota is raised back towards ``quota_sz``.
+ * 0.2 percent by default.
+ */
+static unsigned long quota_autotune_psi_low __read_mostly = 2;
+module_param(quota_autotune_psi_low, ulong, 0600);
+
+/*
+ * Maximum acceptable number of workingset refaults per second.
+ *
+ * If the system-wide workingset refault rate exceeds this, the effective size
+ * quota is reduced regardless of the PSI band, so that over-aggressive
+ * reclamation of the workingset is backed off quickly.  0 (default) disables
+ * the refault rate check.
+ */
+static unsigned long quota_autotune_refaults_max __read_mostly;
+module_param(quota_autotune_refaults_max, ulong, 0600);
+
+/*
+ * Effective size quota that the automatic tuning has converged on, in bytes.
+ * 0 means the tuning is disabled or has not run yet.
+ */
+static unsigned long autotuned_quota_sz;
+module_param(autotuned_quota_sz, ulong, 0400);
+
 static struct damos_watermarks damon_reclaim_wmarks = {
 	.metric = DAMOS_WMARK_FREE_MEM_RATE,
 	.interval = 5000000,	/* 5 seconds */
@@ -141,6 +194,92 @@ static struct damos *damon_reclaim_new_scheme(void)
 			&damon_reclaim_wmarks);
 }
 
+#ifdef CONFIG_PSI
+static u64 damon_reclaim_psi_mem_some_us(void)
+{
+	if (static_branch_likely(&psi_disabled))
+		return 0;
+	return div_u64(psi_system.total[PSI_AVGS][PSI_MEM_SOME],
+			NSEC_PER_USEC);
+}
+#else
+static u64 damon_reclaim_psi_mem_some_us(void)
+{
+	return 0;
+}
+#endif
+
+static unsigned long damon_reclaim_refaults(void)
+{
+	return global_node_page_state(WORKINGSET_REFAULT_ANON) +
+		global_node_page_state(WORKINGSET_REFAULT_FILE);
+}
+
+/* Lowest effective size quota the automatic tuning can converge on. */
+#define DAMON_RECLAIM_QUOTA_SZ_MIN	(1024UL * 1024)
+
+/*
+ * Modulate the effective size quota of the scheme from the observed memory
+ * pressure and refault rate.  Called after each aggregation interval; adjusts
+ * at most once per quota reset interval, so every decision is based on a full
+ * charging window.
+ */
+static void damon_reclaim_tune_quota(struct damos *s)
+{
+	static unsigned long last_update;
+	static u64 last_psi_us;
+	static unsigned long last_refaults;
+	unsigned long window, min_interval, psi_permil, refaults_per_sec;
+	unsigned long refaults, sz, min_sz;
+	u64 psi_us;
+
+	if (!quota_autotune || !damon_reclaim_quota.sz) {
+		if (autotuned_quota_sz) {
+			/* Tuning just got disabled - restore the user quota */
+			s->quota.sz = damon_reclaim_quota.sz;
+			autotuned_quota_sz = 0;
+		}
+		last_update = 0;
+		return;
+	}
+
+	if (!last_update) {
+		last_update = jiffies;
+		last_psi_us = damon_reclaim_psi_mem_some_us();
+		last_refaults = damon_reclaim_refaults();
+		return;
+	}
+
+	min_interval = max(msecs_to_jiffies(damon_reclaim_quota.reset_interval),
+			(unsigned long)HZ);
+	window = jiffies - last_update;
+	if (window < min_interval)
+		return;
+
+	psi_us = damon_reclaim_psi_mem_some_us();
+	refaults = damon_reclaim_refaults();
+	psi_permil = div64_u64((psi_us - last_psi_us) * 1000,
+			jiffies_to_usecs(window));
+	refaults_per_sec = (refaults - last_refaults) * HZ / window;
+
+	sz = autotuned_quota_sz ? : damon_reclaim_quota.sz;
+	if (psi_permil > quota_autotune_psi_high ||
+	    (quota_autotune_refaults_max &&
+	     refaults_per_sec > quota_autotune_refaults_max))
+		sz /= 2;
+	else if (psi_permil < quota_autotune_psi_low)
+		sz += sz / 4;
+
+	min_sz = min(DAMON_RECLAIM_QUOTA_SZ_MIN, damon_reclaim_quota.sz);
+	sz = clamp(sz, min_sz, damon_reclaim_quota.sz);
+	autotuned_quota_sz = sz;
+	s->quota.sz = sz;
+
+	last_update = jiffies;
+	last_psi_us = psi_us;
+	last_refaults = refaults;
+}
+
 static void damon_reclaim_copy_quota_status(struct damos_quota *dst,
 		struct damos_quota *src)
 {
@@ -170,6 +309,9 @@ static int damon_reclaim_apply_parameters(void)
 			damon_reclaim_copy_quota_status(&scheme->quota,
 					&old_scheme->quota);
 	}
+	/* Keep the effective quota the automatic tuning converged on */
+	if (quota_autotune && autotuned_quota_sz)
+		scheme->quota.sz = autotuned_quota_sz;
 	damon_set_schemes(ctx, &scheme, 1);
 
 	return damon_set_region_biggest_system_ram_default(target,
@@ -259,8 +401,10 @@ static int damon_reclaim_after_aggregation(struct damon_ctx *c)
 	struct damos *s;
 
 	/* update the stats parameter */
-	damon_for_each_scheme(s, c)
+	damon_for_each_scheme(s, c) {
 		damon_reclaim_stat = s->stat;
+		damon_reclaim_tune_quota(s);
+	}
 
 	return damon_reclaim_handle_commit_inputs();
 }
@@ -20,6 +20,7 @@
 #include <linux/string.h>
 #include <linux/types.h>
 #include <linux/cpuhotplug.h>
+#include <linux/workqueue.h>
 
 #include "../slab.h"
 #include "kasan.h"
@@ -119,6 +120,13 @@ static unsigned long quarantine_max_size;
  */
 static unsigned long quarantine_batch_size;
 
+/*
+ * Size limit of a per-cpu queue.  Usually QUARANTINE_PERCPU_SIZE, but scaled
+ * down on machines with many CPUs relative to their memory, so that the
+ * per-cpu queues cannot consume the whole quarantine allowance.
+ */
+static unsigned long quarantine_percpu_size = QUARANTINE_PERCPU_SIZE;
+
 /*
  * The fraction of physical memory the quarantine is allowed to occupy.
  * Quarantine doesn't support memory shrinker with SLAB allocator, so we keep
@@ -220,7 +228,7 @@ bool kasan_quarantine_put(struct kmem_cache *cache, void *object)
 		return false;
 	}
 	qlist_put(q, &meta->quarantine_link, cache->size);
-	if (unlikely(q->bytes > QUARANTINE_PERCPU_SIZE)) {
+	if (unlikely(q->bytes > READ_ONCE(quarantine_percpu_size))) {
 		qlist_move_all(q, &temp);
 
 		raw_spin_lock(&quarantine_lock);
@@ -244,36 +252,31 @@ bool kasan_quarantine_put(struct kmem_cache *cache, void *object)
 	return true;
 }
 
-void kasan_quarantine_reduce(void)
+static void quarantine_reduce_worker(struct work_struct *work)
 {
-	size_t total_size, new_quarantine_size, percpu_quarantines;
+	size_t total_size, new_quarantine_size, percpu_size;
+	size_t percpu_quarantines;
+	size_t freed = 0;
 	unsigned long flags;
 	int srcu_idx;
-	struct qlist_head to_free = QLIST_INIT;
-
-	if (likely(READ_ONCE(quarantine_size) <=
-		   READ_ONCE(quarantine_max_size)))
-		return;
+	int i;
 
-	/*
-	 * srcu critical section ensures that kasan_quarantine_remove_cache()
-	 * will not miss objects belonging to the cache while they are in our
-	 * local to_free list. srcu is chosen because (1) it gives us private
-	 * grace period domain that does not interfere with anything else,
-	 * and (2) it allows synchronize_srcu() to return without waiting
-	 * if there are no pending read critical sections (which is the
-	 * expected case).
-	 */
-	srcu_idx = srcu_read_lock(&remove_cache_srcu);
 	raw_spin_lock_irqsave(&quarantine_lock, flags);
 
 	/*
 	 * Update quarantine size in case of hotplug. Allocate a fraction of
 	 * the installed memory to quarantine minus per-cpu queue limits.
+	 * Scale the per-cpu queue limits with the memory size, so that the
+	 * per-cpu queues of machines with many CPUs cannot take more than
+	 * half of the total allowance.
 	 */
 	total_size = (totalram_pages() << PAGE_SHIFT) /
 		QUARANTINE_FRACTION;
-	percpu_quarantines = QUARANTINE_PERCPU_SIZE * num_online_cpus();
+	percpu_size = min((size_t)QUARANTINE_PERCPU_SIZE,
+		total_size / (2 * num_online_cpus()));
+	percpu_size = max(percpu_size, (size_t)PAGE_SIZE);
+	WRITE_ONCE(quarantine_percpu_size, percpu_size);
+	percpu_quarantines = percpu_size * num_online_cpus();
 	new_quarantine_size = (total_size < percpu_quarantines) ?
 		0 : total_size - percpu_quarantines;
 	WRITE_ONCE(quarantine_max_size, new_quarantine_size);
@@ -281,18 +284,72 @@ void kasan_quarantine_reduce(void)
 	WRITE_ONCE(quarantine_batch_size, max((size_t)QUARANTINE_PERCPU_SIZE,
 		2 * total_size / QUARANTINE_BATCHES));
 
-	if (likely(quarantine_size > quarantine_max_size)) {
+	raw_spin_unlock_irqrestore(&quarantine_lock, flags);
+
+	/*
+	 * Free at most one pass over the batch ring per invocation, so
+	 * that sustained producers cannot keep this worker live
+	 * arbitrarily long.  Each batch gets its own srcu critical
+	 * section: it ensures that kasan_quarantine_remove_cache() will
+	 * not miss objects belonging to the cache while they are in our
+	 * local to_free list, and keeping the sections short means
+	 * synchronize_srcu() - and hence kmem_cache_destroy() - never
+	 * waits for more than one batch worth of freeing.  srcu is
+	 * chosen because (1) it gives us private grace period domain
+	 * that does not interfere with anything else, and (2) it allows
+	 * synchronize_srcu() to return without waiting if there are no
+	 * pending read critical sections (which is the expected case).
+	 */
+	for (i = 0; i < QUARANTINE_BATCHES; i++) {
+		struct qlist_head to_free = QLIST_INIT;
+
+		srcu_idx = srcu_read_lock(&remove_cache_srcu);
+		raw_spin_lock_irqsave(&quarantine_lock, flags);
+
+		if (quarantine_size <= quarantine_max_size) {
+			raw_spin_unlock_irqrestore(&quarantine_lock, flags);
+			srcu_read_unlock(&remove_cache_srcu, srcu_idx);
+			return;
+		}
+
 		qlist_move_all(&global_quarantine[quarantine_head], &to_free);
 		WRITE_ONCE(quarantine_size, quarantine_size - to_free.bytes);
+		freed += to_free.bytes;
 		quarantine_head++;
 		if (quarantine_head == QUARANTINE_BATCHES)
 			quarantine_head = 0;
+
+		raw_spin_unlock_irqrestore(&quarantine_lock, flags);
+		qlist_free_all(&to_free, NULL);
+		srcu_read_unlock(&remove_cache_srcu, srcu_idx);
+		cond_resched();
 	}
 
-	raw_spin_unlock_irqrestore(&quarantine_lock, flags);
+	/*
+	 * Still over the limit after a full pass: requeue ourselves and
+	 * let other work run in between.  If the pass freed nothing, the
+	 * byte counter has drifted above what the batches actually hold
+	 * (kasan_quarantine_remove_cache() pulls objects out without
+	 * adjusting it) and requeueing would just spin; give up until
+	 * new objects arrive.
+	 */
+	if (freed && READ_ONCE(quarantine_size) > READ_ONCE(quarantine_max_size))
+		queue_work(system_unbound_wq, work);
+}
+static DECLARE_WORK(quarantine_reduce_work, quarantine_reduce_worker);
 
-	qlist_free_all(&to_free, NULL);
-	srcu_read_unlock(&remove_cache_srcu, srcu_idx);
+void kasan_quarantine_reduce(void)
+{
+	if (likely(READ_ONCE(quarantine_size) <=
+		   READ_ONCE(quarantine_max_size)))
+		return;
+
+	/*
+	 * Defer the actual freeing to a worker, so that allocations do not
+	 * stall for the batched slab returns.  queue_work() is a no-op while
+	 * a drain is already pending.
+	 */
+	queue_work(system_unbound_wq, &quarantine_reduce_work);
 }
 
 static void qlist_move_cache(struct qlist_head *from,
@@ -100,6 +100,20 @@ module_param_cb(sample_interval, &sample_interval_param_ops, &kfence_sample_inte
 static unsigned long kfence_skip_covered_thresh __read_mostly = 75;
 module_param_named(skip_covered_thresh, kfence_skip_covered_thresh, ulong, 0644);
 
+#if !defined(CONFIG_KFENCE_STATIC_KEYS) && CONFIG_KFENCE_SAMPLE_INTERVAL != 0
+/*
+ * Number of allocations of a CPU to skip between reads of the shared
+ * allocation gate, if static keys are not used to gate allocations.  Larger
+ * values take the gate's cacheline out of the allocation fast path more
+ * effectively, at the cost of delaying the sample by up to that many
+ * allocations per CPU.
+ */
+unsigned int kfence_check_stride __read_mostly = 64;
+module_param_named(check_stride, kfence_check_stride, uint, 0644);
+
+DEFINE_PER_CPU(int, kfence_skip_counter);
+#endif
+
 /* If true, use a deferrable timer. */
 static bool kfence_deferrable __read_mostly = IS_ENABLED(CONFIG_KFENCE_DEFERRABLE);
 module_param_named(deferrable, kfence_deferrable, bool, 0444);
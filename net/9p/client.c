@@ -13,6 +13,7 @@
 #include <linux/fs.h>
 #include <linux/poll.h>
 #include <linux/idr.h>
+#include <linux/log2.h>
 #include <linux/mutex.h>
 #include <linux/slab.h>
 #include <linux/sched/signal.h>
@@ -267,6 +268,11 @@ static struct kmem_cache *p9_req_cache;
  * Context: Process context.
  * Return: Pointer to new request.
  */
+static struct p9_tag_pool *p9_tag_to_pool(struct p9_client *c, u16 tag)
+{
+	return &c->pools[tag >> c->pool_shift];
+}
+
 static struct p9_req_t *
 p9_tag_alloc(struct p9_client *c, int8_t type, uint t_size, uint r_size,
 	      const char *fmt, va_list ap)
@@ -306,14 +312,36 @@ p9_tag_alloc(struct p9_client *c, int8_t type, uint t_size, uint r_size,
 	INIT_LIST_HEAD(&req->req_list);
 
 	idr_preload(GFP_NOFS);
-	spin_lock_irq(&c->lock);
-	if (type == P9_TVERSION)
-		tag = idr_alloc(&c->reqs, req, P9_NOTAG, P9_NOTAG + 1,
+	if (type == P9_TVERSION) {
+		struct p9_tag_pool *pool = p9_tag_to_pool(c, P9_NOTAG);
+
+		spin_lock_irq(&pool->lock);
+		tag = idr_alloc(&pool->reqs, req, P9_NOTAG, P9_NOTAG + 1,
 				GFP_NOWAIT);
-	else
-		tag = idr_alloc(&c->reqs, req, 0, P9_NOTAG, GFP_NOWAIT);
+		spin_unlock_irq(&pool->lock);
+	} else {
+		unsigned int first = raw_smp_processor_id() & (c->n_pools - 1);
+		unsigned int n;
+
+		/* Allocate from the local CPU's pool, spilling over to the
+		 * other pools only once it is exhausted.
+		 */
+		tag = -ENOSPC;
+		for (n = 0; n < c->n_pools && tag < 0; n++) {
+			unsigned int i = (first + n) & (c->n_pools - 1);
+			struct p9_tag_pool *pool = &c->pools[i];
+			unsigned int base = i << c->pool_shift;
+			unsigned int end = min_t(unsigned int,
+						 base + (1U << c->pool_shift),
+						 P9_NOTAG);
+
+			spin_lock_irq(&pool->lock);
+			tag = idr_alloc(&pool->reqs, req, base, end,
+					GFP_NOWAIT);
+			spin_unlock_irq(&pool->lock);
+		}
+	}
 	req->tc.tag = tag;
-	spin_unlock_irq(&c->lock);
 	idr_preload_end();
 	if (tag < 0)
 		goto free;
@@ -354,7 +382,7 @@ struct p9_req_t *p9_tag_lookup(struct p9_client *c, u16 tag)
 
 	rcu_read_lock();
 again:
-	req = idr_find(&c->reqs, tag);
+	req = idr_find(&p9_tag_to_pool(c, tag)->reqs, tag);
 	if (req) {
 		/* We have to be careful with the req found under rcu_read_lock
 		 * Thanks to SLAB_TYPESAFE_BY_RCU we can safely try to get the
@@ -387,9 +415,9 @@ static void p9_tag_remove(struct p9_client *c, struct p9_req_t *r)
 	u16 tag = r->tc.tag;
 
 	p9_debug(P9_DEBUG_MUX, "freeing clnt %p req %p tag: %d\n", c, r, tag);
-	spin_lock_irqsave(&c->lock, flags);
-	idr_remove(&c->reqs, tag);
-	spin_unlock_irqrestore(&c->lock, flags);
+	spin_lock_irqsave(&p9_tag_to_pool(c, tag)->lock, flags);
+	idr_remove(&p9_tag_to_pool(c, tag)->reqs, tag);
+	spin_unlock_irqrestore(&p9_tag_to_pool(c, tag)->lock, flags);
 }
 
 int p9_req_put(struct p9_client *c, struct p9_req_t *r)
@@ -416,14 +444,17 @@ EXPORT_SYMBOL(p9_req_put);
 static void p9_tag_cleanup(struct p9_client *c)
 {
 	struct p9_req_t *req;
+	unsigned int i;
 	int id;
 
 	rcu_read_lock();
-	idr_for_each_entry(&c->reqs, req, id) {
-		pr_info("Tag %d still in use\n", id);
-		if (p9_req_put(c, req) == 0)
-			pr_warn("Packet with tag %d has still references",
-				req->tc.tag);
+	for (i = 0; i < c->n_pools; i++) {
+		idr_for_each_entry(&c->pools[i].reqs, req, id) {
+			pr_info("Tag %d still in use\n", id);
+			if (p9_req_put(c, req) == 0)
+				pr_warn("Packet with tag %d has still references",
+					req->tc.tag);
+		}
 	}
 	rcu_read_unlock();
 }
@@ -876,7 +907,7 @@ static void p9_fid_destroy(struct p9_fid *fid)
 	spin_lock_irqsave(&clnt->lock, flags);
 	idr_remove(&clnt->fids, fid->fid);
 	spin_unlock_irqrestore(&clnt->lock, flags);
-	kfree(fid->rdir);
+	kvfree(fid->rdir);
 	kfree(fid);
 }
 
@@ -965,6 +996,7 @@ error:
 struct p9_client *p9_client_create(const char *dev_name, char *options)
 {
 	int err;
+	unsigned int i;
 	struct p9_client *clnt;
 	char *client_id;
 
@@ -982,7 +1014,18 @@ struct p9_client *p9_client_create(const char *dev_name, char *options)
 
 	spin_lock_init(&clnt->lock);
 	idr_init(&clnt->fids);
-	idr_init(&clnt->reqs);
+
+	/* One tag pool per CPU, capped so each pool keeps a useful share
+	 * of the 16-bit tag space.
+	 */
+	clnt->n_pools = roundup_pow_of_two(min_t(unsigned int,
+						 num_possible_cpus(),
+						 P9_TAG_POOLS_MAX));
+	clnt->pool_shift = 16 - ilog2(clnt->n_pools);
+	for (i = 0; i < clnt->n_pools; i++) {
+		spin_lock_init(&clnt->pools[i].lock);
+		idr_init(&clnt->pools[i].reqs);
+	}
 
 	err = parse_opts(options, clnt);
 	if (err < 0)
@@ -1005,6 +1048,15 @@ struct p9_client *p9_client_create(const char *dev_name, char *options)
 	if (err)
 		goto put_trans;
 
+	/* Zero-copy transports carry bulk payloads in pinned pages, so a
+	 * larger msize costs only header space while cutting the number
+	 * of round trips for big reads and readdirs. Unless the user
+	 * asked for a specific msize, bid the full ring capacity and let
+	 * the server negotiate down.
+	 */
+	if (clnt->msize == DEFAULT_MSIZE && clnt->trans_mod->zc_request)
+		clnt->msize = clnt->trans_mod->maxsize;
+
 	if (clnt->msize > clnt->trans_mod->maxsize) {
 		clnt->msize = clnt->trans_mod->maxsize;
 		pr_info("Limiting 'msize' to %d as this is the maximum "
@@ -38,22 +38,57 @@
 
 #define VIRTQUEUE_NUM	128
 
+/* Upper bound on request virtqueues negotiated per device */
+#define VIRTIO_9P_MAX_VQS	16
+
+/*
+ * Multiqueue feature bit, negotiated like virtio-net's VIRTIO_NET_F_MQ.
+ * When offered by the device and accepted, requests are spread over one
+ * virtqueue per guest CPU (capped at VIRTIO_9P_MAX_VQS) instead of being
+ * serialized on a single queue. Devices that do not offer the feature
+ * keep the traditional single "requests" queue.
+ */
+#ifndef VIRTIO_9P_MQ
+#define VIRTIO_9P_MQ	1
+#endif
+
 /* a single mutex to manage channel initialization and attachment */
 static DEFINE_MUTEX(virtio_9p_lock);
 static DECLARE_WAIT_QUEUE_HEAD(vp_wq);
 static atomic_t vp_pinned = ATOMIC_INIT(0);
 
+/**
+ * struct virtio_req_vq - per-virtqueue transmit state
+ * @chan: channel this queue belongs to
+ * @vq: virtio queue used for requests
+ * @lock: protects @vq, @sg and @ring_bufs_avail
+ * @ring_bufs_avail: flag to indicate there is some available in the ring buf
+ * @vc_wq: wait queue for waiting for thing to be added to ring buf
+ * @sg: scatter gather list which is used to pack a request
+ * @name: queue name handed to virtio core
+ *
+ * Each negotiated request virtqueue gets its own lock, scatterlist and
+ * ring-full waitqueue so submissions on different queues never contend.
+ */
+struct virtio_req_vq {
+	struct virtio_chan *chan;
+	struct virtqueue *vq;
+	spinlock_t lock;
+	int ring_bufs_avail;
+	wait_queue_head_t vc_wq;
+	/* Scatterlist: can be too big for stack. */
+	struct scatterlist sg[VIRTQUEUE_NUM];
+	char name[16];
+};
+
 /**
  * struct virtio_chan - per-instance transport information
  * @inuse: whether the channel is in use
- * @lock: protects multiple elements within this structure
  * @client: client instance
  * @vdev: virtio dev associated with this channel
- * @vq: virtio queue associated with this channel
- * @ring_bufs_avail: flag to indicate there is some available in the ring buf
- * @vc_wq: wait queue for waiting for thing to be added to ring buf
+ * @vqs: request virtqueues and their per-queue state
+ * @nvqs: number of request virtqueues in @vqs
  * @p9_max_pages: maximum number of pinned pages
- * @sg: scatter gather list which is used to pack a request (protected?)
  * @chan_list: linked list of channels
  *
  * We keep all per-channel information in a structure.
@@ -65,19 +100,14 @@ static atomic_t vp_pinned = ATOMIC_INIT(0);
 struct virtio_chan {
 	bool inuse;
 
-	spinlock_t lock;
-
 	struct p9_client *client;
 	struct virtio_device *vdev;
-	struct virtqueue *vq;
-	int ring_bufs_avail;
-	wait_queue_head_t *vc_wq;
+	struct virtio_req_vq *vqs;
+	unsigned int nvqs;
 	/* This is global limit. Since we don't have a global structure,
 	 * will be placing it in each channel.
 	 */
 	unsigned long p9_max_pages;
-	/* Scatterlist: can be too big for stack. */
-	struct scatterlist sg[VIRTQUEUE_NUM];
 	/**
 	 * @tag: name to identify a mount null terminated
 	 */
@@ -86,6 +116,12 @@ struct virtio_chan {
 	struct list_head chan_list;
 };
 
+/* Requests are spread over the negotiated queues by submitting CPU */
+static struct virtio_req_vq *chan_req_vq(struct virtio_chan *chan)
+{
+	return &chan->vqs[raw_smp_processor_id() % chan->nvqs];
+}
+
 static struct list_head virtio_chan_list;
 
 /* How many bytes left in this page. */
@@ -129,6 +165,7 @@ static void p9_virtio_close(struct p9_client *client)
 static void req_done(struct virtqueue *vq)
 {
 	struct virtio_chan *chan = vq->vdev->priv;
+	struct virtio_req_vq *rvq = &chan->vqs[vq->index];
 	unsigned int len;
 	struct p9_req_t *req;
 	bool need_wakeup = false;
@@ -136,10 +173,10 @@ static void req_done(struct virtqueue *vq)
 
 	p9_debug(P9_DEBUG_TRANS, ": request done\n");
 
-	spin_lock_irqsave(&chan->lock, flags);
-	while ((req = virtqueue_get_buf(chan->vq, &len)) != NULL) {
-		if (!chan->ring_bufs_avail) {
-			chan->ring_bufs_avail = 1;
+	spin_lock_irqsave(&rvq->lock, flags);
+	while ((req = virtqueue_get_buf(rvq->vq, &len)) != NULL) {
+		if (!rvq->ring_bufs_avail) {
+			rvq->ring_bufs_avail = 1;
 			need_wakeup = true;
 		}
 
@@ -148,10 +185,10 @@ static void req_done(struct virtqueue *vq)
 			p9_client_cb(chan->client, req, REQ_STATUS_RCVD);
 		}
 	}
-	spin_unlock_irqrestore(&chan->lock, flags);
+	spin_unlock_irqrestore(&rvq->lock, flags);
 	/* Wakeup if anyone waiting for VirtIO ring space. */
 	if (need_wakeup)
-		wake_up(chan->vc_wq);
+		wake_up(&rvq->vc_wq);
 }
 
 /**
@@ -259,48 +296,49 @@ p9_virtio_request(struct p9_client *client, struct p9_req_t *req)
 	int in, out, out_sgs, in_sgs;
 	unsigned long flags;
 	struct virtio_chan *chan = client->trans;
+	struct virtio_req_vq *rvq = chan_req_vq(chan);
 	struct scatterlist *sgs[2];
 
 	p9_debug(P9_DEBUG_TRANS, "9p debug: virtio request\n");
 
 	WRITE_ONCE(req->status, REQ_STATUS_SENT);
 req_retry:
-	spin_lock_irqsave(&chan->lock, flags);
+	spin_lock_irqsave(&rvq->lock, flags);
 
 	out_sgs = in_sgs = 0;
 	/* Handle out VirtIO ring buffers */
-	out = pack_sg_list(chan->sg, 0,
+	out = pack_sg_list(rvq->sg, 0,
 			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
 	if (out)
-		sgs[out_sgs++] = chan->sg;
+		sgs[out_sgs++] = rvq->sg;
 
-	in = pack_sg_list(chan->sg, out,
+	in = pack_sg_list(rvq->sg, out,
 			  VIRTQUEUE_NUM, req->rc.sdata, req->rc.capacity);
 	if (in)
-		sgs[out_sgs + in_sgs++] = chan->sg + out;
+		sgs[out_sgs + in_sgs++] = rvq->sg + out;
 
-	err = virtqueue_add_sgs(chan->vq, sgs, out_sgs, in_sgs, req,
+	err = virtqueue_add_sgs(rvq->vq, sgs, out_sgs, in_sgs, req,
 				GFP_ATOMIC);
 	if (err < 0) {
 		if (err == -ENOSPC) {
-			chan->ring_bufs_avail = 0;
-			spin_unlock_irqrestore(&chan->lock, flags);
-			err = wait_event_killable(*chan->vc_wq,
-						  chan->ring_bufs_avail);
+			rvq->ring_bufs_avail = 0;
+			spin_unlock_irqrestore(&rvq->lock, flags);
+			err = wait_event_killable(rvq->vc_wq,
+						  rvq->ring_bufs_avail);
 			if (err  == -ERESTARTSYS)
 				return err;
 
 			p9_debug(P9_DEBUG_TRANS, "Retry virtio request\n");
 			goto req_retry;
 		} else {
-			spin_unlock_irqrestore(&chan->lock, flags);
+			spin_unlock_irqrestore(&rvq->lock, flags);
 			p9_debug(P9_DEBUG_TRANS,
 				 "virtio rpc add_sgs returned failure\n");
 			return -EIO;
 		}
 	}
-	virtqueue_kick(chan->vq);
-	spin_unlock_irqrestore(&chan->lock, flags);
+	virtqueue_kick(rvq->vq);
+	spin_unlock_irqrestore(&rvq->lock, flags);
 
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	return 0;
@@ -428,6 +466,7 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	int in_nr_pages = 0, out_nr_pages = 0;
 	struct page **in_pages = NULL, **out_pages = NULL;
 	struct virtio_chan *chan = client->trans;
+	struct virtio_req_vq *rvq = chan_req_vq(chan);
 	struct scatterlist *sgs[4];
 	size_t offs = 0;
 	int need_drop = 0;
@@ -471,20 +510,20 @@ p9_virtio_zc_request(struct p9_client *client, struct p9_req_t *req,
 	}
 	WRITE_ONCE(req->status, REQ_STATUS_SENT);
 req_retry_pinned:
-	spin_lock_irqsave(&chan->lock, flags);
+	spin_lock_irqsave(&rvq->lock, flags);
 
 	out_sgs = in_sgs = 0;
 
 	/* out data */
-	out = pack_sg_list(chan->sg, 0,
+	out = pack_sg_list(rvq->sg, 0,
 			   VIRTQUEUE_NUM, req->tc.sdata, req->tc.size);
 
 	if (out)
-		sgs[out_sgs++] = chan->sg;
+		sgs[out_sgs++] = rvq->sg;
 
 	if (out_pages) {
-		sgs[out_sgs++] = chan->sg + out;
-		out += pack_sg_list_p(chan->sg, out, VIRTQUEUE_NUM,
+		sgs[out_sgs++] = rvq->sg + out;
+		out += pack_sg_list_p(rvq->sg, out, VIRTQUEUE_NUM,
 				      out_pages, out_nr_pages, offs, outlen);
 	}
 
@@ -495,41 +534,41 @@ req_retry_pinned:
 	 * Arrange in such a way that server places header in the
 	 * allocated memory and payload onto the user buffer.
 	 */
-	in = pack_sg_list(chan->sg, out,
+	in = pack_sg_list(rvq->sg, out,
 			  VIRTQUEUE_NUM, req->rc.sdata, in_hdr_len);
 	if (in)
-		sgs[out_sgs + in_sgs++] = chan->sg + out;
+		sgs[out_sgs + in_sgs++] = rvq->sg + out;
 
 	if (in_pages) {
-		sgs[out_sgs + in_sgs++] = chan->sg + out + in;
-		in += pack_sg_list_p(chan->sg, out + in, VIRTQUEUE_NUM,
+		sgs[out_sgs + in_sgs++] = rvq->sg + out + in;
+		in += pack_sg_list_p(rvq->sg, out + in, VIRTQUEUE_NUM,
 				     in_pages, in_nr_pages, offs, inlen);
 	}
 
 	BUG_ON(out_sgs + in_sgs > ARRAY_SIZE(sgs));
-	err = virtqueue_add_sgs(chan->vq, sgs, out_sgs, in_sgs, req,
+	err = virtqueue_add_sgs(rvq->vq, sgs, out_sgs, in_sgs, req,
 				GFP_ATOMIC);
 	if (err < 0) {
 		if (err == -ENOSPC) {
-			chan->ring_bufs_avail = 0;
-			spin_unlock_irqrestore(&chan->lock, flags);
-			err = wait_event_killable(*chan->vc_wq,
-						  chan->ring_bufs_avail);
+			rvq->ring_bufs_avail = 0;
+			spin_unlock_irqrestore(&rvq->lock, flags);
+			err = wait_event_killable(rvq->vc_wq,
+						  rvq->ring_bufs_avail);
 			if (err  == -ERESTARTSYS)
 				goto err_out;
 
 			p9_debug(P9_DEBUG_TRANS, "Retry virtio request\n");
 			goto req_retry_pinned;
 		} else {
-			spin_unlock_irqrestore(&chan->lock, flags);
+			spin_unlock_irqrestore(&rvq->lock, flags);
 			p9_debug(P9_DEBUG_TRANS,
 				 "virtio rpc add_sgs returned failure\n");
 			err = -EIO;
 			goto err_out;
 		}
 	}
-	virtqueue_kick(chan->vq);
-	spin_unlock_irqrestore(&chan->lock, flags);
+	virtqueue_kick(rvq->vq);
+	spin_unlock_irqrestore(&rvq->lock, flags);
 	kicked = 1;
 	p9_debug(P9_DEBUG_TRANS, "virtio request kicked\n");
 	err = wait_event_killable(req->wq,
@@ -582,6 +621,70 @@ static ssize_t p9_mount_tag_show(struct device *dev,
 
 static DEVICE_ATTR(mount_tag, 0444, p9_mount_tag_show, NULL);
 
+/**
+ * p9_virtio_find_vqs - allocate and set up request virtqueues
+ * @chan: channel being probed
+ * @nvqs: number of request virtqueues to ask the device for
+ *
+ * Returns 0 with @chan->vqs and @chan->nvqs populated, or a negative
+ * errno if the device could not supply @nvqs queues.
+ */
+static int p9_virtio_find_vqs(struct virtio_chan *chan, unsigned int nvqs)
+{
+	vq_callback_t **callbacks;
+	struct virtqueue **vqs;
+	const char **names;
+	unsigned int i;
+	int err = -ENOMEM;
+
+	chan->vqs = kcalloc(nvqs, sizeof(*chan->vqs), GFP_KERNEL);
+	if (!chan->vqs)
+		return -ENOMEM;
+
+	vqs = kcalloc(nvqs, sizeof(*vqs), GFP_KERNEL);
+	callbacks = kcalloc(nvqs, sizeof(*callbacks), GFP_KERNEL);
+	names = kcalloc(nvqs, sizeof(*names), GFP_KERNEL);
+	if (!vqs || !callbacks || !names)
+		goto out;
+
+	for (i = 0; i < nvqs; i++) {
+		callbacks[i] = req_done;
+		if (nvqs > 1)
+			snprintf(chan->vqs[i].name, sizeof(chan->vqs[i].name),
+				 "requests.%u", i);
+		else
+			snprintf(chan->vqs[i].name, sizeof(chan->vqs[i].name),
+				 "requests");
+		names[i] = chan->vqs[i].name;
+	}
+
+	err = virtio_find_vqs(chan->vdev, nvqs, vqs, callbacks, names, NULL);
+	if (err)
+		goto out;
+
+	for (i = 0; i < nvqs; i++) {
+		struct virtio_req_vq *rvq = &chan->vqs[i];
+
+		rvq->chan = chan;
+		rvq->vq = vqs[i];
+		spin_lock_init(&rvq->lock);
+		init_waitqueue_head(&rvq->vc_wq);
+		rvq->ring_bufs_avail = 1;
+		sg_init_table(rvq->sg, VIRTQUEUE_NUM);
+	}
+	chan->nvqs = nvqs;
+
+out:
+	kfree(names);
+	kfree(callbacks);
+	kfree(vqs);
+	if (err) {
+		kfree(chan->vqs);
+		chan->vqs = NULL;
+	}
+	return err;
+}
+
 /**
  * p9_virtio_probe - probe for existence of 9P virtio channels
  * @vdev: virtio device to probe
@@ -594,6 +697,7 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 {
 	__u16 tag_len;
 	char *tag;
+	unsigned int nvqs;
 	int err;
 	struct virtio_chan *chan;
 
@@ -611,17 +715,21 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 	}
 
 	chan->vdev = vdev;
+	vdev->priv = chan;
 
-	/* We expect one virtqueue, for requests. */
-	chan->vq = virtio_find_single_vq(vdev, req_done, "requests");
-	if (IS_ERR(chan->vq)) {
-		err = PTR_ERR(chan->vq);
-		goto out_free_chan;
-	}
-	chan->vq->vdev->priv = chan;
-	spin_lock_init(&chan->lock);
+	nvqs = 1;
+	if (virtio_has_feature(vdev, VIRTIO_9P_MQ))
+		nvqs = min_t(unsigned int, num_online_cpus(),
+			     VIRTIO_9P_MAX_VQS);
 
-	sg_init_table(chan->sg, VIRTQUEUE_NUM);
+	/* The device has no config field advertising a queue count, so
+	 * fall back towards a single queue if it cannot supply one per
+	 * CPU.
+	 */
+	while ((err = p9_virtio_find_vqs(chan, nvqs)) && nvqs > 1)
+		nvqs /= 2;
+	if (err)
+		goto out_free_chan;
 
 	chan->inuse = false;
 	if (virtio_has_feature(vdev, VIRTIO_9P_MOUNT_TAG)) {
@@ -643,13 +751,6 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 	if (err) {
 		goto out_free_tag;
 	}
-	chan->vc_wq = kmalloc(sizeof(wait_queue_head_t), GFP_KERNEL);
-	if (!chan->vc_wq) {
-		err = -ENOMEM;
-		goto out_remove_file;
-	}
-	init_waitqueue_head(chan->vc_wq);
-	chan->ring_bufs_avail = 1;
 	/* Ceiling limit to avoid denial of service attacks */
 	chan->p9_max_pages = nr_free_buffer_pages()/4;
 
@@ -664,12 +765,11 @@ static int p9_virtio_probe(struct virtio_device *vdev)
 
 	return 0;
 
-out_remove_file:
-	sysfs_remove_file(&vdev->dev.kobj, &dev_attr_mount_tag.attr);
 out_free_tag:
 	kfree(tag);
 out_free_vq:
 	vdev->config->del_vqs(vdev);
+	kfree(chan->vqs);
 out_free_chan:
 	kfree(chan);
 fail:
@@ -763,7 +863,7 @@ static void p9_virtio_remove(struct virtio_device *vdev)
 	sysfs_remove_file(&(vdev->dev.kobj), &dev_attr_mount_tag.attr);
 	kobject_uevent(&(vdev->dev.kobj), KOBJ_CHANGE);
 	kfree(chan->tag);
-	kfree(chan->vc_wq);
+	kfree(chan->vqs);
 	kfree(chan);
 
 }
@@ -775,6 +875,7 @@ static struct virtio_device_id id_table[] = {
 
 static unsigned int features[] = {
 	VIRTIO_9P_MOUNT_TAG,
+	VIRTIO_9P_MQ,
 };
 
 /* The standard "struct lguest_driver": */
@@ -8,6 +8,14 @@
 #include <net/genetlink.h>
 #include <net/sock.h>
 
+/* mirrors the uapi value; request flag asking for each statistics group to
+ * be returned as one 64-bit aligned binary block instead of one attribute
+ * per counter
+ */
+#ifndef ETHTOOL_FLAG_COMPACT_STATS
+#define ETHTOOL_FLAG_COMPACT_STATS	(1 << 3)
+#endif
+
 struct ethnl_req_info;
 
 int ethnl_parse_header_dev_get(struct ethnl_req_info *req_info,
@@ -349,6 +357,7 @@ extern const struct ethnl_request_ops ethnl_pse_request_ops;
 
 extern const struct nla_policy ethnl_header_policy[ETHTOOL_A_HEADER_FLAGS + 1];
 extern const struct nla_policy ethnl_header_policy_stats[ETHTOOL_A_HEADER_FLAGS + 1];
+extern const struct nla_policy ethnl_header_policy_compact_stats[ETHTOOL_A_HEADER_FLAGS + 1];
 extern const struct nla_policy ethnl_strset_get_policy[ETHTOOL_A_STRSET_COUNTS_ONLY + 1];
 extern const struct nla_policy ethnl_linkinfo_get_policy[ETHTOOL_A_LINKINFO_HEADER + 1];
 extern const struct nla_policy ethnl_linkinfo_set_policy[ETHTOOL_A_LINKINFO_TP_MDIX_CTRL + 1];
@@ -75,9 +75,14 @@ const char stats_rmon_names[__ETHTOOL_A_STATS_RMON_CNT][ETH_GSTRING_LEN] = {
 	[ETHTOOL_A_STATS_RMON_JABBER]		= "etherStatsJabbers",
 };
 
+/* mirrors the next free uapi value in the ETHTOOL_A_STATS_GRP_* enum */
+#ifndef ETHTOOL_A_STATS_GRP_STAT_BLOCK
+#define ETHTOOL_A_STATS_GRP_STAT_BLOCK	(ETHTOOL_A_STATS_GRP_HIST_VAL + 1)
+#endif
+
 const struct nla_policy ethnl_stats_get_policy[ETHTOOL_A_STATS_GROUPS + 1] = {
 	[ETHTOOL_A_STATS_HEADER]	=
-		NLA_POLICY_NESTED(ethnl_header_policy),
+		NLA_POLICY_NESTED(ethnl_header_policy_compact_stats),
 	[ETHTOOL_A_STATS_GROUPS]	= { .type = NLA_NESTED },
 };
 
@@ -172,6 +177,9 @@ static int stats_reply_size(const struct ethnl_req_info *req_base,
 	len += n_grps * (nla_total_size(0) + /* _A_STATS_GRP */
 			 nla_total_size(4) + /* _A_STATS_GRP_ID */
 			 nla_total_size(4)); /* _A_STATS_GRP_SS_ID */
+	/* an upper bound for ETHTOOL_FLAG_COMPACT_STATS replies, too: the
+	 * per-group binary block is smaller than one nest per counter
+	 */
 	len += n_stats * (nla_total_size(0) + /* _A_STATS_GRP_STAT */
 			  nla_total_size_64bit(sizeof(u64)));
 
@@ -371,6 +379,78 @@ err_cancel:
 	return -EMSGSIZE;
 }
 
+/* Pack a whole statistics group as one 64-bit aligned binary attribute
+ * holding the u64 counters in the same order as the group's kernel stats
+ * structure (which follows the standard's counter numbering, like the
+ * per-counter attributes do).  Counters the driver did not set are
+ * reported as ETHTOOL_STAT_NOT_SET.  This keeps high-frequency scraping
+ * cheap: one attribute per group instead of one nest per counter.
+ */
+static int stats_put_stat_block(struct sk_buff *skb,
+				const struct stats_reply_data *data,
+				u32 id, u32 ss_id,
+				const void *stats, unsigned int len)
+{
+	struct nlattr *nest;
+
+	nest = nla_nest_start(skb, ETHTOOL_A_STATS_GRP);
+	if (!nest)
+		return -EMSGSIZE;
+
+	if (nla_put_u32(skb, ETHTOOL_A_STATS_GRP_ID, id) ||
+	    nla_put_u32(skb, ETHTOOL_A_STATS_GRP_SS_ID, ss_id))
+		goto err_cancel;
+
+	if (nla_put_64bit(skb, ETHTOOL_A_STATS_GRP_STAT_BLOCK, len, stats,
+			  ETHTOOL_A_STATS_GRP_PAD))
+		goto err_cancel;
+
+	/* the histogram buckets are in the block, the ranges are not */
+	if (id == ETHTOOL_STATS_RMON &&
+	    (stats_put_rmon_hist(skb, ETHTOOL_A_STATS_GRP_HIST_RX,
+				 data->rmon_stats.hist, data->rmon_ranges) ||
+	     stats_put_rmon_hist(skb, ETHTOOL_A_STATS_GRP_HIST_TX,
+				 data->rmon_stats.hist_tx, data->rmon_ranges)))
+		goto err_cancel;
+
+	nla_nest_end(skb, nest);
+	return 0;
+
+err_cancel:
+	nla_nest_cancel(skb, nest);
+	return -EMSGSIZE;
+}
+
+static int stats_fill_reply_compact(struct sk_buff *skb,
+				    const struct stats_req_info *req_info,
+				    const struct stats_reply_data *data)
+{
+	int ret = 0;
+
+	if (!ret && test_bit(ETHTOOL_STATS_ETH_PHY, req_info->stat_mask))
+		ret = stats_put_stat_block(skb, data, ETHTOOL_STATS_ETH_PHY,
+					   ETH_SS_STATS_ETH_PHY,
+					   &data->phy_stats,
+					   sizeof(data->phy_stats));
+	if (!ret && test_bit(ETHTOOL_STATS_ETH_MAC, req_info->stat_mask))
+		ret = stats_put_stat_block(skb, data, ETHTOOL_STATS_ETH_MAC,
+					   ETH_SS_STATS_ETH_MAC,
+					   &data->mac_stats,
+					   sizeof(data->mac_stats));
+	if (!ret && test_bit(ETHTOOL_STATS_ETH_CTRL, req_info->stat_mask))
+		ret = stats_put_stat_block(skb, data, ETHTOOL_STATS_ETH_CTRL,
+					   ETH_SS_STATS_ETH_CTRL,
+					   &data->ctrl_stats,
+					   sizeof(data->ctrl_stats));
+	if (!ret && test_bit(ETHTOOL_STATS_RMON, req_info->stat_mask))
+		ret = stats_put_stat_block(skb, data, ETHTOOL_STATS_RMON,
+					   ETH_SS_STATS_RMON,
+					   &data->rmon_stats,
+					   sizeof(data->rmon_stats));
+
+	return ret;
+}
+
 static int stats_fill_reply(struct sk_buff *skb,
 			    const struct ethnl_req_info *req_base,
 			    const struct ethnl_reply_data *reply_base)
@@ -379,6 +459,9 @@ static int stats_fill_reply(struct sk_buff *skb,
 	const struct stats_reply_data *data = STATS_REPDATA(reply_base);
 	int ret = 0;
 
+	if (req_base->flags & ETHTOOL_FLAG_COMPACT_STATS)
+		return stats_fill_reply_compact(skb, req_info, data);
+
 	if (!ret && test_bit(ETHTOOL_STATS_ETH_PHY, req_info->stat_mask))
 		ret = stats_put_stats(skb, data, ETHTOOL_STATS_ETH_PHY,
 				      ETH_SS_STATS_ETH_PHY,
@@ -639,6 +639,7 @@ do_frag_list:
 		for (fragidx = 0; fragidx < skb_shinfo(skb)->nr_frags;
 		     fragidx++) {
 			skb_frag_t *frag;
+			int flags;
 
 			frag_offset = 0;
 do_frag:
@@ -648,11 +649,21 @@ do_frag:
 				goto out;
 			}
 
+			/* Let the transport coalesce fragments of the same
+			 * message instead of pushing each one on the wire
+			 * on its own.
+			 */
+			flags = MSG_DONTWAIT;
+			if (fragidx != skb_shinfo(skb)->nr_frags - 1 ||
+			    (skb == head ? skb_has_frag_list(skb) :
+					   !!skb->next))
+				flags |= MSG_MORE | MSG_SENDPAGE_NOTLAST;
+
 			ret = kernel_sendpage(psock->sk->sk_socket,
 					      skb_frag_page(frag),
 					      skb_frag_off(frag) + frag_offset,
 					      skb_frag_size(frag) - frag_offset,
-					      MSG_DONTWAIT);
+					      flags);
 			if (ret <= 0) {
 				if (ret == -EAGAIN) {
 					/* Save state to try again when there's
@@ -6,6 +6,7 @@
 
 #include <linux/rcupdate.h>
 #include <linux/jhash.h>
+#include <linux/prefetch.h>
 #include <linux/types.h>
 #include <linux/netfilter/nfnetlink.h>
 #include <linux/netfilter/ipset/ip_set.h>
@@ -1173,11 +1174,28 @@ mtype_test_cidrs(struct ip_set *set, struct mtype_elem *d,
 #endif
 		key = HKEY(d, h->initval, t->htable_bits);
 		n = rcu_dereference_bh(hbucket(t, key));
+#if IPSET_NET_COUNT != 2
+		/* Overlap the next net length's bucket slot fetch with
+		 * this walk: the masks only shrink, so masking a copy
+		 * ahead of time yields the key the next iteration will
+		 * compute.
+		 */
+		if (j + 1 < NLEN && h->nets[j + 1].cidr[0]) {
+			struct mtype_elem next = *d;
+
+			mtype_data_netmask(&next,
+					   NCIDR_GET(h->nets[j + 1].cidr[0]));
+			prefetch(&hbucket(t, HKEY(&next, h->initval,
+						  t->htable_bits)));
+		}
+#endif
 		if (!n)
 			continue;
 		for (i = 0; i < n->pos; i++) {
 			if (!test_bit(i, n->used))
 				continue;
+			if (i + 1 < n->pos)
+				prefetch(ahash_data(n, i + 1, set->dsize));
 			data = ahash_data(n, i, set->dsize);
 			if (!mtype_data_equal(data, d, &multi))
 				continue;
@@ -1234,6 +1252,8 @@ mtype_test(struct ip_set *set, void *value, const struct ip_set_ext *ext,
 	for (i = 0; i < n->pos; i++) {
 		if (!test_bit(i, n->used))
 			continue;
+		if (i + 1 < n->pos)
+			prefetch(ahash_data(n, i + 1, set->dsize));
 		data = ahash_data(n, i, set->dsize);
 		if (!mtype_data_equal(data, d, &multi))
 			continue;
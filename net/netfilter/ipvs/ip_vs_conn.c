@@ -32,6 +32,8 @@
 #include <linux/seq_file.h>
 #include <linux/jhash.h>
 #include <linux/random.h>
+#include <linux/mm.h>
+#include <linux/log2.h>
 
 #include <net/net_namespace.h>
 #include <net/ip_vs.h>
@@ -42,11 +44,12 @@
 #endif
 
 /*
- * Connection hash size. Default is what was selected at compile time.
+ * Connection hash size. Zero (the default) sizes the table from the
+ * amount of memory, with the compile time selection as the floor.
 */
-static int ip_vs_conn_tab_bits = CONFIG_IP_VS_TAB_BITS;
+static int ip_vs_conn_tab_bits;
 module_param_named(conn_tab_bits, ip_vs_conn_tab_bits, int, 0444);
-MODULE_PARM_DESC(conn_tab_bits, "Set connections' hash size");
+MODULE_PARM_DESC(conn_tab_bits, "Set connections' hash size (0: memory scaled)");
 
 /* size and mask values */
 int ip_vs_conn_tab_size __read_mostly;
@@ -469,7 +472,19 @@ static void __ip_vs_conn_put_timer(struct ip_vs_conn *cp)
 {
 	unsigned long t = (cp->flags & IP_VS_CONN_F_ONE_PACKET) ?
 		0 : cp->timeout;
-	mod_timer(&cp->timer, jiffies+t);
+	unsigned long expires = jiffies + t;
+
+	/* The timer is only an idle limit, so re-arming can be
+	 * batched: leave the pending expiry alone while it is within
+	 * t >> 6 (~1.5%) of the target. That caps how early a
+	 * connection can expire while sparing the per-packet
+	 * mod_timer() on busy connections. A shrunken timeout (state
+	 * transition) still re-arms immediately.
+	 */
+	if (!timer_pending(&cp->timer) ||
+	    !time_in_range(expires, cp->timer.expires,
+			   cp->timer.expires + (t >> 6)))
+		mod_timer(&cp->timer, expires);
 
 	__ip_vs_conn_put(cp);
 }
@@ -1485,8 +1500,16 @@ int __init ip_vs_conn_init(void)
 
 	/* Compute size and mask */
 	if (ip_vs_conn_tab_bits < 8 || ip_vs_conn_tab_bits > 27) {
-		pr_info("conn_tab_bits not in [8, 27]. Using default value\n");
-		ip_vs_conn_tab_bits = CONFIG_IP_VS_TAB_BITS;
+		/* Aim at one bucket per 16K of memory, so chains stay
+		 * short when the connection count grows with the
+		 * machine (16GB gives the 2^20 cap), without letting
+		 * the heads outgrow a fraction of a percent of it.
+		 */
+		int scaled = order_base_2(totalram_pages()) + PAGE_SHIFT - 14;
+
+		if (ip_vs_conn_tab_bits)
+			pr_info("conn_tab_bits not in [8, 27]. Using memory scaled value\n");
+		ip_vs_conn_tab_bits = clamp(scaled, CONFIG_IP_VS_TAB_BITS, 20);
 	}
 	ip_vs_conn_tab_size = 1 << ip_vs_conn_tab_bits;
 	ip_vs_conn_tab_mask = ip_vs_conn_tab_size - 1;
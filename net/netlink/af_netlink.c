@@ -567,6 +567,128 @@ netlink_update_listeners(struct sock *sk)
 	 * makes sure updates are visible before bind or setsockopt return. */
 }
 
+/* Per-group delivery lists.
+ *
+ * netlink_broadcast() used to walk every multicast-bound socket of the
+ * protocol for each message, so a notification storm on one group taxed
+ * all netlink users. Each subscription is therefore also linked on a
+ * per-group list that the broadcast path walks instead.
+ *
+ * All list updates run with the netlink table grabbed, which drains
+ * concurrent broadcasters (nl_table_users), so the walk needs no extra
+ * locking and may sleep in skb_clone(). Should a link or array
+ * allocation fail, sharding is torn down for the table and broadcasts
+ * fall back to the full mc_list walk until a later membership change
+ * rebuilds the lists.
+ */
+struct netlink_grp_link {
+	struct hlist_node	grp_node;	/* on table's per-group list */
+	struct list_head	sk_node;	/* on socket's membership list */
+	struct sock		*sk;
+	u32			group;
+};
+
+static void netlink_purge_mc_links(struct sock *sk)
+{
+	struct netlink_grp_link *link, *tmp;
+
+	list_for_each_entry_safe(link, tmp, &nlk_sk(sk)->mc_memberships,
+				 sk_node) {
+		hlist_del(&link->grp_node);
+		list_del(&link->sk_node);
+		kfree(link);
+	}
+}
+
+static void netlink_mc_groups_disable(struct netlink_table *tbl)
+{
+	struct sock *sk;
+
+	sk_for_each_bound(sk, &tbl->mc_list)
+		netlink_purge_mc_links(sk);
+	kfree(tbl->mc_groups);
+	tbl->mc_groups = NULL;
+	tbl->mc_ngroups = 0;
+}
+
+/* Bring @sk's per-group links in line with its groups bitmap */
+static bool __netlink_sync_mc_links(struct netlink_table *tbl, struct sock *sk)
+{
+	struct netlink_sock *nlk = nlk_sk(sk);
+	struct netlink_grp_link *link, *tmp;
+	unsigned int group;
+
+	list_for_each_entry_safe(link, tmp, &nlk->mc_memberships, sk_node) {
+		if (link->group < nlk->ngroups &&
+		    test_bit(link->group, nlk->groups))
+			continue;
+		hlist_del(&link->grp_node);
+		list_del(&link->sk_node);
+		kfree(link);
+	}
+
+	if (!nlk->groups)
+		return true;
+
+	for_each_set_bit(group, nlk->groups,
+			 min(nlk->ngroups, tbl->mc_ngroups)) {
+		bool found = false;
+
+		list_for_each_entry(link, &nlk->mc_memberships, sk_node) {
+			if (link->group == group) {
+				found = true;
+				break;
+			}
+		}
+		if (found)
+			continue;
+
+		link = kmalloc(sizeof(*link), GFP_ATOMIC);
+		if (!link)
+			return false;
+
+		link->sk = sk;
+		link->group = group;
+		hlist_add_head(&link->grp_node, &tbl->mc_groups[group]);
+		list_add(&link->sk_node, &nlk->mc_memberships);
+	}
+
+	return true;
+}
+
+/* Must be called with the netlink table grabbed, after @sk's groups
+ * bitmap has been updated.
+ */
+static void netlink_update_mc_groups(struct sock *sk)
+{
+	struct netlink_table *tbl = &nl_table[sk->sk_protocol];
+	struct sock *osk;
+
+	if (!tbl->mc_groups) {
+		if (!tbl->groups)
+			return;
+
+		tbl->mc_groups = kcalloc(tbl->groups,
+					 sizeof(*tbl->mc_groups), GFP_ATOMIC);
+		if (!tbl->mc_groups)
+			return;
+		tbl->mc_ngroups = tbl->groups;
+
+		/* First use (or recovery from an allocation failure):
+		 * rebuild the lists from every bound socket.
+		 */
+		sk_for_each_bound(osk, &tbl->mc_list) {
+			if (!__netlink_sync_mc_links(tbl, osk)) {
+				netlink_mc_groups_disable(tbl);
+				return;
+			}
+		}
+	}
+
+	if (!__netlink_sync_mc_links(tbl, sk))
+		netlink_mc_groups_disable(tbl);
+}
+
 static int netlink_insert(struct sock *sk, u32 portid)
 {
 	struct netlink_table *table = &nl_table[sk->sk_protocol];
@@ -620,6 +742,7 @@ static void netlink_remove(struct sock *sk)
 	}
 
 	netlink_table_grab();
+	netlink_purge_mc_links(sk);
 	if (nlk_sk(sk)->subscriptions) {
 		__sk_del_bind_node(sk);
 		netlink_update_listeners(sk);
@@ -661,6 +784,7 @@ static int __netlink_create(struct net *net, struct socket *sock,
 					   nlk_cb_mutex_key_strings[protocol]);
 	}
 	init_waitqueue_head(&nlk->wait);
+	INIT_LIST_HEAD(&nlk->mc_memberships);
 
 	sk->sk_destruct = netlink_sock_destruct;
 	sk->sk_protocol = protocol;
@@ -1064,6 +1188,7 @@ static int netlink_bind(struct socket *sock, struct sockaddr *addr,
 					 hweight32(nlk->groups[0]));
 	nlk->groups[0] = (nlk->groups[0] & ~0xffffffffUL) | groups;
 	netlink_update_listeners(sk);
+	netlink_update_mc_groups(sk);
 	netlink_table_ungrab();
 
 	return 0;
@@ -1497,6 +1622,7 @@ int netlink_broadcast(struct sock *ssk, struct sk_buff *skb, u32 portid,
 {
 	struct net *net = sock_net(ssk);
 	struct netlink_broadcast_data info;
+	struct netlink_table *tbl;
 	struct sock *sk;
 
 	skb = netlink_trim(skb, allocation);
@@ -1517,8 +1643,17 @@ int netlink_broadcast(struct sock *ssk, struct sk_buff *skb, u32 portid,
 
 	netlink_lock_table();
 
-	sk_for_each_bound(sk, &nl_table[ssk->sk_protocol].mc_list)
-		do_one_broadcast(sk, &info);
+	tbl = &nl_table[ssk->sk_protocol];
+	if (tbl->mc_groups && group && group <= tbl->mc_ngroups) {
+		struct netlink_grp_link *link;
+
+		hlist_for_each_entry(link, &tbl->mc_groups[group - 1],
+				     grp_node)
+			do_one_broadcast(link->sk, &info);
+	} else {
+		sk_for_each_bound(sk, &tbl->mc_list)
+			do_one_broadcast(sk, &info);
+	}
 
 	consume_skb(skb);
 
@@ -1620,6 +1755,7 @@ static void netlink_update_socket_mc(struct netlink_sock *nlk,
 		__clear_bit(group - 1, nlk->groups);
 	netlink_update_subscriptions(&nlk->sk, subscriptions);
 	netlink_update_listeners(&nlk->sk);
+	netlink_update_mc_groups(&nlk->sk);
 }
 
 static int netlink_setsockopt(struct socket *sock, int level, int optname,
@@ -2082,6 +2218,22 @@ int __netlink_change_ngroups(struct sock *sk, unsigned int groups)
 	}
 	tbl->groups = groups;
 
+	if (tbl->mc_groups && groups > tbl->mc_ngroups) {
+		struct hlist_head *grps;
+		unsigned int i;
+
+		grps = kcalloc(groups, sizeof(*grps), GFP_ATOMIC);
+		if (!grps) {
+			netlink_mc_groups_disable(tbl);
+			return 0;
+		}
+		for (i = 0; i < tbl->mc_ngroups; i++)
+			hlist_move_list(&tbl->mc_groups[i], &grps[i]);
+		kfree(tbl->mc_groups);
+		tbl->mc_groups = grps;
+		tbl->mc_ngroups = groups;
+	}
+
 	return 0;
 }
 
@@ -49,6 +49,7 @@ struct netlink_sock {
 	struct rhash_head	node;
 	struct rcu_head		rcu;
 	struct work_struct	work;
+	struct list_head	mc_memberships;
 };
 
 static inline struct netlink_sock *nlk_sk(struct sock *sk)
@@ -61,6 +62,8 @@ static inline struct netlink_sock *nlk_sk(struct sock *sk)
 struct netlink_table {
 	struct rhashtable	hash;
 	struct hlist_head	mc_list;
+	struct hlist_head	*mc_groups;
+	unsigned int		mc_ngroups;
 	struct listeners __rcu	*listeners;
 	unsigned int		flags;
 	unsigned int		groups;
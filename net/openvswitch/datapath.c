@@ -134,6 +134,14 @@ static int queue_userspace_packet(struct datapath *dp, struct sk_buff *,
 
 static void ovs_dp_masks_rebalance(struct work_struct *work);
 
+/* Per-mask hit histogram dumped with the datapath info.  Mirrors the
+ * uapi value from include/uapi/linux/openvswitch.h for older headers.
+ */
+#ifndef OVS_DP_ATTR_MASKS_HIT
+#define OVS_DP_ATTR_MASKS_HIT (OVS_DP_ATTR_IFINDEX + 1)
+#endif
+#define OVS_DP_MASKS_HIT_MAX 64
+
 static int ovs_dp_set_upcall_portids(struct datapath *, const struct nlattr *);
 
 /* Must be called with rcu_read_lock or ovs_mutex. */
@@ -1533,6 +1541,7 @@ static size_t ovs_dp_cmd_msg_size(void)
 	msgsize += nla_total_size(sizeof(u32)); /* OVS_DP_ATTR_USER_FEATURES */
 	msgsize += nla_total_size(sizeof(u32)); /* OVS_DP_ATTR_MASKS_CACHE_SIZE */
 	msgsize += nla_total_size(sizeof(u32) * nr_cpu_ids); /* OVS_DP_ATTR_PER_CPU_PIDS */
+	msgsize += nla_total_size(sizeof(u64) * OVS_DP_MASKS_HIT_MAX); /* OVS_DP_ATTR_MASKS_HIT */
 
 	return msgsize;
 }
@@ -1546,6 +1555,7 @@ static int ovs_dp_cmd_fill_info(struct datapath *dp, struct sk_buff *skb,
 	struct ovs_dp_megaflow_stats dp_megaflow_stats;
 	struct dp_nlsk_pids *pids = ovsl_dereference(dp->upcall_portids);
 	int err, pids_len;
+	u64 *hits;
 
 	ovs_header = genlmsg_put(skb, portid, seq, &dp_datapath_genl_family,
 				 flags, cmd);
@@ -1575,6 +1585,21 @@ static int ovs_dp_cmd_fill_info(struct datapath *dp, struct sk_buff *skb,
 			ovs_flow_tbl_masks_cache_size(&dp->table)))
 		goto nla_put_failure;
 
+	/* Best effort: the histogram is diagnostic only, so a failed
+	 * allocation drops the attribute rather than the whole dump.
+	 */
+	hits = kmalloc_array(OVS_DP_MASKS_HIT_MAX, sizeof(*hits), GFP_ATOMIC);
+	if (hits) {
+		int n_masks = ovs_flow_tbl_masks_usage(&dp->table, hits,
+						       OVS_DP_MASKS_HIT_MAX);
+
+		err = nla_put(skb, OVS_DP_ATTR_MASKS_HIT,
+			      n_masks * sizeof(*hits), hits);
+		kfree(hits);
+		if (err)
+			goto nla_put_failure;
+	}
+
 	if (dp->user_features & OVS_DP_F_DISPATCH_UPCALL_PER_CPU && pids) {
 		pids_len = min(pids->n_pids, nr_cpu_ids) * sizeof(u32);
 		if (nla_put(skb, OVS_DP_ATTR_PER_CPU_PIDS, pids_len, &pids->pids))
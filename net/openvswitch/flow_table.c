@@ -38,7 +38,7 @@
 #define MASK_ARRAY_SIZE_MIN	16
 #define REHASH_INTERVAL		(10 * 60 * HZ)
 
-#define MC_DEFAULT_HASH_ENTRIES	256
+#define MC_DEFAULT_HASH_ENTRIES	512
 #define MC_HASH_SHIFT		8
 #define MC_HASH_SEGS		((sizeof(uint32_t) * 8) / MC_HASH_SHIFT)
 
@@ -948,6 +948,47 @@ u32 ovs_flow_tbl_masks_cache_size(const struct flow_table *table)
 	return READ_ONCE(mc->cache_size);
 }
 
+/* Snapshot of the per-mask hit counters accumulated since the last
+ * rebalance, in current mask-array order.  As the rebalance sorts the
+ * array by hit count, entry 0 is the hottest mask.  Returns the number
+ * of entries filled in.
+ */
+int ovs_flow_tbl_masks_usage(const struct flow_table *table, u64 *usage,
+			     int size)
+{
+	struct mask_array *ma = rcu_dereference_ovsl(table->mask_array);
+	int i;
+
+	for (i = 0; i < ma->max && i < size; i++) {
+		struct sw_flow_mask *mask;
+		u64 counter = 0;
+		int cpu;
+
+		mask = rcu_dereference_ovsl(ma->masks[i]);
+		if (!mask)
+			break;
+
+		for_each_possible_cpu(cpu) {
+			struct mask_array_stats *stats;
+			unsigned int start;
+			u64 val;
+
+			stats = per_cpu_ptr(ma->masks_usage_stats, cpu);
+			do {
+				start = u64_stats_fetch_begin_irq(&stats->syncp);
+				val = stats->usage_cntrs[i];
+			} while (u64_stats_fetch_retry_irq(&stats->syncp,
+							   start));
+
+			counter += val;
+		}
+
+		usage[i] = counter - ma->masks_usage_zero_cntr[i];
+	}
+
+	return i;
+}
+
 static struct table_instance *table_instance_expand(struct table_instance *ti,
 						    bool ufid)
 {
@@ -539,6 +539,67 @@ static void unix_write_space(struct sock *sk)
 	rcu_read_unlock();
 }
 
+/* Lock-free sender-side fast queue for connected stream pairs.
+ *
+ * Stream data skbs that carry no file descriptors are pushed onto a
+ * per-socket MPSC stack with a single cmpxchg instead of bouncing the
+ * receiver's queue lock between sender and receiver, and the receiver
+ * splices them onto sk_receive_queue in batches. AF_UNIX never uses the
+ * socket backlog (there is no softirq delivery path), so its head
+ * pointer anchors the stack without growing struct unix_sock.
+ *
+ * Anything that looks at sk_receive_queue state must splice first while
+ * holding the queue lock; doing the xchg under that lock keeps batches
+ * from concurrent splicers in submission order. Skbs carrying SCM_RIGHTS
+ * never enter the stack so the garbage collector continues to see every
+ * in-flight fd on sk_receive_queue.
+ */
+#define unix_fastq_head(sk)	((sk)->sk_backlog.head)
+
+static void unix_fastq_add(struct sock *sk, struct sk_buff *skb)
+{
+	struct sk_buff *head;
+
+	do {
+		head = READ_ONCE(unix_fastq_head(sk));
+		skb->next = head;
+	} while (cmpxchg(&unix_fastq_head(sk), head, skb) != head);
+}
+
+static void __unix_fastq_splice(struct sock *sk)
+{
+	struct sk_buff *skb, *prev = NULL;
+
+	skb = xchg(&unix_fastq_head(sk), NULL);
+
+	/* The stack is LIFO, reverse it to restore submission order */
+	while (skb) {
+		struct sk_buff *next = skb->next;
+
+		skb->next = prev;
+		prev = skb;
+		skb = next;
+	}
+
+	while (prev) {
+		struct sk_buff *next = prev->next;
+
+		prev->next = NULL;
+		__skb_queue_tail(&sk->sk_receive_queue, prev);
+		prev = next;
+	}
+}
+
+static void unix_fastq_splice(struct sock *sk)
+{
+	if (!READ_ONCE(unix_fastq_head(sk)))
+		return;
+
+	spin_lock(&sk->sk_receive_queue.lock);
+	__unix_fastq_splice(sk);
+	spin_unlock(&sk->sk_receive_queue.lock);
+}
+
 /* When dgram socket disconnects (or changes its peer), we clear its receive
  * queue of packets arrived from previous peer. First, it allows to do
  * flow control based only on wmem_alloc; second, sk connected to peer
@@ -639,6 +700,7 @@ static void unix_release_sock(struct sock *sk, int embrion)
 
 	/* Try to flush out this socket. Throw out buffers at least */
 
+	unix_fastq_splice(sk);
 	while ((skb = skb_dequeue(&sk->sk_receive_queue)) != NULL) {
 		if (state == TCP_LISTEN)
 			unix_release_sock(skb->sk, 1);
@@ -2143,7 +2205,10 @@ static int queue_oob(struct socket *sock, struct msghdr *msg, struct sock *other
 	WRITE_ONCE(ousk->oob_skb, skb);
 
 	scm_stat_add(other, skb);
-	skb_queue_tail(&other->sk_receive_queue, skb);
+	spin_lock(&other->sk_receive_queue.lock);
+	__unix_fastq_splice(other);
+	__skb_queue_tail(&other->sk_receive_queue, skb);
+	spin_unlock(&other->sk_receive_queue.lock);
 	sk_send_sigurg(other);
 	unix_state_unlock(other);
 	other->sk_data_ready(other);
@@ -2159,6 +2224,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	struct sock *other = NULL;
 	int err, size;
 	struct sk_buff *skb;
+	struct ubuf_info *uarg = NULL;
 	int sent = 0;
 	struct scm_cookie scm;
 	bool fds_sent = false;
@@ -2169,6 +2235,20 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	if (err < 0)
 		return err;
 
+	/* MSG_ZEROCOPY was silently ignored here before, so applications
+	 * may pass it without reading the completion notifications it
+	 * queues to the error queue.  Like TCP, require the SO_ZEROCOPY
+	 * opt-in and fall back to copying otherwise.
+	 */
+	if ((msg->msg_flags & MSG_ZEROCOPY) && len &&
+	    sock_flag(sk, SOCK_ZEROCOPY)) {
+		uarg = msg_zerocopy_realloc(sk, len, NULL);
+		if (!uarg) {
+			err = -ENOBUFS;
+			goto out_err;
+		}
+	}
+
 	err = -EOPNOTSUPP;
 	if (msg->msg_flags & MSG_OOB) {
 #if IS_ENABLED(CONFIG_AF_UNIX_OOB)
@@ -2198,16 +2278,27 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		/* Keep two messages in the pipe so it schedules better */
 		size = min_t(int, size, (sk->sk_sndbuf >> 1) - 64);
 
-		/* allow fallback to order-0 allocations */
-		size = min_t(int, size, SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
+		if (uarg) {
+			/* Payload travels as frag references to the pinned
+			 * user pages, only scm/creds need head room.
+			 */
+			skb = sock_alloc_send_pskb(sk, 0, 0,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err, 0);
+		} else {
+			/* allow fallback to order-0 allocations */
+			size = min_t(int, size,
+				     SKB_MAX_HEAD(0) + UNIX_SKB_FRAGS_SZ);
 
-		data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
+			data_len = max_t(int, 0, size - SKB_MAX_HEAD(0));
 
-		data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
+			data_len = min_t(size_t, size, PAGE_ALIGN(data_len));
 
-		skb = sock_alloc_send_pskb(sk, size - data_len, data_len,
-					   msg->msg_flags & MSG_DONTWAIT, &err,
-					   get_order(UNIX_SKB_FRAGS_SZ));
+			skb = sock_alloc_send_pskb(sk, size - data_len, data_len,
+						   msg->msg_flags & MSG_DONTWAIT,
+						   &err,
+						   get_order(UNIX_SKB_FRAGS_SZ));
+		}
 		if (!skb)
 			goto out_err;
 
@@ -2219,13 +2310,35 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 		}
 		fds_sent = true;
 
-		skb_put(skb, size - data_len);
-		skb->data_len = data_len;
-		skb->len = size;
-		err = skb_copy_datagram_from_iter(skb, 0, &msg->msg_iter, size);
-		if (err) {
-			kfree_skb(skb);
-			goto out_err;
+		if (uarg) {
+			unsigned int truesize = skb->truesize;
+
+			err = skb_zerocopy_iter_stream(sk, skb, msg, size,
+						       uarg);
+			if (err < 0) {
+				kfree_skb(skb);
+				goto out_err;
+			}
+			size = err;
+			/* __zerocopy_sg_from_iter() charged the frag pages
+			 * to the stream wmem pool, but AF_UNIX accounts
+			 * sender memory through sk_wmem_alloc and releases
+			 * the whole truesize in sock_wfree(); move the
+			 * charge over so the destructor balances.
+			 */
+			truesize = skb->truesize - truesize;
+			refcount_add(truesize, &sk->sk_wmem_alloc);
+			sk_wmem_queued_add(sk, -truesize);
+		} else {
+			skb_put(skb, size - data_len);
+			skb->data_len = data_len;
+			skb->len = size;
+			err = skb_copy_datagram_from_iter(skb, 0,
+							  &msg->msg_iter, size);
+			if (err) {
+				kfree_skb(skb);
+				goto out_err;
+			}
 		}
 
 		unix_state_lock(other);
@@ -2236,7 +2349,14 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 
 		maybe_add_creds(skb, sock, other);
 		scm_stat_add(other, skb);
-		skb_queue_tail(&other->sk_receive_queue, skb);
+		if (!UNIXCB(skb).fp) {
+			unix_fastq_add(other, skb);
+		} else {
+			spin_lock(&other->sk_receive_queue.lock);
+			__unix_fastq_splice(other);
+			__skb_queue_tail(&other->sk_receive_queue, skb);
+			spin_unlock(&other->sk_receive_queue.lock);
+		}
 		unix_state_unlock(other);
 		other->sk_data_ready(other);
 		sent += size;
@@ -2251,6 +2371,7 @@ static int unix_stream_sendmsg(struct socket *sock, struct msghdr *msg,
 	}
 #endif
 
+	net_zcopy_put(uarg);
 	scm_destroy(&scm);
 
 	return sent;
@@ -2263,6 +2384,10 @@ pipe_err:
 		send_sig(SIGPIPE, current, 0);
 	err = -EPIPE;
 out_err:
+	if (sent)
+		net_zcopy_put(uarg);
+	else
+		net_zcopy_put_abort(uarg, true);
 	scm_destroy(&scm);
 	return sent ? : err;
 }
@@ -2327,6 +2452,7 @@ alloc_skb:
 	}
 
 	spin_lock(&other->sk_receive_queue.lock);
+	__unix_fastq_splice(other);
 	skb = skb_peek_tail(&other->sk_receive_queue);
 	if (tail && tail == skb) {
 		skb = newskb;
@@ -2550,6 +2676,7 @@ static int unix_read_skb(struct sock *sk, skb_read_actor_t recv_actor)
 	int err;
 
 	mutex_lock(&u->iolock);
+	unix_fastq_splice(sk);
 	skb = skb_recv_datagram(sk, MSG_DONTWAIT, &err);
 	mutex_unlock(&u->iolock);
 	if (!skb)
@@ -2577,6 +2704,7 @@ static long unix_stream_data_wait(struct sock *sk, long timeo,
 		tail = skb_peek_tail(&sk->sk_receive_queue);
 		if (tail != last ||
 		    (tail && tail->len != last_len) ||
+		    READ_ONCE(unix_fastq_head(sk)) ||
 		    sk->sk_err ||
 		    (sk->sk_shutdown & RCV_SHUTDOWN) ||
 		    signal_pending(current) ||
@@ -2748,6 +2876,7 @@ redo:
 			err = -ECONNRESET;
 			goto unlock;
 		}
+		unix_fastq_splice(sk);
 		last = skb = skb_peek(&sk->sk_receive_queue);
 		last_len = last ? last->len : 0;
 
@@ -2951,6 +3080,10 @@ static int unix_stream_recvmsg(struct socket *sock, struct msghdr *msg,
 	if (prot != &unix_stream_proto)
 		return prot->recvmsg(sk, msg, size, flags, NULL);
 #endif
+	/* MSG_ZEROCOPY completion notifications */
+	if (unlikely(flags & MSG_ERRQUEUE))
+		return sock_recv_errqueue(sock->sk, msg, size, SOL_SOCKET, 0);
+
 	return unix_stream_read_generic(&state, true);
 }
 
@@ -3043,6 +3176,7 @@ long unix_inq_len(struct sock *sk)
 		return -EINVAL;
 
 	spin_lock(&sk->sk_receive_queue.lock);
+	__unix_fastq_splice(sk);
 	if (sk->sk_type == SOCK_STREAM ||
 	    sk->sk_type == SOCK_SEQPACKET) {
 		skb_queue_walk(&sk->sk_receive_queue, skb)
@@ -3159,7 +3293,7 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 	shutdown = READ_ONCE(sk->sk_shutdown);
 
 	/* exceptional events? */
-	if (sk->sk_err)
+	if (sk->sk_err || !skb_queue_empty_lockless(&sk->sk_error_queue))
 		mask |= EPOLLERR;
 	if (shutdown == SHUTDOWN_MASK)
 		mask |= EPOLLHUP;
@@ -3167,7 +3301,8 @@ static __poll_t unix_poll(struct file *file, struct socket *sock, poll_table *wa
 		mask |= EPOLLRDHUP | EPOLLIN | EPOLLRDNORM;
 
 	/* readable? */
-	if (!skb_queue_empty_lockless(&sk->sk_receive_queue))
+	if (!skb_queue_empty_lockless(&sk->sk_receive_queue) ||
+	    READ_ONCE(unix_fastq_head(sk)))
 		mask |= EPOLLIN | EPOLLRDNORM;
 	if (sk_is_readable(sk))
 		mask |= EPOLLIN | EPOLLRDNORM;
@@ -53,6 +53,7 @@ struct virtio_vsock {
 	bool rx_run;
 	int rx_buf_nr;
 	int rx_buf_max_nr;
+	u32 rx_buf_size;
 
 	/* The following fields are protected by event_lock.
 	 * vqs[VSOCK_VQ_EVENT] must be accessed with event_lock held.
@@ -220,7 +221,8 @@ out_rcu:
 
 static void virtio_vsock_rx_fill(struct virtio_vsock *vsock)
 {
-	int total_len = VIRTIO_VSOCK_DEFAULT_RX_BUF_SIZE + VIRTIO_VSOCK_SKB_HEADROOM;
+	int total_len = vsock->rx_buf_size + VIRTIO_VSOCK_SKB_HEADROOM;
+	int max_buf_nr = VIRTIO_VSOCK_MAX_RX_BUF_BYTES / vsock->rx_buf_size;
 	struct scatterlist pkt, *p;
 	struct virtqueue *vq;
 	struct sk_buff *skb;
@@ -228,7 +230,7 @@ static void virtio_vsock_rx_fill(struct virtio_vsock *vsock)
 
 	vq = vsock->vqs[VSOCK_VQ_RX];
 
-	do {
+	while (vq->num_free && vsock->rx_buf_nr < max_buf_nr) {
 		skb = virtio_vsock_alloc_skb(total_len, GFP_KERNEL);
 		if (!skb)
 			break;
@@ -243,7 +245,7 @@ static void virtio_vsock_rx_fill(struct virtio_vsock *vsock)
 		}
 
 		vsock->rx_buf_nr++;
-	} while (vq->num_free);
+	}
 	if (vsock->rx_buf_nr > vsock->rx_buf_max_nr)
 		vsock->rx_buf_max_nr = vsock->rx_buf_nr;
 	virtqueue_kick(vq);
@@ -669,6 +671,15 @@ static int virtio_vsock_probe(struct virtio_device *vdev)
 	if (virtio_has_feature(vdev, VIRTIO_VSOCK_F_SEQPACKET))
 		vsock->seqpacket_allow = true;
 
+	/* With big packets the host fills however much of the posted
+	 * buffer fits, so large writes stop being chopped into
+	 * rx-buffer-sized packets.
+	 */
+	if (virtio_has_feature(vdev, VIRTIO_VSOCK_F_BIG_PACKETS))
+		vsock->rx_buf_size = VIRTIO_VSOCK_MAX_PKT_BUF_SIZE;
+	else
+		vsock->rx_buf_size = VIRTIO_VSOCK_DEFAULT_RX_BUF_SIZE;
+
 	vdev->priv = vsock;
 
 	ret = virtio_vsock_vqs_init(vsock);
@@ -763,7 +774,8 @@ static struct virtio_device_id id_table[] = {
 };
 
 static unsigned int features[] = {
-	VIRTIO_VSOCK_F_SEQPACKET
+	VIRTIO_VSOCK_F_SEQPACKET,
+	VIRTIO_VSOCK_F_BIG_PACKETS
 };
 
 static struct virtio_driver virtio_vsock_driver = {
@@ -30,7 +30,7 @@
 #include "xdp_umem.h"
 #include "xsk.h"
 
-#define TX_BATCH_SIZE 32
+#define TX_BATCH_SIZE 64
 
 static DEFINE_PER_CPU(struct list_head, xskmap_flush_list);
 
@@ -519,6 +519,7 @@ static int __xsk_generic_xmit(struct sock *sk)
 	struct xdp_desc desc;
 	struct sk_buff *skb;
 	unsigned long flags;
+	u32 reserved = 0;
 	int err = 0;
 
 	mutex_lock(&xs->mutex);
@@ -535,49 +536,49 @@ static int __xsk_generic_xmit(struct sock *sk)
 	while (xskq_cons_peek_desc(xs->tx, &desc, xs->pool)) {
 		if (max_batch-- == 0) {
 			err = -EAGAIN;
-			goto out;
+			goto out_cancel;
 		}
 
 		/* This is the backpressure mechanism for the Tx path.
 		 * Reserve space in the completion queue and only proceed
 		 * if there is space in it. This avoids having to implement
-		 * any buffering in the Tx path.
+		 * any buffering in the Tx path. Slots are reserved for a
+		 * whole burst at once so cq_lock does not bounce against
+		 * the driver's completion path on every descriptor.
 		 */
-		spin_lock_irqsave(&xs->pool->cq_lock, flags);
-		if (xskq_prod_reserve(xs->pool->cq)) {
+		if (!reserved) {
+			spin_lock_irqsave(&xs->pool->cq_lock, flags);
+			reserved = xskq_prod_reserve_n(xs->pool->cq,
+						       max_batch + 1);
 			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			goto out;
+			if (!reserved)
+				goto out;
 		}
-		spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
 
 		skb = xsk_build_skb(xs, &desc);
 		if (IS_ERR(skb)) {
 			err = PTR_ERR(skb);
-			spin_lock_irqsave(&xs->pool->cq_lock, flags);
-			xskq_prod_cancel(xs->pool->cq);
-			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
-			goto out;
+			goto out_cancel;
 		}
 
 		err = __dev_direct_xmit(skb, xs->queue_id);
 		if  (err == NETDEV_TX_BUSY) {
 			/* Tell user-space to retry the send */
 			skb->destructor = sock_wfree;
-			spin_lock_irqsave(&xs->pool->cq_lock, flags);
-			xskq_prod_cancel(xs->pool->cq);
-			spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
 			/* Free skb without triggering the perf drop trace */
 			consume_skb(skb);
 			err = -EAGAIN;
-			goto out;
+			goto out_cancel;
 		}
 
+		/* The skb's destructor submits the completion entry */
+		reserved--;
 		xskq_cons_release(xs->tx);
 		/* Ignore NET_XMIT_CN as packet might have been sent */
 		if (err == NET_XMIT_DROP) {
 			/* SKB completed but not sent */
 			err = -EBUSY;
-			goto out;
+			goto out_cancel;
 		}
 
 		sent_frame = true;
@@ -585,6 +586,12 @@ static int __xsk_generic_xmit(struct sock *sk)
 
 	xs->tx->queue_empty_descs++;
 
+out_cancel:
+	if (reserved) {
+		spin_lock_irqsave(&xs->pool->cq_lock, flags);
+		xskq_prod_cancel_n(xs->pool->cq, reserved);
+		spin_unlock_irqrestore(&xs->pool->cq_lock, flags);
+	}
 out:
 	if (sent_frame)
 		if (xsk_tx_writeable(xs))
@@ -727,11 +734,17 @@ static __poll_t xsk_poll(struct file *file, struct socket *sock,
 	pool = xs->pool;
 
 	if (pool->cached_need_wakeup) {
-		if (xs->zc)
-			xsk_wakeup(xs, pool->cached_need_wakeup);
-		else if (xs->tx)
+		if (xs->zc) {
+			/* A preferred-busy-poll socket drives the NAPI
+			 * context from poll() itself, sparing it the irq
+			 * jitter of a driver kick.
+			 */
+			if (!xsk_no_wakeup(sk))
+				xsk_wakeup(xs, pool->cached_need_wakeup);
+		} else if (xs->tx) {
 			/* Poll needs to drive Tx also in copy mode */
 			xsk_generic_xmit(sk);
+		}
 	}
 
 	if (xs->rx && !xskq_prod_is_empty(xs->rx))
@@ -36,6 +36,7 @@
 	rcu_dereference_protected((table), lockdep_is_held(&(net)->xfrm.xfrm_state_lock))
 
 static void xfrm_state_gc_task(struct work_struct *work);
+static void xfrm_state_cache_revoke(struct xfrm_state *x);
 
 /* Each xfrm_state may be linked to two tables:
 
@@ -697,6 +698,7 @@ int __xfrm_state_delete(struct xfrm_state *x)
 		if (x->encap_sk)
 			sock_put(rcu_dereference_raw(x->encap_sk));
 
+		xfrm_state_cache_revoke(x);
 		xfrm_dev_state_delete(x);
 
 		/* All xfrm_state objects are created by xfrm_state_alloc.
@@ -1067,6 +1069,135 @@ static void xfrm_state_look_at(struct xfrm_policy *pol, struct xfrm_state *x,
 	}
 }
 
+/* Per-CPU cache of the SA last resolved for output on this CPU.
+ *
+ * Each slot owns one reference on the cached state.  Only the owning
+ * CPU fills or consults its slot, with BH disabled; the pointer itself
+ * is claimed with xchg() so that __xfrm_state_delete() can revoke the
+ * entry from any CPU without a lock.  A hit is revalidated against the
+ * full template/selector/security match, and against the genid
+ * snapshot taken at fill time, so a rekeyed SA (which bumps the old
+ * state's genid) stops being served from the cache immediately.
+ */
+struct xfrm_state_pcpu_cache {
+	struct xfrm_state *x;
+	u32 genid;
+};
+
+static DEFINE_PER_CPU(struct xfrm_state_pcpu_cache, xfrm_state_pcpu_cache);
+
+static bool xfrm_state_cached_match(struct xfrm_state *x, struct net *net,
+				    const xfrm_address_t *daddr,
+				    const xfrm_address_t *saddr,
+				    const struct flowi *fl,
+				    struct xfrm_tmpl *tmpl,
+				    struct xfrm_policy *pol,
+				    unsigned short family,
+				    unsigned short encap_family,
+				    u32 mark, u32 if_id)
+{
+	if (!net_eq(xs_net(x), net) ||
+	    x->props.family != encap_family ||
+	    x->props.reqid != tmpl->reqid ||
+	    (mark & x->mark.m) != x->mark.v ||
+	    x->if_id != if_id ||
+	    (x->props.flags & XFRM_STATE_WILDRECV) ||
+	    !xfrm_state_addr_check(x, daddr, saddr, encap_family) ||
+	    tmpl->mode != x->props.mode ||
+	    tmpl->id.proto != x->id.proto ||
+	    (tmpl->id.spi && tmpl->id.spi != x->id.spi))
+		return false;
+
+	if (x->km.state != XFRM_STATE_VALID)
+		return false;
+
+	if (x->sel.family &&
+	    (x->sel.family != family ||
+	     !xfrm_selector_match(&x->sel, fl, family)))
+		return false;
+
+	return security_xfrm_state_pol_flow_match(x, pol,
+						  &fl->u.__fl_common);
+}
+
+static struct xfrm_state *
+xfrm_state_cache_get(struct net *net, const xfrm_address_t *daddr,
+		     const xfrm_address_t *saddr, const struct flowi *fl,
+		     struct xfrm_tmpl *tmpl, struct xfrm_policy *pol,
+		     unsigned short family, unsigned short encap_family,
+		     u32 mark, u32 if_id)
+{
+	struct xfrm_state_pcpu_cache *cache;
+	struct xfrm_state *x, *old;
+
+	local_bh_disable();
+	cache = this_cpu_ptr(&xfrm_state_pcpu_cache);
+	x = xchg(&cache->x, NULL);
+	if (!x) {
+		local_bh_enable();
+		return NULL;
+	}
+
+	if (x->genid == cache->genid &&
+	    xfrm_state_cached_match(x, net, daddr, saddr, fl, tmpl, pol,
+				    family, encap_family, mark, if_id)) {
+		xfrm_state_hold(x);
+		old = xchg(&cache->x, x);
+		local_bh_enable();
+		if (old)
+			xfrm_state_put(old);
+		return x;
+	}
+
+	local_bh_enable();
+	xfrm_state_put(x);
+	return NULL;
+}
+
+static void xfrm_state_cache_fill(struct xfrm_state *x)
+{
+	struct xfrm_state_pcpu_cache *cache;
+	struct xfrm_state *old;
+
+	if (x->km.state != XFRM_STATE_VALID)
+		return;
+
+	xfrm_state_hold(x);
+	local_bh_disable();
+	cache = this_cpu_ptr(&xfrm_state_pcpu_cache);
+	cache->genid = x->genid;
+	old = xchg(&cache->x, x);
+	local_bh_enable();
+	if (old)
+		xfrm_state_put(old);
+}
+
+static void xfrm_state_cache_revoke(struct xfrm_state *x)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu) {
+		struct xfrm_state_pcpu_cache *cache =
+			per_cpu_ptr(&xfrm_state_pcpu_cache, cpu);
+		struct xfrm_state *old;
+
+		if (READ_ONCE(cache->x) != x)
+			continue;
+
+		old = xchg(&cache->x, NULL);
+		if (!old)
+			continue;
+		if (old == x) {
+			xfrm_state_put(old);
+		} else {
+			/* Lost a race with a refill; put it back. */
+			old = xchg(&cache->x, old);
+			if (old)
+				xfrm_state_put(old);
+		}
+	}
+}
+
 struct xfrm_state *
 xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 		const struct flowi *fl, struct xfrm_tmpl *tmpl,
@@ -1087,6 +1218,13 @@ xfrm_state_find(const xfrm_address_t *daddr, const xfrm_address_t *saddr,
 
 	to_put = NULL;
 
+	x = xfrm_state_cache_get(net, daddr, saddr, fl, tmpl, pol, family,
+				 encap_family, mark, if_id);
+	if (x) {
+		*err = 0;
+		return x;
+	}
+
 	sequence = read_seqcount_begin(&net->xfrm.xfrm_state_hash_generation);
 
 	rcu_read_lock();
@@ -1212,6 +1350,9 @@ out:
 		}
 	}
 
+	if (x)
+		xfrm_state_cache_fill(x);
+
 	return x;
 }
 
@@ -64,6 +64,32 @@ asm (
 
 #endif /* CONFIG_S390 */
 
+#ifdef CONFIG_RISCV
+
+#include <asm/asm.h>
+
+asm (
+"	.pushsection	.text, \"ax\", @progbits\n"
+"	.type		my_tramp, @function\n"
+"	.globl		my_tramp\n"
+"   my_tramp:\n"
+"	addi	sp,sp,-4*"SZREG"\n"
+"	"REG_S"	a0,0*"SZREG"(sp)\n"
+"	"REG_S"	t0,1*"SZREG"(sp)\n"
+"	"REG_S"	ra,2*"SZREG"(sp)\n"
+"	mv	a0,t0\n"
+"	call	my_direct_func\n"
+"	"REG_L"	a0,0*"SZREG"(sp)\n"
+"	"REG_L"	t0,1*"SZREG"(sp)\n"
+"	"REG_L"	ra,2*"SZREG"(sp)\n"
+"	addi	sp,sp,4*"SZREG"\n"
+"	jr	t0\n"
+"	.size		my_tramp, .-my_tramp\n"
+"	.popsection\n"
+);
+
+#endif /* CONFIG_RISCV */
+
 static struct ftrace_ops direct;
 
 static int __init ftrace_direct_multi_init(void)
@@ -61,6 +61,31 @@ asm (
 
 #endif /* CONFIG_S390 */
 
+#ifdef CONFIG_RISCV
+
+#include <asm/asm.h>
+
+asm (
+"	.pushsection	.text, \"ax\", @progbits\n"
+"	.type		my_tramp, @function\n"
+"	.globl		my_tramp\n"
+"   my_tramp:\n"
+"	addi	sp,sp,-4*"SZREG"\n"
+"	"REG_S"	a0,0*"SZREG"(sp)\n"
+"	"REG_S"	t0,1*"SZREG"(sp)\n"
+"	"REG_S"	ra,2*"SZREG"(sp)\n"
+"	call	my_direct_func\n"
+"	"REG_L"	a0,0*"SZREG"(sp)\n"
+"	"REG_L"	t0,1*"SZREG"(sp)\n"
+"	"REG_L"	ra,2*"SZREG"(sp)\n"
+"	addi	sp,sp,4*"SZREG"\n"
+"	jr	t0\n"
+"	.size		my_tramp, .-my_tramp\n"
+"	.popsection\n"
+);
+
+#endif /* CONFIG_RISCV */
+
 static int __init ftrace_direct_init(void)
 {
 	return register_ftrace_direct((unsigned long)wake_up_process,
@@ -19,6 +19,7 @@
 #include <linux/init.h>
 #include <linux/skbuff.h>
 #include <linux/percpu.h>
+#include <linux/jhash.h>
 #include <linux/list.h>
 #include <net/sock.h>
 #include <linux/un.h>
@@ -126,7 +127,7 @@ static struct kmem_cache *avc_xperms_cachep __ro_after_init;
 
 static inline int avc_hash(u32 ssid, u32 tsid, u16 tclass)
 {
-	return (ssid ^ (tsid<<2) ^ (tclass<<4)) & (AVC_CACHE_SLOTS - 1);
+	return jhash_3words(ssid, tsid, tclass, 0) & (AVC_CACHE_SLOTS - 1);
 }
 
 /**
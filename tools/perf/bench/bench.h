@@ -39,6 +39,11 @@ int bench_inject_build_id(int argc, const char **argv);
 int bench_evlist_open_close(int argc, const char **argv);
 int bench_breakpoint_thread(int argc, const char **argv);
 int bench_breakpoint_enable(int argc, const char **argv);
+/* riscv platform costs */
+int bench_riscv_shootdown(int argc, const char **argv);
+int bench_riscv_ipi(int argc, const char **argv);
+int bench_riscv_uaccess(int argc, const char **argv);
+int bench_riscv_misaligned(int argc, const char **argv);
 
 #define BENCH_FORMAT_DEFAULT_STR	"default"
 #define BENCH_FORMAT_DEFAULT		0
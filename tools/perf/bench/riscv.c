@@ -0,0 +1,481 @@
+// SPDX-License-Identifier: GPL-2.0
+/*
+ * riscv.c
+ *
+ * Benchmarks for the platform costs that dominate riscv kernels:
+ * remote sfence.vma shootdown latency against the number of harts
+ * running the mm, IPI round trips (driven through expedited
+ * membarrier), uaccess copy bandwidth and the hardware misaligned
+ * access penalty.  The numbers depend as much on the SBI firmware as
+ * on the kernel, which is exactly why they are worth tracking across
+ * updates.
+ */
+#include "../perf.h"
+#include "../util/util.h"
+#include <subcmd/parse-options.h>
+#include "../builtin.h"
+#include "bench.h"
+
+#include <err.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifndef __NR_membarrier
+#define __NR_membarrier 283
+#endif
+#ifndef MEMBARRIER_CMD_PRIVATE_EXPEDITED
+#define MEMBARRIER_CMD_PRIVATE_EXPEDITED		(1 << 3)
+#endif
+#ifndef MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED
+#define MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED	(1 << 4)
+#endif
+
+static unsigned int loops = 10000;
+static unsigned int nthreads;
+
+static const struct option shootdown_options[] = {
+	OPT_UINTEGER('l', "loops",   &loops,    "Number of operations per hart count"),
+	OPT_UINTEGER('t', "threads", &nthreads, "Maximum number of busy harts (default: all other online harts)"),
+	OPT_END()
+};
+
+static const char * const bench_riscv_shootdown_usage[] = {
+	"perf bench riscv shootdown <options>",
+	NULL
+};
+
+static const char * const bench_riscv_ipi_usage[] = {
+	"perf bench riscv ipi <options>",
+	NULL
+};
+
+/*
+ * Busy workers.  Each worker pins itself to a CPU and spins in user
+ * mode on a private cacheline, which keeps the benchmark mm active on
+ * that hart so that remote fences and expedited membarrier IPIs must
+ * reach it.
+ */
+struct riscv_worker {
+	pthread_t	thread;
+	int		cpu;
+	/* Padded so that neighbouring workers don't share a cacheline */
+	unsigned long	spins;
+	unsigned long	pad[6];
+};
+
+static volatile int workers_stop;
+
+static void *riscv_worker_fn(void *arg)
+{
+	struct riscv_worker *w = arg;
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(w->cpu, &cpuset);
+	if (pthread_setaffinity_np(pthread_self(), sizeof(cpuset), &cpuset))
+		err(EXIT_FAILURE, "pthread_setaffinity_np");
+
+	while (!workers_stop)
+		w->spins++;
+
+	return NULL;
+}
+
+static int riscv_online_cpus(int **cpus)
+{
+	cpu_set_t cpuset;
+	int i, n = 0;
+
+	CPU_ZERO(&cpuset);
+	if (sched_getaffinity(0, sizeof(cpuset), &cpuset))
+		err(EXIT_FAILURE, "sched_getaffinity");
+
+	*cpus = calloc(CPU_SETSIZE, sizeof(int));
+	if (!*cpus)
+		err(EXIT_FAILURE, "calloc");
+
+	for (i = 0; i < CPU_SETSIZE; i++)
+		if (CPU_ISSET(i, &cpuset))
+			(*cpus)[n++] = i;
+
+	return n;
+}
+
+static struct riscv_worker *riscv_start_workers(const int *cpus, int nr)
+{
+	struct riscv_worker *workers;
+	int i;
+
+	workers = calloc(nr, sizeof(*workers));
+	if (!workers)
+		err(EXIT_FAILURE, "calloc");
+
+	workers_stop = 0;
+	for (i = 0; i < nr; i++) {
+		workers[i].cpu = cpus[i];
+		if (pthread_create(&workers[i].thread, NULL, riscv_worker_fn,
+				   &workers[i]))
+			err(EXIT_FAILURE, "pthread_create");
+	}
+
+	/* Give every worker time to land on its hart */
+	usleep(10000);
+
+	return workers;
+}
+
+static void riscv_stop_workers(struct riscv_worker *workers, int nr)
+{
+	int i;
+
+	workers_stop = 1;
+	for (i = 0; i < nr; i++)
+		pthread_join(workers[i].thread, NULL);
+	free(workers);
+}
+
+static void riscv_pin_self(int cpu)
+{
+	cpu_set_t cpuset;
+
+	CPU_ZERO(&cpuset);
+	CPU_SET(cpu, &cpuset);
+	if (sched_setaffinity(0, sizeof(cpuset), &cpuset))
+		err(EXIT_FAILURE, "sched_setaffinity");
+}
+
+static double riscv_timed_usecs(struct timeval *start, struct timeval *stop)
+{
+	struct timeval diff;
+
+	timersub(stop, start, &diff);
+	return (double)diff.tv_sec * 1000000.0 + (double)diff.tv_usec;
+}
+
+/* Hart counts worth reporting: 0, powers of two, and the maximum */
+static int riscv_next_step(int cur, int max)
+{
+	if (cur >= max)
+		return max + 1;
+	if (cur == 0)
+		return 1;
+	if (cur * 2 > max)
+		return max;
+	return cur * 2;
+}
+
+static double bench_one_shootdown(void *page, unsigned int n)
+{
+	struct timeval start, stop;
+	unsigned int i;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < n; i++) {
+		if (mprotect(page, getpagesize(), PROT_NONE))
+			err(EXIT_FAILURE, "mprotect");
+		if (mprotect(page, getpagesize(), PROT_READ | PROT_WRITE))
+			err(EXIT_FAILURE, "mprotect");
+		/* Repopulate the TLB entry the flush just killed */
+		*(volatile char *)page = 0;
+	}
+	gettimeofday(&stop, NULL);
+
+	/* Two mprotect() calls, i.e. two remote fences, per loop */
+	return riscv_timed_usecs(&start, &stop) / (double)(2 * n);
+}
+
+/*
+ * Remote TLB shootdown latency.  mprotect() on a mapped page forces a
+ * flush_tlb_range(), which the kernel broadcasts with sfence.vma (via
+ * the SBI remote fence or, with Svinval-style IPIs, a fence IPI) to
+ * every hart the mm is active on.  The busy workers scale that set.
+ */
+int bench_riscv_shootdown(int argc, const char **argv)
+{
+	struct riscv_worker *workers;
+	int *cpus, ncpus, t;
+	void *page;
+
+	argc = parse_options(argc, argv, shootdown_options,
+			     bench_riscv_shootdown_usage, 0);
+
+	ncpus = riscv_online_cpus(&cpus);
+	if (!nthreads || nthreads > (unsigned int)(ncpus - 1))
+		nthreads = ncpus - 1;
+
+	/* The measuring thread keeps the first CPU for itself */
+	riscv_pin_self(cpus[0]);
+
+	page = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (page == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	*(volatile char *)page = 0;
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# Remote TLB shootdown latency, %u flushes per hart count\n\n",
+		       2 * loops);
+
+	for (t = 0; t <= (int)nthreads; t = riscv_next_step(t, nthreads)) {
+		double usecs;
+
+		workers = riscv_start_workers(cpus + 1, t);
+		usecs = bench_one_shootdown(page, loops);
+		riscv_stop_workers(workers, t);
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %4d busy hart%s: %10.3f usecs/flush\n",
+			       t, t == 1 ? " " : "s", usecs);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%d %.3f\n", t, usecs);
+			break;
+		default:
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+		}
+	}
+
+	munmap(page, getpagesize());
+	free(cpus);
+	return 0;
+}
+
+/*
+ * IPI round trip.  An expedited private membarrier IPIs every hart
+ * that is running a thread of this process and does not return before
+ * all of them have entered the kernel and replied, so each call is a
+ * full broadcast round trip through the IPI path.
+ */
+int bench_riscv_ipi(int argc, const char **argv)
+{
+	struct riscv_worker *workers;
+	int *cpus, ncpus, t;
+
+	argc = parse_options(argc, argv, shootdown_options,
+			     bench_riscv_ipi_usage, 0);
+
+	if (syscall(__NR_membarrier,
+		    MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0)) {
+		fprintf(stderr, "membarrier(REGISTER_PRIVATE_EXPEDITED) not supported\n");
+		return -1;
+	}
+
+	ncpus = riscv_online_cpus(&cpus);
+	if (!nthreads || nthreads > (unsigned int)(ncpus - 1))
+		nthreads = ncpus - 1;
+
+	riscv_pin_self(cpus[0]);
+
+	if (bench_format == BENCH_FORMAT_DEFAULT)
+		printf("# IPI round trip via expedited membarrier, %u rounds per hart count\n\n",
+		       loops);
+
+	for (t = 0; t <= (int)nthreads; t = riscv_next_step(t, nthreads)) {
+		struct timeval start, stop;
+		unsigned int i;
+		double usecs;
+
+		workers = riscv_start_workers(cpus + 1, t);
+
+		gettimeofday(&start, NULL);
+		for (i = 0; i < loops; i++)
+			if (syscall(__NR_membarrier,
+				    MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0))
+				err(EXIT_FAILURE, "membarrier");
+		gettimeofday(&stop, NULL);
+
+		riscv_stop_workers(workers, t);
+
+		usecs = riscv_timed_usecs(&start, &stop) / (double)loops;
+
+		switch (bench_format) {
+		case BENCH_FORMAT_DEFAULT:
+			printf(" %4d busy hart%s: %10.3f usecs/round\n",
+			       t, t == 1 ? " " : "s", usecs);
+			break;
+		case BENCH_FORMAT_SIMPLE:
+			printf("%d %.3f\n", t, usecs);
+			break;
+		default:
+			fprintf(stderr, "Unknown format:%d\n", bench_format);
+			exit(1);
+		}
+	}
+
+	free(cpus);
+	return 0;
+}
+
+static unsigned int uaccess_size = 256 * 1024 * 1024;
+static unsigned int uaccess_block = 65536;
+
+static const struct option uaccess_options[] = {
+	OPT_UINTEGER('s', "size",  &uaccess_size,  "Total number of bytes to copy"),
+	OPT_UINTEGER('b', "block", &uaccess_block, "Block size per read()/write() call"),
+	OPT_END()
+};
+
+static const char * const bench_riscv_uaccess_usage[] = {
+	"perf bench riscv uaccess <options>",
+	NULL
+};
+
+static double bench_one_uaccess(int fd, void *buf, int dir_read)
+{
+	struct timeval start, stop;
+	size_t done = 0;
+	ssize_t ret;
+
+	gettimeofday(&start, NULL);
+	while (done < uaccess_size) {
+		if (dir_read)
+			ret = read(fd, buf, uaccess_block);
+		else
+			ret = write(fd, buf, uaccess_block);
+		if (ret < 0)
+			err(EXIT_FAILURE, dir_read ? "read" : "write");
+		done += ret;
+	}
+	gettimeofday(&stop, NULL);
+
+	return (double)done / riscv_timed_usecs(&start, &stop) * 1000000.0 /
+	       (1024.0 * 1024.0 * 1024.0);
+}
+
+/*
+ * uaccess copy bandwidth.  Reading /dev/zero is dominated by
+ * clear_user()/copy_to_user() and writing /dev/null-backed pages by
+ * copy_from_user(), so this tracks the kernel's uaccess routines
+ * (including the vector-accelerated ones) rather than libc memcpy.
+ */
+int bench_riscv_uaccess(int argc, const char **argv)
+{
+	double to_user, from_user;
+	int zfd, nfd;
+	void *buf;
+
+	argc = parse_options(argc, argv, uaccess_options,
+			     bench_riscv_uaccess_usage, 0);
+
+	buf = mmap(NULL, uaccess_block, PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	memset(buf, 0, uaccess_block);
+
+	zfd = open("/dev/zero", O_RDONLY);
+	if (zfd < 0)
+		err(EXIT_FAILURE, "open /dev/zero");
+	nfd = open("/dev/null", O_WRONLY);
+	if (nfd < 0)
+		err(EXIT_FAILURE, "open /dev/null");
+
+	to_user = bench_one_uaccess(zfd, buf, 1);
+	from_user = bench_one_uaccess(nfd, buf, 0);
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# Copied %u bytes in %u byte blocks\n\n",
+		       uaccess_size, uaccess_block);
+		printf(" %14s: %10.3f GB/sec\n", "copy_to_user", to_user);
+		printf(" %14s: %10.3f GB/sec\n", "copy_from_user", from_user);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3f %.3f\n", to_user, from_user);
+		break;
+	default:
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+
+	close(nfd);
+	close(zfd);
+	munmap(buf, uaccess_block);
+	return 0;
+}
+
+static unsigned int misaligned_loops = 10000000;
+
+static const struct option misaligned_options[] = {
+	OPT_UINTEGER('l', "loops", &misaligned_loops, "Number of accesses per alignment"),
+	OPT_END()
+};
+
+static const char * const bench_riscv_misaligned_usage[] = {
+	"perf bench riscv misaligned <options>",
+	NULL
+};
+
+static double bench_one_misaligned(unsigned char *buf, size_t offset,
+				   unsigned int n)
+{
+	volatile unsigned long long *p =
+		(volatile unsigned long long *)(buf + offset);
+	struct timeval start, stop;
+	unsigned long long sum = 0;
+	unsigned int i;
+
+	gettimeofday(&start, NULL);
+	for (i = 0; i < n; i++)
+		sum += *p;
+	gettimeofday(&stop, NULL);
+
+	/* Keep the loads alive */
+	*(volatile unsigned long long *)buf = sum;
+
+	return riscv_timed_usecs(&start, &stop) * 1000.0 / (double)n;
+}
+
+/*
+ * Misaligned access penalty.  A hart either resolves misaligned loads
+ * in hardware (fast or slow) or traps into firmware or the kernel,
+ * which emulates them roughly three orders of magnitude slower; the
+ * ratio printed here tells which of those a hart is, the same
+ * distinction the kernel's boot-time probe latches.
+ */
+int bench_riscv_misaligned(int argc, const char **argv)
+{
+	double aligned, misaligned;
+	unsigned char *buf;
+
+	argc = parse_options(argc, argv, misaligned_options,
+			     bench_riscv_misaligned_usage, 0);
+
+	buf = mmap(NULL, getpagesize(), PROT_READ | PROT_WRITE,
+		   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (buf == MAP_FAILED)
+		err(EXIT_FAILURE, "mmap");
+	memset(buf, 0, getpagesize());
+
+	aligned = bench_one_misaligned(buf, 0, misaligned_loops);
+	misaligned = bench_one_misaligned(buf, 1, misaligned_loops);
+
+	switch (bench_format) {
+	case BENCH_FORMAT_DEFAULT:
+		printf("# %u 8-byte loads per alignment\n\n", misaligned_loops);
+		printf(" %14s: %10.3f nsecs/load\n", "aligned", aligned);
+		printf(" %14s: %10.3f nsecs/load\n", "misaligned", misaligned);
+		printf(" %14s: %10.2fx\n", "penalty", misaligned / aligned);
+		break;
+	case BENCH_FORMAT_SIMPLE:
+		printf("%.3f %.3f\n", aligned, misaligned);
+		break;
+	default:
+		fprintf(stderr, "Unknown format:%d\n", bench_format);
+		exit(1);
+	}
+
+	munmap(buf, getpagesize());
+	return 0;
+}
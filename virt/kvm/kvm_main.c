@@ -3474,6 +3474,17 @@ bool kvm_vcpu_block(struct kvm_vcpu *vcpu)
 	return waited;
 }
 
+/*
+ * Window of recent per-vCPU halt-poll outcomes used to adapt the poll time.
+ * A vCPU whose polls almost never catch the wake event (a batch worker)
+ * shrinks its window even when individual halts look short, while a vCPU
+ * whose polls usually succeed (a latency-critical thread) grows towards
+ * the cap without waiting for the generic single-sample heuristics.
+ */
+#define KVM_HALT_POLL_HIST_BITS		16
+#define KVM_HALT_POLL_HIT_LOW		4	/* <= 25%: polling is wasted */
+#define KVM_HALT_POLL_HIT_HIGH		12	/* >= 75%: polling pays off */
+
 static inline void update_halt_poll_stats(struct kvm_vcpu *vcpu, ktime_t start,
 					  ktime_t end, bool success)
 {
@@ -3482,6 +3493,11 @@ static inline void update_halt_poll_stats(struct kvm_vcpu *vcpu, ktime_t start,
 
 	++vcpu->stat.generic.halt_attempted_poll;
 
+	vcpu->halt_poll_history = (vcpu->halt_poll_history << 1) | success;
+	if (vcpu->halt_poll_hist_len < KVM_HALT_POLL_HIST_BITS)
+		vcpu->halt_poll_hist_len++;
+	stats->halt_poll_window_hits = hweight16(vcpu->halt_poll_history);
+
 	if (success) {
 		++vcpu->stat.generic.halt_successful_poll;
 
@@ -3578,7 +3594,18 @@ out:
 		if (!vcpu_valid_wakeup(vcpu)) {
 			shrink_halt_poll_ns(vcpu);
 		} else if (max_halt_poll_ns) {
-			if (halt_ns <= vcpu->halt_poll_ns)
+			bool hist_full = do_halt_poll &&
+				vcpu->halt_poll_hist_len == KVM_HALT_POLL_HIST_BITS;
+			unsigned int hits = hweight16(vcpu->halt_poll_history);
+
+			/* this vCPU's polls are almost never useful */
+			if (hist_full && hits <= KVM_HALT_POLL_HIT_LOW)
+				shrink_halt_poll_ns(vcpu);
+			/* this vCPU's polls almost always pay off */
+			else if (hist_full && hits >= KVM_HALT_POLL_HIT_HIGH &&
+				 vcpu->halt_poll_ns < max_halt_poll_ns)
+				grow_halt_poll_ns(vcpu);
+			else if (halt_ns <= vcpu->halt_poll_ns)
 				;
 			/* we had a long block, shrink polling */
 			else if (vcpu->halt_poll_ns &&
@@ -3591,6 +3618,12 @@ out:
 		} else {
 			vcpu->halt_poll_ns = 0;
 		}
+
+		/* Let a quiesced vCPU re-learn once polling restarts. */
+		if (!vcpu->halt_poll_ns)
+			vcpu->halt_poll_hist_len = 0;
+
+		vcpu->stat.generic.halt_poll_cur_ns = vcpu->halt_poll_ns;
 	}
 
 	trace_kvm_vcpu_wakeup(halt_ns, waited, vcpu_valid_wakeup(vcpu));